@@ -0,0 +1,21 @@
+#!/bin/bash
+
+# ------------------------------------------------------------------------------------------------ #
+#                                This file is part of CosmoScout VR                                #
+# ------------------------------------------------------------------------------------------------ #
+
+# SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+# SPDX-License-Identifier: CC0-1.0
+
+# Change working directory to the location of this script.
+SCRIPT_DIR="$( cd "$( dirname "$0" )" && pwd )"
+cd "$SCRIPT_DIR"
+
+# Set paths so that all libraries are found.
+export LD_LIBRARY_PATH=../lib:../lib/DriverPlugins:$LD_LIBRARY_PATH
+
+# Run all test cases which are marked as benchmarks. They require neither a GPU nor a screen but
+# take considerably longer than the regular tests. The measured numbers are printed as messages, so
+# we report successful test cases as well. Any additional arguments are passed on to doctest, so you
+# can for example use --test-case="*ThreadPool*" to run a single benchmark.
+./cosmoscout --run-tests --test-case="*[benchmark]*" --success "$@"
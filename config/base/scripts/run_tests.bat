@@ -15,7 +15,7 @@ cd "%SCRIPT_DIR%"
 rem Set paths so that all libraries are found.
 set PATH=%SCRIPT_DIR%\..\lib;%PATH%
 
-cosmoscout.exe --run-tests --test-case-exclude="*[graphical]*"
+cosmoscout.exe --run-tests --test-case-exclude="*[graphical]*,*[benchmark]*"
 set RESULT=%ERRORLEVEL%
 
 rem Go back to where we came from
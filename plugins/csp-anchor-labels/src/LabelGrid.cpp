@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "LabelGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace csp::anchorlabels {
+
+namespace {
+
+// Cell coordinates are clamped to this range. Labels close to the observer's image plane may have
+// huge screen-space coordinates; they all end up in the outermost cells.
+const double MAX_CELL_COORDINATE = 1 << 30;
+
+// Large primes used to hash the cell coordinates.
+const uint32_t HASH_PRIME_X = 73856093U;
+const uint32_t HASH_PRIME_Y = 19349663U;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelGrid::reset(glm::dvec2 const& cellSize, double maxDepthRatio, std::size_t capacity) {
+  mCellSize      = cellSize;
+  mMaxDepthRatio = maxDepthRatio;
+
+  mEntries.clear();
+  mNodes.clear();
+
+  // Use about two buckets per box. The number of buckets has to be a power of two.
+  std::size_t bucketCount = 16;
+  while (bucketCount < 2 * capacity) {
+    bucketCount *= 2;
+  }
+
+  mBuckets.assign(bucketCount, -1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelGrid::tryInsert(glm::dvec4 const& box, double depth) {
+
+  // Boxes with non-finite coordinates cannot be assigned to any cell. They never collide, just like
+  // in a pairwise test where all comparisons with NaN are false.
+  if (!std::isfinite(box.x + box.y + box.z + box.w)) {
+    return true;
+  }
+
+  glm::ivec4 cells = getCellRange(box);
+
+  // First check all boxes in the covered cells for collisions.
+  for (int32_t y = cells.y; y <= cells.w; ++y) {
+    for (int32_t x = cells.x; x <= cells.z; ++x) {
+      for (int32_t n = mBuckets[getBucket(x, y)]; n >= 0; n = mNodes[n].mNext) {
+        Entry const& other = mEntries[mNodes[n].mEntry];
+
+        // If the labels are far apart in depth, both can be shown.
+        double depthRatio = std::max(depth, other.mDepth) / std::min(depth, other.mDepth);
+        if (depthRatio > mMaxDepthRatio) {
+          continue;
+        }
+
+        glm::dvec4 const& b = other.mBox;
+        if (b.x + b.z > box.x && b.y + b.w > box.y && box.x + box.z > b.x && box.y + box.w > b.y) {
+          return false;
+        }
+      }
+    }
+  }
+
+  // Then add the box to all covered cells.
+  auto entry = static_cast<uint32_t>(mEntries.size());
+  mEntries.push_back({box, depth});
+
+  for (int32_t y = cells.y; y <= cells.w; ++y) {
+    for (int32_t x = cells.x; x <= cells.z; ++x) {
+      uint32_t bucket = getBucket(x, y);
+      mNodes.push_back({mBuckets[bucket], entry});
+      mBuckets[bucket] = static_cast<int32_t>(mNodes.size() - 1);
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LabelGrid::size() const {
+  return mEntries.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::ivec4 LabelGrid::getCellRange(glm::dvec4 const& box) const {
+  auto toCell = [](double value, double cellSize) {
+    double cell = std::floor(value / cellSize);
+    return static_cast<int32_t>(std::clamp(cell, -MAX_CELL_COORDINATE, MAX_CELL_COORDINATE));
+  };
+
+  return {toCell(box.x, mCellSize.x), toCell(box.y, mCellSize.y),
+      toCell(box.x + box.z, mCellSize.x), toCell(box.y + box.w, mCellSize.y)};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t LabelGrid::getBucket(int32_t x, int32_t y) const {
+  uint32_t hash =
+      (static_cast<uint32_t>(x) * HASH_PRIME_X) ^ (static_cast<uint32_t>(y) * HASH_PRIME_Y);
+  return hash & static_cast<uint32_t>(mBuckets.size() - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
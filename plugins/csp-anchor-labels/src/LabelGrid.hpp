@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_ANCHOR_LABELS_LABEL_GRID_HPP
+#define CSP_ANCHOR_LABELS_LABEL_GRID_HPP
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// A uniform grid which is used to decide which labels can be shown without overlapping others.
+/// Boxes are inserted in order of priority; a box is only accepted if it does not overlap any box
+/// which has been accepted before. The grid cells are stored in a spatial hash, so the screen area
+/// covered by the labels does not matter. If the cell size is similar to the size of the boxes,
+/// each insertion only has to look at a handful of boxes and the entire process is linear in the
+/// number of inserted boxes.
+class LabelGrid {
+ public:
+  /// Removes all boxes from the grid. The cell size should be about the size of the boxes which
+  /// are going to be inserted. Two overlapping boxes do not collide if the ratio of their depths
+  /// is larger than maxDepthRatio; use infinity to make all overlapping boxes collide. The
+  /// capacity is the expected number of boxes, it determines the number of hash buckets.
+  void reset(glm::dvec2 const& cellSize, double maxDepthRatio, std::size_t capacity);
+
+  /// Inserts the box if it does not collide with any box which has been inserted since the last
+  /// call to reset(). The box is given as (x, y, width, height) and the depth is its distance to
+  /// the observer which must be larger than zero. Returns true if the box has been inserted. Boxes
+  /// with non-finite coordinates are accepted but not inserted.
+  bool tryInsert(glm::dvec4 const& box, double depth);
+
+  /// Returns the number of boxes which have been inserted since the last call to reset().
+  std::size_t size() const;
+
+ private:
+  struct Entry {
+    glm::dvec4 mBox;
+    double     mDepth;
+  };
+
+  /// Each bucket is the head of a singly-linked list of nodes. A box is referenced by one node per
+  /// cell it covers. Different cells may end up in the same bucket, this is harmless as the boxes
+  /// are compared anyways.
+  struct Node {
+    int32_t  mNext;
+    uint32_t mEntry;
+  };
+
+  glm::ivec4 getCellRange(glm::dvec4 const& box) const;
+  uint32_t   getBucket(int32_t x, int32_t y) const;
+
+  glm::dvec2 mCellSize{1.0};
+  double     mMaxDepthRatio = 0.0;
+
+  std::vector<Entry>   mEntries;
+  std::vector<Node>    mNodes;
+  std::vector<int32_t> mBuckets;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_LABEL_GRID_HPP
@@ -0,0 +1,278 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "LabelRenderer.hpp"
+
+#include "logger.hpp"
+
+#include "../../../src/cs-gui/GuiItem.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
+#include "../../../src/cs-utils/utils.hpp"
+
+#include <GL/glew.h>
+#include <VistaKernel/GraphicsManager/VistaGraphicsManager.h>
+#include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
+#include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
+#include <VistaKernel/VistaSystem.h>
+#include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace csp::anchorlabels {
+
+namespace {
+
+// The atlas is ATLAS_COLUMNS cells wide. It starts with INITIAL_ATLAS_ROWS rows and doubles its
+// height whenever it is full, up to MAX_ATLAS_ROWS rows. This keeps the atlas below 16384 pixels,
+// which is the minimum maximum texture size of OpenGL 4.1.
+const int ATLAS_COLUMNS      = 16;
+const int INITIAL_ATLAS_ROWS = 8;
+const int MAX_ATLAS_ROWS     = 546;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const int LabelRenderer::CELL_WIDTH  = 150;
+const int LabelRenderer::CELL_HEIGHT = 30;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* LabelRenderer::QUAD_VERT = R"(
+vec2 positions[4] = vec2[](
+    vec2(-0.5, 0.5),
+    vec2(0.5, 0.5),
+    vec2(-0.5, -0.5),
+    vec2(0.5, -0.5)
+);
+
+layout(location = 0) in vec3  iPosition;
+layout(location = 1) in float iScale;
+layout(location = 2) in float iCell;
+
+uniform mat4  uMatModelView;
+uniform mat4  uMatProjection;
+uniform vec2  uLabelSize;
+uniform float uLabelOffset;
+uniform vec2  uCellSize;
+
+out vec2 vTexCoords;
+
+void main()
+{
+  vec2 p = positions[gl_VertexID];
+
+  // The labels are billboards facing the observer. They are placed above the anchor.
+  vec4 center = uMatModelView * vec4(iPosition, 1.0);
+  vec2 offset = (p * uLabelSize + vec2(0.0, uLabelOffset)) * iScale;
+  gl_Position = uMatProjection * (center + vec4(offset, 0.0, 0.0));
+
+  float column = mod(iCell, float(ATLAS_COLUMNS));
+  float row    = floor(iCell / float(ATLAS_COLUMNS));
+  vTexCoords   = (vec2(column, row) + vec2(p.x, -p.y) + 0.5) * uCellSize;
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* LabelRenderer::QUAD_FRAG = R"(
+in vec2 vTexCoords;
+
+uniform sampler2D uTexture;
+
+layout(location = 0) out vec4 oColor;
+
+void main() {
+  oColor = texture(uTexture, vTexCoords);
+  if (oColor.a == 0.0) discard;
+
+  oColor.rgb /= oColor.a;
+}
+)";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelRenderer::LabelRenderer(std::shared_ptr<Plugin::Settings> pluginSettings)
+    : mPluginSettings(std::move(pluginSettings))
+    , mAtlas(std::make_unique<cs::gui::GuiItem>(
+          "file://../share/resources/gui/anchor_label_atlas.html")) {
+
+  mAtlas->setCanScroll(false);
+  mAtlas->setIsInteractive(false);
+  mAtlas->waitForFinishedLoading();
+
+  resizeAtlas(INITIAL_ATLAS_ROWS);
+
+  // The instance data is streamed to the VBO each frame, it is only allocated on first use.
+  mVAO.EnableAttributeArray(0);
+  mVAO.SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, sizeof(Instance),
+      static_cast<GLuint>(offsetof(Instance, mPosition)), &mVBO);
+
+  mVAO.EnableAttributeArray(1);
+  mVAO.SpecifyAttributeArrayFloat(1, 1, GL_FLOAT, GL_FALSE, sizeof(Instance),
+      static_cast<GLuint>(offsetof(Instance, mScale)), &mVBO);
+
+  mVAO.EnableAttributeArray(2);
+  mVAO.SpecifyAttributeArrayFloat(2, 1, GL_FLOAT, GL_FALSE, sizeof(Instance),
+      static_cast<GLuint>(offsetof(Instance, mCell)), &mVBO);
+
+  // All attributes advance once per label, the quad's corners are generated in the shader.
+  mVAO.Bind();
+  glVertexAttribDivisor(0, 1);
+  glVertexAttribDivisor(1, 1);
+  glVertexAttribDivisor(2, 1);
+  mVAO.Release();
+
+  std::string defines = "#version 330\n";
+  defines += "#define ATLAS_COLUMNS " + std::to_string(ATLAS_COLUMNS) + "\n";
+
+  mShader.InitVertexShaderFromString(defines + QUAD_VERT);
+  mShader.InitFragmentShaderFromString(defines + QUAD_FRAG);
+  mShader.Link();
+
+  mUniforms.modelViewMatrix  = mShader.GetUniformLocation("uMatModelView");
+  mUniforms.projectionMatrix = mShader.GetUniformLocation("uMatProjection");
+  mUniforms.texture          = mShader.GetUniformLocation("uTexture");
+  mUniforms.labelSize        = mShader.GetUniformLocation("uLabelSize");
+  mUniforms.labelOffset      = mShader.GetUniformLocation("uLabelOffset");
+  mUniforms.cellSize         = mShader.GetUniformLocation("uCellSize");
+
+  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  mGLNode.reset(sceneGraph->NewOpenGLNode(sceneGraph->GetRoot(), this));
+  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
+      mGLNode.get(), static_cast<int>(cs::utils::DrawOrder::eTransparentItems));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelRenderer::~LabelRenderer() {
+  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  sceneGraph->GetRoot()->DisconnectChild(mGLNode.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<uint32_t> LabelRenderer::addLabel(std::string const& text) {
+  uint32_t cell = 0;
+
+  if (!mFreeCells.empty()) {
+    cell = mFreeCells.back();
+    mFreeCells.pop_back();
+  } else if (mCellCount < static_cast<uint32_t>(MAX_ATLAS_ROWS * ATLAS_COLUMNS)) {
+    cell = mCellCount++;
+  } else {
+    logger().warn("Cannot add label '{}': The label atlas is full!", text);
+    return std::nullopt;
+  }
+
+  int column = static_cast<int>(cell) % ATLAS_COLUMNS;
+  int row    = static_cast<int>(cell) / ATLAS_COLUMNS;
+
+  if (row >= mAtlasRows) {
+    resizeAtlas(std::min(2 * mAtlasRows, MAX_ATLAS_ROWS));
+  }
+
+  mAtlas->callJavascript("setLabel", cell, column * CELL_WIDTH, row * CELL_HEIGHT, text);
+
+  return cell;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelRenderer::removeLabel(uint32_t cell) {
+  mAtlas->callJavascript("removeLabel", cell);
+  mFreeCells.push_back(cell);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelRenderer::setInstances(std::vector<Instance> instances) {
+  mInstances      = std::move(instances);
+  mInstancesDirty = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelRenderer::Do() {
+  cs::utils::FrameStats::ScopedTimer timer("Anchor Labels");
+
+  if (mInstancesDirty) {
+    mVBO.Bind(GL_ARRAY_BUFFER);
+    mVBO.BufferData(mInstances.size() * sizeof(Instance), mInstances.data(), GL_STREAM_DRAW);
+    mVBO.Release();
+
+    mInstanceCount  = mInstances.size();
+    mInstancesDirty = false;
+  }
+
+  // The atlas is resized asynchronously. Until the new texture is available, the cells of the
+  // labels may be outside of the texture.
+  bool textureRightSize = mAtlas->getWidth() == mAtlas->getTextureSizeX() &&
+                          mAtlas->getHeight() == mAtlas->getTextureSizeY();
+
+  if (mInstanceCount == 0 || !textureRightSize) {
+    return true;
+  }
+
+  glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
+
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glDisable(GL_CULL_FACE);
+
+  mShader.Bind();
+
+  std::array<GLfloat, 16> glMat{};
+  glGetFloatv(GL_MODELVIEW_MATRIX, glMat.data());
+  glUniformMatrix4fv(mUniforms.modelViewMatrix, 1, GL_FALSE, glMat.data());
+  glGetFloatv(GL_PROJECTION_MATRIX, glMat.data());
+  glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMat.data());
+
+  // Labels are sized like the GUI area of the AnchorLabel class.
+  float const labelWidth = 1.2F;
+  mShader.SetUniform(mUniforms.labelSize, labelWidth,
+      labelWidth * static_cast<float>(CELL_HEIGHT) / static_cast<float>(CELL_WIDTH));
+  mShader.SetUniform(
+      mUniforms.labelOffset, static_cast<float>(mPluginSettings->mLabelOffset.get()));
+  mShader.SetUniform(mUniforms.cellSize,
+      static_cast<float>(CELL_WIDTH) / static_cast<float>(mAtlas->getTextureSizeX()),
+      static_cast<float>(CELL_HEIGHT) / static_cast<float>(mAtlas->getTextureSizeY()));
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, mAtlas->getTexture());
+  mShader.SetUniform(mUniforms.texture, 0);
+
+  mVAO.Bind();
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(mInstanceCount));
+  mVAO.Release();
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  mShader.Release();
+
+  glPopAttrib();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelRenderer::GetBoundingBox(VistaBoundingBox& /*bb*/) {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelRenderer::resizeAtlas(int rows) {
+  mAtlasRows = rows;
+  mAtlas->onAreaResize(ATLAS_COLUMNS * CELL_WIDTH, mAtlasRows * CELL_HEIGHT);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
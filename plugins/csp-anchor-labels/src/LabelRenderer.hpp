@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_ANCHOR_LABELS_LABEL_RENDERER_HPP
+#define CSP_ANCHOR_LABELS_LABEL_RENDERER_HPP
+
+#include "Plugin.hpp"
+
+#include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+#include <VistaOGLExt/VistaBufferObject.h>
+#include <VistaOGLExt/VistaGLSLShader.h>
+#include <VistaOGLExt/VistaVertexArrayObject.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+class VistaOpenGLNode;
+
+namespace cs::gui {
+class GuiItem;
+} // namespace cs::gui
+
+namespace csp::anchorlabels {
+
+/// The LabelRenderer draws many labels with a single instanced draw call. The text of all labels
+/// is rendered by one web view into a texture atlas; each label occupies one fixed-size cell of
+/// this atlas. Each frame, the plugin passes the labels which should be drawn together with their
+/// observer-relative positions. They are drawn as billboards facing the observer, sized and placed
+/// like the labels of the AnchorLabel class.
+///
+/// In contrast to the AnchorLabel class, labels drawn by this class cannot be clicked.
+class LabelRenderer : public IVistaOpenGLDraw {
+ public:
+  /// One label which should be drawn in the current frame.
+  struct Instance {
+    /// The observer-relative position of the anchor.
+    glm::vec3 mPosition;
+
+    /// The scale of the label, this is computed like in AnchorLabel::update().
+    float mScale;
+
+    /// The atlas cell of the label as returned by addLabel(). It is stored as float so that it can
+    /// be passed as a regular vertex attribute.
+    float mCell;
+  };
+
+  /// The size of one atlas cell in pixels. This determines the aspect ratio of all labels. It
+  /// matches the size of the GUI area of an AnchorLabel, so that both modes show the same labels.
+  static const int CELL_WIDTH;
+  static const int CELL_HEIGHT;
+
+  explicit LabelRenderer(std::shared_ptr<Plugin::Settings> pluginSettings);
+
+  LabelRenderer(LabelRenderer const& other) = delete;
+  LabelRenderer(LabelRenderer&& other)      = delete;
+
+  LabelRenderer& operator=(LabelRenderer const& other) = delete;
+  LabelRenderer& operator=(LabelRenderer&& other)      = delete;
+
+  ~LabelRenderer() override;
+
+  /// Renders the given text into a free cell of the atlas. The atlas grows if required. Returns
+  /// std::nullopt if the atlas is full.
+  std::optional<uint32_t> addLabel(std::string const& text);
+
+  /// Frees the given atlas cell so that it can be reused by another label.
+  void removeLabel(uint32_t cell);
+
+  /// Sets the labels which should be drawn in the next frames. They are drawn in the given order,
+  /// so they should be sorted back-to-front.
+  void setInstances(std::vector<Instance> instances);
+
+  bool Do() override;
+  bool GetBoundingBox(VistaBoundingBox& bb) override;
+
+ private:
+  /// Resizes the atlas web view so that it has at least the given number of rows.
+  void resizeAtlas(int rows);
+
+  std::shared_ptr<Plugin::Settings> mPluginSettings;
+
+  std::unique_ptr<cs::gui::GuiItem> mAtlas;
+  std::unique_ptr<VistaOpenGLNode>  mGLNode;
+
+  int                   mAtlasRows = 0;
+  uint32_t              mCellCount = 0;
+  std::vector<uint32_t> mFreeCells;
+
+  std::vector<Instance> mInstances;
+  bool                  mInstancesDirty = false;
+  std::size_t           mInstanceCount  = 0;
+
+  VistaGLSLShader        mShader;
+  VistaVertexArrayObject mVAO;
+  VistaBufferObject      mVBO;
+
+  struct {
+    uint32_t modelViewMatrix  = 0;
+    uint32_t projectionMatrix = 0;
+    uint32_t texture          = 0;
+    uint32_t labelSize        = 0;
+    uint32_t labelOffset      = 0;
+    uint32_t cellSize         = 0;
+  } mUniforms;
+
+  static const char* QUAD_VERT;
+  static const char* QUAD_FRAG;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_LABEL_RENDERER_HPP
@@ -7,15 +7,19 @@
 
 #include "Plugin.hpp"
 #include "AnchorLabel.hpp"
+#include "LabelRenderer.hpp"
 
 #include "../../../src/cs-core/GuiManager.hpp"
 #include "../../../src/cs-core/PluginBase.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-scene/CelestialObject.hpp"
 #include "../../../src/cs-utils/logger.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 #include "logger.hpp"
 
+#include <glm/gtx/component_wise.hpp>
 #include <iostream>
+#include <limits>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -33,6 +37,14 @@ EXPORT_FN void destroy(cs::core::PluginBase* pluginBase) {
 
 namespace csp::anchorlabels {
 
+namespace {
+
+// Converts the pixel size of a label to the screen-space units used for collision detection. This
+// is the same factor as used by AnchorLabel::getScreenSpaceBB().
+const double SCREEN_SPACE_SCALE = 0.0005;
+
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void from_json(nlohmann::json const& j, Plugin::Settings& o) {
@@ -42,6 +54,7 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "labelScale", o.mLabelScale);
   cs::core::Settings::deserialize(j, "depthScale", o.mDepthScale);
   cs::core::Settings::deserialize(j, "labelOffset", o.mLabelOffset);
+  cs::core::Settings::deserialize(j, "batchedRendering", o.mBatchedRendering);
   cs::core::Settings::deserialize(j, "blacklist", o.mBlacklist);
 }
 
@@ -52,6 +65,7 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "labelScale", o.mLabelScale);
   cs::core::Settings::serialize(j, "depthScale", o.mDepthScale);
   cs::core::Settings::serialize(j, "labelOffset", o.mLabelOffset);
+  cs::core::Settings::serialize(j, "batchedRendering", o.mBatchedRendering);
   cs::core::Settings::serialize(j, "blacklist", o.mBlacklist);
 }
 
@@ -70,15 +84,8 @@ void Plugin::init() {
   mGuiManager->executeJavascriptFile("../share/resources/gui/js/csp-anchor-labels.js");
 
   // For all bodies that will be created in the future we also create a label.
-  mAddObjectConnection =
-      mAllSettings->mObjects.onAdd().connect([this](auto const& name, auto const& object) {
-        if (mPluginSettings->mBlacklist.find(name) == mPluginSettings->mBlacklist.end()) {
-          mAnchorLabels.emplace_back(std::make_unique<AnchorLabel>(
-              name, object, mPluginSettings, mSolarSystem, mGuiManager, mInputManager));
-
-          mNeedsResort = true;
-        }
-      });
+  mAddObjectConnection = mAllSettings->mObjects.onAdd().connect(
+      [this](auto const& name, auto const& object) { addLabel(name, object); });
 
   // If a body gets dropped from the solar system remove the label too
   mRemoveObjectConnection = mAllSettings->mObjects.onRemove().connect([this](auto const& /*name*/,
@@ -86,6 +93,16 @@ void Plugin::init() {
     mAnchorLabels.erase(std::remove_if(mAnchorLabels.begin(), mAnchorLabels.end(),
                             [object](auto const& label) { return object == label->getObject(); }),
         mAnchorLabels.end());
+
+    mBatchedLabels.erase(std::remove_if(mBatchedLabels.begin(), mBatchedLabels.end(),
+                             [this, object](BatchedLabel const& label) {
+                               if (object != label.mObject) {
+                                 return false;
+                               }
+                               mLabelRenderer->removeLabel(label.mCell);
+                               return true;
+                             }),
+        mBatchedLabels.end());
   });
 
   mGuiManager->getGui()->registerCallback("anchorLabels.setEnabled",
@@ -127,6 +144,16 @@ void Plugin::init() {
   mPluginSettings->mLabelOffset.connectAndTouch(
       [this](double value) { mGuiManager->setSliderValue("anchorLabels.setOffset", value); });
 
+  mGuiManager->getGui()->registerCallback("anchorLabels.setBatchedRendering",
+      "Draws all anchor labels at once. This is faster but the labels cannot be clicked.",
+      std::function([this](bool value) { mPluginSettings->mBatchedRendering = value; }));
+  mPluginSettings->mBatchedRendering.connectAndTouch([this](bool enable) {
+    mGuiManager->setCheckboxValue("anchorLabels.setBatchedRendering", enable);
+
+    // Switching the mode recreates all labels in the next frame.
+    mNeedsRecreate = true;
+  });
+
   onLoad();
 
   logger().info("Loading done.");
@@ -135,6 +162,20 @@ void Plugin::init() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Plugin::update() {
+  if (mNeedsRecreate) {
+    recreateLabels();
+  }
+
+  if (mLabelRenderer) {
+    updateBatchedLabels();
+  } else {
+    updateAnchorLabels();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::updateAnchorLabels() {
   if (mPluginSettings->mEnabled.get()) {
 
     if (mNeedsResort) {
@@ -211,6 +252,74 @@ void Plugin::update() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Plugin::updateBatchedLabels() {
+  if (!mPluginSettings->mEnabled.get()) {
+    mLabelRenderer->setInstances({});
+    return;
+  }
+
+  if (mNeedsResort) {
+    std::sort(mBatchedLabels.begin(), mBatchedLabels.end(),
+        [](BatchedLabel const& l1, BatchedLabel const& l2) {
+          return l1.mBodySize > l2.mBodySize;
+        });
+    mNeedsResort = false;
+  }
+
+  // First collect all labels which are visible at all. This is the only step which has to look
+  // at all labels, everything below only depends on the number of visible labels.
+  std::vector<std::pair<BatchedLabel const*, glm::dvec3>> candidates;
+  for (auto const& label : mBatchedLabels) {
+    if (label.mObject->getIsOrbitVisible()) {
+      candidates.emplace_back(&label, label.mObject->getObserverRelativePosition());
+    }
+  }
+
+  // Then find the labels which do not overlap with bigger ones. Since the list is sorted by body
+  // size, the bigger labels are inserted into the grid first.
+  double const     labelScale = mPluginSettings->mLabelScale.get();
+  glm::dvec2 const labelSize  = labelScale * SCREEN_SPACE_SCALE *
+                               glm::dvec2(LabelRenderer::CELL_WIDTH, LabelRenderer::CELL_HEIGHT);
+
+  double maxDepthRatio = std::numeric_limits<double>::infinity();
+  if (mPluginSettings->mEnableDepthOverlap.get()) {
+    maxDepthRatio = 1.0 + mPluginSettings->mIgnoreOverlapThreshold.get();
+  }
+
+  mLabelGrid.reset(labelSize, maxDepthRatio, candidates.size());
+
+  std::vector<std::pair<double, LabelRenderer::Instance>> instances;
+  for (auto const& [label, position] : candidates) {
+    double     distance  = glm::length(position);
+    glm::dvec2 screenPos = position.xy() / position.z;
+    glm::dvec4 box(screenPos - labelSize * 0.5, labelSize);
+
+    if (mLabelGrid.tryInsert(box, distance)) {
+      double const scaleFactor = 0.05;
+      double const scale =
+          glm::pow(distance, mPluginSettings->mDepthScale.get()) * labelScale * scaleFactor;
+
+      LabelRenderer::Instance instance{
+          glm::vec3(position), static_cast<float>(scale), static_cast<float>(label->mCell)};
+      instances.emplace_back(distance, instance);
+    }
+  }
+
+  // Finally, draw the labels back-to-front.
+  std::sort(instances.begin(), instances.end(),
+      [](auto const& a, auto const& b) { return a.first > b.first; });
+
+  std::vector<LabelRenderer::Instance> sortedInstances;
+  sortedInstances.reserve(instances.size());
+  for (auto const& instance : instances) {
+    sortedInstances.push_back(instance.second);
+  }
+
+  mLabelRenderer->setInstances(std::move(sortedInstances));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Plugin::deInit() {
   logger().info("Unloading plugin...");
 
@@ -218,6 +327,8 @@ void Plugin::deInit() {
   onSave();
 
   mAnchorLabels.clear();
+  mBatchedLabels.clear();
+  mLabelRenderer.reset();
 
   mAllSettings->mObjects.onAdd().disconnect(mAddObjectConnection);
   mAllSettings->mObjects.onRemove().disconnect(mRemoveObjectConnection);
@@ -230,6 +341,7 @@ void Plugin::deInit() {
   mGuiManager->getGui()->unregisterCallback("anchorLabels.setScale");
   mGuiManager->getGui()->unregisterCallback("anchorLabels.setDepthScale");
   mGuiManager->getGui()->unregisterCallback("anchorLabels.setOffset");
+  mGuiManager->getGui()->unregisterCallback("anchorLabels.setBatchedRendering");
 
   mAllSettings->onLoad().disconnect(mOnLoadConnection);
   mAllSettings->onSave().disconnect(mOnSaveConnection);
@@ -243,24 +355,57 @@ void Plugin::onLoad() {
   // Read settings from JSON.
   from_json(mAllSettings->mPlugins.at("csp-anchor-labels"), *mPluginSettings);
 
+  recreateLabels();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::onSave() {
+  mAllSettings->mPlugins["csp-anchor-labels"] = *mPluginSettings;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::recreateLabels() {
+
   // Remove all labels first.
   mAnchorLabels.clear();
+  mBatchedLabels.clear();
+
+  if (mPluginSettings->mBatchedRendering.get()) {
+    mLabelRenderer = std::make_unique<LabelRenderer>(mPluginSettings);
+  } else {
+    mLabelRenderer.reset();
+  }
 
   // Then create labels for all bodies that already exist.
   for (auto const& [name, object] : mAllSettings->mObjects) {
-    if (mPluginSettings->mBlacklist.find(name) == mPluginSettings->mBlacklist.end()) {
-      mAnchorLabels.emplace_back(std::make_unique<AnchorLabel>(
-          name, object, mPluginSettings, mSolarSystem, mGuiManager, mInputManager));
-
-      mNeedsResort = true;
-    }
+    addLabel(name, object);
   }
+
+  mNeedsRecreate = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Plugin::onSave() {
-  mAllSettings->mPlugins["csp-anchor-labels"] = *mPluginSettings;
+void Plugin::addLabel(
+    std::string const& name, std::shared_ptr<const cs::scene::CelestialObject> object) {
+  if (mPluginSettings->mBlacklist.find(name) != mPluginSettings->mBlacklist.end()) {
+    return;
+  }
+
+  if (mLabelRenderer) {
+    auto cell = mLabelRenderer->addLabel(name);
+    if (cell) {
+      double bodySize = glm::compMax(object->getRadii());
+      mBatchedLabels.push_back({std::move(object), *cell, bodySize});
+    }
+  } else {
+    mAnchorLabels.emplace_back(std::make_unique<AnchorLabel>(
+        name, std::move(object), mPluginSettings, mSolarSystem, mGuiManager, mInputManager));
+  }
+
+  mNeedsResort = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -11,11 +11,18 @@
 #include "../../../src/cs-core/PluginBase.hpp"
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-utils/Property.hpp"
+#include "LabelGrid.hpp"
+
 #include <memory>
 #include <unordered_set>
 
+namespace cs::scene {
+class CelestialObject;
+} // namespace cs::scene
+
 namespace csp::anchorlabels {
 class AnchorLabel;
+class LabelRenderer;
 
 /// This plugin puts labels over anchors in space. It uses the object names as text. If you click on
 /// the label you are being flown to the anchor. The plugin is configurable via the application
@@ -49,6 +56,10 @@ class Plugin : public cs::core::PluginBase {
     /// The value describes the labels height over the anchor.
     cs::utils::DefaultProperty<double> mLabelOffset{0.2};
 
+    /// If set to true, all labels are drawn by one LabelRenderer instead of having one web view
+    /// each. This scales to thousands of labels, but the labels cannot be clicked.
+    cs::utils::DefaultProperty<bool> mBatchedRendering{false};
+
     /// Celestial objects with these names will not have an associated label.
     std::unordered_set<std::string> mBlacklist;
   };
@@ -58,13 +69,32 @@ class Plugin : public cs::core::PluginBase {
   void update() override;
 
  private:
+  /// A label drawn by the LabelRenderer.
+  struct BatchedLabel {
+    std::shared_ptr<const cs::scene::CelestialObject> mObject;
+    uint32_t                                          mCell;
+    double                                            mBodySize;
+  };
+
   void onLoad();
   void onSave();
 
+  /// Removes all labels and creates new ones for all objects, either as AnchorLabels or as
+  /// BatchedLabels, depending on the current settings.
+  void recreateLabels();
+  void addLabel(std::string const& name, std::shared_ptr<const cs::scene::CelestialObject> object);
+
+  void updateAnchorLabels();
+  void updateBatchedLabels();
+
   std::shared_ptr<Settings>                 mPluginSettings = std::make_shared<Settings>();
   std::vector<std::unique_ptr<AnchorLabel>> mAnchorLabels;
+  std::vector<BatchedLabel>                 mBatchedLabels;
+  std::unique_ptr<LabelRenderer>            mLabelRenderer;
+  LabelGrid                                 mLabelGrid;
 
-  bool mNeedsResort = true; ///< When a new label gets added resort the vector
+  bool mNeedsResort   = true;  ///< When a new label gets added resort the vector
+  bool mNeedsRecreate = false; ///< When the rendering mode changes, all labels are recreated
 
   int mAddObjectConnection    = -1;
   int mRemoveObjectConnection = -1;
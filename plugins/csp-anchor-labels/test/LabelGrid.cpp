@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/LabelGrid.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+#include <chrono>
+#include <limits>
+#include <random>
+
+namespace csp::anchorlabels {
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+
+struct Label {
+  glm::dvec4 mBox;
+  double     mDepth;
+};
+
+// Creates labels of the given size at random positions with random depths.
+std::vector<Label> createLabels(std::size_t count, glm::dvec2 const& size, double extent) {
+  std::mt19937                           generator(0);
+  std::uniform_real_distribution<double> position(-extent, extent);
+  std::uniform_real_distribution<double> depth(1.0, 2.0);
+
+  std::vector<Label> labels;
+  for (std::size_t i = 0; i < count; ++i) {
+    labels.push_back(
+        {glm::dvec4(position(generator), position(generator), size.x, size.y), depth(generator)});
+  }
+
+  return labels;
+}
+
+// This is the pairwise overlap test which was used by the plugin before the LabelGrid existed.
+std::vector<bool> cullPairwise(std::vector<Label> const& labels, double maxDepthRatio) {
+  std::vector<Label> accepted;
+  std::vector<bool>  result;
+
+  for (auto const& label : labels) {
+    glm::dvec4 const& a = label.mBox;
+
+    bool canBeAdded = true;
+    for (auto const& other : accepted) {
+      double depthRatio =
+          std::max(label.mDepth, other.mDepth) / std::min(label.mDepth, other.mDepth);
+      if (depthRatio > maxDepthRatio) {
+        continue;
+      }
+
+      glm::dvec4 const& b = other.mBox;
+      if (b.x + b.z > a.x && b.y + b.w > a.y && a.x + a.z > b.x && a.y + a.w > b.y) {
+        canBeAdded = false;
+        break;
+      }
+    }
+
+    if (canBeAdded) {
+      accepted.push_back(label);
+    }
+
+    result.push_back(canBeAdded);
+  }
+
+  return result;
+}
+
+std::vector<bool> cullWithGrid(
+    std::vector<Label> const& labels, glm::dvec2 const& cellSize, double maxDepthRatio) {
+  LabelGrid grid;
+  grid.reset(cellSize, maxDepthRatio, labels.size());
+
+  std::vector<bool> result;
+  for (auto const& label : labels) {
+    result.push_back(grid.tryInsert(label.mBox, label.mDepth));
+  }
+
+  return result;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::anchorlabels::LabelGrid") {
+  LabelGrid grid;
+  grid.reset(glm::dvec2(1.0, 1.0), INF, 16);
+
+  SUBCASE("Overlapping boxes collide, touching boxes do not") {
+    CHECK(grid.tryInsert(glm::dvec4(0.0, 0.0, 1.0, 1.0), 1.0));
+    CHECK_FALSE(grid.tryInsert(glm::dvec4(0.5, 0.5, 1.0, 1.0), 1.0));
+    CHECK(grid.tryInsert(glm::dvec4(1.0, 0.0, 1.0, 1.0), 1.0));
+    CHECK(grid.tryInsert(glm::dvec4(0.0, -1.0, 1.0, 1.0), 1.0));
+    CHECK_EQ(grid.size(), 3);
+  }
+
+  SUBCASE("Negative and large coordinates") {
+    CHECK(grid.tryInsert(glm::dvec4(-10.5, -3.2, 1.0, 1.0), 1.0));
+    CHECK_FALSE(grid.tryInsert(glm::dvec4(-10.0, -3.0, 1.0, 1.0), 1.0));
+    CHECK(grid.tryInsert(glm::dvec4(1e12, -1e12, 1.0, 1.0), 1.0));
+    CHECK_FALSE(grid.tryInsert(glm::dvec4(1e12 + 0.5, -1e12, 1.0, 1.0), 1.0));
+    CHECK_EQ(grid.size(), 2);
+  }
+
+  SUBCASE("Boxes larger than the cells") {
+    grid.reset(glm::dvec2(0.1, 0.1), INF, 16);
+    CHECK(grid.tryInsert(glm::dvec4(0.0, 0.0, 1.0, 1.0), 1.0));
+    CHECK_FALSE(grid.tryInsert(glm::dvec4(0.95, 0.95, 0.01, 0.01), 1.0));
+    CHECK(grid.tryInsert(glm::dvec4(1.05, 0.0, 1.0, 1.0), 1.0));
+  }
+
+  SUBCASE("Boxes far apart in depth do not collide") {
+    grid.reset(glm::dvec2(1.0, 1.0), 1.1, 16);
+    CHECK(grid.tryInsert(glm::dvec4(0.0, 0.0, 1.0, 1.0), 1.0));
+    CHECK(grid.tryInsert(glm::dvec4(0.5, 0.5, 1.0, 1.0), 1.2));
+    CHECK_FALSE(grid.tryInsert(glm::dvec4(0.2, 0.2, 1.0, 1.0), 1.05));
+    CHECK_FALSE(grid.tryInsert(glm::dvec4(0.2, 0.2, 1.0, 1.0), 0.95));
+    CHECK(grid.tryInsert(glm::dvec4(0.2, 0.2, 1.0, 1.0), 0.5));
+  }
+
+  SUBCASE("Non-finite boxes are accepted but not inserted") {
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    CHECK(grid.tryInsert(glm::dvec4(nan, 0.0, 1.0, 1.0), 1.0));
+    CHECK(grid.tryInsert(glm::dvec4(INF, 0.0, 1.0, 1.0), 1.0));
+    CHECK_EQ(grid.size(), 0);
+    CHECK(grid.tryInsert(glm::dvec4(0.0, 0.0, 1.0, 1.0), 1.0));
+  }
+
+  SUBCASE("Reset removes all boxes") {
+    CHECK(grid.tryInsert(glm::dvec4(0.0, 0.0, 1.0, 1.0), 1.0));
+    grid.reset(glm::dvec2(1.0, 1.0), INF, 0);
+    CHECK_EQ(grid.size(), 0);
+    CHECK(grid.tryInsert(glm::dvec4(0.0, 0.0, 1.0, 1.0), 1.0));
+  }
+
+  SUBCASE("Results match the pairwise test") {
+    glm::dvec2 size(0.064, 0.012);
+    auto       labels = createLabels(2000, size, 0.5);
+
+    for (double maxDepthRatio : {1.0, 1.025, 1.2, INF}) {
+      auto expected = cullPairwise(labels, maxDepthRatio);
+      CHECK(cullWithGrid(labels, size, maxDepthRatio) == expected);
+      CHECK(cullWithGrid(labels, size * 0.3, maxDepthRatio) == expected);
+      CHECK(cullWithGrid(labels, size * 5.0, maxDepthRatio) == expected);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::anchorlabels::LabelGrid [benchmark]") {
+  glm::dvec2 size(0.064, 0.012);
+
+  for (std::size_t count : {100, 1000, 10000}) {
+    auto labels = createLabels(count, size, 1.0);
+
+    auto start    = std::chrono::high_resolution_clock::now();
+    auto expected = cullPairwise(labels, 1.025);
+
+    std::chrono::duration<double, std::milli> pairwiseTime =
+        std::chrono::high_resolution_clock::now() - start;
+
+    start       = std::chrono::high_resolution_clock::now();
+    auto result = cullWithGrid(labels, size, 1.025);
+
+    std::chrono::duration<double, std::milli> gridTime =
+        std::chrono::high_resolution_clock::now() - start;
+
+    CHECK(result == expected);
+
+    MESSAGE(count, " labels: pairwise ", pairwiseTime.count(), " ms, LabelGrid ", gridTime.count(),
+        " ms");
+  }
+}
+
+} // namespace csp::anchorlabels
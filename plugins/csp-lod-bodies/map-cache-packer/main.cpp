@@ -0,0 +1,162 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../../src/cs-utils/CommandLine.hpp"
+#include "../src/TilePackCache.hpp"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <vector>
+
+// -------------------------------------------------------------------------------------------------
+
+namespace {
+
+// Returns the names of all subdirectories of the given directory which are non-negative integers,
+// i.e. the level and x directories of the map cache.
+std::vector<std::pair<int, boost::filesystem::path>> listNumberedDirectories(
+    boost::filesystem::path const& directory) {
+  std::vector<std::pair<int, boost::filesystem::path>> result;
+  std::regex                                           number("[0-9]+");
+
+  for (auto const& entry : boost::filesystem::directory_iterator(directory)) {
+    auto name = entry.path().filename().string();
+    if (boost::filesystem::is_directory(entry.path()) && std::regex_match(name, number)) {
+      result.emplace_back(std::stoi(name), entry.path());
+    }
+  }
+
+  return result;
+}
+
+// Removes the given directory if it is empty.
+void removeIfEmpty(boost::filesystem::path const& directory) {
+  if (boost::filesystem::is_empty(directory)) {
+    boost::filesystem::remove(directory);
+  }
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// This tool converts the map cache of csp-lod-bodies from the one-file-per-tile layout to the    //
+// packed layout. See the README.md file in this directory for usage instructions!                //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+
+  std::string cInput;
+  std::string cOutput;
+  bool        cDelete    = false;
+  bool        cPrintHelp = false;
+
+  // First configure all possible command line options.
+  cs::utils::CommandLine args("Welcome to the Map Cache Packer! Here are the available options:");
+  args.addArgument({"-i", "--input"}, &cInput,
+      "The map cache directory, e.g. 'install/linux-Release/bin/map-cache' (required).");
+  args.addArgument({"-o", "--output"}, &cOutput,
+      "The directory where the packs are written to. Defaults to the input directory.");
+  args.addArgument({"--delete"}, &cDelete,
+      "Remove the tile files and empty directories once they have been packed.");
+  args.addArgument({"-h", "--help"}, &cPrintHelp, "Show this help message.");
+
+  // Then do the actual parsing.
+  try {
+    args.parse(std::vector<std::string>(argv + 1, argv + argc));
+  } catch (std::runtime_error const& e) {
+    std::cerr << "Failed to parse command line arguments: " << e.what() << std::endl;
+    return 1;
+  }
+
+  // When cPrintHelp was set to true, we print a help message and exit.
+  if (cPrintHelp) {
+    args.printHelp();
+    return 0;
+  }
+
+  if (cInput.empty() || !boost::filesystem::is_directory(cInput)) {
+    std::cerr << "Please specify an existing map cache directory with --input!" << std::endl;
+    return 1;
+  }
+
+  if (cOutput.empty()) {
+    cOutput = cInput;
+  }
+
+  // The map cache contains one directory per data set. Inside, the tiles are stored in
+  // <level>/<x>/<y>.<png|tiff> files.
+  std::regex tileFile("([0-9]+)\\.(png|tiff)");
+
+  for (auto const& dataset : boost::filesystem::directory_iterator(cInput)) {
+    if (!boost::filesystem::is_directory(dataset.path())) {
+      continue;
+    }
+
+    auto outputDirectory = (boost::filesystem::path(cOutput) / dataset.path().filename()).string();
+
+    std::size_t packed  = 0;
+    std::size_t skipped = 0;
+
+    for (auto const& [level, levelDirectory] : listNumberedDirectories(dataset.path())) {
+      for (auto const& [x, xDirectory] : listNumberedDirectories(levelDirectory)) {
+        // The files are collected first, as they may be removed while iterating.
+        std::vector<boost::filesystem::path> files(
+            boost::filesystem::directory_iterator(xDirectory), {});
+
+        for (auto const& file : files) {
+          std::smatch match;
+          std::string name = file.filename().string();
+
+          if (!std::regex_match(name, match, tileFile)) {
+            continue;
+          }
+
+          int  y     = std::stoi(match[1]);
+          auto cache = csp::lodbodies::TilePackCache::get(outputDirectory, match[2]);
+
+          // Empty files are the result of failed downloads, tiles which are already in the pack
+          // have been migrated before.
+          if (boost::filesystem::file_size(file) == 0 || cache->read(level, x, y)) {
+            ++skipped;
+          } else {
+            std::ifstream in(file.string(), std::ifstream::in | std::ifstream::binary);
+            std::string   data(
+                (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+            try {
+              cache->write(level, x, y, data.data(), data.size());
+            } catch (std::runtime_error const& e) {
+              std::cerr << e.what() << std::endl;
+              return 1;
+            }
+
+            ++packed;
+          }
+
+          if (cDelete) {
+            boost::filesystem::remove(file);
+          }
+        }
+
+        if (cDelete) {
+          removeIfEmpty(xDirectory);
+        }
+      }
+
+      if (cDelete) {
+        removeIfEmpty(levelDirectory);
+      }
+    }
+
+    std::cout << dataset.path().filename().string() << ": Packed " << packed << " tiles, skipped "
+              << skipped << " tiles." << std::endl;
+  }
+
+  return 0;
+}
@@ -30,6 +30,30 @@ void BaseTileData::setTexLayer(int layer) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void BaseTileData::setStagingSlot(std::unique_ptr<TileStagingBuffer::Slot> slot) {
+  mStagingSlot = std::move(slot);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<TileStagingBuffer::Slot> BaseTileData::takeStagingSlot() {
+  return std::move(mStagingSlot);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int BaseTileData::getUploadQueueIndex() const {
+  return mUploadQueueIndex;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BaseTileData::setUploadQueueIndex(int index) {
+  mUploadQueueIndex = index;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 uint32_t BaseTileData::getResolution() const {
   return mResolution;
 }
@@ -12,6 +12,7 @@
 #include "MinMaxPyramid.hpp"
 #include "TileDataType.hpp"
 #include "TileId.hpp"
+#include "TileStagingBuffer.hpp"
 
 #include <memory>
 #include <typeinfo>
@@ -47,6 +48,9 @@ class BaseTileData {
   /// Returns pointer to data stored in this tile.
   virtual void* getDataPtr() = 0;
 
+  /// Returns the size of the data stored in this tile in bytes.
+  virtual std::size_t getDataSize() const = 0;
+
   /// Returns the resolution given to the tile at construction time.
   uint32_t getResolution() const;
 
@@ -55,12 +59,27 @@ class BaseTileData {
   int  getTexLayer() const;
   void setTexLayer(int layer);
 
+  /// While the tile is waiting for its upload to the GPU, its data may already have been copied to
+  /// the TileStagingBuffer of a TileTextureArray. This is an internal interface for
+  /// TileTextureArray.
+  void setStagingSlot(std::unique_ptr<TileStagingBuffer::Slot> slot);
+
+  /// Returns the slot set above and removes it from this tile.
+  std::unique_ptr<TileStagingBuffer::Slot> takeStagingSlot();
+
+  /// The position of this tile in the upload queue of a TileTextureArray or -1 if it is not queued.
+  /// This is an internal interface for TileTextureArray.
+  int  getUploadQueueIndex() const;
+  void setUploadQueueIndex(int index);
+
  protected:
   explicit BaseTileData(uint32_t resolution);
 
  private:
-  uint32_t mResolution;
-  int      mTexLayer{-1};
+  uint32_t                                 mResolution;
+  int                                      mTexLayer{-1};
+  int                                      mUploadQueueIndex{-1};
+  std::unique_ptr<TileStagingBuffer::Slot> mStagingSlot;
 };
 
 template <typename T>
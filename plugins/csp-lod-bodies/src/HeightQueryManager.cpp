@@ -0,0 +1,203 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "HeightQueryManager.hpp"
+
+#include "HEALPix.hpp"
+#include "TileQuadTree.hpp"
+#include "utils.hpp"
+
+#include <unordered_set>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// If the tiles covering a query have not been refined for this many frames, the query is fulfilled
+// with the heights which are available at that time.
+const int MAX_STALLED_FRAMES = 300;
+
+// The LODVisitor only requests tiles whose parent has a screen-space error above its refinement
+// threshold. Hence, tiles which are only required by height queries are loaded once all tiles
+// required for rendering the current view have been loaded.
+const TileRequestPriority QUERY_PRIORITY{0.0, 0.0};
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HeightQueryManager::HeightQueryManager(TileQuadTree* tree)
+    : mTree(tree) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HeightQueryManager::~HeightQueryManager() {
+  for (auto& query : mQueries) {
+    fulfill(query);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HeightQueryManager::setMaxLevel(int maxLevel) {
+  mMaxLevel = maxLevel;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int HeightQueryManager::getMaxLevel() const {
+  return mMaxLevel;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HeightQueryManager::Handle HeightQueryManager::query(std::vector<glm::dvec2> lngLats) {
+  Query query;
+  query.mLngLats = std::move(lngLats);
+
+  scan(query);
+  query.mProgress = query.mLevelSum;
+
+  if (query.mMissingTiles.empty()) {
+    return {};
+  }
+
+  Handle handle;
+  handle.mHeights = query.mPromise.get_future();
+  handle.mToken   = std::make_shared<bool>();
+  query.mToken    = handle.mToken;
+
+  mQueries.push_back(std::move(query));
+
+  return handle;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HeightQueryManager::update(int frameCount) {
+  std::unordered_set<TileId> missingTiles;
+
+  for (auto it = mQueries.begin(); it != mQueries.end();) {
+
+    // If nobody holds the token anymore, nobody waits for the heights either.
+    if (it->mToken.expired()) {
+      it = mQueries.erase(it);
+      continue;
+    }
+
+    if (it->mRevision != mTree->getRevision()) {
+      scan(*it);
+    }
+
+    for (auto* node : it->mUsedNodes) {
+      node->setLastFrame(frameCount);
+    }
+
+    if (it->mLevelSum > it->mProgress || it->mLastProgressFrame < 0) {
+      it->mProgress          = it->mLevelSum;
+      it->mLastProgressFrame = frameCount;
+    }
+
+    if (it->mMissingTiles.empty() || frameCount - it->mLastProgressFrame > MAX_STALLED_FRAMES) {
+      fulfill(*it);
+      it = mQueries.erase(it);
+    } else {
+      missingTiles.insert(it->mMissingTiles.begin(), it->mMissingTiles.end());
+      ++it;
+    }
+  }
+
+  mLoadNodes.assign(missingTiles.begin(), missingTiles.end());
+  mLoadPriorities.assign(mLoadNodes.size(), QUERY_PRIORITY);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<TileId> const& HeightQueryManager::getLoadNodes() const {
+  return mLoadNodes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<TileRequestPriority> const& HeightQueryManager::getLoadPriorities() const {
+  return mLoadPriorities;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t HeightQueryManager::getQueryCount() const {
+  return mQueries.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HeightQueryManager::scan(Query& query) const {
+  std::unordered_set<TileNode*> usedNodes;
+  std::unordered_set<TileId>    missingTiles;
+
+  query.mLevelSum = 0;
+  query.mRevision = mTree->getRevision();
+
+  for (auto const& lngLat : query.mLngLats) {
+    int rootIndex = HEALPix::convertLngLat2Base(lngLat);
+
+    if (rootIndex < 0 || rootIndex >= TileQuadTree::sNumRoots) {
+      continue;
+    }
+
+    TileNode* node = mTree->getRoot(rootIndex);
+
+    if (node == nullptr) {
+      missingTiles.insert(TileId(0, rootIndex));
+      continue;
+    }
+
+    // Descend to the deepest loaded tile like utils::getHeight() does.
+    glm::dvec2 relative = HEALPix::convertBaseLngLat2XY(rootIndex, lngLat);
+
+    while (true) {
+      usedNodes.insert(node);
+
+      if (node->getLevel() >= mMaxLevel) {
+        break;
+      }
+
+      int childIndex = (relative.x < 0.5 ? 0 : 1) + (relative.y < 0.5 ? 0 : 2);
+
+      TileNode* child = node->getChild(childIndex);
+
+      if (child == nullptr) {
+        missingTiles.insert(HEALPix::getChildTileId(node->getTileId(), childIndex));
+        break;
+      }
+
+      relative = (relative - glm::dvec2(0.5 * (childIndex % 2), 0.5 * (childIndex / 2))) * 2.0;
+      node     = child;
+    }
+
+    query.mLevelSum += node->getLevel();
+  }
+
+  query.mUsedNodes.assign(usedNodes.begin(), usedNodes.end());
+  query.mMissingTiles.assign(missingTiles.begin(), missingTiles.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HeightQueryManager::fulfill(Query& query) const {
+  std::vector<double> heights(query.mLngLats.size());
+  utils::getHeights(mTree, HeightSamplePrecision::eActual, query.mLngLats.data(), heights.data(),
+      heights.size());
+  query.mPromise.set_value(std::move(heights));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
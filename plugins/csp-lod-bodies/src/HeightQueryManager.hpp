@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_HEIGHT_QUERY_MANAGER_HPP
+#define CSP_LOD_BODIES_HEIGHT_QUERY_MANAGER_HPP
+
+#include "TileId.hpp"
+#include "TileRequestQueue.hpp"
+
+#include <cstdint>
+#include <future>
+#include <glm/glm.hpp>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace csp::lodbodies {
+
+class TileNode;
+class TileQuadTree;
+
+/// The HeightQueryManager provides terrain heights with the highest resolution available in the
+/// tile sources without blocking the caller.
+///
+/// A query is registered for a list of positions and a std::future is returned together with a
+/// token. Once a frame, update() checks which tiles are still missing for each pending query. The
+/// owner of the HeightQueryManager passes these tiles to its TreeManager together with the tiles
+/// required for rendering; they are loaded after the tiles which are required for rendering the
+/// current view. As long as a query is pending, the tiles it covers are marked as used so that
+/// they are not removed from the tree. Once all copies of the token of a query have been
+/// destroyed, nobody waits for its heights anymore and the query is dropped.
+/// Once all positions of a query are covered by tiles of the maximum level, its future is
+/// fulfilled with the refined heights. If the tiles cannot be refined for a while, for instance
+/// because loading fails, the query is fulfilled with the best heights available at that time.
+///
+/// This class is not thread-safe; it is only used on the main thread.
+class HeightQueryManager {
+ public:
+  /// The given tree is sampled for all queries, it has to outlive this HeightQueryManager.
+  explicit HeightQueryManager(TileQuadTree* tree);
+
+  HeightQueryManager(HeightQueryManager const& other) = delete;
+  HeightQueryManager(HeightQueryManager&& other)      = delete;
+
+  HeightQueryManager& operator=(HeightQueryManager const& other) = delete;
+  HeightQueryManager& operator=(HeightQueryManager&& other)      = delete;
+
+  /// Fulfills all pending queries with the best heights which are currently available.
+  ~HeightQueryManager();
+
+  /// Queries are refined up to this level of the quadtree.
+  void setMaxLevel(int maxLevel);
+  int  getMaxLevel() const;
+
+  /// The result of query(). The query is pending as long as mToken or one of its copies exists.
+  /// Resetting it cancels the query; this should be done whenever the heights are not needed
+  /// anymore, for instance because a new query has been issued for the same purpose.
+  struct Handle {
+    std::future<std::vector<double>> mHeights;
+    std::shared_ptr<void>            mToken;
+  };
+
+  /// Registers a query for the given positions. The returned future is fulfilled with the refined
+  /// heights in one of the next calls to update(). If the tiles which are currently loaded provide
+  /// the maximum precision for all positions already, an invalid future and no token is returned.
+  Handle query(std::vector<glm::dvec2> lngLats);
+
+  /// Collects the tiles which are still missing for the pending queries, fulfills all queries
+  /// which cannot be refined any further and drops all cancelled queries. The tiles covering
+  /// pending queries are marked as used in the given frame. This has to be called once a frame
+  /// after the tree has been updated.
+  void update(int frameCount);
+
+  /// Returns the tiles which have been collected by the last call to update() and their priorities.
+  /// Like all tile requests, they have to be passed to the TreeManager each frame. The priorities
+  /// are lower than those of all tiles which are required for rendering.
+  std::vector<TileId> const&              getLoadNodes() const;
+  std::vector<TileRequestPriority> const& getLoadPriorities() const;
+
+  /// Returns the number of queries which have not been fulfilled yet.
+  std::size_t getQueryCount() const;
+
+ private:
+  struct Query {
+    std::vector<glm::dvec2>           mLngLats;
+    std::promise<std::vector<double>> mPromise;
+    std::weak_ptr<void>               mToken;
+
+    /// The sum of the levels of the deepest tiles covering each position. If this does not
+    /// increase for a while, the query is not refined any further.
+    int64_t mProgress{};
+    int     mLastProgressFrame = -1;
+
+    /// The results of the last call to scan(). They remain valid as long as the revision of the
+    /// tree does not change, so the positions are only traversed again if tiles were added or
+    /// removed.
+    uint64_t               mRevision{};
+    int64_t                mLevelSum{};
+    std::vector<TileNode*> mUsedNodes;
+    std::vector<TileId>    mMissingTiles;
+  };
+
+  /// Traverses the tree for all positions of the given query. Collects the tiles which cover the
+  /// query, the tiles which are still missing and the sum of the levels of the deepest available
+  /// tiles.
+  void scan(Query& query) const;
+
+  /// Samples the tree at all positions of the query and fulfills its promise.
+  void fulfill(Query& query) const;
+
+  TileQuadTree*                    mTree;
+  int                              mMaxLevel = 0;
+  std::list<Query>                 mQueries;
+  std::vector<TileId>              mLoadNodes;
+  std::vector<TileRequestPriority> mLoadPriorities;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_HEIGHT_QUERY_MANAGER_HPP
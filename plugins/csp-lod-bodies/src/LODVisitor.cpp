@@ -14,18 +14,58 @@
 #include "TreeManager.hpp"
 #include "logger.hpp"
 
+#include "../../../src/cs-utils/ThreadPool.hpp"
+
 #include <VistaBase/VistaStreamUtils.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <glm/gtc/matrix_inverse.hpp>
+#include <mutex>
 
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-/* explicit */
+namespace {
+
+// A tile is refined if its screen space error exceeds this value. The magic number is chosen to
+// bring the configured LoD factor into a sensible range.
+const double REFINEMENT_THRESHOLD = 10.0;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LODVisitor::NodeBatch::clear() {
+  mNodes.clear();
+  mMinX.clear();
+  mMinY.clear();
+  mMinZ.clear();
+  mMaxX.clear();
+  mMaxY.clear();
+  mMaxZ.clear();
+  mInFrustum.clear();
+  mFrontFacing.clear();
+  mCenterDirX.clear();
+  mCenterDirY.clear();
+  mCenterDirZ.clear();
+  mScreenSpaceError.clear();
+  mActions.clear();
+  mFirstChild.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 LODVisitor::LODVisitor(PlanetParameters const& params, TreeManager* treeMgr)
-    : TileVisitor(treeMgr->getTree())
+    : LODVisitor(params, treeMgr->getTree()) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LODVisitor::LODVisitor(PlanetParameters const& params, TileQuadTree* tree)
+    : TileVisitor(tree)
     , mParams(&params)
-    , mTreeMgr(treeMgr)
     , mMatVM()
     , mMatP()
     , mCameraData()
@@ -41,15 +81,49 @@ void LODVisitor::queueRecomputeTileBounds() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void LODVisitor::visit() {
+  if (mTraversalMode == TraversalMode::eRecursive) {
+    TileVisitor::visit();
+    return;
+  }
+
+  if (preTraverse()) {
+    if (mTraversalMode == TraversalMode::eParallel) {
+      traverseParallel();
+    } else {
+      for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+        traverseBatched(mTree->getRoot(i), mTreeTraversals.at(i));
+      }
+    }
+
+    // Concatenating the results of the individual trees gives the same order as visiting the trees
+    // one after another.
+    for (auto const& traversal : mTreeTraversals) {
+      mLoadNodes.insert(
+          mLoadNodes.end(), traversal.mLoadNodes.begin(), traversal.mLoadNodes.end());
+      mLoadPriorities.insert(mLoadPriorities.end(), traversal.mLoadPriorities.begin(),
+          traversal.mLoadPriorities.end());
+      mRenderNodes.insert(
+          mRenderNodes.end(), traversal.mRenderNodes.begin(), traversal.mRenderNodes.end());
+    }
+  }
+
+  postTraverse();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool LODVisitor::preTraverse() {
 
   mLoadNodes.clear();
+  mLoadPriorities.clear();
   mRenderNodes.clear();
 
-  // Make sure root nodes are loaded.
+  // Make sure root nodes are loaded. They are requested with the highest possible priority.
   for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
     if (!mTree->getRoot(i)) {
       mLoadNodes.emplace_back(0, i);
+      mLoadPriorities.emplace_back();
       return false;
     }
   }
@@ -66,7 +140,7 @@ bool LODVisitor::preTraverse() {
   // Get minimum height of all base patches (needed for radius of proxy culling sphere).
   auto minHeight(std::numeric_limits<float>::max());
   for (int i(0); i < TileQuadTree::sNumRoots; ++i) {
-    auto* tile = mTreeMgr->getTree()->getRoot(i);
+    auto* tile = mTree->getRoot(i);
     minHeight  = std::min(minHeight, tile->getMinMaxPyramid()->getMin());
   }
 
@@ -113,7 +187,9 @@ bool LODVisitor::visitNode(TileNode* node) {
   }
 
   // If no refinement is required, we can directly render the node and stop the traversal.
-  bool needRefine = node->getLevel() < mParams->mMaxLevel && testNeedRefine(node);
+  double screenSpaceError = 0.0;
+  bool   needRefine =
+      node->getLevel() < mParams->mMaxLevel && testNeedRefine(node, screenSpaceError);
   if (!needRefine) {
     mRenderNodes.push_back(node);
     return false;
@@ -125,29 +201,349 @@ bool LODVisitor::visitNode(TileNode* node) {
   }
 
   // Else we have to request loading of missing children.
+  requestChildren(node, screenSpaceError, mLoadNodes, mLoadPriorities);
+
+  // Finally draw this node until all children are loaded and stop the traversal.
+  mRenderNodes.push_back(node);
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LODVisitor::requestChildren(TileNode* node, double screenSpaceError,
+    std::vector<TileId>& loadNodes, std::vector<TileRequestPriority>& loadPriorities) const {
+
   TileId const& tileId = node->getTileId();
 
+  BoundingBox<double> const& tb = node->getBounds();
+
+  TileRequestPriority priority;
+  priority.mScreenSpaceError = screenSpaceError;
+  priority.mDistance         = glm::length(0.5 * (tb.getMin() + tb.getMax()) - mCameraData.mCamPos);
+
   for (int i = 0; i < 4; ++i) {
     if (!node->getChild(i)) {
-      mLoadNodes.push_back(HEALPix::getChildTileId(tileId, i));
+      loadNodes.push_back(HEALPix::getChildTileId(tileId, i));
+      loadPriorities.push_back(priority);
     } else {
       // Mark this child as used to avoid it being removed while waiting for its siblings to be
       // loaded.
       node->getChild(i)->setLastFrame(mFrameCount);
     }
   }
+}
 
-  // Finally draw this node until all children are loaded and stop the traversal.
-  mRenderNodes.push_back(node);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  return false;
+void LODVisitor::traverseBatched(TileNode* root, TreeTraversal& traversal) const {
+  traversal.mLoadNodes.clear();
+  traversal.mLoadPriorities.clear();
+  traversal.mRenderNodes.clear();
+
+  if (traversal.mLevels.empty()) {
+    traversal.mLevels.resize(1);
+  }
+
+  traversal.mLevels[0].clear();
+  addToBatch(traversal.mLevels[0], root);
+
+  // The first batch only contains the root node. Each following batch contains the children of all
+  // nodes of the previous batch which have to be refined.
+  for (std::size_t depth = 0; !traversal.mLevels[depth].mNodes.empty(); ++depth) {
+    if (traversal.mLevels.size() < depth + 2) {
+      traversal.mLevels.resize(depth + 2);
+    }
+
+    NodeBatch& batch = traversal.mLevels[depth];
+    NodeBatch& next  = traversal.mLevels[depth + 1];
+    int        level = root->getLevel() + static_cast<int>(depth);
+
+    next.clear();
+
+    cullBatch(batch);
+    computeScreenSpaceErrors(batch, level);
+
+    batch.mActions.resize(batch.mNodes.size());
+    batch.mFirstChild.resize(batch.mNodes.size());
+
+    for (std::size_t i = 0; i < batch.mNodes.size(); ++i) {
+      TileNode* node = batch.mNodes[i];
+
+      if (!batch.mInFrustum[i] || !batch.mFrontFacing[i]) {
+        batch.mActions[i] = NodeAction::eCull;
+      } else if (level >= mParams->mMaxLevel ||
+                 batch.mScreenSpaceError[i] <= REFINEMENT_THRESHOLD) {
+        batch.mActions[i] = NodeAction::eRender;
+      } else if (node->childrenAvailable()) {
+        batch.mActions[i]    = NodeAction::eRefine;
+        batch.mFirstChild[i] = next.mNodes.size();
+
+        for (int c = 0; c < 4; ++c) {
+          addToBatch(next, node->getChild(c));
+        }
+      } else {
+        batch.mActions[i] = NodeAction::eLoadChildren;
+      }
+    }
+  }
+
+  collectResults(traversal, 0, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LODVisitor::traverseParallel() {
+
+  // Each tree is claimed either by a worker thread or by the calling thread, whichever comes
+  // first. This way, the calling thread never has to wait for a tree which has not been started
+  // yet, even if all worker threads are busy with other tasks. The state is shared with the tasks,
+  // as tasks for trees which have been claimed by the calling thread may run after this method has
+  // returned.
+  struct State {
+    std::array<std::atomic<bool>, TileQuadTree::sNumRoots> mClaimed{};
+    std::mutex                                             mMutex;
+    std::condition_variable                                mFinishedCondition;
+    int                                                    mFinished = 0;
+  };
+
+  auto state = std::make_shared<State>();
+
+  auto traverse = [this, state](int i) {
+    if (state->mClaimed.at(i).exchange(true)) {
+      return;
+    }
+
+    traverseBatched(mTree->getRoot(i), mTreeTraversals.at(i));
+
+    std::unique_lock<std::mutex> lock(state->mMutex);
+    ++state->mFinished;
+    state->mFinishedCondition.notify_one();
+  };
+
+  for (int i = TileQuadTree::sNumRoots - 1; i > 0; --i) {
+    cs::utils::ThreadPool::get().post(
+        [traverse, i]() { traverse(i); }, cs::utils::TaskPriority::eHigh);
+  }
+
+  for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+    traverse(i);
+  }
+
+  std::unique_lock<std::mutex> lock(state->mMutex);
+  state->mFinishedCondition.wait(
+      lock, [&state]() { return state->mFinished == TileQuadTree::sNumRoots; });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LODVisitor::addToBatch(NodeBatch& batch, TileNode* node) const {
+
+  // Recompute tile bounds if required.
+  if (!node->hasBounds() || mRecomputeTileBounds) {
+    auto bounds = calcTileBounds(*node, mParams->mRadii, mParams->mHeightScale);
+    node->setBounds(bounds);
+  }
+
+  // Mark this node as used to prevent it from being removed.
+  node->setLastFrame(mFrameCount);
+
+  glm::dvec3 const& tbMin = node->getBounds().getMin();
+  glm::dvec3 const& tbMax = node->getBounds().getMax();
+
+  batch.mNodes.push_back(node);
+  batch.mMinX.push_back(tbMin.x);
+  batch.mMinY.push_back(tbMin.y);
+  batch.mMinZ.push_back(tbMin.z);
+  batch.mMaxX.push_back(tbMax.x);
+  batch.mMaxY.push_back(tbMax.y);
+  batch.mMaxZ.push_back(tbMax.z);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LODVisitor::cullBatch(NodeBatch& batch) const {
+  std::size_t const count = batch.mNodes.size();
+
+  double const* minX = batch.mMinX.data();
+  double const* minY = batch.mMinY.data();
+  double const* minZ = batch.mMinZ.data();
+  double const* maxX = batch.mMaxX.data();
+  double const* maxY = batch.mMaxY.data();
+  double const* maxZ = batch.mMaxZ.data();
+
+  batch.mInFrustum.assign(count, 1);
+  batch.mFrontFacing.assign(count, 0);
+
+  uint8_t* inFrustum   = batch.mInFrustum.data();
+  uint8_t* frontFacing = batch.mFrontFacing.data();
+
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  // See testInFrustum(). For each plane, it is sufficient to test the corner of the bounding box
+  // which lies farthest in the direction of the plane's normal: if this is outside, all other
+  // corners are outside as well. Since the dot product is computed in the same order, this gives
+  // exactly the same result as testing all eight corners.
+  for (auto const& plane : mCameraData.mFrustumMS.getPlanes()) {
+    double const d = -plane.w;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      double const dot = std::max(plane.x * minX[i], plane.x * maxX[i]) +
+                         std::max(plane.y * minY[i], plane.y * maxY[i]) +
+                         std::max(plane.z * minZ[i], plane.z * maxZ[i]);
+
+      inFrustum[i] &= static_cast<uint8_t>(dot >= d);
+    }
+  }
+
+  // See testFrontFacing(). This performs the same ray-sphere intersection test for all eight
+  // corners, but without any branches.
+  glm::dvec3 const& camPos = mCameraData.mCamPos;
+
+  double const c = glm::dot(camPos, camPos) - mHorizonCullRadius * mHorizonCullRadius;
+
+  for (int corner = 0; corner < 8; ++corner) {
+    double const* xs = (corner & 1) ? maxX : minX;
+    double const* ys = (corner & 2) ? maxY : minY;
+    double const* zs = (corner & 4) ? maxZ : minZ;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      double const rayX   = xs[i] - camPos.x;
+      double const rayY   = ys[i] - camPos.y;
+      double const rayZ   = zs[i] - camPos.z;
+      double const length = std::sqrt(rayX * rayX + rayY * rayY + rayZ * rayZ);
+      double const b =
+          camPos.x * (rayX / length) + camPos.y * (rayY / length) + camPos.z * (rayZ / length);
+      double const det     = b * b - c;
+      double const sqrtDet = std::sqrt(std::max(det, 0.0));
+
+      bool const visible = (det < 0.0) | (((-b - sqrtDet) < 0.0) & ((-b + sqrtDet) < 0.0)) |
+                           (length < -b - sqrtDet);
+
+      frontFacing[i] |= static_cast<uint8_t>(visible);
+    }
+  }
+
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool LODVisitor::testNeedRefine(TileNode* node) const {
+void LODVisitor::computeScreenSpaceErrors(NodeBatch& batch, int level) const {
+  std::size_t const count = batch.mNodes.size();
+
+  // The error is not needed for nodes which cannot be refined anyways.
+  if (level >= mParams->mMaxLevel) {
+    batch.mScreenSpaceError.assign(count, 0.0);
+    return;
+  }
+
+  // Tiles below the minimum level are always refined. Their children are loaded before all others.
+  if (mParams->mMinLevel > level) {
+    batch.mScreenSpaceError.assign(count, std::numeric_limits<double>::max());
+    return;
+  }
+
+  batch.mCenterDirX.resize(count);
+  batch.mCenterDirY.resize(count);
+  batch.mCenterDirZ.resize(count);
+
+  // As the arc cosine is monotonically decreasing, the largest angle between the center direction
+  // and the corner directions belongs to the smallest dot product. So only a single arc cosine has
+  // to be computed per node. Until then, mScreenSpaceError stores this dot product.
+  batch.mScreenSpaceError.assign(count, 1.0);
+
+  double const* minX       = batch.mMinX.data();
+  double const* minY       = batch.mMinY.data();
+  double const* minZ       = batch.mMinZ.data();
+  double const* maxX       = batch.mMaxX.data();
+  double const* maxY       = batch.mMaxY.data();
+  double const* maxZ       = batch.mMaxZ.data();
+  double*       centerDirX = batch.mCenterDirX.data();
+  double*       centerDirY = batch.mCenterDirY.data();
+  double*       centerDirZ = batch.mCenterDirZ.data();
+  double*       minDot     = batch.mScreenSpaceError.data();
+
+  glm::dvec3 const& camPos = mCameraData.mCamPos;
+
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  // See testNeedRefine(). The vectors are normalized in the same way as glm::normalize() does.
+  for (std::size_t i = 0; i < count; ++i) {
+    double const x     = 0.5 * (minX[i] + maxX[i]) - camPos.x;
+    double const y     = 0.5 * (minY[i] + maxY[i]) - camPos.y;
+    double const z     = 0.5 * (minZ[i] + maxZ[i]) - camPos.z;
+    double const scale = 1.0 / std::sqrt(x * x + y * y + z * z);
+
+    centerDirX[i] = x * scale;
+    centerDirY[i] = y * scale;
+    centerDirZ[i] = z * scale;
+  }
 
+  for (int corner = 0; corner < 8; ++corner) {
+    double const* xs = (corner & 1) ? maxX : minX;
+    double const* ys = (corner & 2) ? maxY : minY;
+    double const* zs = (corner & 4) ? maxZ : minZ;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      double const x     = xs[i] - camPos.x;
+      double const y     = ys[i] - camPos.y;
+      double const z     = zs[i] - camPos.z;
+      double const scale = 1.0 / std::sqrt(x * x + y * y + z * z);
+      double const dot =
+          (x * scale) * centerDirX[i] + (y * scale) * centerDirY[i] + (z * scale) * centerDirZ[i];
+
+      minDot[i] = std::min(minDot[i], std::min(1.0, dot));
+    }
+  }
+
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  double fov =
+      std::max(mCameraData.mFrustumES.getHorizontalFOV(), mCameraData.mFrustumES.getVerticalFOV());
+
+  for (std::size_t i = 0; i < count; ++i) {
+    batch.mScreenSpaceError[i] = std::acos(batch.mScreenSpaceError[i]) / fov * mParams->mLodFactor;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LODVisitor::collectResults(
+    TreeTraversal& traversal, std::size_t depth, std::size_t index) const {
+
+  NodeBatch const& batch = traversal.mLevels[depth];
+  TileNode*        node  = batch.mNodes[index];
+
+  switch (batch.mActions[index]) {
+  case NodeAction::eCull:
+    break;
+
+  case NodeAction::eRender:
+    traversal.mRenderNodes.push_back(node);
+    break;
+
+  case NodeAction::eRefine:
+    for (std::size_t c = 0; c < 4; ++c) {
+      collectResults(traversal, depth + 1, batch.mFirstChild[index] + c);
+    }
+    break;
+
+  case NodeAction::eLoadChildren:
+    requestChildren(node, batch.mScreenSpaceError[index], traversal.mLoadNodes,
+        traversal.mLoadPriorities);
+    traversal.mRenderNodes.push_back(node);
+    break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LODVisitor::testNeedRefine(TileNode* node, double& screenSpaceError) const {
+
+  // Tiles below the minimum level are always refined. Their children are loaded before all others.
   if (mParams->mMinLevel > node->getLevel()) {
+    screenSpaceError = std::numeric_limits<double>::max();
     return true;
   }
 
@@ -186,8 +582,9 @@ bool LODVisitor::testNeedRefine(TileNode* node) const {
 
   double ratio = maxAngle / fov * mParams->mLodFactor;
 
-  // The magic number is chosen to bring the configured LoD factor into a sensible range.
-  return ratio > 10.0;
+  screenSpaceError = ratio;
+
+  return ratio > REFINEMENT_THRESHOLD;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -222,12 +619,30 @@ bool LODVisitor::getUpdateLOD() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void LODVisitor::setTraversalMode(TraversalMode mode) {
+  mTraversalMode = mode;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LODVisitor::TraversalMode LODVisitor::getTraversalMode() const {
+  return mTraversalMode;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::vector<TileId> const& LODVisitor::getLoadNodes() const {
   return mLoadNodes;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::vector<TileRequestPriority> const& LODVisitor::getLoadPriorities() const {
+  return mLoadPriorities;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::vector<TileNode*> const& LODVisitor::getRenderNodes() const {
   return mRenderNodes;
 }
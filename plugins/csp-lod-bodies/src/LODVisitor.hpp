@@ -10,8 +10,12 @@
 
 #include "../../../../src/cs-utils/Frustum.hpp"
 #include "TileId.hpp"
+#include "TileQuadTree.hpp"
+#include "TileRequestQueue.hpp"
 #include "TileVisitor.hpp"
 
+#include <array>
+#include <cstdint>
 #include <vector>
 
 namespace csp::lodbodies {
@@ -21,10 +25,35 @@ class TreeManager;
 
 /// Specialization of TileVisitor that determines the necessary level of detail for tiles and
 /// produces lists of tiles to load and draw respectively.
+///
+/// Per default, the tiles are not visited one after another. Instead, all nodes of one level of a
+/// quadtree are tested together: their bounding boxes are stored as structure of arrays so that the
+/// frustum, horizon and refinement tests can be vectorized by the compiler. The resulting lists
+/// are exactly the same as if each node was visited individually.
 class LODVisitor : public TileVisitor {
  public:
+  /// All of these produce the same lists of tiles in the same order.
+  enum class TraversalMode {
+    /// Each node is visited individually in depth-first order.
+    eRecursive,
+
+    /// The nodes of each level of a quadtree are tested together.
+    eBatched,
+
+    /// Like eBatched, but the twelve quadtrees are traversed in parallel using the
+    /// cs::utils::ThreadPool.
+    eParallel
+  };
+
   LODVisitor(PlanetParameters const& params, TreeManager* treeMgr);
 
+  /// This can be used to traverse a tree which is not managed by a TreeManager, for instance for
+  /// testing. The tree is not owned by the LODVisitor.
+  LODVisitor(PlanetParameters const& params, TileQuadTree* tree);
+
+  /// Determines the tiles to load and draw. See TileVisitor::visit().
+  void visit() override;
+
   /// If called, node bounds will be recomputed during the next traversal. This should be called
   /// whenever the body radius or the elevation scale has been changed.
   void queueRecomputeTileBounds();
@@ -44,10 +73,18 @@ class LODVisitor : public TileVisitor {
   void setUpdateLOD(bool enable);
   bool getUpdateLOD() const;
 
+  /// Selects how the trees are traversed. The default is TraversalMode::eBatched.
+  void          setTraversalMode(TraversalMode mode);
+  TraversalMode getTraversalMode() const;
+
   /// Returns the nodes that should be loaded. The parent tiles of these have been
   /// determined to not provide sufficient resolution.
   std::vector<TileId> const& getLoadNodes() const;
 
+  /// Returns the priority of each node returned by getLoadNodes(). It is derived from the
+  /// screen-space error of the parent tile and its distance to the camera.
+  std::vector<TileRequestPriority> const& getLoadPriorities() const;
+
   /// Returns the nodes that should be rendered.
   std::vector<TileNode*> const& getRenderNodes() const;
 
@@ -60,6 +97,45 @@ class LODVisitor : public TileVisitor {
     glm::dvec3         mCamPos;
   };
 
+  /// What happens to a node during the batched traversal.
+  enum class NodeAction : uint8_t { eCull, eRender, eRefine, eLoadChildren };
+
+  /// The nodes of one level of a quadtree during the batched traversal. Apart from the nodes
+  /// themselves, everything is stored as structure of arrays.
+  struct NodeBatch {
+    void clear();
+
+    std::vector<TileNode*> mNodes;
+
+    std::vector<double> mMinX;
+    std::vector<double> mMinY;
+    std::vector<double> mMinZ;
+    std::vector<double> mMaxX;
+    std::vector<double> mMaxY;
+    std::vector<double> mMaxZ;
+
+    std::vector<uint8_t> mInFrustum;
+    std::vector<uint8_t> mFrontFacing;
+
+    // Normalized directions from the camera to the bounding box centers.
+    std::vector<double> mCenterDirX;
+    std::vector<double> mCenterDirY;
+    std::vector<double> mCenterDirZ;
+
+    std::vector<double>      mScreenSpaceError;
+    std::vector<NodeAction>  mActions;
+    std::vector<std::size_t> mFirstChild; ///< Index of the first child in the next batch.
+  };
+
+  /// The batches and results of the batched traversal of one quadtree. The trees are traversed
+  /// independently from each other, so that they can be processed in parallel.
+  struct TreeTraversal {
+    std::vector<NodeBatch>           mLevels;
+    std::vector<TileId>              mLoadNodes;
+    std::vector<TileRequestPriority> mLoadPriorities;
+    std::vector<TileNode*>           mRenderNodes;
+  };
+
   bool preTraverse() override;
   void postTraverse() override;
 
@@ -69,10 +145,39 @@ class LODVisitor : public TileVisitor {
   /// Visit the given node. Returns whether children should be visited.
   bool visitNode(TileNode* node);
 
+  /// Requests loading of all missing children of the given node. Children which are already there
+  /// are marked as used.
+  void requestChildren(TileNode* node, double screenSpaceError, std::vector<TileId>& loadNodes,
+      std::vector<TileRequestPriority>& loadPriorities) const;
+
+  /// Traverses the given quadtree level by level and stores the results in the given traversal.
+  /// This only modifies the nodes of the given tree and the given traversal, so it can be called
+  /// for several trees in parallel.
+  void traverseBatched(TileNode* root, TreeTraversal& traversal) const;
+
+  /// Calls traverseBatched() for all trees. The trees are distributed among the calling thread and
+  /// the worker threads of the cs::utils::ThreadPool.
+  void traverseParallel();
+
+  /// Computes the bounds of the given node if necessary, marks it as used and appends it to the
+  /// batch.
+  void addToBatch(NodeBatch& batch, TileNode* node) const;
+
+  /// Vectorized versions of testInFrustum(), testFrontFacing() and testNeedRefine() for all nodes
+  /// of a batch. A node is visible if both NodeBatch::mInFrustum and NodeBatch::mFrontFacing are
+  /// set. The screen space errors are stored in NodeBatch::mScreenSpaceError.
+  void cullBatch(NodeBatch& batch) const;
+  void computeScreenSpaceErrors(NodeBatch& batch, int level) const;
+
+  /// Appends the results of the given node of a batched traversal and of all its visible
+  /// descendants to the result lists of the traversal in depth-first order.
+  void collectResults(TreeTraversal& traversal, std::size_t depth, std::size_t index) const;
+
   /// Returns whether the currently visited node should be refined, i.e. if it's children should be
   /// used to achieve desired resolution. Estimates the screen space size (in pixels) of the node
-  /// and compares that with the desired LOD factor.
-  bool testNeedRefine(TileNode* node) const;
+  /// and compares that with the desired LOD factor. The estimate is also returned in
+  /// screenSpaceError, it is used to prioritize the loading of the node's children.
+  bool testNeedRefine(TileNode* node, double& screenSpaceError) const;
 
   // Returns if the tile bounds intersect the current frustum. For each plane of the frustum
   // determine if any corner of the bounding box is inside the plane's halfspace. If all corners are
@@ -88,7 +193,6 @@ class LODVisitor : public TileVisitor {
   bool testFrontFacing(TileNode* node) const;
 
   PlanetParameters const* mParams;
-  TreeManager*            mTreeMgr;
   bool                    mRecomputeTileBounds = false;
 
   glm::dmat4 mMatVM;
@@ -96,8 +200,12 @@ class LODVisitor : public TileVisitor {
   CameraData mCameraData;
   double     mHorizonCullRadius;
 
-  std::vector<TileId>    mLoadNodes;
-  std::vector<TileNode*> mRenderNodes;
+  std::vector<TileId>              mLoadNodes;
+  std::vector<TileRequestPriority> mLoadPriorities;
+  std::vector<TileNode*>           mRenderNodes;
+
+  TraversalMode                                      mTraversalMode = TraversalMode::eBatched;
+  std::array<TreeTraversal, TileQuadTree::sNumRoots> mTreeTraversals;
 
   int  mFrameCount;
   bool mUpdateLOD;
@@ -28,12 +28,14 @@ LodBody::LodBody(std::shared_ptr<cs::core::Settings> settings,
     std::shared_ptr<cs::core::GraphicsEngine>        graphicsEngine,
     std::shared_ptr<cs::core::SolarSystem>           solarSystem,
     std::shared_ptr<Plugin::Settings>                pluginSettings,
-    std::shared_ptr<cs::core::GuiManager> pGuiManager, std::shared_ptr<GLResources> glResources)
+    std::shared_ptr<cs::core::GuiManager> pGuiManager, std::shared_ptr<GLResources> glResources,
+    std::shared_ptr<ResidencyManager> residencyManager)
     : mSettings(std::move(settings))
     , mGraphicsEngine(std::move(graphicsEngine))
     , mSolarSystem(std::move(solarSystem))
     , mPluginSettings(std::move(pluginSettings))
     , mGuiManager(std::move(pGuiManager))
+    , mResidencyManager(std::move(residencyManager))
     , mEclipseShadowReceiver(
           std::make_shared<cs::core::EclipseShadowReceiver>(mSettings, mSolarSystem, false))
     , mPlanet(std::move(glResources), mPluginSettings->mTileResolutionDEM.get())
@@ -42,6 +44,8 @@ LodBody::LodBody(std::shared_ptr<cs::core::Settings> settings,
   mGraphicsEngine->registerCaster(&mPlanet);
   mPlanet.setTerrainShader(&mShader);
 
+  mResidencyManager->registerTreeManager(mPlanet.getTileRenderer().getTreeManager());
+
   // scene-wide settings -----------------------------------------------------
   mHeightScaleConnection = mSettings->mGraphics.pHeightScale.connectAndTouch(
       [this](float val) { mPlanet.setHeightScale(val); });
@@ -55,6 +59,11 @@ LodBody::LodBody(std::shared_ptr<cs::core::Settings> settings,
   mPluginSettings->mEnableTilesFreeze.connectAndTouch(
       [this](bool val) { mPlanet.getLODVisitor().setUpdateLOD(!val); });
 
+  mPluginSettings->mParallelLodTraversal.connectAndTouch([this](bool val) {
+    mPlanet.getLODVisitor().setTraversalMode(
+        val ? LODVisitor::TraversalMode::eParallel : LODVisitor::TraversalMode::eBatched);
+  });
+
   // Add to scenegraph.
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
   mGLNode.reset(pSG->NewOpenGLNode(pSG->GetRoot(), this));
@@ -65,6 +74,7 @@ LodBody::LodBody(std::shared_ptr<cs::core::Settings> settings,
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 LodBody::~LodBody() {
+  mResidencyManager->unregisterTreeManager(mPlanet.getTileRenderer().getTreeManager());
   mGraphicsEngine->unregisterCaster(&mPlanet);
   mSettings->mGraphics.pHeightScale.disconnect(mHeightScaleConnection);
 
@@ -93,6 +103,24 @@ double LodBody::getHeight(glm::dvec2 lngLat) const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void LodBody::getHeights(glm::dvec2 const* lngLats, double* heights, std::size_t count) const {
+  utils::getHeights(&mPlanet, HeightSamplePrecision::eActual, lngLats, heights, count);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+cs::scene::CelestialSurface::HeightQuery LodBody::queryHeights(std::vector<glm::dvec2> lngLats) {
+  auto handle = mPlanet.getHeightQueries().query(lngLats);
+
+  HeightQuery query;
+  query.mEstimate = getHeights(lngLats);
+  query.mRefined  = std::move(handle.mHeights);
+  query.mToken    = std::move(handle.mToken);
+  return query;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void LodBody::setDEMtileSource(std::shared_ptr<TileSource> source, uint32_t maxLevel) {
   if (!source->isSame(mDEMtileSource.get())) {
     mPlanet.setDataSource(TileDataType::eElevation, source.get());
@@ -103,6 +131,9 @@ void LodBody::setDEMtileSource(std::shared_ptr<TileSource> source, uint32_t maxL
 
   // Use the maximum level of both tile sources for our planet.
   mPlanet.setMaxLevel(std::max(mMaxLevelIMG, mMaxLevelDEM));
+
+  // Height queries do not benefit from tiles beyond the maximum level of the elevation data.
+  mPlanet.getHeightQueries().setMaxLevel(static_cast<int>(mMaxLevelDEM));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -163,6 +194,12 @@ void LodBody::setLODFactor(float lodFactor) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void LodBody::setTileBudget(TileResidency const& budget) {
+  mResidencyManager->setBudget(mPlanet.getTileRenderer().getTreeManager(), budget);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void LodBody::update() {
   auto parent  = mSolarSystem->getObject(mObjectName);
   bool visible = parent && parent->getIsBodyVisible();
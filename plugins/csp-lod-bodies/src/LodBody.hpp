@@ -13,6 +13,7 @@
 #include "../../../src/cs-scene/IntersectableObject.hpp"
 
 #include "PlanetShader.hpp"
+#include "ResidencyManager.hpp"
 #include "TileSource.hpp"
 #include "TileTextureArray.hpp"
 #include "VistaPlanet.hpp"
@@ -41,7 +42,8 @@ class LodBody : public cs::scene::CelestialSurface,
       std::shared_ptr<cs::core::GraphicsEngine> graphicsEngine,
       std::shared_ptr<cs::core::SolarSystem>    solarSystem,
       std::shared_ptr<Plugin::Settings>         pluginSettings,
-      std::shared_ptr<cs::core::GuiManager> pGuiManager, std::shared_ptr<GLResources> glResources);
+      std::shared_ptr<cs::core::GuiManager> pGuiManager, std::shared_ptr<GLResources> glResources,
+      std::shared_ptr<ResidencyManager> residencyManager);
 
   LodBody(LodBody const& other) = delete;
   LodBody(LodBody&& other)      = delete;
@@ -73,10 +75,19 @@ class LodBody : public cs::scene::CelestialSurface,
   /// higher lodFactor will reduce in smaller tiles and hence in a higher data density.
   void setLODFactor(float lodFactor);
 
+  /// Limits the resources used by the tiles of this body. See ResidencyManager for details.
+  void setTileBudget(TileResidency const& budget);
+
   bool getIntersection(
       glm::dvec3 const& rayPos, glm::dvec3 const& rayDir, glm::dvec3& pos) const override;
   double getHeight(glm::dvec2 lngLat) const override;
 
+  using cs::scene::CelestialSurface::getHeights;
+  void getHeights(glm::dvec2 const* lngLats, double* heights, std::size_t count) const override;
+
+  /// The refined heights are sampled from tiles of the maximum level of the elevation data source.
+  HeightQuery queryHeights(std::vector<glm::dvec2> lngLats) override;
+
   void update();
 
   bool Do() override;
@@ -88,6 +99,7 @@ class LodBody : public cs::scene::CelestialSurface,
   std::shared_ptr<cs::core::SolarSystem>    mSolarSystem;
   std::shared_ptr<Plugin::Settings>         mPluginSettings;
   std::shared_ptr<cs::core::GuiManager>     mGuiManager;
+  std::shared_ptr<ResidencyManager>         mResidencyManager;
 
   std::unique_ptr<VistaOpenGLNode>                 mGLNode;
   std::shared_ptr<TileSource>                      mDEMtileSource;
@@ -6,136 +6,186 @@
 // SPDX-License-Identifier: MIT
 
 #include "MinMaxPyramid.hpp"
+#include "ObjectPool.hpp"
 #include "TileData.hpp"
 
+#include <algorithm>
+
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-// DISCLAIMER: The MinMaxPyramid was ported from a version of CosmoScout VR which used a fixed    //
-// tile resolution of 257x257. There is no guarantee that it still works 100%. This should be     //
-// tested before using it agin :)                                                                 //
+
+namespace {
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-MinMaxPyramid::MinMaxPyramid(TileData<float>* tile)
-    : mTileResolution(tile->getResolution())
-    , mLevels(static_cast<uint32_t>(std::log2(mTileResolution)) - 1)
-    , mMinPyramid(mLevels)
-    , mMaxPyramid(mLevels) {
-
-  for (uint32_t i(0); i < mLevels; ++i) {
-    uint32_t resolution = mTileResolution / (1 << (i + 1));
-    mMinPyramid[i] = std::vector<float>(resolution * resolution, std::numeric_limits<float>::max());
-    mMaxPyramid[i] =
-        std::vector<float>(resolution * resolution, std::numeric_limits<float>::lowest());
+// Computes the first level of the pyramid. Each cell contains the minimum and maximum of the four
+// samples of one quad. The loops work on contiguous rows without any branches, so that they can be
+// vectorized by the compiler.
+void reduceQuads(float const* data, uint32_t resolution, float* minLevel, float* maxLevel) {
+  uint32_t size = resolution - 1;
+
+  for (uint32_t y = 0; y < size; ++y) {
+    float const* row0   = data + static_cast<std::size_t>(y) * resolution;
+    float const* row1   = row0 + resolution;
+    float*       outMin = minLevel + static_cast<std::size_t>(y) * size;
+    float*       outMax = maxLevel + static_cast<std::size_t>(y) * size;
+
+    for (uint32_t x = 0; x < size; ++x) {
+      outMin[x] = std::min(std::min(row0[x], row0[x + 1]), std::min(row1[x], row1[x + 1]));
+      outMax[x] = std::max(std::max(row0[x], row0[x + 1]), std::max(row1[x], row1[x + 1]));
+    }
   }
+}
 
-  // Construct first MinMaxPyramid layer by sampling 2x2 values
-  uint32_t halfSize = static_cast<uint32_t>((mTileResolution - 1) / 2);
-  uint32_t x2       = 0;
-  uint32_t y2       = 0;
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  for (uint32_t y = 0; y < mTileResolution; ++y) {
-    x2 = 0;
-    for (uint32_t x = 0; x < mTileResolution; ++x) {
-      float const v = tile->data()[y * mTileResolution + x];
+// Computes the next level of the pyramid. Each cell reduces 2x2 cells of the previous level. If the
+// size of the previous level is odd, the last row and column of cells only cover a single row or
+// column of the previous level.
+template <typename Reduce>
+void reduceCells(float const* src, uint32_t srcSize, float* dst, Reduce const& reduce) {
+  uint32_t dstSize = (srcSize + 1) / 2;
+  uint32_t pairs   = srcSize / 2;
+
+  for (uint32_t y = 0; y < dstSize; ++y) {
+    float const* row0 = src + static_cast<std::size_t>(2 * y) * srcSize;
+    float const* row1 = src + static_cast<std::size_t>(std::min(2 * y + 1, srcSize - 1)) * srcSize;
+    float*       out  = dst + static_cast<std::size_t>(y) * dstSize;
+
+    for (uint32_t x = 0; x < pairs; ++x) {
+      out[x] = reduce(reduce(row0[2 * x], row0[2 * x + 1]), reduce(row1[2 * x], row1[2 * x + 1]));
+    }
 
-      mMinValue = std::min(mMinValue, v);
-      mMaxValue = std::max(mMaxValue, v);
-      mAvgValue += v / (mTileResolution * mTileResolution);
+    if (pairs < dstSize) {
+      out[pairs] = reduce(row0[srcSize - 1], row1[srcSize - 1]);
+    }
+  }
+}
 
-      x2                                 = std::min(x2, halfSize - 1);
-      y2                                 = std::min(y2, halfSize - 1);
-      mMinPyramid[0][y2 * halfSize + x2] = std::min(mMinPyramid[0][y2 * halfSize + x2], v);
-      mMaxPyramid[0][y2 * halfSize + x2] = std::max(mMaxPyramid[0][y2 * halfSize + x2], v);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-      if (x % 2 == 1) {
-        x2 += 1;
-      }
-    }
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MinMaxPyramid::MinMaxPyramid(TileData<float>* tile)
+    : mTileResolution(tile->getResolution()) {
+
+  // Compute the size and the offset of each level. A tile with N samples along each axis has N-1
+  // quads along each axis.
+  uint32_t    size  = std::max(mTileResolution, 2U) - 1;
+  std::size_t total = 0;
 
-    if (y % 2 == 1) {
-      y2 += 1;
+  while (true) {
+    mLevelSizes.push_back(size);
+    mLevelOffsets.push_back(total);
+    total += static_cast<std::size_t>(size) * size;
+
+    if (size == 1) {
+      break;
     }
+
+    size = (size + 1) / 2;
   }
 
-  // Build remaining MinMaxPyramid layers
-  for (uint32_t i(1); i < mLevels; ++i) {
-    y2 = 0;
-    for (uint32_t y = 0; y < (mTileResolution - 1) * std::pow(0.5, i); ++y) {
-      x2 = 0;
-      for (uint32_t x = 0; x < (mTileResolution - 1) * std::pow(0.5, i); ++x) {
-        mMinPyramid[i][static_cast<uint64_t>(y2 * halfSize * std::pow(0.5, i) + x2)] = std::min(
-            mMinPyramid[i - 1]
-                       [static_cast<uint64_t>(y * (mTileResolution - 1) * std::pow(0.5, i) + x)],
-            mMinPyramid[i][static_cast<uint64_t>(y2 * halfSize * std::pow(0.5, i) + x2)]);
-        mMaxPyramid[i][static_cast<uint64_t>(y2 * halfSize * std::pow(0.5, i) + x2)] = std::max(
-            mMaxPyramid[i - 1]
-                       [static_cast<uint64_t>(y * (mTileResolution - 1) * std::pow(0.5, i) + x)],
-            mMaxPyramid[i][static_cast<uint64_t>(y2 * halfSize * std::pow(0.5, i) + x2)]);
-        if (x % 2 == 1) {
-          x2 += 1;
-        }
-      }
-      if (y % 2 == 1) {
-        y2 += 1;
-      }
-    }
+  mMinValues.resize(total);
+  mMaxValues.resize(total);
+
+  float const* data = tile->data().data();
+
+  if (mTileResolution >= 2) {
+    reduceQuads(data, mTileResolution, mMinValues.data(), mMaxValues.data());
+  } else {
+    mMinValues[0] = data[0];
+    mMaxValues[0] = data[0];
+  }
+
+  auto min = [](float a, float b) { return std::min(a, b); };
+  auto max = [](float a, float b) { return std::max(a, b); };
+
+  for (std::size_t i = 1; i < mLevelSizes.size(); ++i) {
+    reduceCells(mMinValues.data() + mLevelOffsets[i - 1], mLevelSizes[i - 1],
+        mMinValues.data() + mLevelOffsets[i], min);
+    reduceCells(mMaxValues.data() + mLevelOffsets[i - 1], mLevelSizes[i - 1],
+        mMaxValues.data() + mLevelOffsets[i], max);
+  }
+
+  // The last level contains the bounds of the entire tile.
+  mMinValue = mMinValues.back();
+  mMaxValue = mMaxValues.back();
+
+  double sum = 0.0;
+  for (float v : tile->data()) {
+    sum += v;
   }
+
+  mAvgValue = static_cast<float>(sum / static_cast<double>(tile->data().size()));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::vector<std::vector<float>>& MinMaxPyramid::getMinPyramid() {
-  return mMinPyramid;
+void* MinMaxPyramid::operator new(std::size_t size) {
+  return ObjectPool<MinMaxPyramid>::get().allocate(size);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::vector<std::vector<float>>& MinMaxPyramid::getMaxPyramid() {
-  return mMaxPyramid;
+void MinMaxPyramid::operator delete(void* ptr, std::size_t size) {
+  ObjectPool<MinMaxPyramid>::get().deallocate(ptr, size);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-float MinMaxPyramid::getMin(std::vector<int> const& quadrants) {
-  return getData(mMinPyramid, quadrants);
+std::size_t MinMaxPyramid::getMemorySize() const {
+  return (mMinValues.size() + mMaxValues.size()) * sizeof(float) +
+         mLevelSizes.size() * (sizeof(uint32_t) + sizeof(std::size_t));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-float MinMaxPyramid::getMax(std::vector<int> const& quadrants) {
-  return getData(mMaxPyramid, quadrants);
+float MinMaxPyramid::getMinInRange(
+    uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY) const {
+  uint32_t level  = getRangeLevel(minX, minY, maxX, maxY);
+  float    result = std::numeric_limits<float>::max();
+
+  for (uint32_t y = minY >> level; y <= maxY >> level; ++y) {
+    for (uint32_t x = minX >> level; x <= maxX >> level; ++x) {
+      result = std::min(result, getMin(level, x, y));
+    }
+  }
+
+  return result;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-float MinMaxPyramid::getData(
-    std::vector<std::vector<float>>& pyramid, std::vector<int> const& quadrants) {
-  // number of pyramid levels:
-  auto qSize = quadrants.size();
-  // particular pyramid layer,
-  // where min max information of the corresponding tile resolution is stored
-  auto layerId = 7 - qSize;
-  // pyramid layer address of searched value
-  int x(0);
-  int y(0);
-  for (size_t i(0); i < qSize; ++i) {
-    int step = int(std::pow(2, qSize - (i + 1)));
-    switch (quadrants[i]) {
-    case 1:
-      x += step;
-      break;
-    case 2:
-      y += step;
-      break;
-    case 3:
-      x += step;
-      y += step;
-      break;
+float MinMaxPyramid::getMaxInRange(
+    uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY) const {
+  uint32_t level  = getRangeLevel(minX, minY, maxX, maxY);
+  float    result = std::numeric_limits<float>::lowest();
+
+  for (uint32_t y = minY >> level; y <= maxY >> level; ++y) {
+    for (uint32_t x = minX >> level; x <= maxX >> level; ++x) {
+      result = std::max(result, getMax(level, x, y));
     }
   }
 
-  return pyramid[layerId][int(y * std::pow(2, qSize) + x)];
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t MinMaxPyramid::getRangeLevel(
+    uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY) const {
+  uint32_t level = 0;
+
+  while (level + 1 < getLevelCount() &&
+         ((maxX >> level) - (minX >> level) > 1 || (maxY >> level) - (minY >> level) > 1)) {
+    ++level;
+  }
+
+  return level;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -8,6 +8,7 @@
 #ifndef CSP_LOD_BODIES_MINMAXPYRAMID_HPP
 #define CSP_LOD_BODIES_MINMAXPYRAMID_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <vector>
@@ -17,8 +18,16 @@ namespace csp::lodbodies {
 template <typename T>
 class TileData;
 
-/// The MinMaxPyramid is a data structure for finding lod data in constant time. It's similar
-/// to a quad tree but it contains precomputed min and max values at each level.
+/// The MinMaxPyramid stores the minimum and maximum elevation of an elevation tile at multiple
+/// resolutions. Level zero contains one cell for each quad of the tile, i.e. for each group of 2x2
+/// neighbouring samples. This way, the cells bound the bilinearly interpolated height field
+/// exactly. Each following level halves the number of cells along each axis until a single cell
+/// remains. If the number of cells of a level is odd, the last cell of the next level covers only
+/// one cell of the previous level along this axis.
+///
+/// All levels are stored in one contiguous array for the minimum values and one for the maximum
+/// values, starting with level zero. Cells are stored row by row; x refers to the column and y to
+/// the row of the elevation data.
 class MinMaxPyramid {
 
  public:
@@ -32,54 +41,69 @@ class MinMaxPyramid {
 
   virtual ~MinMaxPyramid() = default;
 
-  std::vector<std::vector<float>>& getMinPyramid();
-  std::vector<std::vector<float>>& getMaxPyramid();
-
-  /// Returns the minimum value in the given quadrant.
-  ///
-  /// Requires a list of quadrant indices {[0..3], [0..3], [0..3], ...}
-  /// The number of given quadrants (q == 3 -> q0: 4x4, q1: 2x2, q2: 1x1)
-  /// determines the MinMaxPyramid level and the address for the data access.
-  /// @code
-  ///  e.g. [1, 1, 1] = 8
-  ///  e.g. [1, 1, 2] = 15
-  ///  e.g. [0, 1, 1] = 4
-  ///  e.g. [0, 1, 2] = 11
-  ///
-  ///  1   2   3  |4|  5   6   7  |8|
-  ///  9  10 |11| 12  13  14 |15| 16
-  /// 17  18  19  20  21  22  23  24
-  /// 25  26  27  28  29  30  31  32
-  /// 33  34  35  36  37  38  39  40
-  /// 41  42  43  44  45  46  47  48
-  /// 49  50  51  52  53  54  55  56
-  /// 57  58  59  60  61  62  63  64
-  /// @endcode
-  float getMin(std::vector<int> const& quadrants);
+  /// Like the TileNodes, MinMaxPyramids are allocated from an ObjectPool.
+  static void* operator new(std::size_t size);
+  static void  operator delete(void* ptr, std::size_t size);
+
+  /// Returns the number of bytes used by both pyramids.
+  std::size_t getMemorySize() const;
+
+  /// Returns the resolution of the tile this pyramid has been created for.
+  uint32_t getTileResolution() const {
+    return mTileResolution;
+  }
+
+  /// Returns the number of levels. The last level consists of a single cell.
+  uint32_t getLevelCount() const {
+    return static_cast<uint32_t>(mLevelSizes.size());
+  }
+
+  /// Returns the number of cells along each axis of the given level.
+  uint32_t getLevelSize(uint32_t level) const {
+    return mLevelSizes[level];
+  }
+
+  /// Returns the minimum value of the given cell.
+  float getMin(uint32_t level, uint32_t x, uint32_t y) const {
+    return mMinValues[mLevelOffsets[level] + y * mLevelSizes[level] + x];
+  }
+
+  /// Returns the maximum value of the given cell.
+  float getMax(uint32_t level, uint32_t x, uint32_t y) const {
+    return mMaxValues[mLevelOffsets[level] + y * mLevelSizes[level] + x];
+  }
+
+  /// Returns bounds for the values of all quads in the given inclusive range of quad indices. The
+  /// finest level on which the range is covered by at most 2x2 cells is used, hence the returned
+  /// minimum may be smaller and the returned maximum may be larger than the actual values.
+  float getMinInRange(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY) const;
+  float getMaxInRange(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY) const;
+
+  /// Returns the minimum value of the whole tile.
   float getMin() const {
     return mMinValue;
   }
 
-  /// Returns the maximum value in the given quadrant.
-  float getMax(std::vector<int> const& quadrants);
+  /// Returns the maximum value of the whole tile.
   float getMax() const {
     return mMaxValue;
   }
 
-  /// The average value of the whole pyramid.
+  /// The average value of the whole tile.
   float getAverage() const {
     return mAvgValue;
   }
 
- protected:
-  static float getData(std::vector<std::vector<float>>& pyramid, std::vector<int> const& quadrants);
-
  private:
+  /// Returns the finest level on which the given range of quads is covered by at most 2x2 cells.
+  uint32_t getRangeLevel(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY) const;
+
   uint32_t mTileResolution{};
-  uint32_t mLevels{};
 
-  std::vector<std::vector<float>> mMinPyramid;
-  std::vector<std::vector<float>> mMaxPyramid;
+  std::vector<uint32_t>    mLevelSizes;
+  std::vector<std::size_t> mLevelOffsets;
+  std::vector<float>       mMinValues;
+  std::vector<float>       mMaxValues;
 
   float mMinValue = std::numeric_limits<float>::max();
   float mMaxValue = std::numeric_limits<float>::lowest();
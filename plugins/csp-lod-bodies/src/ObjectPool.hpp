@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_OBJECTPOOL_HPP
+#define CSP_LOD_BODIES_OBJECTPOOL_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace csp::lodbodies {
+
+/// A thread-safe pool of memory for objects of type T. Memory is requested from the system in
+/// chunks which can hold CHUNK_SIZE objects each. The storage of released objects is kept in a free
+/// list and is reused by subsequent allocations; the chunks are only freed when the pool is
+/// destroyed.
+///
+/// This is meant for objects which are created and destroyed at a high rate, such as the TileNodes.
+/// A class can allocate all of its instances from the pool returned by ObjectPool<T>::get() by
+/// overloading its operator new and operator delete.
+template <typename T>
+class ObjectPool {
+ public:
+  static constexpr std::size_t CHUNK_SIZE = 256;
+
+  /// Returns the pool which is shared by all instances of T.
+  static ObjectPool& get() {
+    static ObjectPool pool;
+    return pool;
+  }
+
+  ObjectPool() = default;
+
+  ObjectPool(ObjectPool const& other) = delete;
+  ObjectPool(ObjectPool&& other)      = delete;
+
+  ObjectPool& operator=(ObjectPool const& other) = delete;
+  ObjectPool& operator=(ObjectPool&& other)      = delete;
+
+  ~ObjectPool() = default;
+
+  /// Returns uninitialized storage for an object of the given size. If the size does not match the
+  /// size of T, for instance because a derived class is allocated, the global operator new is used
+  /// instead.
+  void* allocate(std::size_t size) {
+    if (size != sizeof(T)) {
+      return ::operator new(size);
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (!mFreeList) {
+      auto chunk = std::make_unique<Slot[]>(CHUNK_SIZE); // NOLINT(modernize-avoid-c-arrays)
+
+      for (std::size_t i = 0; i < CHUNK_SIZE; ++i) {
+        chunk[i].mNext = mFreeList;
+        mFreeList      = &chunk[i];
+      }
+
+      mChunks.push_back(std::move(chunk));
+    }
+
+    Slot* slot = mFreeList;
+    mFreeList  = slot->mNext;
+    ++mUsedCount;
+
+    return slot;
+  }
+
+  /// Returns storage obtained from allocate() with the same size to the pool.
+  void deallocate(void* ptr, std::size_t size) {
+    if (!ptr) {
+      return;
+    }
+
+    if (size != sizeof(T)) {
+      ::operator delete(ptr);
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    auto* slot  = static_cast<Slot*>(ptr);
+    slot->mNext = mFreeList;
+    mFreeList   = slot;
+    --mUsedCount;
+  }
+
+  /// Returns the number of objects which currently live in the pool.
+  std::size_t getUsedCount() const {
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mUsedCount;
+  }
+
+  /// Returns the number of objects the pool can hold without requesting more memory.
+  std::size_t getCapacity() const {
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mChunks.size() * CHUNK_SIZE;
+  }
+
+ private:
+  union Slot {
+    Slot*                                       mNext;
+    alignas(T) std::array<std::byte, sizeof(T)> mStorage;
+  };
+
+  mutable std::mutex                   mMutex;
+  Slot*                                mFreeList = nullptr;
+  std::vector<std::unique_ptr<Slot[]>> mChunks; // NOLINT(modernize-avoid-c-arrays)
+  std::size_t                          mUsedCount = 0;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_OBJECTPOOL_HPP
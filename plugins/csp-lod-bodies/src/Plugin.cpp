@@ -8,6 +8,7 @@
 #include "Plugin.hpp"
 
 #include "LodBody.hpp"
+#include "ResidencyManager.hpp"
 #include "logger.hpp"
 
 #include "../../../src/cs-core/GuiManager.hpp"
@@ -17,6 +18,9 @@
 #include "../../../src/cs-utils/convert.hpp"
 #include "../../../src/cs-utils/logger.hpp"
 
+#include <VistaKernel/VistaFrameLoop.h>
+#include <VistaKernel/VistaSystem.h>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 EXPORT_FN cs::core::PluginBase* create() {
@@ -56,6 +60,8 @@ void from_json(nlohmann::json const& j, Plugin::Settings::Body& o) {
   cs::core::Settings::deserialize(j, "activeImgDataset", o.mActiveImgDataset);
   cs::core::Settings::deserialize(j, "demDatasets", o.mDemDatasets);
   cs::core::Settings::deserialize(j, "imgDatasets", o.mImgDatasets);
+  cs::core::Settings::deserialize(j, "maxTileMemory", o.mMaxTileMemory);
+  cs::core::Settings::deserialize(j, "maxGPUTiles", o.mMaxGPUTiles);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings::Body const& o) {
@@ -63,6 +69,8 @@ void to_json(nlohmann::json& j, Plugin::Settings::Body const& o) {
   cs::core::Settings::serialize(j, "activeImgDataset", o.mActiveImgDataset);
   cs::core::Settings::serialize(j, "demDatasets", o.mDemDatasets);
   cs::core::Settings::serialize(j, "imgDatasets", o.mImgDatasets);
+  cs::core::Settings::serialize(j, "maxTileMemory", o.mMaxTileMemory);
+  cs::core::Settings::serialize(j, "maxGPUTiles", o.mMaxGPUTiles);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -84,11 +92,17 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "enableBounds", o.mEnableBounds);
   cs::core::Settings::deserialize(j, "enableTilesDebug", o.mEnableTilesDebug);
   cs::core::Settings::deserialize(j, "enableTilesFreeze", o.mEnableTilesFreeze);
+  cs::core::Settings::deserialize(j, "parallelLodTraversal", o.mParallelLodTraversal);
   cs::core::Settings::deserialize(j, "maxGPUTilesColor", o.mMaxGPUTilesColor);
   cs::core::Settings::deserialize(j, "maxGPUTilesDEM", o.mMaxGPUTilesDEM);
+  cs::core::Settings::deserialize(j, "maxTileMemory", o.mMaxTileMemory);
+  cs::core::Settings::deserialize(j, "maxTileUploadTime", o.mMaxTileUploadTime);
   cs::core::Settings::deserialize(j, "tileResolutionDEM", o.mTileResolutionDEM);
   cs::core::Settings::deserialize(j, "tileResolutionIMG", o.mTileResolutionIMG);
   cs::core::Settings::deserialize(j, "mapCache", o.mMapCache);
+  cs::core::Settings::deserialize(j, "packedMapCache", o.mPackedMapCache);
+  cs::core::Settings::deserialize(j, "rawMapCache", o.mRawMapCache);
+  cs::core::Settings::deserialize(j, "compressRawMapCache", o.mCompressRawMapCache);
   cs::core::Settings::deserialize(j, "bodies", o.mBodies);
 }
 
@@ -109,11 +123,17 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "enableBounds", o.mEnableBounds);
   cs::core::Settings::serialize(j, "enableTilesDebug", o.mEnableTilesDebug);
   cs::core::Settings::serialize(j, "enableTilesFreeze", o.mEnableTilesFreeze);
+  cs::core::Settings::serialize(j, "parallelLodTraversal", o.mParallelLodTraversal);
   cs::core::Settings::serialize(j, "maxGPUTilesColor", o.mMaxGPUTilesColor);
   cs::core::Settings::serialize(j, "maxGPUTilesDEM", o.mMaxGPUTilesDEM);
+  cs::core::Settings::serialize(j, "maxTileMemory", o.mMaxTileMemory);
+  cs::core::Settings::serialize(j, "maxTileUploadTime", o.mMaxTileUploadTime);
   cs::core::Settings::serialize(j, "tileResolutionDEM", o.mTileResolutionDEM);
   cs::core::Settings::serialize(j, "tileResolutionIMG", o.mTileResolutionIMG);
   cs::core::Settings::serialize(j, "mapCache", o.mMapCache);
+  cs::core::Settings::serialize(j, "packedMapCache", o.mPackedMapCache);
+  cs::core::Settings::serialize(j, "rawMapCache", o.mRawMapCache);
+  cs::core::Settings::serialize(j, "compressRawMapCache", o.mCompressRawMapCache);
   cs::core::Settings::serialize(j, "bodies", o.mBodies);
 }
 
@@ -373,6 +393,48 @@ void Plugin::init() {
     }
   });
 
+  mPluginSettings->mPackedMapCache.connect([this](bool val) {
+    for (auto&& body : mLodBodies) {
+      auto src =
+          std::dynamic_pointer_cast<TileSourceWebMapService>(body.second->getDEMtileSource());
+      if (src) {
+        src->setPackedCache(val);
+      }
+      src = std::dynamic_pointer_cast<TileSourceWebMapService>(body.second->getIMGtileSource());
+      if (src) {
+        src->setPackedCache(val);
+      }
+    }
+  });
+
+  mPluginSettings->mRawMapCache.connect([this](bool val) {
+    for (auto&& body : mLodBodies) {
+      auto src =
+          std::dynamic_pointer_cast<TileSourceWebMapService>(body.second->getDEMtileSource());
+      if (src) {
+        src->setRawCache(val);
+      }
+      src = std::dynamic_pointer_cast<TileSourceWebMapService>(body.second->getIMGtileSource());
+      if (src) {
+        src->setRawCache(val);
+      }
+    }
+  });
+
+  mPluginSettings->mCompressRawMapCache.connect([this](bool val) {
+    for (auto&& body : mLodBodies) {
+      auto src =
+          std::dynamic_pointer_cast<TileSourceWebMapService>(body.second->getDEMtileSource());
+      if (src) {
+        src->setRawCacheCompression(val);
+      }
+      src = std::dynamic_pointer_cast<TileSourceWebMapService>(body.second->getIMGtileSource());
+      if (src) {
+        src->setRawCacheCompression(val);
+      }
+    }
+  });
+
   onLoad();
 
   logger().info("Loading done.");
@@ -455,6 +517,16 @@ void Plugin::update() {
         mPluginSettings->mAutoLOD.get() ? mAutoLod : mPluginSettings->mLODFactor.get());
     body->update();
   }
+
+  // Evict tiles if any of the budgets is exceeded. The remaining usage is reported so that the
+  // budgets can be tuned.
+  mResidencyManager->update(GetVistaSystem()->GetFrameLoop()->GetFrameCount());
+
+  auto residency = mResidencyManager->getResidency();
+  cs::utils::FrameStats::get().addValue(
+      "Resident Tile Bytes", static_cast<int64_t>(residency.mCPUBytes));
+  cs::utils::FrameStats::get().addValue(
+      "Resident GPU Tiles", static_cast<int64_t>(residency.mGPULayers));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -489,6 +561,26 @@ void Plugin::onLoad() {
       logger().warn("Changing the tile resolution at run-time is not supported. Please restart "
                     "CosmoScout VR!");
     });
+
+    mPluginSettings->mMaxTileUploadTime.connectAndTouch([this](double val) {
+      for (auto const& textureArray : mGLResources->mChannels) {
+        textureArray->setMaxUploadTime(val);
+      }
+    });
+
+    // The tiles of all bodies share the same texture arrays. Tiles are evicted before these run
+    // full.
+    mResidencyManager = std::make_shared<ResidencyManager>();
+
+    mPluginSettings->mMaxTileMemory.connectAndTouch([this](uint32_t val) {
+      auto elevationLayers = mGLResources->get(TileDataType::eElevation)->getTotalLayerCount();
+      auto colorLayers     = mGLResources->get(TileDataType::eColor)->getTotalLayerCount();
+
+      TileResidency budget;
+      budget.mCPUBytes  = static_cast<std::size_t>(val) * 1024 * 1024;
+      budget.mGPULayers = std::min(elevationLayers, colorLayers);
+      mResidencyManager->setTotalBudget(budget);
+    });
   }
 
   // First try to re-configure existing lodBodies. We assume that they are similar if they have
@@ -502,6 +594,7 @@ void Plugin::onLoad() {
 
       setImageSource(lodBody->second, settings->second.mActiveImgDataset);
       setElevationSource(lodBody->second, settings->second.mActiveDemDataset);
+      setTileBudget(lodBody->second);
 
       ++lodBody;
     } else {
@@ -525,8 +618,8 @@ void Plugin::onLoad() {
       continue;
     }
 
-    auto body = std::make_shared<LodBody>(
-        mAllSettings, mGraphicsEngine, mSolarSystem, mPluginSettings, mGuiManager, mGLResources);
+    auto body = std::make_shared<LodBody>(mAllSettings, mGraphicsEngine, mSolarSystem,
+        mPluginSettings, mGuiManager, mGLResources, mResidencyManager);
 
     body->setObjectName(settings.first);
 
@@ -537,6 +630,7 @@ void Plugin::onLoad() {
 
     setImageSource(body, settings.second.mActiveImgDataset);
     setElevationSource(body, settings.second.mActiveDemDataset);
+    setTileBudget(body);
   }
 
   mSolarSystem->pActiveObject.touch(mActiveObjectConnection);
@@ -587,6 +681,9 @@ void Plugin::setImageSource(std::shared_ptr<LodBody> const& body, std::string co
     auto source =
         std::make_shared<TileSourceWebMapService>(mPluginSettings->mTileResolutionIMG.get());
     source->setCacheDirectory(mPluginSettings->mMapCache.get());
+    source->setPackedCache(mPluginSettings->mPackedMapCache.get());
+    source->setRawCache(mPluginSettings->mRawMapCache.get());
+    source->setRawCacheCompression(mPluginSettings->mCompressRawMapCache.get());
     source->setLayers(dataset->second.mLayers);
     source->setUrl(dataset->second.mURL);
     source->setDataType(TileDataType::eColor);
@@ -617,6 +714,9 @@ void Plugin::setElevationSource(
   auto source =
       std::make_shared<TileSourceWebMapService>(mPluginSettings->mTileResolutionDEM.get());
   source->setCacheDirectory(mPluginSettings->mMapCache.get());
+  source->setPackedCache(mPluginSettings->mPackedMapCache.get());
+  source->setRawCache(mPluginSettings->mRawMapCache.get());
+  source->setRawCacheCompression(mPluginSettings->mCompressRawMapCache.get());
   source->setLayers(dataset->second.mLayers);
   source->setUrl(dataset->second.mURL);
   source->setDataType(TileDataType::eElevation);
@@ -629,4 +729,15 @@ void Plugin::setElevationSource(
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Plugin::setTileBudget(std::shared_ptr<LodBody> const& body) const {
+  auto const& settings = getBodySettings(body);
+
+  TileResidency budget;
+  budget.mCPUBytes  = static_cast<std::size_t>(settings.mMaxTileMemory.value_or(0)) * 1024 * 1024;
+  budget.mGPULayers = settings.mMaxGPUTiles.value_or(0);
+  body->setTileBudget(budget);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace csp::lodbodies
@@ -15,6 +15,7 @@
 #include "TileSourceWebMapService.hpp"
 
 #include <glm/gtc/constants.hpp>
+#include <optional>
 #include <vector>
 
 class VistaOpenGLNode;
@@ -23,6 +24,7 @@ namespace csp::lodbodies {
 
 class GLResources;
 class LodBody;
+class ResidencyManager;
 
 /// This plugin provides planets with level of detail data. It uses separate image and elevation
 /// data from either files or web map services to display the information onto the surface.
@@ -93,12 +95,26 @@ class Plugin : public cs::core::PluginBase {
     /// be updated anymore.
     cs::utils::DefaultProperty<bool> mEnableTilesFreeze{false};
 
+    /// If set to true, the twelve quadtrees of each body are traversed in parallel when determining
+    /// the tiles to load and to draw.
+    cs::utils::DefaultProperty<bool> mParallelLodTraversal{false};
+
     /// The maximum allowed colored tiles.
     cs::utils::DefaultProperty<uint32_t> mMaxGPUTilesColor{512};
 
     /// The maximum allowed elevation tiles.
     cs::utils::DefaultProperty<uint32_t> mMaxGPUTilesDEM{512};
 
+    /// The maximum amount of main memory in MiB which may be used by the tiles of all bodies
+    /// together. If this is exceeded, the tiles which have not been used for the longest time are
+    /// removed. If set to zero, there is no limit. The number of tiles on the GPU is always limited
+    /// by mMaxGPUTilesColor and mMaxGPUTilesDEM.
+    cs::utils::DefaultProperty<uint32_t> mMaxTileMemory{0};
+
+    /// The time in milliseconds which may be spent each frame for uploading tiles to the GPU. At
+    /// least one tile is uploaded per frame regardless of this value.
+    cs::utils::DefaultProperty<double> mMaxTileUploadTime{2.0};
+
     /// The vertex grid resolution used for terrain tiles.
     cs::utils::DefaultProperty<uint32_t> mTileResolutionDEM{128};
 
@@ -108,6 +124,17 @@ class Plugin : public cs::core::PluginBase {
     /// Path to the map cache folder, can be absolute or relative to the cosmoscout executable.
     cs::utils::DefaultProperty<std::string> mMapCache{"map-cache"};
 
+    /// If set to true, the tiles of each data set are stored in one pack file per level instead of
+    /// one file per tile. Existing caches can be converted with the map-cache-packer tool.
+    cs::utils::DefaultProperty<bool> mPackedMapCache{false};
+
+    /// If set to true, decoded tiles are additionally stored in the map cache, so that they do not
+    /// have to be decoded again when they are loaded the next time. This requires more disk space.
+    cs::utils::DefaultProperty<bool> mRawMapCache{false};
+
+    /// If set to true, the decoded tiles in the map cache are LZ4-compressed.
+    cs::utils::DefaultProperty<bool> mCompressRawMapCache{true};
+
     /// A single data set containing either elevation or image data.
     struct Dataset {
       std::string mURL;        ///< The URL of the mapserver including the "SERVICE=wms" parameter.
@@ -122,6 +149,12 @@ class Plugin : public cs::core::PluginBase {
       std::string mActiveImgDataset; ///< The name of the currently active image data set.
       std::map<std::string, Dataset> mDemDatasets; ///< The data sets containing elevation data.
       std::map<std::string, Dataset> mImgDatasets; ///< The data sets containing image data.
+
+      /// The maximum amount of main memory in MiB which may be used by the tiles of this body.
+      std::optional<uint32_t> mMaxTileMemory;
+
+      /// The maximum number of tiles of this body which may be stored on the GPU.
+      std::optional<uint32_t> mMaxGPUTiles;
     };
 
     std::map<std::string, Body> mBodies; ///< A list of planets with their anchor names.
@@ -139,9 +172,11 @@ class Plugin : public cs::core::PluginBase {
   Settings::Body& getBodySettings(std::shared_ptr<LodBody> const& body) const;
   void setImageSource(std::shared_ptr<LodBody> const& body, std::string const& name) const;
   void setElevationSource(std::shared_ptr<LodBody> const& body, std::string const& name) const;
+  void setTileBudget(std::shared_ptr<LodBody> const& body) const;
 
   std::shared_ptr<Settings>                       mPluginSettings = std::make_shared<Settings>();
   std::shared_ptr<GLResources>                    mGLResources;
+  std::shared_ptr<ResidencyManager>               mResidencyManager;
   std::map<std::string, std::shared_ptr<LodBody>> mLodBodies;
   float                                           mAutoLod{};
 
@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "RawTileCache.hpp"
+
+#include "TileData.hpp"
+#include "logger.hpp"
+
+#include "../../../src/cs-utils/lz4.hpp"
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const std::array<char, 4> MAGIC = {'C', 'S', 'R', 'T'};
+
+enum class Compression : uint32_t { eNone = 0, eLZ4 = 1 };
+
+// This precedes the pixel data of each tile.
+struct Header {
+  std::array<char, 4> mMagic;
+  uint32_t            mResolution;
+  uint32_t            mDataType;
+  Compression         mCompression;
+  uint64_t            mSize;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+char const* getFileExtension(TileDataType type) {
+  return type == TileDataType::eElevation ? "r32f" : "rgba8";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<BaseTileData> createTile(TileDataType type, uint32_t resolution) {
+  if (type == TileDataType::eElevation) {
+    return std::make_shared<TileData<float>>(resolution);
+  }
+
+  return std::make_shared<TileData<glm::u8vec4>>(resolution);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RawTileCache::RawTileCache(
+    std::string const& directory, TileDataType dataType, uint32_t resolution, bool compress)
+    : mPacks(TilePackCache::get(directory, getFileExtension(dataType)))
+    , mDataType(dataType)
+    , mResolution(resolution)
+    , mCompress(compress) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<BaseTileData> RawTileCache::read(int level, int x, int y) {
+  auto blob = mPacks->read(level, x, y);
+
+  if (!blob) {
+    return nullptr;
+  }
+
+  Header header{};
+  bool   valid = blob->size() >= sizeof(Header);
+
+  if (valid) {
+    std::memcpy(&header, blob->data(), sizeof(Header));
+
+    std::size_t payloadSize = blob->size() - sizeof(Header);
+
+    valid = header.mMagic == MAGIC && header.mResolution == mResolution &&
+            header.mDataType == static_cast<uint32_t>(mDataType) &&
+            header.mSize == getPayloadSize() &&
+            ((header.mCompression == Compression::eNone && payloadSize == header.mSize) ||
+                header.mCompression == Compression::eLZ4);
+  }
+
+  std::shared_ptr<BaseTileData> tile;
+
+  if (valid) {
+    tile = createTile(mDataType, mResolution);
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    char const* payload = blob->data() + sizeof(Header);
+    auto*       pixels  = static_cast<char*>(tile->getDataPtr());
+
+    if (header.mCompression == Compression::eNone) {
+      std::memcpy(pixels, payload, getPayloadSize());
+    } else {
+      valid = cs::utils::lz4::decompress(
+          payload, blob->size() - sizeof(Header), pixels, getPayloadSize());
+    }
+  }
+
+  // This may happen if the resolution of a data set has been changed or if the data has been
+  // corrupted. The tile will be decoded again and written anew.
+  if (!valid) {
+    logger().debug("Removing invalid raw tile {}/{}/{}.", level, x, y);
+    remove(level, x, y);
+    return nullptr;
+  }
+
+  return tile;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RawTileCache::write(int level, int x, int y, BaseTileData const& tile) {
+  if (tile.getDataType() != mDataType || tile.getResolution() != mResolution) {
+    throw std::invalid_argument("Tile does not match the format of the raw tile cache!");
+  }
+
+  std::size_t payloadSize = getPayloadSize();
+  auto const* pixels      = static_cast<char const*>(tile.getDataPtr());
+
+  Header header{MAGIC, mResolution, static_cast<uint32_t>(mDataType), Compression::eNone,
+      static_cast<uint64_t>(payloadSize)};
+
+  std::vector<char> entry;
+
+  if (mCompress) {
+    entry.resize(sizeof(Header) + cs::utils::lz4::compressBound(payloadSize));
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    std::size_t compressedSize = cs::utils::lz4::compress(
+        pixels, payloadSize, entry.data() + sizeof(Header), entry.size() - sizeof(Header));
+
+    // Data which does not compress well, like most elevation data, is stored uncompressed as this
+    // is faster to read.
+    if (compressedSize > 0 && compressedSize < payloadSize) {
+      header.mCompression = Compression::eLZ4;
+      entry.resize(sizeof(Header) + compressedSize);
+    }
+  }
+
+  if (header.mCompression == Compression::eNone) {
+    entry.resize(sizeof(Header) + payloadSize);
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    std::memcpy(entry.data() + sizeof(Header), pixels, payloadSize);
+  }
+
+  std::memcpy(entry.data(), &header, sizeof(Header));
+
+  mPacks->write(level, x, y, entry.data(), entry.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RawTileCache::remove(int level, int x, int y) {
+  try {
+    mPacks->remove(level, x, y);
+  } catch (std::exception const& e) {
+    logger().debug("Failed to remove raw tile: {}", e.what());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileDataType RawTileCache::getDataType() const {
+  return mDataType;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t RawTileCache::getResolution() const {
+  return mResolution;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool RawTileCache::getCompress() const {
+  return mCompress;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t RawTileCache::getPayloadSize() const {
+  std::size_t pixelSize = mDataType == TileDataType::eElevation ? sizeof(float) : 4;
+  return pixelSize * mResolution * mResolution;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_RAWTILECACHE_HPP
+#define CSP_LOD_BODIES_RAWTILECACHE_HPP
+
+#include "BaseTileData.hpp"
+#include "TilePackCache.hpp"
+
+#include <memory>
+#include <string>
+
+namespace csp::lodbodies {
+
+/// The RawTileCache stores the decoded pixels of tiles, i.e. the payload of a TileData<float> or
+/// TileData<glm::u8vec4> after the two halves of diagonal tiles have been merged and the rows have
+/// been flipped. Loading a tile from this cache is a single memcpy (or an LZ4 decompression) from a
+/// memory-mapped TilePackCache instead of a PNG or TIFF decode.
+///
+/// The tiles are identified by the same level, x and y coordinates which are used for the encoded
+/// tiles (see TileSourceWebMapService::getXY()). Each entry starts with a small header containing
+/// the resolution and data type of the tile; entries which do not match the expected format are
+/// treated like missing ones and are removed.
+///
+/// All methods are thread-safe.
+class RawTileCache {
+ public:
+  /// The packs are stored in the given directory, one per level and data type. If compress is set,
+  /// new tiles are LZ4-compressed if this makes them smaller.
+  RawTileCache(std::string const& directory, TileDataType dataType, uint32_t resolution,
+      bool compress);
+
+  /// Returns the given tile or nullptr if it is not cached.
+  std::shared_ptr<BaseTileData> read(int level, int x, int y);
+
+  /// Stores the given tile, replacing any previously stored version. Throws a std::runtime_error if
+  /// the pack cannot be written or std::invalid_argument if the tile does not match the data type
+  /// or resolution of the cache.
+  void write(int level, int x, int y, BaseTileData const& tile);
+
+  /// Removes the given tile from the cache. This does nothing if the tile is not cached.
+  void remove(int level, int x, int y);
+
+  TileDataType getDataType() const;
+  uint32_t     getResolution() const;
+  bool         getCompress() const;
+
+ private:
+  std::size_t getPayloadSize() const;
+
+  std::shared_ptr<TilePackCache> mPacks;
+  TileDataType                   mDataType;
+  uint32_t                       mResolution;
+  bool                           mCompress;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_RAWTILECACHE_HPP
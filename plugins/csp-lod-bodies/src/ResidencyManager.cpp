@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "ResidencyManager.hpp"
+
+#include "TreeManager.hpp"
+
+#include <algorithm>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileResidency& TileResidency::operator+=(TileResidency const& other) {
+  mCPUBytes += other.mCPUBytes;
+  mGPULayers += other.mGPULayers;
+  return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileResidency& TileResidency::operator-=(TileResidency const& other) {
+  mCPUBytes -= std::min(mCPUBytes, other.mCPUBytes);
+  mGPULayers -= std::min(mGPULayers, other.mGPULayers);
+  return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileResidency::exceeds(TileResidency const& budget) const {
+  return (budget.mCPUBytes > 0 && mCPUBytes > budget.mCPUBytes) ||
+         (budget.mGPULayers > 0 && mGPULayers > budget.mGPULayers);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ResidencyManager::setTotalBudget(TileResidency const& budget) {
+  mTotalBudget = budget;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileResidency const& ResidencyManager::getTotalBudget() const {
+  return mTotalBudget;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ResidencyManager::registerTreeManager(TreeManager* treeMgr, TileResidency const& budget) {
+  unregisterTreeManager(treeMgr);
+  mTreeManagers.push_back({treeMgr, budget});
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ResidencyManager::unregisterTreeManager(TreeManager* treeMgr) {
+  mTreeManagers.erase(std::remove_if(mTreeManagers.begin(), mTreeManagers.end(),
+                          [treeMgr](Entry const& entry) { return entry.mTreeMgr == treeMgr; }),
+      mTreeManagers.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ResidencyManager::setBudget(TreeManager* treeMgr, TileResidency const& budget) {
+  for (auto& entry : mTreeManagers) {
+    if (entry.mTreeMgr == treeMgr) {
+      entry.mBudget = budget;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ResidencyManager::update(int frameCount) {
+  // Tiles which have been used in the last frame are most likely required in this frame as well.
+  int unusedSince = frameCount - 1;
+
+  // First, each TreeManager has to meet its own budget.
+  for (auto const& entry : mTreeManagers) {
+    TileResidency usage = entry.mTreeMgr->getResidency();
+
+    if (usage.exceeds(entry.mBudget)) {
+      entry.mTreeMgr->getEvictionCandidates(unusedSince, mCandidates);
+      evict(usage, entry.mBudget);
+    }
+  }
+
+  // Then, the oldest tiles of all TreeManagers are evicted if the total budget is exceeded.
+  TileResidency usage = getResidency();
+
+  if (usage.exceeds(mTotalBudget)) {
+    for (auto const& entry : mTreeManagers) {
+      entry.mTreeMgr->getEvictionCandidates(unusedSince, mCandidates);
+    }
+
+    evict(usage, mTotalBudget);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileResidency ResidencyManager::getResidency() const {
+  TileResidency usage;
+
+  for (auto const& entry : mTreeManagers) {
+    usage += entry.mTreeMgr->getResidency();
+  }
+
+  return usage;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ResidencyManager::evict(TileResidency& usage, TileResidency const& budget) {
+  // Nodes are marked as used together with their parents. Hence, a node is never older than its
+  // children and the children are evicted first. Nodes which still have children when it is their
+  // turn are skipped by TreeManager::evict().
+  std::sort(mCandidates.begin(), mCandidates.end(),
+      [](EvictionCandidate const& lhs, EvictionCandidate const& rhs) {
+        if (lhs.mLastFrame == rhs.mLastFrame) {
+          return lhs.mLevel > rhs.mLevel;
+        }
+        return lhs.mLastFrame < rhs.mLastFrame;
+      });
+
+  for (auto const& candidate : mCandidates) {
+    if (!usage.exceeds(budget)) {
+      break;
+    }
+
+    usage -= candidate.mTreeMgr->evict(candidate);
+  }
+
+  mCandidates.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
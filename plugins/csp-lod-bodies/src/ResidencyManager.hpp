@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_RESIDENCYMANAGER_HPP
+#define CSP_LOD_BODIES_RESIDENCYMANAGER_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace csp::lodbodies {
+
+class TileNode;
+class TreeManager;
+
+/// The resources used by the tiles of one or more TreeManagers. This is also used to describe
+/// budgets for these resources; in this case, a value of zero means that there is no limit.
+struct TileResidency {
+  /// The memory used by the tile data and the MinMaxPyramids in bytes.
+  std::size_t mCPUBytes{};
+
+  /// The number of layers used in the TileTextureArrays. As each tile uses at most one layer in
+  /// each TileTextureArray, this is the number of tiles which have data on the GPU.
+  std::size_t mGPULayers{};
+
+  TileResidency& operator+=(TileResidency const& other);
+  TileResidency& operator-=(TileResidency const& other);
+
+  /// Returns true if this exceeds the given budget in any of the resources.
+  bool exceeds(TileResidency const& budget) const;
+};
+
+/// A node which can be removed from the tree of a TreeManager before its regular expiry. These
+/// are collected with TreeManager::getEvictionCandidates().
+struct EvictionCandidate {
+  TreeManager* mTreeMgr{};
+  TileNode*    mNode{};
+  int          mLastFrame{};
+  int          mLevel{};
+
+  /// These are used by the TreeManager to locate the node in its age buckets.
+  int         mBucket{};
+  std::size_t mIndex{};
+};
+
+/// The TreeManagers only remove tiles which have not been used for a few frames. Hence, there is
+/// no limit on the resources used by the tiles. This is especially problematic if there are
+/// several bodies: The TreeManager of a body which is not drawn anymore is not updated and keeps
+/// all of its tiles.
+///
+/// The ResidencyManager enforces budgets for each registered TreeManager and for all of them
+/// together. If a budget is exceeded, tiles are evicted in the order of their age; tiles of the
+/// same age are evicted in the order of descending level. Tiles which have been used in the last
+/// frame are never evicted, so the budgets may be exceeded temporarily.
+class ResidencyManager {
+ public:
+  ResidencyManager() = default;
+
+  ResidencyManager(ResidencyManager const& other) = delete;
+  ResidencyManager(ResidencyManager&& other)      = delete;
+
+  ResidencyManager& operator=(ResidencyManager const& other) = delete;
+  ResidencyManager& operator=(ResidencyManager&& other)      = delete;
+
+  ~ResidencyManager() = default;
+
+  /// The budget for all registered TreeManagers together.
+  void                 setTotalBudget(TileResidency const& budget);
+  TileResidency const& getTotalBudget() const;
+
+  /// Only registered TreeManagers are taken into account. The given budget applies to the given
+  /// TreeManager alone. TreeManagers have to be unregistered before they are destroyed.
+  void registerTreeManager(TreeManager* treeMgr, TileResidency const& budget = {});
+  void unregisterTreeManager(TreeManager* treeMgr);
+
+  /// Changes the budget of an already registered TreeManager.
+  void setBudget(TreeManager* treeMgr, TileResidency const& budget);
+
+  /// Evicts tiles until all budgets are met. This has to be called once per frame before the tile
+  /// trees are traversed. The given frame count has to be the one which is passed to the
+  /// TreeManagers and the LODVisitors.
+  void update(int frameCount);
+
+  /// Returns the resources currently used by all registered TreeManagers.
+  TileResidency getResidency() const;
+
+ private:
+  struct Entry {
+    TreeManager*  mTreeMgr;
+    TileResidency mBudget;
+  };
+
+  /// Evicts the nodes in mCandidates in the order of their priority until the given usage does not
+  /// exceed the given budget anymore. The usage is reduced by the resources of the evicted nodes.
+  void evict(TileResidency& usage, TileResidency const& budget);
+
+  std::vector<Entry>             mTreeManagers;
+  TileResidency                  mTotalBudget;
+  std::vector<EvictionCandidate> mCandidates;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_RESIDENCYMANAGER_HPP
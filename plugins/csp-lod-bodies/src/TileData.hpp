@@ -34,6 +34,7 @@ class TileData : public BaseTileData {
 
   void const* getDataPtr() const override;
   void*       getDataPtr() override;
+  std::size_t getDataSize() const override;
 
   std::vector<T> const& data() const;
   std::vector<T>&       data();
@@ -91,6 +92,11 @@ void* TileData<T>::getDataPtr() {
   return static_cast<void*>(mData.data());
 }
 
+template <typename T>
+std::size_t TileData<T>::getDataSize() const {
+  return mData.size() * sizeof(T);
+}
+
 template <typename T>
 std::vector<T> const& TileData<T>::data() const {
   return mData;
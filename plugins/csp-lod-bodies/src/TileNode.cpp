@@ -8,6 +8,7 @@
 #include "TileNode.hpp"
 
 #include "HEALPix.hpp"
+#include "ObjectPool.hpp"
 
 namespace csp::lodbodies {
 
@@ -25,6 +26,18 @@ TileNode::TileNode(TileId const& tileId)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void* TileNode::operator new(std::size_t size) {
+  return ObjectPool<TileNode>::get().allocate(size);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileNode::operator delete(void* ptr, std::size_t size) {
+  ObjectPool<TileNode>::get().deallocate(ptr, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::shared_ptr<BaseTileData> const& TileNode::getTileData(TileDataType type) const {
   return mTileData.get(type);
 }
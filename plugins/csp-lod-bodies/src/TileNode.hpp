@@ -27,6 +27,11 @@ class TileNode {
   TileNode& operator=(TileNode const& other) = delete;
   TileNode& operator=(TileNode&& other)      = default;
 
+  /// TileNodes are allocated from an ObjectPool, as thousands of them are created and destroyed
+  /// while navigating around a body.
+  static void* operator new(std::size_t size);
+  static void  operator delete(void* ptr, std::size_t size);
+
   /// Returns the tile data assigned to this. Can be null.
   std::shared_ptr<BaseTileData> const&              getTileData(TileDataType type) const;
   PerDataType<std::shared_ptr<BaseTileData>> const& getTileData() const;
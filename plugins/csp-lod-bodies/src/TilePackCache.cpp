@@ -0,0 +1,559 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TilePackCache.hpp"
+
+#include "../../../src/cs-utils/MappedFile.hpp"
+#include "../../../src/cs-utils/filesystem.hpp"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Both files of a pack start with one of these. The last character is the version of the format.
+std::array<char, 8> const dataFileMagic  = {'C', 'S', 'V', 'R', 'P', 'A', 'K', '1'};
+std::array<char, 8> const indexFileMagic = {'C', 'S', 'V', 'R', 'I', 'D', 'X', '1'};
+
+// Index records are buffered until this many have been collected. Then the data file is synced
+// once and all of them are written together.
+const std::size_t MAX_PENDING_RECORDS = 32;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// One record of the index file. A record with a size of zero marks the tile as removed.
+struct IndexRecord {
+  uint64_t mOffset;
+  uint64_t mSize;
+  int32_t  mX;
+  int32_t  mY;
+  uint32_t mReserved;
+  uint32_t mChecksum;
+};
+
+static_assert(sizeof(IndexRecord) == 32, "IndexRecord must not contain any padding!");
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// FNV-1a hash of all members of the record except for the checksum itself.
+uint32_t computeChecksum(IndexRecord const& record) {
+  auto const* bytes = reinterpret_cast<unsigned char const*>(&record);
+
+  uint32_t hash = 2166136261U;
+  for (std::size_t i = 0; i < offsetof(IndexRecord, mChecksum); ++i) {
+    hash = (hash ^ bytes[i]) * 16777619U; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  }
+
+  return hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t getKey(int x, int y) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32U) | static_cast<uint32_t>(y);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Makes sure that everything written to the given file so far has actually reached the disk.
+bool syncFile(std::FILE* file) {
+  if (std::fflush(file) != 0) {
+    return false;
+  }
+
+#ifdef _WIN32
+  return _commit(_fileno(file)) == 0;
+#else
+  return fsync(fileno(file)) == 0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The pack of a single level. Readers only need a shared lock on the entries and the mapping.
+// Writers are serialized by a separate mutex, so readers are not blocked while a writer waits for
+// its data to reach the disk.
+class TilePackCache::Pack {
+ public:
+  Pack(std::string dataPath, std::string indexPath);
+
+  Pack(Pack const& other) = delete;
+  Pack(Pack&& other)      = delete;
+
+  Pack& operator=(Pack const& other) = delete;
+  Pack& operator=(Pack&& other)      = delete;
+
+  ~Pack();
+
+  std::optional<Blob> read(int x, int y);
+  void                write(int x, int y, char const* data, std::size_t size);
+  void                remove(int x, int y);
+  std::size_t         getTileCount();
+
+ private:
+  struct Entry {
+    uint64_t mOffset;
+    uint64_t mSize;
+  };
+
+  void load();
+  void openForWriting();
+  void append(IndexRecord record, char const* data);
+  void commit();
+  void closeFiles();
+
+  std::string mDataPath;
+  std::string mIndexPath;
+
+  // These are only accessed while holding mWriteMutex. The files are opened on the first write, so
+  // that read-only caches do not need to be writable. mPendingRecords have not been written to the
+  // index file yet, their data has only been flushed but not synced.
+  std::mutex               mWriteMutex;
+  std::FILE*               mDataFile  = nullptr;
+  std::FILE*               mIndexFile = nullptr;
+  uint64_t                 mDataSize  = 0;
+  uint64_t                 mIndexSize = 0;
+  std::vector<IndexRecord> mPendingRecords;
+
+  // These are protected by mEntriesMutex. mCommittedSize is the size of the data file which is
+  // referenced by the index, the mapping is recreated once it becomes too small.
+  std::shared_mutex                            mEntriesMutex;
+  std::unordered_map<uint64_t, Entry>          mEntries;
+  uint64_t                                     mCommittedSize = 0;
+  std::shared_ptr<cs::utils::MappedFile const> mMapping;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TilePackCache::Pack::Pack(std::string dataPath, std::string indexPath)
+    : mDataPath(std::move(dataPath))
+    , mIndexPath(std::move(indexPath)) {
+  load();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TilePackCache::Pack::~Pack() {
+  try {
+    commit();
+  } catch (std::exception const&) {
+    // The tiles of the last batch are simply not cached.
+  }
+
+  closeFiles();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePackCache::Pack::load() {
+
+  // If one of the files is missing, the pack is created on the first write.
+  if (!boost::filesystem::exists(mDataPath) || !boost::filesystem::exists(mIndexPath)) {
+    return;
+  }
+
+  uint64_t dataFileSize = boost::filesystem::file_size(mDataPath);
+
+  // If the application crashed while a new pack was created, one of the headers may be incomplete.
+  // As the pack cannot contain any tiles in this case, it is recreated on the first write.
+  if (dataFileSize < dataFileMagic.size() ||
+      boost::filesystem::file_size(mIndexPath) < indexFileMagic.size()) {
+    return;
+  }
+
+  {
+    std::array<char, 8> magic{};
+    std::ifstream       data(mDataPath, std::ios::binary);
+    data.read(magic.data(), magic.size());
+    if (!data) {
+      throw std::runtime_error("Failed to load tile pack '" + mDataPath + "': Cannot read file!");
+    }
+
+    if (magic != dataFileMagic) {
+      throw std::runtime_error("Failed to load tile pack '" + mDataPath + "': Invalid header!");
+    }
+  }
+
+  std::vector<char> index;
+
+  {
+    std::ifstream file(mIndexPath, std::ios::binary | std::ios::ate);
+    index.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(index.data(), static_cast<std::streamsize>(index.size()));
+
+    if (!file) {
+      throw std::runtime_error("Failed to load tile pack '" + mIndexPath + "': Cannot read file!");
+    }
+
+    if (!std::equal(indexFileMagic.begin(), indexFileMagic.end(), index.begin())) {
+      throw std::runtime_error("Failed to load tile pack '" + mIndexPath + "': Invalid header!");
+    }
+  }
+
+  // As both files are only ever appended to, damage caused by a crash can only be at their ends.
+  // So we use all records up to the first invalid one.
+  uint64_t validIndexSize = indexFileMagic.size();
+  uint64_t validDataSize  = dataFileMagic.size();
+
+  while (validIndexSize + sizeof(IndexRecord) <= index.size()) {
+    IndexRecord record{};
+    std::memcpy(&record, index.data() + validIndexSize, sizeof(IndexRecord));
+
+    if (record.mChecksum != computeChecksum(record)) {
+      break;
+    }
+
+    if (record.mSize > 0) {
+      if (record.mOffset < dataFileMagic.size() || record.mOffset + record.mSize > dataFileSize) {
+        break;
+      }
+
+      mEntries[getKey(record.mX, record.mY)] = {record.mOffset, record.mSize};
+      validDataSize = std::max(validDataSize, record.mOffset + record.mSize);
+    } else {
+      mEntries.erase(getKey(record.mX, record.mY));
+    }
+
+    validIndexSize += sizeof(IndexRecord);
+  }
+
+  // Remove anything which is not referenced by a valid record, so that new data is appended
+  // directly after the last valid tile.
+  if (validIndexSize < index.size()) {
+    boost::filesystem::resize_file(mIndexPath, validIndexSize);
+  }
+
+  if (validDataSize < dataFileSize) {
+    boost::filesystem::resize_file(mDataPath, validDataSize);
+  }
+
+  mDataSize      = validDataSize;
+  mIndexSize     = validIndexSize;
+  mCommittedSize = validDataSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePackCache::Pack::openForWriting() {
+  if (mDataFile && mIndexFile) {
+    return;
+  }
+
+  // Create new files if this pack does not exist yet or if its headers are incomplete. Existing
+  // files are truncated. The data file header has to be on disk
+  // before the index file exists, else the pack would be considered invalid after a crash.
+  if (mDataSize == 0) {
+    auto directory = boost::filesystem::absolute(mDataPath).parent_path();
+    if (!boost::filesystem::exists(directory)) {
+      cs::utils::filesystem::createDirectoryRecursively(
+          directory, boost::filesystem::perms::all_all);
+    }
+
+    std::FILE* data = std::fopen(mDataPath.c_str(), "wb");
+    bool       success =
+        data && std::fwrite(dataFileMagic.data(), dataFileMagic.size(), 1, data) == 1 &&
+        syncFile(data);
+
+    if (data) {
+      std::fclose(data);
+    }
+
+    std::FILE* index = success ? std::fopen(mIndexPath.c_str(), "wb") : nullptr;
+    success          = index &&
+              std::fwrite(indexFileMagic.data(), indexFileMagic.size(), 1, index) == 1 &&
+              syncFile(index);
+
+    if (index) {
+      std::fclose(index);
+    }
+
+    if (!success) {
+      throw std::runtime_error("Failed to create tile pack '" + mDataPath + "'!");
+    }
+
+    mDataSize  = dataFileMagic.size();
+    mIndexSize = indexFileMagic.size();
+  }
+
+  mDataFile  = std::fopen(mDataPath.c_str(), "ab");
+  mIndexFile = std::fopen(mIndexPath.c_str(), "ab");
+
+  if (!mDataFile || !mIndexFile) {
+    closeFiles();
+    throw std::runtime_error("Failed to open tile pack '" + mDataPath + "' for writing!");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePackCache::Pack::append(IndexRecord record, char const* data) {
+  openForWriting();
+
+  record.mOffset   = record.mSize > 0 ? mDataSize : 0;
+  record.mChecksum = computeChecksum(record);
+
+  // Flushing is sufficient for the data to be visible through the mapping. It is synced to the disk
+  // in commit(), before the record which references it is written.
+  bool success = record.mSize == 0 || (std::fwrite(data, record.mSize, 1, mDataFile) == 1 &&
+                                          std::fflush(mDataFile) == 0);
+
+  // If anything went wrong, we remove whatever has been written partially. This has never been
+  // mapped. The files are reopened on the next write.
+  if (!success) {
+    closeFiles();
+
+    boost::system::error_code ignored;
+    boost::filesystem::resize_file(mDataPath, mDataSize, ignored);
+
+    throw std::runtime_error("Failed to write to tile pack '" + mDataPath + "'!");
+  }
+
+  mDataSize += record.mSize;
+  mPendingRecords.push_back(record);
+
+  {
+    std::unique_lock<std::shared_mutex> lock(mEntriesMutex);
+
+    if (record.mSize > 0) {
+      mEntries[getKey(record.mX, record.mY)] = {record.mOffset, record.mSize};
+      mCommittedSize                         = mDataSize;
+    } else {
+      mEntries.erase(getKey(record.mX, record.mY));
+    }
+  }
+
+  // Removals are written right away, else a removed tile could reappear after a crash.
+  if (record.mSize == 0 || mPendingRecords.size() >= MAX_PENDING_RECORDS) {
+    commit();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePackCache::Pack::commit() {
+  if (mPendingRecords.empty()) {
+    return;
+  }
+
+  // The data has to be on disk before the records which reference it are written. The index file
+  // is not synced: If a record gets lost, the tile is simply not cached.
+  bool success = syncFile(mDataFile) &&
+                 std::fwrite(mPendingRecords.data(), sizeof(IndexRecord), mPendingRecords.size(),
+                     mIndexFile) == mPendingRecords.size() &&
+                 std::fflush(mIndexFile) == 0;
+
+  uint64_t size = mPendingRecords.size() * sizeof(IndexRecord);
+  mPendingRecords.clear();
+
+  // The data file may be mapped already, so it is not truncated. Its unreferenced end is removed
+  // the next time the pack is loaded. The tiles stay available until then.
+  if (!success) {
+    closeFiles();
+
+    boost::system::error_code ignored;
+    boost::filesystem::resize_file(mIndexPath, mIndexSize, ignored);
+
+    throw std::runtime_error("Failed to write to tile pack '" + mIndexPath + "'!");
+  }
+
+  mIndexSize += size;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePackCache::Pack::closeFiles() {
+  if (mDataFile) {
+    std::fclose(mDataFile);
+    mDataFile = nullptr;
+  }
+
+  if (mIndexFile) {
+    std::fclose(mIndexFile);
+    mIndexFile = nullptr;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<TilePackCache::Blob> TilePackCache::Pack::read(int x, int y) {
+  Entry entry{};
+
+  {
+    std::shared_lock<std::shared_mutex> lock(mEntriesMutex);
+
+    auto it = mEntries.find(getKey(x, y));
+    if (it == mEntries.end()) {
+      return std::nullopt;
+    }
+
+    entry = it->second;
+
+    if (mMapping && entry.mOffset + entry.mSize <= mMapping->size()) {
+      return Blob(mMapping, mMapping->data() + entry.mOffset, entry.mSize);
+    }
+  }
+
+  // The tile has been written after the data file has been mapped. Blobs which still reference the
+  // old mapping keep it alive.
+  std::unique_lock<std::shared_mutex> lock(mEntriesMutex);
+
+  if (!mMapping || entry.mOffset + entry.mSize > mMapping->size()) {
+    mMapping = std::make_shared<cs::utils::MappedFile const>(mDataPath, mCommittedSize);
+  }
+
+  return Blob(mMapping, mMapping->data() + entry.mOffset, entry.mSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePackCache::Pack::write(int x, int y, char const* data, std::size_t size) {
+  if (size == 0) {
+    throw std::runtime_error("Failed to write to tile pack '" + mDataPath + "': Tile is empty!");
+  }
+
+  std::unique_lock<std::mutex> lock(mWriteMutex);
+  append({0, size, x, y, 0, 0}, data);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePackCache::Pack::remove(int x, int y) {
+  std::unique_lock<std::mutex> lock(mWriteMutex);
+
+  {
+    std::shared_lock<std::shared_mutex> entriesLock(mEntriesMutex);
+    if (mEntries.count(getKey(x, y)) == 0) {
+      return;
+    }
+  }
+
+  append({0, 0, x, y, 0, 0}, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TilePackCache::Pack::getTileCount() {
+  std::shared_lock<std::shared_mutex> lock(mEntriesMutex);
+  return mEntries.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TilePackCache::Blob::Blob(std::shared_ptr<void const> owner, char const* data, std::size_t size)
+    : mOwner(std::move(owner))
+    , mData(data)
+    , mSize(size) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+char const* TilePackCache::Blob::data() const {
+  return mData;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TilePackCache::Blob::size() const {
+  return mSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<TilePackCache> TilePackCache::get(
+    std::string const& directory, std::string const& extension) {
+  static std::mutex                                          mutex;
+  static std::map<std::string, std::weak_ptr<TilePackCache>> instances;
+
+  std::string key =
+      boost::filesystem::absolute(directory).lexically_normal().generic_string() + "*." + extension;
+
+  std::unique_lock<std::mutex> lock(mutex);
+
+  auto instance = instances[key].lock();
+  if (!instance) {
+    instance       = std::make_shared<TilePackCache>(directory, extension);
+    instances[key] = instance;
+  }
+
+  return instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TilePackCache::TilePackCache(std::string directory, std::string extension)
+    : mDirectory(std::move(directory))
+    , mExtension(std::move(extension)) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TilePackCache::~TilePackCache() = default;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<TilePackCache::Blob> TilePackCache::read(int level, int x, int y) {
+  return getPack(level).read(x, y);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePackCache::write(int level, int x, int y, char const* data, std::size_t size) {
+  getPack(level).write(x, y, data, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TilePackCache::remove(int level, int x, int y) {
+  getPack(level).remove(x, y);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TilePackCache::getTileCount(int level) {
+  return getPack(level).getTileCount();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TilePackCache::Pack& TilePackCache::getPack(int level) {
+  std::unique_lock<std::mutex> lock(mPacksMutex);
+
+  auto& pack = mPacks[level];
+  if (!pack) {
+    std::string prefix = mDirectory + "/" + std::to_string(level) + "." + mExtension;
+    pack               = std::make_unique<Pack>(prefix + ".pack", prefix + ".idx");
+  }
+
+  return *pack;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_TILEPACKCACHE_HPP
+#define CSP_LOD_BODIES_TILEPACKCACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace csp::lodbodies {
+
+/// The TilePackCache stores the encoded tiles (PNG or TIFF) of one data set of a
+/// TileSourceWebMapService. Instead of one file per tile, there is one pack per quadtree level. A
+/// pack consists of a data file (<level>.<extension>.pack) to which the encoded tiles are appended
+/// and an index file (<level>.<extension>.idx) to which a fixed-size record with the position of
+/// each tile in the data file is appended. The data file is memory-mapped, so reading a cached tile
+/// does not require any file system access.
+///
+/// Writes are crash-safe: Index records are written in batches. Before a batch is written, the data
+/// file is synced once, so the data of all tiles referenced by the index is on disk. If the
+/// application crashes, only the tiles of the last batch are lost. When a pack is opened, index
+/// records which are incomplete, which fail their checksum or which point beyond the end of the
+/// data file are discarded together with any data following the last valid tile. Packs whose
+/// headers are incomplete are considered to be empty and are recreated on the first write.
+/// Existing data is never modified; if a tile is written again or removed, a new index record is
+/// appended which supersedes the previous one.
+///
+/// All methods are thread-safe. However, a pack must not be written by multiple processes at the
+/// same time. The files are written in the byte order of the host.
+class TilePackCache {
+ public:
+  /// The encoded data of a single tile. It keeps the memory it points to alive, so it stays valid
+  /// even if the pack is remapped or closed in the meantime.
+  class Blob {
+   public:
+    Blob(std::shared_ptr<void const> owner, char const* data, std::size_t size);
+
+    char const* data() const;
+    std::size_t size() const;
+
+   private:
+    std::shared_ptr<void const> mOwner;
+    char const*                 mData;
+    std::size_t                 mSize;
+  };
+
+  /// Returns the cache for the given directory and file extension. The instances are shared, so
+  /// all callers using the same directory and extension get the same TilePackCache. The directory
+  /// is created once the first tile is written.
+  static std::shared_ptr<TilePackCache> get(
+      std::string const& directory, std::string const& extension);
+
+  TilePackCache(std::string directory, std::string extension);
+
+  TilePackCache(TilePackCache const& other) = delete;
+  TilePackCache(TilePackCache&& other)      = delete;
+
+  TilePackCache& operator=(TilePackCache const& other) = delete;
+  TilePackCache& operator=(TilePackCache&& other)      = delete;
+
+  ~TilePackCache();
+
+  /// Returns the data of the given tile or std::nullopt if it is not cached.
+  std::optional<Blob> read(int level, int x, int y);
+
+  /// Appends the data of the given tile to the pack of the given level. If the tile has been
+  /// stored before, the new data replaces the old one. Throws a std::runtime_error if the pack
+  /// cannot be written.
+  void write(int level, int x, int y, char const* data, std::size_t size);
+
+  /// Removes the given tile from the cache. This does nothing if the tile is not cached. Throws a
+  /// std::runtime_error if the pack cannot be written.
+  void remove(int level, int x, int y);
+
+  /// Returns the number of tiles stored for the given level.
+  std::size_t getTileCount(int level);
+
+ private:
+  class Pack;
+
+  Pack& getPack(int level);
+
+  std::string                          mDirectory;
+  std::string                          mExtension;
+  std::mutex                           mPacksMutex;
+  std::map<int, std::unique_ptr<Pack>> mPacks;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILEPACKCACHE_HPP
@@ -21,6 +21,19 @@ TileNode* TileQuadTree::getRoot(int idx) const {
 
 void TileQuadTree::setRoot(int idx, TileNode* root) {
   mRoots.at(idx).reset(root);
+  ++mRevision;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TileQuadTree::getRevision() const {
+  return mRevision;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileQuadTree::incrementRevision() {
+  ++mRevision;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -45,6 +58,7 @@ bool insertNode(TileQuadTree* tree, TileNode* node) {
       assert(parent->getChild(HEALPix::getChildIdxAtLevel(tileId, tileId.level())) == nullptr);
 
       parent->setChild(HEALPix::getChildIdxAtLevel(tileId, tileId.level()), node);
+      tree->incrementRevision();
     } else {
       result = false;
     }
@@ -66,6 +80,7 @@ bool removeNode(TileQuadTree* tree, TileNode* node) {
     assert(parent->getChild(childIdx) == node);
 
     parent->setChild(childIdx, nullptr);
+    tree->incrementRevision();
     result = true;
   } else {
     int childIdx = HEALPix::getChildIdx(node->getTileId());
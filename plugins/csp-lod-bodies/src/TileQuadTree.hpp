@@ -10,6 +10,8 @@
 
 #include "TileNode.hpp"
 
+#include <cstdint>
+
 namespace csp::lodbodies {
 
 /// Stores root nodes of 12 quad trees (i.e. it follows the HEALPix scheme).
@@ -28,8 +30,16 @@ class TileQuadTree {
   /// this.
   void setRoot(int idx, TileNode* root);
 
+  /// Returns a counter which is incremented whenever nodes are added to or removed from the tree.
+  /// As long as it does not change, pointers to the nodes of the tree remain valid.
+  uint64_t getRevision() const;
+
+  /// This is called by insertNode() and removeNode().
+  void incrementRevision();
+
  private:
   std::array<std::unique_ptr<TileNode>, 12> mRoots;
+  uint64_t                                  mRevision = 0;
 };
 
 /// Inserts node into tree and returns true if it succeeded, false otherwise. Insertion can fail if
@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TileRequestQueue.hpp"
+
+#include <algorithm>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileRequestPriority::operator<(TileRequestPriority const& other) const {
+  if (mScreenSpaceError == other.mScreenSpaceError) {
+    return mDistance > other.mDistance;
+  }
+
+  return mScreenSpaceError < other.mScreenSpaceError;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileRequestQueue::push(TileId const& tileId, TileRequestPriority const& priority, int frame) {
+  mRequests[tileId] = {priority, frame};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<TileId> TileRequestQueue::pop(std::size_t count) {
+  count = std::min(count, mRequests.size());
+
+  if (count == 0) {
+    return {};
+  }
+
+  // Only the most important requests need to be sorted.
+  std::vector<std::pair<TileRequestPriority, TileId>> requests;
+  requests.reserve(mRequests.size());
+
+  for (auto const& [tileId, request] : mRequests) {
+    requests.emplace_back(request.mPriority, tileId);
+  }
+
+  std::partial_sort(requests.begin(), requests.begin() + static_cast<std::ptrdiff_t>(count),
+      requests.end(), [](auto const& lhs, auto const& rhs) { return rhs.first < lhs.first; });
+
+  std::vector<TileId> result;
+  result.reserve(count);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    result.push_back(requests[i].second);
+    mRequests.erase(requests[i].second);
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TileRequestQueue::removeStale(int oldestValidFrame) {
+  std::size_t removed = 0;
+
+  for (auto it = mRequests.begin(); it != mRequests.end();) {
+    if (it->second.mFrame < oldestValidFrame) {
+      it = mRequests.erase(it);
+      ++removed;
+    } else {
+      ++it;
+    }
+  }
+
+  return removed;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileRequestQueue::clear() {
+  mRequests.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TileRequestQueue::size() const {
+  return mRequests.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
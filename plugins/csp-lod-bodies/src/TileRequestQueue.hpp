@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_TILEREQUESTQUEUE_HPP
+#define CSP_LOD_BODIES_TILEREQUESTQUEUE_HPP
+
+#include "TileId.hpp"
+
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace csp::lodbodies {
+
+/// The importance of a tile request. It is computed by the LODVisitor for the parent of the
+/// requested tile. Requests with a larger screen-space error are more important; if two requests
+/// have the same screen-space error (e.g. siblings or tiles which are forced to be refined because
+/// of the configured minimum level), the one closer to the camera is more important.
+struct TileRequestPriority {
+  double mScreenSpaceError = std::numeric_limits<double>::max();
+  double mDistance         = 0.0;
+
+  /// Returns true if this is less important than other.
+  bool operator<(TileRequestPriority const& other) const;
+};
+
+/// The TileRequestQueue stores the tile requests of a TreeManager which have not yet been passed to
+/// a TileSource. Requests are renewed every frame with an updated priority. Requests which have not
+/// been renewed for a couple of frames are considered stale and are removed. This class is not
+/// thread-safe; it is only used on the main thread.
+class TileRequestQueue {
+ public:
+  /// Adds a request for the given tile. If the tile has been requested before, its priority and the
+  /// frame of the last request are updated.
+  void push(TileId const& tileId, TileRequestPriority const& priority, int frame);
+
+  /// Removes and returns up to count of the most important requests.
+  std::vector<TileId> pop(std::size_t count);
+
+  /// Removes all requests which have not been renewed since the given frame. Returns the number of
+  /// removed requests.
+  std::size_t removeStale(int oldestValidFrame);
+
+  /// Removes all requests.
+  void clear();
+
+  /// Returns the number of queued requests.
+  std::size_t size() const;
+
+ private:
+  struct Request {
+    TileRequestPriority mPriority;
+    int                 mFrame;
+  };
+
+  std::unordered_map<TileId, Request> mRequests;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILEREQUESTQUEUE_HPP
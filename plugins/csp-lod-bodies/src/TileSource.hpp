@@ -8,6 +8,7 @@
 #ifndef CSP_LOD_BODIES_TILESOURCE_HPP
 #define CSP_LOD_BODIES_TILESOURCE_HPP
 
+#include "../../../src/cs-utils/ThreadPool.hpp"
 #include "TileDataType.hpp"
 #include "TileId.hpp"
 
@@ -50,8 +51,10 @@ class TileSource {
   virtual std::shared_ptr<BaseTileData> loadTile(TileId const& tileId) = 0;
 
   /// Loads a node with given tileId asynchronously (i.e. the call returns immediately).
-  /// Once the node is loaded the given OnLoadCallack is invoked.
-  virtual void loadTileAsync(TileId const& tileId, OnLoadCallback cb) = 0;
+  /// Once the node is loaded the given OnLoadCallack is invoked. The returned handle can be used to
+  /// cancel the request as long as loading has not started. The callback is not invoked for
+  /// cancelled requests.
+  virtual cs::utils::TaskHandle loadTileAsync(TileId const& tileId, OnLoadCallback cb) = 0;
 
   /// Returns the number of currently active async requests.
   virtual int getPendingRequests() = 0;
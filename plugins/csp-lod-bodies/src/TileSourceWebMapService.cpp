@@ -11,15 +11,13 @@
 #include "TileNode.hpp"
 #include "logger.hpp"
 
+#include "../../../src/cs-utils/HttpFetcher.hpp"
 #include "../../../src/cs-utils/filesystem.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <boost/filesystem.hpp>
-#include <curlpp/Easy.hpp>
-#include <curlpp/Info.hpp>
-#include <curlpp/Infos.hpp>
-#include <curlpp/Options.hpp>
-#include <curlpp/cURLpp.hpp>
 #include <fstream>
 #include <sstream>
 
@@ -41,15 +39,77 @@ enum class CopyPixels { eAll, eAboveDiagonal, eBelowDiagonal };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+char const* getFileExtension(TileDataType type) {
+  return type == TileDataType::eElevation ? "tiff" : "png";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Elevation tiles are decoded by libtiff directly from the cached data in memory. These are the
+// callbacks required for this.
+struct TiffMemoryStream {
+  char const* mData;
+  toff_t      mSize;
+  toff_t      mPosition;
+};
+
+tsize_t tiffRead(thandle_t handle, tdata_t buffer, tsize_t size) {
+  auto* stream = static_cast<TiffMemoryStream*>(handle);
+  auto  count  = std::min(static_cast<toff_t>(size), stream->mSize - stream->mPosition);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  std::memcpy(buffer, stream->mData + stream->mPosition, count);
+  stream->mPosition += count;
+
+  return static_cast<tsize_t>(count);
+}
+
+tsize_t tiffWrite(thandle_t /*handle*/, tdata_t /*buffer*/, tsize_t /*size*/) {
+  return 0;
+}
+
+toff_t tiffSeek(thandle_t handle, toff_t offset, int whence) {
+  auto* stream = static_cast<TiffMemoryStream*>(handle);
+
+  if (whence == SEEK_CUR) {
+    offset += stream->mPosition;
+  } else if (whence == SEEK_END) {
+    offset += stream->mSize;
+  }
+
+  stream->mPosition = std::min(offset, stream->mSize);
+  return stream->mPosition;
+}
+
+int tiffClose(thandle_t /*handle*/) {
+  return 0;
+}
+
+toff_t tiffSize(thandle_t handle) {
+  return static_cast<TiffMemoryStream*>(handle)->mSize;
+}
+
+int tiffMap(thandle_t handle, tdata_t* base, toff_t* size) {
+  auto* stream = static_cast<TiffMemoryStream*>(handle);
+  *base        = const_cast<char*>(stream->mData); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+  *size        = stream->mSize;
+  return 1;
+}
+
+void tiffUnmap(thandle_t /*handle*/, tdata_t /*base*/, toff_t /*size*/) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 template <typename T>
 bool loadImpl(TileSourceWebMapService* source, BaseTileData* tile, TileId const& tileId, int x,
     int y, CopyPixels which) {
-  std::optional<std::string> cacheFile;
+  std::optional<TilePackCache::Blob> cachedData;
 
-  // First we download the tile data to a local cache file. This will return quickly if the file is
+  // First we download the tile data to the local cache. This will return quickly if the tile is
   // already downloaded but will take some time if it needs to be fetched from the server.
   try {
-    cacheFile = source->loadData(tileId, x, y);
+    cachedData = source->loadData(tileId, x, y);
   } catch (std::exception const& e) {
     // This is not critical, the planet will just not refine any further.
     logger().debug("Tile loading failed: {}", e.what());
@@ -57,22 +117,26 @@ bool loadImpl(TileSourceWebMapService* source, BaseTileData* tile, TileId const&
   }
 
   // Data is not available. That's most likely due to our server being offline.
-  if (!cacheFile) {
+  if (!cachedData) {
     return false;
   }
 
   T* tileData = tile->getTypedPtr<T>();
 
-  // Now the cache file is available, try to load it with libtiff if it's elevation data.
+  // Now the data is available, try to decode it with libtiff if it's elevation data.
   if (tile->getDataType() == TileDataType::eElevation) {
     TIFFSetWarningHandler(nullptr);
-    auto* data = TIFFOpen(cacheFile->c_str(), "r");
+
+    TiffMemoryStream stream{cachedData->data(), cachedData->size(), 0};
+    auto*            data = TIFFClientOpen("tile", "r", &stream, tiffRead, tiffWrite, tiffSeek,
+        tiffClose, tiffSize, tiffMap, tiffUnmap);
     if (!data) {
 
-      // This is also not critical. Something went wrong - we will just remove the cache file and
-      // will try to download it later again if it's requested once more.
-      logger().debug("Tile loading failed: Removing invalid cache file '{}'.", *cacheFile);
-      boost::filesystem::remove(*cacheFile);
+      // This is also not critical. Something went wrong - we will just remove the tile from the
+      // cache and will try to download it later again if it's requested once more.
+      logger().debug("Tile loading failed: Removing invalid cached tile {}/{}/{}.", tileId.level(),
+          x, y);
+      source->removeData(tileId, x, y);
       return false;
     }
 
@@ -83,8 +147,10 @@ bool loadImpl(TileSourceWebMapService* source, BaseTileData* tile, TileId const&
     // the diagonal).
     int imagelength{};
     if (TIFFGetField(data, TIFFTAG_IMAGELENGTH, &imagelength) == 0) {
-      logger().debug("TIFFGetField failed: Removing invalid cache file '{}'.", *cacheFile);
-      boost::filesystem::remove(*cacheFile);
+      logger().debug(
+          "TIFFGetField failed: Removing invalid cached tile {}/{}/{}.", tileId.level(), x, y);
+      TIFFClose(data);
+      source->removeData(tileId, x, y);
       return false;
     }
     int tiffReturn{};
@@ -109,30 +175,34 @@ bool loadImpl(TileSourceWebMapService* source, BaseTileData* tile, TileId const&
         std::memcpy(tileData + offset, tmp.data() + resolution - y, count * sizeof(float));
       }
     }
+
+    TIFFClose(data);
+
     if (tiffReturn == -1) {
-      logger().debug("TIFFReadScanline failed: Removing invalid cache file '{}'.", *cacheFile);
-      boost::filesystem::remove(*cacheFile);
+      logger().debug(
+          "TIFFReadScanline failed: Removing invalid cached tile {}/{}/{}.", tileId.level(), x, y);
+      source->removeData(tileId, x, y);
       return false;
     }
-
-    TIFFClose(data);
   } else {
 
-    // Image tiles are loaded with stbi.
+    // Image tiles are decoded with stbi.
     int width{};
     int height{};
     int bpp{};
     int channels = 4;
 
-    auto* data =
-        reinterpret_cast<T*>(stbi_load(cacheFile->c_str(), &width, &height, &bpp, channels));
+    auto* data = reinterpret_cast<T*>(
+        stbi_load_from_memory(reinterpret_cast<stbi_uc const*>(cachedData->data()),
+            static_cast<int>(cachedData->size()), &width, &height, &bpp, channels));
 
     if (!data) {
 
-      // This is also not critical. Something went wrong - we will just remove the cache file and
-      // will try to download it later again if it's requested once more.
-      logger().debug("Tile loading failed: Removing invalid cache file '{}'.", *cacheFile);
-      boost::filesystem::remove(*cacheFile);
+      // This is also not critical. Something went wrong - we will just remove the tile from the
+      // cache and will try to download it later again if it's requested once more.
+      logger().debug("Tile loading failed: Removing invalid cached tile {}/{}/{}.", tileId.level(),
+          x, y);
+      source->removeData(tileId, x, y);
       return false;
     }
 
@@ -146,13 +216,11 @@ bool loadImpl(TileSourceWebMapService* source, BaseTileData* tile, TileId const&
       }
     }
     if (isCompletelyWhiteTile) {
-      logger().debug(
-          "Failed to parse tile data: File '{}' is completely white and most likely corrupt.",
-          *cacheFile);
-      source->markTileDataAsInvalid(*cacheFile);
-      if (boost::filesystem::remove(*cacheFile) == 0) {
-        logger().debug("Failed to remove tile data: File '{}'", *cacheFile);
-      }
+      logger().debug("Failed to parse tile data: Tile {}/{}/{} is completely white and most likely "
+                     "corrupt.",
+          tileId.level(), x, y);
+      stbi_image_free(data);
+      source->removeData(tileId, x, y, true);
       return false;
     }
 
@@ -251,22 +319,46 @@ std::mutex TileSourceWebMapService::mFileSystemMutex;
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 TileSourceWebMapService::TileSourceWebMapService(uint32_t resolution)
-    : mThreadPool(32)
-    , mResolution(resolution) {
+    : mResolution(resolution) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /* virtual */ std::shared_ptr<BaseTileData> TileSourceWebMapService::loadTile(
     TileId const& tileId) {
+  int x{};
+  int y{};
+  getXY(tileId, x, y);
+
+  // If the tile has been decoded before, there is nothing more to do.
+  auto rawCache = getRawTileCache();
+  if (rawCache) {
+    auto tile = rawCache->read(tileId.level(), x, y);
+    if (tile) {
+      return tile;
+    }
+  }
+
+  std::shared_ptr<BaseTileData> tile;
+
   if (mFormat == TileDataType::eElevation) {
-    return loadImpl<float>(this, tileId);
+    tile = loadImpl<float>(this, tileId);
+  } else if (mFormat == TileDataType::eColor) {
+    tile = loadImpl<glm::u8vec4>(this, tileId);
+  } else {
+    throw std::domain_error(fmt::format("Unsupported format: {}!", static_cast<int>(mFormat)));
   }
-  if (mFormat == TileDataType::eColor) {
-    return loadImpl<glm::u8vec4>(this, tileId);
+
+  if (tile && rawCache) {
+    try {
+      rawCache->write(tileId.level(), x, y, *tile);
+    } catch (std::exception const& e) {
+      // This is not critical, the tile will just be decoded again next time.
+      logger().debug("Failed to store raw tile: {}", e.what());
+    }
   }
 
-  throw std::domain_error(fmt::format("Unsupported format: {}!", static_cast<int>(mFormat)));
+  return tile;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -298,25 +390,80 @@ bool TileSourceWebMapService::getXY(TileId const& tileId, int& x, int& y) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::optional<std::string> TileSourceWebMapService::loadData(TileId const& tileId, int x, int y) {
+std::optional<TilePackCache::Blob> TileSourceWebMapService::loadData(
+    TileId const& tileId, int x, int y) {
+
+  // The tile is already cached, we can return it.
+  auto cachedData = readCachedData(tileId, x, y);
+  if (cachedData) {
+    return cachedData;
+  }
+
+  // The tile is not available but the server is marked as 'offline'. In this case we can do nothing
+  // but return std::nullopt.
+  if (mUrl == "offline") {
+    return std::nullopt;
+  }
+
+  auto response = cs::utils::HttpFetcher::get().fetch(createRequest(tileId, x, y)).get();
+  return storeData(tileId, x, y, response);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<TilePackCache::Blob> TileSourceWebMapService::readCachedData(
+    TileId const& tileId, int x, int y) {
+  std::string cacheFile = getCacheFile(tileId.level(), x, y);
+  auto        packCache = getPackCache();
 
+  if (packCache) {
+    auto cachedData = packCache->read(tileId.level(), x, y);
+    if (cachedData) {
+      return cachedData;
+    }
+  } else {
+    std::ifstream in(cacheFile, std::ifstream::in | std::ifstream::binary);
+    if (in) {
+      auto data = std::make_shared<std::string>(
+          (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+      // An empty file is obviously corrupt. It will be overwritten once the tile is downloaded.
+      if (!data->empty()) {
+        return TilePackCache::Blob(data, data->data(), data->size());
+      }
+    }
+  }
+
+  return std::nullopt;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileSourceWebMapService::isCached(TileId const& tileId, int x, int y) {
+  auto packCache = getPackCache();
+
+  if (packCache) {
+    return packCache->read(tileId.level(), x, y).has_value();
+  }
+
+  // Empty files are obviously corrupt and will be overwritten.
+  boost::system::error_code error;
+  auto size = boost::filesystem::file_size(getCacheFile(tileId.level(), x, y), error);
+  return !error && size > 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+cs::utils::HttpRequest TileSourceWebMapService::createRequest(
+    TileId const& tileId, int x, int y) {
   std::string format;
-  std::string type;
 
   if (mFormat == TileDataType::eElevation) {
     format = "tiffGray";
-    type   = "tiff";
   } else {
     format = "pngRGB";
-    type   = "png";
   }
 
-  // We encode the layers and the tile resolution in the cache file path.
-  std::stringstream cacheDir;
-  cacheDir << mCache << "/" << mLayers << "x" << mResolution << "/" << tileId.level() << "/" << x;
-
-  std::stringstream cacheFile(cacheDir.str());
-  cacheFile << cacheDir.str() << "/" << y << "." << type;
   std::stringstream url;
 
   double size = 1.0 / (1 << tileId.level());
@@ -367,109 +514,207 @@ std::optional<std::string> TileSourceWebMapService::loadData(TileId const& tileI
       << "&width=" << mResolution << "&height=" << mResolution
       << "&srs=EPSG:900914&format=" << format;
 
-  auto cacheFilePath(boost::filesystem::path(cacheFile.str()));
+  cs::utils::HttpRequest request;
+  request.mUrl        = url.str();
+  request.mMaxRetries = 2;
+
+  // If we received invalid data for this tile recently, we wait a bit before asking again. The
+  // request is simply delayed by the HttpFetcher, so no thread is blocked in the meantime.
+  std::string cacheFile = getCacheFile(tileId.level(), x, y);
+  request.mDelay        = getRemainingCooldown(cacheFile);
 
-  // The file is already there, we can return it.
-  if (boost::filesystem::exists(cacheFilePath) &&
-      boost::filesystem::file_size(cacheFile.str()) > 0) {
-    return cacheFile.str();
+  if (request.mDelay.count() > 0) {
+    logger().warn("Failed to download tile data: Waiting for '{}' to cool down", cacheFile);
   }
 
-  // The file is not available but the server is marked as 'offline'. In this case we can do nothing
-  // but return std::nullopt.
-  if (mUrl == "offline") {
-    return std::nullopt;
+  return request;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TilePackCache::Blob TileSourceWebMapService::storeData(
+    TileId const& tileId, int x, int y, cs::utils::HttpResponse const& response) {
+
+  if (!response.mError.empty()) {
+    throw std::runtime_error(response.mError);
+  }
+
+  // The data is only written to the cache if the server actually returned an image.
+  if (!cs::utils::contains(response.mContentType, "image/png") &&
+      !cs::utils::contains(response.mContentType, "image/tiff")) {
+    throw std::runtime_error(response.mBody);
   }
 
-  {
-    std::unique_lock<std::mutex> lock(mFileSystemMutex);
-
-    // Try to create the cache directory if necessary.
-    auto cacheDirPath(boost::filesystem::absolute(boost::filesystem::path(cacheDir.str())));
-    if (!(boost::filesystem::exists(cacheDirPath))) {
-      try {
-        cs::utils::filesystem::createDirectoryRecursively(
-            cacheDirPath, boost::filesystem::perms::all_all);
-      } catch (std::exception& e) {
-        throw std::runtime_error(fmt::format("Failed to create cache directory '{}'!", e.what()));
+  std::string cacheFile = getCacheFile(tileId.level(), x, y);
+  auto        packCache = getPackCache();
+
+  auto cacheFilePath(boost::filesystem::path(cacheFile));
+  auto data = std::make_shared<std::string>(response.mBody);
+
+  if (packCache) {
+    packCache->write(tileId.level(), x, y, data->data(), data->size());
+  } else {
+    {
+      std::unique_lock<std::mutex> lock(mFileSystemMutex);
+
+      // Try to create the cache directory if necessary.
+      auto cacheDirPath(boost::filesystem::absolute(cacheFilePath.parent_path()));
+      if (!(boost::filesystem::exists(cacheDirPath))) {
+        try {
+          cs::utils::filesystem::createDirectoryRecursively(
+              cacheDirPath, boost::filesystem::perms::all_all);
+        } catch (std::exception& e) {
+          throw std::runtime_error(fmt::format("Failed to create cache directory '{}'!", e.what()));
+        }
       }
     }
 
-    // The file is there but obviously corrupt. Remove it.
-    if (boost::filesystem::exists(cacheFilePath) &&
-        boost::filesystem::file_size(cacheFile.str()) == 0) {
-      boost::filesystem::remove(cacheFilePath);
+    {
+      std::ofstream file(cacheFile, std::ofstream::out | std::ofstream::binary);
+
+      if (!file) {
+        throw std::runtime_error(fmt::format(
+            "Failed to download tile data: Cannot open '{}' for writing!", cacheFile));
+      }
+
+      file.write(data->data(), static_cast<std::streamsize>(data->size()));
     }
+
+    boost::filesystem::perms filePerms =
+        boost::filesystem::perms::owner_read | boost::filesystem::perms::owner_write |
+        boost::filesystem::perms::group_read | boost::filesystem::perms::group_write |
+        boost::filesystem::perms::others_read | boost::filesystem::perms::others_write;
+    boost::filesystem::permissions(cacheFilePath, filePerms);
   }
 
-  bool fail = false;
-  {
-    std::ofstream out;
-    out.open(cacheFile.str(), std::ofstream::out | std::ofstream::binary);
+  // The raw cache uses the coordinates of the first image of diagonal tiles.
+  int rawX{};
+  int rawY{};
+  getXY(tileId, rawX, rawY);
+  getRawTileCache(true)->remove(tileId.level(), rawX, rawY);
 
-    if (!out) {
-      throw std::runtime_error(fmt::format(
-          "Failed to download tile data: Cannot open '{}' for writing!", cacheFile.str()));
-    }
+  return TilePackCache::Blob(data, data->data(), data->size());
+}
 
-    // Check if we already had an error with this tile cache file in the past
-    if (mLastTimeTileFailed.find(cacheFilePath) != mLastTimeTileFailed.end()) {
-      auto cooldownTime = std::chrono::seconds(3);
-      auto timeNow      = std::chrono::system_clock::now();
-      if (timeNow - mLastTimeTileFailed[cacheFilePath] < cooldownTime) {
-        logger().warn(
-            "Failed to download tile data: Waiting for '{}' to cool down", cacheFile.str());
-        // Sleep for the rest of the cooldown time (plus a little longer 500ms)
-        std::this_thread::sleep_until(
-            mLastTimeTileFailed[cacheFilePath] + cooldownTime + std::chrono::milliseconds(500));
-      }
-      mLastTimeTileFailed.erase(cacheFilePath);
-    }
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    curlpp::Easy request;
-    request.setOpt(curlpp::options::Url(url.str()));
-    request.setOpt(curlpp::options::WriteStream(&out));
-    request.setOpt(curlpp::options::NoSignal(true));
+std::chrono::milliseconds TileSourceWebMapService::getRemainingCooldown(
+    std::string const& cacheFile) {
+  std::unique_lock<std::mutex> lock(mLastTimeTileFailedMutex);
 
-    request.perform();
+  auto iter = mLastTimeTileFailed.find(boost::filesystem::path(cacheFile));
+  if (iter == mLastTimeTileFailed.end()) {
+    return std::chrono::milliseconds(0);
+  }
+
+  // Wait for the rest of the cooldown time (plus a little longer 500ms).
+  auto cooldownTime = std::chrono::seconds(3);
+  auto remaining    = std::chrono::duration_cast<std::chrono::milliseconds>(
+      iter->second + cooldownTime - std::chrono::system_clock::now());
 
-    auto contentType = curlpp::Info<CURLINFO_CONTENT_TYPE, std::string>::get(request);
+  mLastTimeTileFailed.erase(iter);
 
-    fail = !cs::utils::contains(contentType, "image/png") &&
-           !cs::utils::contains(contentType, "image/tiff");
+  if (remaining.count() <= 0) {
+    return std::chrono::milliseconds(0);
   }
 
-  if (fail) {
-    std::ifstream     in(cacheFile.str());
-    std::stringstream sstr;
-    sstr << in.rdbuf();
+  return remaining + std::chrono::milliseconds(500);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceWebMapService::removeData(
+    TileId const& tileId, int x, int y, bool markAsInvalid) {
+  std::string cacheFile = getCacheFile(tileId.level(), x, y);
 
-    std::remove(cacheFile.str().c_str());
-    throw std::runtime_error(sstr.str());
+  // We keep track of the time a tile has had invalid data. This is used for a cooldown mechanism.
+  if (markAsInvalid) {
+    std::unique_lock<std::mutex> lock(mLastTimeTileFailedMutex);
+    mLastTimeTileFailed[boost::filesystem::path(cacheFile)] = std::chrono::system_clock::now();
   }
 
-  boost::filesystem::perms filePerms =
-      boost::filesystem::perms::owner_read | boost::filesystem::perms::owner_write |
-      boost::filesystem::perms::group_read | boost::filesystem::perms::group_write |
-      boost::filesystem::perms::others_read | boost::filesystem::perms::others_write;
-  boost::filesystem::permissions(cacheFilePath, filePerms);
+  auto packCache = getPackCache();
 
-  return cacheFile.str();
+  try {
+    if (packCache) {
+      packCache->remove(tileId.level(), x, y);
+    } else {
+      boost::filesystem::remove(cacheFile);
+    }
+  } catch (std::exception const& e) {
+    logger().debug("Failed to remove tile data: {}", e.what());
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-/* virtual */ void TileSourceWebMapService::loadTileAsync(TileId const& tileId, OnLoadCallback cb) {
-  mThreadPool.enqueue([=]() {
-    auto tile = loadTile(tileId);
-    cb(tileId, std::move(tile));
+/* virtual */ cs::utils::TaskHandle TileSourceWebMapService::loadTileAsync(
+    TileId const& tileId, OnLoadCallback cb) {
+  return mLoadTasks.submit([=]() {
+    int  x{};
+    int  y{};
+    bool onDiag = getXY(tileId, x, y);
+
+    // If the tile has been decoded before, there is nothing more to do.
+    auto rawCache = getRawTileCache();
+    if (rawCache) {
+      auto tile = rawCache->read(tileId.level(), x, y);
+      if (tile) {
+        cb(tileId, std::move(tile));
+        return;
+      }
+    }
+
+    // Tiles on the diagonal of base patch 4 consist of two images.
+    std::vector<glm::ivec2> missing;
+
+    if (mUrl != "offline") {
+      std::vector<glm::ivec2> images = {{x, y}};
+
+      if (onDiag) {
+        images.emplace_back(x + 4 * (1 << tileId.level()), y - 4 * (1 << tileId.level()));
+      }
+
+      std::copy_if(images.begin(), images.end(), std::back_inserter(missing),
+          [&](glm::ivec2 const& image) { return !isCached(tileId, image.x, image.y); });
+    }
+
+    if (missing.empty()) {
+      cb(tileId, loadTile(tileId));
+      return;
+    }
+
+    // The missing images are downloaded by the HttpFetcher. No thread of the pool is blocked in the
+    // meantime; the responses are stored in the cache on the pool and once all images of the tile
+    // are available, it is decoded.
+    auto pending = std::make_shared<std::atomic<std::size_t>>(missing.size());
+    auto failed  = std::make_shared<std::atomic<bool>>(false);
+
+    for (auto const& image : missing) {
+      cs::utils::HttpFetcher::get().fetch(createRequest(tileId, image.x, image.y),
+          mLoadTasks.track([=](cs::utils::HttpResponse response) {
+            mLoadTasks.post([=, response = std::move(response)]() {
+              try {
+                storeData(tileId, image.x, image.y, response);
+              } catch (std::exception const& e) {
+                // This is not critical, the planet will just not refine any further.
+                logger().debug("Tile loading failed: {}", e.what());
+                *failed = true;
+              }
+
+              if (--*pending == 0) {
+                cb(tileId, *failed ? nullptr : loadTile(tileId));
+              }
+            });
+          }));
+    }
   });
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 int TileSourceWebMapService::getPendingRequests() {
-  return static_cast<int>(mThreadPool.getPendingTaskCount() + mThreadPool.getRunningTaskCount());
+  return static_cast<int>(mLoadTasks.getPendingTaskCount());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -481,7 +726,10 @@ uint32_t TileSourceWebMapService::getResolution() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TileSourceWebMapService::setCacheDirectory(std::string const& cacheDirectory) {
+  std::unique_lock<std::mutex> lock(mPackCacheMutex);
   mCache = cacheDirectory;
+  mPackCache.reset();
+  mRawTileCache.reset();
 }
 
 std::string const& TileSourceWebMapService::getCacheDirectory() const {
@@ -491,7 +739,10 @@ std::string const& TileSourceWebMapService::getCacheDirectory() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TileSourceWebMapService::setLayers(std::string const& layers) {
+  std::unique_lock<std::mutex> lock(mPackCacheMutex);
   mLayers = layers;
+  mPackCache.reset();
+  mRawTileCache.reset();
 }
 
 std::string const& TileSourceWebMapService::getLayers() const {
@@ -510,8 +761,48 @@ std::string const& TileSourceWebMapService::getUrl() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TileSourceWebMapService::setPackedCache(bool enable) {
+  std::unique_lock<std::mutex> lock(mPackCacheMutex);
+  mPackedCache = enable;
+  mPackCache.reset();
+  mRawTileCache.reset();
+}
+
+bool TileSourceWebMapService::getPackedCache() const {
+  return mPackedCache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceWebMapService::setRawCache(bool enable) {
+  std::unique_lock<std::mutex> lock(mPackCacheMutex);
+  mRawCache = enable;
+  mRawTileCache.reset();
+}
+
+bool TileSourceWebMapService::getRawCache() const {
+  return mRawCache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceWebMapService::setRawCacheCompression(bool enable) {
+  std::unique_lock<std::mutex> lock(mPackCacheMutex);
+  mRawCacheCompression = enable;
+  mRawTileCache.reset();
+}
+
+bool TileSourceWebMapService::getRawCacheCompression() const {
+  return mRawCacheCompression;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TileSourceWebMapService::setDataType(TileDataType type) {
+  std::unique_lock<std::mutex> lock(mPackCacheMutex);
   mFormat = type;
+  mPackCache.reset();
+  mRawTileCache.reset();
 }
 
 TileDataType TileSourceWebMapService::getDataType() const {
@@ -524,13 +815,49 @@ bool TileSourceWebMapService::isSame(TileSource const* other) const {
   auto const* casted = dynamic_cast<TileSourceWebMapService const*>(other);
 
   return casted != nullptr && mUrl == casted->mUrl && mCache == casted->mCache &&
-         mLayers == casted->mLayers && mFormat == casted->mFormat;
+         mLayers == casted->mLayers && mFormat == casted->mFormat &&
+         mPackedCache == casted->mPackedCache && mRawCache == casted->mRawCache &&
+         mRawCacheCompression == casted->mRawCacheCompression;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string TileSourceWebMapService::getCacheFile(int level, int x, int y) const {
+  // We encode the layers and the tile resolution in the cache file path.
+  return fmt::format("{}/{}x{}/{}/{}/{}.{}", mCache, mLayers, mResolution, level, x, y,
+      getFileExtension(mFormat));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TileSourceWebMapService::markTileDataAsInvalid(boost::filesystem::path const& TileDataPath) {
-  mLastTimeTileFailed[TileDataPath] = std::chrono::system_clock::now();
+std::shared_ptr<TilePackCache> TileSourceWebMapService::getPackCache() {
+  std::unique_lock<std::mutex> lock(mPackCacheMutex);
+
+  if (mPackedCache && !mPackCache) {
+    mPackCache = TilePackCache::get(
+        fmt::format("{}/{}x{}", mCache, mLayers, mResolution), getFileExtension(mFormat));
+  }
+
+  return mPackCache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<RawTileCache> TileSourceWebMapService::getRawTileCache(bool evenIfDisabled) {
+  std::unique_lock<std::mutex> lock(mPackCacheMutex);
+
+  if (!mRawCache && !evenIfDisabled) {
+    return nullptr;
+  }
+
+  // Opening the raw cache does not create any files, so this is cheap even if it is disabled.
+  if (!mRawTileCache) {
+    mRawTileCache = std::make_shared<RawTileCache>(
+        fmt::format("{}/{}x{}/raw", mCache, mLayers, mResolution), mFormat, mResolution,
+        mRawCacheCompression);
+  }
+
+  return mRawTileCache;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -8,8 +8,11 @@
 #ifndef CSP_LOD_BODIES_TILESOURCEWMS_HPP
 #define CSP_LOD_BODIES_TILESOURCEWMS_HPP
 
+#include "../../../src/cs-utils/HttpFetcher.hpp"
 #include "../../../src/cs-utils/ThreadPool.hpp"
+#include "RawTileCache.hpp"
 #include "TileData.hpp"
+#include "TilePackCache.hpp"
 #include "TileSource.hpp"
 
 #include <chrono>
@@ -40,14 +43,29 @@ class TileSourceWebMapService : public TileSource {
 
   std::shared_ptr<BaseTileData> loadTile(TileId const& tileId) override;
 
-  void loadTileAsync(TileId const& tileId, OnLoadCallback cb) override;
-  int  getPendingRequests() override;
+  cs::utils::TaskHandle loadTileAsync(TileId const& tileId, OnLoadCallback cb) override;
+  int                   getPendingRequests() override;
 
   uint32_t getResolution() const;
 
   void               setCacheDirectory(std::string const& cacheDirectory);
   std::string const& getCacheDirectory() const;
 
+  /// If enabled, the tiles are not stored as individual files in the cache directory. Instead,
+  /// there is one TilePackCache per data set. Disabled by default.
+  void setPackedCache(bool enable);
+  bool getPackedCache() const;
+
+  /// If enabled, decoded tiles are additionally stored in a RawTileCache next to the encoded ones.
+  /// When a tile is loaded again, the PNG or TIFF decoding and the merging of diagonal tiles is
+  /// skipped. Disabled by default.
+  void setRawCache(bool enable);
+  bool getRawCache() const;
+
+  /// If enabled, tiles written to the raw cache are LZ4-compressed. Enabled by default.
+  void setRawCacheCompression(bool enable);
+  bool getRawCacheCompression() const;
+
   void               setLayers(std::string const& layers);
   std::string const& getLayers() const;
 
@@ -64,32 +82,78 @@ class TileSourceWebMapService : public TileSource {
   static bool getXY(TileId const& tileId, int& x, int& y);
 
   // This downloads the tile with the given coordinates from the MapServer. It is stored in the
-  // local map cache and the resulting file name is returned. If the tile is already present in the
-  // map cache, no request is made and the cache file name is returned immediately. It may happen
-  // that a tile cannot be downloaded (e.g. if the server is offline) - in this case no error is
-  // thrown but std::nullopt is returned. In several other cases (e.g. cache directory is not
-  // writable) a std::runtime_error is thrown.
-  std::optional<std::string> loadData(TileId const& tileId, int x, int y);
-
-  // This will mark a previously downloaded tile file as invalid together with the current
-  // timestamp. This information is used to avoid quering the same tile immediately after we've
-  // received invalid data from server Tracking the time of the last error allows us to apply a kind
-  // of cooldown mechanism
-  void markTileDataAsInvalid(boost::filesystem::path const& TileDataPath);
+  // local map cache and the encoded image data is returned. If the tile is already present in the
+  // map cache, no request is made and the cached data is returned immediately. It may happen that a
+  // tile cannot be downloaded (e.g. if the server is offline) - in this case no error is thrown but
+  // std::nullopt is returned. In several other cases (e.g. cache directory is not writable) a
+  // std::runtime_error is thrown. This blocks until the download is finished; loadTileAsync() does
+  // not use this for tiles which are not cached yet.
+  std::optional<TilePackCache::Blob> loadData(TileId const& tileId, int x, int y);
+
+  // This removes a previously downloaded tile from the local map cache, e.g. because it could not
+  // be decoded. If markAsInvalid is set, the tile is also marked as invalid together with the
+  // current timestamp. This information is used to avoid quering the same tile immediately after
+  // we've received invalid data from server. Tracking the time of the last error allows us to apply
+  // a kind of cooldown mechanism.
+  void removeData(TileId const& tileId, int x, int y, bool markAsInvalid = false);
 
  private:
+  // Returns the path of the cache file of the given tile. If the packed cache is used, this is only
+  // used for identifying the tile in log messages.
+  std::string getCacheFile(int level, int x, int y) const;
+
+  // Returns the cached data of the given tile or std::nullopt if it is not cached.
+  std::optional<TilePackCache::Blob> readCachedData(TileId const& tileId, int x, int y);
+
+  // Returns true if the given tile is in the cache. This does not read the tile's data.
+  bool isCached(TileId const& tileId, int x, int y);
+
+  // Creates the request for downloading the given tile from the MapServer.
+  cs::utils::HttpRequest createRequest(TileId const& tileId, int x, int y);
+
+  // Writes the data downloaded for the given tile to the cache. As the decoded tile may be outdated
+  // now, it is removed from the raw cache. A std::runtime_error is thrown if the download failed,
+  // if the server did not return an image or if the cache cannot be written.
+  TilePackCache::Blob storeData(
+      TileId const& tileId, int x, int y, cs::utils::HttpResponse const& response);
+
+  // If the given tile has had invalid data recently, this returns the time which has to pass before
+  // it should be requested again. The tile is only delayed once.
+  std::chrono::milliseconds getRemainingCooldown(std::string const& cacheFile);
+
+  // Returns nullptr if the packed cache is not enabled.
+  std::shared_ptr<TilePackCache> getPackCache();
+
+  // Returns nullptr if the raw cache is not enabled. If evenIfDisabled is set, the raw cache is
+  // returned anyways. This is used for removing outdated tiles which may have been stored while it
+  // was enabled.
+  std::shared_ptr<RawTileCache> getRawTileCache(bool evenIfDisabled = false);
+
   static std::mutex mFileSystemMutex;
 
-  cs::utils::ThreadPool mThreadPool;
-  std::string           mUrl;
-  std::string           mCache = "cache/img";
-  std::string           mLayers;
-  TileDataType          mFormat = TileDataType::eColor;
-  uint32_t              mResolution;
+  std::string  mUrl;
+  std::string  mCache = "cache/img";
+  std::string  mLayers;
+  TileDataType mFormat = TileDataType::eColor;
+  uint32_t     mResolution;
+  bool         mPackedCache         = false;
+  bool         mRawCache            = false;
+  bool         mRawCacheCompression = true;
+
+  // The caches are opened lazily as they depend on several of the properties above.
+  std::mutex                     mPackCacheMutex;
+  std::shared_ptr<TilePackCache> mPackCache;
+  std::shared_ptr<RawTileCache>  mRawTileCache;
 
   // We keep track of the time a tile has had invalid data from the server.
   // This timestamp is used for a cooldown mechanism
+  std::mutex mLastTimeTileFailedMutex;
   std::map<boost::filesystem::path, std::chrono::system_clock::time_point> mLastTimeTileFailed;
+
+  // Tiles are loaded on the shared thread pool. The callbacks of pending downloads are tracked by
+  // this group as well. This has to be the last member, so that pending tasks and downloads are
+  // finished before any of the members above are destroyed.
+  cs::utils::TaskGroup mLoadTasks;
 };
 } // namespace csp::lodbodies
 
@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TileStagingBuffer.hpp"
+
+#include <cstring>
+#include <utility>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileStagingBuffer::Slot::Slot(std::shared_ptr<FreeSlots> freeSlots, int index, std::size_t offset)
+    : mFreeSlots(std::move(freeSlots))
+    , mIndex(index)
+    , mOffset(offset) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileStagingBuffer::Slot::~Slot() {
+  // The FreeSlots are reset by TileStagingBuffer::submit(). In this case, the slot is recycled once
+  // the upload has been finished.
+  if (mFreeSlots) {
+    std::unique_lock<std::mutex> lock(mFreeSlots->mMutex);
+    mFreeSlots->mIndices.push_back(mIndex);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TileStagingBuffer::Slot::getOffset() const {
+  return mOffset;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileStagingBuffer::TileStagingBuffer(std::size_t slotSize, int slotCount)
+    : mSlotSize(slotSize)
+    , mFreeSlots(std::make_shared<FreeSlots>()) {
+
+  auto       size  = static_cast<GLsizeiptr>(slotSize * slotCount);
+  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  glGenBuffers(1, &mBuffer);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+  glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+  mData = static_cast<char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  // The slots are handed out in ascending order.
+  mFreeSlots->mIndices.reserve(slotCount);
+  for (int i = slotCount - 1; i >= 0; --i) {
+    mFreeSlots->mIndices.push_back(i);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileStagingBuffer::~TileStagingBuffer() {
+  for (auto const& submission : mSubmissions) {
+    glDeleteSync(submission.mFence);
+  }
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  glDeleteBuffers(1, &mBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<TileStagingBuffer::Slot> TileStagingBuffer::stage(void const* data) {
+  if (!mData) {
+    return nullptr;
+  }
+
+  int index{};
+
+  {
+    std::unique_lock<std::mutex> lock(mFreeSlots->mMutex);
+
+    if (mFreeSlots->mIndices.empty()) {
+      return nullptr;
+    }
+
+    index = mFreeSlots->mIndices.back();
+    mFreeSlots->mIndices.pop_back();
+  }
+
+  // The slot is not accessed by the GPU, so it can be written without any synchronization.
+  std::size_t offset = index * mSlotSize;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  std::memcpy(mData + offset, data, mSlotSize);
+
+  return std::unique_ptr<Slot>(new Slot(mFreeSlots, index, offset));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileStagingBuffer::submit(std::vector<std::unique_ptr<Slot>> slots) {
+  if (slots.empty()) {
+    return;
+  }
+
+  Submission submission;
+  submission.mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  for (auto& slot : slots) {
+    submission.mIndices.push_back(slot->mIndex);
+    slot->mFreeSlots.reset();
+  }
+
+  mSubmissions.push_back(std::move(submission));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileStagingBuffer::recycle() {
+  // The fences are signalled in the order they have been inserted, so we can stop at the first one
+  // which has not been passed yet.
+  while (!mSubmissions.empty()) {
+    auto const& submission = mSubmissions.front();
+    GLenum      result     = glClientWaitSync(submission.mFence, 0, 0);
+
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+      break;
+    }
+
+    glDeleteSync(submission.mFence);
+
+    {
+      std::unique_lock<std::mutex> lock(mFreeSlots->mMutex);
+      mFreeSlots->mIndices.insert(mFreeSlots->mIndices.end(), submission.mIndices.begin(),
+          submission.mIndices.end());
+    }
+
+    mSubmissions.pop_front();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GLuint TileStagingBuffer::getBuffer() const {
+  return mBuffer;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TileStagingBuffer::getSlotSize() const {
+  return mSlotSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_LOD_BODIES_TILESTAGINGBUFFER_HPP
+#define CSP_LOD_BODIES_TILESTAGINGBUFFER_HPP
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace csp::lodbodies {
+
+/// A persistently mapped pixel unpack buffer which is used to stream tile data to the GPU. The
+/// buffer is divided into a ring of equally sized slots, each large enough to hold the data of one
+/// tile. The data of a tile can be copied into a free slot by any thread right after it has been
+/// loaded. The render thread then only has to issue a glTexSubImage3D from the buffer which does
+/// not require any further copies on the CPU.
+///
+/// Once the uploads from some slots have been issued, they are passed to submit(). A fence is
+/// inserted into the command stream and the slots become available again as soon as the GPU has
+/// passed this fence.
+class TileStagingBuffer {
+ private:
+  struct FreeSlots;
+
+ public:
+  /// A slot which contains the data of one tile. If it is destroyed before it has been passed to
+  /// TileStagingBuffer::submit(), it becomes available again immediately.
+  class Slot {
+   public:
+    Slot(Slot const& other) = delete;
+    Slot(Slot&& other)      = delete;
+
+    Slot& operator=(Slot const& other) = delete;
+    Slot& operator=(Slot&& other)      = delete;
+
+    ~Slot();
+
+    /// The offset of the slot's data in bytes from the beginning of the buffer.
+    std::size_t getOffset() const;
+
+   private:
+    friend class TileStagingBuffer;
+
+    Slot(std::shared_ptr<FreeSlots> freeSlots, int index, std::size_t offset);
+
+    std::shared_ptr<FreeSlots> mFreeSlots;
+    int                        mIndex;
+    std::size_t                mOffset;
+  };
+
+  /// Creates and maps the buffer. This has to be called on the render thread.
+  TileStagingBuffer(std::size_t slotSize, int slotCount);
+
+  TileStagingBuffer(TileStagingBuffer const& other) = delete;
+  TileStagingBuffer(TileStagingBuffer&& other)      = delete;
+
+  TileStagingBuffer& operator=(TileStagingBuffer const& other) = delete;
+  TileStagingBuffer& operator=(TileStagingBuffer&& other)      = delete;
+
+  ~TileStagingBuffer();
+
+  /// Copies slotSize bytes from the given pointer to a free slot. This is thread-safe. Returns
+  /// nullptr if all slots are currently in use.
+  std::unique_ptr<Slot> stage(void const* data);
+
+  /// Marks the given slots as being read by the upload commands issued so far. They will become
+  /// available again once the GPU has finished these commands. This has to be called on the render
+  /// thread.
+  void submit(std::vector<std::unique_ptr<Slot>> slots);
+
+  /// Makes all slots available again whose uploads have been finished by the GPU. This has to be
+  /// called on the render thread.
+  void recycle();
+
+  /// Returns the OpenGL id of the buffer. It can be bound to GL_PIXEL_UNPACK_BUFFER.
+  GLuint getBuffer() const;
+
+  std::size_t getSlotSize() const;
+
+ private:
+  struct FreeSlots {
+    std::mutex       mMutex;
+    std::vector<int> mIndices;
+  };
+
+  struct Submission {
+    GLsync           mFence;
+    std::vector<int> mIndices;
+  };
+
+  std::size_t mSlotSize;
+  GLuint      mBuffer{};
+  char*       mData{};
+
+  std::shared_ptr<FreeSlots> mFreeSlots;
+  std::deque<Submission>     mSubmissions;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILESTAGINGBUFFER_HPP
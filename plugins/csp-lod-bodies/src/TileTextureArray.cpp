@@ -10,7 +10,11 @@
 #include "BaseTileData.hpp"
 #include "TreeManager.hpp"
 
+#include "../../../src/cs-utils/FrameStats.hpp"
+
 #include <VistaBase/VistaStreamUtils.h>
+#include <algorithm>
+#include <chrono>
 
 namespace csp::lodbodies {
 
@@ -18,6 +22,11 @@ namespace csp::lodbodies {
 
 namespace {
 
+// The size of the persistently mapped staging buffer of each TileTextureArray in bytes.
+const std::size_t STAGING_BUFFER_SIZE = 32 * 1024 * 1024;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 // functions to obtain texture internal/external format and type
 // from TileDataType value
 GLenum getInternalFormat(TileDataType dataType) {
@@ -65,6 +74,20 @@ GLenum getType(TileDataType dataType) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::size_t getPixelSize(TileDataType dataType) {
+  switch (dataType) {
+  case TileDataType::eElevation:
+    return sizeof(float);
+
+  case TileDataType::eColor:
+    return 4 * sizeof(uint8_t);
+  }
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -78,6 +101,10 @@ TileTextureArray::TileTextureArray(TileDataType dataType, int maxLayerCount, uin
     , mDataType(dataType)
     , mResolution(resolution)
     , mNumLayers(maxLayerCount) {
+
+  std::size_t layerSize = getPixelSize(dataType) * resolution * resolution;
+  std::size_t slotCount = std::max<std::size_t>(1, STAGING_BUFFER_SIZE / layerSize);
+  mStagingBuffer = std::make_unique<TileStagingBuffer>(layerSize, static_cast<int>(slotCount));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -94,7 +121,16 @@ TileDataType TileTextureArray::getDataType() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TileTextureArray::stage(BaseTileData& data) {
+  if (data.getDataType() == mDataType && data.getResolution() == mResolution) {
+    data.setStagingSlot(mStagingBuffer->stage(data.getDataPtr()));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TileTextureArray::allocateGPU(std::shared_ptr<BaseTileData> data) {
+  data->setUploadQueueIndex(static_cast<int>(mUploadQueue.size()));
   mUploadQueue.push_back(std::move(data));
 }
 
@@ -105,31 +141,40 @@ void TileTextureArray::releaseGPU(std::shared_ptr<BaseTileData> const& data) {
   if (data->getTexLayer() >= 0) {
     releaseLayer(data);
   } else {
-    // TileData is not uploaded, could be in the queue?
-    // XXX TODO Linear search, but mUploadQueue is usually small and
-    //          this case should be rare
-    auto rIt = std::find(mUploadQueue.begin(), mUploadQueue.end(), data);
-
-    // avoid erasing an element in the middle of std::vector,
-    // just invalidate the pointer and skip NULL entries when uploading
-    if (rIt != mUploadQueue.end()) {
-      rIt->reset();
+    // TileData is not uploaded, it is most likely still in the queue. Avoid erasing an element in
+    // the middle of std::vector, just invalidate the pointer and skip NULL entries when uploading.
+    auto index = data->getUploadQueueIndex();
+
+    if (index >= 0 && index < static_cast<int>(mUploadQueue.size()) &&
+        mUploadQueue[index] == data) {
+      mUploadQueue[index].reset();
     }
+
+    data->setUploadQueueIndex(-1);
+
+    // The data will not be uploaded anymore, so its slot in the staging buffer can be reused.
+    data->setStagingSlot(nullptr);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TileTextureArray::processQueue(int maxItems) {
+void TileTextureArray::processQueue(int frameCount) {
+  // Slots whose uploads have been finished by the GPU can be used again.
+  mStagingBuffer->recycle();
+
+  if (mUploadFrame != frameCount) {
+    mUploadFrame = frameCount;
+    mUploadTime  = 0.0;
+  }
+
   if (mUploadQueue.empty()) {
     return;
   }
 
   preUpload();
 
-  std::size_t upload = std::min<std::size_t>(maxItems, mUploadQueue.size());
-
-  if (mFreeLayers.size() < upload) {
+  if (mFreeLayers.empty()) {
     // XXX TODO This is bad for performance and visuals, since *all* tiles
     // must be (re)-uploaded to the larger texture
     vstr::warnp() << "[TileTextureArray::processQueue]"
@@ -138,27 +183,46 @@ void TileTextureArray::processQueue(int maxItems) {
                   << std::endl;
   }
 
-  int count = 0;
+  auto        start = std::chrono::high_resolution_clock::now();
+  std::size_t bytes = 0;
+  int         count = 0;
 
-  while (!mUploadQueue.empty() && count < maxItems) {
-    if (mFreeLayers.empty()) {
+  auto elapsed = [&start]() {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start)
+        .count();
+  };
+
+  // The first call in a frame always uploads at least one tile to guarantee progress.
+  while (!mUploadQueue.empty() && !mFreeLayers.empty()) {
+    if ((count > 0 || mUploadTime > 0.0) && mUploadTime + elapsed() >= mMaxUploadTime) {
       break;
     }
 
-    auto data = mUploadQueue.back();
+    auto data = std::move(mUploadQueue.back());
+    mUploadQueue.pop_back();
 
     // data could be NULL if a tile is removed before it is ever
     // uploaded to the GPU, c.f. releaseGPU
     if (data) {
+      data->setUploadQueueIndex(-1);
       allocateLayer(data);
+      bytes += getPixelSize(mDataType) * mResolution * mResolution;
       ++count;
     }
-
-    mUploadQueue.pop_back();
   }
 
+  // The slots of the staging buffer become available again once the GPU has finished all uploads
+  // issued above.
+  mStagingBuffer->submit(std::move(mUploadedSlots));
+  mUploadedSlots.clear();
+
   postUpload();
 
+  mUploadTime += elapsed();
+
+  cs::utils::FrameStats::get().addValue("Uploaded Tile Bytes", static_cast<int64_t>(bytes));
+
   if (count > 0) {
 #if !defined(NDEBUG) && !defined(VISTAPLANET_NO_VERBOSE)
     vstr::outi() << "[TileTextureArray::processQueue]"
@@ -171,6 +235,18 @@ void TileTextureArray::processQueue(int maxItems) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TileTextureArray::setMaxUploadTime(double milliseconds) {
+  mMaxUploadTime = milliseconds;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double TileTextureArray::getMaxUploadTime() const {
+  return mMaxUploadTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 unsigned int TileTextureArray::getTextureId() const {
   return mTexId;
 }
@@ -255,9 +331,24 @@ void TileTextureArray::allocateLayer(std::shared_ptr<BaseTileData> const& data)
   GLsizei const depth   = 1;
   GLvoid const* pixels  = data->getDataPtr();
 
+  // If the data has been copied to the staging buffer before, it is uploaded from there. The
+  // pixels pointer is interpreted as offset into the bound buffer in this case.
+  auto slot = data->takeStagingSlot();
+
+  if (slot) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mStagingBuffer->getBuffer());
+    // NOLINTNEXTLINE(performance-no-int-to-ptr)
+    pixels = reinterpret_cast<GLvoid const*>(slot->getOffset());
+  }
+
   glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, xoffset, yoffset, layer, mResolution, mResolution,
       depth, mFormat, mType, pixels);
 
+  if (slot) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    mUploadedSlots.push_back(std::move(slot));
+  }
+
   data->setTexLayer(layer);
 }
 
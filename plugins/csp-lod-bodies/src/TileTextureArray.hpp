@@ -9,6 +9,7 @@
 #define CSP_LOD_BODIES_TILETEXTUREARRAY_HPP
 
 #include "TileDataType.hpp"
+#include "TileStagingBuffer.hpp"
 
 #include <GL/glew.h>
 #include <array>
@@ -29,6 +30,10 @@ class TreeManager;
 /// once. If more tiles are needed on the GPU the array texture must be resized (which requires all
 /// tiles to be re-uploaded), this should be avoided to prevent the tile resolution to drop
 /// dramatically while only low resolution tiles are on the GPU.
+///
+/// The data is uploaded via a TileStagingBuffer. Loaded tiles can be copied to this buffer by the
+/// loading threads with stage(). The render thread then uploads as many queued tiles as possible
+/// within a given time budget each frame.
 class TileTextureArray {
  public:
   explicit TileTextureArray(TileDataType dataType, int maxLayerCount, uint32_t resolution);
@@ -43,14 +48,27 @@ class TileTextureArray {
 
   TileDataType getDataType() const;
 
+  /// Copies the data of the given tile to the staging buffer, so that it can be uploaded without
+  /// further copies later. This can be called from any thread before allocateGPU() is called for
+  /// the tile. If the staging buffer is full, this does nothing and the tile will be uploaded
+  /// directly from its data.
+  void stage(BaseTileData& data);
+
   /// Requests that data for the tile associated with data be uploaded to the GPU.
   void allocateGPU(std::shared_ptr<BaseTileData> data);
 
   /// Release GPU resources allocated for the tile associated with data.
   void releaseGPU(std::shared_ptr<BaseTileData> const& data);
 
-  /// Process up to maxItems upload requests.
-  void processQueue(int maxItems);
+  /// Process upload requests until the maximum upload time for the given frame is exceeded. This
+  /// may be called several times per frame, e.g. by the TreeManagers of multiple bodies; the time
+  /// budget is shared by all of these calls. At least one tile is uploaded each frame. The number
+  /// of uploaded bytes is reported to the cs::utils::FrameStats.
+  void processQueue(int frameCount);
+
+  /// The time in milliseconds which processQueue() may spend on uploading tiles per frame.
+  void   setMaxUploadTime(double milliseconds);
+  double getMaxUploadTime() const;
 
   /// Returns the OpenGL id of the texture used to store tiles on the GPU. This is an internal
   /// interface for TileRenderer.
@@ -82,7 +100,18 @@ class TileTextureArray {
   const GLint        mNumLayers;
   std::vector<GLint> mFreeLayers;
 
+  // The staging buffer and those of its slots from which uploads have been issued during the
+  // current call to processQueue().
+  std::unique_ptr<TileStagingBuffer>                    mStagingBuffer;
+  std::vector<std::unique_ptr<TileStagingBuffer::Slot>> mUploadedSlots;
+
+  // Tiles are removed from the upload queue by setting their entry to nullptr. The position of each
+  // tile in this queue is stored in the tile, so this does not require a search.
   std::vector<std::shared_ptr<BaseTileData>> mUploadQueue;
+
+  double mMaxUploadTime = 2.0;
+  int    mUploadFrame   = -1;
+  double mUploadTime    = 0.0;
 };
 
 /// DocTODO
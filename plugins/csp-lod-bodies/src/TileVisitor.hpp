@@ -34,7 +34,7 @@ class TileVisitor {
   explicit TileVisitor(TileQuadTree* tree);
 
   /// Start traversal of the trees passed to the constructor.
-  void visit();
+  virtual void visit();
 
  protected:
   void visitRoot(TileNode* root);
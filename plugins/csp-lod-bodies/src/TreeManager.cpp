@@ -12,6 +12,8 @@
 #include "TileSource.hpp"
 #include "TileTextureArray.hpp"
 
+#include "../../../src/cs-utils/FrameStats.hpp"
+
 #include <VistaBase/VistaStreamUtils.h>
 
 #include <algorithm>
@@ -42,47 +44,43 @@ std::size_t const preAllocNodeCount = 500;
 // number of nodes to pre-allocate IO data structures
 std::size_t const preAllocIONodeCount = 200;
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+// number of frames a tile request is kept without being renewed
+int const maxRequestAge = 1;
 
-} // namespace
+// number of tile requests which are passed to the tile sources at the same time
+std::size_t const maxInFlightRequests = 32;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Function object to compare RDMapValue objects by their age.
-struct TreeManager::AgeLess {
-  explicit AgeLess(int frame);
-
-  bool operator()(TileNode const* lhs, TileNode const* rhs) const;
-
-  int mFrame;
-};
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
+// Ends the cs::utils::FrameStats flow of a tile request once the tile has been merged into the tree
+// or has been discarded.
+void endFlow(uint64_t flowID, bool merged) {
+  auto&             frameStats      = cs::utils::FrameStats::get();
+  static auto const mergeFlowName   = frameStats.registerName("Merge Tile");
+  static auto const discardFlowName = frameStats.registerName("Discard Tile");
 
-/* explicit */
-TreeManager::AgeLess::AgeLess(int frame)
-    : mFrame(frame) {
+  frameStats.addFlowEvent(
+      merged ? mergeFlowName : discardFlowName, flowID, cs::utils::FrameStats::FlowPhase::eEnd);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool TreeManager::AgeLess::operator()(TileNode const* lhs, TileNode const* rhs) const {
-  // sort by age (frames since last use), in case of a tie use
-  // tile level - this ensure that child nodes are always sorted
-  // after parent nodes
-
-  int ageLHS = lhs->getAge(mFrame);
-  int ageRHS = rhs->getAge(mFrame);
-
-  if (ageLHS == ageRHS) {
-    return lhs->getLevel() < rhs->getLevel();
+bool hasChildren(TileNode const* node) {
+  for (int i = 0; i < 4; ++i) {
+    if (node->getChild(i)) {
+      return true;
+    }
   }
 
-  return ageLHS < ageRHS;
+  return false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 /* explicit */
 TreeManager::NodeAge::NodeAge(TileNode* node, int frame)
     : mNode(node)
@@ -97,7 +95,7 @@ TreeManager::TreeManager(std::shared_ptr<GLResources> glResources)
     , mFrameCount(0)
     , mAsyncLoading(true) {
 
-  mNodes.reserve(preAllocNodeCount);
+  mPruneCandidates.reserve(preAllocNodeCount);
   mUnmergedNodes.reserve(preAllocIONodeCount);
   mLoadedNodes.reserve(preAllocIONodeCount);
 }
@@ -114,29 +112,141 @@ void TreeManager::setSource(TileDataType type, TileSource* src) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TreeManager::request(std::vector<TileId> const& tileIds) {
-  // for each requested tile, check if it is already in the mPendingTiles
-  // set (those are tiles that have already been requesed from the tile
-  // source), otherwise put the tile in mPendingTiles and ask the source to
-  // load the tile.
-  // In the case of async loading, register @c onDataLoaded as the callback
-  // that the source invokes when the tile is ready.
+void TreeManager::request(
+    std::vector<TileId> const& tileIds, std::vector<TileRequestPriority> const& priorities) {
+  // For each requested tile, check if it is already in mPendingTiles (those are tiles that have
+  // already been passed to the tile source). If so, the request is only renewed. Otherwise, the
+  // tile is put into the request queue. The priority of queued requests is updated.
+  {
+    std::unique_lock<std::mutex> lck(mPendingMtx);
+
+    for (std::size_t i = 0; i < tileIds.size(); ++i) {
+      auto it = mPendingTiles.find(tileIds[i]);
+      if (it != mPendingTiles.end()) {
+        it->second.mLastRequestFrame = mFrameCount;
+      } else {
+        mRequestQueue.push(tileIds[i],
+            i < priorities.size() ? priorities[i] : TileRequestPriority(), mFrameCount);
+      }
+    }
+  }
+
+  removeStaleRequests();
+  dispatchRequests();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::removeStaleRequests() {
+  int oldestValidFrame = mFrameCount - maxRequestAge;
+
   std::unique_lock<std::mutex> lck(mPendingMtx);
 
+  // Requests which have not been passed to the tile sources can be dropped without further ado.
+  mCancelledRequests += mRequestQueue.removeStale(oldestValidFrame);
+
+  // For in-flight requests, we try to cancel the loading of each channel. If loading has already
+  // started for all channels, we let the request finish as the work is done anyways.
+  for (auto it = mPendingTiles.begin(); it != mPendingTiles.end();) {
+    auto& tile = it->second;
+
+    if (tile.mDiscarded || tile.mOutstanding == 0 || tile.mLastRequestFrame >= oldestValidFrame) {
+      ++it;
+      continue;
+    }
+
+    bool cancelled = false;
+    for (auto& handle : tile.mHandles) {
+      if (handle.cancel()) {
+        --tile.mOutstanding;
+        cancelled = true;
+      }
+    }
+
+    if (!cancelled) {
+      ++it;
+      continue;
+    }
+
+    tile.mDiscarded = true;
+    --mInFlightRequests;
+    ++mCancelledRequests;
+    endFlow(tile.mFlowID, false);
+
+    // If loading of some channels is still in progress, the node will be deleted in onDataLoaded().
+    if (tile.mOutstanding == 0) {
+      delete tile.mNode; // NOLINT(cppcoreguidelines-owning-memory)
+      it = mPendingTiles.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::dispatchRequests() {
+  std::vector<TileSource*> sources;
+
+  {
+    std::unique_lock<std::mutex> lck(mSourcesMtx);
+    for (auto const& src : mTileDataSources.mChannels) {
+      if (src) {
+        sources.push_back(src);
+      }
+    }
+  }
+
+  if (sources.empty()) {
+    return;
+  }
+
+  auto&                 frameStats      = cs::utils::FrameStats::get();
+  static auto const     requestFlowName = frameStats.registerName("Request Tile");
+  std::vector<TileId>   tileIds;
+  std::vector<uint64_t> flowIDs;
+
+  {
+    std::unique_lock<std::mutex> lck(mPendingMtx);
+
+    if (mInFlightRequests >= maxInFlightRequests) {
+      return;
+    }
+
+    tileIds = mRequestQueue.pop(maxInFlightRequests - mInFlightRequests);
+
+    for (auto const& tileId : tileIds) {
+      auto& tile             = mPendingTiles[tileId];
+      tile.mNode             = new TileNode(tileId);
+      tile.mOutstanding      = sources.size();
+      tile.mLastRequestFrame = mFrameCount;
+      tile.mFlowID           = frameStats.createFlowID();
+      flowIDs.push_back(tile.mFlowID);
+      ++mInFlightRequests;
+    }
+  }
+
+  for (auto flowID : flowIDs) {
+    frameStats.addFlowEvent(requestFlowName, flowID, cs::utils::FrameStats::FlowPhase::eBegin);
+  }
+
+  // In the case of async loading, register onDataLoaded as the callback that the source invokes
+  // when the tile is ready. The mutex is not held here, as the synchronous loading will call
+  // onDataLoaded directly.
   for (auto const& tileId : tileIds) {
-    if (mPendingTiles.count(tileId) == 0) {
-      mPendingTiles[tileId] = new TileNode(tileId);
-
-      for (auto const& src : mTileDataSources.mChannels) {
-        if (src) {
-          if (mAsyncLoading) {
-            src->loadTileAsync(
-                tileId, [this](auto id, auto data) { onDataLoaded(id, std::move(data)); });
-          } else {
-            auto tileData = src->loadTile(tileId);
-            onDataLoaded(tileId, std::move(tileData));
-          }
+    for (auto* src : sources) {
+      if (mAsyncLoading) {
+        auto handle = src->loadTileAsync(
+            tileId, [this](auto id, auto data) { onDataLoaded(id, std::move(data)); });
+
+        std::unique_lock<std::mutex> lck(mPendingMtx);
+        auto                         it = mPendingTiles.find(tileId);
+        if (it != mPendingTiles.end()) {
+          it->second.mHandles.push_back(std::move(handle));
         }
+      } else {
+        auto tileData = src->loadTile(tileId);
+        onDataLoaded(tileId, std::move(tileData));
       }
     }
   }
@@ -153,8 +263,10 @@ void TreeManager::update() {
   merge();
 
   // upload tiles to GPU
-  for (auto const& textureArray : mGLResources->mChannels) {
-    textureArray->processQueue(5);
+  if (mGLResources) {
+    for (auto const& textureArray : mGLResources->mChannels) {
+      textureArray->processQueue(mFrameCount);
+    }
   }
 }
 
@@ -166,16 +278,51 @@ void TreeManager::clear() {
     mLoadedNodes.clear();
   }
 
+  mUnmergedNodes.clear();
+
   {
     std::unique_lock<std::mutex> lck(mPendingMtx);
-    mPendingTiles.clear();
+    mRequestQueue.clear();
+
+    // Nodes of tiles which are currently being loaded cannot be deleted here, as the loading
+    // threads may still access them. They are marked as discarded and deleted once loading is done.
+    // All other nodes have been in mLoadedNodes or mUnmergedNodes and can be deleted right away.
+    for (auto it = mPendingTiles.begin(); it != mPendingTiles.end();) {
+      auto& tile = it->second;
+
+      for (auto& handle : tile.mHandles) {
+        if (handle.cancel()) {
+          --tile.mOutstanding;
+        }
+      }
+
+      if (!tile.mDiscarded) {
+        endFlow(tile.mFlowID, false);
+      }
+
+      if (tile.mOutstanding == 0) {
+        delete tile.mNode; // NOLINT(cppcoreguidelines-owning-memory)
+        it = mPendingTiles.erase(it);
+      } else {
+        tile.mDiscarded = true;
+        ++it;
+      }
+    }
+
+    mInFlightRequests = 0;
   }
 
-  for (auto* node : mNodes) {
-    releaseResources(node);
+  for (auto const& bucket : mAgeBuckets) {
+    for (auto* node : bucket.second) {
+      if (node) {
+        releaseResources(node);
+      }
+    }
   }
 
-  mNodes.clear();
+  mAgeBuckets.clear();
+  mNodeCount = 0;
+  mResidency = {};
 
   for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
     mTree.setRoot(i, nullptr);
@@ -185,51 +332,83 @@ void TreeManager::clear() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TreeManager::onDataLoaded(TileId const& tileId, std::shared_ptr<BaseTileData> tileData) {
+  auto&             frameStats   = cs::utils::FrameStats::get();
+  static auto const timerName    = frameStats.registerName("Process Loaded Tile");
+  static auto const loadFlowName = frameStats.registerName("Load Tile");
 
-  // If tile loading failed, discard the data.
-  if (!tileData) {
-    std::unique_lock<std::mutex> lck(mPendingMtx);
-    mPendingTiles.erase(tileId);
-    return;
-  }
+  // This is usually executed on a worker thread of the TileSource.
+  cs::utils::FrameStats::ScopedTimer timer(timerName, cs::utils::FrameStats::TimerMode::eCPU);
 
   TileNode* node{};
+  uint64_t  flowID{};
 
   {
     std::unique_lock<std::mutex> lck(mPendingMtx);
 
-    // If the data is not need the tile anymore, discard it.
+    // If the tile is not needed anymore, discard the data.
     auto it = mPendingTiles.find(tileId);
     if (it == mPendingTiles.end()) {
       return;
     }
 
-    node = it->second;
+    node   = it->second.mNode;
+    flowID = it->second.mFlowID;
   }
 
-  if (tileData->getDataType() == TileDataType::eElevation) {
-    auto demdata = dynamic_cast<TileData<float>*>(tileData.get());
-    node->setMinMaxPyramid(std::make_unique<MinMaxPyramid>(demdata));
+  frameStats.addFlowEvent(loadFlowName, flowID, cs::utils::FrameStats::FlowPhase::eStep);
+
+  // If tile loading failed, the tile is discarded below.
+  bool failed = !tileData;
+
+  if (!failed) {
+    if (tileData->getDataType() == TileDataType::eElevation) {
+      auto demdata = dynamic_cast<TileData<float>*>(tileData.get());
+      node->setMinMaxPyramid(std::make_unique<MinMaxPyramid>(demdata));
+    }
+
+    // Copy the data to the staging buffer while we are still on the loading thread. This way, the
+    // render thread only has to issue the upload later.
+    if (mGLResources) {
+      mGLResources->get(tileData->getDataType())->stage(*tileData);
+    }
+
+    node->setTileData(std::move(tileData));
   }
 
-  node->setTileData(std::move(tileData));
+  std::unique_lock<std::mutex> lck(mPendingMtx);
 
-  auto dem = node->getTileData(TileDataType::eElevation);
-  auto img = node->getTileData(TileDataType::eColor);
+  auto it = mPendingTiles.find(tileId);
+  if (it == mPendingTiles.end()) {
+    return;
+  }
 
-  bool hasColorChannel = false;
+  auto& tile = it->second;
+  --tile.mOutstanding;
 
-  {
-    std::unique_lock<std::mutex> lck(mSourcesMtx);
-    hasColorChannel = mTileDataSources.get(TileDataType::eColor);
+  if (failed && !tile.mDiscarded) {
+    tile.mDiscarded = true;
+    --mInFlightRequests;
+    endFlow(tile.mFlowID, false);
   }
 
-  if (dem && (img || !hasColorChannel)) {
-    // Only add node to list of loaded nodes, actual insertion into the
-    // quad-tree is done in merge().
-    // This ensures that the tree is not modified at unpredictable moments
-    // in time (for example while a traversal is in progress).
-    std::unique_lock<std::mutex> lck(mLoadedMtx);
+  if (tile.mDiscarded) {
+    // The tile cannot be used, we delete it once all channels are done. Afterwards, the tile may be
+    // requested again.
+    if (tile.mOutstanding == 0) {
+      delete tile.mNode; // NOLINT(cppcoreguidelines-owning-memory)
+      mPendingTiles.erase(it);
+    }
+    return;
+  }
+
+  if (tile.mOutstanding == 0) {
+    --mInFlightRequests;
+    ++mCompletedRequests;
+
+    // Only add node to list of loaded nodes, actual insertion into the quad-tree is done in
+    // merge(). This ensures that the tree is not modified at unpredictable moments in time (for
+    // example while a traversal is in progress).
+    std::unique_lock<std::mutex> loadedLck(mLoadedMtx);
     mLoadedNodes.push_back(node);
   }
 }
@@ -244,7 +423,13 @@ void TreeManager::onNodeInserted(TileNode* node) {
     node->setLastFrame(parent->getLastFrame());
   }
 
-  mNodes.push_back(node);
+  mAgeBuckets[node->getLastFrame()].push_back(node);
+  mResidency += getResidency(node);
+  ++mNodeCount;
+
+  if (!mGLResources) {
+    return;
+  }
 
   for (auto const& res : mGLResources->mChannels) {
     auto data = node->getTileData(res->getDataType());
@@ -257,6 +442,10 @@ void TreeManager::onNodeInserted(TileNode* node) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TreeManager::releaseResources(TileNode* node) {
+  if (!mGLResources) {
+    return;
+  }
+
   for (auto const& res : mGLResources->mChannels) {
     auto data = node->getTileData(res->getDataType());
     if (data) {
@@ -267,32 +456,85 @@ void TreeManager::releaseResources(TileNode* node) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TreeManager::prune() {
-  // sort by age, oldest nodes at the back
-  std::sort(mNodes.begin(), mNodes.end(), AgeLess(mFrameCount));
-  int count = 0;
+TileResidency TreeManager::getResidency(TileNode const* node) const {
+  TileResidency residency;
+  residency.mCPUBytes = sizeof(TileNode);
+
+  for (auto const& data : node->getTileData().mChannels) {
+    if (data) {
+      residency.mCPUBytes += data->getDataSize();
+      residency.mGPULayers = mGLResources ? 1 : 0;
+    }
+  }
+
+  if (node->getMinMaxPyramid()) {
+    residency.mCPUBytes += sizeof(MinMaxPyramid) + node->getMinMaxPyramid()->getMemorySize();
+  }
+
+  return residency;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileResidency TreeManager::removeLeaf(TileNode* node) {
+  TileResidency residency = getResidency(node);
+
+  mResidency -= residency;
+  --mNodeCount;
+
+  releaseResources(node);
 
-  while (!mNodes.empty()) {
-    TileNode* node = mNodes.back();
+  if (!removeNode(&mTree, node)) {
+    vstr::errp() << "[TreeManager::removeLeaf] Failed to remove node " << node << "!" << std::endl;
+  }
+
+  return residency;
+}
 
-    // remove unnused nodes, but never root nodes
-    if (node->getAge(mFrameCount) > maxNodeAge && node->getLevel() > 0) {
-      releaseResources(node);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-      if (!removeNode(&mTree, node)) {
-        vstr::errp() << "[TreeManager::prune] Failed to remove node " << node << "!" << std::endl;
+void TreeManager::prune() {
+  int oldestValidFrame = mFrameCount - maxNodeAge;
+
+  // Inspect all buckets which are too old. Nodes which have been used in the meantime are moved to
+  // the bucket of the frame they have been used in. So a node which is used every frame is only
+  // inspected every few frames.
+  while (!mAgeBuckets.empty() && mAgeBuckets.begin()->first < oldestValidFrame) {
+    std::vector<TileNode*> bucket = std::move(mAgeBuckets.begin()->second);
+    mAgeBuckets.erase(mAgeBuckets.begin());
+
+    for (auto* node : bucket) {
+      if (!node) {
+        continue;
       }
 
-      // remove entries for node from internal data structures
-      mNodes.pop_back();
-      ++count;
+      if (node->getLastFrame() >= oldestValidFrame) {
+        mAgeBuckets[node->getLastFrame()].push_back(node);
+      } else if (node->getLevel() == 0) {
+        // Root nodes are never removed.
+        mAgeBuckets[mFrameCount].push_back(node);
+      } else {
+        mPruneCandidates.push_back(node);
+      }
+    }
+  }
+
+  // Removing a node from the tree also deletes its children. Hence, the deepest nodes are removed
+  // first. Nodes are marked as used together with their parents, so children are never younger
+  // than their parents and have been collected above as well.
+  std::sort(mPruneCandidates.begin(), mPruneCandidates.end(),
+      [](TileNode const* lhs, TileNode const* rhs) { return lhs->getLevel() > rhs->getLevel(); });
+
+  for (auto* node : mPruneCandidates) {
+    // Should a child have been used more recently nevertheless, the node is kept for now.
+    if (hasChildren(node)) {
+      mAgeBuckets[mFrameCount].push_back(node);
     } else {
-      // The node at the back of mAgeStore can not be removed - stop
-      // The sorting of mAgeStore ensures that there is no node that
-      // could be removed beyond this point.
-      break;
+      removeLeaf(node);
     }
   }
+
+  mPruneCandidates.clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -319,7 +561,7 @@ void TreeManager::merge() {
       ++merged;
 
       std::unique_lock<std::mutex> lck(mPendingMtx);
-      mPendingTiles.erase(node->getTileId());
+      removePendingTile(node->getTileId(), true);
 
       node = nullptr;
     } else {
@@ -333,25 +575,34 @@ void TreeManager::merge() {
   // Go through list of unmerged nodes and attempt to insert them into the
   // tree. If that fails and the nodes age exceeds maxUnmergedAge, it is
   // discarded.
-  for (std::size_t i = 0; i < mUnmergedNodes.size();) {
-    TileNode* node = mUnmergedNodes[i].mNode;
+  {
+    std::unique_lock<std::mutex> lck(mPendingMtx);
 
-    if (insertNode(&mTree, node)) {
-      // insert succeeded, remove from pending and unmerged and
-      // associate render data with node
-      mPendingTiles.erase(node->getTileId());
-      mUnmergedNodes.erase(mUnmergedNodes.begin() + i);
+    // Nodes which remain unmerged are moved to the front of mUnmergedNodes. This keeps their order
+    // and avoids erasing elements from the middle of the vector.
+    std::size_t remaining = 0;
 
-      onNodeInserted(node);
-    } else if ((mFrameCount - mUnmergedNodes[i].mFrame) > maxUnmergedAge) {
-      // node is waiting for too long to be merged - discard it
-      mPendingTiles.erase(node->getTileId());
-      mUnmergedNodes.erase(mUnmergedNodes.begin() + i);
+    for (auto const& unmergedNode : mUnmergedNodes) {
+      TileNode* node = unmergedNode.mNode;
 
-      delete node; // NOLINT(cppcoreguidelines-owning-memory): TODO where does it get created?
-    } else {
-      ++i;
+      if (insertNode(&mTree, node)) {
+        // insert succeeded, remove from pending and unmerged and
+        // associate render data with node
+        removePendingTile(node->getTileId(), true);
+
+        onNodeInserted(node);
+      } else if ((mFrameCount - unmergedNode.mFrame) > maxUnmergedAge) {
+        // node is waiting for too long to be merged - discard it
+        removePendingTile(node->getTileId(), false);
+
+        delete node; // NOLINT(cppcoreguidelines-owning-memory): TODO where does it get created?
+      } else {
+        mUnmergedNodes[remaining++] = unmergedNode;
+      }
     }
+
+    mUnmergedNodes.erase(mUnmergedNodes.begin() + static_cast<std::ptrdiff_t>(remaining),
+        mUnmergedNodes.end());
   }
 
   // copy any nodes that where not merged to mUnmergedNodes
@@ -377,6 +628,16 @@ void TreeManager::merge() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TreeManager::removePendingTile(TileId const& tileId, bool merged) {
+  auto it = mPendingTiles.find(tileId);
+  if (it != mPendingTiles.end()) {
+    endFlow(it->second.mFlowID, merged);
+    mPendingTiles.erase(it);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 TileQuadTree* TreeManager::getTree() {
   return &mTree;
 }
@@ -395,4 +656,59 @@ void TreeManager::setFrameCount(int frameCount) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::size_t TreeManager::getNodeCount() const {
+  return mNodeCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileResidency const& TreeManager::getResidency() const {
+  return mResidency;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManager::getEvictionCandidates(
+    int unusedSince, std::vector<EvictionCandidate>& candidates) {
+  // The nodes in a bucket have not been used before the frame of the bucket. Hence, only the
+  // buckets before the given frame have to be inspected.
+  for (auto it = mAgeBuckets.begin(); it != mAgeBuckets.end() && it->first < unusedSince; ++it) {
+    for (std::size_t i = 0; i < it->second.size(); ++i) {
+      TileNode* node = it->second[i];
+
+      if (node && node->getLevel() > 0 && node->getLastFrame() < unusedSince) {
+        candidates.push_back({this, node, node->getLastFrame(), node->getLevel(), it->first, i});
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileResidency TreeManager::evict(EvictionCandidate const& candidate) {
+  if (hasChildren(candidate.mNode)) {
+    return {};
+  }
+
+  mAgeBuckets.at(candidate.mBucket).at(candidate.mIndex) = nullptr;
+
+  return removeLeaf(candidate.mNode);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TreeManager::RequestStatistics TreeManager::getRequestStatistics() const {
+  std::unique_lock<std::mutex> lck(mPendingMtx);
+
+  RequestStatistics statistics;
+  statistics.mQueued    = mRequestQueue.size();
+  statistics.mInFlight  = mInFlightRequests;
+  statistics.mCancelled = mCancelledRequests;
+  statistics.mCompleted = mCompletedRequests;
+
+  return statistics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace csp::lodbodies
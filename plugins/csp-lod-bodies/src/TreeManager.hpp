@@ -8,9 +8,13 @@
 #ifndef CSP_LOD_BODIES_TREEMANAGER_HPP
 #define CSP_LOD_BODIES_TREEMANAGER_HPP
 
+#include "../../../src/cs-utils/ThreadPool.hpp"
+#include "ResidencyManager.hpp"
 #include "TileId.hpp"
 #include "TileQuadTree.hpp"
+#include "TileRequestQueue.hpp"
 
+#include <map>
 #include <mutex>
 #include <string>
 #include <unordered_set>
@@ -29,16 +33,25 @@ class TileTextureArray;
 /// Tiles to load from the configured TileSource are passed in with a call to request and previously
 /// (asynchronously) loaded tiles are merged into the TileQuadTree with a call to update.
 ///
+/// Requested tiles are not passed to the TileSources immediately. Instead, they are stored in a
+/// TileRequestQueue and only a limited number of requests is loaded at the same time. The most
+/// important requests (according to their TileRequestPriority) are loaded first. Requests have to
+/// be renewed every frame; requests which have not been renewed for a few frames are dropped. This
+/// also applies to requests which have already been passed to a TileSource but whose loading has
+/// not started yet.
+///
 /// In addition to managing the loading of tiles and inserting them into the managed TileQuadTree
 /// this also keeps track of the "age" of nodes. A nodes age is measured in frames since the last
 /// time it was used - other classes mark nodes as used (e.g. LODVisitor when testing visibility of
 /// a node).
 ///
-/// In order to quickly find "old" nodes a vector of node pointers is used. The vector is sorted so
-/// that the oldest nodes are at the back and those are removed if their age exceeds a certain
-/// threshold (see TreeManager::prune).
+/// In order to quickly find "old" nodes, the nodes are stored in buckets according to the frame in
+/// which they have been used last. Only the nodes in buckets which are older than a certain
+/// threshold have to be inspected for removal (see TreeManager::prune).
 class TreeManager {
  public:
+  /// If glResources is nullptr, the data of the tiles is not uploaded to the GPU. This can be used
+  /// to manage a tree without an OpenGL context, for instance for testing.
   explicit TreeManager(std::shared_ptr<GLResources> glResources);
 
   TreeManager(TreeManager const& other) = delete;
@@ -57,9 +70,30 @@ class TreeManager {
 
   std::shared_ptr<GLResources> const& getGLResources() const;
 
+  /// Counters describing the state of the tile request scheduler.
+  struct RequestStatistics {
+    /// Requests which have not been passed to a TileSource yet.
+    std::size_t mQueued{};
+
+    /// Requests which are currently being loaded by the TileSources.
+    std::size_t mInFlight{};
+
+    /// Requests which have been dropped because they were not renewed in time. This is accumulated
+    /// over the lifetime of the TreeManager.
+    std::size_t mCancelled{};
+
+    /// Requests for which the data of all channels has been loaded successfully. This is
+    /// accumulated over the lifetime of the TreeManager.
+    std::size_t mCompleted{};
+  };
+
   /// Request data tiles with indices tileIds to be loaded and queued to be merged into the quad
-  /// tree (with a subsequent call to update).
-  void request(std::vector<TileId> const& tileIds);
+  /// tree (with a subsequent call to update). The priorities vector should either be empty or
+  /// contain one entry for each tile. Tiles without a given priority are loaded before all others.
+  /// Requests have to be repeated each frame until the tile has been loaded, else they will be
+  /// dropped.
+  void request(
+      std::vector<TileId> const& tileIds, std::vector<TileRequestPriority> const& priorities = {});
 
   /// Update the TileQuadTree managed by this with the tiles that have been loaded from the
   /// TileSource since the last call to update.
@@ -70,9 +104,27 @@ class TreeManager {
 
   void setFrameCount(int frameCount);
 
- private:
-  struct AgeLess;
+  /// Returns the number of nodes which are currently in the tree.
+  std::size_t getNodeCount() const;
 
+  /// Returns the resources used by the nodes which are currently in the tree. Nodes which are still
+  /// being loaded are not included.
+  TileResidency const& getResidency() const;
+
+  /// Appends all nodes to the given vector which have not been used since the given frame. Root
+  /// nodes are never included. This is used by the ResidencyManager.
+  void getEvictionCandidates(int unusedSince, std::vector<EvictionCandidate>& candidates);
+
+  /// Removes the node of the given candidate from the tree ahead of time. Nodes with children
+  /// cannot be removed, in this case nothing is done. Returns the resources which have been freed.
+  /// The candidate must have been collected with getEvictionCandidates() and the tree must not
+  /// have been updated since then.
+  TileResidency evict(EvictionCandidate const& candidate);
+
+  /// Returns the current state of the request scheduler.
+  RequestStatistics getRequestStatistics() const;
+
+ private:
   /// Tracks a node and the frame it was loaded in - for nodes that can not immediately be merged.
   struct NodeAge {
     explicit NodeAge(TileNode* node, int frame);
@@ -81,6 +133,34 @@ class TreeManager {
     int       mFrame;
   };
 
+  /// Tracks a tile which has been passed to the TileSources and which has not been merged into the
+  /// tree yet.
+  struct PendingTile {
+    TileNode*                          mNode{};
+    std::vector<cs::utils::TaskHandle> mHandles;
+
+    /// The number of channels whose data has neither been delivered nor been cancelled.
+    std::size_t mOutstanding{};
+
+    /// The last frame in which this tile has been requested.
+    int mLastRequestFrame{};
+
+    /// Links the request, loading and merging or discarding of this tile in traces of
+    /// cs::utils::FrameStats.
+    uint64_t mFlowID{};
+
+    /// This is set if loading of one channel failed or if the request became stale. The node will
+    /// be deleted as soon as mOutstanding reaches zero.
+    bool mDiscarded{};
+  };
+
+  /// Drops all queued requests and all in-flight requests which have not been renewed recently. For
+  /// the latter, this is only possible if loading has not started for at least one channel.
+  void removeStaleRequests();
+
+  /// Passes the most important queued requests to the TileSources.
+  void dispatchRequests();
+
   /// Used as a callback for the TileSource to call when a node is loaded.
   void onDataLoaded(TileId const& tileId, std::shared_ptr<BaseTileData> tileData);
 
@@ -91,9 +171,16 @@ class TreeManager {
   /// Helper function to free resources associated with node.
   void releaseResources(TileNode* node);
 
+  /// Returns the resources used by the given node.
+  TileResidency getResidency(TileNode const* node) const;
+
+  /// Removes the given node from the tree. The node must not have any children. Returns the
+  /// resources which have been freed.
+  TileResidency removeLeaf(TileNode* node);
+
   /// Remove nodes from the managed TileQuadTree that have not been used for a number of frames.
-  /// Sort tiles by age (frames since last use, see TreeManager::AgeLess for details) and
-  /// removes those considered too "old".
+  /// Only the nodes in outdated buckets of mAgeBuckets are inspected, so the cost does not depend
+  /// on the total number of nodes in the tree.
   void prune();
 
   /// Merge nodes loaded since the last merge into the managed TileQuadTree. It is possible that a
@@ -103,19 +190,36 @@ class TreeManager {
   /// node still cannot be inserted into the tree it is deleted.
   void merge();
 
+  /// Removes the given tile from mPendingTiles and ends the flow of its request. mPendingMtx has to
+  /// be locked by the caller.
+  void removePendingTile(TileId const& tileId, bool merged);
+
   std::shared_ptr<GLResources> mGLResources;
-  std::vector<TileNode*>       mNodes;
+
+  // All nodes in the tree, bucketed by the frame in which they have been used last. As the nodes
+  // are marked as used without notifying the TreeManager, the buckets are only updated lazily in
+  // prune(). Hence, the actual last frame of a node may be newer than the one of its bucket. Nodes
+  // which have been evicted are replaced by nullptr.
+  std::map<int, std::vector<TileNode*>> mAgeBuckets;
+  std::vector<TileNode*>                mPruneCandidates;
+  std::size_t                           mNodeCount{};
+  TileResidency                         mResidency;
 
   TileQuadTree             mTree;
   PerDataType<TileSource*> mTileDataSources;
 
-  std::unordered_map<TileId, TileNode*> mPendingTiles;
-  std::vector<NodeAge>                  mUnmergedNodes;
-  std::vector<TileNode*>                mLoadedNodes;
+  TileRequestQueue                        mRequestQueue;
+  std::unordered_map<TileId, PendingTile> mPendingTiles;
+  std::vector<NodeAge>                    mUnmergedNodes;
+  std::vector<TileNode*>                  mLoadedNodes;
+
+  std::size_t mInFlightRequests{};
+  std::size_t mCancelledRequests{};
+  std::size_t mCompletedRequests{};
 
-  std::mutex mSourcesMtx;
-  std::mutex mLoadedMtx;
-  std::mutex mPendingMtx;
+  std::mutex         mSourcesMtx;
+  std::mutex         mLoadedMtx;
+  mutable std::mutex mPendingMtx;
 
   int  mFrameCount;
   bool mAsyncLoading;
@@ -31,6 +31,7 @@ namespace csp::lodbodies {
 VistaPlanet::VistaPlanet(std::shared_ptr<GLResources> glResources, uint32_t tileResolution)
     : mWorldTransform(1.0)
     , mTreeMgr(std::move(glResources))
+    , mHeightQueries(mTreeMgr.getTree())
     , mLodVisitor(mParams, &mTreeMgr)
     , mRenderer(mParams, &mTreeMgr, tileResolution)
     , mLastFrameClock(GetVistaSystem()->GetFrameClock())
@@ -204,6 +205,16 @@ void VistaPlanet::updateStatistics(int frameCount) {
   mSumDrawTiles += mLodVisitor.getRenderNodes().size();
   mSumLoadTiles += mLodVisitor.getLoadNodes().size();
 
+  // The state of the request scheduler is reported to the cs::utils::FrameStats, so that it can be
+  // shown next to the ranges of the loading threads in traces.
+  if (cs::utils::FrameStats::get().getMeasurementsEnabled()) {
+    auto requests = mTreeMgr.getRequestStatistics();
+    cs::utils::FrameStats::get().addValue(
+        "Queued Tile Requests", static_cast<int64_t>(requests.mQueued));
+    cs::utils::FrameStats::get().addValue(
+        "In-Flight Tile Requests", static_cast<int64_t>(requests.mInFlight));
+  }
+
   // print and reset statistics every 60 frames
   if (frameCount % 60 == 0) {
 #if !defined(NDEBUG) && !defined(VISTAPLANET_NO_VERBOSE)
@@ -219,6 +230,12 @@ void VistaPlanet::updateStatistics(int frameCount) {
     }
 
     vstr::out() << std::endl;
+
+    auto requests = mTreeMgr.getRequestStatistics();
+    vstr::outi() << "[VistaPlanet::Do] tile requests queued [" << requests.mQueued
+                 << "] in flight [" << requests.mInFlight << "] cancelled ["
+                 << requests.mCancelled << "] completed [" << requests.mCompleted << "]"
+                 << std::endl;
 #endif
 
     mSumFrameClock = 0.0;
@@ -233,6 +250,9 @@ void VistaPlanet::updateTileTrees(int frameCount) {
   cs::utils::FrameStats::ScopedTimer timer("Upload Tiles", cs::utils::FrameStats::TimerMode::eCPU);
   mTreeMgr.setFrameCount(frameCount);
   mTreeMgr.update();
+
+  // Pending height queries are checked against the updated trees and keep their tiles alive.
+  mHeightQueries.update(frameCount);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -252,7 +272,23 @@ void VistaPlanet::traverseTileTrees(
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void VistaPlanet::processLoadRequests() {
-  mTreeMgr.request(mLodVisitor.getLoadNodes());
+  // The tiles required by height queries are loaded after the tiles requested by the LODVisitor.
+  auto const& queryNodes = mHeightQueries.getLoadNodes();
+
+  if (queryNodes.empty()) {
+    mTreeMgr.request(mLodVisitor.getLoadNodes(), mLodVisitor.getLoadPriorities());
+    return;
+  }
+
+  auto const& queryPriorities = mHeightQueries.getLoadPriorities();
+
+  std::vector<TileId> loadNodes(mLodVisitor.getLoadNodes());
+  loadNodes.insert(loadNodes.end(), queryNodes.begin(), queryNodes.end());
+
+  std::vector<TileRequestPriority> loadPriorities(mLodVisitor.getLoadPriorities());
+  loadPriorities.insert(loadPriorities.end(), queryPriorities.begin(), queryPriorities.end());
+
+  mTreeMgr.request(loadNodes, loadPriorities);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -394,4 +430,16 @@ LODVisitor const& VistaPlanet::getLODVisitor() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+HeightQueryManager& VistaPlanet::getHeightQueries() {
+  return mHeightQueries;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HeightQueryManager const& VistaPlanet::getHeightQueries() const {
+  return mHeightQueries;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace csp::lodbodies
@@ -8,6 +8,7 @@
 #ifndef CSP_LOD_BODIES_VISTAPLANET_HPP
 #define CSP_LOD_BODIES_VISTAPLANET_HPP
 
+#include "HeightQueryManager.hpp"
 #include "LODVisitor.hpp"
 #include "PlanetParameters.hpp"
 #include "TileRenderer.hpp"
@@ -109,6 +110,11 @@ class VistaPlanet : public cs::graphics::ShadowCaster {
   LODVisitor&       getLODVisitor();
   LODVisitor const& getLODVisitor() const;
 
+  /// Returns the HeightQueryManager which refines terrain heights up to the maximum level without
+  /// blocking. The tiles it requires are loaded before all tiles required for rendering.
+  HeightQueryManager&       getHeightQueries();
+  HeightQueryManager const& getHeightQueries() const;
+
  private:
   void updateStatistics(int frameCount);
   void updateTileTrees(int frameCount);
@@ -126,10 +132,11 @@ class VistaPlanet : public cs::graphics::ShadowCaster {
   glm::dmat4 mWorldTransform;
   bool       mEnabled = false;
 
-  PlanetParameters mParams;
-  TreeManager      mTreeMgr;
-  LODVisitor       mLodVisitor;
-  TileRenderer     mRenderer;
+  PlanetParameters   mParams;
+  TreeManager        mTreeMgr;
+  HeightQueryManager mHeightQueries;
+  LODVisitor         mLodVisitor;
+  TileRenderer       mRenderer;
 
   PerDataType<TileSource*> mTileDataSources;
 
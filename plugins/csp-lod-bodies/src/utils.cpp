@@ -10,18 +10,401 @@
 #include "HEALPix.hpp"
 
 #include "BaseTileData.hpp"
+#include "MinMaxPyramid.hpp"
+#include "TileQuadTree.hpp"
 #include "VistaPlanet.hpp"
 
+#include "../../../src/cs-utils/ThreadPool.hpp"
 #include "../../../src/cs-utils/convert.hpp"
 
 #include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
 
 #include <glm/gtx/quaternion.hpp>
 
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <map>
+#include <thread>
+#include <vector>
+
 namespace csp::lodbodies::utils {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The ray traversal of intersectTile() subdivides the ray at most this many times.
+const int MAX_SEGMENT_DEPTH = 32;
+
+// The number of samples which are taken along the parts of a ray which cover at most one quad of a
+// tile. Between the first two samples where the ray enters the terrain, the intersection is then
+// refined with this many bisection steps.
+const int LEAF_SAMPLES    = 4;
+const int BISECTION_STEPS = 16;
+
+// Intersections which are this many texels outside of a tile are still accepted by the tile. This
+// accounts for rounding errors at the edges between tiles.
+const double EDGE_TOLERANCE = 1e-6;
+
+// getHeights() processes batches with at least this many positions on multiple threads.
+const std::size_t MIN_PARALLEL_HEIGHT_SAMPLES = 4096;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A position along a ray in the coordinate system of a tile.
+struct RaySample {
+  double mT{};
+
+  // The position in the elevation data of the tile. x refers to the column, y to the row.
+  glm::dvec2 mTexel{};
+
+  // The height above the surface of the planet's ellipsoid.
+  double mAltitude{};
+};
+
+// A part of a ray which is processed by intersectTile().
+struct RaySegment {
+  RaySample mStart;
+  RaySample mEnd;
+  int       mDepth{};
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Maps positions along a ray to the coordinate system of a tile.
+class TileRay {
+ public:
+  TileRay(TileNode const* tileNode, glm::dvec3 const& radii, double heightScale,
+      glm::dvec3 const& origin, glm::dvec3 const& direction)
+      : mRadii(radii)
+      , mHeightScale(heightScale)
+      , mOrigin(origin)
+      , mDirection(direction)
+      , mBasePatch(HEALPix::getBasePatch(tileNode->getTileId()))
+      , mOffsetScale(HEALPix::getPatchOffsetScale(tileNode->getTileId()))
+      , mResolution(static_cast<int>(
+            tileNode->getTileData(TileDataType::eElevation)->getResolution()))
+      , mHeights(tileNode->getTileData(TileDataType::eElevation)->getTypedPtr<float>()) {
+  }
+
+  RaySample sample(double t) const {
+    glm::dvec3 lngLatHeight =
+        cs::utils::convert::cartesianToLngLatHeight(mOrigin + t * mDirection, mRadii);
+
+    glm::dvec2 xy = HEALPix::convertBaseLngLat2XY(mBasePatch, lngLatHeight.xy());
+    xy            = (xy - glm::dvec2(mOffsetScale.x, mOffsetScale.y)) / mOffsetScale.z;
+
+    return {t, xy * static_cast<double>(mResolution - 1), lngLatHeight.z};
+  }
+
+  // Returns the minimum altitude of the ray between the two given samples. The sample in the
+  // middle is only used if the ray is closest to the center of the planet between a and b.
+  double getMinAltitude(RaySample const& a, RaySample const& b, RaySample const& m) const {
+    double minAltitude = std::min(a.mAltitude, b.mAltitude);
+    double closestT    = -glm::dot(mOrigin, mDirection);
+
+    if (closestT > a.mT && closestT < b.mT) {
+      minAltitude = std::min(minAltitude, std::min(m.mAltitude, sample(closestT).mAltitude));
+    }
+
+    return minAltitude;
+  }
+
+  // Returns the bilinearly interpolated and scaled height at the given texel coordinates.
+  double getHeight(glm::dvec2 const& texel) const {
+    glm::dvec2 p  = glm::clamp(texel, 0.0, static_cast<double>(mResolution - 1));
+    int        x0 = std::min(static_cast<int>(p.x), mResolution - 2);
+    int        y0 = std::min(static_cast<int>(p.y), mResolution - 2);
+    double     fx = p.x - x0;
+    double     fy = p.y - y0;
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    float const* row0 = mHeights + static_cast<std::ptrdiff_t>(y0) * mResolution;
+    float const* row1 = row0 + mResolution;
+
+    double h0 = (1.0 - fx) * row0[x0] + fx * row0[x0 + 1];
+    double h1 = (1.0 - fx) * row1[x0] + fx * row1[x0 + 1];
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+    return ((1.0 - fy) * h0 + fy * h1) * mHeightScale;
+  }
+
+  // Samples which are less than EDGE_TOLERANCE texels outside of the tile are considered to be
+  // inside, so that a position on the edge between two tiles is inside of both.
+  bool isInside(RaySample const& s) const {
+    auto maxIndex = static_cast<double>(mResolution - 1) + EDGE_TOLERANCE;
+    return s.mTexel.x >= -EDGE_TOLERANCE && s.mTexel.y >= -EDGE_TOLERANCE &&
+           s.mTexel.x <= maxIndex && s.mTexel.y <= maxIndex;
+  }
+
+  // Searches for the first position between a and b where the ray enters the terrain. Samples
+  // outside of the tile use the heights at the edge of the tile. Therefore, a crossing is only
+  // accepted if the bisection ends inside the tile; crossings beyond the edge are found by the
+  // neighbouring tile. This way, crossings between a sample inside and a sample outside of the
+  // tile are not lost.
+  bool intersect(RaySample const& a, RaySample const& b, double& t) const {
+    RaySample last          = a;
+    double    lastClearance = a.mAltitude - getHeight(a.mTexel);
+
+    for (int i = 1; i <= LEAF_SAMPLES; ++i) {
+      RaySample current =
+          i == LEAF_SAMPLES ? b : sample(a.mT + (b.mT - a.mT) * i / LEAF_SAMPLES);
+      double clearance = current.mAltitude - getHeight(current.mTexel);
+
+      if (lastClearance >= 0.0 && clearance < 0.0) {
+        double above = last.mT;
+        double below = current.mT;
+
+        for (int j = 0; j < BISECTION_STEPS; ++j) {
+          RaySample middle = sample(0.5 * (above + below));
+
+          if (middle.mAltitude >= getHeight(middle.mTexel)) {
+            above = middle.mT;
+          } else {
+            below = middle.mT;
+          }
+        }
+
+        RaySample hit = sample(0.5 * (above + below));
+
+        if (isInside(hit)) {
+          t = hit.mT;
+          return true;
+        }
+      }
+
+      last          = current;
+      lastClearance = clearance;
+    }
+
+    return false;
+  }
+
+ private:
+  glm::dvec3   mRadii;
+  double       mHeightScale;
+  glm::dvec3   mOrigin;
+  glm::dvec3   mDirection;
+  int          mBasePatch;
+  glm::dvec3   mOffsetScale;
+  int          mResolution;
+  float const* mHeights;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Intersects a ray given in the coordinate system of the planet with all loaded leaf tiles of the
+// planet. The tiles are processed in the order in which the ray enters their bounds. The search
+// stops as soon as no remaining tile can contain an intersection closer than the closest one found
+// so far. Only intersections closer than maxDistance are considered.
+bool intersectTree(VistaPlanet const* planet, glm::dvec3 const& origin,
+    glm::dvec3 const& direction, double maxDistance, double& distance) {
+
+  auto* treeManager = planet->getTileRenderer().getTreeManager();
+
+  if (treeManager == nullptr || treeManager->getTree() == nullptr) {
+    return false;
+  }
+
+  glm::dvec4 origin4(origin, 1.0);
+  glm::dvec4 direction4(direction, 0.0);
+
+  std::multimap<double, TileNode*> intersectedTiles;
+
+  auto addTile = [&](TileNode* node, double limit) {
+    double minDist{};
+    double maxDist{};
+    if (intersectTileBounds(node, planet, origin4, direction4, minDist, maxDist) &&
+        maxDist > 0.0 && minDist < limit) {
+      intersectedTiles.emplace(minDist, node);
+    }
+  };
+
+  for (int rootIndex = 0; rootIndex < TileQuadTree::sNumRoots; ++rootIndex) {
+    TileNode* rootNode = treeManager->getTree()->getRoot(rootIndex);
+
+    if (rootNode == nullptr) {
+      return false;
+    }
+
+    addTile(rootNode, maxDistance);
+  }
+
+  bool found = false;
+  distance   = maxDistance;
+
+  while (!intersectedTiles.empty() && intersectedTiles.begin()->first < distance) {
+    TileNode* node = intersectedTiles.begin()->second;
+    intersectedTiles.erase(intersectedTiles.begin());
+
+    // Parent is not a leaf in cut -> push intersected children into queue.
+    if (node->childrenAvailable()) {
+      for (int childIndex = 0; childIndex < 4; ++childIndex) {
+        if (node->getChild(childIndex)) {
+          addTile(node->getChild(childIndex), distance);
+        }
+      }
+
+      continue;
+    }
+
+    if (!node->getTileData(TileDataType::eElevation) || !node->getMinMaxPyramid()) {
+      continue;
+    }
+
+    double minDist{};
+    double maxDist{};
+    intersectTileBounds(node, planet, origin4, direction4, minDist, maxDist);
+
+    double t{};
+    if (intersectTile(node, planet->getRadii(), planet->getHeightScale(), origin, direction,
+            std::max(0.0, minDist), std::min(maxDist, distance), t)) {
+      distance = t;
+      found    = true;
+    }
+  }
+
+  return found;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Bilinearly interpolates the elevation data of the given tile at the given relative coordinates.
+double sampleTile(TileNode const* node, glm::dvec2 relative) {
+  uint32_t size = node->getTileData().get(TileDataType::eElevation)->getResolution();
+
+  // Figure out flip
+  std::swap(relative.x, relative.y);
+
+  double u = relative.x * (size - 1);
+  double v = relative.y * (size - 1);
+
+  int uB = static_cast<int>(u);
+  int vB = static_cast<int>(v);
+
+  double uP = u - uB;
+  double vP = v - vB;
+
+  double h{};
+  double hP1{};
+  double hP2{};
+  double hPP{};
+
+  const auto* ptr = node->getTileData().get(TileDataType::eElevation)->getTypedPtr<float>();
+  h               = ptr[vB + size * uB]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  hP1 = ptr[vB + size * (uB + 1)];       // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  hP2 = ptr[vB + 1 + size * uB];         // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  hPP = ptr[vB + 1 + size * (uB + 1)];   // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  double interpol1 = (1.0 - uP) * h + uP * hP1;
+  double interpol2 = (1.0 - uP) * hP2 + uP * hPP;
+
+  return (1.0 - vP) * interpol1 + vP * interpol2;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A position which is sampled by getHeights(). The relative coordinates are updated while the
+// quadtree is descended.
+struct HeightSample {
+  glm::dvec2  mRelative{};
+  std::size_t mIndex{};
+};
+
+// Samples all given positions in the deepest available descendants of the given node. The samples
+// are partitioned by the child which contains them, so that each node is visited only once per
+// batch. The same arithmetic as in getHeight() is used, hence the results are identical.
+void sampleNode(TileNode const* node, bool descend, HeightSample* begin, HeightSample* end,
+    double* heights) {
+
+  if (!descend) {
+    for (auto* sample = begin; sample != end; ++sample) {
+      heights[sample->mIndex] = sampleTile(node, sample->mRelative);
+    }
+    return;
+  }
+
+  // The child index is (x >= 0.5) + 2 * (y >= 0.5). Partitioning by y first and then by x sorts the
+  // samples by their child index.
+  auto isLeft   = [](HeightSample const& s) { return s.mRelative.x < 0.5; };
+  auto isBottom = [](HeightSample const& s) { return s.mRelative.y < 0.5; };
+
+  auto* middle = std::partition(begin, end, isBottom);
+
+  std::array<HeightSample*, 5> bounds{begin, std::partition(begin, middle, isLeft), middle,
+      std::partition(middle, end, isLeft), end};
+
+  for (int childIndex = 0; childIndex < 4; ++childIndex) {
+    auto* childBegin = bounds.at(childIndex);
+    auto* childEnd   = bounds.at(childIndex + 1);
+
+    if (childBegin == childEnd) {
+      continue;
+    }
+
+    TileNode const* child = node->getChild(childIndex);
+
+    // If the child is not loaded, the samples are taken from this node.
+    if (child == nullptr) {
+      sampleNode(node, false, childBegin, childEnd, heights);
+      continue;
+    }
+
+    glm::dvec2 offset(0.5 * (childIndex % 2), 0.5 * (childIndex / 2));
+
+    for (auto* sample = childBegin; sample != childEnd; ++sample) {
+      sample->mRelative = (sample->mRelative - offset) * 2.0;
+    }
+
+    sampleNode(child, true, childBegin, childEnd, heights);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Samples the given range of positions with a single traversal of the quadtree.
+void sampleTree(TileQuadTree const* tree, HeightSamplePrecision precision,
+    glm::dvec2 const* lngLats, double* heights, std::size_t begin, std::size_t end) {
+
+  // The samples are sorted by their base patch first.
+  std::array<std::vector<HeightSample>, TileQuadTree::sNumRoots> roots;
+
+  for (std::size_t i = begin; i < end; ++i) {
+    int rootIndex = HEALPix::convertLngLat2Base(lngLats[i]);
+
+    if (rootIndex < 0 || rootIndex >= TileQuadTree::sNumRoots) {
+      heights[i] = 0.0;
+      continue;
+    }
+
+    roots.at(rootIndex).push_back({HEALPix::convertBaseLngLat2XY(rootIndex, lngLats[i]), i});
+  }
+
+  for (int rootIndex = 0; rootIndex < TileQuadTree::sNumRoots; ++rootIndex) {
+    auto&     samples = roots.at(rootIndex);
+    TileNode* root    = tree->getRoot(rootIndex);
+
+    if (root == nullptr) {
+      for (auto const& sample : samples) {
+        heights[sample.mIndex] = 0.0;
+      }
+      continue;
+    }
+
+    sampleNode(root, precision != HeightSamplePrecision::eCoarse, samples.data(),
+        samples.data() + samples.size(), heights);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 double getHeight(
     VistaPlanet const* planet, HeightSamplePrecision precision, glm::dvec2 const& lngLat) {
 
@@ -87,28 +470,15 @@ double getHeight(
     // Get the new Child
     child = parent->getChild(childIndex);
 
-    // Child is unavailable and precision is "HeightSamplePrecision::eActual"
-    if (child == nullptr && precision == HeightSamplePrecision::eActual) {
+    // Child is unavailable, missing tiles are never loaded synchronously. Use the
+    // HeightQueryManager of the planet to refine the heights asynchronously.
+    if (child == nullptr) {
       child = parent;
 
       // Reset coordinates
       relative1 = relative2;
       break;
     }
-
-    // Child is unavailable and precision is "Fine"
-    if (child == nullptr && precision == HeightSamplePrecision::eFine) {
-      std::vector<TileId> requested;
-
-      requested.push_back(HEALPix::getChildTileId(parent->getTileId(), childIndex));
-
-      planet->getTileRenderer().getTreeManager()->request(requested);
-
-      // planet->getTileRenderer().getTreeManager()->merge();
-      planet->getTileRenderer().getTreeManager()->update();
-
-      child = parent->getChild(childIndex);
-    }
   }
 
   // Check if Child Exists
@@ -116,36 +486,51 @@ double getHeight(
     return 0.0;
   }
 
-  uint32_t size = child->getTileData().get(TileDataType::eElevation)->getResolution();
+  return sampleTile(child, relative1);
+}
 
-  // Figure out flip
-  std::swap(relative1.x, relative1.y);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  double u = relative1.x * (size - 1);
-  double v = relative1.y * (size - 1);
+void getHeights(VistaPlanet const* planet, HeightSamplePrecision precision,
+    glm::dvec2 const* lngLats, double* heights, std::size_t count) {
 
-  int uB = static_cast<int>(u);
-  int vB = static_cast<int>(v);
+  TreeManager* treeManager = planet->getTileRenderer().getTreeManager();
 
-  double uP = u - uB;
-  double vP = v - vB;
+  if (treeManager == nullptr || treeManager->getTree() == nullptr) {
+    std::fill(heights, heights + count, 0.0);
+    return;
+  }
 
-  double h{};
-  double hP1{};
-  double hP2{};
-  double hPP{};
+  getHeights(treeManager->getTree(), precision, lngLats, heights, count);
+}
 
-  const auto* ptr = child->getTileData().get(TileDataType::eElevation)->getTypedPtr<float>();
-  h               = ptr[vB + size * uB]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  hP1 = ptr[vB + size * (uB + 1)];       // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  hP2 = ptr[vB + 1 + size * uB];         // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  hPP = ptr[vB + 1 + size * (uB + 1)];   // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  double interpol1 = (1.0 - uP) * h + uP * hP1;
-  double interpol2 = (1.0 - uP) * hP2 + uP * hPP;
-  double height    = (1.0 - vP) * interpol1 + vP * interpol2;
+void getHeights(TileQuadTree const* tree, HeightSamplePrecision precision,
+    glm::dvec2 const* lngLats, double* heights, std::size_t count) {
+
+  if (count < MIN_PARALLEL_HEIGHT_SAMPLES) {
+    sampleTree(tree, precision, lngLats, heights, 0, count);
+    return;
+  }
 
-  return height;
+  // The positions are split into one chunk per hardware thread. Each chunk descends the tree on
+  // its own. The first chunk is processed by this thread, so that it does not idle while waiting
+  // for the others.
+  std::size_t chunkCount = std::max(1U, std::thread::hardware_concurrency());
+  std::size_t chunkSize =
+      std::max(MIN_PARALLEL_HEIGHT_SAMPLES / 2, (count + chunkCount - 1) / chunkCount);
+
+  cs::utils::TaskGroup tasks;
+
+  for (std::size_t begin = chunkSize; begin < count; begin += chunkSize) {
+    auto end = std::min(count, begin + chunkSize);
+    tasks.post([=]() { sampleTree(tree, precision, lngLats, heights, begin, end); },
+        cs::utils::TaskPriority::eHigh);
+  }
+
+  sampleTree(tree, precision, lngLats, heights, 0, std::min(count, chunkSize));
+  tasks.wait();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -168,214 +553,121 @@ bool intersectTileBounds(TileNode const* tileNode, VistaPlanet const* planet,
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool intersectPlanet(
-    VistaPlanet const* planet, glm::dvec3 rayOrigin, glm::dvec3 rayDir, glm::dvec3& pos) {
-  // Check if TreeManagerDEM is ok
-  if (planet->getTileRenderer().getTreeManager() == nullptr) {
-    return false;
-  }
+bool intersectTile(TileNode const* tileNode, glm::dvec3 const& radii, double heightScale,
+    glm::dvec3 const& origin, glm::dvec3 const& direction, double tMin, double tMax, double& t) {
 
-  // Check if TreeManagerDEM -> GetTree is ok
-  if (planet->getTileRenderer().getTreeManager()->getTree() == nullptr) {
+  if (tMax <= tMin) {
     return false;
   }
 
-  // Initialize Result to Zero
-  pos = glm::dvec3(0);
+  TileRay ray(tileNode, radii, heightScale, origin, direction);
+
+  auto const& pyramid  = *tileNode->getMinMaxPyramid();
+  auto const  maxIndex = static_cast<double>(pyramid.getTileResolution() - 1);
+  auto const  lastQuad = static_cast<double>(pyramid.getLevelSize(0) - 1);
+
+  // The segments are processed depth-first. The second half of a segment is pushed first, so that
+  // the segments are processed in the order in which they are passed by the ray.
+  std::vector<RaySegment> stack;
+  stack.reserve(2 * MAX_SEGMENT_DEPTH);
+  stack.push_back({ray.sample(tMin), ray.sample(tMax), 0});
+
+  while (!stack.empty()) {
+    RaySegment segment = stack.back();
+    stack.pop_back();
+
+    RaySample const& a = segment.mStart;
+    RaySample const& b = segment.mEnd;
+    RaySample        m = ray.sample(0.5 * (a.mT + b.mT));
+
+    // The projection of the straight segment onto the tile is curved. The distance of the sample in
+    // the middle of the segment to the straight line between its ends is used to enlarge the
+    // texel-space bounds of the segment accordingly.
+    glm::dvec2 deviation(glm::length(m.mTexel - 0.5 * (a.mTexel + b.mTexel)));
+    glm::dvec2 minTexel = glm::min(glm::min(a.mTexel, b.mTexel), m.mTexel);
+    glm::dvec2 maxTexel = glm::max(glm::max(a.mTexel, b.mTexel), m.mTexel);
+
+    // Skip all parts of the ray which are outside of the tile.
+    if (maxTexel.x + deviation.x < 0.0 || maxTexel.y + deviation.y < 0.0 ||
+        minTexel.x - deviation.x > maxIndex || minTexel.y - deviation.y > maxIndex) {
+      continue;
+    }
 
-  // Planet transform -> Inverse -> so we are in planet space
-  glm::dmat4 planet_transform = planet->getWorldTransform();
-  glm::dmat4 planet_transformnv;
-  planet_transformnv = glm::inverse(planet_transform);
+    // Look up the bounds of the terrain below the segment in the MinMaxPyramid.
+    glm::dvec2 minQuad = glm::clamp(glm::floor(minTexel - deviation), 0.0, lastQuad);
+    glm::dvec2 maxQuad = glm::clamp(glm::floor(maxTexel + deviation), 0.0, lastQuad);
 
-  // Transform ray into planet coordinate system
-  glm::dvec4 origin(rayOrigin[0], rayOrigin[1], rayOrigin[2], 1.0);
-  origin = planet_transformnv * origin;
+    auto minX = static_cast<uint32_t>(minQuad.x);
+    auto minY = static_cast<uint32_t>(minQuad.y);
+    auto maxX = static_cast<uint32_t>(maxQuad.x);
+    auto maxY = static_cast<uint32_t>(maxQuad.y);
 
-  glm::dvec4 direction(rayDir[0], rayDir[1], rayDir[2], 0.0);
-  direction = planet_transformnv * direction;
-  direction = glm::normalize(direction);
+    double minHeight = pyramid.getMinInRange(minX, minY, maxX, maxY) * heightScale;
+    double maxHeight = pyramid.getMaxInRange(minX, minY, maxX, maxY) * heightScale;
 
-  // Determine intersected root patches
-  std::multimap<double, TileNode*> intersected_tiles;
-  for (int rootIndex = 0; rootIndex < 12; ++rootIndex) {
+    // The segment can only enter the terrain if it is above the terrain at some point and below it
+    // at another.
+    if (ray.getMinAltitude(a, b, m) > maxHeight ||
+        std::max(a.mAltitude, b.mAltitude) < minHeight) {
+      continue;
+    }
 
-    TileNode* root_node = planet->getTileRenderer().getTreeManager()->getTree()->getRoot(rootIndex);
+    // If the segment covers at most one quad, the intersection is searched by sampling.
+    if ((maxX - minX <= 1 && maxY - minY <= 1) || segment.mDepth >= MAX_SEGMENT_DEPTH) {
+      if (ray.intersect(a, b, t)) {
+        return true;
+      }
 
-    if (root_node == nullptr) {
-      return false;
+      continue;
     }
 
-    double min_dist{};
-    double max_dist{};
-    bool intersects = intersectTileBounds(root_node, planet, origin, direction, min_dist, max_dist);
-    if (intersects) {
-      intersected_tiles.insert(std::pair<double, TileNode*>(min_dist, root_node));
-    }
+    stack.push_back({m, b, segment.mDepth + 1});
+    stack.push_back({a, m, segment.mDepth + 1});
   }
 
-  TileNode* parent = nullptr;
-  TileNode* child  = nullptr;
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  // Process intersected tile patch priority queue:
-  while (!intersected_tiles.empty()) {
-    parent = intersected_tiles.begin()->second;
-    intersected_tiles.erase(intersected_tiles.begin());
+bool intersectPlanet(
+    VistaPlanet const* planet, glm::dvec3 rayOrigin, glm::dvec3 rayDir, glm::dvec3& pos) {
 
-    if (parent == nullptr) {
-      return false;
-    }
+  // Initialize Result to Zero
+  pos = glm::dvec3(0);
 
-    // Sample height field of cut leaf node
-    if (!parent->childrenAvailable()) {
-      // Get entry and exit point again:
-      double min_dist{};
-      double max_dist{};
-      intersectTileBounds(parent, planet, origin, direction, min_dist, max_dist);
-
-      // Prevent entry being behind the camera:
-      min_dist             = std::max(0.0, min_dist);
-      glm::dvec4 entry     = origin + direction * min_dist;
-      glm::dvec4 exit      = origin + direction * max_dist;
-      auto       sampleDir = (exit - entry).xyz();
-      glm::dvec3 lastSampleCartesian{};
-      glm::dvec3 sampleCartesian{};
-      glm::dvec3 lastSampleLngLatHeight{};
-      glm::dvec3 sampleLngLatHeight{};
-      double     height(0.0);
-      double     lastHeight(0.0);
-      bool       first_sample(true);
-
-      // Estimate number of sampling steps
-      //        -------------------- BboxMax
-      //        |        /\        |
-      //        |   255 /  \       |
-      //        |     /      \     |
-      //        |   /          \   |
-      //        | /     Tile     \ |
-      //        | \               /|
-      //        |   \            / |
-      //        |     \        /   |
-      //        |  255 \      /    |
-      //        |        \   /     |
-      //        |         \/       |
-      // BboxMin--------------------
-      auto const& tile        = parent->getTileData().get(TileDataType::eElevation);
-      auto        tile_bounds = parent->getBounds();
-
-      // Tile sizes
-      int size = tile->getResolution();
-
-      auto max_tile_samplings = std::sqrt((size * size) + (size * size));
-      auto max_bbox_samplings = std::sqrt(
-          (max_tile_samplings * max_tile_samplings) + (max_tile_samplings * max_tile_samplings));
-
-      auto step_factor =
-          glm::length(sampleDir) / glm::length(tile_bounds.getMax() - tile_bounds.getMin());
-      auto step_nr = step_factor * max_bbox_samplings;
-
-      // Sample between entry and exit:
-      for (int step(0); step <= static_cast<int>(step_nr); ++step) {
-        lastSampleCartesian    = sampleCartesian;
-        lastSampleLngLatHeight = sampleLngLatHeight;
-        lastHeight             = height;
-
-        // Sample along ray and then convert to polar:
-        sampleCartesian = glm::dvec3(entry[0], entry[1], entry[2]) +
-                          glm::dvec3((step / step_nr) * sampleDir[0],
-                              (step / step_nr) * sampleDir[1], (step / step_nr) * sampleDir[2]);
-
-        sampleLngLatHeight =
-            cs::utils::convert::cartesianToLngLatHeight(sampleCartesian, planet->getRadii());
-
-        // Calc correct HPix coordinate for child patch in relation to base batch
-        int        base   = HEALPix::getBasePatch(parent->getTileId());
-        auto       scale  = HEALPix::getPatchOffsetScale(parent->getTileId());
-        glm::dvec2 HPixPt = HEALPix::convertBaseLngLat2XY(base, sampleLngLatHeight.xy());
-        HPixPt            = (HPixPt - glm::dvec2(scale[0], scale[1])) / scale[2];
-
-        /* Figure out flip */
-        std::swap(HPixPt.x, HPixPt.y);
-
-        // Calc coords in texture space
-        double u = HPixPt.x * (size - 1);
-        double v = HPixPt.y * (size - 1);
-
-        int uB = static_cast<int>(u);
-        int vB = static_cast<int>(v);
-
-        double uP = u - uB;
-        double vP = v - vB;
-
-        double hP1{};
-        double hP2{};
-        double hPP{};
-        if (uB >= size - 1 || uB < 0) {
-          continue;
-        }
-        if (vB >= size - 1 || vB < 0) {
-          continue;
-        }
+  // Transform ray into planet coordinate system
+  glm::dmat4 inverseTransform = glm::inverse(planet->getWorldTransform());
+  glm::dvec3 origin           = (inverseTransform * glm::dvec4(rayOrigin, 1.0)).xyz();
+  glm::dvec3 direction        = (inverseTransform * glm::dvec4(rayDir, 0.0)).xyz();
+  direction                   = glm::normalize(direction);
 
-        // Access height data
-        const auto* ptr = parent->getTileData().get(TileDataType::eElevation)->getTypedPtr<float>();
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-        height = ptr[vB + size * uB];
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-        hP1 = ptr[vB + size * (uB + 1)];
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-        hP2 = ptr[vB + 1 + size * uB];
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-        hPP = ptr[vB + 1 + size * (uB + 1)];
-
-        double interpol1 = (1.0 - uP) * height + uP * hP1;
-        double interpol2 = (1.0 - uP) * hP2 + uP * hPP;
-        height           = (1.0 - vP) * interpol1 + vP * interpol2;
-        height *= planet->getHeightScale();
-
-        // Detect hit as soon as a sample point below the surface is found
-        if (sampleLngLatHeight.z < height) {
-          // Ignore sampling, which already starts below a patch due to exaggeration
-          if (first_sample) {
-            break;
-          }
+  double distance{};
+  if (!intersectTree(planet, origin, direction, std::numeric_limits<double>::max(), distance)) {
+    return false;
+  }
 
-          double lastWeight = lastSampleLngLatHeight.z - lastHeight;
-          double curWeight  = height - sampleLngLatHeight.z;
+  pos = origin + distance * direction;
 
-          double sum = lastWeight + curWeight;
+  return true;
+}
 
-          lastWeight /= sum;
-          curWeight /= sum;
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-          pos = lastSampleCartesian * (1.0 - lastWeight) + sampleCartesian * (1.0 - curWeight);
+bool hasLineOfSight(VistaPlanet const* planet, glm::dvec3 const& from, glm::dvec3 const& to) {
 
-          // FOUND VALID INTERSECTION!!!
-          return true;
-        }
-        first_sample = false;
-      }
-    }
-    // Parent is not a leaf in cut -> push intersected children into queue:
-    else {
-      // Check all children for intersection
-      for (int childIndex = 0; childIndex < 4; ++childIndex) {
-        /* Get the new Child */
-        child = parent->getChild(childIndex);
-        if (child == nullptr) {
-          continue;
-        }
+  // Transform both points into planet coordinate system
+  glm::dmat4 inverseTransform = glm::inverse(planet->getWorldTransform());
+  glm::dvec3 origin           = (inverseTransform * glm::dvec4(from, 1.0)).xyz();
+  glm::dvec3 target           = (inverseTransform * glm::dvec4(to, 1.0)).xyz();
+  double     length           = glm::length(target - origin);
 
-        double min_dist{};
-        double max_dist{};
-        bool intersects = intersectTileBounds(child, planet, origin, direction, min_dist, max_dist);
-        if (intersects && max_dist > 0.0) {
-          intersected_tiles.insert(std::pair<double, TileNode*>(min_dist, child));
-        }
-      }
-    }
+  if (length <= 0.0) {
+    return true;
   }
-  return false;
+
+  double distance{};
+  return !intersectTree(planet, origin, (target - origin) / length, length, distance);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -10,6 +10,7 @@
 
 #define _USE_MATH_DEFINES // Use Math.h defines like M_PI
 #include <cmath>          // C++ Math
+#include <cstddef>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
@@ -20,12 +21,14 @@ namespace csp::lodbodies {
 
 class VistaPlanet;
 class TileNode;
+class TileQuadTree;
 
 /// Defines the Sample Precision
 enum class HeightSamplePrecision {
   eCoarse = 1, ///< Use the Base Patches (LOD 0) only.
   eActual = 2, ///< Use the already loaded Patches.
-  eFine   = 3  ///< Use the highest LOD available in database.
+  eFine   = 3  ///< Same as eActual. Use VistaPlanet::getHeightQueries() to get the highest LOD
+               ///< available in the database without blocking.
 };
 
 namespace utils {
@@ -38,8 +41,22 @@ namespace utils {
 double getHeight(
     VistaPlanet const* planet, HeightSamplePrecision precision, glm::dvec2 const& lngLat);
 
+/// Retrieves the Planets Height at many lat / long positions at once. The results are the same as
+/// if getHeight() was called for each position, but the positions are grouped by the tiles which
+/// contain them so that each tile of the quadtree is visited only once. Large batches are split
+/// across the cs::utils::ThreadPool; this function blocks until all heights are written.
+/// @param lngLats An array of count positions in the same format as for getHeight().
+/// @param heights An array of count values which receives the heights.
+void getHeights(VistaPlanet const* planet, HeightSamplePrecision precision,
+    glm::dvec2 const* lngLats, double* heights, std::size_t count);
+
+/// Same as above, but samples the given tree directly. The tree must not be modified while this
+/// function is running.
+void getHeights(TileQuadTree const* tree, HeightSamplePrecision precision,
+    glm::dvec2 const* lngLats, double* heights, std::size_t count);
+
 /// Intersects a ray with the height field of a VistaPlanet. The Ray is defined by a position
-/// and orientation.
+/// and orientation. Only the tiles which are currently loaded are considered.
 /// @param planet VistaPlanet to be intersected
 /// @param rayPos Ray position in world space
 /// @param rayDir Ray direction in world space
@@ -47,6 +64,23 @@ double getHeight(
 bool intersectPlanet(
     VistaPlanet const* planet, glm::dvec3 rayOrigin, glm::dvec3 rayDir, glm::dvec3& pos);
 
+/// Returns true if the straight line between the two given points in world space does not
+/// intersect the height field of the given VistaPlanet. Only the tiles which are currently loaded
+/// are considered.
+bool hasLineOfSight(VistaPlanet const* planet, glm::dvec3 const& from, glm::dvec3 const& to);
+
+/// Intersects a ray with the height field of a single tile. The MinMaxPyramid of the tile is used
+/// to skip all parts of the ray which are above or below the terrain, so only the parts close to
+/// the surface are sampled. The ray has to be given in the coordinate system of the planet and
+/// its direction has to be normalized. Only intersections between tMin and tMax are considered and
+/// only where the ray enters the terrain from above. If one is found, its distance along the ray
+/// is stored in t.
+/// @param tileNode    The tile must contain elevation data and a MinMaxPyramid.
+/// @param radii       The radii of the planet.
+/// @param heightScale The factor the elevation data is multiplied with.
+bool intersectTile(TileNode const* tileNode, glm::dvec3 const& radii, double heightScale,
+    glm::dvec3 const& origin, glm::dvec3 const& direction, double tMin, double tMax, double& t);
+
 /// Retrieve entry and exit distance along a ray on the bbox of a tile node. The ray parameters must
 /// be transformed into the planet coordinate system before!
 bool intersectTileBounds(TileNode const* tileNode, VistaPlanet const* planet,
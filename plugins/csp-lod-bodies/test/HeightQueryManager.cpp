@@ -0,0 +1,215 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/HeightQueryManager.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/HEALPix.hpp"
+#include "../src/TileData.hpp"
+#include "../src/TileSource.hpp"
+#include "../src/TreeManager.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace csp::lodbodies {
+
+namespace {
+
+// A tile source which creates elevation tiles right away. Tiles beyond the given level are never
+// loaded.
+class TestTileSource : public TileSource {
+ public:
+  explicit TestTileSource(int maxLevel)
+      : mMaxLevel(maxLevel) {
+  }
+
+  void init() override {
+  }
+
+  void fini() override {
+  }
+
+  TileDataType getDataType() const override {
+    return TileDataType::eElevation;
+  }
+
+  std::shared_ptr<BaseTileData> loadTile(TileId const& tileId) override {
+    auto tile = std::make_shared<TileData<float>>(16);
+    std::fill(tile->data().begin(), tile->data().end(), static_cast<float>(tileId.level()));
+    return tile;
+  }
+
+  cs::utils::TaskHandle loadTileAsync(TileId const& tileId, OnLoadCallback cb) override {
+    if (tileId.level() <= mMaxLevel) {
+      cb(tileId, loadTile(tileId));
+    }
+    return {};
+  }
+
+  int getPendingRequests() override {
+    return 0;
+  }
+
+  bool isSame(TileSource const* other) const override {
+    return dynamic_cast<TestTileSource const*>(other) != nullptr;
+  }
+
+ private:
+  int mMaxLevel;
+};
+
+const glm::dvec2 POSITION(0.3, 0.4);
+
+bool isReady(std::future<std::vector<double>> const& future) {
+  return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// Returns the level of the deepest tile containing POSITION.
+int getLevel(TreeManager& treeMgr) {
+  int        rootIndex = HEALPix::convertLngLat2Base(POSITION);
+  glm::dvec2 relative  = HEALPix::convertBaseLngLat2XY(rootIndex, POSITION);
+  TileNode*  node      = treeMgr.getTree()->getRoot(rootIndex);
+
+  if (node == nullptr) {
+    return -1;
+  }
+
+  while (true) {
+    int       childIndex = (relative.x < 0.5 ? 0 : 1) + (relative.y < 0.5 ? 0 : 2);
+    TileNode* child      = node->getChild(childIndex);
+
+    if (child == nullptr) {
+      return node->getLevel();
+    }
+
+    relative = relative * 2.0 - glm::dvec2(childIndex % 2, childIndex / 2);
+    node     = child;
+  }
+}
+
+// Runs one frame in the same order as VistaPlanet::draw() does.
+void runFrame(TreeManager& treeMgr, HeightQueryManager& queries, int frameCount) {
+  treeMgr.setFrameCount(frameCount);
+  treeMgr.update();
+  queries.update(frameCount);
+  treeMgr.request(queries.getLoadNodes(), queries.getLoadPriorities());
+}
+
+} // namespace
+
+TEST_CASE("csp::lodbodies::HeightQueryManager") {
+  const int maxLevel = 3;
+
+  TestTileSource     source(maxLevel);
+  TreeManager        treeMgr(nullptr);
+  HeightQueryManager queries(treeMgr.getTree());
+
+  treeMgr.setSource(TileDataType::eElevation, &source);
+  queries.setMaxLevel(maxLevel);
+
+  auto handle = queries.query({POSITION});
+  auto future = std::move(handle.mHeights);
+  REQUIRE(future.valid());
+  REQUIRE(handle.mToken);
+  CHECK_EQ(queries.getQueryCount(), 1U);
+
+  // The root tile and one tile of each level are loaded one after another.
+  int frameCount = 0;
+  while (!isReady(future) && frameCount < 20) {
+    runFrame(treeMgr, queries, ++frameCount);
+  }
+
+  REQUIRE(isReady(future));
+  CHECK_EQ(queries.getQueryCount(), 0U);
+  CHECK_EQ(getLevel(treeMgr), maxLevel);
+
+  auto heights = future.get();
+  REQUIRE_EQ(heights.size(), 1U);
+  CHECK_EQ(heights[0], doctest::Approx(maxLevel));
+
+  SUBCASE("No future is returned if the tiles are loaded already") {
+    auto other = queries.query({POSITION});
+    CHECK_FALSE(other.mHeights.valid());
+    CHECK_FALSE(other.mToken);
+    CHECK_EQ(queries.getQueryCount(), 0U);
+  }
+
+  SUBCASE("Tiles are pruned once no query is pending") {
+    for (int i = 0; i < 20; ++i) {
+      runFrame(treeMgr, queries, ++frameCount);
+    }
+
+    CHECK_EQ(getLevel(treeMgr), 0);
+  }
+
+  SUBCASE("Stalled queries are fulfilled with the available heights") {
+    queries.setMaxLevel(maxLevel + 1);
+
+    handle = queries.query({POSITION});
+    future = std::move(handle.mHeights);
+    REQUIRE(future.valid());
+
+    int startFrame = frameCount;
+    while (!isReady(future) && frameCount < startFrame + 1000) {
+      runFrame(treeMgr, queries, ++frameCount);
+
+      // As long as the query is pending, its tiles are kept in the tree.
+      REQUIRE_EQ(getLevel(treeMgr), maxLevel);
+    }
+
+    REQUIRE(isReady(future));
+    CHECK_GT(frameCount - startFrame, 10);
+    CHECK_EQ(queries.getQueryCount(), 0U);
+    CHECK_EQ(future.get()[0], doctest::Approx(maxLevel));
+  }
+
+  SUBCASE("Superseded queries stop requesting tiles") {
+    queries.setMaxLevel(maxLevel + 1);
+
+    handle = queries.query({POSITION});
+    REQUIRE(handle.mToken);
+
+    runFrame(treeMgr, queries, ++frameCount);
+    CHECK_EQ(queries.getQueryCount(), 1U);
+    CHECK_FALSE(queries.getLoadNodes().empty());
+
+    // The tiles are requested with a lower priority than all tiles required for rendering.
+    REQUIRE_EQ(queries.getLoadPriorities().size(), queries.getLoadNodes().size());
+    TileRequestPriority renderPriority;
+    renderPriority.mScreenSpaceError = 1.0;
+    CHECK(queries.getLoadPriorities()[0] < renderPriority);
+
+    // A new query replaces the handle of the previous one, this cancels the previous query.
+    handle = queries.query({POSITION + glm::dvec2(0.001, 0.0)});
+    REQUIRE(handle.mToken);
+
+    runFrame(treeMgr, queries, ++frameCount);
+    CHECK_EQ(queries.getQueryCount(), 1U);
+
+    // Once the last handle is gone, no tiles are requested anymore.
+    handle = {};
+
+    runFrame(treeMgr, queries, ++frameCount);
+    CHECK_EQ(queries.getQueryCount(), 0U);
+    CHECK(queries.getLoadNodes().empty());
+  }
+
+  SUBCASE("Pending queries are fulfilled on destruction") {
+    auto other = std::make_unique<HeightQueryManager>(treeMgr.getTree());
+    other->setMaxLevel(maxLevel + 1);
+
+    handle = other->query({POSITION});
+    future = std::move(handle.mHeights);
+    REQUIRE(future.valid());
+
+    other.reset();
+    REQUIRE(isReady(future));
+    CHECK_EQ(future.get()[0], doctest::Approx(maxLevel));
+  }
+}
+
+} // namespace csp::lodbodies
@@ -0,0 +1,259 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../../src/cs-utils/convert.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/HEALPix.hpp"
+#include "../src/TileData.hpp"
+#include "../src/TileNode.hpp"
+#include "../src/TileQuadTree.hpp"
+#include "../src/utils.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace csp::lodbodies {
+
+namespace {
+
+const glm::dvec3 RADII(6378137.0, 6378137.0, 6356752.0);
+
+// The center of the polygon used in the tests. The tree is refined down to MAX_LEVEL around it.
+const glm::dvec2 POLYGON_CENTER(0.3, 0.4);
+const int        MAX_LEVEL = 6;
+
+// Creates a node with some synthetic elevation data which differs for each tile.
+TileNode* createNode(TileId const& tileId) {
+  const uint32_t resolution = 33;
+
+  auto tile = std::make_shared<TileData<float>>(resolution);
+
+  for (uint32_t y = 0; y < resolution; ++y) {
+    for (uint32_t x = 0; x < resolution; ++x) {
+      tile->data()[y * resolution + x] = static_cast<float>(
+          1000.0 * std::sin(0.37 * static_cast<double>(tileId.patchIdx()) + 0.2 * x) +
+          500.0 * std::cos(0.1 * tileId.level() + 0.3 * y));
+    }
+  }
+
+  auto* node = new TileNode(tileId);
+  node->setTileData(std::move(tile));
+
+  return node;
+}
+
+// Creates the children of the given node. The children of the root nodes are refined once more,
+// below that only the nodes containing the given position are refined further. The position is
+// given relative to the node.
+void refineNode(TileQuadTree& tree, TileNode* node, glm::dvec2 const& center) {
+  if (node->getLevel() >= MAX_LEVEL) {
+    return;
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    REQUIRE(insertNode(&tree, createNode(HEALPix::getChildTileId(node->getTileId(), i))));
+
+    glm::dvec2 childCenter = center * 2.0 - glm::dvec2(i % 2, i / 2);
+    bool       isInside    = childCenter.x >= 0.0 && childCenter.x < 1.0 && childCenter.y >= 0.0 &&
+                    childCenter.y < 1.0;
+
+    if (node->getLevel() < 1 || isInside) {
+      refineNode(tree, node->getChild(i), childCenter);
+    }
+  }
+}
+
+void createTree(TileQuadTree& tree) {
+  int rootIndex = HEALPix::convertLngLat2Base(POLYGON_CENTER);
+
+  for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+    tree.setRoot(i, createNode(TileId(0, i)));
+
+    glm::dvec2 center(-1.0);
+    if (i == rootIndex) {
+      center = HEALPix::convertBaseLngLat2XY(rootIndex, POLYGON_CENTER);
+    }
+
+    refineNode(tree, tree.getRoot(i), center);
+  }
+}
+
+// Returns the height at the given position by descending the tree for this position alone. The
+// elevation data is interpolated bilinearly; x refers to the column, y to the row.
+double getReferenceHeight(TileQuadTree const& tree, glm::dvec2 const& lngLat, bool descend) {
+  int        rootIndex = HEALPix::convertLngLat2Base(lngLat);
+  glm::dvec2 relative  = HEALPix::convertBaseLngLat2XY(rootIndex, lngLat);
+  TileNode*  node      = tree.getRoot(rootIndex);
+
+  while (descend) {
+    int       childIndex = (relative.x < 0.5 ? 0 : 1) + (relative.y < 0.5 ? 0 : 2);
+    TileNode* child      = node->getChild(childIndex);
+
+    if (child == nullptr) {
+      break;
+    }
+
+    relative = relative * 2.0 - glm::dvec2(childIndex % 2, childIndex / 2);
+    node     = child;
+  }
+
+  auto const& tile = node->getTileData(TileDataType::eElevation);
+  auto        size = static_cast<int>(tile->getResolution());
+  auto const* data = tile->getTypedPtr<float>();
+
+  glm::dvec2 xy = relative * static_cast<double>(size - 1);
+  int        x  = static_cast<int>(xy.x);
+  int        y  = static_cast<int>(xy.y);
+
+  auto at = [&](int dx, int dy) { return static_cast<double>(data[(y + dy) * size + x + dx]); };
+
+  double fx = xy.x - x;
+  double fy = xy.y - y;
+  return (1.0 - fy) * ((1.0 - fx) * at(0, 0) + fx * at(1, 0)) +
+         fy * ((1.0 - fx) * at(0, 1) + fx * at(1, 1));
+}
+
+// Creates the corners of a polygon around POLYGON_CENTER which is divided into the given number
+// of rows and columns of quads. Each quad consists of two triangles.
+std::vector<glm::dvec2> createTriangles(int rows, int columns, double size) {
+  std::vector<glm::dvec2> corners;
+
+  auto getCorner = [&](int row, int column) {
+    return POLYGON_CENTER + size * glm::dvec2(static_cast<double>(column) / columns - 0.5,
+                                       static_cast<double>(row) / rows - 0.5);
+  };
+
+  for (int row = 0; row < rows; ++row) {
+    for (int column = 0; column < columns; ++column) {
+      for (auto const& [r, c] : {std::pair(0, 0), std::pair(0, 1), std::pair(1, 1),
+               std::pair(0, 0), std::pair(1, 1), std::pair(1, 0)}) {
+        corners.push_back(getCorner(row + r, column + c));
+      }
+    }
+  }
+
+  return corners;
+}
+
+// Sums up the volumes of the prisms between the surface of the ellipsoid and the terrain below
+// each triangle, similar to the PolygonTool of csp-measurement-tools.
+double computeVolume(std::vector<glm::dvec2> const& corners, std::vector<double> const& heights) {
+  double volume = 0.0;
+
+  for (std::size_t i = 0; i < corners.size(); i += 3) {
+    glm::dvec3 p1 = cs::utils::convert::toCartesian(corners[i], RADII, 0.0);
+    glm::dvec3 p2 = cs::utils::convert::toCartesian(corners[i + 1], RADII, 0.0);
+    glm::dvec3 p3 = cs::utils::convert::toCartesian(corners[i + 2], RADII, 0.0);
+
+    double baseArea = glm::length(glm::cross(p2 - p1, p3 - p1)) / 2;
+    volume += baseArea * (heights[i] + heights[i + 1] + heights[i + 2]) / 3;
+  }
+
+  return volume;
+}
+
+} // namespace
+
+TEST_CASE("csp::lodbodies::utils::getHeights") {
+  TileQuadTree tree;
+  createTree(tree);
+
+  // Random positions all over the planet and more densely around the refined tiles. There are
+  // enough positions, so that they are processed on multiple threads.
+  std::mt19937                           generator(42);
+  std::uniform_real_distribution<double> lng(-glm::pi<double>(), glm::pi<double>());
+  std::uniform_real_distribution<double> lat(-0.5 * glm::pi<double>(), 0.5 * glm::pi<double>());
+  std::uniform_real_distribution<double> offset(-0.05, 0.05);
+
+  std::vector<glm::dvec2> lngLats;
+
+  for (int i = 0; i < 10000; ++i) {
+    lngLats.emplace_back(lng(generator), lat(generator));
+    lngLats.push_back(POLYGON_CENTER + glm::dvec2(offset(generator), offset(generator)));
+  }
+
+  std::vector<double> heights(lngLats.size());
+
+  SUBCASE("Actual precision") {
+    utils::getHeights(
+        &tree, HeightSamplePrecision::eActual, lngLats.data(), heights.data(), lngLats.size());
+
+    for (std::size_t i = 0; i < lngLats.size(); ++i) {
+      CHECK(heights[i] == doctest::Approx(getReferenceHeight(tree, lngLats[i], true)));
+    }
+  }
+
+  SUBCASE("Coarse precision") {
+    utils::getHeights(
+        &tree, HeightSamplePrecision::eCoarse, lngLats.data(), heights.data(), lngLats.size());
+
+    for (std::size_t i = 0; i < lngLats.size(); ++i) {
+      CHECK(heights[i] == doctest::Approx(getReferenceHeight(tree, lngLats[i], false)));
+    }
+  }
+
+  SUBCASE("Single positions") {
+    utils::getHeights(
+        &tree, HeightSamplePrecision::eActual, lngLats.data(), heights.data(), lngLats.size());
+
+    // A batch gives exactly the same results as sampling each position on its own.
+    for (std::size_t i = 0; i < lngLats.size(); ++i) {
+      double height{};
+      utils::getHeights(&tree, HeightSamplePrecision::eActual, &lngLats[i], &height, 1);
+      CHECK_EQ(heights[i], height);
+    }
+  }
+}
+
+TEST_CASE("csp::lodbodies::utils::getHeights polygon volume [benchmark]") {
+  TileQuadTree tree;
+  createTree(tree);
+
+  // 100 x 50 quads result in 10k triangles.
+  auto corners = createTriangles(50, 100, 0.05);
+
+  const int repetitions = 20;
+
+  std::vector<double> heights(corners.size());
+
+  // First, each corner is sampled on its own, like the measurement tools used to do it.
+  auto   start        = std::chrono::high_resolution_clock::now();
+  double singleVolume = 0.0;
+
+  for (int r = 0; r < repetitions; ++r) {
+    for (std::size_t i = 0; i < corners.size(); ++i) {
+      utils::getHeights(&tree, HeightSamplePrecision::eActual, &corners[i], &heights[i], 1);
+    }
+
+    singleVolume = computeVolume(corners, heights);
+  }
+
+  std::chrono::duration<double, std::milli> singleDuration =
+      std::chrono::high_resolution_clock::now() - start;
+
+  // Then, all corners are sampled in one batch.
+  start              = std::chrono::high_resolution_clock::now();
+  double batchVolume = 0.0;
+
+  for (int r = 0; r < repetitions; ++r) {
+    utils::getHeights(
+        &tree, HeightSamplePrecision::eActual, corners.data(), heights.data(), corners.size());
+
+    batchVolume = computeVolume(corners, heights);
+  }
+
+  std::chrono::duration<double, std::milli> batchDuration =
+      std::chrono::high_resolution_clock::now() - start;
+
+  CHECK_EQ(singleVolume, batchVolume);
+
+  MESSAGE("single positions: ", singleDuration.count() / repetitions, " ms, batched: ",
+      batchDuration.count() / repetitions, " ms");
+}
+
+} // namespace csp::lodbodies
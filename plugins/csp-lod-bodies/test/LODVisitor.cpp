@@ -0,0 +1,212 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/LODVisitor.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/MinMaxPyramid.hpp"
+#include "../src/PlanetParameters.hpp"
+#include "../src/TileData.hpp"
+#include "../src/TileNode.hpp"
+#include "../src/TileQuadTree.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace csp::lodbodies {
+
+namespace {
+
+using TraversalMode = LODVisitor::TraversalMode;
+
+// Creates a node with some synthetic elevation data. The data is marked as being uploaded to the
+// GPU, so that the LODVisitor considers the node to be available.
+TileNode* createNode(TileId const& tileId) {
+  auto tile = std::make_shared<TileData<float>>(16);
+
+  for (std::size_t i = 0; i < tile->data().size(); ++i) {
+    tile->data()[i] = static_cast<float>(
+        2000.0 * std::sin(0.37 * static_cast<double>(tileId.patchIdx()) + 0.1 * i));
+  }
+
+  tile->setTexLayer(0);
+
+  auto* node = new TileNode(tileId);
+  node->setMinMaxPyramid(std::make_unique<MinMaxPyramid>(tile.get()));
+  node->setTileData(std::move(tile));
+
+  return node;
+}
+
+// Inserts nodes for all tiles requested by the visitor. Returns false if nothing was requested.
+bool loadRequestedTiles(LODVisitor const& visitor, TileQuadTree& tree) {
+  for (auto const& tileId : visitor.getLoadNodes()) {
+    REQUIRE(insertNode(&tree, createNode(tileId)));
+  }
+
+  return !visitor.getLoadNodes().empty();
+}
+
+// Generates the modelview matrices of a camera flight from a distant orbit down to a low altitude
+// above an Earth-sized body. The camera looks at the surface slightly ahead of its position.
+std::vector<glm::dmat4> createCameraPath(int frameCount, double radius) {
+  std::vector<glm::dmat4> path;
+
+  for (int i = 0; i < frameCount; ++i) {
+    double t        = static_cast<double>(i) / (frameCount - 1);
+    double altitude = radius * std::pow(10.0, 0.5 - 4.0 * t);
+    double lng      = 1.5 * t;
+    double lat      = 0.3 + 0.4 * t;
+
+    auto direction = [lat](double lng) {
+      return glm::dvec3(
+          std::cos(lat) * std::sin(lng), std::sin(lat), std::cos(lat) * std::cos(lng));
+    };
+
+    glm::dvec3 position = (radius + altitude) * direction(lng);
+    glm::dvec3 target   = radius * direction(lng + 0.1);
+
+    path.push_back(glm::lookAt(position, target, glm::dvec3(0.0, 1.0, 0.0)));
+  }
+
+  return path;
+}
+
+glm::dmat4 createProjection() {
+  return glm::perspective(glm::radians(60.0), 16.0 / 9.0, 1.0, 1e9);
+}
+
+PlanetParameters createParameters(int maxLevel, double lodFactor) {
+  PlanetParameters params;
+  params.mRadii     = glm::dvec3(6378137.0, 6378137.0, 6356752.0);
+  params.mLodFactor = lodFactor;
+  params.mMaxLevel  = maxLevel;
+  return params;
+}
+
+// Creates the root nodes and refines the tree until all tiles required along the given camera path
+// are loaded.
+void loadTree(TileQuadTree& tree, PlanetParameters const& params,
+    std::vector<glm::dmat4> const& path, glm::dmat4 const& projection) {
+  for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+    tree.setRoot(i, createNode(TileId(0, i)));
+  }
+
+  LODVisitor visitor(params, &tree);
+  visitor.setProjection(projection);
+
+  for (auto const& modelview : path) {
+    visitor.setModelview(modelview);
+
+    do {
+      visitor.visit();
+    } while (loadRequestedTiles(visitor, tree));
+  }
+}
+
+// Returns the time in microseconds the given visitor needs on average for traversing the tree once
+// for each frame of the path.
+double measureTraversal(LODVisitor& visitor, std::vector<glm::dmat4> const& path, int repetitions) {
+  auto start = std::chrono::high_resolution_clock::now();
+
+  for (int r = 0; r < repetitions; ++r) {
+    for (auto const& modelview : path) {
+      visitor.setModelview(modelview);
+      visitor.visit();
+    }
+  }
+
+  std::chrono::duration<double, std::micro> duration =
+      std::chrono::high_resolution_clock::now() - start;
+  return duration.count() / static_cast<double>(path.size() * repetitions);
+}
+
+} // namespace
+
+TEST_CASE("csp::lodbodies::LODVisitor traversal modes") {
+  auto params     = createParameters(8, 40.0);
+  auto path       = createCameraPath(30, params.mRadii.x);
+  auto projection = createProjection();
+
+  TileQuadTree tree;
+  for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+    tree.setRoot(i, createNode(TileId(0, i)));
+  }
+
+  LODVisitor recursive(params, &tree);
+  LODVisitor batched(params, &tree);
+  LODVisitor parallel(params, &tree);
+
+  recursive.setTraversalMode(TraversalMode::eRecursive);
+  batched.setTraversalMode(TraversalMode::eBatched);
+  parallel.setTraversalMode(TraversalMode::eParallel);
+
+  std::size_t renderedNodes = 0;
+
+  // The tree grows while the camera moves along the path. Hence, all modes are tested with
+  // partially loaded trees as well.
+  for (auto const& modelview : path) {
+    for (int i = 0; i < 5; ++i) {
+      for (auto* visitor : {&recursive, &batched, &parallel}) {
+        visitor->setProjection(projection);
+        visitor->setModelview(modelview);
+        visitor->visit();
+      }
+
+      for (auto* visitor : {&batched, &parallel}) {
+        REQUIRE_EQ(visitor->getRenderNodes(), recursive.getRenderNodes());
+        REQUIRE_EQ(visitor->getLoadNodes(), recursive.getLoadNodes());
+        REQUIRE_EQ(visitor->getLoadPriorities().size(), recursive.getLoadPriorities().size());
+
+        for (std::size_t j = 0; j < recursive.getLoadPriorities().size(); ++j) {
+          CHECK_EQ(visitor->getLoadPriorities()[j].mScreenSpaceError,
+              recursive.getLoadPriorities()[j].mScreenSpaceError);
+          CHECK_EQ(visitor->getLoadPriorities()[j].mDistance,
+              recursive.getLoadPriorities()[j].mDistance);
+        }
+      }
+
+      renderedNodes += recursive.getRenderNodes().size();
+
+      if (!loadRequestedTiles(recursive, tree)) {
+        break;
+      }
+    }
+  }
+
+  // Make sure that the test actually covers some refinement.
+  CHECK_GT(renderedNodes, path.size() * TileQuadTree::sNumRoots);
+}
+
+TEST_CASE("csp::lodbodies::LODVisitor traversal [benchmark]") {
+  const int repetitions = 20;
+
+  auto params     = createParameters(15, 40.0);
+  auto path       = createCameraPath(200, params.mRadii.x);
+  auto projection = createProjection();
+
+  TileQuadTree tree;
+  loadTree(tree, params, path, projection);
+
+  std::array<double, 3> durations{};
+  std::size_t           renderNodes = 0;
+
+  for (auto mode : {TraversalMode::eRecursive, TraversalMode::eBatched, TraversalMode::eParallel}) {
+    LODVisitor visitor(params, &tree);
+    visitor.setProjection(projection);
+    visitor.setTraversalMode(mode);
+
+    durations.at(static_cast<std::size_t>(mode)) = measureTraversal(visitor, path, repetitions);
+    renderNodes                                  = visitor.getRenderNodes().size();
+  }
+
+  MESSAGE("LOD traversal (", renderNodes, " tiles in the last frame): recursive ",
+      static_cast<int>(durations[0]), " us, batched ", static_cast<int>(durations[1]),
+      " us, parallel ", static_cast<int>(durations[2]), " us per frame");
+}
+
+} // namespace csp::lodbodies
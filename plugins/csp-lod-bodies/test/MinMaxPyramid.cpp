@@ -0,0 +1,359 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/MinMaxPyramid.hpp"
+#include "../../../src/cs-utils/convert.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/HEALPix.hpp"
+#include "../src/TileBounds.hpp"
+#include "../src/TileData.hpp"
+#include "../src/TileNode.hpp"
+#include "../src/utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace csp::lodbodies {
+
+namespace {
+
+const glm::dvec3 RADII(6378137.0, 6378137.0, 6356752.0);
+
+// Creates an elevation tile with a sum of sine waves of different frequencies. If roughness is
+// zero, the tile is flat.
+std::shared_ptr<TileData<float>> createTile(uint32_t resolution, double roughness, int seed) {
+  auto tile = std::make_shared<TileData<float>>(resolution);
+
+  for (uint32_t y = 0; y < resolution; ++y) {
+    for (uint32_t x = 0; x < resolution; ++x) {
+      double height = 500.0;
+
+      for (int octave = 0; octave < 6; ++octave) {
+        double frequency = std::pow(2.0, octave) * 0.02;
+        height += roughness * 2000.0 / std::pow(2.0, octave) *
+                  std::sin(frequency * x + 0.7 * octave + seed) *
+                  std::cos(frequency * y + 1.3 * octave - seed);
+      }
+
+      tile->data()[y * resolution + x] = static_cast<float>(height);
+    }
+  }
+
+  return tile;
+}
+
+// Creates a node with the given elevation data, its MinMaxPyramid and its bounds.
+std::unique_ptr<TileNode> createNode(TileId const& tileId, std::shared_ptr<TileData<float>> tile) {
+  auto node = std::make_unique<TileNode>(tileId);
+  node->setMinMaxPyramid(std::make_unique<MinMaxPyramid>(tile.get()));
+  node->setTileData(std::move(tile));
+  node->setBounds(calcTileBounds(*node, RADII, 1.0));
+  return node;
+}
+
+// Returns the position of the given point relative to the given tile. The tile covers [0, 1]².
+glm::dvec2 getTileCoordinates(TileNode const& node, glm::dvec3 const& position) {
+  auto       scale  = HEALPix::getPatchOffsetScale(node.getTileId());
+  glm::dvec2 lngLat = cs::utils::convert::cartesianToLngLat(position, RADII);
+  glm::dvec2 xy = HEALPix::convertBaseLngLat2XY(HEALPix::getBasePatch(node.getTileId()), lngLat);
+  return (xy - glm::dvec2(scale.x, scale.y)) / scale.z;
+}
+
+// Returns the bilinearly interpolated terrain height below the given position. This is used as
+// reference for the intersections.
+double getTerrainHeight(TileNode const& node, glm::dvec3 const& position) {
+  auto const& tile = node.getTileData(TileDataType::eElevation);
+  auto        size = static_cast<int>(tile->getResolution());
+
+  glm::dvec2 xy = glm::clamp(getTileCoordinates(node, position), 0.0, 1.0);
+  xy *= static_cast<double>(size - 1);
+
+  int x = std::min(static_cast<int>(xy.x), size - 2);
+  int y = std::min(static_cast<int>(xy.y), size - 2);
+
+  auto const* data = tile->getTypedPtr<float>();
+  auto        at   = [&](int dx, int dy) { return data[(y + dy) * size + x + dx]; };
+
+  double fx = xy.x - x;
+  double fy = xy.y - y;
+  return (1.0 - fy) * ((1.0 - fx) * at(0, 0) + fx * at(1, 0)) +
+         fy * ((1.0 - fx) * at(0, 1) + fx * at(1, 1));
+}
+
+// Returns a position on the ellipsoid at the given relative coordinates inside the tile.
+glm::dvec3 getSurfacePoint(TileId const& tileId, double u, double v, double height) {
+  auto       scale  = HEALPix::getPatchOffsetScale(tileId);
+  glm::dvec2 lngLat = HEALPix::convertBaseXY2LngLat(
+      HEALPix::getBasePatch(tileId), scale.x + u * scale.z, scale.y + v * scale.z);
+  return cs::utils::convert::toCartesian(lngLat, RADII, height);
+}
+
+struct Ray {
+  glm::dvec3 mOrigin;
+  glm::dvec3 mDirection;
+  double     mTMin{};
+  double     mTMax{};
+};
+
+// Creates rays which start high above the given tile and point towards random positions on the
+// tile at varying angles. The rays are clipped to the bounds of the tile.
+std::vector<Ray> createRays(TileNode const& node, int count) {
+  std::mt19937                           generator(42);
+  std::uniform_real_distribution<double> position(0.1, 0.9);
+  std::uniform_real_distribution<double> offset(-0.05, 0.05);
+
+  std::vector<Ray> rays;
+
+  for (int i = 0; i < count; ++i) {
+    double u = position(generator);
+    double v = position(generator);
+
+    glm::dvec3 target = getSurfacePoint(node.getTileId(), u, v, 0.0);
+    glm::dvec3 origin = getSurfacePoint(
+        node.getTileId(), u + offset(generator), v + offset(generator), 20000.0);
+
+    Ray ray{origin, glm::normalize(target - origin)};
+
+    if (utils::intersectTileBounds(&node, nullptr, glm::dvec4(ray.mOrigin, 1.0),
+            glm::dvec4(ray.mDirection, 0.0), ray.mTMin, ray.mTMax)) {
+      ray.mTMin = std::max(0.0, ray.mTMin);
+      rays.push_back(ray);
+    }
+  }
+
+  return rays;
+}
+
+// Intersects the ray by sampling it with a fixed number of steps per texel, like intersectPlanet()
+// did before the MinMaxPyramid was used. Samples outside of the tile are skipped.
+bool intersectBySampling(TileNode const& node, Ray const& ray, double& t) {
+  auto   size       = node.getTileData(TileDataType::eElevation)->getResolution();
+  auto   bounds     = node.getBounds();
+  double stepFactor = (ray.mTMax - ray.mTMin) / glm::length(bounds.getMax() - bounds.getMin());
+  int    steps      = static_cast<int>(stepFactor * 2.0 * size);
+
+  for (int i = 0; i <= steps; ++i) {
+    double     sampleT  = ray.mTMin + (ray.mTMax - ray.mTMin) * i / steps;
+    glm::dvec3 position = ray.mOrigin + sampleT * ray.mDirection;
+    double     altitude = cs::utils::convert::cartesianToLngLatHeight(position, RADII).z;
+    glm::dvec2 xy       = getTileCoordinates(node, position);
+
+    if (xy.x < 0.0 || xy.y < 0.0 || xy.x > 1.0 || xy.y > 1.0) {
+      continue;
+    }
+
+    if (altitude < getTerrainHeight(node, position)) {
+      t = sampleT;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+} // namespace
+
+TEST_CASE("csp::lodbodies::MinMaxPyramid") {
+  for (uint32_t resolution : {2U, 16U, 17U, 65U}) {
+    auto          tile = createTile(resolution, 1.0, 1);
+    MinMaxPyramid pyramid(tile.get());
+
+    REQUIRE_EQ(pyramid.getLevelSize(0), resolution - 1);
+    REQUIRE_EQ(pyramid.getLevelSize(pyramid.getLevelCount() - 1), 1U);
+
+    // Each cell has to contain the bounds of all samples of the quads it covers.
+    for (uint32_t level = 0; level < pyramid.getLevelCount(); ++level) {
+      uint32_t cellSize = 1U << level;
+
+      for (uint32_t y = 0; y < pyramid.getLevelSize(level); ++y) {
+        for (uint32_t x = 0; x < pyramid.getLevelSize(level); ++x) {
+          float    minValue = std::numeric_limits<float>::max();
+          float    maxValue = std::numeric_limits<float>::lowest();
+          uint32_t lastX    = std::min((x + 1) * cellSize, resolution - 1);
+          uint32_t lastY    = std::min((y + 1) * cellSize, resolution - 1);
+
+          for (uint32_t j = y * cellSize; j <= lastY; ++j) {
+            for (uint32_t i = x * cellSize; i <= lastX; ++i) {
+              minValue = std::min(minValue, tile->data()[j * resolution + i]);
+              maxValue = std::max(maxValue, tile->data()[j * resolution + i]);
+            }
+          }
+
+          CHECK_EQ(pyramid.getMin(level, x, y), minValue);
+          CHECK_EQ(pyramid.getMax(level, x, y), maxValue);
+        }
+      }
+    }
+
+    auto minmax = std::minmax_element(tile->data().begin(), tile->data().end());
+    CHECK_EQ(pyramid.getMin(), *minmax.first);
+    CHECK_EQ(pyramid.getMax(), *minmax.second);
+
+    // The range queries have to be conservative.
+    uint32_t last = resolution - 2;
+    CHECK_LE(pyramid.getMinInRange(0, 0, last, last), pyramid.getMin());
+    CHECK_GE(pyramid.getMaxInRange(last / 2, 0, last, last / 2), pyramid.getMax(0, last, 0));
+  }
+}
+
+TEST_CASE("csp::lodbodies::utils::intersectTile") {
+  TileId tileId(6, 4 * 64 * 64 + 1000);
+
+  SUBCASE("flat tile") {
+    auto node = createNode(tileId, createTile(33, 0.0, 0));
+
+    for (auto const& ray : createRays(*node, 100)) {
+      double t{};
+      REQUIRE(utils::intersectTile(
+          node.get(), RADII, 1.0, ray.mOrigin, ray.mDirection, ray.mTMin, ray.mTMax, t));
+
+      glm::dvec3 position = ray.mOrigin + t * ray.mDirection;
+      double     altitude = cs::utils::convert::cartesianToLngLatHeight(position, RADII).z;
+      CHECK_LT(std::abs(altitude - 500.0), 0.1);
+    }
+  }
+
+  SUBCASE("rough tile") {
+    auto node = createNode(tileId, createTile(257, 1.0, 2));
+
+    for (auto const& ray : createRays(*node, 200)) {
+      double t{};
+      double reference{};
+
+      // The sampling may miss thin ridges which the traversal finds. Hence, the traversal has to
+      // find an intersection whenever the sampling finds one and it must not be behind it.
+      if (intersectBySampling(*node, ray, reference)) {
+        REQUIRE(utils::intersectTile(
+            node.get(), RADII, 1.0, ray.mOrigin, ray.mDirection, ray.mTMin, ray.mTMax, t));
+
+        glm::dvec3 position = ray.mOrigin + t * ray.mDirection;
+        double     altitude = cs::utils::convert::cartesianToLngLatHeight(position, RADII).z;
+        CHECK_LT(std::abs(altitude - getTerrainHeight(*node, position)), 0.1);
+        CHECK_LE(t, reference + 0.1);
+      }
+    }
+  }
+
+  SUBCASE("ray above terrain") {
+    auto node = createNode(tileId, createTile(65, 1.0, 3));
+
+    glm::dvec3 origin    = getSurfacePoint(tileId, 0.1, 0.1, 10000.0);
+    glm::dvec3 target    = getSurfacePoint(tileId, 0.9, 0.9, 10000.0);
+    glm::dvec3 direction = glm::normalize(target - origin);
+
+    double t{};
+    CHECK_UNARY_FALSE(utils::intersectTile(
+        node.get(), RADII, 1.0, origin, direction, 0.0, glm::length(target - origin), t));
+  }
+
+  SUBCASE("ray hitting the edge between two tiles") {
+
+    // Find the tile of the same base patch which shares the edge at u = 1 with the first tile.
+    auto   scale = HEALPix::getPatchOffsetScale(tileId);
+    TileId neighbourId;
+    bool   found = false;
+
+    for (int i = 0; i < 64 * 64 && !found; ++i) {
+      neighbourId = TileId(6, 4 * 64 * 64 + i);
+      auto other  = HEALPix::getPatchOffsetScale(neighbourId);
+      found =
+          std::abs(other.x - scale.x - scale.z) < 1e-9 && std::abs(other.y - scale.y) < 1e-9;
+    }
+
+    REQUIRE(found);
+
+    std::array<std::unique_ptr<TileNode>, 2> nodes = {createNode(tileId, createTile(33, 0.0, 0)),
+        createNode(neighbourId, createTile(33, 0.0, 0))};
+
+    std::mt19937                           generator(7);
+    std::uniform_real_distribution<double> across(-1e-3, 1e-3);
+    std::uniform_real_distribution<double> along(0.2, 0.8);
+
+    for (int i = 0; i < 100; ++i) {
+      double     v      = along(generator);
+      glm::dvec3 target = getSurfacePoint(tileId, 1.0 + across(generator), v, 500.0);
+      glm::dvec3 origin = getSurfacePoint(tileId, i % 2 == 0 ? 0.95 : 1.05, v, 20000.0);
+      glm::dvec3 direction = glm::normalize(target - origin);
+
+      // Each tile only reports intersections on its own side of the edge. Hence, at least one of
+      // the tiles has to find the intersection.
+      int hits = 0;
+
+      for (auto const& node : nodes) {
+        double tMin{};
+        double tMax{};
+        double t{};
+
+        if (utils::intersectTileBounds(node.get(), nullptr, glm::dvec4(origin, 1.0),
+                glm::dvec4(direction, 0.0), tMin, tMax) &&
+            utils::intersectTile(
+                node.get(), RADII, 1.0, origin, direction, std::max(0.0, tMin), tMax, t)) {
+          glm::dvec3 position = origin + t * direction;
+          double     altitude = cs::utils::convert::cartesianToLngLatHeight(position, RADII).z;
+          CHECK_LT(std::abs(altitude - 500.0), 0.1);
+          CHECK_LT(glm::length(position - target), 1.0);
+          ++hits;
+        }
+      }
+
+      CHECK_GE(hits, 1);
+    }
+  }
+}
+
+TEST_CASE("csp::lodbodies::MinMaxPyramid build and ray traversal [benchmark]") {
+  const int tileCount = 64;
+
+  std::vector<std::shared_ptr<TileData<float>>> tiles;
+  for (int i = 0; i < tileCount; ++i) {
+    tiles.push_back(createTile(257, 1.0, i));
+  }
+
+  auto start = std::chrono::high_resolution_clock::now();
+
+  for (auto const& tile : tiles) {
+    MinMaxPyramid pyramid(tile.get());
+  }
+
+  std::chrono::duration<double, std::micro> buildTime =
+      std::chrono::high_resolution_clock::now() - start;
+
+  auto node = createNode(TileId(6, 4 * 64 * 64 + 1000), tiles.front());
+  auto rays = createRays(*node, 2000);
+
+  auto measureRays = [&rays](auto const& intersect) {
+    auto        start = std::chrono::high_resolution_clock::now();
+    std::size_t hits  = 0;
+
+    for (auto const& ray : rays) {
+      double t{};
+      hits += intersect(ray, t) ? 1 : 0;
+    }
+
+    std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+    return std::make_pair(static_cast<double>(rays.size()) / duration.count(), hits);
+  };
+
+  auto pyramidRays = measureRays([&node](Ray const& ray, double& t) {
+    return utils::intersectTile(
+        node.get(), RADII, 1.0, ray.mOrigin, ray.mDirection, ray.mTMin, ray.mTMax, t);
+  });
+
+  auto samplingRays = measureRays(
+      [&node](Ray const& ray, double& t) { return intersectBySampling(*node, ray, t); });
+
+  MESSAGE("MinMaxPyramid build (257x257): ", buildTime.count() / tileCount, " us per tile");
+  MESSAGE("Ray traversal: ", static_cast<int>(pyramidRays.first), " rays/s with MinMaxPyramid, ",
+      static_cast<int>(samplingRays.first), " rays/s with fixed sampling (", pyramidRays.second,
+      " / ", samplingRays.second, " hits)");
+}
+
+} // namespace csp::lodbodies
@@ -0,0 +1,194 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/RawTileCache.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/HEALPix.hpp"
+#include "../src/TileData.hpp"
+#include "../src/TileSourceWebMapService.hpp"
+
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cmath>
+
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <tiffio.h>
+
+namespace csp::lodbodies {
+
+namespace {
+
+boost::filesystem::path createTempDirectory() {
+  return boost::filesystem::temp_directory_path() /
+         boost::filesystem::unique_path("csp-lod-bodies-test-%%%%-%%%%");
+}
+
+// Writes a smoothly varying image of the given type and resolution to the map cache of the given
+// data set in the same format the map server would provide. Elevation data is written as 32-bit
+// float TIFF, color data as RGBA PNG.
+void writeCacheFile(
+    std::string const& file, TileDataType type, uint32_t resolution, int x, int y) {
+  boost::filesystem::create_directories(boost::filesystem::path(file).parent_path());
+
+  auto value = [&](uint32_t i, uint32_t j) {
+    return std::sin(0.1 * (x * resolution + i)) * std::cos(0.07 * (y * resolution + j));
+  };
+
+  if (type == TileDataType::eElevation) {
+    TIFF* tiff = TIFFOpen(file.c_str(), "w");
+    TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, resolution);
+    TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, resolution);
+    TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+    TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 32);
+    TIFFSetField(tiff, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
+    TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+    TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, resolution);
+
+    std::vector<float> row(resolution);
+    for (uint32_t j = 0; j < resolution; ++j) {
+      for (uint32_t i = 0; i < resolution; ++i) {
+        row[i] = static_cast<float>(1000.0 * value(i, j));
+      }
+      TIFFWriteScanline(tiff, row.data(), j, 0);
+    }
+
+    TIFFClose(tiff);
+  } else {
+    std::vector<glm::u8vec4> pixels(resolution * resolution);
+    for (uint32_t j = 0; j < resolution; ++j) {
+      for (uint32_t i = 0; i < resolution; ++i) {
+        auto gray                  = static_cast<uint8_t>(100.0 + 50.0 * value(i, j));
+        pixels[j * resolution + i] = glm::u8vec4(gray, gray, gray / 2, 255);
+      }
+    }
+
+    stbi_write_png(file.c_str(), static_cast<int>(resolution), static_cast<int>(resolution), 4,
+        pixels.data(), static_cast<int>(resolution * 4));
+  }
+}
+
+// Loads all tiles of the given level from the given source and returns the achieved tiles per
+// second.
+double measureLoading(TileSourceWebMapService& source, int level, int repetitions) {
+  auto tileCount = HEALPix::getLevel(level).getTotalPatchCount();
+  auto start     = std::chrono::high_resolution_clock::now();
+
+  for (int r = 0; r < repetitions; ++r) {
+    for (glm::int64 i = 0; i < tileCount; ++i) {
+      REQUIRE(source.loadTile(TileId(level, i)));
+    }
+  }
+
+  std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+  return static_cast<double>(tileCount * repetitions) / duration.count();
+}
+
+} // namespace
+
+TEST_CASE("csp::lodbodies::RawTileCache") {
+  auto directory = createTempDirectory();
+
+  TileData<glm::u8vec4> tile(16);
+  for (std::size_t i = 0; i < tile.data().size(); ++i) {
+    tile.data()[i] = glm::u8vec4(i % 3, i % 5, i % 7, 255);
+  }
+
+  for (bool compress : {false, true}) {
+    RawTileCache cache(directory.string(), TileDataType::eColor, 16, compress);
+    int          y = compress ? 1 : 0;
+
+    CHECK_UNARY_FALSE(cache.read(2, 1, y));
+
+    cache.write(2, 1, y, tile);
+    auto result = std::dynamic_pointer_cast<TileData<glm::u8vec4>>(cache.read(2, 1, y));
+
+    REQUIRE(result);
+    CHECK_UNARY(result->data() == tile.data());
+  }
+
+  // A tile written with a different resolution is treated like a missing one and is removed.
+  {
+    RawTileCache cache(directory.string(), TileDataType::eColor, 8, true);
+    CHECK_UNARY_FALSE(cache.read(2, 1, 0));
+    CHECK_THROWS_AS(cache.write(2, 1, 0, tile), std::invalid_argument);
+  }
+
+  {
+    RawTileCache cache(directory.string(), TileDataType::eColor, 16, true);
+    CHECK_UNARY_FALSE(cache.read(2, 1, 0));
+    CHECK_UNARY(cache.read(2, 1, 1));
+  }
+
+  boost::filesystem::remove_all(directory);
+}
+
+TEST_CASE("csp::lodbodies::RawTileCache decoding [benchmark]") {
+  const int level       = 2;
+  const int repetitions = 5;
+
+  for (auto type : {TileDataType::eElevation, TileDataType::eColor}) {
+    auto        directory  = createTempDirectory();
+    uint32_t    resolution = type == TileDataType::eElevation ? 128 : 512;
+    std::string dataset    = "benchmarkx" + std::to_string(resolution);
+
+    auto createSource = [&](bool rawCache, bool compress) {
+      auto source = std::make_unique<TileSourceWebMapService>(resolution);
+      source->setCacheDirectory(directory.string());
+      source->setLayers("benchmark");
+      source->setUrl("offline");
+      source->setDataType(type);
+      source->setRawCache(rawCache);
+      source->setRawCacheCompression(compress);
+      return source;
+    };
+
+    // Populate the map cache with the files the map server would have provided. Tiles on the
+    // diagonal of base patch 4 consist of two images.
+    auto writeTile = [&](int x, int y) {
+      auto file = directory / dataset / std::to_string(level) / std::to_string(x) /
+                  (std::to_string(y) + (type == TileDataType::eElevation ? ".tiff" : ".png"));
+      writeCacheFile(file.string(), type, resolution, x, y);
+    };
+
+    for (glm::int64 i = 0; i < HEALPix::getLevel(level).getTotalPatchCount(); ++i) {
+      int x{};
+      int y{};
+      if (TileSourceWebMapService::getXY(TileId(level, i), x, y)) {
+        writeTile(x + 4 * (1 << level), y - 4 * (1 << level));
+      }
+      writeTile(x, y);
+    }
+
+    double decode = measureLoading(*createSource(false, false), level, repetitions);
+
+    double raw = 0.0;
+    double lz4 = 0.0;
+
+    for (bool compress : {false, true}) {
+      auto source = createSource(true, compress);
+
+      // The first pass fills the raw cache.
+      measureLoading(*source, level, 1);
+      (compress ? lz4 : raw) = measureLoading(*source, level, repetitions);
+
+      source.reset();
+      boost::filesystem::remove_all(directory / dataset / "raw");
+    }
+
+    MESSAGE(type == TileDataType::eElevation ? "Elevation" : "Color", " tiles (", resolution, "x",
+        resolution, "): decode ", static_cast<int>(decode), " tiles/s, raw ",
+        static_cast<int>(raw), " tiles/s, raw + LZ4 ", static_cast<int>(lz4), " tiles/s");
+
+    boost::filesystem::remove_all(directory);
+  }
+}
+
+} // namespace csp::lodbodies
@@ -0,0 +1,169 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/ResidencyManager.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/HEALPix.hpp"
+#include "../src/TileData.hpp"
+#include "../src/TileSource.hpp"
+#include "../src/TreeManager.hpp"
+
+#include <algorithm>
+
+namespace csp::lodbodies {
+
+namespace {
+
+// A tile source which creates flat elevation tiles right away.
+class TestTileSource : public TileSource {
+ public:
+  void init() override {
+  }
+
+  void fini() override {
+  }
+
+  TileDataType getDataType() const override {
+    return TileDataType::eElevation;
+  }
+
+  std::shared_ptr<BaseTileData> loadTile(TileId const& /*tileId*/) override {
+    return std::make_shared<TileData<float>>(16);
+  }
+
+  cs::utils::TaskHandle loadTileAsync(TileId const& tileId, OnLoadCallback cb) override {
+    cb(tileId, loadTile(tileId));
+    return {};
+  }
+
+  int getPendingRequests() override {
+    return 0;
+  }
+
+  bool isSame(TileSource const* other) const override {
+    return dynamic_cast<TestTileSource const*>(other) != nullptr;
+  }
+};
+
+// Loads the root tiles, the children of the first root and the children of its first child.
+void loadTiles(TreeManager& treeMgr) {
+  std::vector<TileId> tileIds;
+  for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+    tileIds.emplace_back(0, i);
+  }
+
+  for (int level = 0; level < 3; ++level) {
+    treeMgr.request(tileIds);
+    treeMgr.update();
+
+    TileId parentId = tileIds.front();
+    tileIds.clear();
+
+    for (int i = 0; i < 4; ++i) {
+      tileIds.push_back(HEALPix::getChildTileId(parentId, i));
+    }
+  }
+}
+
+void markAsUsed(TileNode* node, int frame) {
+  if (node) {
+    node->setLastFrame(frame);
+
+    for (int i = 0; i < 4; ++i) {
+      markAsUsed(node->getChild(i), frame);
+    }
+  }
+}
+
+void markAsUsed(TreeManager& treeMgr, int frame) {
+  for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+    markAsUsed(treeMgr.getTree()->getRoot(i), frame);
+  }
+}
+
+int getMaxLevel(TileNode const* node) {
+  int level = node->getLevel();
+
+  for (int i = 0; i < 4; ++i) {
+    if (node->getChild(i)) {
+      level = std::max(level, getMaxLevel(node->getChild(i)));
+    }
+  }
+
+  return level;
+}
+
+} // namespace
+
+TEST_CASE("csp::lodbodies::ResidencyManager") {
+  const std::size_t rootCount = TileQuadTree::sNumRoots;
+  const std::size_t nodeCount = rootCount + 8;
+
+  TestTileSource source;
+  TreeManager    used(nullptr);
+  TreeManager    unused(nullptr);
+
+  for (auto* treeMgr : {&used, &unused}) {
+    treeMgr->setSource(TileDataType::eElevation, &source);
+    loadTiles(*treeMgr);
+    REQUIRE_EQ(treeMgr->getNodeCount(), nodeCount);
+  }
+
+  // All nodes are of the same size.
+  std::size_t nodeSize = used.getResidency().mCPUBytes / nodeCount;
+  CHECK_GT(nodeSize, 16 * 16 * sizeof(float));
+
+  ResidencyManager residencyMgr;
+  residencyMgr.registerTreeManager(&used);
+  residencyMgr.registerTreeManager(&unused);
+
+  CHECK_EQ(residencyMgr.getResidency().mCPUBytes, 2 * nodeCount * nodeSize);
+
+  markAsUsed(used, 5);
+
+  SUBCASE("The least recently used tiles are evicted first") {
+    residencyMgr.setTotalBudget({(2 * nodeCount - 3) * nodeSize, 0});
+    residencyMgr.update(6);
+
+    CHECK_EQ(used.getNodeCount(), nodeCount);
+    CHECK_EQ(unused.getNodeCount(), nodeCount - 3);
+    CHECK_EQ(getMaxLevel(unused.getTree()->getRoot(0)), 2);
+    CHECK_EQ(residencyMgr.getResidency().mCPUBytes, (2 * nodeCount - 3) * nodeSize);
+
+    // Children are evicted before their parents and root tiles are never evicted.
+    residencyMgr.setTotalBudget({nodeSize, 0});
+    residencyMgr.update(6);
+
+    CHECK_EQ(used.getNodeCount(), nodeCount);
+    CHECK_EQ(unused.getNodeCount(), rootCount);
+  }
+
+  SUBCASE("Tiles used in the last frame are not evicted") {
+    residencyMgr.setBudget(&used, {nodeSize, 0});
+    residencyMgr.update(6);
+
+    CHECK_EQ(used.getNodeCount(), nodeCount);
+    CHECK_EQ(unused.getNodeCount(), nodeCount);
+
+    residencyMgr.update(7);
+
+    CHECK_EQ(used.getNodeCount(), rootCount);
+    CHECK_EQ(unused.getNodeCount(), nodeCount);
+  }
+
+  // Evicted tiles must not confuse the regular pruning.
+  for (auto* treeMgr : {&used, &unused}) {
+    treeMgr->setFrameCount(100);
+    treeMgr->update();
+    CHECK_EQ(treeMgr->getNodeCount(), rootCount);
+
+    treeMgr->clear();
+    CHECK_EQ(treeMgr->getResidency().mCPUBytes, 0U);
+  }
+}
+
+} // namespace csp::lodbodies
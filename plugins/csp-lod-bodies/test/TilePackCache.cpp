@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/TilePackCache.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+namespace csp::lodbodies {
+
+namespace {
+
+std::string toString(std::optional<TilePackCache::Blob> const& blob) {
+  return blob ? std::string(blob->data(), blob->size()) : std::string();
+}
+
+} // namespace
+
+TEST_CASE("csp::lodbodies::TilePackCache") {
+  auto directory = boost::filesystem::temp_directory_path() /
+                   boost::filesystem::unique_path("csp-lod-bodies-test-%%%%-%%%%");
+
+  std::string first  = "first tile";
+  std::string second = "second tile";
+  std::string third  = "replaced first tile";
+
+  {
+    TilePackCache cache(directory.string(), "png");
+
+    CHECK_UNARY_FALSE(cache.read(3, 1, 2));
+    CHECK_UNARY_FALSE(boost::filesystem::exists(directory));
+
+    cache.write(3, 1, 2, first.data(), first.size());
+
+    // Reading before and after another write makes sure that the data file gets remapped.
+    CHECK_EQ(toString(cache.read(3, 1, 2)), first);
+
+    cache.write(3, 2, 1, second.data(), second.size());
+    auto blob = cache.read(3, 2, 1);
+    cache.write(3, 1, 2, third.data(), third.size());
+
+    CHECK_EQ(toString(blob), second);
+    CHECK_EQ(toString(cache.read(3, 1, 2)), third);
+    CHECK_EQ(cache.getTileCount(3), 2);
+    CHECK_EQ(cache.getTileCount(4), 0);
+
+    cache.remove(3, 2, 1);
+    CHECK_UNARY_FALSE(cache.read(3, 2, 1));
+  }
+
+  // Simulate a crash while a record has been written to the index file.
+  {
+    std::FILE* index = std::fopen((directory / "3.png.idx").string().c_str(), "ab");
+    std::fputs("garbage", index);
+    std::fclose(index);
+  }
+
+  {
+    TilePackCache cache(directory.string(), "png");
+
+    CHECK_EQ(toString(cache.read(3, 1, 2)), third);
+    CHECK_UNARY_FALSE(cache.read(3, 2, 1));
+    CHECK_EQ(cache.getTileCount(3), 1);
+
+    // New tiles have to be appended after the last valid record.
+    cache.write(3, 5, 5, first.data(), first.size());
+  }
+
+  {
+    TilePackCache cache(directory.string(), "png");
+    CHECK_EQ(toString(cache.read(3, 5, 5)), first);
+    CHECK_EQ(cache.getTileCount(3), 2);
+  }
+
+  // Simulate a crash while the headers of a new pack have been written.
+  {
+    std::ofstream data((directory / "4.png.pack").string(), std::ios::binary);
+    data.write("CSVR", 4);
+    std::ofstream index((directory / "4.png.idx").string(), std::ios::binary);
+  }
+
+  {
+    TilePackCache cache(directory.string(), "png");
+    CHECK_EQ(cache.getTileCount(4), 0);
+
+    // The truncated pack is recreated.
+    cache.write(4, 1, 1, second.data(), second.size());
+    CHECK_EQ(toString(cache.read(4, 1, 1)), second);
+  }
+
+  {
+    TilePackCache cache(directory.string(), "png");
+    CHECK_EQ(toString(cache.read(4, 1, 1)), second);
+    CHECK_EQ(cache.getTileCount(4), 1);
+  }
+
+  // Packs with an unknown header are not overwritten.
+  {
+    std::ofstream data((directory / "5.png.pack").string(), std::ios::binary);
+    data.write("CSVRPAK9", 8);
+    std::ofstream index((directory / "5.png.idx").string(), std::ios::binary);
+    index.write("CSVRIDX9", 8);
+  }
+
+  {
+    TilePackCache cache(directory.string(), "png");
+    CHECK_THROWS_AS(cache.read(5, 1, 1), std::runtime_error);
+  }
+
+  // More tiles than fit into one batch of index records.
+  {
+    TilePackCache cache(directory.string(), "png");
+    for (int i = 0; i < 100; ++i) {
+      auto tile = std::to_string(i);
+      cache.write(6, i, 0, tile.data(), tile.size());
+    }
+  }
+
+  {
+    TilePackCache cache(directory.string(), "png");
+    CHECK_EQ(cache.getTileCount(6), 100);
+    CHECK_EQ(toString(cache.read(6, 42, 0)), "42");
+  }
+
+  boost::filesystem::remove_all(directory);
+}
+
+} // namespace csp::lodbodies
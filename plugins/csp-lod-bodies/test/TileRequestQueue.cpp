@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/TileRequestQueue.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+namespace csp::lodbodies {
+
+TEST_CASE("csp::lodbodies::TileRequestQueue::pop") {
+  TileRequestQueue queue;
+
+  queue.push(TileId(1, 0), {10.0, 5.0}, 0);
+  queue.push(TileId(1, 1), {20.0, 5.0}, 0);
+  queue.push(TileId(1, 2), {20.0, 1.0}, 0);
+  queue.push(TileId(0, 0), {}, 0);
+
+  // Renewing a request updates its priority instead of adding a second one.
+  queue.push(TileId(1, 0), {30.0, 5.0}, 0);
+  CHECK_EQ(queue.size(), 4);
+
+  auto first = queue.pop(2);
+  REQUIRE_EQ(first.size(), 2);
+  CHECK_EQ(first[0], TileId(0, 0));
+  CHECK_EQ(first[1], TileId(1, 0));
+
+  auto second = queue.pop(10);
+  REQUIRE_EQ(second.size(), 2);
+  CHECK_EQ(second[0], TileId(1, 2));
+  CHECK_EQ(second[1], TileId(1, 1));
+
+  CHECK_EQ(queue.size(), 0);
+}
+
+TEST_CASE("csp::lodbodies::TileRequestQueue::removeStale") {
+  TileRequestQueue queue;
+
+  queue.push(TileId(1, 0), {}, 1);
+  queue.push(TileId(1, 1), {}, 2);
+  queue.push(TileId(1, 2), {}, 3);
+
+  CHECK_EQ(queue.removeStale(2), 1);
+  CHECK_EQ(queue.size(), 2);
+
+  queue.clear();
+  CHECK_EQ(queue.size(), 0);
+}
+
+} // namespace csp::lodbodies
@@ -0,0 +1,348 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/TreeManager.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/HEALPix.hpp"
+#include "../src/ObjectPool.hpp"
+#include "../src/TileData.hpp"
+#include "../src/TileNode.hpp"
+#include "../src/TileSource.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+
+namespace csp::lodbodies {
+
+namespace {
+
+// A tile source which creates flat elevation tiles. The callback is invoked right away, so
+// requested tiles are available for merging in the next call to TreeManager::update().
+class TestTileSource : public TileSource {
+ public:
+  void init() override {
+  }
+
+  void fini() override {
+  }
+
+  TileDataType getDataType() const override {
+    return TileDataType::eElevation;
+  }
+
+  std::shared_ptr<BaseTileData> loadTile(TileId const& /*tileId*/) override {
+    return std::make_shared<TileData<float>>(16);
+  }
+
+  cs::utils::TaskHandle loadTileAsync(TileId const& tileId, OnLoadCallback cb) override {
+    cb(tileId, loadTile(tileId));
+    return {};
+  }
+
+  int getPendingRequests() override {
+    return 0;
+  }
+
+  bool isSame(TileSource const* other) const override {
+    return dynamic_cast<TestTileSource const*>(other) != nullptr;
+  }
+};
+
+// A tile source which loads the tiles on a ThreadPool with a single thread. While this thread is
+// blocked, requested tiles are not loaded and can still be cancelled.
+class DeferredTileSource : public TestTileSource {
+ public:
+  DeferredTileSource() = default;
+
+  DeferredTileSource(DeferredTileSource const& other) = delete;
+  DeferredTileSource(DeferredTileSource&& other)      = delete;
+
+  DeferredTileSource& operator=(DeferredTileSource const& other) = delete;
+  DeferredTileSource& operator=(DeferredTileSource&& other)      = delete;
+
+  ~DeferredTileSource() override {
+    release();
+  }
+
+  cs::utils::TaskHandle loadTileAsync(TileId const& tileId, OnLoadCallback cb) override {
+    auto handle = mPool.submit([tileId, cb, this]() { cb(tileId, loadTile(tileId)); });
+    mHandles.push_back(handle);
+    return handle;
+  }
+
+  // Blocks the thread until release() is called.
+  void block() {
+    auto started = std::make_shared<std::promise<void>>();
+    auto future  = started->get_future();
+
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mBlocked = true;
+    }
+
+    mPool.post([this, started]() {
+      started->set_value();
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCondition.wait(lock, [this]() { return !mBlocked; });
+    });
+
+    future.wait();
+  }
+
+  // Unblocks the thread and waits until all tiles have been loaded or cancelled.
+  void release() {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mBlocked = false;
+    }
+
+    mCondition.notify_all();
+
+    for (auto const& handle : mHandles) {
+      while (!handle.isFinished() && !handle.isCancelled()) {
+        std::this_thread::yield();
+      }
+    }
+
+    mHandles.clear();
+  }
+
+ private:
+  std::mutex                         mMutex;
+  std::condition_variable            mCondition;
+  bool                               mBlocked = false;
+  std::vector<cs::utils::TaskHandle> mHandles;
+  cs::utils::ThreadPool              mPool{1};
+};
+
+// Returns the node with the given id or nullptr if it is not part of the tree.
+TileNode* findNode(TileQuadTree* tree, TileId const& tileId) {
+  TileNode* node = tree->getRoot(HEALPix::getRootIdx(tileId));
+
+  for (int i = 1; i <= tileId.level() && node; ++i) {
+    node = node->getChild(HEALPix::getChildIdxAtLevel(tileId, i));
+  }
+
+  return node;
+}
+
+std::vector<TileId> getRootIds() {
+  std::vector<TileId> tileIds;
+  for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+    tileIds.emplace_back(0, i);
+  }
+  return tileIds;
+}
+
+} // namespace
+
+TEST_CASE("csp::lodbodies::TreeManager pruning") {
+  const std::size_t rootCount = TileQuadTree::sNumRoots;
+
+  TestTileSource source;
+  TreeManager    treeMgr(nullptr);
+  treeMgr.setSource(TileDataType::eElevation, &source);
+
+  TileId const parentId(0, 0);
+  TileId const usedId   = HEALPix::getChildTileId(parentId, 0);
+  TileId const unusedId = HEALPix::getChildTileId(parentId, 1);
+
+  treeMgr.request(getRootIds());
+  treeMgr.update();
+
+  std::vector<TileId> children;
+  for (int i = 0; i < 4; ++i) {
+    children.push_back(HEALPix::getChildTileId(parentId, i));
+  }
+
+  treeMgr.request(children);
+  treeMgr.update();
+
+  REQUIRE_EQ(treeMgr.getNodeCount(), rootCount + 4);
+
+  // Only one of the children is used, the others have to be removed after ten frames.
+  int frame = 1;
+  for (; frame <= 12; ++frame) {
+    findNode(treeMgr.getTree(), parentId)->setLastFrame(frame);
+    findNode(treeMgr.getTree(), usedId)->setLastFrame(frame);
+    treeMgr.setFrameCount(frame);
+    treeMgr.update();
+  }
+
+  CHECK_EQ(treeMgr.getNodeCount(), rootCount + 1);
+  CHECK_UNARY(findNode(treeMgr.getTree(), usedId));
+  CHECK_UNARY_FALSE(findNode(treeMgr.getTree(), unusedId));
+
+  // Once no node is used anymore, all but the root nodes are removed.
+  for (; frame <= 24; ++frame) {
+    treeMgr.setFrameCount(frame);
+    treeMgr.update();
+  }
+
+  CHECK_EQ(treeMgr.getNodeCount(), rootCount);
+  CHECK_UNARY_FALSE(findNode(treeMgr.getTree(), usedId));
+
+  for (auto const& rootId : getRootIds()) {
+    CHECK_UNARY(findNode(treeMgr.getTree(), rootId));
+  }
+
+  treeMgr.clear();
+  CHECK_EQ(treeMgr.getNodeCount(), 0U);
+}
+
+TEST_CASE("csp::lodbodies::TreeManager stale requests") {
+  const std::size_t rootCount = TileQuadTree::sNumRoots;
+
+  DeferredTileSource source;
+  TreeManager        treeMgr(nullptr);
+  treeMgr.setSource(TileDataType::eElevation, &source);
+
+  int frame = 0;
+  treeMgr.setFrameCount(frame);
+  treeMgr.request(getRootIds());
+  source.release();
+  treeMgr.update();
+
+  REQUIRE_EQ(treeMgr.getNodeCount(), rootCount);
+
+  // Request more children than can be in flight at the same time, so that some of them stay in the
+  // queue while the others wait for the blocked thread of the tile source.
+  std::vector<TileId> children;
+  for (auto const& rootId : getRootIds()) {
+    for (int i = 0; i < 4; ++i) {
+      children.push_back(HEALPix::getChildTileId(rootId, i));
+    }
+  }
+
+  source.block();
+  treeMgr.setFrameCount(++frame);
+  treeMgr.request(children);
+
+  auto statistics = treeMgr.getRequestStatistics();
+  REQUIRE_GT(statistics.mQueued, 0U);
+  REQUIRE_GT(statistics.mInFlight, 0U);
+  REQUIRE_EQ(statistics.mQueued + statistics.mInFlight, children.size());
+
+  SUBCASE("Requests which are not renewed are dropped and not merged") {
+    frame += 2;
+    treeMgr.setFrameCount(frame);
+    treeMgr.request({});
+
+    statistics = treeMgr.getRequestStatistics();
+    CHECK_EQ(statistics.mQueued, 0U);
+    CHECK_EQ(statistics.mInFlight, 0U);
+    CHECK_EQ(statistics.mCancelled, children.size());
+
+    source.release();
+    treeMgr.update();
+
+    CHECK_EQ(treeMgr.getNodeCount(), rootCount);
+    CHECK_EQ(treeMgr.getRequestStatistics().mCompleted, rootCount);
+
+    for (auto const& child : children) {
+      CHECK_UNARY_FALSE(findNode(treeMgr.getTree(), child));
+    }
+  }
+
+  SUBCASE("Requests which are renewed are merged") {
+    frame += 2;
+    treeMgr.setFrameCount(frame - 1);
+    treeMgr.request(children);
+    treeMgr.setFrameCount(frame);
+    treeMgr.request(children);
+
+    CHECK_EQ(treeMgr.getRequestStatistics().mCancelled, 0U);
+
+    source.release();
+    treeMgr.update();
+
+    CHECK_EQ(treeMgr.getNodeCount(), rootCount + statistics.mInFlight);
+  }
+}
+
+TEST_CASE("csp::lodbodies::TreeManager insertion and eviction [benchmark]") {
+  const int         level           = 6;
+  const glm::int64  windowSize      = 128;
+  const glm::int64  windowStep      = 16;
+  const std::size_t totalInsertions = 100000;
+
+  auto const& pool         = ObjectPool<TileNode>::get();
+  std::size_t pooledNodes  = pool.getUsedCount();
+  glm::int64  levelPatches = HEALPix::getLevel(level).getTotalPatchCount();
+  std::size_t maxTreeSize  = 0;
+  int         frame        = 0;
+
+  TestTileSource source;
+  TreeManager    treeMgr(nullptr);
+  treeMgr.setSource(TileDataType::eElevation, &source);
+
+  std::vector<double> frameTimes;
+
+  // A window of tiles moves across the body. Each frame, all tiles of the window and their
+  // ancestors are marked as used, missing ones are requested. Tiles which left the window are
+  // evicted after a few frames.
+  while (treeMgr.getRequestStatistics().mCompleted < totalInsertions) {
+    std::unordered_set<TileId> window;
+    glm::int64                 offset = frame * windowStep;
+
+    for (glm::int64 i = 0; i < windowSize; ++i) {
+      TileId tileId(level, (offset + i) % levelPatches);
+
+      while (window.insert(tileId).second && tileId.level() > 0) {
+        tileId = HEALPix::getParentTileId(tileId);
+      }
+    }
+
+    std::vector<TileId> requests;
+
+    for (auto const& tileId : window) {
+      if (auto* node = findNode(treeMgr.getTree(), tileId)) {
+        node->setLastFrame(frame);
+      } else if (tileId.level() == 0 ||
+                 findNode(treeMgr.getTree(), HEALPix::getParentTileId(tileId))) {
+        requests.push_back(tileId);
+      }
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    treeMgr.setFrameCount(frame);
+    treeMgr.request(requests);
+    treeMgr.update();
+
+    std::chrono::duration<double, std::micro> duration =
+        std::chrono::high_resolution_clock::now() - start;
+    frameTimes.push_back(duration.count());
+
+    maxTreeSize = std::max(maxTreeSize, treeMgr.getNodeCount());
+    ++frame;
+  }
+
+  // Most of the inserted tiles have to be evicted again, else the tree would contain all of them.
+  CHECK_LT(maxTreeSize, totalInsertions / 10);
+
+  treeMgr.clear();
+  CHECK_EQ(pool.getUsedCount(), pooledNodes);
+
+  std::sort(frameTimes.begin(), frameTimes.end());
+
+  auto percentile = [&](double p) {
+    auto index = static_cast<std::size_t>(p * static_cast<double>(frameTimes.size() - 1));
+    return static_cast<int>(frameTimes[index]);
+  };
+
+  MESSAGE("TreeManager (", totalInsertions, " insertions in ", frame, " frames, at most ",
+      maxTreeSize, " nodes): p50 ", percentile(0.5), " us, p95 ", percentile(0.95), " us, p99 ",
+      percentile(0.99), " us, max ", percentile(1.0), " us per frame");
+}
+
+} // namespace csp::lodbodies
@@ -0,0 +1,811 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "DelaunayMesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <glm/gtc/constants.hpp>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <unordered_map>
+
+namespace csp::measurementtools {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Triangles with an edge shorter than this (relative to the size of the polygon) are not refined
+// any further. This prevents endless refinement close to sharp corners of the polygon.
+const double MIN_RELATIVE_EDGE_LENGTH = 1e-4;
+
+// The exact predicates below are based on "Adaptive Precision Floating-Point Arithmetic and Fast
+// Robust Geometric Predicates" by Jonathan R. Shewchuk. A number is represented as an expansion,
+// which is a sum of non-overlapping doubles sorted by increasing magnitude. The sign of an
+// expansion is the sign of its last component.
+using Expansion = std::vector<double>;
+
+const double EPSILON             = std::numeric_limits<double>::epsilon() * 0.5;
+const double ORIENT_ERROR_BOUND   = (3.0 + 16.0 * EPSILON) * EPSILON;
+const double INCIRCLE_ERROR_BOUND = (10.0 + 96.0 * EPSILON) * EPSILON;
+
+// x + y = a + b exactly.
+void twoSum(double a, double b, double& x, double& y) {
+  x               = a + b;
+  double bVirtual = x - a;
+  double aVirtual = x - bVirtual;
+  y               = (a - aVirtual) + (b - bVirtual);
+}
+
+// x + y = a * b exactly.
+void twoProduct(double a, double b, double& x, double& y) {
+  x = a * b;
+  y = std::fma(a, b, -x);
+}
+
+Expansion difference(double a, double b) {
+  double x{};
+  double y{};
+  twoSum(a, -b, x, y);
+  return y == 0.0 ? Expansion{x} : Expansion{y, x};
+}
+
+Expansion grow(Expansion const& e, double b) {
+  Expansion h;
+  h.reserve(e.size() + 1);
+
+  double q = b;
+  for (double component : e) {
+    double sum{};
+    double error{};
+    twoSum(q, component, sum, error);
+    q = sum;
+
+    if (error != 0.0) {
+      h.push_back(error);
+    }
+  }
+
+  if (q != 0.0 || h.empty()) {
+    h.push_back(q);
+  }
+
+  return h;
+}
+
+Expansion sum(Expansion e, Expansion const& f) {
+  for (double component : f) {
+    e = grow(e, component);
+  }
+
+  return e;
+}
+
+Expansion scale(Expansion const& e, double b) {
+  Expansion h;
+  h.reserve(e.size() * 2);
+
+  double q{};
+  double error{};
+  twoProduct(e[0], b, q, error);
+
+  if (error != 0.0) {
+    h.push_back(error);
+  }
+
+  for (std::size_t i = 1; i < e.size(); ++i) {
+    double product{};
+    double productError{};
+    twoProduct(e[i], b, product, productError);
+
+    double partial{};
+    twoSum(q, productError, partial, error);
+    if (error != 0.0) {
+      h.push_back(error);
+    }
+
+    twoSum(product, partial, q, error);
+    if (error != 0.0) {
+      h.push_back(error);
+    }
+  }
+
+  if (q != 0.0 || h.empty()) {
+    h.push_back(q);
+  }
+
+  return h;
+}
+
+Expansion product(Expansion const& e, Expansion const& f) {
+  Expansion result{0.0};
+
+  for (double component : f) {
+    result = sum(result, scale(e, component));
+  }
+
+  return result;
+}
+
+Expansion negate(Expansion e) {
+  for (double& component : e) {
+    component = -component;
+  }
+
+  return e;
+}
+
+double orient2dExact(glm::dvec2 const& a, glm::dvec2 const& b, glm::dvec2 const& c) {
+  Expansion left  = product(difference(a.x, c.x), difference(b.y, c.y));
+  Expansion right = product(difference(a.y, c.y), difference(b.x, c.x));
+
+  return sum(left, negate(right)).back();
+}
+
+double incircleExact(
+    glm::dvec2 const& a, glm::dvec2 const& b, glm::dvec2 const& c, glm::dvec2 const& d) {
+  Expansion adx = difference(a.x, d.x);
+  Expansion ady = difference(a.y, d.y);
+  Expansion bdx = difference(b.x, d.x);
+  Expansion bdy = difference(b.y, d.y);
+  Expansion cdx = difference(c.x, d.x);
+  Expansion cdy = difference(c.y, d.y);
+
+  auto lift = [](Expansion const& x, Expansion const& y) {
+    return sum(product(x, x), product(y, y));
+  };
+
+  auto cross = [](Expansion const& x1, Expansion const& y1, Expansion const& x2,
+                   Expansion const& y2) { return sum(product(x1, y2), negate(product(y1, x2))); };
+
+  Expansion det = product(lift(adx, ady), cross(bdx, bdy, cdx, cdy));
+  det           = sum(det, product(lift(bdx, bdy), cross(cdx, cdy, adx, ady)));
+  det           = sum(det, product(lift(cdx, cdy), cross(adx, ady, bdx, bdy)));
+
+  return det.back();
+}
+
+// Returns a positive value if a, b and c are in counter-clockwise order, a negative value if they
+// are in clockwise order and zero if they are collinear. The sign is always exact.
+double orient2d(glm::dvec2 const& a, glm::dvec2 const& b, glm::dvec2 const& c) {
+  double detLeft  = (a.x - c.x) * (b.y - c.y);
+  double detRight = (a.y - c.y) * (b.x - c.x);
+  double det      = detLeft - detRight;
+
+  if (std::abs(det) >= ORIENT_ERROR_BOUND * (std::abs(detLeft) + std::abs(detRight))) {
+    return det;
+  }
+
+  return orient2dExact(a, b, c);
+}
+
+// Returns a positive value if d lies inside the circle through a, b and c, which have to be in
+// counter-clockwise order. It is negative if d lies outside and zero if all four points are
+// cocircular. The sign is always exact.
+double incircle(
+    glm::dvec2 const& a, glm::dvec2 const& b, glm::dvec2 const& c, glm::dvec2 const& d) {
+  double adx = a.x - d.x;
+  double ady = a.y - d.y;
+  double bdx = b.x - d.x;
+  double bdy = b.y - d.y;
+  double cdx = c.x - d.x;
+  double cdy = c.y - d.y;
+
+  double alift = adx * adx + ady * ady;
+  double blift = bdx * bdx + bdy * bdy;
+  double clift = cdx * cdx + cdy * cdy;
+
+  double det = alift * (bdx * cdy - bdy * cdx) + blift * (cdx * ady - cdy * adx) +
+               clift * (adx * bdy - ady * bdx);
+
+  double permanent = alift * (std::abs(bdx * cdy) + std::abs(bdy * cdx)) +
+                     blift * (std::abs(cdx * ady) + std::abs(cdy * adx)) +
+                     clift * (std::abs(adx * bdy) + std::abs(ady * bdx));
+
+  if (std::abs(det) >= INCIRCLE_ERROR_BOUND * permanent) {
+    return det;
+  }
+
+  return incircleExact(a, b, c, d);
+}
+
+glm::dvec2 circumcenter(glm::dvec2 const& a, glm::dvec2 const& b, glm::dvec2 const& c) {
+  glm::dvec2 ab = b - a;
+  glm::dvec2 ac = c - a;
+
+  double d  = 2.0 * (ab.x * ac.y - ab.y * ac.x);
+  double ab2 = glm::dot(ab, ab);
+  double ac2 = glm::dot(ac, ac);
+
+  return a + glm::dvec2(ac.y * ab2 - ab.y * ac2, ab.x * ac2 - ac.x * ab2) / d;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DelaunayMesh::triangulate(std::vector<glm::dvec2> const& polygon) {
+  mVertices.clear();
+  mFaces.clear();
+  mTouchedFaces.clear();
+  mLastFace = 0;
+
+  for (auto const& point : polygon) {
+    if (mVertices.empty() || point != mVertices.back()) {
+      mVertices.push_back(point);
+    }
+  }
+
+  while (mVertices.size() > 1 && mVertices.front() == mVertices.back()) {
+    mVertices.pop_back();
+  }
+
+  if (mVertices.size() < 3) {
+    mVertices.clear();
+    return false;
+  }
+
+  glm::dvec2 minPoint = mVertices.front();
+  glm::dvec2 maxPoint = mVertices.front();
+  double     area     = 0.0;
+
+  for (std::size_t i = 0, j = mVertices.size() - 1; i < mVertices.size(); j = i++) {
+    minPoint = glm::min(minPoint, mVertices[i]);
+    maxPoint = glm::max(maxPoint, mVertices[i]);
+    area += (mVertices[j].x - mVertices[i].x) * (mVertices[j].y + mVertices[i].y);
+  }
+
+  if (area == 0.0) {
+    mVertices.clear();
+    return false;
+  }
+
+  mDiameter = glm::length(maxPoint - minPoint);
+
+  // The polygon is clipped in counter-clockwise order.
+  std::vector<uint32_t> ring(mVertices.size());
+  std::iota(ring.begin(), ring.end(), 0U);
+
+  if (area < 0.0) {
+    std::reverse(ring.begin(), ring.end());
+  }
+
+  // If the polygon turns back at a corner, it is degenerate. Corners which lie on a straight line
+  // between their neighbors are fine, they just cannot be the tip of an ear.
+  for (std::size_t i = 0; i < ring.size(); ++i) {
+    glm::dvec2 const& prev = mVertices[ring[(i + ring.size() - 1) % ring.size()]];
+    glm::dvec2 const& curr = mVertices[ring[i]];
+    glm::dvec2 const& next = mVertices[ring[(i + 1) % ring.size()]];
+
+    if (orient2d(prev, curr, next) == 0.0 && glm::dot(curr - prev, next - curr) <= 0.0) {
+      mVertices.clear();
+      return false;
+    }
+  }
+
+  // Ear clipping. The ring is stored as a doubly linked list of positions in ring.
+  std::size_t              remaining = ring.size();
+  std::vector<std::size_t> prev(remaining);
+  std::vector<std::size_t> next(remaining);
+
+  for (std::size_t i = 0; i < remaining; ++i) {
+    prev[i] = (i + remaining - 1) % remaining;
+    next[i] = (i + 1) % remaining;
+  }
+
+  auto isEar = [&](std::size_t i) {
+    glm::dvec2 const& a = mVertices[ring[prev[i]]];
+    glm::dvec2 const& b = mVertices[ring[i]];
+    glm::dvec2 const& c = mVertices[ring[next[i]]];
+
+    if (orient2d(a, b, c) <= 0.0) {
+      return false;
+    }
+
+    // No other corner may lie inside the ear or on its boundary.
+    for (std::size_t j = next[next[i]]; j != prev[i]; j = next[j]) {
+      glm::dvec2 const& p = mVertices[ring[j]];
+
+      if (orient2d(a, b, p) >= 0.0 && orient2d(b, c, p) >= 0.0 && orient2d(c, a, p) >= 0.0) {
+        return false;
+      }
+    }
+
+    return true;
+  };
+
+  std::size_t current  = 0;
+  std::size_t failures = 0;
+
+  while (remaining > 3) {
+    if (isEar(current)) {
+      Face face;
+      face.mVertices = {ring[prev[current]], ring[current], ring[next[current]]};
+      mFaces.push_back(face);
+
+      next[prev[current]] = next[current];
+      prev[next[current]] = prev[current];
+      current             = prev[current];
+      failures            = 0;
+      --remaining;
+    } else if (++failures > remaining) {
+      // There is no ear, so the polygon intersects itself.
+      mVertices.clear();
+      mFaces.clear();
+      return false;
+    } else {
+      current = next[current];
+    }
+  }
+
+  // The last triangle is degenerate if the polygon overlaps itself.
+  if (!isEar(current)) {
+    mVertices.clear();
+    mFaces.clear();
+    return false;
+  }
+
+  Face face;
+  face.mVertices = {ring[prev[current]], ring[current], ring[next[current]]};
+  mFaces.push_back(face);
+
+  // Connect the faces which share an edge.
+  std::unordered_map<uint64_t, std::pair<int32_t, int>> edges;
+
+  for (int32_t f = 0; f < static_cast<int32_t>(mFaces.size()); ++f) {
+    for (int i = 0; i < 3; ++i) {
+      uint64_t v1  = mFaces[f].mVertices.at((i + 1) % 3);
+      uint64_t v2  = mFaces[f].mVertices.at((i + 2) % 3);
+      uint64_t key = (std::min(v1, v2) << 32U) | std::max(v1, v2);
+
+      auto [it, inserted] = edges.emplace(key, std::make_pair(f, i));
+
+      if (!inserted) {
+        mFaces[f].mNeighbors.at(i)                                 = it->second.first;
+        mFaces[it->second.first].mNeighbors.at(it->second.second) = f;
+      }
+    }
+  }
+
+  // Make the triangulation Delaunay by flipping all edges which are not.
+  std::vector<std::pair<int32_t, uint32_t>> stack;
+  for (int32_t f = 0; f < static_cast<int32_t>(mFaces.size()); ++f) {
+    for (uint32_t vertex : mFaces[f].mVertices) {
+      stack.emplace_back(f, vertex);
+    }
+  }
+
+  legalize(stack);
+  mTouchedFaces.clear();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DelaunayMesh::insertPoint(glm::dvec2 const& point) {
+  if (mFaces.empty()) {
+    return false;
+  }
+
+  int32_t  face     = mLastFace;
+  int      edge     = -1;
+  Location location = locate(point, face, edge);
+
+  if (location == Location::eOutside) {
+    location = locateExhaustive(point, face, edge);
+  }
+
+  if (location != Location::eInside && location != Location::eOnEdge) {
+    return false;
+  }
+
+  mVertices.push_back(point);
+  auto vertex = static_cast<uint32_t>(mVertices.size() - 1);
+
+  if (location == Location::eInside) {
+    insertInFace(face, vertex);
+  } else {
+    insertOnEdge(face, edge, vertex);
+  }
+
+  mTouchedFaces.clear();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t DelaunayMesh::refine(
+    double minAngle, std::size_t maxVertices, std::atomic<bool> const* cancelled) {
+
+  // A triangle is skinny if the ratio of its circumradius to its shortest edge is larger than this.
+  // For a triangle with the smallest angle alpha, this ratio is 1 / (2 * sin(alpha)).
+  double maxRatio  = 1.0 / (2.0 * std::sin(minAngle * glm::pi<double>() / 180.0));
+  double minCos    = std::cos(minAngle * glm::pi<double>() / 180.0);
+  double minLength = mDiameter * MIN_RELATIVE_EDGE_LENGTH;
+
+  auto getCircumcenter = [&](int32_t f) -> std::optional<glm::dvec2> {
+    auto const& face = mFaces[f];
+
+    glm::dvec2 const& a = mVertices[face.mVertices[0]];
+    glm::dvec2 const& b = mVertices[face.mVertices[1]];
+    glm::dvec2 const& c = mVertices[face.mVertices[2]];
+
+    // Triangles in corners of the polygon which are sharper than minAngle cannot be improved.
+    auto boundaryEdges = std::count(face.mNeighbors.begin(), face.mNeighbors.end(), -1);
+
+    if (boundaryEdges == 3) {
+      return std::nullopt;
+    }
+
+    if (boundaryEdges == 2) {
+      // The corner is opposite to the only inner edge.
+      auto inner = std::find_if(
+          face.mNeighbors.begin(), face.mNeighbors.end(), [](int32_t n) { return n >= 0; });
+      int  i     = static_cast<int>(inner - face.mNeighbors.begin());
+
+      glm::dvec2 corner = mVertices[face.mVertices.at(i)];
+      glm::dvec2 e1     = mVertices[face.mVertices.at((i + 1) % 3)] - corner;
+      glm::dvec2 e2     = mVertices[face.mVertices.at((i + 2) % 3)] - corner;
+
+      if (glm::dot(e1, e2) > minCos * glm::length(e1) * glm::length(e2)) {
+        return std::nullopt;
+      }
+    }
+
+    double shortest = std::min({glm::length(b - a), glm::length(c - b), glm::length(a - c)});
+
+    if (shortest < minLength) {
+      return std::nullopt;
+    }
+
+    glm::dvec2 center = circumcenter(a, b, c);
+
+    if (glm::length(center - a) <= maxRatio * shortest) {
+      return std::nullopt;
+    }
+
+    return center;
+  };
+
+  auto isEncroached = [&](int32_t f, int edge, glm::dvec2 const& point) {
+    glm::dvec2 const& a = mVertices[mFaces[f].mVertices.at((edge + 1) % 3)];
+    glm::dvec2 const& b = mVertices[mFaces[f].mVertices.at((edge + 2) % 3)];
+    return glm::dot(point - a, point - b) < 0.0;
+  };
+
+  auto splitEdge = [&](int32_t f, int edge) {
+    glm::dvec2 const& a = mVertices[mFaces[f].mVertices.at((edge + 1) % 3)];
+    glm::dvec2 const& b = mVertices[mFaces[f].mVertices.at((edge + 2) % 3)];
+
+    if (glm::length(b - a) < 2.0 * minLength) {
+      return false;
+    }
+
+    mVertices.push_back((a + b) * 0.5);
+    insertOnEdge(f, edge, static_cast<uint32_t>(mVertices.size() - 1));
+    return true;
+  };
+
+  std::deque<int32_t> queue(mFaces.size());
+  std::iota(queue.begin(), queue.end(), 0);
+
+  std::size_t initialVertices = mVertices.size();
+
+  while (!queue.empty() && mVertices.size() < maxVertices) {
+    if (cancelled && cancelled->load()) {
+      break;
+    }
+
+    int32_t f = queue.front();
+    queue.pop_front();
+
+    auto center = getCircumcenter(f);
+
+    if (!center) {
+      continue;
+    }
+
+    mTouchedFaces.clear();
+
+    int32_t  face     = f;
+    int      edge     = -1;
+    Location location = locate(*center, face, edge);
+    bool     inserted = false;
+
+    if (location == Location::eOutside) {
+      // The circumcenter is hidden behind an edge of the polygon, this edge is split instead.
+      inserted = edge >= 0 && splitEdge(face, edge);
+    } else if (location != Location::eOnVertex) {
+      // If the circumcenter encroaches upon an edge of the polygon, this edge is split instead.
+      for (int i = 0; i < 3 && !inserted; ++i) {
+        if (mFaces[face].mNeighbors.at(i) < 0 && isEncroached(face, i, *center)) {
+          inserted = splitEdge(face, i);
+        }
+      }
+
+      if (!inserted) {
+        mVertices.push_back(*center);
+        auto vertex = static_cast<uint32_t>(mVertices.size() - 1);
+
+        if (location == Location::eInside) {
+          insertInFace(face, vertex);
+        } else {
+          insertOnEdge(face, edge, vertex);
+        }
+        inserted = true;
+      }
+    }
+
+    if (inserted) {
+      queue.insert(queue.end(), mTouchedFaces.begin(), mTouchedFaces.end());
+
+      // The skinny triangle may still exist if an edge of the polygon was split.
+      queue.push_back(f);
+    }
+  }
+
+  mTouchedFaces.clear();
+
+  return mVertices.size() - initialVertices;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<glm::dvec2> const& DelaunayMesh::getVertices() const {
+  return mVertices;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<DelaunayMesh::Triangle> DelaunayMesh::getTriangles() const {
+  std::vector<Triangle> triangles;
+  triangles.reserve(mFaces.size());
+
+  for (auto const& face : mFaces) {
+    triangles.push_back(face.mVertices);
+  }
+
+  return triangles;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<DelaunayMesh::Edge> DelaunayMesh::getEdges() const {
+  std::vector<Edge> edges;
+  edges.reserve(mFaces.size() * 2 + 1);
+
+  for (int32_t f = 0; f < static_cast<int32_t>(mFaces.size()); ++f) {
+    auto const& face = mFaces[f];
+
+    for (int i = 0; i < 3; ++i) {
+      if (face.mNeighbors.at(i) < f) {
+        edges.emplace_back(face.mVertices.at((i + 1) % 3), face.mVertices.at((i + 2) % 3));
+      }
+    }
+  }
+
+  return edges;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DelaunayMesh::Location DelaunayMesh::locate(
+    glm::dvec2 const& point, int32_t& face, int& edge) const {
+
+  edge = -1;
+
+  // The edges are checked in varying order, so that the walk cannot run in circles.
+  for (std::size_t step = 0; step < mFaces.size() * 3; ++step) {
+    auto const& f     = mFaces[face];
+    int         zeros = 0;
+    bool        moved = false;
+
+    for (std::size_t k = 0; k < 3 && !moved; ++k) {
+      int    i           = static_cast<int>((k + step) % 3);
+      double orientation = orient2d(
+          mVertices[f.mVertices.at((i + 1) % 3)], mVertices[f.mVertices.at((i + 2) % 3)], point);
+
+      if (orientation < 0.0) {
+        if (f.mNeighbors.at(i) < 0) {
+          edge = i;
+          return Location::eOutside;
+        }
+
+        face  = f.mNeighbors.at(i);
+        moved = true;
+      } else if (orientation == 0.0) {
+        edge = i;
+        ++zeros;
+      }
+    }
+
+    if (!moved) {
+      return zeros == 0 ? Location::eInside : zeros == 1 ? Location::eOnEdge : Location::eOnVertex;
+    }
+  }
+
+  return locateExhaustive(point, face, edge);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DelaunayMesh::Location DelaunayMesh::locateExhaustive(
+    glm::dvec2 const& point, int32_t& face, int& edge) const {
+
+  for (int32_t f = 0; f < static_cast<int32_t>(mFaces.size()); ++f) {
+    int  zeros  = 0;
+    bool inside = true;
+
+    for (int i = 0; i < 3 && inside; ++i) {
+      double orientation = orient2d(mVertices[mFaces[f].mVertices.at((i + 1) % 3)],
+          mVertices[mFaces[f].mVertices.at((i + 2) % 3)], point);
+
+      if (orientation < 0.0) {
+        inside = false;
+      } else if (orientation == 0.0) {
+        edge = i;
+        ++zeros;
+      }
+    }
+
+    if (inside) {
+      face = f;
+      return zeros == 0 ? Location::eInside : zeros == 1 ? Location::eOnEdge : Location::eOnVertex;
+    }
+  }
+
+  return Location::eOutside;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DelaunayMesh::insertInFace(int32_t face, uint32_t p) {
+  auto [a, b, c]    = mFaces[face].mVertices;
+  auto [nA, nB, nC] = mFaces[face].mNeighbors;
+
+  auto f1 = static_cast<int32_t>(mFaces.size());
+  auto f2 = f1 + 1;
+
+  mFaces[face] = {{a, b, p}, {f1, f2, nC}};
+  mFaces.push_back({{b, c, p}, {f2, face, nA}});
+  mFaces.push_back({{c, a, p}, {face, f1, nB}});
+
+  replaceNeighbor(nA, face, f1);
+  replaceNeighbor(nB, face, f2);
+
+  mTouchedFaces.insert(mTouchedFaces.end(), {face, f1, f2});
+
+  std::vector<std::pair<int32_t, uint32_t>> stack{{face, p}, {f1, p}, {f2, p}};
+  legalize(stack);
+
+  mLastFace = face;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DelaunayMesh::insertOnEdge(int32_t face, int edge, uint32_t p) {
+  // The edge from b to c is split.
+  uint32_t a  = mFaces[face].mVertices.at(edge);
+  uint32_t b  = mFaces[face].mVertices.at((edge + 1) % 3);
+  uint32_t c  = mFaces[face].mVertices.at((edge + 2) % 3);
+  int32_t  g  = mFaces[face].mNeighbors.at(edge);
+  int32_t  nB = mFaces[face].mNeighbors.at((edge + 1) % 3);
+  int32_t  nC = mFaces[face].mNeighbors.at((edge + 2) % 3);
+
+  auto f1 = static_cast<int32_t>(mFaces.size());
+  auto g1 = g < 0 ? -1 : f1 + 1;
+
+  mFaces[face] = {{a, b, p}, {g1, f1, nC}};
+  mFaces.push_back({{a, p, c}, {g, nB, face}});
+
+  replaceNeighbor(nB, face, f1);
+
+  mTouchedFaces.insert(mTouchedFaces.end(), {face, f1});
+
+  std::vector<std::pair<int32_t, uint32_t>> stack{{face, p}, {f1, p}};
+
+  // If the edge is not an edge of the polygon, the face on the other side is split as well. Its
+  // corners are d, c and b.
+  if (g >= 0) {
+    int      j   = (indexOf(g, c) + 2) % 3;
+    uint32_t d   = mFaces[g].mVertices.at(j);
+    int32_t  nBD = mFaces[g].mNeighbors.at((j + 1) % 3);
+    int32_t  nDC = mFaces[g].mNeighbors.at((j + 2) % 3);
+
+    mFaces[g] = {{d, c, p}, {f1, g1, nDC}};
+    mFaces.push_back({{d, p, b}, {face, nBD, g}});
+
+    replaceNeighbor(nBD, g, g1);
+
+    mTouchedFaces.insert(mTouchedFaces.end(), {g, g1});
+    stack.insert(stack.end(), {{g, p}, {g1, p}});
+  }
+
+  legalize(stack);
+
+  mLastFace = face;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DelaunayMesh::flip(int32_t face, int edge) {
+  // The faces a, b, c and d, c, b become a, b, d and a, d, c.
+  uint32_t a   = mFaces[face].mVertices.at(edge);
+  uint32_t b   = mFaces[face].mVertices.at((edge + 1) % 3);
+  uint32_t c   = mFaces[face].mVertices.at((edge + 2) % 3);
+  int32_t  g   = mFaces[face].mNeighbors.at(edge);
+  int32_t  nCA = mFaces[face].mNeighbors.at((edge + 1) % 3);
+  int32_t  nAB = mFaces[face].mNeighbors.at((edge + 2) % 3);
+
+  int      j   = (indexOf(g, c) + 2) % 3;
+  uint32_t d   = mFaces[g].mVertices.at(j);
+  int32_t  nBD = mFaces[g].mNeighbors.at((j + 1) % 3);
+  int32_t  nDC = mFaces[g].mNeighbors.at((j + 2) % 3);
+
+  mFaces[face] = {{a, b, d}, {nBD, g, nAB}};
+  mFaces[g]    = {{a, d, c}, {nDC, nCA, face}};
+
+  replaceNeighbor(nBD, g, face);
+  replaceNeighbor(nCA, face, g);
+
+  mTouchedFaces.insert(mTouchedFaces.end(), {face, g});
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DelaunayMesh::legalize(std::vector<std::pair<int32_t, uint32_t>>& stack) {
+  while (!stack.empty()) {
+    auto [face, vertex] = stack.back();
+    stack.pop_back();
+
+    // The face may have changed in the meantime.
+    int edge = indexOf(face, vertex);
+    if (edge < 0) {
+      continue;
+    }
+
+    int32_t neighbor = mFaces[face].mNeighbors.at(edge);
+    if (neighbor < 0) {
+      continue;
+    }
+
+    uint32_t b = mFaces[face].mVertices.at((edge + 1) % 3);
+    uint32_t c = mFaces[face].mVertices.at((edge + 2) % 3);
+    uint32_t d = mFaces[neighbor].mVertices.at((indexOf(neighbor, c) + 2) % 3);
+
+    if (incircle(mVertices[vertex], mVertices[b], mVertices[c], mVertices[d]) > 0.0) {
+      flip(face, edge);
+      stack.insert(stack.end(), {{face, d}, {face, vertex}, {neighbor, vertex}, {neighbor, d}});
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DelaunayMesh::replaceNeighbor(int32_t face, int32_t oldNeighbor, int32_t newNeighbor) {
+  if (face >= 0) {
+    auto& neighbors = mFaces[face].mNeighbors;
+    std::replace(neighbors.begin(), neighbors.end(), oldNeighbor, newNeighbor);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int DelaunayMesh::indexOf(int32_t face, uint32_t vertex) const {
+  auto const& vertices = mFaces[face].mVertices;
+  auto        it       = std::find(vertices.begin(), vertices.end(), vertex);
+  return it == vertices.end() ? -1 : static_cast<int>(it - vertices.begin());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::measurementtools
@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_MEASUREMENT_TOOLS_DELAUNAY_MESH_HPP
+#define CSP_MEASUREMENT_TOOLS_DELAUNAY_MESH_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <utility>
+#include <vector>
+
+namespace csp::measurementtools {
+
+/// A constrained Delaunay triangulation of the interior of a simple polygon. The edges of the
+/// polygon are always part of the mesh, all other edges are flipped until the mesh is Delaunay.
+/// Afterwards, the mesh can be refined by inserting additional points, either explicitly with
+/// insertPoint() or with refine(), which removes skinny triangles like Ruppert's algorithm does.
+///
+/// All geometric decisions are based on orientation and in-circle predicates which are evaluated
+/// with floating point arithmetic first and fall back to exact arithmetic if the result is too
+/// close to zero to be trusted. Hence, collinear and cocircular points do not break the mesh.
+///
+/// The class does not depend on any OpenGL or scene graph state, so it can be used on any thread.
+/// A mesh may be copied in order to refine it further while the original is still in use.
+class DelaunayMesh {
+ public:
+  /// The indices of the three corners of a triangle in counter-clockwise order.
+  using Triangle = std::array<uint32_t, 3>;
+
+  /// The indices of the two end points of an edge.
+  using Edge = std::pair<uint32_t, uint32_t>;
+
+  /// Triangulates the given polygon. It may be oriented clockwise or counter-clockwise and must not
+  /// be closed explicitly. Consecutive duplicate corners are removed. Returns false if the polygon
+  /// is degenerate or self-intersecting; the mesh is empty in this case.
+  bool triangulate(std::vector<glm::dvec2> const& polygon);
+
+  /// Inserts a point into the mesh. Points on an edge split this edge, this may also be an edge of
+  /// the polygon. Returns false if the point is outside the polygon or coincides with a vertex.
+  bool insertPoint(glm::dvec2 const& point);
+
+  /// Inserts points until no triangle has an angle smaller than minAngle (in degrees) or until the
+  /// mesh consists of maxVertices vertices. Triangles at corners of the polygon which are sharper
+  /// than minAngle are left as they are. minAngle should not exceed 30 degrees, else refinement is
+  /// only stopped by maxVertices. If cancelled is given and becomes true, refinement stops early.
+  /// Returns the number of inserted points.
+  std::size_t refine(
+      double minAngle, std::size_t maxVertices, std::atomic<bool> const* cancelled = nullptr);
+
+  /// The first vertices are the corners of the polygon, followed by all inserted points.
+  std::vector<glm::dvec2> const& getVertices() const;
+
+  /// Returns all triangles of the mesh.
+  std::vector<Triangle> getTriangles() const;
+
+  /// Returns each edge of the mesh once.
+  std::vector<Edge> getEdges() const;
+
+ private:
+  /// Edge i of a face is the edge opposite to mVertices[i]. mNeighbors[i] is the face on the other
+  /// side of this edge or -1 if it is an edge of the polygon.
+  struct Face {
+    std::array<uint32_t, 3> mVertices{};
+    std::array<int32_t, 3>  mNeighbors{-1, -1, -1};
+  };
+
+  enum class Location { eInside, eOnEdge, eOnVertex, eOutside };
+
+  /// Walks from the given face towards the point. On return, face contains the point and edge is
+  /// the edge it lies on. If an edge of the polygon blocks the way, eOutside is returned and face
+  /// and edge refer to this edge. For non-convex polygons, this does not necessarily mean that the
+  /// point is outside the polygon.
+  Location locate(glm::dvec2 const& point, int32_t& face, int& edge) const;
+
+  /// Checks all faces for the point. This is used if locate() was blocked by an edge.
+  Location locateExhaustive(glm::dvec2 const& point, int32_t& face, int& edge) const;
+
+  /// Connect the given vertex, which has to be added to mVertices already, to the corners of the
+  /// face or to the corners of the faces adjacent to the given edge and restore the Delaunay
+  /// property around it.
+  void insertInFace(int32_t face, uint32_t vertex);
+  void insertOnEdge(int32_t face, int edge, uint32_t vertex);
+
+  /// Flips the given edge of the face. The two faces adjacent to this edge must form a convex
+  /// quadrilateral.
+  void flip(int32_t face, int edge);
+
+  /// Flips edges until all edges in the stack and the edges affected by the flips are Delaunay.
+  /// Each entry is a face and the vertex opposite to the edge which should be checked.
+  void legalize(std::vector<std::pair<int32_t, uint32_t>>& stack);
+
+  void replaceNeighbor(int32_t face, int32_t oldNeighbor, int32_t newNeighbor);
+  int  indexOf(int32_t face, uint32_t vertex) const;
+
+  std::vector<glm::dvec2> mVertices;
+  std::vector<Face>       mFaces;
+
+  /// The faces which have been modified by the last insertion. This is used by refine() in order
+  /// to check only the new faces.
+  std::vector<int32_t> mTouchedFaces;
+
+  /// The face from which the next point location starts.
+  int32_t mLastFace = 0;
+
+  /// Length of the diagonal of the bounding box of the polygon.
+  double mDiameter = 0.0;
+};
+
+} // namespace csp::measurementtools
+
+#endif // CSP_MEASUREMENT_TOOLS_DELAUNAY_MESH_HPP
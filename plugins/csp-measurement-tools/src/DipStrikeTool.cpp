@@ -23,6 +23,7 @@
 #include <VistaKernel/VistaSystem.h>
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
 
+#include <chrono>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -244,17 +245,44 @@ void DipStrikeTool::calculateDipAndStrike() {
     mPosition += mark->getPosition() / static_cast<double>(mPoints.size());
   }
 
+  // LongLat coordinates of the points, their heights are retrieved in one batch
+  mSampledLngLats.clear();
+  for (auto const& mark : mPoints) {
+    mSampledLngLats.push_back(cs::utils::convert::cartesianToLngLat(mark->getPosition(), radii));
+  }
+
+  // Fit the plane with the heights which are available right now. If the surface provides more
+  // accurate heights later on, the plane is updated in update(). The query for the previous points
+  // is cancelled first, so that the surface does not load any tiles for it anymore.
+  mRefinedHeights      = {};
+  mRefinedHeightsToken = nullptr;
+
+  if (object->getSurface()) {
+    auto query           = object->getSurface()->queryHeights(mSampledLngLats);
+    mRefinedHeights      = std::move(query.mRefined);
+    mRefinedHeightsToken = std::move(query.mToken);
+    calculateDipAndStrike(query.mEstimate);
+  } else {
+    calculateDipAndStrike(std::vector<double>(mSampledLngLats.size(), 0.0));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DipStrikeTool::calculateDipAndStrike(std::vector<double> const& heights) {
+  auto object = mSolarSystem->getObject(getObjectName());
+  auto radii  = object->getRadii();
+
+  // Cartesian coordinates with height
+  std::vector<glm::dvec3> positionsNorm;
+  for (std::size_t i = 0; i < mSampledLngLats.size(); ++i) {
+    positionsNorm.push_back(cs::utils::convert::toCartesian(mSampledLngLats[i], radii, heights[i]));
+  }
+
   // corrected average position (works for every height scale)
   // average position of the coordinates without height exaggeration
   glm::dvec3 averagePositionNorm(0.0);
-  for (auto const& mark : mPoints) {
-    // LongLat coordinate
-    glm::dvec2 l = cs::utils::convert::cartesianToLngLat(mark->getPosition(), radii);
-    // Height of the point
-    double h = object->getSurface() ? object->getSurface()->getHeight(l) : 0.0;
-    // Cartesian coordinate with height
-    glm::dvec3 posNorm = cs::utils::convert::toCartesian(l, radii, h);
-
+  for (auto const& posNorm : positionsNorm) {
     averagePositionNorm += posNorm / static_cast<double>(mPoints.size());
   }
 
@@ -268,11 +296,7 @@ void DipStrikeTool::calculateDipAndStrike() {
   mSize                 = 0;
   mOffset               = 0.F;
 
-  for (auto const& p : mPoints) {
-    glm::dvec2 l       = cs::utils::convert::cartesianToLngLat(p->getPosition(), radii);
-    double     h       = object->getSurface() ? object->getSurface()->getHeight(l) : 0.0;
-    glm::dvec3 posNorm = cs::utils::convert::toCartesian(l, radii, h);
-
+  for (auto const& posNorm : positionsNorm) {
     glm::dvec3 relativePosition = posNorm - averagePositionNorm;
 
     mSize = std::max(mSize, glm::length(relativePosition));
@@ -330,6 +354,10 @@ void DipStrikeTool::update() {
   if (mVerticesDirty) {
     calculateDipAndStrike();
     mVerticesDirty = false;
+  } else if (mRefinedHeights.valid() &&
+             mRefinedHeights.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    calculateDipAndStrike(mRefinedHeights.get());
+    mRefinedHeightsToken = nullptr;
   }
 
   auto object = mSolarSystem->getObject(getObjectName());
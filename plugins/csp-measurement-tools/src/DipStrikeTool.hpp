@@ -14,7 +14,9 @@
 #include <VistaOGLExt/VistaBufferObject.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 
+#include <future>
 #include <glm/glm.hpp>
+#include <memory>
 #include <vector>
 
 namespace cs::gui {
@@ -64,6 +66,9 @@ class DipStrikeTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool
  private:
   void calculateDipAndStrike();
 
+  /// Fits the plane to mSampledLngLats and the given heights.
+  void calculateDipAndStrike(std::vector<double> const& heights);
+
   /// Returns the interpolated position in cartesian coordinates the fourth component is height
   /// above the surface.
   glm::dvec4 getInterpolatedPosBetweenTwoMarks(csl::tools::DeletableMark const& pMark1,
@@ -98,6 +103,12 @@ class DipStrikeTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool
   glm::vec3  mNormal = glm::vec3(0.0), mMip = glm::vec3(0.0);
   float      mOffset{};
 
+  /// If the surface was not fully loaded when the points were sampled, this receives refined
+  /// heights for mSampledLngLats later on. Resetting mRefinedHeightsToken cancels the query.
+  std::vector<glm::dvec2>          mSampledLngLats;
+  std::future<std::vector<double>> mRefinedHeights;
+  std::shared_ptr<void>            mRefinedHeightsToken;
+
   int mTextConnection  = -1;
   int mScaleConnection = -1;
 
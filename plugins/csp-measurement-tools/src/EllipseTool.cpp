@@ -20,6 +20,7 @@
 #include <VistaKernel/VistaSystem.h>
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
 
+#include <chrono>
 #include <glm/gtc/type_ptr.hpp>
 
 namespace csp::measurementtools {
@@ -211,18 +212,43 @@ void EllipseTool::calculateVertices() {
   auto radii  = object->getRadii();
   auto center = mCenterHandle.getPosition();
 
-  std::vector<glm::vec3> vRelativePositions(mNumSamples);
+  mSampledLngLats.resize(mNumSamples);
   for (int i = 0; i < mNumSamples; ++i) {
     double phi = glm::mix(0.0, 2.0 * glm::pi<double>(), 1.0 * i / (mNumSamples - 1));
     double x   = std::sin(phi);
     double y   = std::cos(phi);
 
     glm::dvec3 absPosition = center + x * mAxes[0] + y * mAxes[1];
-    glm::dvec2 lngLat      = cs::utils::convert::cartesianToLngLat(absPosition, radii);
+    mSampledLngLats[i]     = cs::utils::convert::cartesianToLngLat(absPosition, radii);
+  }
+
+  // The heights of all samples are retrieved in one batch. If the surface provides more accurate
+  // heights later on, the vertices are updated in update(). The query for the previous samples is
+  // cancelled first, so that the surface does not load any tiles for it anymore.
+  mRefinedHeights      = {};
+  mRefinedHeightsToken = nullptr;
+
+  if (object->getSurface()) {
+    auto query           = object->getSurface()->queryHeights(mSampledLngLats);
+    mRefinedHeights      = std::move(query.mRefined);
+    mRefinedHeightsToken = std::move(query.mToken);
+    calculateVertices(query.mEstimate);
+  } else {
+    calculateVertices(std::vector<double>(mSampledLngLats.size(), 0.0));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    double height = object->getSurface() ? object->getSurface()->getHeight(lngLat) : 0.0;
-    height *= mSettings->mGraphics.pHeightScale.get();
-    absPosition = cs::utils::convert::toCartesian(lngLat, radii, height);
+void EllipseTool::calculateVertices(std::vector<double> const& heights) {
+  auto object = mSolarSystem->getObject(getObjectName());
+  auto radii  = object->getRadii();
+  auto center = mCenterHandle.getPosition();
+
+  std::vector<glm::vec3> vRelativePositions(mNumSamples);
+  for (int i = 0; i < mNumSamples; ++i) {
+    double     height      = heights[i] * mSettings->mGraphics.pHeightScale.get();
+    glm::dvec3 absPosition = cs::utils::convert::toCartesian(mSampledLngLats[i], radii, height);
 
     vRelativePositions[i] = absPosition - center;
   }
@@ -242,6 +268,10 @@ void EllipseTool::update() {
   if (mVerticesDirty) {
     calculateVertices();
     mVerticesDirty = false;
+  } else if (mRefinedHeights.valid() &&
+             mRefinedHeights.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    calculateVertices(mRefinedHeights.get());
+    mRefinedHeightsToken = nullptr;
   }
 
   auto object    = mSolarSystem->getObject(getObjectName());
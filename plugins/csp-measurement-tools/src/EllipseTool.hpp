@@ -14,6 +14,9 @@
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 
 #include <array>
+#include <future>
+#include <memory>
+#include <vector>
 
 namespace csp::measurementtools {
 
@@ -58,6 +61,9 @@ class EllipseTool : public IVistaOpenGLDraw, public csl::tools::Tool {
  private:
   void calculateVertices();
 
+  /// Uploads the vertices of the ellipse from mSampledLngLats and the given heights.
+  void calculateVertices(std::vector<double> const& heights);
+
   std::shared_ptr<cs::core::SolarSystem> mSolarSystem;
   std::shared_ptr<cs::core::Settings>    mSettings;
   std::shared_ptr<cs::core::TimeControl> mTimeControl;
@@ -67,6 +73,12 @@ class EllipseTool : public IVistaOpenGLDraw, public csl::tools::Tool {
   bool mVerticesDirty = false;
   bool mFirstUpdate   = true;
 
+  /// If the surface was not fully loaded when the ellipse was sampled, this receives refined
+  /// heights for mSampledLngLats later on. Resetting mRefinedHeightsToken cancels the query.
+  std::vector<glm::dvec2>          mSampledLngLats;
+  std::future<std::vector<double>> mRefinedHeights;
+  std::shared_ptr<void>            mRefinedHeightsToken;
+
   FlagTool                                         mCenterHandle;
   std::array<glm::dvec3, 2>                        mAxes;
   std::array<std::unique_ptr<csl::tools::Mark>, 2> mHandles;
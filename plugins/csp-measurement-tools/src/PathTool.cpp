@@ -26,6 +26,7 @@
 #include <VistaKernel/VistaSystem.h>
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
 
+#include <chrono>
 #include <glm/gtc/type_ptr.hpp>
 
 namespace csp::measurementtools {
@@ -163,8 +164,8 @@ void PathTool::setNumSamples(int const& numSamples) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-glm::dvec4 PathTool::getInterpolatedPosBetweenTwoMarks(csl::tools::DeletableMark const& l0,
-    csl::tools::DeletableMark const& l1, double value, double const& scale) {
+glm::dvec2 PathTool::getInterpolatedLngLatBetweenTwoMarks(
+    csl::tools::DeletableMark const& l0, csl::tools::DeletableMark const& l1, double value) {
 
   auto       object = mSolarSystem->getObject(getObjectName());
   glm::dvec3 radii  = object->getRadii();
@@ -174,12 +175,7 @@ glm::dvec4 PathTool::getInterpolatedPosBetweenTwoMarks(csl::tools::DeletableMark
   glm::dvec3 p1              = cs::utils::convert::toCartesian(l1.pLngLat.get(), radii, 0.0);
   glm::dvec3 interpolatedPos = p0 + (value * (p1 - p0));
 
-  // Calc final position
-  glm::dvec2 ll     = cs::utils::convert::cartesianToLngLat(interpolatedPos, radii);
-  double     height = (object->getSurface() ? object->getSurface()->getHeight(ll) : 0.0) * scale;
-  glm::dvec3 pos    = cs::utils::convert::toCartesian(ll, radii, height);
-
-  return glm::dvec4(pos, height);
+  return cs::utils::convert::cartesianToLngLat(interpolatedPos, radii);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -207,9 +203,6 @@ void PathTool::updateLineVertices() {
     return;
   }
 
-  // Fill the vertex buffer with sampled data
-  mSampledPositions.clear();
-
   auto object = mSolarSystem->getObject(getObjectName());
 
   mPosition = glm::dvec3(0.0);
@@ -217,45 +210,74 @@ void PathTool::updateLineVertices() {
     mPosition += mark->getPosition() / static_cast<double>(mPoints.size());
   }
 
-  double heightScale = mSettings->mGraphics.pHeightScale.get();
-  auto   lastMark    = mPoints.begin();
-  auto   currMark    = ++mPoints.begin();
+  auto lastMark = mPoints.begin();
+  auto currMark = ++mPoints.begin();
 
-  std::stringstream json;
-  std::string       jsonSeperator;
-  double            distance = -1;
-  glm::dvec3        lastPos(0.0);
+  // generate X points for each line segment, their heights are retrieved in one batch
+  mSampledLngLats.clear();
 
   while (currMark != mPoints.end()) {
-    // generate X points for each line segment
     for (int vertex_id = 0; vertex_id < mNumSamples; vertex_id++) {
-      glm::dvec4 pos = getInterpolatedPosBetweenTwoMarks(
-          **lastMark, **currMark, (vertex_id / static_cast<double>(mNumSamples)), heightScale);
-      mSampledPositions.push_back(pos.xyz());
-
-      // coordinate normalized by height scale; to count distance correctly
-      glm::dvec4 posNorm = pos;
-      if (heightScale != 1) {
-        posNorm = getInterpolatedPosBetweenTwoMarks(
-            **lastMark, **currMark, (vertex_id / static_cast<double>(mNumSamples)), 1);
-      }
-
-      if (distance < 0) {
-        distance = 0;
-      } else {
-        distance += glm::length(posNorm.xyz() - lastPos);
-      }
-
-      json << jsonSeperator << "[" << distance << "," << pos.w / heightScale << "]";
-      jsonSeperator = ",";
-
-      lastPos = posNorm.xyz();
+      mSampledLngLats.push_back(getInterpolatedLngLatBetweenTwoMarks(
+          **lastMark, **currMark, (vertex_id / static_cast<double>(mNumSamples))));
     }
 
     lastMark = currMark;
     ++currMark;
   }
 
+  // Draw the path with the heights which are available right now. If the surface provides more
+  // accurate heights later on, the path is updated in update(). The query for the previous path is
+  // cancelled first, so that the surface does not load any tiles for it anymore.
+  mRefinedHeights      = {};
+  mRefinedHeightsToken = nullptr;
+
+  if (object->getSurface()) {
+    auto query           = object->getSurface()->queryHeights(mSampledLngLats);
+    mRefinedHeights      = std::move(query.mRefined);
+    mRefinedHeightsToken = std::move(query.mToken);
+    updateLineVertices(query.mEstimate);
+  } else {
+    updateLineVertices(std::vector<double>(mSampledLngLats.size(), 0.0));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PathTool::updateLineVertices(std::vector<double> const& heights) {
+  // Fill the vertex buffer with sampled data
+  mSampledPositions.clear();
+
+  auto object = mSolarSystem->getObject(getObjectName());
+
+  double      heightScale = mSettings->mGraphics.pHeightScale.get();
+  glm::dvec3  radii       = object->getRadii();
+  auto const& lngLats     = mSampledLngLats;
+
+  std::stringstream json;
+  std::string       jsonSeperator;
+  double            distance = -1;
+  glm::dvec3        lastPos(0.0);
+
+  for (std::size_t i = 0; i < lngLats.size(); ++i) {
+    glm::dvec3 pos = cs::utils::convert::toCartesian(lngLats[i], radii, heights[i] * heightScale);
+    mSampledPositions.push_back(pos);
+
+    // coordinate normalized by height scale; to count distance correctly
+    glm::dvec3 posNorm = cs::utils::convert::toCartesian(lngLats[i], radii, heights[i]);
+
+    if (distance < 0) {
+      distance = 0;
+    } else {
+      distance += glm::length(posNorm - lastPos);
+    }
+
+    json << jsonSeperator << "[" << distance << "," << heights[i] << "]";
+    jsonSeperator = ",";
+
+    lastPos = posNorm;
+  }
+
   mGuiItem->callJavascript("setData", "[" + json.str() + "]");
 
   mIndexCount = mSampledPositions.size();
@@ -277,6 +299,10 @@ void PathTool::update() {
   if (mVerticesDirty) {
     updateLineVertices();
     mVerticesDirty = false;
+  } else if (mRefinedHeights.valid() &&
+             mRefinedHeights.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    updateLineVertices(mRefinedHeights.get());
+    mRefinedHeightsToken = nullptr;
   }
 
   auto object = mSolarSystem->getObject(getObjectName());
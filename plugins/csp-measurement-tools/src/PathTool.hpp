@@ -14,7 +14,9 @@
 #include <VistaOGLExt/VistaBufferObject.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 
+#include <future>
 #include <glm/glm.hpp>
+#include <memory>
 #include <vector>
 
 namespace cs::gui {
@@ -60,10 +62,12 @@ class PathTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
  private:
   void updateLineVertices();
 
-  /// Returns the interpolated position in cartesian coordinates. The fourth component is height
-  /// above the surface.
-  glm::dvec4 getInterpolatedPosBetweenTwoMarks(csl::tools::DeletableMark const& l0,
-      csl::tools::DeletableMark const& l1, double value, double const& scale);
+  /// Builds the line and the elevation profile from mSampledLngLats and the given heights.
+  void updateLineVertices(std::vector<double> const& heights);
+
+  /// Returns the interpolated position in longitude and latitude.
+  glm::dvec2 getInterpolatedLngLatBetweenTwoMarks(
+      csl::tools::DeletableMark const& l0, csl::tools::DeletableMark const& l1, double value);
 
   /// These are called by the base class MultiPointTool.
   void onPointMoved() override;
@@ -87,11 +91,17 @@ class PathTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
     uint32_t color            = 0;
   } mUniforms;
 
+  std::vector<glm::dvec2> mSampledLngLats;
   std::vector<glm::dvec3> mSampledPositions;
   glm::dvec3              mPosition{};
   size_t                  mIndexCount    = 0;
   bool                    mVerticesDirty = false;
 
+  /// If the surface was not fully loaded when the path was sampled, this receives refined heights
+  /// for mSampledLngLats later on. Resetting mRefinedHeightsToken cancels the query.
+  std::future<std::vector<double>> mRefinedHeights;
+  std::shared_ptr<void>            mRefinedHeightsToken;
+
   int mScaleConnection = -1;
   int mTextConnection  = -1;
   int mNumSamples      = 256;
@@ -27,11 +27,29 @@
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
 
 #include <glm/gtc/type_ptr.hpp>
+#include <array>
+#include <chrono>
 
 namespace csp::measurementtools {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// Returns the heights at the given positions. If there is no surface, all heights are zero.
+std::vector<double> getHeights(std::shared_ptr<cs::scene::CelestialSurface> const& surface,
+    std::vector<glm::dvec2> const& lngLats) {
+  if (surface) {
+    return surface->getHeights(lngLats);
+  }
+
+  return std::vector<double>(lngLats.size(), 0.0);
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 const int PolygonTool::NUM_SAMPLES = 256;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -152,6 +170,9 @@ PolygonTool::PolygonTool(std::shared_ptr<cs::core::InputManager> pInputManager,
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 PolygonTool::~PolygonTool() {
+  // Stops a running mesh refinement, mMeshTasks waits for it.
+  cancelMesh();
+
   mSettings->mGraphics.pHeightScale.disconnect(mScaleConnection);
   mGuiItem->unregisterCallback("deleteMe");
   mGuiItem->unregisterCallback("setAddPointMode");
@@ -202,8 +223,7 @@ void PolygonTool::setSleekness(uint32_t degree) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-glm::dvec4 PolygonTool::getInterpolatedPosBetweenTwoMarks(
-    std::shared_ptr<cs::scene::CelestialSurface> const& surface,
+glm::dvec2 PolygonTool::getInterpolatedLngLatBetweenTwoMarks(
     csl::tools::DeletableMark const& l0, csl::tools::DeletableMark const& l1, double value) {
 
   auto       object = mSolarSystem->getObject(getObjectName());
@@ -214,549 +234,275 @@ glm::dvec4 PolygonTool::getInterpolatedPosBetweenTwoMarks(
   glm::dvec3 p1              = cs::utils::convert::toCartesian(l1.pLngLat.get(), radii, 0.0);
   glm::dvec3 interpolatedPos = p0 + (value * (p1 - p0));
 
-  // Calculates final position
-  double     heightScale = mSettings->mGraphics.pHeightScale.get();
-  glm::dvec2 ll          = cs::utils::convert::cartesianToLngLat(interpolatedPos, radii);
-  double     height      = (surface ? surface->getHeight(ll) : 0.0) * heightScale;
-  glm::dvec3 pos         = cs::utils::convert::toCartesian(ll, radii, height);
-  return {pos, height};
+  return cs::utils::convert::cartesianToLngLat(interpolatedPos, radii);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Based on
-// https://stackoverflow.com/questions/8721406/how-to-determine-if-a-point-is-inside-a-2d-convex-polygon
-bool PolygonTool::checkPoint(glm::dvec2 const& point) {
-  bool result = false;
-
-  // Positive x (other directions could be compared, but it works reliable with only one direction)
-  for (size_t i = 0, j = mCorners.size() - 1; i < mCorners.size(); j = i++) {
-    if (((mCorners[i].mY > point.y) != (mCorners[j].mY > point.y) &&
-            (point.x < (mCorners[j].mX - mCorners[i].mX) * (point.y - mCorners[i].mY) /
-                               (mCorners[j].mY - mCorners[i].mY) +
-                           mCorners[i].mX)) ||
-        // Checks surroundings to avoid numerical errors
-        ((mCorners[i].mY > point.y) != (mCorners[j].mY > point.y) &&
-            std::abs(point.x - ((mCorners[j].mX - mCorners[i].mX) * (point.y - mCorners[i].mY) /
-                                       (mCorners[j].mY - mCorners[i].mY) +
-                                   mCorners[i].mX)) < 0.001)) {
-      result = !result;
-    }
-  }
-  return result;
+glm::dvec3 PolygonTool::getSurfacePoint(
+    glm::dvec2 const& planePoint, glm::dvec3 const& radii) const {
+  return glm::normalize(mMiddlePoint + mPlaneScale * planePoint.x * mEast +
+                        mPlaneScale * planePoint.y * mNorth) *
+         radii[0];
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool PolygonTool::findIntersection(Site const& s1, Site const& s2, Site const& s3, Site const& s4,
-    double& intersectionX, double& intersectionY) {
-  // Avoids division with 0
-  if ((s1.mX == 0) || (s2.mX == 0) || (s3.mX == 0) || (s4.mX == 0) || (s1.mY == 0) ||
-      (s2.mY == 0) || (s3.mY == 0) || (s4.mY == 0)) {
-    return false;
-  }
+void PolygonTool::requestMesh(
+    std::shared_ptr<DelaunayMesh const> base, std::vector<glm::dvec2> points) {
+
+  // The result of a running job would be discarded anyways, so it is stopped early.
+  cancelMesh();
 
-  // Based on
-  // http://www.softwareandfinance.com/Visual_CPP/VCPP_Intersection_Two_lines_EndPoints.html
-
-  // Safety band - to avoid point duplications - set to 1%
-  double safety = 0.01;
-
-  double m1{};
-  double m2{};
-  double c1{};
-  double c2{};
-
-  // Line 1 (y = m1 * x + c1)
-  m1 = (s2.mY - s1.mY) / (s2.mX - s1.mX);
-  c1 = s1.mY - m1 * s1.mX;
-
-  // Line 2 (y = m2 * x + c2)
-  m2 = (s4.mY - s3.mY) / (s4.mX - s3.mX);
-  c2 = s3.mY - m2 * s3.mX;
-
-  // Edges are not exactly parallel
-  if (m1 != m2) {
-    // Intersection of lines
-    intersectionX = (c2 - c1) / (m1 - m2);
-    intersectionY = m1 * (intersectionX) + c1;
-
-    // Checks if intersection point is on the edges or not (between a bounding box)
-    if (((s1.mX > intersectionX) != (s2.mX > intersectionX)) &&
-        ((s3.mX > intersectionX) != (s4.mX > intersectionX)) &&
-        ((s1.mY > intersectionY) != (s2.mY > intersectionY)) &&
-        ((s3.mY > intersectionY) != (s4.mY > intersectionY))) {
-      // Checks all 4 points: do not return with an intersection point within the safety band
-      if (((std::abs((s1.mX - intersectionX) / s1.mX) > safety) ||
-              (std::abs((s1.mY - intersectionY) / s1.mY) > safety)) &&
-          ((std::abs((s2.mX - intersectionX) / s2.mX) > safety) ||
-              (std::abs((s2.mY - intersectionY) / s2.mY) > safety)) &&
-          ((std::abs((s3.mX - intersectionX) / s3.mX) > safety) ||
-              (std::abs((s3.mY - intersectionY) / s3.mY) > safety)) &&
-          ((std::abs((s4.mX - intersectionX) / s4.mX) > safety) ||
-              (std::abs((s4.mY - intersectionY) / s4.mY) > safety))) {
-        return true;
+  mMeshCancelled = std::make_shared<std::atomic<bool>>(false);
+
+  double      minAngle  = mSleekness;
+  std::size_t maxPoints = mMaxPoints;
+
+  mNextMesh = mMeshTasks.enqueue([base = std::move(base), points = std::move(points),
+                                     cancelled = mMeshCancelled, minAngle,
+                                     maxPoints]() -> std::shared_ptr<DelaunayMesh const> {
+    auto mesh = base ? std::make_shared<DelaunayMesh>(*base) : std::make_shared<DelaunayMesh>();
+
+    if (base) {
+      for (auto const& point : points) {
+        mesh->insertPoint(point);
       }
+    } else if (!mesh->triangulate(points)) {
+      return nullptr;
     }
+
+    mesh->refine(minAngle, maxPoints, cancelled.get());
+
+    return mesh;
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PolygonTool::cancelMesh() {
+  if (mMeshCancelled) {
+    *mMeshCancelled = true;
   }
-  return false;
+
+  mNextMesh = {};
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void PolygonTool::createMesh(std::vector<Triangle>& triangles) {
-  bool edgesOK = false;
-  int  it      = 0;
-
-  // Does the triangulaiton of the original polygon
-  // Checks and refines the triangulation until all original edges of the polygon are in the
-  // triangulation Quits after 5 iteration to avoid performance issues and displays error message
-  while (!edgesOK && it < 5) {
-    it++;
-
-    // Performs the Delaunay triangulation
-    VoronoiGenerator voronoi;
-    voronoi.parse(mCorners);
-
-    // Number of the original edges of the polygon
-    size_t countEdges = mCorners.size();
-
-    // Vector of the original edges of the polygon from Delaunay triangulation
-    std::vector<Edge2> voronoiEdges;
-
-    for (auto const& s : voronoi.getTriangulation()) {
-      // Finds original edges based on their addresses
-      if (((std::abs(s.second.mAddr - s.first.mAddr) == 1 ||
-               (std::abs(s.second.mAddr - s.first.mAddr) == mCorners.size() - 1)) &&
-              s.first.mAddr < mCorners.size() && s.second.mAddr < mCorners.size())) {
-        // Counts found edges
-        countEdges--;
-
-        Site site1(0, 0, 0);
-        Site site2(0, 0, 0);
-
-        // Orders addresses of the found edge
-        if (((s.first.mAddr == mCorners.size() - 1) && (s.second.mAddr == 0)) ||
-            ((s.second.mAddr > s.first.mAddr) &&
-                !((s.first.mAddr == 0) && (s.second.mAddr == mCorners.size() - 1)))) {
-          site1 = s.first;
-          site2 = s.second;
-        } else {
-          site1 = s.second;
-          site2 = s.first;
-        }
-        // Saves edges of the triangulation
-        voronoiEdges.emplace_back(site1, site2);
-      }
-    }
+void PolygonTool::applyMesh(std::shared_ptr<DelaunayMesh const> const& mesh) {
+  mTriangulation.clear();
 
-    // If some of the polygon edges did not match with a voronoi edge
-    // This means, that some edges are missing, and need to be recovered
-    // Intersection points of the missing edges and voronoi edges need to determined
-    // These points are added to mCorners, and the triangulation hopefully
-    // solves the problem in the next cycle (works for most of the cases)
-    if (countEdges != 0) {
-      // Vector of corners on missing edges - to be added to mCorners
-      std::vector<Site> addCorners;
-
-      // Finds the missing edges: search for every original edge in voronoiEdges
-      // (the original polygon edges have neighbor addresses -> searches for corners)
-      for (size_t i = 0; i < mCorners.size(); i++) {
-        bool       found = false;
-        glm::ivec2 missingAddr;
-
-        // In case of the last line of the polygon
-        if (i == (mCorners.size() - 1)) {
-          for (auto const& v : voronoiEdges) {
-            if ((v.first.mAddr == i) && (v.second.mAddr == 0)) {
-              found = true;
-            }
-          }
+  double area      = 0;
+  double negVolume = 0;
+  double posVolume = 0;
+
+  if (mesh) {
+    auto       object      = mSolarSystem->getObject(getObjectName());
+    auto       surface     = object->getSurface();
+    double     heightScale = mSettings->mGraphics.pHeightScale.get();
+    glm::dvec3 radii       = object->getRadii();
+
+    // Cartesian coordinates without height, LongLat coordinates and heights of all vertices
+    auto const&             vertices = mesh->getVertices();
+    std::vector<glm::dvec3> positions;
+    std::vector<glm::dvec2> lngLats;
+    positions.reserve(vertices.size());
+    lngLats.reserve(vertices.size());
+
+    for (auto const& vertex : vertices) {
+      positions.push_back(getSurfacePoint(vertex, radii));
+      lngLats.push_back(cs::utils::convert::cartesianToLngLat(positions.back(), radii));
+    }
 
-          if (!found) {
-            missingAddr = glm::ivec2(i, 0);
-          }
-        }
-        // Every other line
-        else {
-          for (auto const& v : voronoiEdges) {
-            if ((v.first.mAddr == i) && (v.second.mAddr == i + 1)) {
-              found = true;
-            }
-          }
-          if (!found) {
-            missingAddr = glm::ivec2(i, i + 1);
-          }
-        }
+    std::vector<double> heights = getHeights(surface, lngLats);
 
-        // If this edge is missing
-        if (!found) {
-          // Points of the missing edge
-          Site              site1(0, 0, 0);
-          Site              site2(0, 0, 0);
-          std::vector<Site> sites;
-
-          // Pairs the known addresses of the missing edge with sites
-          for (auto const& s : voronoi.getTriangulation()) {
-            if (s.first.mAddr == missingAddr.x) {
-              site1 = s.first;
-            }
-            if (s.second.mAddr == missingAddr.x) {
-              site1 = s.second;
-            }
-
-            if (s.first.mAddr == missingAddr.y) {
-              site2 = s.first;
-            }
-            if (s.second.mAddr == missingAddr.y) {
-              site2 = s.second;
-            }
-          }
+    // Emplaces back the end points of all edges in Cartesian (on planet surface) with height for
+    // display
+    for (auto const& [v1, v2] : mesh->getEdges()) {
+      for (uint32_t v : {v1, v2}) {
+        mTriangulation.emplace_back(
+            cs::utils::convert::toCartesian(lngLats[v], radii, heights[v] * heightScale));
+      }
+    }
 
-          // Finds intersecting edges (if a triangulation edge intersects the original polygon edge,
-          // it is wrong)
-          for (auto const& s : voronoi.getTriangulation()) {
-            double intersectionX{};
-            double intersectionY{};
-
-            if (findIntersection(site1, site2, s.first, s.second, intersectionX, intersectionY)) {
-              int addrNew =
-                  site1.mAddr + 1; // = site2.mAddr (except for the last edge, where site2.mAddr=0!
-              Site oldCorner(0, 0, 0);
-              bool done = false;
-
-              // Cycles through addCorners vector and saves current intersection into the right
-              // place
-              for (auto& addCorner : addCorners) {
-                // If current intersection is not saved yet
-                if (!done) {
-                  // Compares addresses of the two intersection
-                  if (addCorner.mAddr < addrNew) {
-                    // Skips first elements of vector
-                  } else if (addCorner.mAddr == addrNew) {
-                    // If edges points to positive x
-                    if (intersectionX > site1.mX) {
-                      // Saves intersection only when it is in front of the
-                      // existing intersection; otherwise it will be handled
-                      // in the next cycle
-                      if (addCorner.mX > intersectionX) {
-                        // Saves existing intersection to oldCorner
-                        // will be placed back to vector in the next cycle
-                        oldCorner = addCorner;
-                        addCorner = Site(intersectionX, intersectionY, addrNew);
-                        done      = true;
-                      }
-                    }
-                    // If edges points to negative x
-                    else if (intersectionX < site1.mX) {
-                      if (addCorner.mX < intersectionX) {
-                        oldCorner = addCorner;
-                        addCorner = Site(intersectionX, intersectionY, addrNew);
-                        done      = true;
-                      }
-                    }
-                    // Handles the very rare case of a vertical edge
-                    // Does the same, as before, just now with y coordinates
-                    else if (intersectionX == site1.mX) {
-                      if (intersectionY > site1.mY) {
-                        if (addCorner.mY > intersectionY) {
-                          oldCorner = addCorner;
-                          addCorner = Site(intersectionX, intersectionY, addrNew);
-                          done      = true;
-                        }
-                      } else if (intersectionY < site1.mY) {
-                        if (addCorner.mY < intersectionY) {
-                          oldCorner = addCorner;
-                          addCorner = Site(intersectionX, intersectionY, addrNew);
-                          done      = true;
-                        }
-                      }
-                    } // if (intersectionX==s.first.mX)
-                  }   // if (addCorners[i].mAddr == addrNew)
-                  // if (addCorners[i].mAddr > addrNew)
-                  else {
-                    oldCorner = addCorner;
-                    addCorner = Site(intersectionX, intersectionY, addrNew);
-                    done      = true;
-                  }
-                } // if (!done)
-                else {
-                  // After the current intersecting point is added to the middle of the vector
-                  // shifts back every other element by one position
-                  Site newCorner = addCorner;
-                  addCorner      = oldCorner;
-                  oldCorner      = newCorner;
-                }
-              } // for (int i = 0; i < addCorners.size(); i++)
-
-              // If the current intersection was placed in the vector
-              if (done) {
-                // Emplaces the last element to the end of the vector
-                addCorners.emplace_back(oldCorner);
-              } else {
-                // Emplaces back current intersection to the end of the vector
-                addCorners.emplace_back(Site(intersectionX, intersectionY, addrNew));
-              }
-
-              // Corners needed to be added -> run the cycle again
-              edgesOK = false;
-            } // if (findIntersection(...))
-          }   // for (auto const& s : triangulation)
-        }     // if (!found)
-      }       // for (int i = 0; i < mCorners.size(); i++)
-
-      // Counts the intersection corners already added to mCorners
-      int cornerCount = 0;
-
-      // Goes through the intersection corners and adds them to the right place of mCorners
-      for (auto const& c : addCorners) {
-        // Address of the intersection if it is the only one in the vector
-        int addr3 = c.mAddr;
-        addr3 += cornerCount;
-
-        // If intersection is not between last and first Site
-        if (addr3 < static_cast<int>(mCorners.size())) {
-          // Saves intersection corner to mCorners and element of mCorners to oldSite
-          Site oldSite    = mCorners[addr3];
-          mCorners[addr3] = Site(c.mX, c.mY, addr3);
-
-          addr3++;
-
-          // Shifts every other corner of mCorners behind by one
-          for (; addr3 < static_cast<int>(mCorners.size()); addr3++) {
-            Site newSite    = mCorners[addr3];
-            mCorners[addr3] = Site(oldSite.mX, oldSite.mY, addr3);
-            oldSite         = newSite;
-          }
+    calculateAreaAndVolume(surface, mesh->getTriangles(), positions, lngLats, heights, radii, area,
+        posVolume, negVolume);
 
-          // Emplaces back the last corner
-          mCorners.emplace_back(Site(oldSite.mX, oldSite.mY, addr3));
-        } else {
-          // Emplaces back the intersection corner
-          mCorners.emplace_back(Site(c.mX, c.mY, addr3));
-        }
+    // Refines the mesh until it matches the terrain or mMaxAttempt or mMaxPoints is reached
+    if (mRefinementAttempt + 1 < mMaxAttempt && vertices.size() < mMaxPoints) {
+      auto points = getTerrainRefinementPoints(surface, *mesh, heights, radii);
+      points.resize(std::min<std::size_t>(points.size(), mMaxPoints - vertices.size()));
 
-        cornerCount++;
+      if (!points.empty()) {
+        ++mRefinementAttempt;
+        requestMesh(mesh, std::move(points));
       }
-    } // if (countEdges != 0)
-    else {
-      // All of the original edges are in voronoiEdges -> no need for an other cycle
-      edgesOK = true;
     }
-    // Saves the original triangles
-    triangles = voronoi.getTriangles();
-  } // while (!edgesOK && it < 5)
-
-  // If the voronoi edges are still wrong after 5 cycles of refinement, display the problem
-  if (!edgesOK) {
-    logger().warn("Area calculation can be false: Concave or self-intersecting polygon! Check "
-                  "triangulation mesh.");
+  } else {
+    logger().warn("Cannot calculate area and volume: The polygon is self-intersecting!");
+  }
+
+  // Displays values
+  if (!std::isnan(area)) {
+    mGuiItem->callJavascript("setArea", area);
+  } else {
+    mGuiItem->callJavascript("setArea", 0);
+  }
+
+  if ((!std::isnan(posVolume)) && (!std::isnan(negVolume))) {
+    mGuiItem->callJavascript("setVolume", posVolume, negVolume);
+  } else if (!std::isnan(negVolume)) {
+    mGuiItem->callJavascript("setVolume", 0, negVolume);
+  } else if (!std::isnan(posVolume)) {
+    mGuiItem->callJavascript("setVolume", posVolume, 0);
+  } else {
+    mGuiItem->callJavascript("setVolume", 0, 0);
   }
+
+  // Uploads the new mesh at once, so that Do() never draws a partially updated mesh
+  mIndexCount2 = mTriangulation.size();
+
+  mVBO2.Bind(GL_ARRAY_BUFFER);
+  mVBO2.BufferData(mTriangulation.size() * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
+  mVBO2.Release();
+
+  mVAO2.EnableAttributeArray(0);
+  mVAO2.SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0, &mVBO2);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool PolygonTool::checkSleekness(int count) {
-  // Voronoi inside the original triangles - to check triangle angles
-  VoronoiGenerator voronoiCheck;
-  voronoiCheck.parse(mCornersFine[count]);
-
-  // Vector to save addresses of added points - to avoid adding the same point twice
-  std::vector<std::pair<int, int>> addedPoints;
-
-  // Checks triangle sleekness and add middle points to vector if they are too sleek
-  // Could be done in multiple iterations for a more precise result
-  for (auto const& t2 : voronoiCheck.getTriangles()) {
-    // Minimun angle criteria (for 2 simple cases, approximately correct in general)
-    float minAngle = mSleekness * glm::pi<float>() / 180;
-    // Ratio of two edges in triangle
-    float sleekness1 = 1 / std::sin(minAngle);
-    // Ration between the sum of 2 smaller edges and the long edge in triangle
-    float sleekness2 = 1 / std::cos(minAngle);
-
-    Site si1(0, 0, 0);
-    Site si2(0, 0, 0);
-    Site si3(0, 0, 0);
-    std::tie(si1, si2, si3) = t2;
-
-    // Length of the edges
-    double length1 = glm::length(glm::dvec2(si1.mX, si1.mY) - glm::dvec2(si2.mX, si2.mY));
-    double length2 = glm::length(glm::dvec2(si1.mX, si1.mY) - glm::dvec2(si3.mX, si3.mY));
-    double length3 = glm::length(glm::dvec2(si2.mX, si2.mY) - glm::dvec2(si3.mX, si3.mY));
-
-    // Edge 1 is too long compared to the others
-    if ((length2 * sleekness1 < length1) || (length3 * sleekness1 < length1) ||
-        (length2 + length3 < length1 * sleekness2)) {
-      bool addPoint = true;
-      // Checks previously added points if they are the same
-      for (auto const& addr : addedPoints) {
-        if (((addr.first == si1.mAddr) && (addr.second == si2.mAddr)) ||
-            ((addr.first == si2.mAddr) && (addr.second == si1.mAddr))) {
-          addPoint = false;
-        }
-      }
-      // If not, adds this point to vector
-      if (addPoint) {
-        mCornersFine[count].emplace_back((si1.mX + si2.mX) / 2, (si1.mY + si2.mY) / 2,
-            static_cast<uint16_t>(mCornersFine[count].size()));
-        addedPoints.emplace_back(si1.mAddr, si2.mAddr);
+std::vector<glm::dvec2> PolygonTool::getTerrainRefinementPoints(
+    std::shared_ptr<cs::scene::CelestialSurface> const& surface, DelaunayMesh const& mesh,
+    std::vector<double> const& heights, glm::dvec3 const& radii) const {
+
+  // Checks whether the height of the terrain differs too much from the interpolated height
+  auto isRough = [this](double height, double interpolated) {
+    return (height / interpolated > mHeightDiff) || (interpolated / height > mHeightDiff);
+  };
+
+  // The middle point, the trisecting points, etc. of each edge are sampled in one batch
+  const int         maxDivision    = 5;
+  const std::size_t samplesPerEdge = maxDivision * (maxDivision - 1) / 2;
+
+  auto const&             vertices = mesh.getVertices();
+  auto                    edges    = mesh.getEdges();
+  std::vector<glm::dvec2> samples;
+  std::vector<glm::dvec2> sampleLngLats;
+  samples.reserve(edges.size() * samplesPerEdge);
+  sampleLngLats.reserve(edges.size() * samplesPerEdge);
+
+  for (auto const& [v1, v2] : edges) {
+    for (int j = 2; j <= maxDivision; j++) {
+      for (int i = 1; i < j; i++) {
+        samples.push_back((vertices[v1] * static_cast<double>(i) +
+                              vertices[v2] * static_cast<double>(j - i)) /
+                          static_cast<double>(j));
+        sampleLngLats.push_back(
+            cs::utils::convert::cartesianToLngLat(getSurfacePoint(samples.back(), radii), radii));
       }
     }
+  }
 
-    // Edge 2 is too long compared to the others
-    if ((length1 * sleekness1 < length2) || (length3 * sleekness1 < length2) ||
-        (length1 + length3 < length2 * sleekness2)) {
-      bool addPoint = true;
-      for (auto const& addr : addedPoints) {
-        if (((addr.first == si1.mAddr) && (addr.second == si3.mAddr)) ||
-            ((addr.first == si3.mAddr) && (addr.second == si1.mAddr))) {
-          addPoint = false;
-        }
-      }
-      if (addPoint) {
-        mCornersFine[count].emplace_back((si1.mX + si3.mX) / 2, (si1.mY + si3.mY) / 2,
-            static_cast<uint16_t>(mCornersFine[count].size()));
-        addedPoints.emplace_back(si1.mAddr, si3.mAddr);
-      }
-    }
+  std::vector<double> sampleHeights = getHeights(surface, sampleLngLats);
+
+  // If the middle point of an edge is too far off, it is added. Else the trisecting points are
+  // checked, etc.
+  std::vector<glm::dvec2> points;
 
-    // Edge 3 is too long compared to the others
-    if ((length1 * sleekness1 < length3) || (length2 * sleekness1 < length3) ||
-        (length1 + length2 < length3 * sleekness2)) {
-      bool addPoint = true;
-      for (auto const& addr : addedPoints) {
-        if (((addr.first == si2.mAddr) && (addr.second == si3.mAddr)) ||
-            ((addr.first == si3.mAddr) && (addr.second == si2.mAddr))) {
-          addPoint = false;
+  for (std::size_t e = 0; e < edges.size(); ++e) {
+    double      h1     = heights[edges[e].first];
+    double      h2     = heights[edges[e].second];
+    std::size_t sample = e * samplesPerEdge;
+    bool        added  = false;
+
+    for (int j = 2; j <= maxDivision && !added; j++) {
+      for (int i = 1; i < j; i++, sample++) {
+        double interpolated = (i * h1 + (j - i) * h2) / j;
+
+        if (isRough(sampleHeights[sample], interpolated)) {
+          points.push_back(samples[sample]);
+          added = true;
         }
       }
-      if (addPoint) {
-        mCornersFine[count].emplace_back((si2.mX + si3.mX) / 2, (si2.mY + si3.mY) / 2,
-            static_cast<uint16_t>(mCornersFine[count].size()));
-        addedPoints.emplace_back(si2.mAddr, si3.mAddr);
-      }
     }
   }
 
-  return addedPoints.size() >
-         1.5 * static_cast<double>(mCornersFine[count].size() - addedPoints.size());
+  return points;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void PolygonTool::displayMesh(std::shared_ptr<cs::scene::CelestialSurface> const& surface,
-    Edge2 const& edge, double mdist, glm::dvec3 const& e, glm::dvec3 const& n,
-    glm::dvec3 const& radii, double scale, double& h1, double& h2) {
-  // Cartesian coordinates without height
-  glm::dvec3 p1 =
-      glm::normalize(mMiddlePoint + mdist * edge.first.mX * e + mdist * edge.first.mY * n) *
-      radii[0];
-  glm::dvec3 p2 =
-      glm::normalize(mMiddlePoint + mdist * edge.second.mX * e + mdist * edge.second.mY * n) *
-      radii[0];
-
-  // LongLat coordinates
-  glm::dvec2 l1 = cs::utils::convert::cartesianToLngLat(p1, radii);
-  glm::dvec2 l2 = cs::utils::convert::cartesianToLngLat(p2, radii);
+void PolygonTool::calculateAreaAndVolume(
+    std::shared_ptr<cs::scene::CelestialSurface> const& surface,
+    std::vector<DelaunayMesh::Triangle> const& triangles, std::vector<glm::dvec3> const& positions,
+    std::vector<glm::dvec2> const& lngLats, std::vector<double> const& heights,
+    glm::dvec3 const& radii, double& area, double& pvol, double& nvol) {
 
-  // Heights of the points
-  h1 = surface ? surface->getHeight(l1.xy()) : 0.0;
-  h2 = surface ? surface->getHeight(l2.xy()) : 0.0;
+  // Resolution of edge sampling
+  const int res = 32;
+
+  // Height over the least squares plane of a point without height
+  auto getPlaneHeight = [this](glm::dvec3 const& p, double h) {
+    return h - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, p) - 1) *
+                   glm::length(mMiddlePoint2);
+  };
+
+  // Triangles which intersect the least squares plane are split at the intersection points. These
+  // are found by sampling the intersecting edges, which is also done in one batch. For each
+  // triangle, the index of the first sample of each edge is stored.
+  std::vector<glm::dvec3>                 edgeSamples;
+  std::vector<glm::dvec2>                 edgeLngLats;
+  std::vector<std::array<std::size_t, 3>> edgeOffsets(triangles.size());
+
+  auto addEdgeSamples = [&](glm::dvec3 const& pa, glm::dvec3 const& pb) {
+    for (int i = 0; i < res; i++) {
+      double frac = static_cast<double>(i) / res;
+      edgeSamples.push_back(glm::normalize((1 - frac) * pa + frac * pb) * radii[0]);
+      edgeLngLats.push_back(cs::utils::convert::cartesianToLngLat(edgeSamples.back(), radii));
+    }
+  };
 
-  // Cartesian coordinates with height
-  glm::dvec3 r1 = cs::utils::convert::toCartesian(l1, radii, h1 * scale);
-  glm::dvec3 r2 = cs::utils::convert::toCartesian(l2, radii, h2 * scale);
+  for (std::size_t t = 0; t < triangles.size(); ++t) {
+    std::array<double, 3> hl{};
+    for (std::size_t c = 0; c < 3; ++c) {
+      hl.at(c) = getPlaneHeight(positions[triangles[t].at(c)], heights[triangles[t].at(c)]);
+    }
 
-  // Emplaces back points in Cartesian (on planet surface) for display
-  mTriangulation.emplace_back(r1);
-  mTriangulation.emplace_back(r2);
-}
+    // The edges are ordered like in the volume calculation below
+    std::array<std::pair<std::size_t, std::size_t>, 3> edges{{{0, 1}, {0, 2}, {1, 2}}};
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+    for (std::size_t i = 0; i < 3; ++i) {
+      auto [a, b]          = edges.at(i);
+      edgeOffsets[t].at(i) = edgeSamples.size();
 
-void PolygonTool::refineMesh(std::shared_ptr<cs::scene::CelestialSurface> const& surface,
-    Edge2 const& edge, double mdist, glm::dvec3 const& e, glm::dvec3 const& n,
-    glm::dvec3 const& radii, int count, double h1, double h2, bool& fine) {
-
-  // Middle point of the edge on voronoi plane
-  glm::dvec2 avgPoint2 =
-      glm::dvec2((edge.first.mX + edge.second.mX) / 2, (edge.first.mY + edge.second.mY) / 2);
-  // Middle point on planet´s surface
-  glm::dvec3 pAvg =
-      glm::normalize(mMiddlePoint + mdist * avgPoint2.x * e + mdist * avgPoint2.y * n) * radii[0];
-
-  // Heights of the points over see level
-  double hAvg =
-      surface ? surface->getHeight(cs::utils::convert::cartesianToLngLat(pAvg, radii)) : 0.0;
-
-  // Checks height of the middle point
-  if ((hAvg / ((h1 + h2) / 2) > mHeightDiff) || (((h1 + h2) / 2) / hAvg > mHeightDiff)) {
-    mCornersFine[count].emplace_back(
-        avgPoint2.x, avgPoint2.y, static_cast<uint16_t>(mCornersFine[count].size()));
-    fine = false;
-  }
-  // Checks height of other points between the two Sites
-  else {
-    // Trisecting points, etc.
-    for (int j = 3; j < 6; j++) {
-      // Checks "level" only if no points were emplaced back form the previous cycle
-      if (fine) {
-        for (int i = 1; i < j; i++) {
-          // Point
-          glm::dvec2 avgPoint3 = glm::dvec2((i * edge.first.mX + (j - i) * edge.second.mX) / j,
-              (i * edge.first.mY + (j - i) * edge.second.mY) / j);
-          // Cartesian coordinate of the point
-          glm::dvec3 cAvg3 =
-              glm::normalize(mMiddlePoint + mdist * avgPoint3.x * e + mdist * avgPoint3.y * n) *
-              radii[0];
-          // Height of the point
-          double heAvg3 =
-              surface ? surface->getHeight(cs::utils::convert::cartesianToLngLat(cAvg3, radii))
-                      : 0.0;
-
-          if ((heAvg3 / ((i * h1 + (j - i) * h2) / j) > mHeightDiff) ||
-              (((i * h1 + (j - i) * h2) / j) / heAvg3 > mHeightDiff)) {
-            mCornersFine[count].emplace_back(
-                avgPoint3.x, avgPoint3.y, static_cast<uint16_t>(mCornersFine[count].size()));
-            fine = false;
-          }
-        }
+      if ((hl.at(a) > 0) != (hl.at(b) > 0)) {
+        addEdgeSamples(positions[triangles[t].at(a)], positions[triangles[t].at(b)]);
       }
     }
   }
-}
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<double> edgeHeights = getHeights(surface, edgeLngLats);
 
-void PolygonTool::calculateAreaAndVolume(
-    std::shared_ptr<cs::scene::CelestialSurface> const& surface,
-    std::vector<Triangle> const& triangles, double mdist, glm::dvec3 const& e, glm::dvec3 const& n,
-    glm::dvec3 const& radii, double& area, double& pvol, double& nvol) {
   // Counts area and volume in every triangle
-  for (const auto& triangle : triangles) {
+  for (std::size_t t = 0; t < triangles.size(); ++t) {
     // ------------------------------------------ AREA ------------------------------------------
-    Site si1(0, 0, 0);
-    Site si2(0, 0, 0);
-    Site si3(0, 0, 0);
-    std::tie(si1, si2, si3) = triangle;
-
-    // Cartesian coordinates without height
-    glm::dvec3 p1 =
-        glm::normalize(mMiddlePoint + mdist * si1.mX * e + mdist * si1.mY * n) * radii[0];
-    glm::dvec3 p2 =
-        glm::normalize(mMiddlePoint + mdist * si2.mX * e + mdist * si2.mY * n) * radii[0];
-    glm::dvec3 p3 =
-        glm::normalize(mMiddlePoint + mdist * si3.mX * e + mdist * si3.mY * n) * radii[0];
+    auto [i1, i2, i3] = triangles[t];
+
+    glm::dvec3 p1 = positions[i1];
+    glm::dvec3 p2 = positions[i2];
+    glm::dvec3 p3 = positions[i3];
 
     // LongLat coordinates
-    glm::dvec2 l1 = cs::utils::convert::cartesianToLngLat(p1, radii);
-    glm::dvec2 l2 = cs::utils::convert::cartesianToLngLat(p2, radii);
-    glm::dvec2 l3 = cs::utils::convert::cartesianToLngLat(p3, radii);
+    glm::dvec2 l1 = lngLats[i1];
+    glm::dvec2 l2 = lngLats[i2];
+    glm::dvec2 l3 = lngLats[i3];
 
     // Heights of the points
-    double h1 = surface ? surface->getHeight(l1) : 0.0;
-    double h2 = surface ? surface->getHeight(l2) : 0.0;
-    double h3 = surface ? surface->getHeight(l3) : 0.0;
+    double h1 = heights[i1];
+    double h2 = heights[i2];
+    double h3 = heights[i3];
 
     // Cartesian coordinates with height
     glm::dvec3 r1 = cs::utils::convert::toCartesian(l1, radii, h1);
@@ -769,12 +515,9 @@ void PolygonTool::calculateAreaAndVolume(
     // ----------------------------------------- Volume -----------------------------------------
 
     // Heights over the least squares plane
-    double hl1 = h1 - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, p1) - 1) *
-                          glm::length(mMiddlePoint2);
-    double hl2 = h2 - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, p2) - 1) *
-                          glm::length(mMiddlePoint2);
-    double hl3 = h3 - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, p3) - 1) *
-                          glm::length(mMiddlePoint2);
+    double hl1 = getPlaneHeight(p1, h1);
+    double hl2 = getPlaneHeight(p2, h2);
+    double hl3 = getPlaneHeight(p3, h3);
 
     double baseArea1 = 0;
     double baseArea2 = 0;
@@ -803,7 +546,6 @@ void PolygonTool::calculateAreaAndVolume(
       auto   pM3    = glm::dvec3(0.0);
       auto   pM     = glm::dvec3(0.0);
       auto   pMOld  = glm::dvec3(0.0);
-      auto   lM     = glm::dvec2(0.0);
       double hM     = 0;
       double hlM    = 0;
       double hlMOld = 0;
@@ -811,27 +553,18 @@ void PolygonTool::calculateAreaAndVolume(
       bool   b2     = false;
       bool   b3     = false;
 
-      // Resolution of edge sampling
-      int    res  = 32;
-      double frac = 0;
-
       // If the two points are on the other side of the plane
       if ((hl1 > 0) != (hl2 > 0)) {
         // Samples of edge to find the intersection point between edge and plane
         // (Does not consider multiple intersection points (f.eg.: mountains in triangle)
         // They have been mostly eliminated with triangulation
         for (int i = 0; i < res; i++) {
-          frac = static_cast<double>(i) / res;
           // Point coordinate without height
-          pM = glm::normalize((1 - frac) * p1 + frac * p2) * radii[0];
-
-          // LongLat
-          lM = cs::utils::convert::cartesianToLngLat(pM, radii);
+          pM = edgeSamples[edgeOffsets[t][0] + i];
           // Height
-          hM = surface ? surface->getHeight(lM) : 0.0;
+          hM = edgeHeights[edgeOffsets[t][0] + i];
           // Height over least square plane
-          hlM = hM - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, pM) - 1) *
-                         glm::length(mMiddlePoint2);
+          hlM = getPlaneHeight(pM, hM);
           // If intersection is between this and previous sample point
           // Interpolate between this and previous point and end loop
           if ((hl1 > 0) != (hlM > 0)) {
@@ -849,12 +582,9 @@ void PolygonTool::calculateAreaAndVolume(
 
       if ((hl1 > 0) != (hl3 > 0)) {
         for (int i = 0; i < res; i++) {
-          frac = static_cast<double>(i) / res;
-          pM   = glm::normalize((1 - frac) * p1 + frac * p3) * radii[0];
-          lM   = cs::utils::convert::cartesianToLngLat(pM, radii);
-          hM   = surface ? surface->getHeight(lM) : 0.0;
-          hlM  = hM - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, pM) - 1) *
-                         glm::length(mMiddlePoint2);
+          pM  = edgeSamples[edgeOffsets[t][1] + i];
+          hM  = edgeHeights[edgeOffsets[t][1] + i];
+          hlM = getPlaneHeight(pM, hM);
           if ((hl1 > 0) != (hlM > 0)) {
             pM2 = pMOld - (pM - pMOld) * hlMOld / (hlM - hlMOld);
             i   = res;
@@ -868,12 +598,9 @@ void PolygonTool::calculateAreaAndVolume(
 
       if ((hl2 > 0) != (hl3 > 0)) {
         for (int i = 0; i < res; i++) {
-          frac = static_cast<double>(i) / res;
-          pM   = glm::normalize((1 - frac) * p2 + frac * p3) * radii[0];
-          lM   = cs::utils::convert::cartesianToLngLat(pM, radii);
-          hM   = surface ? surface->getHeight(lM) : 0.0;
-          hlM  = hM - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, pM) - 1) *
-                         glm::length(mMiddlePoint2);
+          pM  = edgeSamples[edgeOffsets[t][2] + i];
+          hM  = edgeHeights[edgeOffsets[t][2] + i];
+          hlM = getPlaneHeight(pM, hM);
           if ((hl2 > 0) != (hlM > 0)) {
             pM3 = pMOld - (pM - pMOld) * hlMOld / (hlM - hlMOld);
             i   = res;
@@ -1000,8 +727,10 @@ void PolygonTool::updateLineVertices() {
     mPosition += mark->getPosition() / static_cast<double>(mPoints.size());
   }
 
-  auto object  = mSolarSystem->getObject(getObjectName());
-  auto surface = object->getSurface();
+  auto       object      = mSolarSystem->getObject(getObjectName());
+  auto       surface     = object->getSurface();
+  double     heightScale = mSettings->mGraphics.pHeightScale.get();
+  glm::dvec3 radii       = object->getRadii();
 
   auto lastMark = mPoints.begin();
   auto currMark = ++mPoints.begin();
@@ -1009,12 +738,14 @@ void PolygonTool::updateLineVertices() {
   // minLng,maxLng,minLat,maxLat
   auto boundingBox = glm::dvec4(0.0);
 
+  // LongLat coordinates of the samples, their heights are retrieved in one batch
+  std::vector<glm::dvec2> lngLats;
+
   while (currMark != mPoints.end()) {
     // Generates X points for each line segment
     for (int vertex_id = 0; vertex_id < NUM_SAMPLES; vertex_id++) {
-      glm::dvec4 pos = getInterpolatedPosBetweenTwoMarks(
-          surface, **lastMark, **currMark, (vertex_id / static_cast<double>(NUM_SAMPLES)));
-      mSampledPositions.push_back(pos.xyz());
+      lngLats.push_back(getInterpolatedLngLatBetweenTwoMarks(
+          **lastMark, **currMark, (vertex_id / static_cast<double>(NUM_SAMPLES))));
     }
 
     // Saves the point coordinates to vector (normalized by the radius)
@@ -1043,9 +774,15 @@ void PolygonTool::updateLineVertices() {
   // Last line to draw a polygon instead of a path
   currMark = mPoints.begin();
   for (int vertex_id = 0; vertex_id < NUM_SAMPLES; vertex_id++) {
-    glm::dvec4 pos = getInterpolatedPosBetweenTwoMarks(
-        surface, **lastMark, **currMark, (vertex_id / static_cast<double>(NUM_SAMPLES)));
-    mSampledPositions.push_back(pos.xyz());
+    lngLats.push_back(getInterpolatedLngLatBetweenTwoMarks(
+        **lastMark, **currMark, (vertex_id / static_cast<double>(NUM_SAMPLES))));
+  }
+
+  std::vector<double> heights = getHeights(surface, lngLats);
+
+  for (std::size_t i = 0; i < lngLats.size(); ++i) {
+    mSampledPositions.push_back(
+        cs::utils::convert::toCartesian(lngLats[i], radii, heights[i] * heightScale));
   }
 
   // Variables for display on tool
@@ -1070,34 +807,37 @@ void PolygonTool::updateLineVertices() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // Creates a new plane normal to the middle of the polygon and projects the polygon points to
-// this plane and generates a Delaunay-mesh on this plane and calculates the area and volume
-// of the original polygon using this mesh
+// this plane and requests a Delaunay-mesh on this plane. The area and volume of the original
+// polygon are calculated once the mesh is finished in applyMesh().
 void PolygonTool::updateCalculation() {
   // Returns if no triangle can be created
   if (mPoints.size() < 3) {
     return;
   }
 
-  mCorners.clear();
-  mCornersFine.clear();
-  mTriangulation.clear();
-
-  auto       object      = mSolarSystem->getObject(getObjectName());
-  auto       surface     = object->getSurface();
-  double     heightScale = mSettings->mGraphics.pHeightScale.get();
-  glm::dvec3 radii       = object->getRadii();
+  auto       object  = mSolarSystem->getObject(getObjectName());
+  auto       surface = object->getSurface();
+  glm::dvec3 radii   = object->getRadii();
 
-  // Corrected average position (works for every height scale)
-  glm::dvec3 averagePositionNorm(0.0);
+  // LongLat coordinates of the points
+  std::vector<glm::dvec2> pointLngLats;
   for (auto const& mark : mPoints) {
     glm::dvec3 pos = glm::normalize(mark->getPosition()) * radii[0];
-    // LongLat coordinate
-    glm::dvec2 l = cs::utils::convert::cartesianToLngLat(pos, radii);
-    // Height of the point
-    double h = surface ? surface->getHeight(l) : 0.0;
-    // Cartesian coordinate with height
-    glm::dvec3 posNorm = cs::utils::convert::toCartesian(l, radii, h);
+    pointLngLats.push_back(cs::utils::convert::cartesianToLngLat(pos, radii));
+  }
+
+  // Heights of the points
+  std::vector<double> pointHeights = getHeights(surface, pointLngLats);
+
+  // Cartesian coordinates of the points with height
+  std::vector<glm::dvec3> pointsNorm;
+  for (std::size_t i = 0; i < pointLngLats.size(); ++i) {
+    pointsNorm.push_back(cs::utils::convert::toCartesian(pointLngLats[i], radii, pointHeights[i]));
+  }
 
+  // Corrected average position (works for every height scale)
+  glm::dvec3 averagePositionNorm(0.0);
+  for (auto const& posNorm : pointsNorm) {
     averagePositionNorm += posNorm / static_cast<double>(mPoints.size());
   }
 
@@ -1111,20 +851,25 @@ void PolygonTool::updateCalculation() {
   }
 
   // If polygon is to big (disable area calculation and mesh generation)
-  // Voronoi implementation is designed for a maximal area of one hemisphere
+  // The plane projection is designed for a maximal area of one hemisphere
   if (maxDist > radii[0]) {
+    cancelMesh();
+    mIndexCount2 = 0;
+    mTriangulation.clear();
+
     mGuiItem->callJavascript("setArea", 0);
     mGuiItem->callJavascript("setVolume", 0, 0);
     pShowMesh = false;
     return;
   }
-  // Converts maxDist to Voronoi plane (approx.)
-  // 1.2 is for safety -> makes sure, that the voronoi coordinates are under 1
+  // Converts maxDist to the mesh plane (approx.)
+  // 1.2 is for safety -> makes sure, that the plane coordinates are under 1
   maxDist = 1.2 * maxDist * radii[0] / (std::sqrt(std::pow(radii[0], 2) - std::pow(maxDist, 2)));
 
   // Planes normal is perpendicular to the average position
   mNormal      = glm::normalize(mPosition);
   mMiddlePoint = mNormal * radii[0];
+  mPlaneScale  = maxDist;
   // Coordinate system of the plane
   glm::dvec3 east(0.0);
   glm::dvec3 north(0.0);
@@ -1142,7 +887,9 @@ void PolygonTool::updateCalculation() {
     north = glm::dvec3(0, 1, 0);
   }
 
-  east = -glm::cross(mNormal, north);
+  east   = -glm::cross(mNormal, north);
+  mEast  = east;
+  mNorth = north;
 
   // Calculates plane for volume calculation
   // From DipStrikeTool
@@ -1153,12 +900,7 @@ void PolygonTool::updateCalculation() {
   mNormal2 = glm::normalize(averagePositionNorm);
   mOffset  = 0.F;
 
-  for (auto const& p : mPoints) {
-    glm::dvec3 pos     = glm::normalize(p->getPosition()) * radii[0];
-    glm::dvec2 l       = cs::utils::convert::cartesianToLngLat(pos, radii);
-    double     h       = surface ? surface->getHeight(l) : 0.0;
-    glm::dvec3 posNorm = cs::utils::convert::toCartesian(l, radii, h);
-
+  for (auto const& posNorm : pointsNorm) {
     glm::dvec3 realtivePosition = posNorm - averagePositionNorm;
 
     mat[0][0] += realtivePosition.x * realtivePosition.x;
@@ -1186,152 +928,33 @@ void PolygonTool::updateCalculation() {
   mOffset       = solution.z;
   mMiddlePoint2 = averagePositionNorm + mNormal2 * radii[0] * mOffset;
 
-  // Projects points to Voronoi plane and calculates their position in the new coordinate system
-  int        addr = 0;
-  glm::dvec3 lastPosition{0};
+  // Projects points to the mesh plane and calculates their position in the new coordinate system
+  std::vector<glm::dvec2> corners;
 
   for (auto const& mark : mPoints) {
     glm::dvec3 currentPosition = mark->getPosition();
 
-    // Filters out double points
-    if (currentPosition != lastPosition) {
-      // Corrects distance from origin (average point is inside of the sphere)
-      double     k   = glm::dot(mNormal, mMiddlePoint) / glm::dot(mNormal, currentPosition);
-      glm::dvec3 pos = k * currentPosition;
-
-      // Coordinates on the plane
-      double x = glm::dot(east, pos - mMiddlePoint);
-      double y = glm::dot(north, pos - mMiddlePoint);
-
-      // Avoids crashing when moving to the other side of the planet
-      if ((std::isnan(x / maxDist)) || (std::isnan(y / maxDist))) {
-        return;
-      }
+    // Corrects distance from origin (average point is inside of the sphere)
+    double     k   = glm::dot(mNormal, mMiddlePoint) / glm::dot(mNormal, currentPosition);
+    glm::dvec3 pos = k * currentPosition;
 
-      // Saves coordinates normalized with maxDist
-      mCorners.emplace_back(x / maxDist, y / maxDist, addr);
+    // Coordinates on the plane
+    double x = glm::dot(east, pos - mMiddlePoint);
+    double y = glm::dot(north, pos - mMiddlePoint);
 
-      lastPosition = currentPosition;
-      addr++;
+    // Avoids crashing when moving to the other side of the planet
+    if ((std::isnan(x / maxDist)) || (std::isnan(y / maxDist))) {
+      cancelMesh();
+      return;
     }
-  }
-
-  // Vector to save triangles from voronoi generator
-  std::vector<Triangle> triangles;
-
-  // Creates Delaunay-mesh of the original polygon
-  createMesh(triangles);
 
-  bool     fine          = false;
-  uint32_t attempt       = 0;
-  double   area          = 0;
-  double   negVolume     = 0;
-  double   posVolume     = 0;
-  size_t   triangleCount = 0;
-  size_t   pointCount    = 0;
-
-  // Counts points of the original Delaunay-mesh
-  for (auto const& vect : mCornersFine) {
-    pointCount += vect.size();
+    // Saves coordinates normalized with maxDist. Double points are removed by the DelaunayMesh.
+    corners.emplace_back(x / maxDist, y / maxDist);
   }
 
-  // Refines triangulation until it is necessary or mMaxAttempt or mMaxPoints
-  while ((!fine) && (attempt < mMaxAttempt) && (pointCount < mMaxPoints)) {
-    attempt++;
-    fine = true;
-
-    area          = 0;
-    negVolume     = 0;
-    posVolume     = 0;
-    triangleCount = 0;
-    pointCount    = 0;
-
-    mTriangulation.clear();
-
-    // Goes through every triangle of original Delaunay-mesh separately
-    for (auto const& t : triangles) {
-
-      Site s1(0, 0, 0);
-      Site s2(0, 0, 0);
-      Site s3(0, 0, 0);
-      std::tie(s1, s2, s3) = t;
-
-      // Middle point of the triangle
-      glm::dvec2 avgPoint = glm::dvec2((s1.mX + s2.mX + s3.mX) / 3, (s1.mY + s2.mY + s3.mY) / 3);
-
-      // Checks, if middle point is is the polygon
-      if (checkPoint(avgPoint)) {
-        if (attempt == 1) {
-          // Emplaces back the 3 corners of the triangle
-          std::vector<Site> corners;
-          corners.emplace_back(s1.mX, s1.mY, 0);
-          corners.emplace_back(s2.mX, s2.mY, 1);
-          corners.emplace_back(s3.mX, s3.mY, 2);
-
-          mCornersFine.emplace_back(corners);
-        }
-
-        // Checks sleekness of triangles in Delaunay-mesh and refines them, if necessary
-        bool refine = checkSleekness(static_cast<int32_t>(triangleCount));
-
-        // Voronoi inside the original triangles - to refine triangle angles
-        VoronoiGenerator voronoiRefine;
-        voronoiRefine.parse(mCornersFine[triangleCount]);
-
-        // No need for checkPoint, all of the edges are inside the triangle and the polygon
-        for (auto const& s : voronoiRefine.getTriangulation()) {
-          double h1{};
-          double h2{};
-
-          // Calculates mesh coordinates on planet's surface and saves these coordinates for display
-          displayMesh(surface, s, maxDist, east, north, radii, heightScale, h1, h2);
-
-          // If not too many points are addded in checkSleekness and it is not the the last attempt
-          // than refines the mesh based on edge length and height differences
-          if ((!refine) && (pointCount < mMaxPoints) && (attempt < mMaxAttempt)) {
-            refineMesh(surface, s, maxDist, east, north, radii, static_cast<int32_t>(triangleCount),
-                h1, h2, fine);
-          }
-        }
-
-        std::vector<Triangle> trianglesRefined = voronoiRefine.getTriangles();
-
-        // Calculates area and volume
-        calculateAreaAndVolume(
-            surface, trianglesRefined, maxDist, east, north, radii, area, posVolume, negVolume);
-
-        pointCount += mCornersFine[triangleCount].size();
-        triangleCount++;
-      } // if (checkPoint(avgPoint))
-    }   // for (auto const& t : triangles)
-
-    // Displays values
-    if (!std::isnan(area)) {
-      mGuiItem->callJavascript("setArea", area);
-    } else {
-      mGuiItem->callJavascript("setArea", 0);
-    }
-
-    if ((!std::isnan(posVolume)) && (!std::isnan(negVolume))) {
-      mGuiItem->callJavascript("setVolume", posVolume, negVolume);
-    } else if (!std::isnan(negVolume)) {
-      mGuiItem->callJavascript("setVolume", 0, negVolume);
-    } else if (!std::isnan(posVolume)) {
-      mGuiItem->callJavascript("setVolume", posVolume, 0);
-    } else {
-      mGuiItem->callJavascript("setVolume", 0, 0);
-    }
-  } // while ((!fine) && (attempt < mMaxAttempt) && (pointCount < mMaxPoints))
-
-  mIndexCount2 = mTriangulation.size();
-
-  // Uploads new data
-  mVBO2.Bind(GL_ARRAY_BUFFER);
-  mVBO2.BufferData(mTriangulation.size() * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
-  mVBO2.Release();
-
-  mVAO2.EnableAttributeArray(0);
-  mVAO2.SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0, &mVBO2);
+  // The mesh is created in the background and displayed in update() once it is finished
+  mRefinementAttempt = 0;
+  requestMesh(nullptr, std::move(corners));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1343,6 +966,9 @@ void PolygonTool::update() {
     updateLineVertices();
     updateCalculation();
     mVerticesDirty = false;
+  } else if (mNextMesh.valid() &&
+             mNextMesh.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    applyMesh(mNextMesh.get());
   }
 
   auto object   = mSolarSystem->getObject(getObjectName());
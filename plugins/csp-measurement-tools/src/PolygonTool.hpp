@@ -8,18 +8,21 @@
 #ifndef CSP_MEASUREMENT_TOOLS_POLYGONTOOL_HPP
 #define CSP_MEASUREMENT_TOOLS_POLYGONTOOL_HPP
 
+#include "../../../src/cs-utils/ThreadPool.hpp"
 #include "../../csl-tools/src/MultiPointTool.hpp"
+#include "DelaunayMesh.hpp"
 #include "Plugin.hpp"
 
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
 #include <VistaOGLExt/VistaBufferObject.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 
+#include <atomic>
+#include <future>
 #include <glm/glm.hpp>
+#include <memory>
 #include <vector>
 
-#include "voronoi/VoronoiGenerator.hpp"
-
 namespace cs::scene {
 class CelestialSurface;
 }
@@ -35,6 +38,12 @@ namespace csp::measurementtools {
 
 /// Measures the area and volume of an arbitrary polygon on surface with a Delaunay-mesh. It
 /// displays the bounding box of the selected polygon, which can be copied for cache generator.
+///
+/// The mesh is created on a plane tangential to the planet. Triangulation and refinement are done
+/// by a DelaunayMesh on a worker thread, so editing large polygons does not stall the frame. Once
+/// a mesh is finished, the terrain is sampled along its edges on the main thread. Where the
+/// terrain deviates from the mesh, points are added and the next refinement step is started in
+/// the background. In the meantime, the current mesh and its area and volume are displayed.
 class PolygonTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
  public:
   /// This text is shown on the ui and can be edited by the user.
@@ -71,37 +80,34 @@ class PolygonTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
   void updateLineVertices();
   void updateCalculation();
 
-  /// Returns the interpolated position in cartesian coordinates. The fourth component is
-  /// height above the surface
-  glm::dvec4 getInterpolatedPosBetweenTwoMarks(
-      std::shared_ptr<cs::scene::CelestialSurface> const& surface,
+  /// Returns the interpolated position in LongLat coordinates
+  glm::dvec2 getInterpolatedLngLatBetweenTwoMarks(
       csl::tools::DeletableMark const& l0, csl::tools::DeletableMark const& l1, double value);
 
-  /// Finds the intersection point between two sites
-  static bool findIntersection(Site const& s1, Site const& s2, Site const& s3, Site const& s4,
-      double& intersectionX, double& intersectionY);
-
-  /// Creates a Delaunay-mesh and corrects it to match the original polygon
-  /// (especially for concave polygons)
-  void createMesh(std::vector<Triangle>& triangles);
-  /// Checks sleekness of a triangle from the original Delaunay-mesh and its subtriangles
-  /// If a triangle is too sleek, divides it
-  /// Returns true if a lot of new points are added
-  bool checkSleekness(int count);
-  /// Draws the Delaunay-mesh on the planet's surface
-  void displayMesh(std::shared_ptr<cs::scene::CelestialSurface> const& surface, Edge2 const& edge,
-      double mdist, glm::dvec3 const& e, glm::dvec3 const& n, glm::dvec3 const& r, double scale,
-      double& h1, double& h2);
-  /// Refines mesh based on edge length and terrain
-  void refineMesh(std::shared_ptr<cs::scene::CelestialSurface> const& surface, Edge2 const& edge,
-      double mdist, glm::dvec3 const& e, glm::dvec3 const& n, glm::dvec3 const& r, int count,
-      double h1, double h2, bool& fine);
-  /// Calculates triangle areas and prism volumes
+  /// Returns the point on the planet's surface (without height) for a point on the mesh plane
+  glm::dvec3 getSurfacePoint(glm::dvec2 const& planePoint, glm::dvec3 const& radii) const;
+
+  /// Starts a background job which triangulates the given polygon corners or, if base is given,
+  /// inserts the given points into a copy of base. The mesh is refined afterwards according to
+  /// mSleekness and mMaxPoints. A job which is still running is cancelled.
+  void requestMesh(std::shared_ptr<DelaunayMesh const> base, std::vector<glm::dvec2> points);
+  /// Stops the running background job and discards its result
+  void cancelMesh();
+  /// Displays a mesh computed by requestMesh(), calculates area and volume and requests the next
+  /// refinement step if the mesh does not match the terrain yet
+  void applyMesh(std::shared_ptr<DelaunayMesh const> const& mesh);
+  /// Compares the terrain heights along the mesh edges with the heights of their end points
+  /// Returns the points which should be added to the mesh
+  std::vector<glm::dvec2> getTerrainRefinementPoints(
+      std::shared_ptr<cs::scene::CelestialSurface> const& surface, DelaunayMesh const& mesh,
+      std::vector<double> const& heights, glm::dvec3 const& radii) const;
+  /// Calculates triangle areas and prism volumes. The positions on the surface, their LongLat
+  /// coordinates and their heights are given for each vertex of the triangles.
   void calculateAreaAndVolume(std::shared_ptr<cs::scene::CelestialSurface> const& surface,
-      std::vector<Triangle> const& triangles, double mdist, glm::dvec3 const& e,
-      glm::dvec3 const& n, glm::dvec3 const& r, double& area, double& pvol, double& nvol);
-  // Checks if point is inside of the polygon or not
-  bool checkPoint(glm::dvec2 const& point);
+      std::vector<DelaunayMesh::Triangle> const& triangles,
+      std::vector<glm::dvec3> const& positions, std::vector<glm::dvec2> const& lngLats,
+      std::vector<double> const& heights, glm::dvec3 const& radii, double& area, double& pvol,
+      double& nvol);
 
   // These are called by the base class MultiPointTool
   void onPointMoved() override;
@@ -143,12 +149,20 @@ class PolygonTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
   glm::dvec4 mBoundingBox = glm::dvec4(0.0);
 
   // For Delaunay-mesh
-  std::vector<Site>              mCorners;
-  std::vector<std::vector<Site>> mCornersFine;
-  std::vector<glm::dvec3>        mTriangulation;
-  glm::dvec3                     mNormal      = glm::dvec3(0.0);
-  glm::dvec3                     mMiddlePoint = glm::dvec3(0.0);
-  size_t                         mIndexCount2 = 0;
+  std::vector<glm::dvec3> mTriangulation;
+  glm::dvec3              mNormal      = glm::dvec3(0.0);
+  glm::dvec3              mMiddlePoint = glm::dvec3(0.0);
+  size_t                  mIndexCount2 = 0;
+
+  // Coordinate system of the mesh plane
+  glm::dvec3 mEast       = glm::dvec3(0.0);
+  glm::dvec3 mNorth      = glm::dvec3(0.0);
+  double     mPlaneScale = 1.0;
+
+  // The result of the last background job and a flag to cancel it
+  std::future<std::shared_ptr<DelaunayMesh const>> mNextMesh;
+  std::shared_ptr<std::atomic<bool>>               mMeshCancelled;
+  uint32_t                                         mRefinementAttempt = 0;
 
   // For triangle fineness
   float    mHeightDiff = 1.002F;
@@ -164,6 +178,9 @@ class PolygonTool : public IVistaOpenGLDraw, public csl::tools::MultiPointTool {
   static const int   NUM_SAMPLES;
   static const char* SHADER_VERT;
   static const char* SHADER_FRAG;
+
+  // Waits for the background jobs on destruction, hence it is the last member
+  cs::utils::TaskGroup mMeshTasks;
 };
 
 } // namespace csp::measurementtools
@@ -0,0 +1,334 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/DelaunayMesh.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/voronoi/VoronoiGenerator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <random>
+
+namespace csp::measurementtools {
+
+namespace {
+
+double getArea(std::vector<glm::dvec2> const& polygon) {
+  double area = 0.0;
+
+  for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+    area += (polygon[j].x - polygon[i].x) * (polygon[j].y + polygon[i].y);
+  }
+
+  return std::abs(area) * 0.5;
+}
+
+double getSignedArea(glm::dvec2 const& a, glm::dvec2 const& b, glm::dvec2 const& c) {
+  return ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x)) * 0.5;
+}
+
+// Returns the sum of the areas of all triangles. If a triangle is not oriented counter-clockwise,
+// a negative value is returned.
+double getMeshArea(DelaunayMesh const& mesh) {
+  auto const& vertices = mesh.getVertices();
+  double      area     = 0.0;
+
+  for (auto const& t : mesh.getTriangles()) {
+    double triangleArea = getSignedArea(vertices[t[0]], vertices[t[1]], vertices[t[2]]);
+
+    if (triangleArea <= 0.0) {
+      return -1.0;
+    }
+
+    area += triangleArea;
+  }
+
+  return area;
+}
+
+// Returns the smallest angle of all triangles in degrees.
+double getMinAngle(DelaunayMesh const& mesh) {
+  auto const& vertices = mesh.getVertices();
+  double      minAngle = 180.0;
+
+  for (auto const& t : mesh.getTriangles()) {
+    for (int i = 0; i < 3; ++i) {
+      glm::dvec2 e1 = vertices[t.at((i + 1) % 3)] - vertices[t.at(i)];
+      glm::dvec2 e2 = vertices[t.at((i + 2) % 3)] - vertices[t.at(i)];
+      double     angle =
+          std::acos(glm::dot(e1, e2) / (glm::length(e1) * glm::length(e2))) * 180.0 / M_PI;
+      minAngle = std::min(minAngle, angle);
+    }
+  }
+
+  return minAngle;
+}
+
+// Checks for each pair of adjacent triangles that the opposite corner of one triangle does not lie
+// inside the circumcircle of the other.
+bool isDelaunay(DelaunayMesh const& mesh) {
+  auto const& vertices  = mesh.getVertices();
+  auto        triangles = mesh.getTriangles();
+
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> opposite;
+  for (auto const& t : triangles) {
+    for (int i = 0; i < 3; ++i) {
+      opposite[{t.at((i + 1) % 3), t.at((i + 2) % 3)}] = t.at(i);
+    }
+  }
+
+  for (auto const& t : triangles) {
+    for (int i = 0; i < 3; ++i) {
+      auto it = opposite.find({t.at((i + 2) % 3), t.at((i + 1) % 3)});
+
+      if (it == opposite.end()) {
+        continue;
+      }
+
+      glm::dvec2 a = vertices[t[0]] - vertices[it->second];
+      glm::dvec2 b = vertices[t[1]] - vertices[it->second];
+      glm::dvec2 c = vertices[t[2]] - vertices[it->second];
+
+      double det = glm::dot(a, a) * (b.x * c.y - b.y * c.x) +
+                   glm::dot(b, b) * (c.x * a.y - c.y * a.x) +
+                   glm::dot(c, c) * (a.x * b.y - a.y * b.x);
+
+      if (det > 1e-9) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool hasEdge(DelaunayMesh const& mesh, uint32_t v1, uint32_t v2) {
+  auto edges = mesh.getEdges();
+  return std::find(edges.begin(), edges.end(), std::make_pair(v1, v2)) != edges.end() ||
+         std::find(edges.begin(), edges.end(), std::make_pair(v2, v1)) != edges.end();
+}
+
+// A polygon with many concave corners.
+std::vector<glm::dvec2> createComb(int teeth) {
+  std::vector<glm::dvec2> polygon{{0.0, 0.0}, {2.0 * teeth, 0.0}};
+
+  for (int i = teeth; i > 0; --i) {
+    polygon.emplace_back(2.0 * i, 3.0);
+    polygon.emplace_back(2.0 * i - 1.0, 3.0);
+    polygon.emplace_back(2.0 * i - 1.0, 1.0);
+    polygon.emplace_back(2.0 * i - 2.0, 1.0);
+  }
+
+  return polygon;
+}
+
+std::vector<glm::dvec2> createCircle(int corners, double radius) {
+  std::vector<glm::dvec2> polygon;
+
+  for (int i = 0; i < corners; ++i) {
+    double angle = 2.0 * M_PI * i / corners;
+    polygon.emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+  }
+
+  return polygon;
+}
+
+} // namespace
+
+TEST_CASE("csp::measurementtools::DelaunayMesh::triangulate") {
+  DelaunayMesh mesh;
+
+  SUBCASE("Clockwise square") {
+    std::vector<glm::dvec2> polygon{{0.0, 0.0}, {0.0, 1.0}, {1.0, 1.0}, {1.0, 0.0}};
+
+    REQUIRE(mesh.triangulate(polygon));
+    CHECK_EQ(mesh.getVertices().size(), 4U);
+    CHECK_EQ(mesh.getTriangles().size(), 2U);
+    CHECK_EQ(mesh.getEdges().size(), 5U);
+    CHECK_EQ(getMeshArea(mesh), doctest::Approx(1.0));
+  }
+
+  SUBCASE("Concave polygon") {
+    auto polygon = createComb(10);
+
+    REQUIRE(mesh.triangulate(polygon));
+    CHECK_EQ(mesh.getTriangles().size(), polygon.size() - 2);
+    CHECK_EQ(getMeshArea(mesh), doctest::Approx(getArea(polygon)));
+    CHECK(isDelaunay(mesh));
+
+    for (uint32_t i = 0; i < polygon.size(); ++i) {
+      CHECK(hasEdge(mesh, i, static_cast<uint32_t>((i + 1) % polygon.size())));
+    }
+  }
+
+  SUBCASE("Collinear corners") {
+    std::vector<glm::dvec2> polygon{
+        {0.0, 0.0}, {1.0, 0.0}, {2.0, 0.0}, {2.0, 1.0}, {2.0, 2.0}, {1.0, 2.0}, {0.0, 2.0}};
+
+    REQUIRE(mesh.triangulate(polygon));
+    CHECK_EQ(mesh.getVertices().size(), polygon.size());
+    CHECK_EQ(mesh.getTriangles().size(), polygon.size() - 2);
+    CHECK_EQ(getMeshArea(mesh), doctest::Approx(4.0));
+
+    for (uint32_t i = 0; i < polygon.size(); ++i) {
+      CHECK(hasEdge(mesh, i, static_cast<uint32_t>((i + 1) % polygon.size())));
+    }
+  }
+
+  SUBCASE("Cocircular corners") {
+    auto polygon = createCircle(64, 1.0);
+
+    REQUIRE(mesh.triangulate(polygon));
+    CHECK_EQ(mesh.getTriangles().size(), polygon.size() - 2);
+    CHECK_EQ(getMeshArea(mesh), doctest::Approx(getArea(polygon)));
+  }
+
+  SUBCASE("Duplicate corners are removed") {
+    std::vector<glm::dvec2> polygon{
+        {0.0, 0.0}, {1.0, 0.0}, {1.0, 0.0}, {1.0, 1.0}, {0.0, 1.0}, {0.0, 0.0}};
+
+    REQUIRE(mesh.triangulate(polygon));
+    CHECK_EQ(mesh.getVertices().size(), 4U);
+    CHECK_EQ(getMeshArea(mesh), doctest::Approx(1.0));
+  }
+
+  SUBCASE("Degenerate polygons are rejected") {
+    CHECK_FALSE(mesh.triangulate({{0.0, 0.0}, {1.0, 0.0}}));
+    CHECK_FALSE(mesh.triangulate({{0.0, 0.0}, {1.0, 0.0}, {2.0, 0.0}}));
+    CHECK_FALSE(mesh.triangulate({{0.0, 0.0}, {1.0, 1.0}, {1.0, 0.0}, {0.0, 1.0}}));
+    CHECK_FALSE(mesh.triangulate({{0.0, 0.0}, {2.0, 0.0}, {1.0, 0.0}, {1.0, 1.0}}));
+    CHECK(mesh.getVertices().empty());
+    CHECK(mesh.getTriangles().empty());
+  }
+}
+
+TEST_CASE("csp::measurementtools::DelaunayMesh::insertPoint") {
+  DelaunayMesh mesh;
+  REQUIRE(mesh.triangulate(createComb(3)));
+
+  double area = getMeshArea(mesh);
+
+  CHECK_FALSE(mesh.insertPoint({-1.0, 0.5}));
+  CHECK_FALSE(mesh.insertPoint({2.5, 2.0}));
+  CHECK_FALSE(mesh.insertPoint({2.0, 3.0}));
+
+  // Inside the polygon and on one of its edges.
+  CHECK(mesh.insertPoint({0.5, 0.5}));
+  CHECK(mesh.insertPoint({3.0, 0.5}));
+  CHECK(mesh.insertPoint({3.0, 0.0}));
+  CHECK_EQ(mesh.getVertices().size(), 17U);
+
+  // Many cocircular points.
+  for (int x = 1; x < 60; ++x) {
+    for (int y = 1; y < 10; ++y) {
+      mesh.insertPoint({x * 0.1, y * 0.1});
+    }
+  }
+
+  CHECK_EQ(getMeshArea(mesh), doctest::Approx(area));
+  CHECK_EQ(mesh.getTriangles().size(), 2 * mesh.getVertices().size() - 15 - 2);
+  CHECK(isDelaunay(mesh));
+  CHECK(hasEdge(mesh, 0, 16));
+}
+
+TEST_CASE("csp::measurementtools::DelaunayMesh::refine") {
+  DelaunayMesh mesh;
+
+  SUBCASE("Skinny triangles are removed") {
+    for (auto const& polygon : {createComb(5), createCircle(64, 100.0),
+             std::vector<glm::dvec2>{{0.0, 0.0}, {100.0, 0.0}, {100.0, 0.1}, {0.0, 0.1}}}) {
+      REQUIRE(mesh.triangulate(polygon));
+      CHECK_GT(mesh.refine(25.0, 100000), 0U);
+      CHECK_GE(getMinAngle(mesh), 25.0 - 1e-6);
+      CHECK_EQ(getMeshArea(mesh), doctest::Approx(getArea(polygon)));
+      CHECK(isDelaunay(mesh));
+    }
+  }
+
+  SUBCASE("Sharp corners are kept") {
+    std::vector<glm::dvec2> polygon{{0.0, 0.0}, {10.0, -0.5}, {10.0, 0.5}};
+
+    REQUIRE(mesh.triangulate(polygon));
+    mesh.refine(25.0, 100000);
+    CHECK_LT(mesh.getVertices().size(), 100000U);
+    CHECK_EQ(getMeshArea(mesh), doctest::Approx(getArea(polygon)));
+  }
+
+  SUBCASE("Refinement stops at the maximum number of vertices") {
+    REQUIRE(mesh.triangulate(createCircle(64, 1.0)));
+    CHECK_EQ(mesh.refine(30.0, 100), 36U);
+    CHECK_EQ(mesh.getVertices().size(), 100U);
+  }
+
+  SUBCASE("Refinement can be cancelled") {
+    std::atomic<bool> cancelled(true);
+
+    REQUIRE(mesh.triangulate(createCircle(64, 1.0)));
+    CHECK_EQ(mesh.refine(30.0, 1000, &cancelled), 0U);
+  }
+}
+
+TEST_CASE("csp::measurementtools::DelaunayMesh [benchmark]") {
+  const int pointCount = 4000;
+
+  std::mt19937                           generator(0);
+  std::uniform_real_distribution<double> distribution(-0.7, 0.7);
+
+  std::vector<glm::dvec2> points;
+  while (points.size() < pointCount) {
+    glm::dvec2 point(distribution(generator), distribution(generator));
+    if (glm::length(point) < 0.95) {
+      points.push_back(point);
+    }
+  }
+
+  auto polygon = createCircle(64, 1.0);
+
+  // Triangulation of a fixed set of points.
+  auto         start = std::chrono::high_resolution_clock::now();
+  DelaunayMesh mesh;
+  mesh.triangulate(polygon);
+
+  for (auto const& point : points) {
+    mesh.insertPoint(point);
+  }
+
+  std::chrono::duration<double, std::milli> delaunayTime =
+      std::chrono::high_resolution_clock::now() - start;
+
+  std::vector<Site> sites;
+  for (auto const& vertex : mesh.getVertices()) {
+    sites.emplace_back(vertex.x, vertex.y, static_cast<uint16_t>(sites.size()));
+  }
+
+  start = std::chrono::high_resolution_clock::now();
+  VoronoiGenerator voronoi;
+  voronoi.parse(sites);
+
+  std::chrono::duration<double, std::milli> voronoiTime =
+      std::chrono::high_resolution_clock::now() - start;
+
+  CHECK_EQ(getMeshArea(mesh), doctest::Approx(getArea(polygon)));
+
+  MESSAGE(sites.size(), " vertices: DelaunayMesh ", delaunayTime.count(), " ms, VoronoiGenerator ",
+      voronoiTime.count(), " ms");
+
+  // Refinement of the bare polygon to a quality mesh.
+  start = std::chrono::high_resolution_clock::now();
+  mesh.triangulate(polygon);
+  mesh.refine(30.0, pointCount);
+
+  std::chrono::duration<double, std::milli> refineTime =
+      std::chrono::high_resolution_clock::now() - start;
+
+  MESSAGE(mesh.getVertices().size(), " vertices: refine() ", refineTime.count(),
+      " ms, minimum angle ", getMinAngle(mesh), " degrees");
+}
+
+} // namespace csp::measurementtools
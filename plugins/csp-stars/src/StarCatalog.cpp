@@ -0,0 +1,764 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "StarCatalog.hpp"
+
+#include "logger.hpp"
+
+#include "../../../src/cs-utils/MappedFile.hpp"
+#include "../../../src/cs-utils/ThreadPool.hpp"
+#include "../../../src/cs-utils/utils.hpp"
+
+#include <boost/filesystem.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+
+namespace csp::stars {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint32_t StarCache::VERSION = 6;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+constexpr std::size_t NUM_CATALOGS = cs::utils::enumCast(CatalogType::eCount);
+constexpr std::size_t NUM_COLUMNS  = cs::utils::enumCast(CatalogColumn::eCount);
+
+const std::array<std::array<int, NUM_COLUMNS>, NUM_CATALOGS> COLUMN_MAPPING{
+    std::array{5, 11, 8, 9, 1},   // CatalogType::eHipparcos
+    std::array{34, 11, 8, 9, 31}, // CatalogType::eTycho
+    std::array{19, -1, 2, 3, 23}, // CatalogType::eTycho2
+    std::array{5, 4, 2, 3, 1}     // CatalogType::eGaia
+};
+
+// Some catalogs provide additional columns which are used to compute the effective temperature.
+const int GAIA_BP_MINUS_RP_COLUMN = 6;
+const int TYCHO2_B_MAG_COLUMN     = 17;
+const int TYCHO_B_MAG_COLUMN      = 32;
+const int TYCHO_B_MINUS_V_COLUMN  = 37;
+
+// Columns after this one are not required by any catalog and are not tokenized.
+const std::size_t MAX_COLUMNS = 40;
+
+// The columns of the star cache are computed in parallel in chunks of this many stars.
+const std::size_t STARS_PER_TASK = 64 * 1024;
+
+// The stars of each layer are fainter than the limit of the previous layer and brighter than its
+// own limit. The stars of the first layers are visible with the default settings, so they are
+// uploaded first.
+const std::array<float, StarCache::LAYER_COUNT> LAYER_LIMITS{
+    6.F, 9.F, 12.F, 15.F, std::numeric_limits<float>::infinity()};
+
+// A star cache file starts with this header. It is followed by the cells, the ranges and the
+// columns.
+struct CacheHeader {
+  std::array<char, 8> mMagic;
+  uint32_t            mVersion;
+  uint32_t            mCatalogs;
+  uint64_t            mStarCount;
+  uint32_t            mCellCount;
+  uint32_t            mLayerCount;
+};
+
+static_assert(sizeof(CacheHeader) == 32, "The columns of the star cache have to be aligned.");
+
+const std::array<char, 8> CACHE_MAGIC{'C', 'S', 'V', 'R', 'S', 'T', 'A', 'R'};
+
+// The GPU columns contain five floats per star, the magnitudes as seen from the Sun one more.
+const std::size_t FLOATS_PER_STAR = 6;
+
+const std::size_t CELLS_OFFSET   = sizeof(CacheHeader);
+const std::size_t RANGES_OFFSET  = CELLS_OFFSET + StarCache::CELL_COUNT * sizeof(StarCache::Cell);
+const std::size_t COLUMNS_OFFSET = RANGES_OFFSET + StarCache::LAYER_COUNT * StarCache::CELL_COUNT *
+                                                       sizeof(StarCache::Range);
+
+std::size_t getFileSize(std::size_t starCount) {
+  return COLUMNS_OFFSET + FLOATS_PER_STAR * starCount * sizeof(float);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the index of the HEALPix cell in the nested scheme which contains the given direction.
+// Here, z is the sine of the declination and phi the ascension. This is the ang2pix_nest() function
+// from the paper "HEALPix: A Framework for High-Resolution Discretization and fast Analysis of Data
+// Distributed on the Sphere" by K.M. Gorski et al.
+uint32_t getHEALPixCell(float z, float phi) {
+  const auto nside = static_cast<int>(StarCache::HEALPIX_NSIDE);
+
+  float za = std::abs(z);
+  float tt = std::fmod(phi, glm::two_pi<float>());
+  tt       = (tt < 0.F ? tt + glm::two_pi<float>() : tt) / glm::half_pi<float>();
+
+  int face = 0;
+  int ix   = 0;
+  int iy   = 0;
+
+  if (za <= 2.F / 3.F) {
+    // Equatorial region.
+    float temp1 = static_cast<float>(nside) * (0.5F + tt);
+    float temp2 = static_cast<float>(nside) * z * 0.75F;
+    int   jp    = static_cast<int>(temp1 - temp2);
+    int   jm    = static_cast<int>(temp1 + temp2);
+    int   ifp   = jp / nside;
+    int   ifm   = jm / nside;
+
+    face = ifp == ifm ? (ifp | 4) : (ifp < ifm ? ifp : ifm + 8);
+    ix   = jm & (nside - 1);
+    iy   = nside - (jp & (nside - 1)) - 1;
+  } else {
+    // Polar caps.
+    int   ntt = std::min(3, static_cast<int>(tt));
+    float tp  = tt - static_cast<float>(ntt);
+    float tmp = static_cast<float>(nside) * std::sqrt(3.F * (1.F - za));
+    int   jp  = std::min(nside - 1, static_cast<int>(tp * tmp));
+    int   jm  = std::min(nside - 1, static_cast<int>((1.F - tp) * tmp));
+
+    if (z >= 0.F) {
+      face = ntt;
+      ix   = nside - jm - 1;
+      iy   = nside - jp - 1;
+    } else {
+      face = ntt + 8;
+      ix   = jp;
+      iy   = jm;
+    }
+  }
+
+  // Interleave the bits of ix and iy.
+  uint32_t index = 0;
+  for (int bit = 0; (1 << bit) < nside; ++bit) {
+    index |= static_cast<uint32_t>((ix >> bit) & 1) << (2 * bit);
+    index |= static_cast<uint32_t>((iy >> bit) & 1) << (2 * bit + 1);
+  }
+
+  return static_cast<uint32_t>(face) * StarCache::HEALPIX_NSIDE * StarCache::HEALPIX_NSIDE + index;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using Fields = std::array<std::string_view, MAX_COLUMNS>;
+
+// Splits a line of the form "val0|val1|...|valN|" into its fields. The fields point into the line,
+// nothing is copied. Returns the number of fields found, at most MAX_COLUMNS.
+std::size_t splitFields(std::string_view line, Fields& fields) {
+  std::size_t count = 0;
+
+  while (count < MAX_COLUMNS) {
+    auto separator = line.find('|');
+
+    if (separator == std::string_view::npos) {
+      fields[count++] = line;
+      break;
+    }
+
+    fields[count++] = line.substr(0, separator);
+    line.remove_prefix(separator + 1);
+  }
+
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// Skips leading white space and an optional sign. Returns the position after it.
+std::size_t skipSign(std::string_view field, bool& negative) {
+  std::size_t i = 0;
+
+  while (i < field.size() && (field[i] == ' ' || field[i] == '\t')) {
+    ++i;
+  }
+
+  negative = false;
+
+  if (i < field.size() && (field[i] == '+' || field[i] == '-')) {
+    negative = field[i] == '-';
+    ++i;
+  }
+
+  return i;
+}
+
+// Like the std::istringstream which has been used before, these parse a number at the beginning of
+// the field and ignore any trailing characters. They return false if the field does not start with
+// a number. Compared to std::istringstream, they are locale-independent and do not allocate.
+bool parseInt(std::string_view field, int& out) {
+  bool        negative = false;
+  std::size_t i        = skipSign(field, negative);
+  std::size_t begin    = i;
+  int64_t     value    = 0;
+
+  for (; i < field.size() && isDigit(field[i]); ++i) {
+    value = std::min<int64_t>(value * 10 + (field[i] - '0'), std::numeric_limits<int>::max());
+  }
+
+  if (i == begin) {
+    return false;
+  }
+
+  out = static_cast<int>(negative ? -value : value);
+  return true;
+}
+
+bool parseFloat(std::string_view field, float& out) {
+  // Exactly representable powers of ten.
+  static const std::array<double, 23> powersOfTen{1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+      1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+  // More digits than this do not fit into the mantissa. They are only counted.
+  const uint64_t maxMantissa = 100000000000000000ULL;
+
+  bool        negative  = false;
+  std::size_t i         = skipSign(field, negative);
+  uint64_t    mantissa  = 0;
+  int         exponent  = 0;
+  bool        hasDigits = false;
+
+  for (; i < field.size() && isDigit(field[i]); ++i) {
+    hasDigits = true;
+    if (mantissa < maxMantissa) {
+      mantissa = mantissa * 10 + static_cast<uint64_t>(field[i] - '0');
+    } else {
+      ++exponent;
+    }
+  }
+
+  if (i < field.size() && field[i] == '.') {
+    for (++i; i < field.size() && isDigit(field[i]); ++i) {
+      hasDigits = true;
+      if (mantissa < maxMantissa) {
+        mantissa = mantissa * 10 + static_cast<uint64_t>(field[i] - '0');
+        --exponent;
+      }
+    }
+  }
+
+  if (!hasDigits) {
+    return false;
+  }
+
+  if (i + 1 < field.size() && (field[i] == 'e' || field[i] == 'E')) {
+    bool        negativeExponent = false;
+    std::size_t j                = i + 1;
+
+    if (field[j] == '+' || field[j] == '-') {
+      negativeExponent = field[j] == '-';
+      ++j;
+    }
+
+    int explicitExponent = 0;
+    for (; j < field.size() && isDigit(field[j]); ++j) {
+      explicitExponent = std::min(explicitExponent * 10 + (field[j] - '0'), 1000);
+    }
+
+    exponent += negativeExponent ? -explicitExponent : explicitExponent;
+  }
+
+  auto value = static_cast<double>(mantissa);
+
+  if (exponent < 0) {
+    value = -exponent < static_cast<int>(powersOfTen.size()) ? value / powersOfTen.at(-exponent)
+                                                             : value * std::pow(10.0, exponent);
+  } else if (exponent > 0) {
+    value = exponent < static_cast<int>(powersOfTen.size()) ? value * powersOfTen.at(exponent)
+                                                            : value * std::pow(10.0, exponent);
+  }
+
+  out = static_cast<float>(negative ? -value : value);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Converts one line of a catalog to a star. Returns false if the line does not contain a valid star
+// or if it should be skipped.
+bool parseStar(std::string_view line, CatalogType type, bool skipHipparcosStars, Star& star) {
+  Fields      fields;
+  std::size_t fieldCount = splitFields(line, fields);
+
+  // Expecting more than 5 columns.
+  if (fieldCount <= 5) {
+    return false;
+  }
+
+  auto const& mapping = COLUMN_MAPPING.at(cs::utils::enumCast(type));
+
+  auto field = [&](int column) {
+    return column >= 0 && static_cast<std::size_t>(column) < fieldCount ? fields.at(column)
+                                                                        : std::string_view();
+  };
+
+  auto column = [&](CatalogColumn c) { return field(mapping.at(cs::utils::enumCast(c))); };
+
+  // Skip stars which are part of the Hipparcos catalog.
+  if (type != CatalogType::eHipparcos && skipHipparcosStars) {
+    int hippID{};
+    if (parseInt(column(CatalogColumn::eHipp), hippID) && hippID >= 0) {
+      return false;
+    }
+  }
+
+  bool success = true;
+
+  success &= parseFloat(column(CatalogColumn::eMag), star.mMagnitude);
+  success &= parseFloat(column(CatalogColumn::eRect), star.mAscension);
+  success &= parseFloat(column(CatalogColumn::eDecl), star.mDeclination);
+
+  if (!parseFloat(column(CatalogColumn::ePara), star.mParallax)) {
+    star.mParallax = 0.F;
+  }
+
+  if (type == CatalogType::eGaia) {
+    float GbpMinusGrp = 0;
+    success &= parseFloat(field(GAIA_BP_MINUS_RP_COLUMN), GbpMinusGrp);
+
+    // https://doi.org/10.1051/0004-6361/201015441
+    float logTeff = 3.999F - 0.654F * GbpMinusGrp + 0.709F * std::pow(GbpMinusGrp, 2.F) -
+                    0.316F * std::pow(GbpMinusGrp, 3.F);
+    star.mTEff = std::pow(10.F, logTeff);
+
+  } else {
+    float bv = 0;
+
+    // use B and V magnitude to retrieve the according color
+    if (type == CatalogType::eTycho2) {
+      float bMag = 0;
+      success &= parseFloat(field(TYCHO2_B_MAG_COLUMN), bMag);
+      bv = bMag - star.mMagnitude;
+    } else if (!parseFloat(field(TYCHO_B_MINUS_V_COLUMN), bv)) {
+      float bMag = 0;
+      success &= parseFloat(field(TYCHO_B_MAG_COLUMN), bMag);
+      bv = bMag - star.mMagnitude;
+    }
+
+    // https://arxiv.org/pdf/1201.1809
+    // https://github.com/sczesla/PyAstronomy/blob/master/src/pyasl/asl/aslExt_1/ballesterosBV_T.py
+    const float t0 = 4600.F;
+    const float a  = 0.92F;
+    const float b  = 1.7F;
+    const float c  = 0.62F;
+    star.mTEff     = t0 * (1.0F / (a * bv + b) + 1.0F / (a * bv + c));
+  }
+
+  if (!success) {
+    return false;
+  }
+
+  star.mAscension   = (360.F + 90.F - star.mAscension) / 180.F * glm::pi<float>();
+  star.mDeclination = star.mDeclination / 180.F * glm::pi<float>();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Parses all lines in the given range of a catalog file.
+void parseChunk(std::string_view chunk, CatalogType type, bool skipHipparcosStars,
+    std::vector<Star>& stars) {
+  while (!chunk.empty()) {
+    auto end  = chunk.find('\n');
+    auto line = chunk.substr(0, end);
+
+    Star star{};
+    if (parseStar(line, type, skipHipparcosStars, star)) {
+      stars.push_back(star);
+    }
+
+    if (end == std::string_view::npos) {
+      break;
+    }
+
+    chunk.remove_prefix(end + 1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<std::vector<Star>> readStarCatalog(
+    CatalogType type, std::string const& filename, bool skipHipparcosStars, std::size_t chunkSize) {
+  logger().info("Reading star catalog '{}'.", filename);
+
+  auto startTime = std::chrono::steady_clock::now();
+
+  std::unique_ptr<cs::utils::MappedFile> file;
+
+  try {
+    file = std::make_unique<cs::utils::MappedFile>(filename);
+  } catch (std::exception const& e) {
+    logger().error("Failed to load stars: {}", e.what());
+    return std::nullopt;
+  }
+
+  std::string_view data(file->data(), file->size());
+
+  // Split the file into chunks which end at line breaks.
+  std::vector<std::string_view> chunks;
+
+  while (!data.empty()) {
+    auto end = data.size() > chunkSize ? data.find('\n', chunkSize) : std::string_view::npos;
+    end      = end == std::string_view::npos ? data.size() : end + 1;
+
+    chunks.push_back(data.substr(0, end));
+    data.remove_prefix(end);
+  }
+
+  // Parse all chunks in parallel.
+  std::vector<std::vector<Star>> results(chunks.size());
+
+  {
+    cs::utils::TaskGroup tasks;
+
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+      tasks.post([&, i]() { parseChunk(chunks[i], type, skipHipparcosStars, results[i]); });
+    }
+
+    tasks.wait();
+  }
+
+  std::size_t count = 0;
+  for (auto const& result : results) {
+    count += result.size();
+  }
+
+  std::vector<Star> stars;
+  stars.reserve(count);
+
+  for (auto& result : results) {
+    stars.insert(stars.end(), result.begin(), result.end());
+    result = {};
+  }
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+  logger().info("Read {} stars in {:.2f} seconds.", stars.size(), duration.count());
+
+  return stars;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StarCache::StarCache(std::vector<Star> const& stars, uint32_t catalogs)
+    : mBuffer(getFileSize(stars.size()))
+    , mData(mBuffer.data())
+    , mCatalogs(catalogs)
+    , mStarCount(stars.size()) {
+
+  if (mStarCount > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Too many stars.");
+  }
+
+  cs::utils::TaskGroup tasks;
+
+  // First, the bucket of each star is computed. The buckets are sorted by layer and then by cell.
+  std::vector<uint32_t> buckets(mStarCount);
+
+  for (std::size_t begin = 0; begin < mStarCount; begin += STARS_PER_TASK) {
+    std::size_t end = std::min(begin + STARS_PER_TASK, mStarCount);
+
+    tasks.post([&, begin, end]() {
+      for (std::size_t i = begin; i < end; ++i) {
+        auto const& star = stars[i];
+        auto        cell = getHEALPixCell(std::sin(star.mDeclination), star.mAscension);
+        auto        layer =
+            std::upper_bound(LAYER_LIMITS.begin(), LAYER_LIMITS.end() - 1, star.mMagnitude) -
+            LAYER_LIMITS.begin();
+
+        buckets[i] = static_cast<uint32_t>(layer * CELL_COUNT + cell);
+      }
+    });
+  }
+
+  tasks.wait();
+
+  // Then the stars are sorted into their buckets with a counting sort.
+  std::vector<Range> ranges(LAYER_COUNT * CELL_COUNT);
+
+  for (auto bucket : buckets) {
+    ++ranges[bucket].mCount;
+  }
+
+  for (std::size_t i = 1; i < ranges.size(); ++i) {
+    ranges[i].mFirst = ranges[i - 1].mFirst + ranges[i - 1].mCount;
+  }
+
+  std::vector<uint32_t> order(mStarCount);
+  std::vector<uint64_t> next(ranges.size());
+
+  for (std::size_t i = 0; i < ranges.size(); ++i) {
+    next[i] = ranges[i].mFirst;
+  }
+
+  for (std::size_t i = 0; i < mStarCount; ++i) {
+    order[next[buckets[i]]++] = static_cast<uint32_t>(i);
+  }
+
+  buckets = {};
+
+  // Within each bucket, the stars are sorted by magnitude.
+  for (std::size_t cell = 0; cell < CELL_COUNT; ++cell) {
+    tasks.post([&, cell]() {
+      for (std::size_t layer = 0; layer < LAYER_COUNT; ++layer) {
+        auto const& range = ranges[layer * CELL_COUNT + cell];
+        auto        begin = order.begin() + static_cast<std::ptrdiff_t>(range.mFirst);
+
+        std::sort(begin, begin + static_cast<std::ptrdiff_t>(range.mCount),
+            [&](uint32_t a, uint32_t b) {
+              return stars[a].mMagnitude < stars[b].mMagnitude ||
+                     (stars[a].mMagnitude == stars[b].mMagnitude && a < b);
+            });
+      }
+    });
+  }
+
+  tasks.wait();
+
+  // Now the columns can be filled.
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  auto* positions  = reinterpret_cast<float*>(mBuffer.data() + COLUMNS_OFFSET);
+  auto* tEffs      = positions + 3 * mStarCount;
+  auto* absMags    = tEffs + mStarCount;
+  auto* magnitudes = absMags + mStarCount;
+
+  for (std::size_t begin = 0; begin < mStarCount; begin += STARS_PER_TASK) {
+    std::size_t end = std::min(begin + STARS_PER_TASK, mStarCount);
+
+    tasks.post([&, begin, end]() {
+      for (std::size_t i = begin; i < end; ++i) {
+        auto const& star = stars[order[i]];
+
+        // Distance in parsec --- some have parallax of zero; assume a large distance in those
+        // cases.
+        float dist = 1000.F;
+
+        if (star.mParallax > 0.F) {
+          dist = 1000.F / star.mParallax;
+        }
+
+        positions[3 * i]     = std::cos(star.mDeclination) * std::cos(star.mAscension) * dist;
+        positions[3 * i + 1] = std::sin(star.mDeclination) * dist;
+        positions[3 * i + 2] = std::cos(star.mDeclination) * std::sin(star.mAscension) * dist;
+        tEffs[i]             = star.mTEff;
+        absMags[i]           = star.mMagnitude - 5.F * std::log10(dist / 10.F);
+        magnitudes[i]        = star.mMagnitude;
+      }
+    });
+  }
+
+  tasks.wait();
+
+  // Finally, the bounding cones of the cells are computed from the star positions.
+  std::vector<Cell> cells(CELL_COUNT);
+
+  for (std::size_t cell = 0; cell < CELL_COUNT; ++cell) {
+    tasks.post([&, cell]() {
+      auto forEachDirection = [&](auto const& f) {
+        for (std::size_t layer = 0; layer < LAYER_COUNT; ++layer) {
+          auto const& range = ranges[layer * CELL_COUNT + cell];
+          for (auto i = range.mFirst; i < range.mFirst + range.mCount; ++i) {
+            f(glm::normalize(glm::vec3(positions[3 * i], positions[3 * i + 1],
+                positions[3 * i + 2])));
+          }
+        }
+      };
+
+      glm::vec3 sum(0.F);
+      forEachDirection([&](glm::vec3 const& direction) { sum += direction; });
+
+      // Empty cells are never drawn, so their cone does not matter.
+      if (glm::length(sum) == 0.F) {
+        cells[cell] = {{1.F, 0.F, 0.F}, glm::pi<float>()};
+        return;
+      }
+
+      glm::vec3 axis      = glm::normalize(sum);
+      float     minCosine = 1.F;
+      forEachDirection([&](glm::vec3 const& direction) {
+        minCosine = std::min(minCosine, glm::dot(axis, direction));
+      });
+
+      cells[cell] = {{axis.x, axis.y, axis.z}, std::acos(std::clamp(minCosine, -1.F, 1.F))};
+    });
+  }
+
+  tasks.wait();
+
+  CacheHeader header{};
+  header.mMagic      = CACHE_MAGIC;
+  header.mVersion    = VERSION;
+  header.mCatalogs   = mCatalogs;
+  header.mStarCount  = mStarCount;
+  header.mCellCount  = static_cast<uint32_t>(CELL_COUNT);
+  header.mLayerCount = static_cast<uint32_t>(LAYER_COUNT);
+
+  std::memcpy(mBuffer.data(), &header, sizeof(CacheHeader));
+  std::memcpy(mBuffer.data() + CELLS_OFFSET, cells.data(), cells.size() * sizeof(Cell));
+  std::memcpy(mBuffer.data() + RANGES_OFFSET, ranges.data(), ranges.size() * sizeof(Range));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StarCache::StarCache(std::string const& file)
+    : mFile(std::make_unique<cs::utils::MappedFile>(file)) {
+
+  if (mFile->size() < sizeof(CacheHeader)) {
+    throw std::runtime_error("The file is too small.");
+  }
+
+  CacheHeader header{};
+  std::memcpy(&header, mFile->data(), sizeof(CacheHeader));
+
+  if (header.mMagic != CACHE_MAGIC) {
+    throw std::runtime_error("The file is not a star cache.");
+  }
+
+  if (header.mVersion != VERSION || header.mCellCount != CELL_COUNT ||
+      header.mLayerCount != LAYER_COUNT) {
+    throw std::runtime_error(
+        "The cache has been written by an incompatible version (" +
+        std::to_string(header.mVersion) + " instead of " + std::to_string(VERSION) + ").");
+  }
+
+  if (mFile->size() != getFileSize(header.mStarCount)) {
+    throw std::runtime_error("The file is truncated.");
+  }
+
+  mData      = mFile->data();
+  mCatalogs  = header.mCatalogs;
+  mStarCount = header.mStarCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StarCache::~StarCache() = default;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StarCache::write(std::string const& file) const {
+  // The cache file may be mapped by another instance of CosmoScout VR, so it is not overwritten
+  // in-place. Instead, a new file is written and then moved over the old one.
+  std::string tmpFile = file + ".tmp";
+
+  {
+    std::ofstream stream(tmpFile, std::ios::out | std::ios::binary | std::ios::trunc);
+    stream.write(mData, static_cast<std::streamsize>(getFileSize(mStarCount)));
+
+    if (!stream) {
+      throw std::runtime_error("Failed to write to '" + tmpFile + "'.");
+    }
+  }
+
+  boost::system::error_code error;
+  boost::filesystem::rename(tmpFile, file, error);
+
+  if (error) {
+    boost::filesystem::remove(tmpFile, error);
+    throw std::runtime_error("Failed to replace '" + file + "'.");
+  }
+
+  logger().info(
+      "Wrote {} stars ({} bytes) into '{}'.", mStarCount, getFileSize(mStarCount), file);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t StarCache::getCatalogs() const {
+  return mCatalogs;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t StarCache::getStarCount() const {
+  return mStarCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float const* StarCache::getData() const {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return reinterpret_cast<float const*>(mData + COLUMNS_OFFSET);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t StarCache::getDataSize() const {
+  return 5 * mStarCount * sizeof(float);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t StarCache::getPositionsOffset() const {
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t StarCache::getTemperaturesOffset() const {
+  return 3 * mStarCount * sizeof(float);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t StarCache::getMagnitudesOffset() const {
+  return 4 * mStarCount * sizeof(float);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float const* StarCache::getApparentMagnitudes() const {
+  return getData() + 5 * mStarCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StarCache::Cell const& StarCache::getCell(std::size_t cell) const {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return reinterpret_cast<Cell const*>(mData + CELLS_OFFSET)[cell];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StarCache::Range const& StarCache::getRange(std::size_t layer, std::size_t cell) const {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return reinterpret_cast<Range const*>(mData + RANGES_OFFSET)[layer * CELL_COUNT + cell];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StarCache::Range StarCache::clip(
+    Range const& range, float minMagnitude, float maxMagnitude) const {
+  auto const* begin = getApparentMagnitudes() + range.mFirst;
+  auto const* end   = begin + range.mCount;
+
+  auto const* first = std::lower_bound(begin, end, minMagnitude);
+  auto const* last  = std::upper_bound(first, end, maxMagnitude);
+
+  return {range.mFirst + static_cast<uint64_t>(first - begin), static_cast<uint64_t>(last - first)};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::stars
@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_STARS_STAR_CATALOG_HPP
+#define CSP_STARS_STAR_CATALOG_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cs::utils {
+class MappedFile;
+} // namespace cs::utils
+
+namespace csp::stars {
+
+/// The supported catalog Types.
+/// Hipparcos and Tycho can be obtained from:
+///    http://cdsarc.u-strasbg.fr/viz-bin/Cat?cat=I%2F239
+/// Tycho2 can be obtained from:
+///    http://cdsarc.u-strasbg.fr/cgi-bin/myqcat3?I/259/
+enum class CatalogType { eHipparcos = 0, eTycho, eTycho2, eGaia, eCount };
+
+/// The required columns of each catalog. The position of each column in each catalog is
+/// configured with COLUMN_MAPPING in StarCatalog.cpp.
+enum class CatalogColumn {
+  eMag = 0, ///< visual magnitude
+  ePara,    ///< trigonometric parallax
+  eRect,    ///< rectascension
+  eDecl,    ///< declination
+  eHipp,    ///< hipparcos number
+  eCount
+};
+
+/// Data structure of one record from star catalog. The ascension and declination are already
+/// converted to radians.
+struct Star {
+  float mMagnitude;
+  float mTEff;
+  float mAscension;
+  float mDeclination;
+  float mParallax;
+};
+
+/// Reads all stars from the given catalog file. The file is memory-mapped and split into chunks of
+/// about chunkSize bytes at line boundaries. These chunks are parsed in parallel on the
+/// cs::utils::ThreadPool; the order of the stars is the same as in the file. If skipHipparcosStars
+/// is set, all stars which have a Hipparcos number are ignored as they are loaded from the
+/// Hipparcos catalog. Returns std::nullopt if the file cannot be read.
+std::optional<std::vector<Star>> readStarCatalog(CatalogType type, std::string const& filename,
+    bool skipHipparcosStars, std::size_t chunkSize = 4 * 1024 * 1024);
+
+/// The StarCache contains the star data in the format which is used on the GPU. The data is
+/// stored in consecutive columns: First the Cartesian positions of all stars in parsec (three
+/// floats per star), then their effective temperatures and then their absolute magnitudes. These
+/// three columns are uploaded to the GPU. A fourth column contains the apparent magnitudes as seen
+/// from the Sun; it is only used on the CPU.
+///
+/// The stars are sorted into LAYER_COUNT layers by their apparent magnitude, so that the bright
+/// stars come first and can be uploaded before the faint ones. Within each layer, the stars are
+/// bucketed by the HEALPix cell they are located in and sorted by magnitude within each cell. So
+/// the stars of each cell in each layer form a contiguous Range and the stars within a given
+/// magnitude interval form a sub-range of it. For each cell, a bounding cone of the directions of
+/// its stars is stored which can be used for frustum culling.
+///
+/// When loaded from a file, the data is not copied but memory-mapped, so it can be passed to OpenGL
+/// directly.
+class StarCache {
+ public:
+  /// Increase this if the cache format changed and is incompatible now. This will force a reload.
+  static const uint32_t VERSION;
+
+  /// The HEALPix resolution. The sky is divided into 12 * HEALPIX_NSIDE^2 cells of about 3.7
+  /// degrees.
+  static constexpr uint32_t    HEALPIX_NSIDE = 16;
+  static constexpr std::size_t CELL_COUNT    = 12 * HEALPIX_NSIDE * HEALPIX_NSIDE;
+
+  /// The number of magnitude layers. Their limits are defined in StarCatalog.cpp.
+  static constexpr std::size_t LAYER_COUNT = 5;
+
+  /// A bounding cone of the directions of all stars of a cell, as seen from the Sun.
+  struct Cell {
+    std::array<float, 3> mAxis;
+    float                mRadius; ///< In radians.
+  };
+
+  /// A contiguous range of stars in the columns.
+  struct Range {
+    uint64_t mFirst;
+    uint64_t mCount;
+  };
+
+  /// Computes the columns for the given stars. This uses the cs::utils::ThreadPool. The catalogs
+  /// are stored as a bit mask of the CatalogTypes the stars were loaded from.
+  StarCache(std::vector<Star> const& stars, uint32_t catalogs);
+
+  /// Maps the given cache file. This throws a std::runtime_error if the file cannot be read, if it
+  /// is not a star cache or if it has been written by an incompatible version.
+  explicit StarCache(std::string const& file);
+
+  StarCache(StarCache const& other) = delete;
+  StarCache(StarCache&& other)      = delete;
+
+  StarCache& operator=(StarCache const& other) = delete;
+  StarCache& operator=(StarCache&& other)      = delete;
+
+  ~StarCache();
+
+  /// Writes the cache to the given file. This throws a std::runtime_error if this fails.
+  void write(std::string const& file) const;
+
+  /// The bit mask of the CatalogTypes the stars were loaded from.
+  uint32_t    getCatalogs() const;
+  std::size_t getStarCount() const;
+
+  /// Returns the three columns which are used on the GPU. They are getDataSize() bytes in total.
+  float const* getData() const;
+  std::size_t  getDataSize() const;
+
+  /// The byte offsets of the columns relative to getData().
+  std::size_t getPositionsOffset() const;
+  std::size_t getTemperaturesOffset() const;
+  std::size_t getMagnitudesOffset() const;
+
+  /// The apparent magnitudes of all stars as seen from the Sun.
+  float const* getApparentMagnitudes() const;
+
+  Cell const& getCell(std::size_t cell) const;
+
+  /// Returns the stars of the given cell in the given layer.
+  Range const& getRange(std::size_t layer, std::size_t cell) const;
+
+  /// Returns the part of the given range which contains the stars with an apparent magnitude
+  /// between minMagnitude and maxMagnitude. The given range must not span multiple cells.
+  Range clip(Range const& range, float minMagnitude, float maxMagnitude) const;
+
+ private:
+  // Only one of these is used, depending on whether the cache has been loaded from a file. Both
+  // contain the data in the same layout as the cache file.
+  std::vector<char>                      mBuffer;
+  std::unique_ptr<cs::utils::MappedFile> mFile;
+
+  char const* mData      = nullptr;
+  uint32_t    mCatalogs  = 0;
+  std::size_t mStarCount = 0;
+};
+
+} // namespace csp::stars
+
+#endif // CSP_STARS_STAR_CATALOG_HPP
@@ -17,8 +17,6 @@
 #include <Windows.h>
 #endif
 
-#include <VistaInterProcComm/Connections/VistaByteBufferDeSerializer.h>
-#include <VistaInterProcComm/Connections/VistaByteBufferSerializer.h>
 #include <VistaKernel/DisplayManager/VistaDisplayManager.h>
 #include <VistaKernel/GraphicsManager/VistaGeometryFactory.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
@@ -31,9 +29,12 @@
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 #include <VistaTools/tinyXML/tinyxml.h>
 
+#include <algorithm>
 #include <array>
-#include <fstream>
-#include <glm/glm.hpp>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_access.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 namespace csp::stars {
 
@@ -41,33 +42,21 @@ namespace csp::stars {
 
 namespace {
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-template <typename T>
-bool fromString(std::string const& v, T& out) {
-  std::istringstream iss(v);
-  iss >> out;
-  return (iss.rdstate() & std::stringstream::failbit) == 0;
-}
+// At most this many stars are uploaded to the GPU each frame. This corresponds to 10 MB.
+const std::size_t STARS_PER_FRAME = 512 * 1024;
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+// The star positions are given in parsec.
+const float PARSEC_TO_METER = 3.08567758e16F;
 
-} // namespace
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
+// If the observer is further away from the Sun than this (in parsec), the stars are not culled
+// anymore as the bounding cones and magnitudes of the cells are computed as seen from the Sun.
+const float MAX_OBSERVER_DISTANCE = 0.01F;
 
-const std::array<std::array<int, Stars::NUM_COLUMNS>, Stars::NUM_CATALOGS> Stars::cColumnMapping{
-    std::array{5, 11, 8, 9, 1},   // CatalogType::eHipparcos
-    std::array{34, 11, 8, 9, 31}, // CatalogType::eTycho
-    std::array{19, -1, 2, 3, 23}, // CatalogType::eTycho2
-    std::array{5, 4, 2, 3, 1}     // CatalogType::eGaia
-};
+// The cones are enlarged by this angle (in radians) so that large star billboards at the edges of
+// the screen are not culled too early.
+const float CULLING_MARGIN = 0.02F;
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-// Increase this if the cache format changed and is incompatible now. This will
-// force a reload.
-const int Stars::cCacheVersion = 4;
+} // namespace
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -84,52 +73,8 @@ void Stars::setCatalogs(std::map<Stars::CatalogType, std::string> catalogs) {
 
     mCatalogs = std::move(catalogs);
 
-    // Clear stars first.
-    mStars.clear();
-
-    // Read star catalogs.
-    if (!readStarCache(mCacheFile)) {
-      std::map<CatalogType, std::string>::const_iterator it;
-
-      it = mCatalogs.find(CatalogType::eHipparcos);
-      if (it != mCatalogs.end()) {
-        readStarsFromCatalog(it->first, it->second);
-      }
-
-      it = mCatalogs.find(CatalogType::eTycho);
-      if (it != mCatalogs.end()) {
-        readStarsFromCatalog(it->first, it->second);
-      }
-
-      it = mCatalogs.find(CatalogType::eTycho2);
-      if (it != mCatalogs.end()) {
-        // Do not load tycho and tycho 2.
-        if (mCatalogs.find(CatalogType::eTycho) == mCatalogs.end()) {
-          readStarsFromCatalog(it->first, it->second);
-        } else {
-          logger().warn("Failed to load Tycho2 catalog: Tycho already loaded!");
-        }
-      }
-
-      it = mCatalogs.find(CatalogType::eGaia);
-      if (it != mCatalogs.end()) {
-        // Do not load gaia together with tycho or tycho 2.
-        if (mCatalogs.find(CatalogType::eTycho) == mCatalogs.end() &&
-            mCatalogs.find(CatalogType::eTycho2) == mCatalogs.end()) {
-          readStarsFromCatalog(it->first, it->second);
-        } else {
-          logger().warn("Failed to load Gaia catalog: Tycho already loaded!");
-        }
-      }
-
-      if (!mStars.empty()) {
-        writeStarCache(mCacheFile);
-      } else {
-        logger().warn("Loaded no stars! Stars will not work properly.");
-      }
-    }
-
     // Create buffers,
+    mStarCache = loadStars();
     buildStarVAO();
     buildBackgroundVAO();
   }
@@ -333,9 +278,11 @@ bool Stars::Do() {
   std::array<GLfloat, 16> glMat{};
   glGetFloatv(GL_MODELVIEW_MATRIX, glMat.data());
   VistaTransformMatrix matModelView(glMat.data(), true);
+  glm::mat4            glmModelView = glm::make_mat4(glMat.data());
 
   glGetFloatv(GL_PROJECTION_MATRIX, glMat.data());
   VistaTransformMatrix matProjection(glMat.data(), true);
+  glm::mat4            glmProjection = glm::make_mat4(glMat.data());
 
   if (mShaderDirty) {
     std::string defines;
@@ -438,7 +385,9 @@ bool Stars::Do() {
     mUniforms.starInversePMatrix  = mStarShader.GetUniformLocation("uInvP");
 
     if (mDrawMode == DrawMode::eSRPoint) {
-      mUniforms.starCount = mStarShader.GetUniformLocation("uStarCount");
+      mUniforms.starCount       = mStarShader.GetUniformLocation("uStarCount");
+      mUniforms.starRangeCount  = mStarShader.GetUniformLocation("uRangeCount");
+      mUniforms.starThreadCount = mStarShader.GetUniformLocation("uThreadCount");
     }
 
     mShaderDirty = false;
@@ -488,6 +437,10 @@ bool Stars::Do() {
     mBackgroundVAO.Release();
   }
 
+  // Stream in the next stars and find the stars which have to be drawn.
+  uploadStars();
+  updateDrawRanges(glmModelView, glmProjection);
+
   // Draw stars. In software rasterization mode, we need to bind the VBO as SSBO.
   if (mDrawMode == DrawMode::eSRPoint) {
     mStarVBO.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0);
@@ -562,14 +515,36 @@ bool Stars::Do() {
       glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, width, height);
     }
 
-    glUniform1i(mUniforms.starCount, static_cast<int>(mStars.size()));
+    // The compute shader is executed once for each star in the drawn ranges. Each thread looks up
+    // its star in a list of the ranges and the accumulated number of stars up to the end of each
+    // range.
+    std::vector<uint32_t> ranges(2 * mDrawFirsts.size());
+    uint32_t              threadCount = 0;
+
+    for (std::size_t i = 0; i < mDrawFirsts.size(); ++i) {
+      threadCount += static_cast<uint32_t>(mDrawCounts[i]);
+      ranges[2 * i]     = static_cast<uint32_t>(mDrawFirsts[i]);
+      ranges[2 * i + 1] = threadCount;
+    }
+
+    mStarRangesSSBO.Bind(GL_SHADER_STORAGE_BUFFER);
+    mStarRangesSSBO.BufferData(ranges.size() * sizeof(uint32_t), ranges.data(), GL_STREAM_DRAW);
+    mStarRangesSSBO.Release();
+    mStarRangesSSBO.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1);
+
+    glUniform1i(mUniforms.starCount, static_cast<int>(mStarCount));
+    glUniform1i(mUniforms.starRangeCount, static_cast<int>(mDrawFirsts.size()));
+    glUniform1ui(mUniforms.starThreadCount, threadCount);
 
     {
       cs::utils::FrameStats::ScopedTimer timer("Software Rasterizer");
       glClearTexImage(data.mImage->GetId(), 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
       glBindImageTexture(0, data.mImage->GetId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
 
-      glDispatchCompute(static_cast<uint32_t>(std::ceil(1.0 * mStars.size() / 256)), 1, 1);
+      if (threadCount > 0) {
+        glDispatchCompute(static_cast<uint32_t>(std::ceil(1.0 * threadCount / 256)), 1, 1);
+      }
+
       glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
     }
 
@@ -586,7 +561,8 @@ bool Stars::Do() {
   } else {
     // The other draw modes are very simple. They are either using point primitives or a geometry
     // shader to create the star billboards.
-    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(mStars.size()));
+    glMultiDrawArrays(GL_POINTS, mDrawFirsts.data(), mDrawCounts.data(),
+        static_cast<GLsizei>(mDrawFirsts.size()));
     mStarVAO.Release();
   }
 
@@ -617,291 +593,220 @@ bool Stars::GetBoundingBox(VistaBoundingBox& oBoundingBox) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool Stars::readStarsFromCatalog(CatalogType type, std::string const& filename) {
-  bool success = false;
-  logger().info("Reading star catalog '{}'.", filename);
+std::unique_ptr<StarCache> Stars::loadStars() const {
+  uint32_t catalogs = 0;
+  for (auto const& catalog : mCatalogs) {
+    catalogs |= 1U << cs::utils::enumCast(catalog.first);
+  }
 
-  std::ifstream file;
+  if (boost::filesystem::exists(mCacheFile)) {
+    try {
+      auto cache = std::make_unique<StarCache>(mCacheFile);
 
-  try {
-    file.open(filename.c_str(), std::ifstream::in);
-  } catch (std::exception& e) {
-    logger().error("Failed to open catalog file '{}': {}", filename, e.what());
+      if (cache->getCatalogs() == catalogs) {
+        logger().info("Read {} stars from '{}'.", cache->getStarCount(), mCacheFile);
+        return cache;
+      }
+    } catch (std::exception const& e) {
+      logger().info("Ignoring star cache '{}': {}", mCacheFile, e.what());
+    }
   }
 
-  if (file.is_open()) {
-    int  lineCount = 0;
-    bool loadHipparcos(mCatalogs.find(CatalogType::eHipparcos) != mCatalogs.end());
-
-    // read line by line
-    while (!file.eof()) {
-      // get line
-      ++lineCount;
-      std::string line;
-      getline(file, line);
-
-      // parse line:
-      // separate complete items consisting of "val0|val1|...|valN|" into vector of value strings
-      std::vector<std::string> items = cs::utils::splitString(line, '|');
-
-      // convert value strings to int/double/float and save in star data structure
-      // expecting Hipparcos or Tycho-1 catalog and more than 5 columns
-      if (items.size() > 5) {
-        // skip if part of hipparcos catalogue
-        if (type != CatalogType::eHipparcos && loadHipparcos) {
-          int  hippID{};
-          bool read = fromString<int>(items[cColumnMapping.at(cs::utils::enumCast(type))
-                                                .at(cs::utils::enumCast(CatalogColumn::eHipp))],
-              hippID);
-          if (read && hippID >= 0) {
-            continue;
-          }
-        }
+  // Read star catalogs.
+  std::vector<Star> stars;
+  bool loadHipparcos(mCatalogs.find(CatalogType::eHipparcos) != mCatalogs.end());
 
-        // store star data
-        bool successStoreData(true);
-
-        Star star{};
-        successStoreData &= fromString<float>(items[cColumnMapping.at(cs::utils::enumCast(
-                                                  type))[cs::utils::enumCast(CatalogColumn::eMag)]],
-            star.mMagnitude);
-        successStoreData &= fromString<float>(
-            items[cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::eRect)]],
-            star.mAscension);
-        successStoreData &= fromString<float>(
-            items[cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::eDecl)]],
-            star.mDeclination);
-
-        if (cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::ePara)] > 0) {
-          if (!fromString<float>(items[cColumnMapping.at(cs::utils::enumCast(type))
-                                           .at(cs::utils::enumCast(CatalogColumn::ePara))],
-                  star.mParallax)) {
-            star.mParallax = 0;
-          }
-        } else {
-          star.mParallax = 0;
-        }
+  auto readCatalog = [&](CatalogType type, std::string const& filename) {
+    auto catalog = readStarCatalog(type, filename, loadHipparcos);
+    if (catalog) {
+      stars.insert(stars.end(), catalog->begin(), catalog->end());
+    }
+  };
 
-        if (type == CatalogType::eGaia) {
-          int   GbpMinusGrpColumn = 6;
-          float GbpMinusGrp       = 0;
-          successStoreData &= fromString<float>(items[GbpMinusGrpColumn], GbpMinusGrp);
-
-          // https://doi.org/10.1051/0004-6361/201015441
-          float logTeff = 3.999F - 0.654F * GbpMinusGrp + 0.709F * std::pow(GbpMinusGrp, 2.F) -
-                          0.316F * std::pow(GbpMinusGrp, 3.F);
-          star.mTEff = std::pow(10.F, logTeff);
-
-        } else {
-          float bv = 0;
-
-          // use B and V magnitude to retrieve the according color
-          if (type == CatalogType::eTycho2) {
-            float bMag = 0;
-            successStoreData &= fromString<float>(items[17], bMag);
-            bv = bMag - star.mMagnitude;
-          } else {
-            bool hasBV = fromString<float>(items[37], bv);
-
-            if (!hasBV) {
-              float bMag = 0;
-              successStoreData &= fromString<float>(items[32], bMag);
-              bv = bMag - star.mMagnitude;
-            }
-          }
-
-          // https://arxiv.org/pdf/1201.1809
-          // https://github.com/sczesla/PyAstronomy/blob/master/src/pyasl/asl/aslExt_1/ballesterosBV_T.py
-          const float t0 = 4600.F;
-          const float a  = 0.92F;
-          const float b  = 1.7F;
-          const float c  = 0.62F;
-          star.mTEff     = t0 * (1.0F / (a * bv + b) + 1.0F / (a * bv + c));
-        }
+  std::map<CatalogType, std::string>::const_iterator it;
 
-        if (successStoreData) {
-          star.mAscension   = (360.F + 90.F - star.mAscension) / 180.F * Vista::Pi;
-          star.mDeclination = star.mDeclination / 180.F * Vista::Pi;
+  it = mCatalogs.find(CatalogType::eHipparcos);
+  if (it != mCatalogs.end()) {
+    readCatalog(it->first, it->second);
+  }
 
-          mStars.emplace_back(star);
-        }
-      }
+  it = mCatalogs.find(CatalogType::eTycho);
+  if (it != mCatalogs.end()) {
+    readCatalog(it->first, it->second);
+  }
 
-      // Print progress status every 10000 stars.
-      if (mStars.size() % 10000 == 0) {
-        logger().info("Read {} stars so far...", mStars.size());
-      }
+  it = mCatalogs.find(CatalogType::eTycho2);
+  if (it != mCatalogs.end()) {
+    // Do not load tycho and tycho 2.
+    if (mCatalogs.find(CatalogType::eTycho) == mCatalogs.end()) {
+      readCatalog(it->first, it->second);
+    } else {
+      logger().warn("Failed to load Tycho2 catalog: Tycho already loaded!");
     }
-    file.close();
-    success = true;
+  }
+
+  it = mCatalogs.find(CatalogType::eGaia);
+  if (it != mCatalogs.end()) {
+    // Do not load gaia together with tycho or tycho 2.
+    if (mCatalogs.find(CatalogType::eTycho) == mCatalogs.end() &&
+        mCatalogs.find(CatalogType::eTycho2) == mCatalogs.end()) {
+      readCatalog(it->first, it->second);
+    } else {
+      logger().warn("Failed to load Gaia catalog: Tycho already loaded!");
+    }
+  }
+
+  auto cache = std::make_unique<StarCache>(stars, catalogs);
 
-    logger().info("Read a total of {} stars.", mStars.size());
+  if (stars.empty()) {
+    logger().warn("Loaded no stars! Stars will not work properly.");
   } else {
-    logger().error("Failed to load stars: Cannot open catalog file '{}'!", filename);
+    try {
+      cache->write(mCacheFile);
+    } catch (std::exception const& e) {
+      logger().error("Failed to write star cache: {}", e.what());
+    }
   }
 
-  return success;
+  return cache;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Stars::writeStarCache(const std::string& sCacheFile) const {
-  VistaType::uint32 catalogs = 0;
-  for (auto const& mCatalog : mCatalogs) {
-    catalogs += static_cast<uint32_t>(std::pow(2, static_cast<int>(mCatalog.first)));
-  }
+void Stars::buildStarVAO() {
+  mStarCount            = mStarCache->getStarCount();
+  mUploadedStars        = 0;
+  mClippedUploadedStars = 0;
+  mClippedRanges.clear();
 
-  VistaByteBufferSerializer serializer;
-  serializer.WriteInt32(
-      static_cast<VistaType::uint32>(cCacheVersion)); // cache format version number
-  serializer.WriteInt32(catalogs);                    // cache format version number
-  serializer.WriteInt32(static_cast<VistaType::uint32>(
-      mStars.size())); // write number of stars to front of byte stream
-
-  for (const auto& mStar : mStars) {
-    // serialize star data into byte stream
-    serializer.WriteFloat32(mStar.mMagnitude);
-    serializer.WriteFloat32(mStar.mTEff);
-    serializer.WriteFloat32(mStar.mAscension);
-    serializer.WriteFloat32(mStar.mDeclination);
-    serializer.WriteFloat32(mStar.mParallax);
-  }
+  // Only the memory is allocated here, the stars are uploaded by uploadStars().
+  mStarVBO.Bind(GL_ARRAY_BUFFER);
+  mStarVBO.BufferData(mStarCache->getDataSize(), nullptr, GL_STATIC_DRAW);
+  mStarVBO.Release();
 
-  // open file
-  std::ofstream file;
-  file.open(sCacheFile.c_str(), std::ios::out | std::ios::binary);
-  if (file.is_open()) {
-    // write serialized star data
-    logger().info("Writing {} stars ({} bytes) into '{}'.", mStars.size(),
-        serializer.GetBufferSize(), sCacheFile);
-
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-    file.write(reinterpret_cast<const char*>(serializer.GetBuffer()), serializer.GetBufferSize());
-    file.close();
-  } else {
-    logger().error(
-        "Failed to write binary star data: Cannot open file '{}' for writing!", sCacheFile);
-  }
+  // star positions
+  mStarVAO.EnableAttributeArray(0);
+  mStarVAO.SpecifyAttributeArrayFloat(
+      0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), mStarCache->getPositionsOffset(), &mStarVBO);
+
+  // temperature
+  mStarVAO.EnableAttributeArray(1);
+  mStarVAO.SpecifyAttributeArrayFloat(
+      1, 1, GL_FLOAT, GL_FALSE, sizeof(float), mStarCache->getTemperaturesOffset(), &mStarVBO);
+
+  // magnitude
+  mStarVAO.EnableAttributeArray(2);
+  mStarVAO.SpecifyAttributeArrayFloat(
+      2, 1, GL_FLOAT, GL_FALSE, sizeof(float), mStarCache->getMagnitudesOffset(), &mStarVBO);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool Stars::readStarCache(const std::string& sCacheFile) {
-  bool success = false;
+void Stars::uploadStars() {
+  if (mUploadedStars == mStarCount) {
+    return;
+  }
 
-  // open file
-  std::ifstream file;
-  file.open(sCacheFile.c_str(),
-      std::ios::in | std::ios::binary | std::ios::ate); // ate = set read pointer to end
-  if (file.is_open()) {
+  cs::utils::FrameStats::ScopedTimer timer("Upload Stars");
 
-    // read binary data from file
-    int                          size = static_cast<int>(file.tellg());
-    std::vector<VistaType::byte> data(size);
+  std::size_t first = mUploadedStars;
+  std::size_t count = std::min(STARS_PER_FRAME, mStarCount - first);
 
-    // set read pointer to the beginning of file stream
-    file.seekg(0, std::ios::beg);
+  // The columns are uploaded directly from the cache. If it has been loaded from disk, they are
+  // read from the mapped file.
+  auto uploadColumn = [&](std::size_t offset, std::size_t components) {
+    auto bytes = components * sizeof(float);
+    mStarVBO.BufferSubData(static_cast<GLintptr>(offset + first * bytes),
+        static_cast<GLsizeiptr>(count * bytes),
+        mStarCache->getData() + (offset / sizeof(float) + first * components));
+  };
 
-    // read file stream into char array 'data'
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-    file.read(reinterpret_cast<char*>(&data[0]), size);
-    file.close();
+  mStarVBO.Bind(GL_ARRAY_BUFFER);
+  uploadColumn(mStarCache->getPositionsOffset(), 3);
+  uploadColumn(mStarCache->getTemperaturesOffset(), 1);
+  uploadColumn(mStarCache->getMagnitudesOffset(), 1);
+  mStarVBO.Release();
 
-    // de-serialize byte stream
-    VistaType::uint32 cacheVersion = 0;
-    VistaType::uint32 catalogs     = 0;
-    VistaType::uint32 numStars     = 0;
+  mUploadedStars += count;
+}
 
-    VistaByteBufferDeSerializer deserializer;
-    deserializer.SetBuffer(&data[0], size); // prepare for de-serialization
-    deserializer.ReadInt32(cacheVersion);   // read cache format version number
-    deserializer.ReadInt32(catalogs);       // read which catalogs were loaded
-    deserializer.ReadInt32(numStars);       // read number of stars from front of byte stream
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    if (cacheVersion != cCacheVersion) {
-      return false;
-    }
+void Stars::updateDrawRanges(glm::mat4 const& modelView, glm::mat4 const& projection) {
+  mDrawFirsts.clear();
+  mDrawCounts.clear();
 
-    VistaType::uint32 catalogsToLoad = 0;
-    for (const auto& mCatalog : mCatalogs) {
-      catalogsToLoad += static_cast<uint32_t>(std::pow(2, static_cast<int>(mCatalog.first)));
-    }
+  // The bounding cones of the cells and the magnitudes used for sorting the stars are computed as
+  // seen from the Sun. If the observer is far away from it, all uploaded stars are drawn.
+  glm::vec3 observer = glm::vec3(glm::inverse(modelView)[3]) / PARSEC_TO_METER;
 
-    if (catalogs != catalogsToLoad) {
-      return false;
+  if (glm::length(observer) > MAX_OBSERVER_DISTANCE) {
+    if (mUploadedStars > 0) {
+      mDrawFirsts.push_back(0);
+      mDrawCounts.push_back(static_cast<GLsizei>(mUploadedStars));
     }
+    return;
+  }
+
+  // Clip the ranges of the cells to the magnitude range and to the uploaded stars. This only has to
+  // be done if one of these changed.
+  if (mClippedRanges.empty() || mClippedUploadedStars != mUploadedStars ||
+      mClippedMinMagnitude != mMinMagnitude || mClippedMaxMagnitude != mMaxMagnitude) {
+    mClippedRanges.resize(StarCache::CELL_COUNT * StarCache::LAYER_COUNT);
 
-    for (unsigned int num = 0; num < numStars; ++num) {
-      Star star{};
-      deserializer.ReadFloat32(star.mMagnitude);
-      deserializer.ReadFloat32(star.mTEff);
-      deserializer.ReadFloat32(star.mAscension);
-      deserializer.ReadFloat32(star.mDeclination);
-      deserializer.ReadFloat32(star.mParallax);
+    for (std::size_t cell = 0; cell < StarCache::CELL_COUNT; ++cell) {
+      for (std::size_t layer = 0; layer < StarCache::LAYER_COUNT; ++layer) {
+        auto range = mStarCache->getRange(layer, cell);
 
-      mStars.emplace_back(star);
+        range.mCount = range.mFirst >= mUploadedStars
+                           ? 0
+                           : std::min<uint64_t>(range.mCount, mUploadedStars - range.mFirst);
 
-      // print progress status
-      if (mStars.size() % 100000 == 0) {
-        logger().info("Read {} stars so far...", mStars.size());
+        mClippedRanges[cell * StarCache::LAYER_COUNT + layer] =
+            mStarCache->clip(range, mMinMagnitude, mMaxMagnitude);
       }
     }
 
-    success = true;
-
-    logger().info("Read a total of {} stars.", mStars.size());
+    mClippedUploadedStars = mUploadedStars;
+    mClippedMinMagnitude  = mMinMagnitude;
+    mClippedMaxMagnitude  = mMaxMagnitude;
   }
 
-  return success;
-}
+  // The side planes of the view frustum in view space. They all pass through the origin, so a
+  // direction is visible if it is on the positive side of all of them.
+  std::array<glm::vec3, 4> planes{};
+  for (int i = 0; i < 2; ++i) {
+    auto w               = glm::row(projection, 3);
+    auto c               = glm::row(projection, i);
+    planes.at(2 * i)     = glm::normalize(glm::vec3(w + c));
+    planes.at(2 * i + 1) = glm::normalize(glm::vec3(w - c));
+  }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+  glm::mat3 rotation(modelView);
 
-void Stars::buildStarVAO() {
-  int                index(0);
-  const int          iElementCount(5);
-  std::vector<float> data(iElementCount * mStars.size());
+  for (std::size_t cell = 0; cell < StarCache::CELL_COUNT; ++cell) {
+    auto const& cone    = mStarCache->getCell(cell);
+    bool        visible = cone.mRadius + CULLING_MARGIN >= glm::half_pi<float>();
 
-  for (auto it = mStars.begin(); it != mStars.end(); ++it, index += iElementCount) {
-    // Distance in parsec --- some have parallax of zero; assume a large distance in those cases.
-    float fDist = 1000.F;
+    if (!visible) {
+      auto  axis      = glm::normalize(rotation * glm::make_vec3(cone.mAxis.data()));
+      float sinRadius = std::sin(cone.mRadius + CULLING_MARGIN);
 
-    if (it->mParallax > 0.F) {
-      fDist = 1000.F / it->mParallax;
+      visible = std::all_of(planes.begin(), planes.end(),
+          [&](glm::vec3 const& plane) { return glm::dot(plane, axis) >= -sinRadius; });
     }
 
-    glm::vec3 starPos = glm::vec3(glm::cos(it->mDeclination) * glm::cos(it->mAscension) * fDist,
-        glm::sin(it->mDeclination) * fDist,
-        glm::cos(it->mDeclination) * glm::sin(it->mAscension) * fDist);
+    if (visible) {
+      for (std::size_t layer = 0; layer < StarCache::LAYER_COUNT; ++layer) {
+        auto const& range = mClippedRanges[cell * StarCache::LAYER_COUNT + layer];
 
-    data[index]     = starPos[0];
-    data[index + 1] = starPos[1];
-    data[index + 2] = starPos[2];
-    data[index + 3] = it->mTEff;
-    data[index + 4] = it->mMagnitude - 5.F * std::log10(fDist / 10.F);
+        if (range.mCount > 0) {
+          mDrawFirsts.push_back(static_cast<GLint>(range.mFirst));
+          mDrawCounts.push_back(static_cast<GLsizei>(range.mCount));
+        }
+      }
+    }
   }
-
-  mStarVBO.Bind(GL_ARRAY_BUFFER);
-  mStarVBO.BufferData(iElementCount * mStars.size() * sizeof(float), data.data(), GL_STATIC_DRAW);
-  mStarVBO.Release();
-
-  // star positions
-  mStarVAO.EnableAttributeArray(0);
-  mStarVAO.SpecifyAttributeArrayFloat(
-      0, 3, GL_FLOAT, GL_FALSE, iElementCount * sizeof(float), 0, &mStarVBO);
-
-  // temperature
-  mStarVAO.EnableAttributeArray(1);
-  mStarVAO.SpecifyAttributeArrayFloat(
-      1, 1, GL_FLOAT, GL_FALSE, iElementCount * sizeof(float), 3 * sizeof(float), &mStarVBO);
-
-  // magnitude
-  mStarVAO.EnableAttributeArray(2);
-  mStarVAO.SpecifyAttributeArrayFloat(
-      2, 1, GL_FLOAT, GL_FALSE, iElementCount * sizeof(float), 4 * sizeof(float), &mStarVBO);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
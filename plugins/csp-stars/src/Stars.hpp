@@ -17,10 +17,13 @@
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 
 #include "../../../src/cs-utils/utils.hpp"
+#include "StarCatalog.hpp"
+
+#include <glm/glm.hpp>
 
 #include <map>
 #include <memory>
-#include <vector>
+#include <unordered_map>
 
 namespace csp::stars {
 
@@ -30,23 +33,8 @@ namespace csp::stars {
 /// information such as a constellations or grid lines.
 class Stars : public IVistaOpenGLDraw {
  public:
-  /// The supported catalog Types.
-  /// Hipparcos and Tycho can be obtained from:
-  ///    http://cdsarc.u-strasbg.fr/viz-bin/Cat?cat=I%2F239
-  /// Tycho2 can be obtained from:
-  ///    http://cdsarc.u-strasbg.fr/cgi-bin/myqcat3?I/259/
-  enum class CatalogType { eHipparcos = 0, eTycho, eTycho2, eGaia, eCount };
-
-  /// The required columns of each catalog. The position of each column in each catalog is
-  /// configured with the static member COLUMN_MAPPING at the bottom of this file.
-  enum class CatalogColumn {
-    eMag = 0, ///< visual magnitude
-    ePara,    ///< trigonometric parallax
-    eRect,    ///< rectascension
-    eDecl,    ///< declination
-    eHipp,    ///< hipparcos number
-    eCount
-  };
+  /// See StarCatalog.hpp.
+  using CatalogType = csp::stars::CatalogType;
 
   enum class DrawMode {
     ePoint,
@@ -131,26 +119,21 @@ class Stars : public IVistaOpenGLDraw {
   bool GetBoundingBox(VistaBoundingBox& oBoundingBox) override;
 
  private:
-  /// Data structure of one record from star catalog.
-  struct Star {
-    float mMagnitude;
-    float mTEff;
-    float mAscension;
-    float mDeclination;
-    float mParallax;
-  };
+  /// Loads the star cache if it matches the current catalogs. Else the catalogs are parsed and a
+  /// new cache file is written.
+  std::unique_ptr<StarCache> loadStars() const;
 
-  /// Reads star data from binary file.
-  bool readStarsFromCatalog(CatalogType type, std::string const& filename);
-
-  /// Writes internal star data read from catalog into a binary file.
-  void writeStarCache(const std::string& cacheFile) const;
+  /// Allocates the star buffer for the stars in mStarCache and sets up the vertex array object.
+  /// The stars are not uploaded here, this is done progressively by uploadStars().
+  void buildStarVAO();
 
-  /// Reads star data from binary file.
-  bool readStarCache(const std::string& cacheFile);
+  /// Uploads the next batch of stars. As the brightest stars come first in the cache, the first
+  /// frame can be drawn right away while the fainter stars are streamed in during the following
+  /// frames.
+  void uploadStars();
 
-  /// Build vertex array objects from given star list.
-  void buildStarVAO();
+  /// Updates mDrawFirsts and mDrawCounts for the current view and magnitude range.
+  void updateDrawRanges(glm::mat4 const& modelView, glm::mat4 const& projection);
   void buildBackgroundVAO();
 
   std::unique_ptr<VistaTexture> mStarTexture;
@@ -171,12 +154,26 @@ class Stars : public IVistaOpenGLDraw {
   VistaColor             mBackgroundColor2;
   VistaVertexArrayObject mStarVAO;
   VistaBufferObject      mStarVBO;
+  VistaBufferObject      mStarRangesSSBO;
   VistaVertexArrayObject mBackgroundVAO;
   VistaBufferObject      mBackgroundVBO;
 
-  std::vector<Star>                  mStars;
+  std::unique_ptr<StarCache>         mStarCache;
+  std::size_t                        mStarCount     = 0;
+  std::size_t                        mUploadedStars = 0;
   std::map<CatalogType, std::string> mCatalogs;
 
+  // The ranges of each cell and layer which are uploaded and within the current magnitude range.
+  // These are only updated if one of these changes.
+  std::vector<StarCache::Range> mClippedRanges;
+  std::size_t                   mClippedUploadedStars = 0;
+  float                         mClippedMinMagnitude  = 0.F;
+  float                         mClippedMaxMagnitude  = 0.F;
+
+  // The ranges of stars which are drawn in the current frame.
+  std::vector<GLint>   mDrawFirsts;
+  std::vector<GLsizei> mDrawCounts;
+
   DrawMode mDrawMode = DrawMode::eSRPoint;
 
   bool  mShaderDirty                = true;
@@ -205,7 +202,9 @@ class Stars : public IVistaOpenGLDraw {
     uint32_t starInverseMVMatrix = 0;
     uint32_t starInversePMatrix  = 0;
 
-    uint32_t starCount = 0;
+    uint32_t starCount       = 0;
+    uint32_t starRangeCount  = 0;
+    uint32_t starThreadCount = 0;
   } mUniforms;
 
   struct SoftwareRasterizerTargets {
@@ -215,13 +214,6 @@ class Stars : public IVistaOpenGLDraw {
   };
 
   std::unordered_map<VistaViewport*, SoftwareRasterizerTargets> mSRTargets;
-
-  static const int cCacheVersion;
-
-  static constexpr size_t NUM_CATALOGS = cs::utils::enumCast(CatalogType::eCount);
-  static constexpr size_t NUM_COLUMNS  = cs::utils::enumCast(CatalogColumn::eCount);
-
-  static const std::array<std::array<int, NUM_COLUMNS>, NUM_CATALOGS> cColumnMapping;
 };
 
 } // namespace csp::stars
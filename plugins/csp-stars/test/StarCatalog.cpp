@@ -0,0 +1,368 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../src/StarCatalog.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../../../src/cs-utils/utils.hpp"
+
+#include <boost/filesystem.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+namespace csp::stars {
+
+namespace {
+
+boost::filesystem::path createTempDirectory() {
+  auto directory = boost::filesystem::temp_directory_path() /
+                   boost::filesystem::unique_path("csp-stars-test-%%%%-%%%%");
+  boost::filesystem::create_directories(directory);
+  return directory;
+}
+
+// Writes a catalog in the format of the Gaia catalog which is shipped with CosmoScout VR. The
+// stars are scattered randomly over the sky. Every tenth star has a Hipparcos number.
+void writeGaiaCatalog(std::string const& file, std::size_t count) {
+  std::mt19937                          generator(42);
+  std::uniform_real_distribution<float> ascension(0.F, 360.F);
+  std::uniform_real_distribution<float> declination(-90.F, 90.F);
+  std::uniform_real_distribution<float> parallax(0.01F, 50.F);
+  std::uniform_real_distribution<float> magnitude(-1.F, 21.F);
+  std::uniform_real_distribution<float> color(-0.5F, 3.F);
+
+  std::ofstream         stream(file, std::ios::out | std::ios::binary);
+  std::array<char, 256> line{};
+
+  for (std::size_t i = 0; i < count; ++i) {
+    auto id        = 4000000000000ULL + static_cast<unsigned long long>(i);
+    int  hipparcos = i % 10 == 0 ? static_cast<int>(i / 10) : -1;
+    auto asc       = ascension(generator);
+    auto dec       = declination(generator);
+    auto para      = parallax(generator);
+    auto mag       = magnitude(generator);
+    auto bpMinusRp = color(generator);
+
+    int length = std::snprintf(line.data(), line.size(), "%llu|%d|%.8f|%.8f|%.4f|%.5f|%.5f\n", id,
+        hipparcos, asc, dec, para, mag, bpMinusRp);
+    stream.write(line.data(), length);
+  }
+}
+
+// This is how Gaia catalogs have been parsed before. It is used as a baseline in the benchmark
+// below.
+std::vector<Star> readGaiaCatalogLegacy(std::string const& file) {
+  auto fromString = [](std::string const& v, auto& out) {
+    std::istringstream iss(v);
+    iss >> out;
+    return (iss.rdstate() & std::stringstream::failbit) == 0;
+  };
+
+  std::vector<Star> stars;
+  std::ifstream     stream(file);
+
+  while (!stream.eof()) {
+    std::string line;
+    getline(stream, line);
+
+    std::vector<std::string> items = cs::utils::splitString(line, '|');
+
+    if (items.size() > 5) {
+      Star star{};
+      bool success = true;
+      success &= fromString(items[5], star.mMagnitude);
+      success &= fromString(items[2], star.mAscension);
+      success &= fromString(items[3], star.mDeclination);
+
+      if (!fromString(items[4], star.mParallax)) {
+        star.mParallax = 0;
+      }
+
+      float GbpMinusGrp = 0;
+      success &= fromString(items[6], GbpMinusGrp);
+
+      float logTeff = 3.999F - 0.654F * GbpMinusGrp + 0.709F * std::pow(GbpMinusGrp, 2.F) -
+                      0.316F * std::pow(GbpMinusGrp, 3.F);
+      star.mTEff = std::pow(10.F, logTeff);
+
+      if (success) {
+        star.mAscension   = (360.F + 90.F - star.mAscension) / 180.F * glm::pi<float>();
+        star.mDeclination = star.mDeclination / 180.F * glm::pi<float>();
+        stars.emplace_back(star);
+      }
+    }
+  }
+
+  return stars;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+TEST_CASE("csp::stars::readStarCatalog") {
+  auto directory = createTempDirectory();
+  auto file      = (directory / "catalog.txt").string();
+
+  {
+    std::ofstream stream(file);
+
+    // A star without Hipparcos number, a star with Hipparcos number, a line with too few columns,
+    // a star with an invalid magnitude and a star without trailing new line.
+    stream << "1|-1|90.0|45.0|10.0|5.5|0.5\n";
+    stream << "2|123|180.0|-45.0|2.0|1.5|1.0\n";
+    stream << "3|-1|10.0\n";
+    stream << "4|-1|10.0|10.0|1.0|abc|1.0\n";
+    stream << "5| |270.0|0.0||-1.5e0|0.0";
+  }
+
+  SUBCASE("Fields are parsed correctly") {
+    auto stars = readStarCatalog(CatalogType::eGaia, file, false);
+
+    REQUIRE(stars);
+    REQUIRE_EQ(stars->size(), 3);
+
+    CHECK_EQ(stars->at(0).mMagnitude, doctest::Approx(5.5F));
+    CHECK_EQ(stars->at(0).mParallax, doctest::Approx(10.F));
+    CHECK_EQ(stars->at(0).mAscension, doctest::Approx(2.0 * glm::pi<double>()));
+    CHECK_EQ(stars->at(0).mDeclination, doctest::Approx(0.25 * glm::pi<double>()));
+
+    CHECK_EQ(stars->at(1).mMagnitude, doctest::Approx(1.5F));
+    CHECK_EQ(stars->at(1).mDeclination, doctest::Approx(-0.25 * glm::pi<double>()));
+
+    // The last star has no parallax.
+    CHECK_EQ(stars->at(2).mMagnitude, doctest::Approx(-1.5F));
+    CHECK_EQ(stars->at(2).mParallax, 0.F);
+    CHECK_EQ(stars->at(2).mAscension, doctest::Approx(glm::pi<double>()));
+  }
+
+  SUBCASE("Hipparcos stars can be skipped") {
+    auto stars = readStarCatalog(CatalogType::eGaia, file, true);
+
+    REQUIRE(stars);
+    CHECK_EQ(stars->size(), 2);
+  }
+
+  SUBCASE("The order of the stars does not depend on the chunk size") {
+    writeGaiaCatalog(file, 1000);
+
+    auto reference = readStarCatalog(CatalogType::eGaia, file, false);
+    auto chunked   = readStarCatalog(CatalogType::eGaia, file, false, 100);
+
+    REQUIRE(reference);
+    REQUIRE(chunked);
+    REQUIRE_EQ(reference->size(), 1000);
+    REQUIRE_EQ(chunked->size(), 1000);
+
+    for (std::size_t i = 0; i < reference->size(); ++i) {
+      CHECK_EQ(reference->at(i).mAscension, chunked->at(i).mAscension);
+    }
+  }
+
+  SUBCASE("Missing catalogs are reported") {
+    CHECK_FALSE(readStarCatalog(CatalogType::eGaia, (directory / "missing.txt").string(), false));
+  }
+
+  boost::filesystem::remove_all(directory);
+}
+
+TEST_CASE("csp::stars::StarCache") {
+  auto directory = createTempDirectory();
+  auto file      = (directory / "star_cache.dat").string();
+
+  std::vector<Star> stars{{1.F, 5000.F, 0.F, 0.F, 100.F}, {2.F, 6000.F, 1.F, 0.5F, 0.F},
+      {3.F, 7000.F, 2.F, -0.5F, 1.F}};
+
+  StarCache cache(stars, 8);
+
+  // All stars are in the first layer, so the first star is the brightest star of its cell. It is
+  // 10 parsec away.
+  CHECK_EQ(cache.getStarCount(), 3);
+
+  std::size_t first = 0;
+  while (first < 3 && cache.getApparentMagnitudes()[first] != 1.F) {
+    ++first;
+  }
+
+  REQUIRE_LT(first, 3);
+  CHECK_EQ(cache.getData()[3 * first], doctest::Approx(10.F));
+  CHECK_EQ(cache.getData()[cache.getTemperaturesOffset() / sizeof(float) + first], 5000.F);
+  CHECK_EQ(cache.getData()[cache.getMagnitudesOffset() / sizeof(float) + first],
+      doctest::Approx(1.F));
+
+  SUBCASE("Caches can be written and mapped") {
+    cache.write(file);
+
+    StarCache mapped(file);
+    CHECK_EQ(mapped.getCatalogs(), 8);
+    CHECK_EQ(mapped.getStarCount(), 3);
+    REQUIRE_EQ(mapped.getDataSize(), cache.getDataSize());
+
+    for (std::size_t i = 0; i < 18; ++i) {
+      CHECK_EQ(mapped.getData()[i], cache.getData()[i]);
+    }
+
+    for (std::size_t cell = 0; cell < StarCache::CELL_COUNT; ++cell) {
+      CHECK_EQ(mapped.getRange(0, cell).mCount, cache.getRange(0, cell).mCount);
+    }
+  }
+
+  SUBCASE("Invalid caches are rejected") {
+    cache.write(file);
+
+    // Change the version number.
+    {
+      std::fstream stream(file, std::ios::in | std::ios::out | std::ios::binary);
+      stream.seekp(8);
+      stream.put(4);
+    }
+
+    CHECK_THROWS_AS(StarCache{file}, std::runtime_error);
+
+    boost::filesystem::resize_file(file, 10);
+    CHECK_THROWS_AS(StarCache{file}, std::runtime_error);
+
+    CHECK_THROWS_AS(StarCache{(directory / "missing.dat").string()}, std::runtime_error);
+  }
+
+  boost::filesystem::remove_all(directory);
+}
+
+TEST_CASE("csp::stars::StarCache spatial index") {
+  auto directory = createTempDirectory();
+  auto file      = (directory / "catalog.txt").string();
+
+  writeGaiaCatalog(file, 100000);
+  auto stars = readStarCatalog(CatalogType::eGaia, file, false);
+  REQUIRE(stars);
+
+  StarCache cache(*stars, 8);
+
+  auto const* positions  = cache.getData();
+  auto const* magnitudes = cache.getApparentMagnitudes();
+
+  // The ranges cover all stars without gaps. The layers are sorted by magnitude, within each layer
+  // the stars are sorted by cell and within each cell by magnitude. All stars of a cell are within
+  // its bounding cone.
+  uint64_t next         = 0;
+  float    maxMagnitude = -std::numeric_limits<float>::infinity();
+  bool     sorted       = true;
+  bool     inCone       = true;
+
+  for (std::size_t layer = 0; layer < StarCache::LAYER_COUNT; ++layer) {
+    float layerMaxMagnitude = maxMagnitude;
+
+    for (std::size_t cell = 0; cell < StarCache::CELL_COUNT; ++cell) {
+      auto const& range = cache.getRange(layer, cell);
+      auto const& cone  = cache.getCell(cell);
+
+      REQUIRE_EQ(range.mFirst, next);
+      next += range.mCount;
+
+      for (auto i = range.mFirst; i < range.mFirst + range.mCount; ++i) {
+        sorted &= magnitudes[i] >= maxMagnitude;
+        sorted &= i == range.mFirst || magnitudes[i] >= magnitudes[i - 1];
+        layerMaxMagnitude = std::max(layerMaxMagnitude, magnitudes[i]);
+
+        glm::vec3 direction(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+        glm::vec3 axis(cone.mAxis[0], cone.mAxis[1], cone.mAxis[2]);
+        inCone &= glm::dot(glm::normalize(direction), axis) >= std::cos(cone.mRadius) - 1e-5F;
+      }
+    }
+
+    maxMagnitude = layerMaxMagnitude;
+  }
+
+  CHECK_EQ(next, stars->size());
+  CHECK(sorted);
+  CHECK(inCone);
+
+  // Clipping a range only keeps the stars in the given magnitude interval.
+  auto const& range   = cache.getRange(StarCache::LAYER_COUNT - 1, 0);
+  auto        clipped = cache.clip(range, 17.F, 18.F);
+
+  CHECK_GE(clipped.mFirst, range.mFirst);
+  CHECK_LE(clipped.mFirst + clipped.mCount, range.mFirst + range.mCount);
+
+  for (auto i = range.mFirst; i < range.mFirst + range.mCount; ++i) {
+    bool inInterval = magnitudes[i] >= 17.F && magnitudes[i] <= 18.F;
+    bool inClipped  = i >= clipped.mFirst && i < clipped.mFirst + clipped.mCount;
+    CHECK_EQ(inInterval, inClipped);
+  }
+
+  boost::filesystem::remove_all(directory);
+}
+
+TEST_CASE("csp::stars::readStarCatalog startup time [benchmark]") {
+  const std::size_t count = 10000000;
+
+  auto directory = createTempDirectory();
+  auto catalog   = (directory / "gaia.txt").string();
+  auto cacheFile = (directory / "star_cache.dat").string();
+
+  writeGaiaCatalog(catalog, count);
+
+  // The first start without a cache file.
+  auto start          = std::chrono::steady_clock::now();
+  auto legacy         = readGaiaCatalogLegacy(catalog);
+  auto legacyDuration = secondsSince(start);
+
+  start              = std::chrono::steady_clock::now();
+  auto stars         = readStarCatalog(CatalogType::eGaia, catalog, false);
+  auto parseDuration = secondsSince(start);
+
+  REQUIRE(stars);
+  REQUIRE_EQ(stars->size(), legacy.size());
+
+  start = std::chrono::steady_clock::now();
+  StarCache(*stars, 8).write(cacheFile);
+  auto writeDuration = secondsSince(start);
+
+  // Subsequent starts with the cache file. The data is read once to include the page faults.
+  double mapDuration = 0.0;
+
+  {
+    start = std::chrono::steady_clock::now();
+    StarCache cache(cacheFile);
+
+    double sum = 0.0;
+    for (std::size_t i = 0; i < cache.getDataSize() / sizeof(float); i += 1024) {
+      sum += cache.getData()[i];
+    }
+
+    mapDuration = secondsSince(start);
+
+    CHECK_EQ(cache.getStarCount(), count);
+    CHECK(std::isfinite(sum));
+  }
+
+  // The results of both parsers must match.
+  float maxError = 0.F;
+  for (std::size_t i = 0; i < legacy.size(); ++i) {
+    maxError = std::max(maxError, std::abs(legacy[i].mMagnitude - stars->at(i).mMagnitude));
+    maxError = std::max(maxError, std::abs(legacy[i].mParallax - stars->at(i).mParallax));
+  }
+
+  CHECK_LT(maxError, 1e-5F);
+
+  MESSAGE("Parsing ", count, " stars: ", legacyDuration, " s (legacy), ", parseDuration,
+      " s (parallel), building and writing cache: ", writeDuration, " s, mapping cache: ", mapDuration, " s");
+
+  boost::filesystem::remove_all(directory);
+}
+
+} // namespace csp::stars
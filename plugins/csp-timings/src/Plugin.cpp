@@ -139,6 +139,38 @@ void Plugin::init() {
       "Shows or hides the on-screen timer statistics.",
       std::function([this](bool enable) { mEnableStatistics = enable; }));
 
+  // Starts or stops writing a trace file. The file is closed once the TraceWriter is destroyed.
+  mGuiManager->getGui()->registerCallback("timings.setEnableTracing",
+      "Starts or stops streaming all frame timings to a Chrome trace file.",
+      std::function([this](bool enable) {
+        mTraceWriter.reset();
+
+        if (enable) {
+          std::string fileName = createOutputDirectory() + "/trace.json";
+
+          try {
+            mTraceWriter = std::make_unique<TraceWriter>(fileName);
+            logger().info("Writing trace to '{}'.", fileName);
+          } catch (std::runtime_error const& e) {
+            logger().warn("Failed to start tracing: {}", e.what());
+          }
+        }
+
+        // If the file could not be created, the checkbox is reset so that the next click starts a
+        // new trace.
+        if (mTraceWriter) {
+          mGuiManager->getGui()->executeJavascript(
+              "document.querySelector('.timings-trace-button').innerHTML = "
+              "'<i class=\"material-icons\">stop</i> Stop Trace';");
+        } else {
+          mGuiManager->getGui()->executeJavascript(
+              "document.querySelector('.timings-trace-button').innerHTML = "
+              "'<i class=\"material-icons\">timeline</i> Start New Trace';"
+              "document.querySelector('[data-callback=\"timings.setEnableTracing\"]').checked = "
+              "false;");
+        }
+      }));
+
   // Load settings.
   onLoad();
 
@@ -162,9 +194,11 @@ void Plugin::update() {
     auto const&    timerQueryResults = cs::utils::FrameStats::get().getTimerQueryResults();
     uint32_t       maxNestingLevel   = 0;
 
-    // Compute the maximum nesting level amongst all recorded ranges.
+    // Compute the maximum nesting level amongst all ranges recorded on the main thread.
     for (auto const& timerQueryResult : timerQueryResults) {
-      maxNestingLevel = std::max(maxNestingLevel, timerQueryResult.mNestingLevel);
+      if (timerQueryResult.mThread == 0) {
+        maxNestingLevel = std::max(maxNestingLevel, timerQueryResult.mNestingLevel);
+      }
     }
 
     // The outer vector contains all timing ranges for a specific nesting level.
@@ -177,14 +211,22 @@ void Plugin::update() {
       auto cpuFrameStart = timerQueryResults[0].mCPUStart;
 
       for (auto const& timerQueryResult : timerQueryResults) {
+
+        // Ranges recorded on other threads than the main thread are not shown.
+        if (timerQueryResult.mThread != 0) {
+          continue;
+        }
+
         if (timerQueryResult.mGPUEnd - timerQueryResult.mGPUStart >= minTimeNanos) {
-          gpuRanges[timerQueryResult.mNestingLevel].emplace_back(timerQueryResult.mName,
+          gpuRanges[timerQueryResult.mNestingLevel].emplace_back(
+              std::string(timerQueryResult.mName),
               static_cast<uint32_t>(timerQueryResult.mGPUStart - gpuFrameStart) / 1000,
               static_cast<uint32_t>(timerQueryResult.mGPUEnd - gpuFrameStart) / 1000);
         }
 
         if (timerQueryResult.mCPUEnd - timerQueryResult.mCPUStart >= minTimeNanos) {
-          cpuRanges[timerQueryResult.mNestingLevel].emplace_back(timerQueryResult.mName,
+          cpuRanges[timerQueryResult.mNestingLevel].emplace_back(
+              std::string(timerQueryResult.mName),
               static_cast<uint32_t>(timerQueryResult.mCPUStart - cpuFrameStart) / 1000,
               static_cast<uint32_t>(timerQueryResult.mCPUEnd - cpuFrameStart) / 1000);
         }
@@ -237,20 +279,15 @@ void Plugin::update() {
     }
   }
 
+  // The trace contains all ranges of this frame, so it is written regardless of the other modes.
+  if (mTraceWriter && cs::utils::FrameStats::get().pEnableMeasurements.get()) {
+    mTraceWriter->addFrame();
+  }
+
   // Recording seems to have stopped last frame, so write the output file!
   if (!mEnableRecording && !mRecordedGPURanges.empty()) {
 
-    // We use the current date as a directory name.
-    auto timeString =
-        cs::utils::convert::time::toString(boost::posix_time::microsec_clock::local_time());
-    cs::utils::replaceString(timeString, ":", "-");
-    cs::utils::replaceString(timeString, ".", "-");
-    cs::utils::replaceString(timeString, "T", "-");
-    cs::utils::replaceString(timeString, "Z", "");
-
-    std::string directory = "csp-timings/" + timeString;
-    cs::utils::filesystem::createDirectoryRecursively(
-        boost::filesystem::system_complete(directory));
+    std::string directory = createOutputDirectory();
 
     // This stores a CSV file for each nesting level in the directory created above. The prefix will
     // be prepended to the CSV file name.
@@ -333,6 +370,10 @@ void Plugin::deInit() {
   mGuiManager->getGui()->unregisterCallback("timings.setEnableTimerQueries");
   mGuiManager->getGui()->unregisterCallback("timings.setEnableRecording");
   mGuiManager->getGui()->unregisterCallback("timings.setEnableStatistics");
+  mGuiManager->getGui()->unregisterCallback("timings.setEnableTracing");
+
+  // Finish the trace file if one is currently written.
+  mTraceWriter.reset();
 
   // Remove the statistic GUI item. We don't exactly know whether it was attached locally or
   // globally, so we just attempt to remove it in both cases.
@@ -366,4 +407,22 @@ void Plugin::onSave() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::string Plugin::createOutputDirectory() const {
+
+  // We use the current date as a directory name.
+  auto timeString =
+      cs::utils::convert::time::toString(boost::posix_time::microsec_clock::local_time());
+  cs::utils::replaceString(timeString, ":", "-");
+  cs::utils::replaceString(timeString, ".", "-");
+  cs::utils::replaceString(timeString, "T", "-");
+  cs::utils::replaceString(timeString, "Z", "");
+
+  std::string directory = "csp-timings/" + timeString;
+  cs::utils::filesystem::createDirectoryRecursively(boost::filesystem::system_complete(directory));
+
+  return directory;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace csp::timings
@@ -12,6 +12,7 @@
 #include "../../../src/cs-gui/GuiItem.hpp"
 #include "../../../src/cs-utils/DefaultProperty.hpp"
 #include "../../../src/cs-utils/FrameStats.hpp"
+#include "TraceWriter.hpp"
 
 #include <fstream>
 #include <list>
@@ -19,7 +20,8 @@
 namespace csp::timings {
 
 /// A plugin which uses the built-in timer queries of CosmoScout VR to draw on-screen live frame
-/// timing statistics. This plugin can also be used to export recorded time series to CSV files.
+/// timing statistics. This plugin can also be used to export recorded time series to CSV files or
+/// to stream all ranges, including those of worker threads, to a Chrome trace file.
 class Plugin : public cs::core::PluginBase {
  public:
   struct Settings {
@@ -50,6 +52,9 @@ class Plugin : public cs::core::PluginBase {
   void onLoad();
   void onSave();
 
+  /// Creates a new directory in csp-timings/ named after the current time and returns its path.
+  std::string createOutputDirectory() const;
+
   Settings mPluginSettings;
 
   /// This store the statistics GUI element.
@@ -68,6 +73,9 @@ class Plugin : public cs::core::PluginBase {
   /// Sample queries do not support nesting.
   std::vector<int64_t> mTimestamps;
 
+  /// This is only set while a trace is written.
+  std::unique_ptr<TraceWriter> mTraceWriter;
+
   int mOnLoadConnection      = -1;
   int mOnSaveConnection      = -1;
   int mFrameTimingConnection = -1;
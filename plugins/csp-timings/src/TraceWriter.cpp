@@ -0,0 +1,213 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TraceWriter.hpp"
+
+#include "logger.hpp"
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+namespace csp::timings {
+
+namespace {
+
+// All events are written to this process.
+const int PROCESS_ID = 1;
+
+// The GPU ranges are written to a separate track with this thread ID.
+const uint32_t GPU_THREAD_ID = 1000000;
+
+// If the file cannot be written fast enough, frames are dropped once this many are queued.
+const std::size_t MAX_QUEUED_FRAMES = 120;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TraceWriter::TraceWriter(std::string const& fileName)
+    : mFile(fileName, std::ios::out | std::ios::trunc)
+    , mStartTime(std::chrono::high_resolution_clock::now().time_since_epoch().count()) {
+
+  if (!mFile) {
+    throw std::runtime_error("Failed to open '" + fileName + "' for writing!");
+  }
+
+  nlohmann::json processName = {{"name", "process_name"}, {"ph", "M"}, {"pid", PROCESS_ID},
+      {"args", {{"name", "CosmoScout VR"}}}};
+
+  mFile << "[\n" << processName.dump();
+  mFile << ",\n" << formatThreadName(GPU_THREAD_ID, "GPU");
+  mHasEvents = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TraceWriter::~TraceWriter() {
+  mTasks.wait();
+
+  if (mDroppedFrames > 0) {
+    logger().warn("{} frames have been dropped from the trace file.", mDroppedFrames);
+  }
+
+  mFile << "\n]\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceWriter::addFrame() {
+  auto& frameStats = cs::utils::FrameStats::get();
+
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  if (mQueuedFrames.size() >= MAX_QUEUED_FRAMES) {
+    if (mDroppedFrames++ == 0) {
+      logger().warn("The trace file cannot be written fast enough, frames will be missing!");
+    }
+    return;
+  }
+
+  Frame frame;
+  frame.mTimerQueryResults   = frameStats.getTimerQueryResults();
+  frame.mValueCounterResults = frameStats.getValueCounterResults();
+  frame.mFlowEvents          = frameStats.getFlowEvents();
+
+  mQueuedFrames.push_back(std::move(frame));
+
+  // The frames have to be written in order, so there is at most one task which writes them.
+  if (!mIsWriting) {
+    mIsWriting = true;
+    mTasks.post([this]() { writeFrames(); }, cs::utils::TaskPriority::eLow);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceWriter::writeFrames() {
+  while (true) {
+    std::vector<Frame> frames;
+
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      if (mQueuedFrames.empty()) {
+        mIsWriting = false;
+        return;
+      }
+
+      std::swap(frames, mQueuedFrames);
+    }
+
+    for (auto const& frame : frames) {
+      mFile << formatFrame(frame);
+    }
+
+    mFile.flush();
+
+    if (!mFile) {
+      logger().warn("Failed to write trace file!");
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string TraceWriter::formatFrame(Frame const& frame) {
+  std::string events;
+
+  // The first range always spans the entire frame.
+  if (frame.mTimerQueryResults.empty()) {
+    return events;
+  }
+
+  auto const& frameRange = frame.mTimerQueryResults.front();
+
+  // Timestamps are given in microseconds relative to the start of the trace.
+  auto toMicroSeconds = [this](int64_t nanoSeconds) {
+    return static_cast<double>(nanoSeconds - mStartTime) * 0.001;
+  };
+
+  auto append = [this, &events](std::string const& event) {
+    events += mHasEvents ? ",\n" : "";
+    events += event;
+    mHasEvents = true;
+  };
+
+  // Each thread is named once, before its first event.
+  auto nameThread = [this, &append](uint32_t thread) {
+    if (mNamedThreads.insert(thread).second) {
+      append(formatThreadName(
+          thread, thread == 0 ? "Main Thread" : "Thread " + std::to_string(thread)));
+    }
+  };
+
+  // The GPU ranges are shifted to the CPU clock.
+  int64_t gpuOffset = frameRange.mCPUStart - frameRange.mGPUStart;
+
+  for (auto const& result : frame.mTimerQueryResults) {
+    nameThread(result.mThread);
+
+    std::string name(result.mName);
+
+    if (result.mMode != cs::utils::FrameStats::TimerMode::eGPU &&
+        result.mCPUEnd >= result.mCPUStart) {
+      nlohmann::json event = {{"name", name}, {"ph", "X"}, {"pid", PROCESS_ID},
+          {"tid", result.mThread}, {"ts", toMicroSeconds(result.mCPUStart)},
+          {"dur", static_cast<double>(result.mCPUEnd - result.mCPUStart) * 0.001}};
+      append(event.dump());
+    }
+
+    if (result.mMode != cs::utils::FrameStats::TimerMode::eCPU &&
+        result.mGPUEnd >= result.mGPUStart) {
+      nlohmann::json event = {{"name", name}, {"ph", "X"}, {"pid", PROCESS_ID},
+          {"tid", GPU_THREAD_ID}, {"ts", toMicroSeconds(result.mGPUStart + gpuOffset)},
+          {"dur", static_cast<double>(result.mGPUEnd - result.mGPUStart) * 0.001}};
+      append(event.dump());
+    }
+  }
+
+  for (auto const& counter : frame.mValueCounterResults) {
+    nlohmann::json event = {{"name", counter.mName}, {"ph", "C"}, {"pid", PROCESS_ID},
+        {"ts", toMicroSeconds(frameRange.mCPUStart)}, {"args", {{"value", counter.mCount}}}};
+    append(event.dump());
+  }
+
+  // The flow events are bound to the range which encloses them. Trace viewers connect flow events
+  // with the same category, name and ID, so the name of each step is stored as argument.
+  for (auto const& flowEvent : frame.mFlowEvents) {
+    nameThread(flowEvent.mThread);
+
+    std::string phase = "t";
+
+    if (flowEvent.mPhase == cs::utils::FrameStats::FlowPhase::eBegin) {
+      phase = "s";
+    } else if (flowEvent.mPhase == cs::utils::FrameStats::FlowPhase::eEnd) {
+      phase = "f";
+    }
+
+    nlohmann::json event = {{"name", "Flow"}, {"cat", "flow"}, {"ph", phase}, {"bp", "e"},
+        {"id", flowEvent.mID}, {"pid", PROCESS_ID}, {"tid", flowEvent.mThread},
+        {"ts", toMicroSeconds(flowEvent.mTime)},
+        {"args", {{"step", std::string(flowEvent.mName)}}}};
+    append(event.dump());
+  }
+
+  return events;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string TraceWriter::formatThreadName(uint32_t thread, std::string const& name) const {
+  nlohmann::json event = {{"name", "thread_name"}, {"ph", "M"}, {"pid", PROCESS_ID},
+      {"tid", thread}, {"args", {{"name", name}}}};
+
+  return event.dump();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::timings
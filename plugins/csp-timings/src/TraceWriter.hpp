@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_TIMINGS_TRACE_WRITER_HPP
+#define CSP_TIMINGS_TRACE_WRITER_HPP
+
+#include "../../../src/cs-utils/FrameStats.hpp"
+#include "../../../src/cs-utils/ThreadPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace csp::timings {
+
+/// The TraceWriter continuously streams the results of cs::utils::FrameStats to a file in the
+/// Chrome trace-event format. Such files can be loaded into chrome://tracing or
+/// https://ui.perfetto.dev.
+///
+/// The CPU ranges of each thread are written as complete events, the GPU ranges are written to an
+/// additional track called "GPU". The value counters are written as counter events and the flow
+/// events of cs::utils::FrameStats as flow events. As the GPU timestamps use a different clock, the
+/// GPU ranges of each frame are shifted so that the GPU frame starts together with the CPU frame.
+///
+/// The events are formatted and written on the cs::utils::ThreadPool. As the file is written
+/// incrementally, the closing bracket of the event array is only appended when the TraceWriter is
+/// destroyed. Trace viewers accept files without it, so the file can be used even if CosmoScout VR
+/// crashes.
+class TraceWriter {
+ public:
+  /// Creates the given file. Throws a std::runtime_error if this fails.
+  explicit TraceWriter(std::string const& fileName);
+
+  TraceWriter(TraceWriter const& other) = delete;
+  TraceWriter(TraceWriter&& other)      = delete;
+
+  TraceWriter& operator=(TraceWriter const& other) = delete;
+  TraceWriter& operator=(TraceWriter&& other)      = delete;
+
+  /// Waits for all frames to be written and closes the file.
+  ~TraceWriter();
+
+  /// Appends the results which are currently returned by cs::utils::FrameStats. This has to be
+  /// called once a frame on the main thread while measurements are enabled. If too many frames are
+  /// waiting to be written, the frame is dropped and a warning is printed.
+  void addFrame();
+
+ private:
+  /// The results of one frame. The names of the ranges and flow events are owned by the FrameStats
+  /// singleton, so they can be copied cheaply.
+  struct Frame {
+    std::vector<cs::utils::FrameStats::TimerQueryResult>   mTimerQueryResults;
+    std::vector<cs::utils::FrameStats::CounterQueryResult> mValueCounterResults;
+    std::vector<cs::utils::FrameStats::FlowEvent>          mFlowEvents;
+  };
+
+  /// Formats and writes all queued frames. Only one such task is running at any time.
+  void writeFrames();
+
+  /// Formats the events of the given frame.
+  std::string formatFrame(Frame const& frame);
+
+  /// Formats a metadata event which names the given thread.
+  std::string formatThreadName(uint32_t thread, std::string const& name) const;
+
+  std::ofstream mFile;
+  int64_t       mStartTime = 0;
+  bool          mHasEvents = false;
+
+  // The threads which have been named in the file already. This is only accessed by the task
+  // running writeFrames().
+  std::set<uint32_t> mNamedThreads;
+
+  std::mutex         mMutex;
+  std::vector<Frame> mQueuedFrames;
+  bool               mIsWriting     = false;
+  std::size_t        mDroppedFrames = 0;
+
+  // This has to be the last member, so that all tasks have finished before the other members are
+  // destroyed.
+  cs::utils::TaskGroup mTasks;
+};
+
+} // namespace csp::timings
+
+#endif // CSP_TIMINGS_TRACE_WRITER_HPP
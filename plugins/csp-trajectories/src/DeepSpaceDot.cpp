@@ -138,6 +138,7 @@ DeepSpaceDot::~DeepSpaceDot() {
 
 void DeepSpaceDot::setObjectName(std::string objectName) {
   mObjectName = std::move(objectName);
+  mTimerName  = cs::utils::FrameStats::get().registerName("DeepSpaceDot for " + mObjectName);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -182,7 +183,7 @@ bool DeepSpaceDot::Do() {
     mShaderDirty = false;
   }
 
-  cs::utils::FrameStats::ScopedTimer timer("DeepSpaceDot for " + mObjectName);
+  cs::utils::FrameStats::ScopedTimer timer(mTimerName);
 
   // get model view and projection matrices
   std::array<GLfloat, 16> glMatMV{};
@@ -9,6 +9,7 @@
 #define CSP_TRAJECTORIES_DEEP_SPACE_DOT_HPP
 
 #include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 
 #include <VistaBase/VistaColor.h>
@@ -81,6 +82,7 @@ class DeepSpaceDot : public IVistaOpenGLDraw {
   std::unique_ptr<VistaOpenGLNode>       mGLNode;
   std::shared_ptr<cs::core::SolarSystem> mSolarSystem;
   std::string                            mObjectName;
+  cs::utils::FrameStats::NameID          mTimerName = 0;
 
   bool mShaderDirty = true;
 
@@ -14,6 +14,7 @@
 #include "../../../src/cs-core/GuiManager.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
 #include "../../../src/cs-core/TimeControl.hpp"
+#include "../../../src/cs-scene/TrajectorySampler.hpp"
 #include "../../../src/cs-utils/logger.hpp"
 
 #include <VistaKernel/DisplayManager/VistaDisplayManager.h>
@@ -79,6 +80,7 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "enablePlanetMarks", o.mEnablePlanetMarks);
   cs::core::Settings::deserialize(j, "hdrFlareScale", o.mHDRFlareScale);
   cs::core::Settings::deserialize(j, "planetMarkScale", o.mPlanetMarkScale);
+  cs::core::Settings::deserialize(j, "cacheDirectory", o.mCacheDirectory);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings const& o) {
@@ -89,6 +91,7 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "enablePlanetMarks", o.mEnablePlanetMarks);
   cs::core::Settings::serialize(j, "hdrFlareScale", o.mHDRFlareScale);
   cs::core::Settings::serialize(j, "planetMarkScale", o.mPlanetMarkScale);
+  cs::core::Settings::serialize(j, "cacheDirectory", o.mCacheDirectory);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -321,6 +324,9 @@ void Plugin::onLoad() {
   // Read settings from JSON.
   from_json(mAllSettings->mPlugins.at("csp-trajectories"), *mPluginSettings);
 
+  cs::scene::TrajectorySampler::get().setCacheDirectory(
+      mPluginSettings->mCacheDirectory.value_or(""));
+
   size_t ldrFlareCount   = 0;
   size_t hdrFlareCount   = 0;
   size_t dotCount        = 0;
@@ -89,6 +89,10 @@ class Plugin : public cs::core::PluginBase {
 
     /// Scaling factor for dots.
     cs::utils::DefaultProperty<double> mPlanetMarkScale{1.0};
+
+    /// If set, sampled trajectories are cached in this directory. The directory is not limited in
+    /// size, so it should be cleaned up from time to time.
+    std::optional<std::string> mCacheDirectory;
   };
 
   void init() override;
@@ -16,6 +16,8 @@
 #include <VistaKernel/GraphicsManager/VistaTransformNode.h>
 #include <VistaKernel/VistaSystem.h>
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
+#include <algorithm>
+#include <cmath>
 
 namespace csp::trajectories {
 
@@ -27,7 +29,7 @@ Trajectory::Trajectory(std::shared_ptr<Plugin::Settings> pluginSettings,
     , mSolarSystem(std::move(solarSystem)) {
 
   pLength.connect([this](double val) {
-    mPoints.clear();
+    resetPoints();
     mTrajectory.setMaxAge(val * 24 * 60 * 60);
   });
 
@@ -36,7 +38,7 @@ Trajectory::Trajectory(std::shared_ptr<Plugin::Settings> pluginSettings,
     mTrajectory.setEndColor(glm::vec4(val, 0.F));
   });
 
-  pSamples.connect([this](uint32_t /*value*/) { mPoints.clear(); });
+  pSamples.connect([this](uint32_t /*value*/) { resetPoints(); });
 
   // Add to scenegraph.
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
@@ -50,6 +52,10 @@ Trajectory::Trajectory(std::shared_ptr<Plugin::Settings> pluginSettings,
 Trajectory::~Trajectory() {
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
   pSG->GetRoot()->DisconnectChild(mGLNode.get());
+
+  if (mPendingJob) {
+    mPendingJob->cancel();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -59,8 +65,7 @@ void Trajectory::update(double tTime) {
     return;
   }
 
-  cs::utils::FrameStats::ScopedTimer timer(
-      "Trajectory of " + mTargetName, cs::utils::FrameStats::TimerMode::eCPU);
+  cs::utils::FrameStats::ScopedTimer timer(mTimerName, cs::utils::FrameStats::TimerMode::eCPU);
 
   auto parent = mSolarSystem->getObject(mParentName);
   auto target = mSolarSystem->getObject(mTargetName);
@@ -69,15 +74,16 @@ void Trajectory::update(double tTime) {
     double dLengthSeconds = pLength.get() * 24.0 * 60.0 * 60.0;
     double dSampleLength  = dLengthSeconds / pSamples.get();
 
+    // A complete recalculation is done in the background. Until it has finished, the old points
+    // are shown.
+    if (mPendingJob && mPendingJob->isReady()) {
+      applyPendingJob();
+    }
+
     // only recalculate if there is not too much change from frame to frame
-    if (std::abs(mLastFrameTime - tTime) <= dLengthSeconds / 10.0) {
+    if (!mPendingJob && std::abs(mLastFrameTime - tTime) <= dLengthSeconds / 10.0) {
       // make sure to re-sample entire trajectory if complete reset is required
-      bool completeRecalculation = false;
-
-      if (mPoints.size() != pSamples.get()) {
-        mPoints.resize(pSamples.get());
-        completeRecalculation = true;
-      }
+      bool completeRecalculation = mPoints.size() != pSamples.get();
 
       if (tTime > mLastSampleTime + dLengthSeconds || tTime < mLastSampleTime - dLengthSeconds) {
         completeRecalculation = true;
@@ -86,54 +92,74 @@ void Trajectory::update(double tTime) {
       auto startExistence = glm::max(parent->getExistence()[0], target->getExistence()[0]);
       auto endExistence   = glm::min(parent->getExistence()[1], target->getExistence()[1]);
 
-      if (mLastUpdateTime < tTime) {
-        if (completeRecalculation) {
-          mLastSampleTime = tTime - dLengthSeconds - dSampleLength;
-          mStartIndex     = 0;
-        }
-
-        while (mLastSampleTime < tTime) {
-          mLastSampleTime += dSampleLength;
-
-          try {
-            double     tSampleTime = glm::clamp(mLastSampleTime, startExistence, endExistence);
-            glm::dvec3 pos         = parent->getRelativePosition(tSampleTime, *target);
-            mPoints[mStartIndex]   = glm::dvec4(pos.x, pos.y, pos.z, tSampleTime);
+      if (completeRecalculation) {
+        // The samples are aligned to multiples of the sample length, so that the sampler can reuse
+        // blocks which have been computed before. The last sample is the first one after tTime if
+        // time runs forward and the last one before tTime if time runs backwards.
+        auto lastIndex = static_cast<int64_t>(mLastUpdateTime < tTime
+                                                  ? std::ceil(tTime / dSampleLength)
+                                                  : std::floor(tTime / dSampleLength));
+
+        cs::scene::TrajectorySampler::Request request{*parent, *target};
+        request.mStep      = dSampleLength;
+        request.mFirst     = lastIndex - static_cast<int64_t>(pSamples.get()) + 1;
+        request.mCount     = pSamples.get();
+        request.mExistence = glm::dvec2(startExistence, endExistence);
+
+        // When time runs backwards, the sample at mStartIndex is taken at
+        // mLastSampleTime - dLengthSeconds.
+        mPendingLastSampleTime = mLastUpdateTime < tTime
+                                     ? static_cast<double>(lastIndex) * dSampleLength
+                                     : static_cast<double>(lastIndex + 1) * dSampleLength;
+        mPendingJob = cs::scene::TrajectorySampler::get().sample(request);
 
-            mStartIndex = (mStartIndex + 1) % static_cast<int>(pSamples.get());
-          } catch (...) {
-            // Getting the relative transformation may fail due to insufficient SPICE data.
-          }
-        }
+        logger().debug("Recalculating trajectory for {}.", mTargetName);
       } else {
-        if (completeRecalculation) {
-          mLastSampleTime = tTime + dLengthSeconds + dSampleLength;
-          mStartIndex     = 0;
-        }
-
-        while (mLastSampleTime - dSampleLength > tTime) {
-          mLastSampleTime -= dSampleLength;
-
-          try {
-            double tSampleTime =
-                glm::clamp(mLastSampleTime - dLengthSeconds, startExistence, endExistence);
-            glm::dvec3 pos = parent->getRelativePosition(tSampleTime, *target);
-            mPoints[(mStartIndex - 1 + pSamples.get()) % pSamples.get()] =
-                glm::dvec4(pos.x, pos.y, pos.z, tSampleTime);
-
-            mStartIndex = (mStartIndex - 1 + static_cast<int>(pSamples.get())) %
-                          static_cast<int>(pSamples.get());
-          } catch (...) {
-            // Getting the relative transformation may fail due to insufficient SPICE data.
+        // The new samples are written to consecutive slots of the ring buffer. Only these are
+        // uploaded to the GPU afterwards.
+        int         firstNewPoint = mStartIndex;
+        std::size_t newPoints     = 0;
+
+        if (mLastUpdateTime < tTime) {
+          while (mLastSampleTime < tTime) {
+            mLastSampleTime += dSampleLength;
+
+            try {
+              double     tSampleTime = glm::clamp(mLastSampleTime, startExistence, endExistence);
+              glm::dvec3 pos         = parent->getRelativePosition(tSampleTime, *target);
+              mPoints[mStartIndex]   = glm::dvec4(pos.x, pos.y, pos.z, tSampleTime);
+
+              mStartIndex = (mStartIndex + 1) % static_cast<int>(pSamples.get());
+              ++newPoints;
+            } catch (...) {
+              // Getting the relative transformation may fail due to insufficient SPICE data.
+            }
+          }
+        } else {
+          while (mLastSampleTime - dSampleLength > tTime) {
+            mLastSampleTime -= dSampleLength;
+
+            try {
+              double tSampleTime =
+                  glm::clamp(mLastSampleTime - dLengthSeconds, startExistence, endExistence);
+              glm::dvec3 pos = parent->getRelativePosition(tSampleTime, *target);
+              mPoints[(mStartIndex - 1 + pSamples.get()) % pSamples.get()] =
+                  glm::dvec4(pos.x, pos.y, pos.z, tSampleTime);
+
+              mStartIndex = (mStartIndex - 1 + static_cast<int>(pSamples.get())) %
+                            static_cast<int>(pSamples.get());
+              firstNewPoint = mStartIndex;
+              ++newPoints;
+            } catch (...) {
+              // Getting the relative transformation may fail due to insufficient SPICE data.
+            }
           }
         }
+
+        mTrajectory.uploadPoints(mPoints, static_cast<std::size_t>(firstNewPoint), newPoints);
       }
 
       mLastUpdateTime = tTime;
-
-      if (completeRecalculation) {
-        logger().debug("Recalculating trajectory for {}.", mTargetName);
-      }
     }
 
     mLastFrameTime = tTime;
@@ -146,7 +172,7 @@ void Trajectory::update(double tTime) {
         // Getting the relative transformation may fail due to insufficient SPICE data.
       }
 
-      mTrajectory.upload(parent->getObserverRelativeTransform(), tTime, mPoints, tip, mStartIndex);
+      mTrajectory.update(parent->getObserverRelativeTransform(), tTime, tip, mStartIndex);
     }
   }
 }
@@ -154,14 +180,15 @@ void Trajectory::update(double tTime) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Trajectory::setTargetName(std::string objectName) {
-  mPoints.clear();
+  resetPoints();
   mTargetName = std::move(objectName);
+  mTimerName  = cs::utils::FrameStats::get().registerName("Trajectory of " + mTargetName);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Trajectory::setParentName(std::string objectName) {
-  mPoints.clear();
+  resetPoints();
   mParentName = std::move(objectName);
 }
 
@@ -179,6 +206,49 @@ std::string const& Trajectory::getParentName() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Trajectory::resetPoints() {
+  mPoints.clear();
+
+  // Uploading no points makes sure that the old polyline is not drawn anymore until the new points
+  // have been sampled.
+  mTrajectory.uploadPoints(mPoints, 0, 0);
+
+  if (mPendingJob) {
+    mPendingJob->cancel();
+    mPendingJob.reset();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Trajectory::applyPendingJob() {
+  mPoints = mPendingJob->getPoints();
+  mPendingJob.reset();
+
+  // Samples for which SPICE had no data are replaced by the previous valid sample. Leading invalid
+  // samples are replaced by the first valid one.
+  auto firstValid = std::find_if(
+      mPoints.begin(), mPoints.end(), [](glm::dvec4 const& p) { return !std::isnan(p.w); });
+
+  glm::dvec4 lastValid = firstValid != mPoints.end() ? *firstValid : glm::dvec4(0.0);
+
+  for (auto& point : mPoints) {
+    if (std::isnan(point.w)) {
+      point = lastValid;
+    } else {
+      lastValid = point;
+    }
+  }
+
+  // The points are sorted by time, so the oldest one is at the beginning of the ring buffer.
+  mStartIndex     = 0;
+  mLastSampleTime = mPendingLastSampleTime;
+
+  mTrajectory.uploadPoints(mPoints, 0, mPoints.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool Trajectory::Do() {
   if (!mPluginSettings->mEnableTrajectories.get()) {
     return true;
@@ -188,7 +258,7 @@ bool Trajectory::Do() {
   auto target = mSolarSystem->getObject(mTargetName);
 
   if (parent->getIsInExistence() && target->getIsOrbitVisible()) {
-    cs::utils::FrameStats::ScopedTimer timer("Trajectory of " + mTargetName);
+    cs::utils::FrameStats::ScopedTimer timer(mTimerName);
     mTrajectory.Do();
   }
 
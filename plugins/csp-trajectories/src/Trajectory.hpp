@@ -12,6 +12,8 @@
 
 #include "../../../src/cs-scene/CelestialObject.hpp"
 #include "../../../src/cs-scene/Trajectory.hpp"
+#include "../../../src/cs-scene/TrajectorySampler.hpp"
+#include "../../../src/cs-utils/FrameStats.hpp"
 
 #include <VistaBase/VistaColor.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
@@ -57,6 +59,12 @@ class Trajectory : public IVistaOpenGLDraw {
   bool GetBoundingBox(VistaBoundingBox& bb) override;
 
  private:
+  /// Clears all points and cancels a pending recalculation.
+  void resetPoints();
+
+  /// Replaces all points with the result of the finished background recalculation.
+  void applyPendingJob();
+
   std::shared_ptr<Plugin::Settings>      mPluginSettings;
   std::shared_ptr<cs::core::SolarSystem> mSolarSystem;
   cs::scene::Trajectory                  mTrajectory;
@@ -66,11 +74,17 @@ class Trajectory : public IVistaOpenGLDraw {
   std::string mTargetName;
   std::string mParentName;
 
+  cs::utils::FrameStats::NameID mTimerName = 0;
+
   std::vector<glm::dvec4> mPoints;
   int                     mStartIndex     = 0;
   double                  mLastSampleTime = 0.0;
   double                  mLastUpdateTime = -1.0;
   double                  mLastFrameTime  = 0.0;
+
+  // A complete recalculation of the trajectory which is computed in the background.
+  std::shared_ptr<cs::scene::TrajectorySampler::Job> mPendingJob;
+  double                                             mPendingLastSampleTime = 0.0;
 };
 
 } // namespace csp::trajectories
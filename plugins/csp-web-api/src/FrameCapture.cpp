@@ -0,0 +1,411 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "FrameCapture.hpp"
+
+#include "../../../src/cs-core/GraphicsEngine.hpp"
+#include "../../../src/cs-core/Settings.hpp"
+#include "logger.hpp"
+
+#include <VistaOGLExt/VistaTexture.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <tiffio.h>
+#include <tiffio.hxx>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+namespace csp::webapi {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Appends void* data to a std::vector<std::byte> (which is given through a void* as well). So this
+// is pretty unsafe, but I think it's the only way to make stb_image write to a
+// std::vector<std::byte>.
+void stbWriteToVector(void* context, void* data, int len) {
+  auto* vector   = static_cast<std::vector<std::byte>*>(context);
+  auto* charData = static_cast<std::byte*>(data);
+  // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  vector->insert(vector->end(), charData, charData + len);
+}
+
+// Encodes the pixel data in "in" to a in-memory tiff in "out".
+template <typename T>
+void tiffWriteToVector(std::vector<std::byte>& out, std::vector<T>& in, uint32_t width,
+    uint32_t height, uint32_t samples, uint32_t bits) {
+
+  std::ostringstream oStream;
+  TIFF*              tiff = TIFFStreamOpen("MemTIFF", &oStream);
+
+  TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, width);
+  TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, height);
+  TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, samples);
+  TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, bits);
+  TIFFSetField(tiff, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
+  TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, 16);
+  TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
+  TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+  TIFFSetField(tiff, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
+
+  if (samples == 3) {
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+  } else {
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+  }
+
+  for (uint32_t i(0); i < height; ++i) {
+    TIFFWriteScanline(tiff, &in.at((height - i - 1) * width * samples), i);
+  }
+
+  TIFFClose(tiff);
+
+  // Convert the stringstream to a std::vector<std::byte>.
+  std::string s = oStream.str();
+  out.reserve(s.size());
+
+  std::transform(s.begin(), s.end(), std::back_inserter(out),
+      [](char& c) { return static_cast<std::byte>(c); });
+}
+
+// OpenGL stores the rows from bottom to top, image files from top to bottom. We flip the rows
+// ourselves, as stbi_flip_vertically_on_write() changes a global state and the images are encoded
+// on multiple threads.
+std::vector<std::byte> flipRows(std::vector<std::byte> const& in, std::size_t rowSize) {
+  std::vector<std::byte> out(in.size());
+  std::size_t            rows = in.size() / rowSize;
+
+  for (std::size_t i(0); i < rows; ++i) {
+    std::memcpy(&out[i * rowSize], &in[(rows - i - 1) * rowSize], rowSize);
+  }
+
+  return out;
+}
+
+// Reduces the size of an 8-bit image with the given number of channels by averaging all input
+// pixels which fall into an output pixel.
+std::vector<std::byte> downsample(std::vector<std::byte> const& in, int32_t width, int32_t height,
+    int32_t channels, int32_t newWidth, int32_t newHeight) {
+
+  std::vector<std::byte> out(static_cast<std::size_t>(newWidth * newHeight * channels));
+  std::vector<uint32_t>  sum(channels);
+
+  for (int32_t y(0); y < newHeight; ++y) {
+    int32_t minY = y * height / newHeight;
+    int32_t maxY = std::max(minY + 1, (y + 1) * height / newHeight);
+
+    for (int32_t x(0); x < newWidth; ++x) {
+      int32_t minX = x * width / newWidth;
+      int32_t maxX = std::max(minX + 1, (x + 1) * width / newWidth);
+
+      std::fill(sum.begin(), sum.end(), 0U);
+
+      for (int32_t v(minY); v < maxY; ++v) {
+        for (int32_t u(minX); u < maxX; ++u) {
+          for (int32_t c(0); c < channels; ++c) {
+            sum[c] += static_cast<uint32_t>(in[(v * width + u) * channels + c]);
+          }
+        }
+      }
+
+      auto count = static_cast<uint32_t>((maxX - minX) * (maxY - minY));
+
+      for (int32_t c(0); c < channels; ++c) {
+        out[(y * newWidth + x) * channels + c] = static_cast<std::byte>(sum[c] / count);
+      }
+    }
+  }
+
+  return out;
+}
+
+// Encodes the pixels which have been read back by FrameCapture::capture(). The rows of the given
+// pixels are ordered from bottom to top.
+FrameCapture::Image encodeImage(std::vector<std::byte>&& pixels, int32_t width, int32_t height,
+    double scale, glm::mat4 const& inverseProjection, FrameCapture::Options const& options) {
+
+  FrameCapture::Image image;
+  image.mMimeType = "image/" + options.mFormat;
+  image.mWidth    = width;
+  image.mHeight   = height;
+
+  auto columns    = static_cast<std::size_t>(width);
+  auto pixelCount = columns * static_cast<std::size_t>(height);
+
+  if (options.mDepth) {
+    std::vector<float> depth(pixelCount);
+    std::memcpy(depth.data(), pixels.data(), pixelCount * sizeof(float));
+
+    if (options.mFormat == "tiff" || options.mFormat == "raw") {
+
+      // If a tiff image is requested, we convert the depth buffer to meters.
+      glm::vec2 pixel(1.F / static_cast<float>(width), 1.F / static_cast<float>(height));
+
+      for (std::size_t i(0); i < depth.size(); ++i) {
+        auto coords = glm::vec2(i % columns, i / columns) * pixel + 0.5F * pixel;
+        auto pos    = inverseProjection * glm::vec4(2.F * coords - 1.F, 2.F * depth[i] - 1.F, 1.F);
+
+        float dist = static_cast<float>(glm::length(glm::vec3(pos) / pos.w) * scale);
+        depth[i]   = std::isinf(dist) ? std::numeric_limits<float>::max() : dist;
+      }
+
+      if (options.mFormat == "tiff") {
+        tiffWriteToVector(image.mData, depth, width, height, 1, 32);
+      } else {
+        image.mData.resize(depth.size() * sizeof(float));
+        std::memcpy(image.mData.data(), depth.data(), image.mData.size());
+      }
+
+    } else {
+      // Capture format is png or jpeg, let's convert the depth to 8-bit.
+      std::vector<std::byte> depthBytes(pixelCount);
+      for (std::size_t i(0); i < depth.size(); ++i) {
+        // The funny cast is required for MSVC 14.1 which does not like casting floating point
+        // numbers to std::byte.
+        depthBytes[i] = static_cast<std::byte>(static_cast<uint8_t>(depth[i] * 255.0));
+      }
+
+      depthBytes = flipRows(depthBytes, static_cast<std::size_t>(width));
+
+      if (options.mFormat == "png") {
+        stbi_write_png_to_func(
+            &stbWriteToVector, &image.mData, width, height, 1, depthBytes.data(), width);
+      } else {
+        stbi_write_jpg_to_func(
+            &stbWriteToVector, &image.mData, width, height, 1, depthBytes.data(), options.mQuality);
+      }
+    }
+
+  } else if (options.mFormat == "raw") {
+    image.mData = std::move(pixels);
+
+  } else {
+
+    // Downsample the image if it does not fit into the maximum size.
+    double factor = 1.0;
+
+    if (options.mMaxWidth > 0) {
+      factor = std::min(factor, static_cast<double>(options.mMaxWidth) / width);
+    }
+
+    if (options.mMaxHeight > 0) {
+      factor = std::min(factor, static_cast<double>(options.mMaxHeight) / height);
+    }
+
+    if (factor < 1.0) {
+      auto newWidth  = std::max(1, static_cast<int32_t>(width * factor));
+      auto newHeight = std::max(1, static_cast<int32_t>(height * factor));
+      pixels         = downsample(pixels, width, height, 3, newWidth, newHeight);
+      width          = newWidth;
+      height         = newHeight;
+      image.mWidth   = width;
+      image.mHeight  = height;
+    }
+
+    if (options.mFormat == "tiff") {
+      tiffWriteToVector(image.mData, pixels, width, height, 3, 8);
+      return image;
+    }
+
+    pixels = flipRows(pixels, static_cast<std::size_t>(width) * 3);
+
+    if (options.mFormat == "rgb") {
+      image.mData = std::move(pixels);
+    } else if (options.mFormat == "png") {
+      stbi_write_png_to_func(
+          &stbWriteToVector, &image.mData, width, height, 3, pixels.data(), width * 3);
+    } else {
+      stbi_write_jpg_to_func(
+          &stbWriteToVector, &image.mData, width, height, 3, pixels.data(), options.mQuality);
+    }
+  }
+
+  return image;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrameCapture::FrameCapture(std::shared_ptr<cs::core::Settings> settings,
+    std::shared_ptr<cs::core::GraphicsEngine>                  graphicsEngine)
+    : mSettings(std::move(settings))
+    , mGraphicsEngine(std::move(graphicsEngine)) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrameCapture::~FrameCapture() {
+  // The worker threads may still read from the mapped buffers.
+  mTasks.wait();
+
+  for (auto& buffer : mBuffers) {
+    if (buffer.mFence) {
+      glDeleteSync(buffer.mFence);
+    }
+
+    if (buffer.mBuffer) {
+      glDeleteBuffers(1, &buffer.mBuffer);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameCapture::capture(int32_t width, int32_t height, double observerScale,
+    Options const& options, Callback callback) {
+
+  auto& buffer = mBuffers.at(mNextBuffer);
+  mNextBuffer  = (mNextBuffer + 1) % BUFFER_COUNT;
+
+  // If the buffer is still in use, we have to wait for the GPU to finish the copy and for a worker
+  // thread to copy the pixels out of the buffer.
+  if (buffer.mFence) {
+    glClientWaitSync(buffer.mFence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    encode(buffer);
+  }
+
+  while (buffer.mBusy) {
+    std::this_thread::yield();
+  }
+
+  bool readHDRBuffer =
+      !options.mDepth && options.mFormat == "raw" && mSettings->mGraphics.pEnableHDR.get();
+
+  // Raw color images are read as floats. Without HDR, the values in the buffer have been converted
+  // to [0, 255] before, so for high quality raw output, HDR mode should be used.
+  std::size_t pixelSize = 3;
+  if (options.mDepth) {
+    pixelSize = sizeof(float);
+  } else if (options.mFormat == "raw") {
+    pixelSize = 3 * sizeof(float);
+  }
+
+  std::size_t size =
+      static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * pixelSize;
+
+  // The buffers are immutable, so they have to be recreated if the size changes.
+  if (buffer.mSize != size) {
+    if (buffer.mBuffer) {
+      glDeleteBuffers(1, &buffer.mBuffer);
+    }
+
+    GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &buffer.mBuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.mBuffer);
+    glBufferStorage(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, flags);
+    buffer.mData = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(size), flags);
+    buffer.mSize = size;
+  } else {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.mBuffer);
+  }
+
+  GLint packAlignment = 4;
+  glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+  if (options.mDepth) {
+    glReadPixels(0, 0, width, height, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+  } else if (readHDRBuffer) {
+    VistaTexture* texture = mGraphicsEngine->getHDRBuffer()->getCurrentWriteAttachment();
+    texture->Bind();
+    glGetTexImage(texture->GetTarget(), 0, GL_RGB, GL_FLOAT, nullptr);
+    texture->Unbind();
+  } else if (options.mFormat == "raw") {
+    glReadPixels(0, 0, width, height, GL_RGB, GL_FLOAT, nullptr);
+  } else {
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+  }
+
+  glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  buffer.mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  buffer.mBusy  = true;
+
+  // The projection matrix is required to convert the depth values to meters.
+  std::array<GLfloat, 16> glMatP{};
+  glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
+
+  buffer.mWidth             = width;
+  buffer.mHeight            = height;
+  buffer.mScale             = observerScale;
+  buffer.mInverseProjection = glm::inverse(glm::make_mat4x4(glMatP.data()));
+  buffer.mOptions           = options;
+  buffer.mCallback          = std::move(callback);
+
+  ++mPendingCaptures;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool FrameCapture::isBusy() const {
+  return mBuffers.at(mNextBuffer).mBusy;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t FrameCapture::getPendingCaptureCount() const {
+  return mPendingCaptures;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameCapture::update() {
+  for (auto& buffer : mBuffers) {
+    if (buffer.mFence && glClientWaitSync(buffer.mFence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+      encode(buffer);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameCapture::encode(Buffer& buffer) {
+  glDeleteSync(buffer.mFence);
+  buffer.mFence = nullptr;
+
+  mTasks.post([this, &buffer]() {
+    // Copy everything out of the buffer first, so that it can be reused as soon as possible.
+    std::vector<std::byte> pixels(buffer.mSize);
+    std::memcpy(pixels.data(), buffer.mData, buffer.mSize);
+
+    auto width             = buffer.mWidth;
+    auto height            = buffer.mHeight;
+    auto scale             = buffer.mScale;
+    auto inverseProjection = buffer.mInverseProjection;
+    auto options           = buffer.mOptions;
+    auto callback          = std::move(buffer.mCallback);
+
+    buffer.mBusy = false;
+
+    Image image;
+
+    try {
+      image = encodeImage(std::move(pixels), width, height, scale, inverseProjection, options);
+    } catch (std::exception const& e) { logger().error("Failed to encode capture: {}", e.what()); }
+
+    callback(std::move(image));
+
+    --mPendingCaptures;
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::webapi
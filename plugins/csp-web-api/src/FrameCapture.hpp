@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CSP_WEB_API_FRAME_CAPTURE_HPP
+#define CSP_WEB_API_FRAME_CAPTURE_HPP
+
+#include "../../../src/cs-utils/ThreadPool.hpp"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cs::core {
+class GraphicsEngine;
+class Settings;
+} // namespace cs::core
+
+namespace csp::webapi {
+
+/// The FrameCapture reads the pixels of the current framebuffer without stalling the render loop.
+/// Each call to capture() copies the framebuffer into one of several persistently mapped pixel
+/// buffer objects and inserts a fence after the copy. update() has to be called once a frame; as
+/// soon as the fence of a buffer has been signaled, the pixels are converted and encoded on the
+/// cs::utils::ThreadPool. The encoded image is then passed to the callback given to capture(). The
+/// callback is executed on a worker thread. If encoding fails, the data of the image is empty.
+class FrameCapture {
+ public:
+  /// Describes how the captured pixels are encoded.
+  struct Options {
+    /// Either "png", "jpeg", "tiff", "raw" or "rgb". "raw" contains the color or depth values as
+    /// floats with the rows ordered from bottom to top. "rgb" contains uncompressed 8-bit color
+    /// values with the rows ordered from top to bottom.
+    std::string mFormat = "png";
+
+    /// If set, the depth buffer is captured instead of the color buffer. For "tiff" and "raw", the
+    /// depth values are converted to the distance in meters. For "png" and "jpeg", the depth buffer
+    /// is written as 8-bit grayscale image.
+    bool mDepth = false;
+
+    /// The quality of "jpeg" images in the range [1, 100].
+    int32_t mQuality = 80;
+
+    /// If set, color images with 8 bits per channel are downsampled with a box filter so that they
+    /// fit into the given size. The aspect ratio is preserved. Images are never upsampled.
+    int32_t mMaxWidth  = 0;
+    int32_t mMaxHeight = 0;
+  };
+
+  /// An encoded image.
+  struct Image {
+    std::string            mMimeType;
+    std::vector<std::byte> mData;
+    int32_t                mWidth  = 0;
+    int32_t                mHeight = 0;
+  };
+
+  using Callback = std::function<void(Image&&)>;
+
+  /// The graphics engine is required to access the HDR buffer for "raw" color captures.
+  FrameCapture(std::shared_ptr<cs::core::Settings> settings,
+      std::shared_ptr<cs::core::GraphicsEngine>    graphicsEngine);
+
+  FrameCapture(FrameCapture const& other) = delete;
+  FrameCapture(FrameCapture&& other)      = delete;
+
+  FrameCapture& operator=(FrameCapture const& other) = delete;
+  FrameCapture& operator=(FrameCapture&& other)      = delete;
+
+  /// Waits for all pending captures to be encoded.
+  ~FrameCapture();
+
+  /// Starts reading the pixels of the current framebuffer. The region is given in pixels from the
+  /// lower left corner. If all buffers are busy, this blocks until the oldest capture has been read
+  /// back; use isBusy() to avoid this. The observer scale is used to convert depth values to
+  /// meters.
+  void capture(int32_t width, int32_t height, double observerScale, Options const& options,
+      Callback callback);
+
+  /// Returns true if a call to capture() would block.
+  bool isBusy() const;
+
+  /// Returns the number of captures which have been started but not passed to their callback yet.
+  uint32_t getPendingCaptureCount() const;
+
+  /// Passes all captures whose fence has been signaled to the ThreadPool. This has to be called
+  /// once a frame on the main thread.
+  void update();
+
+ private:
+  /// The number of pixel buffer objects.
+  static constexpr std::size_t BUFFER_COUNT = 3;
+
+  struct Buffer {
+    GLuint      mBuffer = 0;
+    void*       mData   = nullptr;
+    std::size_t mSize   = 0;
+    GLsync      mFence  = nullptr;
+
+    // This is set by capture() and reset by the worker thread once the pixels have been copied.
+    std::atomic<bool> mBusy{false};
+
+    // The parameters of the capture which is currently stored in the buffer.
+    int32_t   mWidth  = 0;
+    int32_t   mHeight = 0;
+    double    mScale  = 1.0;
+    glm::mat4 mInverseProjection{};
+    Options   mOptions;
+    Callback  mCallback;
+  };
+
+  /// Passes the given buffer to the ThreadPool. It must only be called once its fence has been
+  /// signaled.
+  void encode(Buffer& buffer);
+
+  std::shared_ptr<cs::core::Settings>       mSettings;
+  std::shared_ptr<cs::core::GraphicsEngine> mGraphicsEngine;
+  std::array<Buffer, BUFFER_COUNT>          mBuffers;
+  std::size_t                               mNextBuffer = 0;
+  std::atomic<uint32_t>                     mPendingCaptures{0};
+
+  // This has to be the last member, so that all tasks have finished before the buffers are
+  // destroyed.
+  cs::utils::TaskGroup mTasks;
+};
+
+} // namespace csp::webapi
+
+#endif // CSP_WEB_API_FRAME_CAPTURE_HPP
@@ -10,32 +10,25 @@
 #include "../../../src/cs-core/GuiManager.hpp"
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-core/TimeControl.hpp"
 #include "../../../src/cs-scene/CelestialObserver.hpp"
+#include "../../../src/cs-utils/convert.hpp"
 #include "../../../src/cs-utils/logger.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 #include "logger.hpp"
 
 #include <CivetServer.h>
-#include <GL/glew.h>
 #include <VistaKernel/DisplayManager/VistaDisplayManager.h>
 #include <VistaKernel/DisplayManager/VistaProjection.h>
 #include <VistaKernel/DisplayManager/VistaViewport.h>
 #include <VistaKernel/DisplayManager/VistaWindow.h>
 #include <VistaKernel/VistaFrameLoop.h>
 #include <VistaKernel/VistaSystem.h>
-#include <VistaOGLExt/VistaTexture.h>
+#include <algorithm>
+#include <array>
 #include <curlpp/cURLpp.hpp>
-#include <glm/gtc/type_ptr.hpp>
-#include <sstream>
-#include <tiffio.h>
-#include <tiffio.hxx>
-
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include <stb_image_write.h>
 #include <utility>
 
-#include "../../../src/cs-core/GraphicsEngine.hpp"
-
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 EXPORT_FN cs::core::PluginBase* create() {
@@ -54,53 +47,14 @@ namespace {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Appends void* data to a std::vector<std::byte> (which is given through a void* as well). So this
-// is pretty unsafe, but I think it's the only way to make stb_image write to a
-// std::vector<std::byte>.
-void stbWriteToVector(void* context, void* data, int len) {
-  auto* vector   = static_cast<std::vector<std::byte>*>(context);
-  auto* charData = static_cast<std::byte*>(data);
-  // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  vector->insert(vector->end(), charData, charData + len);
-}
-
-// Encodes the pixel data in "in" to a in-memory tiff in "out".
-template <typename T>
-void tiffWriteToVector(std::vector<std::byte>& out, std::vector<T>& in, uint32_t width,
-    uint32_t height, uint32_t samples, uint32_t bits) {
-
-  std::ostringstream oStream;
-  TIFF*              tiff = TIFFStreamOpen("MemTIFF", &oStream);
-
-  TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, width);
-  TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, height);
-  TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, samples);
-  TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, bits);
-  TIFFSetField(tiff, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
-  TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, 16);
-  TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
-  TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-  TIFFSetField(tiff, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
-
-  if (samples == 3) {
-    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
-  } else {
-    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
-  }
-
-  for (uint32_t i(0); i < height; ++i) {
-    TIFFWriteScanline(tiff, &in.at((height - i - 1) * width * samples), i);
-  }
-
-  TIFFClose(tiff);
+// The maximum number of clients which can be connected to /stream at the same time. Each stream
+// occupies one thread of the server.
+const std::size_t MAX_STREAMS = 4;
 
-  // Convert the stringstream to a std::vector<std::byte>.
-  std::string s = oStream.str();
-  out.reserve(s.size());
-
-  std::transform(s.begin(), s.end(), std::back_inserter(out),
-      [](char& c) { return static_cast<std::byte>(c); });
-}
+// If a client of /stream falls behind, the JPEG quality is reduced down to this value. After that,
+// the resolution is reduced down to this fraction of the requested resolution.
+const int32_t MIN_STREAM_QUALITY = 20;
+const double  MIN_STREAM_SCALE   = 0.25;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -179,6 +133,8 @@ void Plugin::init() {
 
   logger().info("Loading plugin...");
 
+  mFrameCapture = std::make_unique<FrameCapture>(mAllSettings, mGraphicsEngine);
+
   // We store all emitted log messages (up to a maximum of 1000) in a std::deque in order to be able
   // to answer to /log requests.
   mOnLogMessageConnection = cs::utils::onLogMessage().connect(
@@ -262,49 +218,220 @@ void Plugin::init() {
   // The /capture endpoint is a little bit more involved. As it takes several frames for the
   // capture to be completed (first we have to resize CosmoScout's window to the requested size,
   // then we have to wait some frames so that everything is loaded properly), we have to do some
-  // more synchronization here.
+  // more synchronization here. The request is processed by the main thread in Plugin::update()
+  // and the image is encoded on the ThreadPool.
   mHandlers.emplace("/capture", std::make_unique<GetHandler>([this](mg_connection* conn) {
-    // First acquire the lock to make sure the mCapture* members are not currently read by the
-    // main thread.
-    std::unique_lock<std::mutex> lock(mCaptureMutex);
+    auto job = std::make_shared<CaptureJob>();
 
     // Read all paramters.
-    mCaptureDelay  = std::clamp(getParam<int32_t>(conn, "delay", 50), 1, 200);
-    mCaptureWidth  = std::clamp(getParam<int32_t>(conn, "width", 0), 0, 4096);
-    mCaptureHeight = std::clamp(getParam<int32_t>(conn, "height", 0), 0, 4096);
-    mRestoreState  = getParam<std::string>(conn, "restoreState", "false") == "true";
-    mCaptureGui    = getParam<std::string>(conn, "gui", "auto");
-    mCaptureDepth  = getParam<std::string>(conn, "depth", "false") == "true";
-    mCaptureFormat = getParam<std::string>(conn, "format", mCaptureDepth ? "tiff" : "png");
-
-    // Validate format parameter.
-    if (mCaptureFormat != "png" && mCaptureFormat != "jpeg" && mCaptureFormat != "tiff" &&
-        mCaptureFormat != "raw") {
-      mg_send_http_error(
-          conn, 422, "Only 'png', 'jpeg', 'tiff' or 'raw' are allowed for the format parameter!");
+    job->mDelay            = getParam<int32_t>(conn, "delay", 50);
+    job->mWidth            = getParam<int32_t>(conn, "width", 0);
+    job->mHeight           = getParam<int32_t>(conn, "height", 0);
+    job->mRestoreState     = getParam<std::string>(conn, "restoreState", "false") == "true";
+    job->mGui              = getParam<std::string>(conn, "gui", "auto");
+    job->mOptions.mDepth   = getParam<std::string>(conn, "depth", "false") == "true";
+    job->mOptions.mQuality = getParam<int32_t>(conn, "quality", 80);
+    job->mOptions.mFormat =
+        getParam<std::string>(conn, "format", job->mOptions.mDepth ? "tiff" : "png");
+
+    // A single frame is captured without changing the time or the observer's location.
+    job->mFrames.resize(1);
+
+    if (auto error = validateCaptureJob(*job)) {
+      mg_send_http_error(conn, 422, "%s", error->c_str());
+      return;
+    }
+
+    queueCaptureJob(job);
+
+    // Now we wait for the capture. It is actually captured in the Plugin::update() method further
+    // below.
+    auto image = job->waitForImage(0);
+
+    if (!image || image->mData.empty()) {
+      mg_send_http_error(conn, 500, "Failed to capture the image!");
+      return;
+    }
+
+    // The capture has been captured, return the result!
+    mg_send_http_ok(conn, image->mMimeType.c_str(), static_cast<int64_t>(image->mData.size()));
+    mg_write(conn, image->mData.data(), image->mData.size());
+  }));
+
+  // The /capture-sequence endpoint works like /capture, but it captures multiple frames. The
+  // parameters are given as a json object in the body of a POST request. Each entry of the "frames"
+  // array may set the simulation time and the observer's location before the frame is captured.
+  // The images are streamed back as a multipart response as soon as they have been encoded.
+  mHandlers.emplace("/capture-sequence", std::make_unique<PostHandler>([this](mg_connection* conn) {
+    auto job = std::make_shared<CaptureJob>();
+
+    try {
+      auto json = nlohmann::json::parse(CivetServer::getPostData(conn));
+
+      job->mDelay            = json.value("delay", 50);
+      job->mFrameDelay       = json.value("frameDelay", job->mDelay);
+      job->mWidth            = json.value("width", 0);
+      job->mHeight           = json.value("height", 0);
+      job->mRestoreState     = json.value("restoreState", false);
+      job->mGui              = json.value("gui", "auto");
+      job->mOptions.mDepth   = json.value("depth", false);
+      job->mOptions.mFormat  = json.value("format", job->mOptions.mDepth ? "tiff" : "png");
+      job->mOptions.mQuality = json.value("quality", 80);
+
+      for (auto const& frame : json.at("frames")) {
+        CaptureJob::Frame f;
+        cs::core::Settings::deserialize(frame, "time", f.mTime);
+        cs::core::Settings::deserialize(frame, "location", f.mLocation);
+        job->mFrames.push_back(f);
+      }
+    } catch (std::exception const& e) {
+      mg_send_http_error(conn, 400, "Failed to parse request: %s", e.what());
+      return;
+    }
+
+    if (auto error = validateCaptureJob(*job)) {
+      mg_send_http_error(conn, 422, "%s", error->c_str());
       return;
     }
 
-    // Validate gui parameter.
-    if (mCaptureGui != "auto" && mCaptureGui != "true" && mCaptureGui != "false") {
+    queueCaptureJob(job);
+
+    std::string boundary = "cosmoscout-capture";
+    mg_send_http_ok(conn, ("multipart/mixed; boundary=" + boundary).c_str(), -1);
+
+    for (std::size_t i(0); i < job->mFrames.size(); ++i) {
+      auto image = job->waitForImage(i);
+
+      if (!image) {
+        break;
+      }
+
+      std::string header = "--" + boundary + "\r\nContent-Type: " + image->mMimeType +
+                           "\r\nContent-Length: " + std::to_string(image->mData.size()) +
+                           "\r\nX-Frame-Index: " + std::to_string(i) + "\r\n\r\n";
+
+      // An empty chunk would end the response, so the data of images which could not be encoded
+      // is skipped. If the client has closed the connection, there is no need to capture the
+      // remaining frames.
+      bool failed = mg_send_chunk(conn, header.data(), static_cast<unsigned>(header.size())) < 0;
+
+      if (!failed && !image->mData.empty()) {
+        failed = mg_send_chunk(conn, reinterpret_cast<char const*>(image->mData.data()),
+                     static_cast<unsigned>(image->mData.size())) < 0;
+      }
+
+      if (failed || mg_send_chunk(conn, "\r\n", 2) < 0) {
+        job->cancel();
+        return;
+      }
+    }
+
+    std::string footer = "--" + boundary + "--\r\n";
+    mg_send_chunk(conn, footer.data(), static_cast<unsigned>(footer.size()));
+    mg_send_chunk(conn, "", 0);
+  }));
+
+  // The /stream endpoint continuously sends frames to the client until it disconnects. With
+  // format=mjpeg, the frames are sent as a multipart/x-mixed-replace response which can be shown
+  // by most web browsers. With format=raw, each frame consists of its width and height as 32-bit
+  // unsigned integers, followed by the 8-bit RGB values of all pixels from the top row to the
+  // bottom row.
+  mHandlers.emplace("/stream", std::make_unique<GetHandler>([this](mg_connection* conn) {
+    auto stream    = std::make_shared<Stream>();
+    auto format    = getParam<std::string>(conn, "format", "mjpeg");
+    auto frameRate = getParam<double>(conn, "fps", 10.0);
+
+    stream->mRaw        = format == "raw";
+    stream->mMaxWidth   = getParam<int32_t>(conn, "width", 0);
+    stream->mMaxHeight  = getParam<int32_t>(conn, "height", 0);
+    stream->mMaxQuality = getParam<int32_t>(conn, "quality", 80);
+    stream->mQuality    = stream->mMaxQuality;
+
+    if (format != "mjpeg" && format != "raw") {
+      mg_send_http_error(conn, 422, "Only 'mjpeg' or 'raw' are allowed for the format parameter!");
+      return;
+    }
+
+    if (!(frameRate > 0.0 && frameRate <= 60.0)) {
+      mg_send_http_error(conn, 422, "The fps parameter must be in the range (0, 60]!");
+      return;
+    }
+
+    if (stream->mMaxWidth < 0 || stream->mMaxWidth > 4096 || stream->mMaxHeight < 0 ||
+        stream->mMaxHeight > 4096) {
       mg_send_http_error(
-          conn, 422, "Only 'auto', 'true', or 'false' are allowed for the gui parameter!");
+          conn, 422, "The width and height parameters must be in the range [0, 4096]!");
       return;
     }
 
-    // This tells the main thread that a capture request is pending.
-    mCaptureRequested = true;
+    if (stream->mMaxQuality < 1 || stream->mMaxQuality > 100) {
+      mg_send_http_error(conn, 422, "The quality parameter must be in the range [1, 100]!");
+      return;
+    }
 
-    // Now we use a condition variable to wait for the capture. It is actually captured in the
-    // Plugin::update() method further below.
-    mCaptureDone.wait(lock);
-    // The capture has been captured, return the result!
-    mg_send_http_ok(conn, ("image/" + mCaptureFormat).c_str(), mCapture.size());
-    mg_write(conn, mCapture.data(), mCapture.size());
+    stream->mInterval = 1.0 / frameRate;
+
+    {
+      std::lock_guard<std::mutex> lock(mStreamMutex);
+      if (!mStreamsClosed && mStreams.size() < MAX_STREAMS) {
+        mStreams.push_back(stream);
+      } else {
+        stream->close();
+      }
+    }
+
+    if (stream->isClosed()) {
+      mg_send_http_error(conn, 503, "Too many streams are running!");
+      return;
+    }
+
+    std::string boundary = "cosmoscout-stream";
+
+    if (stream->mRaw) {
+      mg_send_http_ok(conn, "application/octet-stream", -1);
+    } else {
+      mg_send_http_ok(conn, ("multipart/x-mixed-replace; boundary=" + boundary).c_str(), -1);
+    }
+
+    while (auto frame = stream->waitForFrame()) {
+      if (frame->mData.empty()) {
+        continue;
+      }
+
+      std::string header;
+
+      if (stream->mRaw) {
+        std::array<uint32_t, 2> size{
+            static_cast<uint32_t>(frame->mWidth), static_cast<uint32_t>(frame->mHeight)};
+        header.assign(reinterpret_cast<char const*>(size.data()), sizeof(size));
+      } else {
+        header = "--" + boundary + "\r\nContent-Type: image/jpeg\r\nContent-Length: " +
+                 std::to_string(frame->mData.size()) + "\r\n\r\n";
+      }
+
+      bool failed =
+          mg_send_chunk(conn, header.data(), static_cast<unsigned>(header.size())) < 0 ||
+          mg_send_chunk(conn, reinterpret_cast<char const*>(frame->mData.data()),
+              static_cast<unsigned>(frame->mData.size())) < 0;
+
+      if (!failed && !stream->mRaw) {
+        failed = mg_send_chunk(conn, "\r\n", 2) < 0;
+      }
+
+      // The client has closed the connection.
+      if (failed) {
+        break;
+      }
+    }
+
+    // The stream is removed by the main thread in Plugin::update().
+    stream->close();
+    mg_send_chunk(conn, "", 0);
   }));
 
-  // All POST requests received on /run-js are stored in a queue. They are executed in the main
-  // thread in the Plugin::update() method further below.
+  // All POST requests received on /run-js are stored in a queue. They are passed to the GUI in the
+  // main thread in the Plugin::update() method further below. See WebView::executeJavascript() for
+  // when and how they are executed.
   mHandlers.emplace("/run-js", std::make_unique<PostHandler>([this](mg_connection* conn) {
     std::lock_guard<std::mutex> lock(mJavaScriptCallsMutex);
     mJavaScriptCalls.push(CivetServer::getPostData(conn));
@@ -335,8 +462,23 @@ void Plugin::deInit() {
   mAllSettings->onSave().disconnect(mOnSaveConnection);
   cs::utils::onLogMessage().disconnect(mOnLogMessageConnection);
 
+  // Wake up the server's threads if they are waiting for a capture or for a frame of a stream.
+  cancelCaptureJobs();
+
+  {
+    std::lock_guard<std::mutex> lock(mStreamMutex);
+    mStreamsClosed = true;
+    for (auto const& stream : mStreams) {
+      stream->close();
+    }
+    mStreams.clear();
+  }
+
   quitServer();
 
+  mActiveCaptureJob.reset();
+  mFrameCapture.reset();
+
   logger().info("Unloading done.");
 }
 
@@ -366,7 +508,7 @@ void Plugin::update() {
         logger().error("Failed to write settings: {}", e.what());
         mSaveSettings = "";
       }
-      mSaveDone.notify_one();
+      mSaveDone.notify_all();
       mSaveRequested = false;
     }
   }
@@ -386,155 +528,354 @@ void Plugin::update() {
     }
   }
 
-  // If a screen shot has been requested, we first resize the image to the given size. Then we wait
-  // mCaptureDelay frames until we actually read the pixels.
-  {
+  // Start the next capture job if there is none in progress.
+  if (!mActiveCaptureJob) {
     std::lock_guard<std::mutex> lock(mCaptureMutex);
-    if (mCaptureRequested) {
-      if (mCaptureWidth > 0 && mCaptureHeight > 0) {
-        auto* window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
-        window->GetWindowProperties()->GetSize(mRestoreW, mRestoreH);
-        window->GetWindowProperties()->SetSize(mCaptureWidth, mCaptureHeight);
-      }
-      mCaptureAtFrame = GetVistaSystem()->GetFrameLoop()->GetFrameCount() + mCaptureDelay;
-      if (mCaptureGui != "auto") {
-        mRestoreGui                        = mAllSettings->pEnableUserInterface.get();
-        mAllSettings->pEnableUserInterface = mCaptureGui == "true";
-      }
-      mCaptureRequested = false;
+    if (!mCaptureJobs.empty()) {
+      mActiveCaptureJob = mCaptureJobs.front();
+      mCaptureJobs.pop();
+      startCaptureJob();
     }
+  }
 
-    // Now we waited several frames. We read the pixels, encode the data as png and notify the
-    // server's worker thread that the screen shot is done.
-    if (mCaptureAtFrame > 0 &&
-        mCaptureAtFrame == GetVistaSystem()->GetFrameLoop()->GetFrameCount()) {
+  if (mActiveCaptureJob) {
+    updateCaptureJob();
+  }
 
-      auto* window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
-      window->GetWindowProperties()->GetSize(mCaptureWidth, mCaptureHeight);
-
-      logger().debug("Capturing capture for /capture request: resolution = {}x{}, show gui = {}, "
-                     "depth = {}, format = {}, restore resolution to {}x{}, reenable Gui {}",
-          mCaptureWidth, mCaptureHeight, mCaptureGui, mCaptureDepth, mCaptureFormat, mRestoreW,
-          mRestoreH, mRestoreGui);
-
-      // We encode image data in the main thread as this is not thread-safe.
-      stbi_flip_vertically_on_write(1);
-
-      // Clear last data first.
-      mCapture.clear();
-
-      if (mCaptureDepth) {
-
-        // Capture the depth component.
-        std::vector<float> capture(mCaptureWidth * mCaptureHeight);
-        glReadPixels(
-            0, 0, mCaptureWidth, mCaptureHeight, GL_DEPTH_COMPONENT, GL_FLOAT, capture.data());
-
-        if (mCaptureFormat == "tiff" || mCaptureFormat == "raw") {
-
-          // If a tiff image is requested, we convert the depth buffer to meters.
-          std::array<GLfloat, 16> glMatP{};
-          glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
-          auto      matInvP = glm::inverse(glm::make_mat4x4(glMatP.data()));
-          glm::vec2 pixel(1.F / mCaptureWidth, 1.F / mCaptureHeight);
-
-          for (size_t i(0); i < capture.size(); ++i) {
-            auto coords = glm::vec2(i % mCaptureWidth, i / mCaptureWidth) * pixel + 0.5F * pixel;
-            auto pos    = matInvP * glm::vec4(2.F * coords - 1.F, 2.F * capture[i] - 1.F, 1.F);
-
-            float dist = static_cast<float>(
-                (glm::length(pos.xyz() / pos.w) * mSolarSystem->getObserver().getScale()));
-            capture[i] = std::isinf(dist) ? std::numeric_limits<float>::max() : dist;
-          }
-          if (mCaptureFormat == "tiff") {
-            // Now write the tiff image.
-            tiffWriteToVector(mCapture, capture, mCaptureWidth, mCaptureHeight, 1, 32);
-          } else {
-            // Write raw vector
-            mCapture.resize(capture.size() * sizeof(float));
-            memcpy(mCapture.data(), capture.data(), mCapture.size());
-          }
-
-        } else {
-          // Capture format is png or jpeg, let's convert the depth to 8-bit.
-          std::vector<std::byte> captureByte(mCaptureWidth * mCaptureHeight);
-          for (size_t i(0); i < capture.size(); ++i) {
-            // The funny cast is required for MSVC 14.1 which does not like casting floating point
-            // numbers to std::byte.
-            captureByte[i] = static_cast<std::byte>(static_cast<uint8_t>(capture[i] * 255.0));
-          }
-
-          if (mCaptureFormat == "png") {
-            stbi_write_png_to_func(&stbWriteToVector, &mCapture, mCaptureWidth, mCaptureHeight, 1,
-                captureByte.data(), mCaptureWidth);
-          } else {
-            stbi_write_jpg_to_func(&stbWriteToVector, &mCapture, mCaptureWidth, mCaptureHeight, 1,
-                captureByte.data(), 80);
-          }
-        }
+  // Capture new frames for all connected clients of /stream.
+  updateStreams();
+
+  // Pass all finished read-backs to the ThreadPool for encoding.
+  mFrameCapture->update();
+
+  // In this plugin, we cannot call this directly when the onLoad signal of the settings is fired,
+  // since reloading can cause our server to be restarted. And as reloading can be triggered from a
+  // /load request, this could lead to a deadlock.
+  if (mReloadRequired) {
+    from_json(mAllSettings->mPlugins.at("csp-web-api"), mPluginSettings);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<FrameCapture::Image> Plugin::CaptureJob::waitForImage(std::size_t index) {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mImageDone.wait(lock, [&]() { return mCancelled || (index < mImages.size() && mImages[index]); });
+
+  if (mCancelled) {
+    return std::nullopt;
+  }
+
+  return std::move(mImages[index]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::CaptureJob::setImage(std::size_t index, FrameCapture::Image&& image) {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mImages.resize(std::max(mImages.size(), index + 1));
+    mImages[index] = std::move(image);
+  }
+
+  mImageDone.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::CaptureJob::cancel() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCancelled = true;
+  }
+
+  mImageDone.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Plugin::CaptureJob::isCancelled() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mCancelled;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<FrameCapture::Image> Plugin::Stream::waitForFrame() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mFrameDone.wait(lock, [this]() { return mClosed || mFrame; });
+
+  if (mClosed) {
+    return std::nullopt;
+  }
+
+  auto frame = std::move(mFrame);
+  mFrame.reset();
+  return frame;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::Stream::setFrame(FrameCapture::Image&& frame) {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFrame = std::move(frame);
+  }
+
+  mFrameDone.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::Stream::close() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mClosed = true;
+  }
+
+  mFrameDone.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Plugin::Stream::isClosed() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mClosed;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Plugin::Stream::isFrameConsumed() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return !mFrame;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::updateStreams() {
+  std::lock_guard<std::mutex> lock(mStreamMutex);
+
+  // Remove all streams whose client has disconnected.
+  mStreams.erase(std::remove_if(mStreams.begin(), mStreams.end(),
+                     [](auto const& stream) { return stream->isClosed(); }),
+      mStreams.end());
+
+  auto now = std::chrono::steady_clock::now();
+
+  for (auto const& stream : mStreams) {
+    if (now < stream->mNextFrameTime) {
+      continue;
+    }
 
+    auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(stream->mInterval));
+
+    // If the previous frame is still being encoded or has not been sent yet, the client falls
+    // behind. The frame is skipped and the quality is reduced; first the JPEG quality, then the
+    // resolution.
+    if (stream->mCapturePending || !stream->isFrameConsumed()) {
+      if (!stream->mRaw && stream->mQuality > MIN_STREAM_QUALITY) {
+        stream->mQuality = std::max(MIN_STREAM_QUALITY, stream->mQuality - 10);
       } else {
-        if (mCaptureFormat == "raw") {
-          // larger output size, but performance is comparable or better because there is no image
-          // encoding
-          mCapture.resize(mCaptureWidth * mCaptureHeight * 3 * sizeof(float));
-          if (mAllSettings->mGraphics.pEnableHDR.get()) {
-            // using the hdr buffer
-            std::shared_ptr<cs::graphics::HDRBuffer> hdrBuffer = mGraphicsEngine->getHDRBuffer();
-            VistaTexture* luminance_buffer = hdrBuffer->getCurrentWriteAttachment();
-            luminance_buffer->Bind();
-            glGetTexImage(luminance_buffer->GetTarget(), 0, GL_RGB, GL_FLOAT,
-                static_cast<void*>(mCapture.data()));
-            luminance_buffer->Unbind();
-          } else {
-            // without HDR, output is float in [0, 1], but the values in the buffer were
-            // previously converted to uint [0, 255]. For high quality raw output, use HDR mode.
-            glReadPixels(0, 0, mCaptureWidth, mCaptureHeight, GL_RGB, GL_FLOAT,
-                static_cast<void*>(mCapture.data()));
-          }
-        } else {
-          // Capturing color images is pretty straight-forward.
-          std::vector<std::byte> capture(mCaptureWidth * mCaptureHeight * 3);
-          glReadPixels(0, 0, mCaptureWidth, mCaptureHeight, GL_RGB, GL_UNSIGNED_BYTE, &capture[0]);
-
-          if (mCaptureFormat == "tiff") {
-            tiffWriteToVector(mCapture, capture, mCaptureWidth, mCaptureHeight, 3, 8);
-          } else if (mCaptureFormat == "png") {
-            stbi_write_png_to_func(&stbWriteToVector, &mCapture, mCaptureWidth, mCaptureHeight, 3,
-                capture.data(), mCaptureWidth * 3);
-          } else {
-            stbi_write_jpg_to_func(
-                &stbWriteToVector, &mCapture, mCaptureWidth, mCaptureHeight, 3, capture.data(), 80);
-          }
-        }
+        stream->mScale = std::max(MIN_STREAM_SCALE, stream->mScale * 0.8);
       }
 
-      // Restore stb image state to default.
-      stbi_flip_vertically_on_write(0);
+      stream->mNextFrameTime = now + interval;
+      continue;
+    }
+
+    // The render loop must never wait for a read-back, so we try again in the next frame if all
+    // buffers are in use.
+    if (mFrameCapture->isBusy()) {
+      continue;
+    }
 
-      mCaptureAtFrame = 0;
+    int32_t width  = 0;
+    int32_t height = 0;
+    auto*   window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
+    window->GetWindowProperties()->GetSize(width, height);
 
-      // The capture has been done, notify the worker thread,
-      mCaptureDone.notify_one();
-      if (mRestoreState) {
-        // Restore interactive window UI and image resolution
-        if (mCaptureGui != "auto") {
-          mAllSettings->pEnableUserInterface = mRestoreGui;
-        }
+    int32_t maxWidth  = stream->mMaxWidth > 0 ? std::min(stream->mMaxWidth, width) : width;
+    int32_t maxHeight = stream->mMaxHeight > 0 ? std::min(stream->mMaxHeight, height) : height;
 
-        if (mRestoreW > 0 && mRestoreH > 0) {
-          auto* window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
-          window->GetWindowProperties()->SetSize(mRestoreW, mRestoreH);
-        }
-      }
+    FrameCapture::Options options;
+    options.mFormat    = stream->mRaw ? "rgb" : "jpeg";
+    options.mQuality   = stream->mQuality;
+    options.mMaxWidth  = std::max(1, static_cast<int32_t>(maxWidth * stream->mScale));
+    options.mMaxHeight = std::max(1, static_cast<int32_t>(maxHeight * stream->mScale));
+
+    stream->mCapturePending = true;
+
+    mFrameCapture->capture(width, height, mSolarSystem->getObserver().getScale(), options,
+        [stream](FrameCapture::Image&& image) {
+          stream->setFrame(std::move(image));
+          stream->mCapturePending = false;
+        });
+
+    // The quality recovers slowly as long as the client keeps up.
+    stream->mQuality = std::min(stream->mMaxQuality, stream->mQuality + 1);
+    stream->mScale   = std::min(1.0, stream->mScale * 1.02);
+
+    // If we are late by more than one interval, we do not try to catch up.
+    stream->mNextFrameTime = std::max(stream->mNextFrameTime + interval, now);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<std::string> Plugin::validateCaptureJob(CaptureJob const& job) {
+  auto const& format = job.mOptions.mFormat;
+
+  if (format != "png" && format != "jpeg" && format != "tiff" && format != "raw") {
+    return "Only 'png', 'jpeg', 'tiff' or 'raw' are allowed for the format parameter!";
+  }
+
+  if (job.mGui != "auto" && job.mGui != "true" && job.mGui != "false") {
+    return "Only 'auto', 'true', or 'false' are allowed for the gui parameter!";
+  }
+
+  if (job.mDelay < 1 || job.mDelay > 200 || job.mFrameDelay < 1 || job.mFrameDelay > 200) {
+    return "The delay parameters must be in the range [1, 200]!";
+  }
+
+  if (job.mWidth < 0 || job.mWidth > 4096 || job.mHeight < 0 || job.mHeight > 4096) {
+    return "The width and height parameters must be in the range [0, 4096]!";
+  }
+
+  if (job.mOptions.mQuality < 1 || job.mOptions.mQuality > 100) {
+    return "The quality parameter must be in the range [1, 100]!";
+  }
+
+  if (job.mFrames.empty()) {
+    return "At least one frame has to be captured!";
+  }
+
+  return std::nullopt;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::queueCaptureJob(std::shared_ptr<CaptureJob> const& job) {
+  std::lock_guard<std::mutex> lock(mCaptureMutex);
+
+  // The plugin is being unloaded, so the job will never be processed.
+  if (mCaptureJobsCancelled) {
+    job->cancel();
+    return;
+  }
+
+  mCaptureJobs.push(job);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::cancelCaptureJobs() {
+  std::lock_guard<std::mutex> lock(mCaptureMutex);
+  mCaptureJobsCancelled = true;
+
+  while (!mCaptureJobs.empty()) {
+    mCaptureJobs.front()->cancel();
+    mCaptureJobs.pop();
+  }
+
+  if (mActiveCaptureJob) {
+    mActiveCaptureJob->cancel();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::startCaptureJob() {
+  auto& job = *mActiveCaptureJob;
+
+  // First, we resize the window to the requested size. Then we wait mDelay frames until we
+  // actually read the pixels.
+  if (job.mWidth > 0 && job.mHeight > 0) {
+    auto* window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
+    window->GetWindowProperties()->GetSize(job.mRestoreW, job.mRestoreH);
+    window->GetWindowProperties()->SetSize(job.mWidth, job.mHeight);
+  }
+
+  if (job.mGui != "auto") {
+    job.mRestoreGui                    = mAllSettings->pEnableUserInterface.get();
+    mAllSettings->pEnableUserInterface = job.mGui == "true";
+  }
+
+  applyCaptureFrame(job.mFrames.front());
+  job.mCaptureAtFrame = GetVistaSystem()->GetFrameLoop()->GetFrameCount() + job.mDelay;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::updateCaptureJob() {
+  auto& job = *mActiveCaptureJob;
+
+  bool cancelled = job.isCancelled();
+  int  frame     = GetVistaSystem()->GetFrameLoop()->GetFrameCount();
+
+  if (!cancelled) {
+    if (job.mCaptureAtFrame != frame) {
+      return;
+    }
+
+    // Now we waited several frames. We start reading the pixels; they will be encoded on the
+    // ThreadPool and passed to the server's thread once the read-back has finished.
+    int32_t width  = 0;
+    int32_t height = 0;
+    auto*   window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
+    window->GetWindowProperties()->GetSize(width, height);
+
+    logger().debug("Capturing frame {} of {}: resolution = {}x{}, show gui = {}, depth = {}, "
+                   "format = {}",
+        job.mNextFrame + 1, job.mFrames.size(), width, height, job.mGui, job.mOptions.mDepth,
+        job.mOptions.mFormat);
+
+    mFrameCapture->capture(width, height, mSolarSystem->getObserver().getScale(), job.mOptions,
+        [activeJob = mActiveCaptureJob, index = job.mNextFrame](
+            FrameCapture::Image&& image) { activeJob->setImage(index, std::move(image)); });
+
+    // Move on to the next frame.
+    if (++job.mNextFrame < job.mFrames.size()) {
+      applyCaptureFrame(job.mFrames[job.mNextFrame]);
+      job.mCaptureAtFrame = frame + job.mFrameDelay;
+      return;
     }
   }
 
-  // In this plugin, we cannot call this directly when the onLoad signal of the settings is fired,
-  // since reloading can cause our server to be restarted. And as reloading can be triggered from a
-  // /load request, this could lead to a deadlock.
-  if (mReloadRequired) {
-    from_json(mAllSettings->mPlugins.at("csp-web-api"), mPluginSettings);
+  // All frames have been captured or the job has been cancelled.
+  if (job.mRestoreState) {
+    // Restore interactive window UI and image resolution
+    if (job.mGui != "auto") {
+      mAllSettings->pEnableUserInterface = job.mRestoreGui;
+    }
+
+    if (job.mRestoreW > 0 && job.mRestoreH > 0) {
+      auto* window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
+      window->GetWindowProperties()->SetSize(job.mRestoreW, job.mRestoreH);
+    }
+  }
+
+  mActiveCaptureJob.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::applyCaptureFrame(CaptureJob::Frame const& frame) {
+  if (frame.mTime) {
+    mTimeControl->setTime(cs::utils::convert::time::toSpice(frame.mTime.value()));
+  }
+
+  if (frame.mLocation) {
+    auto const& loc = frame.mLocation.value();
+
+    if (loc.mRotation.has_value() && loc.mPosition.has_value()) {
+      mSolarSystem->flyObserverTo(
+          loc.mCenter, loc.mFrame, loc.mPosition.value(), loc.mRotation.value(), 0.0);
+    } else if (loc.mPosition.has_value()) {
+      mSolarSystem->flyObserverTo(loc.mCenter, loc.mFrame, loc.mPosition.value(), 0.0);
+    } else {
+      mSolarSystem->flyObserverTo(loc.mCenter, loc.mFrame, 0.0);
+    }
   }
 }
 
@@ -552,8 +893,10 @@ void Plugin::startServer(uint16_t port) {
   quitServer();
 
   try {
-    // We start the server with one thread only, as we do not want to process requests in parallel.
-    std::vector<std::string> options{"listening_ports", std::to_string(port), "num_threads", "1"};
+    // Each stream occupies one thread for as long as the client is connected. The remaining
+    // threads handle all other requests.
+    std::vector<std::string> options{
+        "listening_ports", std::to_string(port), "num_threads", std::to_string(MAX_STREAMS + 2)};
     mServer = std::make_unique<CivetServer>(options);
 
     for (auto const& handler : mHandlers) {
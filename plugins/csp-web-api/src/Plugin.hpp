@@ -9,11 +9,16 @@
 #define CSP_WEB_API_PLUGIN_HPP
 
 #include "../../../src/cs-core/PluginBase.hpp"
+#include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-utils/DefaultProperty.hpp"
+#include "FrameCapture.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <deque>
+#include <memory>
 #include <optional>
 #include <queue>
 #include <unordered_map>
@@ -24,7 +29,9 @@ class CivetHandler;
 namespace csp::webapi {
 
 /// This plugin contains a web server which provides some HTTP endpoints which can be used to
-/// remote-control CosmoScout VR.
+/// remote-control CosmoScout VR. Captures requested via /capture or /capture-sequence are read
+/// back asynchronously by a FrameCapture, so that encoding the images does not stall the render
+/// loop.
 class Plugin : public cs::core::PluginBase {
  public:
   struct Settings {
@@ -44,8 +51,115 @@ class Plugin : public cs::core::PluginBase {
   void update() override;
 
  private:
+  /// A CaptureJob is created for each request on /capture or /capture-sequence. It is set up by the
+  /// server's thread, processed by the main thread in update() and the resulting images are
+  /// encoded on the ThreadPool.
+  struct CaptureJob {
+    /// Each frame can change the simulation time and the observer's location before it is
+    /// captured.
+    struct Frame {
+      std::optional<std::string>                            mTime;
+      std::optional<cs::core::Settings::Bookmark::Location> mLocation;
+    };
+
+    /// Blocks until the image with the given index has been encoded. Returns std::nullopt if the
+    /// job has been cancelled before.
+    std::optional<FrameCapture::Image> waitForImage(std::size_t index);
+
+    /// Stores the image with the given index and wakes up the server's thread.
+    void setImage(std::size_t index, FrameCapture::Image&& image);
+
+    /// Makes all current and future calls to waitForImage() return std::nullopt.
+    void cancel();
+    bool isCancelled();
+
+    // These are set by the server's thread before the job is queued.
+    int32_t               mWidth        = 0;
+    int32_t               mHeight       = 0;
+    int32_t               mDelay        = 50;
+    int32_t               mFrameDelay   = 50;
+    std::string           mGui          = "auto";
+    bool                  mRestoreState = false;
+    FrameCapture::Options mOptions;
+    std::vector<Frame>    mFrames;
+
+    // These are only accessed by the main thread.
+    std::size_t mNextFrame      = 0;
+    int32_t     mCaptureAtFrame = 0;
+    bool        mRestoreGui     = true;
+    int32_t     mRestoreW       = -1;
+    int32_t     mRestoreH       = -1;
+
+   private:
+    std::mutex                                      mMutex;
+    std::condition_variable                         mImageDone;
+    std::vector<std::optional<FrameCapture::Image>> mImages;
+    bool                                            mCancelled = false;
+  };
+
+  /// A Stream is created for each client connected to /stream. The main thread captures frames at
+  /// the requested rate and the server's thread sends them to the client. Only the most recent
+  /// frame is kept, so if the client falls behind, frames are dropped and the quality is reduced.
+  struct Stream {
+    /// Blocks until a new frame is available. Returns std::nullopt if the stream has been closed.
+    std::optional<FrameCapture::Image> waitForFrame();
+
+    /// Stores the given frame and wakes up the server's thread. A frame which has not been sent
+    /// yet is replaced.
+    void setFrame(FrameCapture::Image&& frame);
+
+    /// Makes all current and future calls to waitForFrame() return std::nullopt.
+    void close();
+    bool isClosed();
+
+    /// Returns true if the last frame has been taken by the server's thread or if there has not
+    /// been any frame yet.
+    bool isFrameConsumed();
+
+    // These are set by the server's thread before the stream is added.
+    bool    mRaw        = false;
+    double  mInterval   = 0.1;
+    int32_t mMaxWidth   = 0;
+    int32_t mMaxHeight  = 0;
+    int32_t mMaxQuality = 80;
+
+    // These are only accessed by the main thread.
+    std::chrono::steady_clock::time_point mNextFrameTime;
+    int32_t                               mQuality = 80;
+    double                                mScale   = 1.0;
+
+    // This is set by the main thread when a capture is started and reset by the worker thread once
+    // the frame has been encoded.
+    std::atomic<bool> mCapturePending{false};
+
+   private:
+    std::mutex                         mMutex;
+    std::condition_variable            mFrameDone;
+    std::optional<FrameCapture::Image> mFrame;
+    bool                               mClosed = false;
+  };
+
   void onSave();
 
+  /// This is called by update() on the main thread. It captures a new frame for each stream whose
+  /// interval has passed and adapts the quality of streams whose client falls behind.
+  void updateStreams();
+
+  /// Returns an error message if the parameters of the given job are invalid.
+  static std::optional<std::string> validateCaptureJob(CaptureJob const& job);
+
+  /// Adds the given job to the queue of capture jobs which is processed by the main thread.
+  void queueCaptureJob(std::shared_ptr<CaptureJob> const& job);
+
+  /// Cancels all queued capture jobs and the job which is currently processed. Jobs which are
+  /// queued afterwards are cancelled immediately.
+  void cancelCaptureJobs();
+
+  /// These are called by update() on the main thread.
+  void startCaptureJob();
+  void updateCaptureJob();
+  void applyCaptureFrame(CaptureJob::Frame const& frame);
+
   void startServer(uint16_t port);
   void quitServer();
 
@@ -53,22 +167,17 @@ class Plugin : public cs::core::PluginBase {
   std::unique_ptr<CivetServer>                                   mServer;
   std::unordered_map<std::string, std::unique_ptr<CivetHandler>> mHandlers;
 
-  // Members for the /capture endpoint
-  std::mutex              mCaptureMutex;
-  std::condition_variable mCaptureDone;
-  bool                    mCaptureRequested = false;
-  int32_t                 mCaptureWidth     = 0;
-  int32_t                 mCaptureHeight    = 0;
-  int32_t                 mCaptureDelay     = 0;
-  std::string             mCaptureGui       = "auto";
-  bool                    mRestoreState     = false;
-  bool                    mRestoreGui       = true;
-  int32_t                 mRestoreW         = -1;
-  int32_t                 mRestoreH         = -1;
-  bool                    mCaptureDepth     = false;
-  std::string             mCaptureFormat;
-  int32_t                 mCaptureAtFrame = 0;
-  std::vector<std::byte>  mCapture;
+  // Members for the /capture and /capture-sequence endpoints
+  std::mutex                              mCaptureMutex;
+  std::queue<std::shared_ptr<CaptureJob>> mCaptureJobs;
+  bool                                    mCaptureJobsCancelled = false;
+  std::shared_ptr<CaptureJob>             mActiveCaptureJob;
+  std::unique_ptr<FrameCapture>           mFrameCapture;
+
+  // Members for the /stream endpoint
+  std::mutex                           mStreamMutex;
+  std::vector<std::shared_ptr<Stream>> mStreams;
+  bool                                 mStreamsClosed = false;
 
   // Members for the /log endpoint
   std::mutex              mLogMutex;
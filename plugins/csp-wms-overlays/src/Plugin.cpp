@@ -464,23 +464,22 @@ void Plugin::deInit() {
 
 void Plugin::update() {
   std::vector<std::string> finishedBodies;
-  for (auto const& creationThreads : mWmsCreationThreads) {
-    int running  = creationThreads.second.getRunningTaskCount();
-    int total    = static_cast<int>(mPluginSettings->mBodies.at(creationThreads.first).mWms.size());
-    int progress = total - running;
-    if (progress > mWmsCreationProgress.at(creationThreads.first)) {
-      logger().info(
-          "Loaded {} of {} WMS servers for {}...", progress, total, creationThreads.first);
-      mWmsCreationProgress.at(creationThreads.first) = progress;
+  for (auto const& creationTasks : mWmsCreationTasks) {
+    int pending  = static_cast<int>(creationTasks.second.getPendingTaskCount());
+    int total    = static_cast<int>(mPluginSettings->mBodies.at(creationTasks.first).mWms.size());
+    int progress = total - pending;
+    if (progress > mWmsCreationProgress.at(creationTasks.first)) {
+      logger().info("Loaded {} of {} WMS servers for {}...", progress, total, creationTasks.first);
+      mWmsCreationProgress.at(creationTasks.first) = progress;
     }
-    if (creationThreads.second.hasFinished()) {
-      initOverlay(creationThreads.first, mPluginSettings->mBodies.at(creationThreads.first));
-      finishedBodies.push_back(creationThreads.first);
-      logger().info("Finished loading WMS servers for {}.", creationThreads.first);
+    if (creationTasks.second.hasFinished()) {
+      initOverlay(creationTasks.first, mPluginSettings->mBodies.at(creationTasks.first));
+      finishedBodies.push_back(creationTasks.first);
+      logger().info("Finished loading WMS servers for {}.", creationTasks.first);
     }
   }
   for (auto const& body : finishedBodies) {
-    mWmsCreationThreads.erase(body);
+    mWmsCreationTasks.erase(body);
   }
 
   if (mPluginSettings->mEnableAutomaticBoundsUpdate.get() && mNoMovement &&
@@ -536,10 +535,10 @@ void Plugin::onLoad() {
 
     mWMSOverlays.emplace(settings.first, wmsOverlay);
 
-    mWmsCreationThreads.emplace(settings.first, settings.second.mWms.size());
+    mWmsCreationTasks.try_emplace(settings.first);
     mWmsCreationProgress.emplace(settings.first, 0);
     for (auto const& wmsUrl : settings.second.mWms) {
-      mWmsCreationThreads.at(settings.first).enqueue([this, settings, wmsUrl]() {
+      mWmsCreationTasks.at(settings.first).post([this, settings, wmsUrl]() {
         try {
           WebMapService                wms(wmsUrl, mPluginSettings->mUseCapabilityCache.get(),
                              mPluginSettings->mCapabilityCache.get());
@@ -119,10 +119,10 @@ class Plugin : public cs::core::PluginBase {
   /// appropriate range specified in the layer capabilities, a warning will be displayed.
   void checkScale(Bounds const& bounds, WebMapLayer const& layer, int maxTextureSize);
 
-  std::shared_ptr<Settings>                    mPluginSettings = std::make_shared<Settings>();
-  std::mutex                                   mWmsInsertMutex;
-  std::map<std::string, cs::utils::ThreadPool> mWmsCreationThreads;
-  std::map<std::string, int>                   mWmsCreationProgress;
+  std::shared_ptr<Settings>                   mPluginSettings = std::make_shared<Settings>();
+  std::mutex                                  mWmsInsertMutex;
+  std::map<std::string, cs::utils::TaskGroup> mWmsCreationTasks;
+  std::map<std::string, int>                  mWmsCreationProgress;
   std::map<std::string, std::shared_ptr<TextureOverlayRenderer>> mWMSOverlays;
   std::map<std::string, std::vector<WebMapService>>              mWms;
 
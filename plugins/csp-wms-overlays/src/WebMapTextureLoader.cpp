@@ -11,6 +11,7 @@
 
 #include "logger.hpp"
 
+#include "../../../src/cs-utils/HttpFetcher.hpp"
 #include "../../../src/cs-utils/convert.hpp"
 #include "../../../src/cs-utils/filesystem.hpp"
 #include "../../../src/cs-utils/utils.hpp"
@@ -18,8 +19,6 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/range/algorithm/replace_copy_if.hpp>
-#include <curlpp/Infos.hpp>
-#include <curlpp/Options.hpp>
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -32,17 +31,63 @@ namespace csp::wmsoverlays {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-WebMapTextureLoader::WebMapTextureLoader()
-    : mThreadPool(32) {
-}
+WebMapTextureLoader::WebMapTextureLoader() = default;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 std::future<std::optional<WebMapTexture>> WebMapTextureLoader::loadTextureAsync(
     WebMapService const& wms, WebMapLayer const& layer, Request const& request,
     std::string const& mapCache, bool saveToCache) {
-  return mThreadPool.enqueue(
-      [=]() { return loadTexture(wms, layer, request, mapCache, saveToCache); });
+
+  // Everything which depends on the service and the layer is gathered here, so that they do not
+  // have to be copied to the pool.
+  boost::filesystem::path cachePath = getCachePath(wms, layer, request, mapCache);
+  std::string             url       = getRequestUrl(wms, layer, request);
+  std::string             mimeType  = getMimeType(wms, layer);
+
+  auto promise = std::make_shared<std::promise<std::optional<WebMapTexture>>>();
+  auto result  = promise->get_future();
+
+  mLoadTasks.post([=]() {
+    try {
+      // The file is already there, we can return it.
+      if (saveToCache && boost::filesystem::exists(cachePath) &&
+          boost::filesystem::file_size(cachePath) > 0) {
+        promise->set_value(loadTextureFromFile(cachePath.string()));
+        return;
+      }
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+      return;
+    }
+
+    logger().debug("Performing WMS request '{}'.", url);
+
+    // The texture is downloaded by the HttpFetcher. No thread of the pool is blocked in the
+    // meantime; the response is stored and decoded on the pool once it has arrived.
+    cs::utils::HttpFetcher::get().fetch(
+        createRequest(url, mimeType), mLoadTasks.track([=](cs::utils::HttpResponse response) {
+          mLoadTasks.post([=, response = std::move(response)]() {
+            try {
+              auto data = getTextureData(url, mimeType, response);
+              if (!data) {
+                promise->set_value(std::nullopt);
+                return;
+              }
+
+              if (saveToCache) {
+                saveTextureToFile(cachePath, *data);
+              }
+
+              promise->set_value(loadTextureFromMemory(*data));
+            } catch (...) {
+              promise->set_exception(std::current_exception());
+            }
+          });
+        }));
+  });
+
+  return result;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -60,86 +105,108 @@ std::optional<WebMapTexture> WebMapTextureLoader::loadTexture(WebMapService cons
   }
 
   // The file is corrupt or not available, we have to request it
-  auto textureStream = requestTexture(wms, layer, request);
-  if (!textureStream.has_value()) {
+  std::string url      = getRequestUrl(wms, layer, request);
+  std::string mimeType = getMimeType(wms, layer);
+
+  logger().debug("Performing WMS request '{}'.", url);
+
+  auto response = cs::utils::HttpFetcher::get().fetch(createRequest(url, mimeType)).get();
+  auto data     = getTextureData(url, mimeType, response);
+  if (!data.has_value()) {
     return {};
   }
 
   if (saveToCache) {
-    saveTextureToFile(cachePath, textureStream.value());
+    saveTextureToFile(cachePath, data.value());
   }
 
-  std::optional<WebMapTexture> texture = loadTextureFromStream(textureStream.value());
+  std::optional<WebMapTexture> texture = loadTextureFromMemory(data.value());
   return texture;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::optional<std::stringstream> WebMapTextureLoader::requestTexture(
-    WebMapService const& wms, WebMapLayer const& layer, Request const& wmsrequest) {
+cs::utils::HttpRequest WebMapTextureLoader::createRequest(
+    std::string const& url, std::string const& mimeType) {
+  cs::utils::HttpRequest request;
+  request.mUrl        = url;
+  request.mVerifyPeer = false;
 
-  std::string url = getRequestUrl(wms, layer, wmsrequest);
+  // Some errors typically persist only for a short amount of time, so the request can be retried.
+  request.mMaxRetries = 2;
+  request.mRetryIf    = [mimeType](cs::utils::HttpResponse const& response) {
+    std::string error;
+    return checkResponse(response, mimeType, error) == ResponseStatus::eRetry;
+  };
 
-  logger().debug("Performing WMS request '{}'.", url);
+  return request;
+}
 
-  int maxRetries = 3;
-  for (int i = 0; i < maxRetries; i++) {
-    if (i > 0) {
-      logger().debug("Retrying...");
-    }
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    std::stringstream out(std::ios_base::out | std::ios_base::in | std::ios_base::binary);
+WebMapTextureLoader::ResponseStatus WebMapTextureLoader::checkResponse(
+    cs::utils::HttpResponse const& response, std::string const& mimeType, std::string& error) {
 
-    curlpp::Easy request;
-    request.setOpt(curlpp::options::Url(url));
-    request.setOpt(curlpp::options::WriteStream(&out));
-    request.setOpt(curlpp::options::NoSignal(true));
-    request.setOpt(curlpp::options::SslVerifyPeer(false));
+  if (!response.mError.empty()) {
+    error = response.mError;
+    return ResponseStatus::eRetry;
+  }
 
+  std::string contentType = response.mContentType;
+  // Remove suffix and parameter from content type
+  size_t suffixPos    = contentType.find('+');
+  size_t parameterPos = contentType.find(';');
+  if (suffixPos != std::string::npos) {
+    contentType = contentType.substr(0, suffixPos);
+  } else if (parameterPos != std::string::npos) {
+    contentType = contentType.substr(0, parameterPos);
+  }
+  if (contentType.empty()) {
+    // No content type was set in the response. This error typically persists only for a short
+    // amount of time, so the request can be retried.
+    error = "Could not determine response content type.";
+    return ResponseStatus::eRetry;
+  }
+  if (contentType == "text/xml") {
+    // A WMS exception might have occurred.
     try {
-      request.perform();
-    } catch (std::exception& e) {
-      logger().warn("Failed to perform WMS request '{}': '{}'!", url, e.what());
-      continue;
+      // If there was a valid WMS exception, the problem probably can't be fixed with a retry.
+      WebMapExceptionReport e(response.mBody);
+      error = e.what();
+      return ResponseStatus::eInvalid;
+    } catch (std::exception const& e) {
+      // If parsing the document fails, this might be due to connection problems
+      // or corrupted data.
+      // => Retry the request.
+      error = fmt::format("Could not create WebMapExceptionReport: '{}'.", e.what());
+      return ResponseStatus::eRetry;
     }
+  }
+  if (contentType != mimeType) {
+    error = fmt::format("Received response of invalid MIME type '{}'.", contentType);
+    return ResponseStatus::eRetry;
+  }
+  return ResponseStatus::eValid;
+}
 
-    std::string contentType = curlpp::Info<CURLINFO_CONTENT_TYPE, std::string>::get(request);
-    // Remove suffix and parameter from content type
-    size_t suffixPos    = contentType.find('+');
-    size_t parameterPos = contentType.find(';');
-    if (suffixPos != std::string::npos) {
-      contentType = contentType.substr(0, suffixPos);
-    } else if (parameterPos != std::string::npos) {
-      contentType = contentType.substr(0, parameterPos);
-    }
-    if (contentType == "NULL") {
-      // No content type was set in the response. This error typically persists only for a short
-      // amount of time, so the request can be retried.
-      logger().debug("Could not determine response content type.");
-      continue;
-    }
-    if (contentType == "text/xml") {
-      // A WMS exception might have occurred.
-      try {
-        // If there was a valid WMS exception, the problem probably can't be fixed with a retry.
-        // => Return an empty object to cancel the request.
-        WebMapExceptionReport e(out.str());
-        logger().warn("WMS Exception occurred for WMS request '{}': '{}'!", url, e.what());
-        return {};
-      } catch (std::exception const& e) {
-        // If parsing the document fails, this might be due to connection problems
-        // or corrupted data.
-        // => Retry the request.
-        logger().debug("Could not create WebMapExceptionReport: '{}'.", e.what());
-        continue;
-      }
-      continue;
-    } else if (contentType != getMimeType(wms, layer)) {
-      logger().debug("Received response of invalid MIME type '{}'.", contentType);
-      continue;
-    }
-    return std::move(out);
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<std::string> WebMapTextureLoader::getTextureData(
+    std::string const& url, std::string const& mimeType, cs::utils::HttpResponse const& response) {
+
+  std::string error;
+
+  switch (checkResponse(response, mimeType, error)) {
+  case ResponseStatus::eValid:
+    return response.mBody;
+  case ResponseStatus::eInvalid:
+    logger().warn("WMS Exception occurred for WMS request '{}': '{}'!", url, error);
+    return {};
+  case ResponseStatus::eRetry:
+    logger().debug("{}", error);
+    break;
   }
+
   logger().warn("Could not get a valid response for WMS request '{}'!", url);
   return {};
 }
@@ -147,7 +214,7 @@ std::optional<std::stringstream> WebMapTextureLoader::requestTexture(
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void WebMapTextureLoader::saveTextureToFile(
-    boost::filesystem::path const& file, std::stringstream const& data) {
+    boost::filesystem::path const& file, std::string const& data) {
   {
     std::unique_lock<std::mutex> lock(mTextureMutex);
 
@@ -176,7 +243,7 @@ void WebMapTextureLoader::saveTextureToFile(
       return;
     }
 
-    out << data.rdbuf();
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
   }
 
   boost::filesystem::perms filePerms =
@@ -206,14 +273,13 @@ std::optional<WebMapTexture> WebMapTextureLoader::loadTextureFromFile(std::strin
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::optional<WebMapTexture> WebMapTextureLoader::loadTextureFromStream(
-    std::stringstream const& stream) {
+std::optional<WebMapTexture> WebMapTextureLoader::loadTextureFromMemory(std::string const& data) {
   int width, height, bpp;
   int channels = 4;
 
   std::unique_ptr<unsigned char> pixels(
-      stbi_load_from_memory(reinterpret_cast<unsigned char*>(stream.str().data()),
-          static_cast<int>(stream.str().size()), &width, &height, &bpp, channels));
+      stbi_load_from_memory(reinterpret_cast<unsigned char const*>(data.data()),
+          static_cast<int>(data.size()), &width, &height, &bpp, channels));
 
   if (!pixels) {
     logger().warn("Failed to load texture from memory with stbi!");
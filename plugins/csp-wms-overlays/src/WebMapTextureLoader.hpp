@@ -11,6 +11,7 @@
 #include "WebMapLayer.hpp"
 #include "WebMapService.hpp"
 
+#include "../../../src/cs-utils/HttpFetcher.hpp"
 #include "../../../src/cs-utils/ThreadPool.hpp"
 
 #include <boost/filesystem.hpp>
@@ -38,10 +39,11 @@ class WebMapTextureLoader {
     std::optional<std::string> mTime;
   };
 
-  /// Creates a new ThreadPool with the specified amount of threads.
+  /// Textures are downloaded by the shared cs::utils::HttpFetcher and decoded on the shared
+  /// cs::utils::ThreadPool.
   WebMapTextureLoader();
 
-  /// Async WMS texture loader.
+  /// Async WMS texture loader. No thread is blocked while the texture is downloaded.
   /// Returns an empty optional if loading the texture failed.
   std::future<std::optional<WebMapTexture>> loadTextureAsync(WebMapService const& wms,
       WebMapLayer const& layer, Request const& request, std::string const& mapCache,
@@ -53,20 +55,31 @@ class WebMapTextureLoader {
       Request const& request, std::string const& mapCache, bool saveToCache);
 
  private:
-  /// Requests a map texture from a WMS.
-  /// Returns a binary stream of the texture file if the request succeeds.
-  /// Returns an empty optional if the request fails.
-  std::optional<std::stringstream> requestTexture(
-      WebMapService const& wms, WebMapLayer const& layer, Request const& request);
+  /// The outcome of a request to a WMS.
+  enum class ResponseStatus { eValid, eRetry, eInvalid };
+
+  /// Creates a request for a map texture of the given MIME type. The request is retried if the
+  /// response is not usable.
+  static cs::utils::HttpRequest createRequest(std::string const& url, std::string const& mimeType);
+
+  /// Checks whether the given response contains a map texture of the given MIME type. If not, the
+  /// reason is stored in error and eRetry is returned for problems which a retry might fix.
+  static ResponseStatus checkResponse(
+      cs::utils::HttpResponse const& response, std::string const& mimeType, std::string& error);
 
-  /// Saves a binary stream of a texture file to the given path.
-  void saveTextureToFile(boost::filesystem::path const& file, std::stringstream const& data);
+  /// Returns the texture file contained in the given response to a request to the given URL.
+  /// Returns an empty optional if the request failed.
+  static std::optional<std::string> getTextureData(
+      std::string const& url, std::string const& mimeType, cs::utils::HttpResponse const& response);
+
+  /// Saves a texture file to the given path.
+  void saveTextureToFile(boost::filesystem::path const& file, std::string const& data);
 
   /// Loads WMS texture from a file using stbi.
   static std::optional<WebMapTexture> loadTextureFromFile(std::string const& fileName);
 
-  /// Loads WMS texture from a stream using stbi.
-  static std::optional<WebMapTexture> loadTextureFromStream(std::stringstream const& stream);
+  /// Loads WMS texture from a texture file in memory using stbi.
+  static std::optional<WebMapTexture> loadTextureFromMemory(std::string const& data);
 
   /// Constructs a path for loading/saving the texture requested with the given parameters.
   boost::filesystem::path getCachePath(WebMapService const& wms, WebMapLayer const& layer,
@@ -82,8 +95,12 @@ class WebMapTextureLoader {
   const std::map<std::string, std::string> mMimeToExtension = {
       {"image/png", "png"}, {"image/jpeg", "jpg"}};
 
-  std::mutex            mTextureMutex;
-  cs::utils::ThreadPool mThreadPool;
+  std::mutex mTextureMutex;
+
+  // The callbacks of pending downloads are tracked by this group as well. This has to be the last
+  // member, so that pending tasks and downloads are finished before any of the members above are
+  // destroyed.
+  cs::utils::TaskGroup mLoadTasks;
 };
 
 } // namespace csp::wmsoverlays
@@ -504,7 +504,7 @@ void Application::FrameUpdate() {
     {
       cs::utils::FrameStats::ScopedTimer timer("Update Plugins");
       for (auto const& plugin : mPlugins) {
-        cs::utils::FrameStats::ScopedTimer timer("Update " + plugin.first);
+        cs::utils::FrameStats::ScopedTimer timer(plugin.second.mTimerName);
 
         try {
           plugin.second.mPlugin->update();
@@ -613,7 +613,8 @@ void Application::FrameUpdate() {
           angle = -angle;
         }
 
-        mGuiManager->getGui()->callJavascript("CosmoScout.timeline.setNorthDirection", angle);
+        mGuiManager->getGui()->callJavascriptCoalesced(
+            "CosmoScout.timeline.setNorthDirection", angle);
 
       } catch (std::exception const& e) {
         // Getting the relative transformation may fail due to insufficient SPICE data.
@@ -734,7 +735,9 @@ void Application::openPlugin(std::string const& name) {
         logger().info("Opening plugin '{}'.", name);
 
         // Actually call the plugin's constructor and add the returned pointer to out list.
-        mPlugins.insert(std::pair<std::string, Plugin>(name, {pluginHandle, pluginConstructor()}));
+        Plugin plugin{pluginHandle, pluginConstructor()};
+        plugin.mTimerName = cs::utils::FrameStats::get().registerName("Update " + name);
+        mPlugins.insert(std::pair<std::string, Plugin>(name, plugin));
       } else {
         logger().warn("Failed to load plugin '{}': {}", name, LIBERROR());
       }
@@ -1253,12 +1256,14 @@ void Application::registerGuiCallbacks() {
 
   // Update the side bar field showing the average luminance of the scene.
   mGraphicsEngine->pAverageLuminance.connect([this](float value) {
-    mGuiManager->getGui()->callJavascript("CosmoScout.sidebar.setAverageSceneLuminance", value);
+    mGuiManager->getGui()->callJavascriptCoalesced(
+        "CosmoScout.sidebar.setAverageSceneLuminance", value);
   });
 
   // Update the side bar field showing the maximum luminance of the scene.
   mGraphicsEngine->pMaximumLuminance.connect([this](float value) {
-    mGuiManager->getGui()->callJavascript("CosmoScout.sidebar.setMaximumSceneLuminance", value);
+    mGuiManager->getGui()->callJavascriptCoalesced(
+        "CosmoScout.sidebar.setMaximumSceneLuminance", value);
   });
 
   // Adjusts the amount of ambient lighting.
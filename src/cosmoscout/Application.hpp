@@ -8,6 +8,8 @@
 #ifndef CS_APPLICATION_HPP
 #define CS_APPLICATION_HPP
 
+#include "../cs-utils/FrameStats.hpp"
+
 #include <VistaKernel/VistaFrameLoop.h>
 #include <limits>
 #include <map>
@@ -105,6 +107,9 @@ class Application : public VistaFrameLoop {
     COSMOSCOUT_LIBTYPE    mHandle;
     cs::core::PluginBase* mPlugin        = nullptr;
     bool                  mIsInitialized = false;
+
+    // The name of the timer which measures the plugin's update() method.
+    cs::utils::FrameStats::NameID mTimerName = 0;
   };
 
   /// Called whenever the settings are (re-)loaded;
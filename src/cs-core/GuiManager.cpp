@@ -392,13 +392,14 @@ void GuiManager::enableLoadingScreen(bool enable) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void GuiManager::setLoadingScreenStatus(std::string const& sStatus) const {
-  mCosmoScoutGui->callJavascript("CosmoScout.loadingScreen.setStatus", sStatus);
+  mCosmoScoutGui->callJavascriptCoalesced("CosmoScout.loadingScreen.setStatus", sStatus);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void GuiManager::setLoadingScreenProgress(float percent, bool animate) const {
-  mCosmoScoutGui->callJavascript("CosmoScout.loadingScreen.setProgress", percent, animate);
+  mCosmoScoutGui->callJavascriptCoalesced(
+      "CosmoScout.loadingScreen.setProgress", percent, animate);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
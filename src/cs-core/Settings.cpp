@@ -402,6 +402,9 @@ void from_json(nlohmann::json const& j, Settings& o) {
   Settings::deserialize(j, "resetDate", o.mResetDate);
   Settings::deserialize(j, "observer", o.mObserver);
   Settings::deserialize(j, "spiceKernel", o.pSpiceKernel);
+  Settings::deserialize(j, "enableEphemerisCache", o.pEnableEphemerisCache);
+  Settings::deserialize(j, "ephemerisPositionTolerance", o.pEphemerisPositionTolerance);
+  Settings::deserialize(j, "ephemerisRotationTolerance", o.pEphemerisRotationTolerance);
   Settings::deserialize(j, "sceneScale", o.mSceneScale);
   Settings::deserialize(j, "guiPosition", o.mGuiPosition);
   Settings::deserialize(j, "graphics", o.mGraphics);
@@ -427,6 +430,9 @@ void to_json(nlohmann::json& j, Settings const& o) {
   Settings::serialize(j, "resetDate", o.mResetDate);
   Settings::serialize(j, "observer", o.mObserver);
   Settings::serialize(j, "spiceKernel", o.pSpiceKernel);
+  Settings::serialize(j, "enableEphemerisCache", o.pEnableEphemerisCache);
+  Settings::serialize(j, "ephemerisPositionTolerance", o.pEphemerisPositionTolerance);
+  Settings::serialize(j, "ephemerisRotationTolerance", o.pEphemerisRotationTolerance);
   Settings::serialize(j, "sceneScale", o.mSceneScale);
   Settings::serialize(j, "guiPosition", o.mGuiPosition);
   Settings::serialize(j, "graphics", o.mGraphics);
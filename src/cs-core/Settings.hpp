@@ -296,6 +296,14 @@ class CS_CORE_EXPORT Settings {
   /// The file name of the meta kernel for SPICE.
   utils::Property<std::string> pSpiceKernel;
 
+  /// If enabled, the positions and rotations of all SPICE frames are interpolated from polynomials
+  /// which are fitted to the SPICE data on demand. This is much faster than querying SPICE each
+  /// frame and allows updating the celestial objects in parallel. The tolerances specify the
+  /// maximum deviation from the SPICE data in meters and radians respectively.
+  utils::DefaultProperty<bool>   pEnableEphemerisCache{true};
+  utils::DefaultProperty<double> pEphemerisPositionTolerance{0.001};
+  utils::DefaultProperty<double> pEphemerisRotationTolerance{1e-9};
+
   /// If set to false, the user interface is completely hidden.
   utils::DefaultProperty<bool> pEnableUserInterface{true};
 
@@ -11,8 +11,12 @@
 
 #include "../cs-graphics/EclipseShadowMap.hpp"
 #include "../cs-scene/CelestialSurface.hpp"
+#include "../cs-scene/EphemerisCache.hpp"
+#include "../cs-scene/TrajectorySampler.hpp"
 #include "../cs-utils/FrameStats.hpp"
+#include "../cs-utils/ThreadPool.hpp"
 #include "../cs-utils/convert.hpp"
+#include "../cs-utils/spice.hpp"
 #include "../cs-utils/utils.hpp"
 #include "GraphicsEngine.hpp"
 #include "Settings.hpp"
@@ -25,9 +29,12 @@
 #include <VistaKernel/DisplayManager/VistaProjection.h>
 #include <VistaKernel/GraphicsManager/VistaTransformNode.h>
 #include <VistaKernel/VistaSystem.h>
+#include <algorithm>
+#include <cmath>
 #include <cspice/SpiceUsr.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <thread>
 
 namespace cs::core {
 
@@ -51,8 +58,20 @@ SolarSystem::SolarSystem(std::shared_ptr<Settings> settings,
     if (name == "Sun") {
       mSun.reset();
     }
+
+    // Forget the cached timer name of the object, see getUpdateTimerName().
+    mUpdateTimerNames.erase(name);
   });
 
+  mSettings->pEnableEphemerisCache.connectAndTouch(
+      [](bool enable) { scene::EphemerisCache::get().setEnabled(enable); });
+
+  mSettings->pEphemerisPositionTolerance.connectAndTouch(
+      [](double tolerance) { scene::EphemerisCache::get().setPositionTolerance(tolerance); });
+
+  mSettings->pEphemerisRotationTolerance.connectAndTouch(
+      [](double tolerance) { scene::EphemerisCache::get().setRotationTolerance(tolerance); });
+
   // Tell the user what's going on.
   logger().debug("Creating SolarSystem.");
 }
@@ -244,12 +263,18 @@ void SolarSystem::update() {
       utils::convert::time::toSpice(boost::posix_time::microsec_clock::universal_time()));
   mObserver.updateMovementAnimation(realTime);
 
-  // First, update all celestial object positions.
-  for (auto const& [name, object] : mSettings->mObjects) {
+  // First, update all celestial object positions. If their positions are taken from the
+  // EphemerisCache, this can be done in parallel.
+  if (scene::EphemerisCache::get().getEnabled()) {
     utils::FrameStats::ScopedTimer timer(
-        "Update " + object->getCenterName() + " / " + object->getFrameName(),
-        utils::FrameStats::TimerMode::eCPU);
-    object->update(simulationTime, mObserver);
+        "Update Celestial Objects", utils::FrameStats::TimerMode::eCPU);
+    updateObjectsInParallel(simulationTime);
+  } else {
+    for (auto const& [name, object] : mSettings->mObjects) {
+      utils::FrameStats::ScopedTimer timer(
+          getUpdateTimerName(name, *object), utils::FrameStats::TimerMode::eCPU);
+      object->update(simulationTime, mObserver);
+    }
   }
 
   // Update sun position. If a fixed Sun direction is enabled, we must calculate an artificial
@@ -562,6 +587,8 @@ void SolarSystem::flyObserverTo(
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void SolarSystem::printFrames() {
+  std::unique_lock<std::mutex> lock(utils::spice::getMutex());
+
   SPICEINT_CELL(ids, 1000); // NOLINT: Creates a c-array.
   bltfrm_c(SPICE_FRMTYP_ALL, &ids);
 
@@ -598,22 +625,37 @@ void SolarSystem::printFrames() {
 
 void SolarSystem::init(std::string const& sSpiceMetaFile) {
 
-  std::string actionReturn = "RETURN";
-  // Continue execution on errors.
-  erract_c("SET", 0, actionReturn.data());
+  int32_t const maxSpiceErrorLength = 320;
+
+  std::array<SpiceChar, maxSpiceErrorLength> msg{};
+  bool                                       failed = false;
+
+  {
+    std::unique_lock<std::mutex> lock(utils::spice::getMutex());
+
+    std::string actionReturn = "RETURN";
+    // Continue execution on errors.
+    erract_c("SET", 0, actionReturn.data());
 
-  std::string actionNull = "NULL";
-  // Disable default error reports.
-  errdev_c("SET", 0, actionNull.data());
+    std::string actionNull = "NULL";
+    // Disable default error reports.
+    errdev_c("SET", 0, actionNull.data());
 
-  // Load the spice kernels.
-  furnsh_c(sSpiceMetaFile.c_str());
+    // Load the spice kernels.
+    furnsh_c(sSpiceMetaFile.c_str());
 
-  if (failed_c()) {
-    int32_t const maxSpiceErrorLength = 320;
+    if (failed_c()) {
+      getmsg_c("LONG", maxSpiceErrorLength, msg.data());
+      failed = true;
+    }
+  }
+
+  // Data fitted to previously loaded kernels must not be used anymore. This locks the SPICE mutex
+  // as well, so it has to be done after the block above.
+  scene::EphemerisCache::get().clear();
+  scene::TrajectorySampler::get().clear();
 
-    std::array<SpiceChar, maxSpiceErrorLength> msg{};
-    getmsg_c("LONG", maxSpiceErrorLength, msg.data());
+  if (failed) {
     throw std::runtime_error(msg.data());
   }
 
@@ -622,6 +664,67 @@ void SolarSystem::init(std::string const& sSpiceMetaFile) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void SolarSystem::updateObjectsInParallel(double simulationTime) {
+  std::vector<scene::CelestialObject const*> objects;
+  std::vector<utils::FrameStats::NameID>     timerNames;
+  objects.reserve(mSettings->mObjects.size());
+  timerNames.reserve(mSettings->mObjects.size());
+
+  for (auto const& [name, object] : mSettings->mObjects) {
+    // The existence is parsed lazily using SPICE. This has to happen on this thread.
+    object->getExistence();
+    objects.push_back(object.get());
+    timerNames.push_back(getUpdateTimerName(name, *object));
+  }
+
+  // The objects are split into one chunk per hardware thread. The first chunk is processed by this
+  // thread, so that it does not idle while waiting for the others.
+  std::size_t chunkCount = std::max(1U, std::thread::hardware_concurrency());
+  std::size_t chunkSize  = (objects.size() + chunkCount - 1) / chunkCount;
+
+  auto updateChunk = [this, &objects, &timerNames, simulationTime, chunkSize](std::size_t chunk) {
+    auto end = std::min(objects.size(), (chunk + 1) * chunkSize);
+    for (auto i = chunk * chunkSize; i < end; ++i) {
+      utils::FrameStats::ScopedTimer timer(timerNames[i], utils::FrameStats::TimerMode::eCPU);
+      objects[i]->update(simulationTime, mObserver);
+    }
+  };
+
+  utils::TaskGroup tasks;
+
+  for (std::size_t chunk = 1; chunk < chunkCount && chunk * chunkSize < objects.size(); ++chunk) {
+    tasks.post([&updateChunk, chunk]() { updateChunk(chunk); }, utils::TaskPriority::eHigh);
+  }
+
+  updateChunk(0);
+  tasks.wait();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+utils::FrameStats::NameID SolarSystem::getUpdateTimerName(
+    std::string const& name, scene::CelestialObject const& object) {
+
+  if (!utils::FrameStats::get().getMeasurementsEnabled()) {
+    return 0;
+  }
+
+  auto& timerName = mUpdateTimerNames[name];
+
+  // The center and the frame of an object may change at runtime.
+  if (timerName.mCenter != object.getCenterName() || timerName.mFrame != object.getFrameName() ||
+      timerName.mCenter.empty()) {
+    timerName.mCenter = object.getCenterName();
+    timerName.mFrame  = object.getFrameName();
+    timerName.mName   = utils::FrameStats::get().registerName(
+        "Update " + timerName.mCenter + " / " + timerName.mFrame);
+  }
+
+  return timerName.mName;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool SolarSystem::getIsInitialized() const {
   return mIsInitialized;
 }
@@ -629,7 +732,13 @@ bool SolarSystem::getIsInitialized() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void SolarSystem::deinit() {
-  kclear_c();
+  {
+    std::unique_lock<std::mutex> lock(utils::spice::getMutex());
+    kclear_c();
+  }
+
+  scene::EphemerisCache::get().clear();
+  scene::TrajectorySampler::get().clear();
   mIsInitialized = false;
 }
 
@@ -686,20 +795,25 @@ glm::dquat SolarSystem::getRotationToObserver(
 std::vector<glm::dvec4> SolarSystem::calculateTrajectory(std::string const& sCenterName,
     std::string const& sFrameName, std::string const& sTargetName, double dStartTime,
     double dEndTime, int iSamples) {
-  std::vector<glm::dvec4> vPoints;
+  if (iSamples <= 0) {
+    return {};
+  }
 
-  double dLength(dEndTime - dStartTime);
+  scene::TrajectorySampler::Request request{scene::CelestialAnchor(sCenterName, sFrameName),
+      scene::CelestialAnchor(sTargetName, sFrameName)};
+  request.mOffset = dStartTime;
+  request.mStep   = (dEndTime - dStartTime) / iSamples;
+  request.mCount  = static_cast<std::size_t>(iSamples);
 
-  scene::CelestialAnchor obs(sCenterName, sFrameName);
-  scene::CelestialAnchor body(sTargetName, sFrameName);
+  // The samples are aligned to the start time, so they are unlikely to be requested again.
+  request.mUseCache = false;
 
-  for (int i(0); i < iSamples; ++i) {
-    double dTime = dLength / iSamples * i;
-    try {
-      glm::dvec3 pos = obs.getRelativePosition(dTime + dStartTime, body);
-      vPoints.emplace_back(glm::dvec4(pos.x, pos.y, pos.z, dTime + dStartTime));
-    } catch (...) {}
-  }
+  auto vPoints = scene::TrajectorySampler::get().sampleNow(request);
+
+  // Remove the samples for which SPICE had no data.
+  vPoints.erase(std::remove_if(vPoints.begin(), vPoints.end(),
+                    [](glm::dvec4 const& point) { return std::isnan(point.w); }),
+      vPoints.end());
 
   return vPoints;
 }
@@ -12,10 +12,13 @@
 
 #include "../cs-scene/CelestialObject.hpp"
 #include "../cs-scene/CelestialObserver.hpp"
+#include "../cs-utils/FrameStats.hpp"
 #include "../cs-utils/Property.hpp"
 
 #include <chrono>
 #include <map>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace cs::graphics {
@@ -204,11 +207,25 @@ class CS_CORE_EXPORT SolarSystem {
   ///
   /// @return A vector of points, where the x, y and z values represent the position and the w
   ///         value represents the time of that point, when the body was at that location.
+  ///         Samples for which no SPICE data is available are omitted.
+  ///
+  /// The samples are computed on the calling thread by the scene::TrajectorySampler. They are not
+  /// stored in its cache directory.
   static std::vector<glm::dvec4> calculateTrajectory(std::string const& sCenterName,
       std::string const& sFrameName, std::string const& sTargetName, double dStartTime,
       double dEndTime, int iSamples);
 
  private:
+  /// Calls CelestialObject::update() for all objects using the ThreadPool. This requires the
+  /// EphemerisCache to be enabled, as SPICE itself cannot be used from multiple threads.
+  void updateObjectsInParallel(double simulationTime);
+
+  /// Returns the ID of the timer name "Update <center> / <frame>" for the object with the given
+  /// name. The IDs are cached, so that the timer name does not have to be built each frame. This
+  /// returns zero if measurements are disabled.
+  utils::FrameStats::NameID getUpdateTimerName(
+      std::string const& name, scene::CelestialObject const& object);
+
   std::shared_ptr<Settings>                     mSettings;
   std::shared_ptr<GraphicsEngine>               mGraphicsEngine;
   std::shared_ptr<TimeControl>                  mTimeControl;
@@ -221,6 +238,15 @@ class CS_CORE_EXPORT SolarSystem {
   // These are used for measuring the observer speed.
   glm::dvec3                                     mLastPosition = glm::dvec3(0.0);
   std::chrono::high_resolution_clock::time_point mLastTime;
+
+  // The cached timer names of the objects, see getUpdateTimerName().
+  struct UpdateTimerName {
+    std::string               mCenter;
+    std::string               mFrame;
+    utils::FrameStats::NameID mName{};
+  };
+
+  std::unordered_map<std::string, UpdateTimerName> mUpdateTimerNames;
 };
 
 } // namespace cs::core
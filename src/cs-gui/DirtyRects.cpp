@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "DirtyRects.hpp"
+
+#include <algorithm>
+
+namespace cs::gui {
+
+namespace {
+
+// Two dirty regions are merged if the area of their bounding box is at most this much larger than
+// the sum of their areas. This keeps the number of glTexSubImage2D() calls low without uploading
+// too many unchanged pixels.
+const double MAX_MERGE_OVERHEAD = 1.25;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const std::size_t DirtyRects::MAX_RECTS         = 32;
+const std::size_t DirtyRects::MAX_PENDING_RECTS = 128;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DirtyRects::add(Rect const& rect) {
+  if (mIsFullyDirty) {
+    return;
+  }
+
+  if (mRects.size() < MAX_PENDING_RECTS) {
+    mRects.push_back(rect);
+  } else {
+    invalidate();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DirtyRects::invalidate() {
+  mRects.clear();
+  mIsFullyDirty = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DirtyRects::empty() const {
+  return mRects.empty() && !mIsFullyDirty;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<DirtyRects::Rect> DirtyRects::take(int width, int height) {
+  if (mIsFullyDirty) {
+    mRects        = {{0, 0, width, height}};
+    mIsFullyDirty = false;
+  }
+
+  auto rects = merge(std::move(mRects), width, height);
+  mRects.clear();
+
+  return rects;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<DirtyRects::Rect> DirtyRects::merge(std::vector<Rect> rects, int width, int height) {
+
+  // Clamp all regions to the texture and remove empty ones.
+  for (auto& rect : rects) {
+    int x0 = std::clamp(rect.mX, 0, width);
+    int y0 = std::clamp(rect.mY, 0, height);
+    int x1 = std::clamp(rect.mX + rect.mWidth, 0, width);
+    int y1 = std::clamp(rect.mY + rect.mHeight, 0, height);
+
+    rect = {x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0)};
+  }
+
+  rects.erase(std::remove_if(rects.begin(), rects.end(),
+                  [](Rect const& r) { return r.mWidth == 0 || r.mHeight == 0; }),
+      rects.end());
+
+  auto getArea = [](Rect const& r) {
+    return static_cast<double>(r.mWidth) * static_cast<double>(r.mHeight);
+  };
+
+  auto getUnion = [](Rect const& a, Rect const& b) {
+    int x0 = std::min(a.mX, b.mX);
+    int y0 = std::min(a.mY, b.mY);
+    int x1 = std::max(a.mX + a.mWidth, b.mX + b.mWidth);
+    int y1 = std::max(a.mY + a.mHeight, b.mY + b.mHeight);
+    return Rect{x0, y0, x1 - x0, y1 - y0};
+  };
+
+  auto getOverlap = [](Rect const& a, Rect const& b) {
+    return a.mX < b.mX + b.mWidth && b.mX < a.mX + a.mWidth && a.mY < b.mY + b.mHeight &&
+           b.mY < a.mY + a.mHeight;
+  };
+
+  if (rects.size() > MAX_RECTS) {
+    Rect bounds = rects.front();
+    for (auto const& rect : rects) {
+      bounds = getUnion(bounds, rect);
+    }
+    return {bounds};
+  }
+
+  // Merge pairs of regions until no pair is left which overlaps or which is cheaper to upload as
+  // one region.
+  bool merged = true;
+  while (merged) {
+    merged = false;
+
+    for (std::size_t i = 0; i < rects.size() && !merged; ++i) {
+      for (std::size_t j = i + 1; j < rects.size() && !merged; ++j) {
+        Rect both = getUnion(rects[i], rects[j]);
+
+        if (getOverlap(rects[i], rects[j]) ||
+            getArea(both) <= MAX_MERGE_OVERHEAD * (getArea(rects[i]) + getArea(rects[j]))) {
+          rects[i] = both;
+          rects.erase(rects.begin() + static_cast<std::ptrdiff_t>(j));
+          merged = true;
+        }
+      }
+    }
+  }
+
+  return rects;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::gui
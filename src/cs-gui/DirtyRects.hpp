@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_GUI_DIRTY_RECTS_HPP
+#define CS_GUI_DIRTY_RECTS_HPP
+
+#include "cs_gui_export.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace cs::gui {
+
+/// Collects the regions of a GuiItem's texture which have been redrawn by the browser, so that
+/// only these have to be uploaded. This does not depend on CEF or OpenGL, so the merging of the
+/// regions can be tested without a browser.
+class CS_GUI_EXPORT DirtyRects {
+ public:
+  /// A region of the texture in pixels.
+  struct Rect {
+    int mX;
+    int mY;
+    int mWidth;
+    int mHeight;
+  };
+
+  /// If more regions than this are passed to merge(), their bounding box is returned instead.
+  static const std::size_t MAX_RECTS;
+
+  /// Regions are only collected until take() is called, which does not happen for hidden items.
+  /// If more regions than this accumulate, they are dropped and the entire texture is marked as
+  /// dirty instead.
+  static const std::size_t MAX_PENDING_RECTS;
+
+  /// Adds a redrawn region.
+  void add(Rect const& rect);
+
+  /// Drops all regions and marks the entire texture as dirty. This is used after a resize.
+  void invalidate();
+
+  /// Returns true if nothing has been redrawn since the last call to take().
+  bool empty() const;
+
+  /// Returns the merged regions which have been redrawn since the last call and clears them. If
+  /// the entire texture is dirty, this returns a single region of the given size.
+  std::vector<Rect> take(int width, int height);
+
+  /// Clamps the given regions to a texture of the given size and merges them so that the result
+  /// does not contain overlapping regions. Regions are also merged if their bounding box is not
+  /// much larger than the regions themselves.
+  static std::vector<Rect> merge(std::vector<Rect> rects, int width, int height);
+
+ private:
+  std::vector<Rect> mRects;
+  bool              mIsFullyDirty = false;
+};
+
+} // namespace cs::gui
+
+#endif // CS_GUI_DIRTY_RECTS_HPP
@@ -9,7 +9,10 @@
 
 #include "GuiArea.hpp"
 
+#include "../cs-utils/FrameStats.hpp"
+
 #include <VistaOGLExt/VistaTexture.h>
+#include <cstring>
 
 namespace cs::gui {
 
@@ -39,13 +42,15 @@ GuiItem::GuiItem(std::string const& url, bool allowLocalFileAccess)
     , mIsRelOffsetY(true) {
 
   setDrawCallback([this](DrawEvent const& event) {
-    mPBOsNeedUpload = static_cast<uint8_t>(mTexturePBOs.size());
-
     if (event.mResized) {
       mTextureSizeX = event.mWidth;
       mTextureSizeY = event.mHeight;
 
       recreateBuffers();
+
+      mDirtyRects.invalidate();
+    } else {
+      mDirtyRects.add({event.mX, event.mY, event.mWidth, event.mHeight});
     }
 
     return mPixels.data();
@@ -228,25 +233,60 @@ void GuiItem::onAreaResize(int width, int height) {
 
 uint32_t GuiItem::getTexture() const {
 
-  // Copy the pixels buffer to the texture.
-  if (mPBOsNeedUpload > 0) {
+  // Copy the redrawn regions of the pixels buffer to the texture.
+  if (!mDirtyRects.empty()) {
+    auto rects = mDirtyRects.take(mTextureSizeX, mTextureSizeY);
+
+    std::size_t bytes = 0;
+    for (auto const& rect : rects) {
+      bytes += 4 * static_cast<std::size_t>(rect.mWidth) * static_cast<std::size_t>(rect.mHeight);
+    }
+
+    if (bytes == 0) {
+      return mTexture;
+    }
 
+    // The regions are written one after another to the PBO, each one with tightly packed rows.
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mTexturePBOs[mCurrentPBO]);
-    auto ptr = static_cast<uint8_t*>(glMapBufferRange(
-        GL_PIXEL_UNPACK_BUFFER, 0, 4 * mTextureSizeX * mTextureSizeY, GL_MAP_WRITE_BIT));
-    std::memcpy(ptr, mPixels.data(), 4 * mTextureSizeX * mTextureSizeY);
+    auto ptr = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+        static_cast<GLsizeiptr>(bytes), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+
+    std::size_t offset = 0;
+    for (auto const& rect : rects) {
+      std::size_t rowSize = 4 * static_cast<std::size_t>(rect.mWidth);
+      std::size_t start   = 4 * (static_cast<std::size_t>(rect.mY) * mTextureSizeX + rect.mX);
+
+      if (rect.mWidth == mTextureSizeX) {
+        std::memcpy(ptr + offset, mPixels.data() + start, rowSize * rect.mHeight);
+      } else {
+        for (int i = 0; i < rect.mHeight; ++i) {
+          std::memcpy(ptr + offset + i * rowSize,
+              mPixels.data() + start + 4 * static_cast<std::size_t>(i) * mTextureSizeX, rowSize);
+        }
+      }
+
+      offset += rowSize * rect.mHeight;
+    }
+
     glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
 
     glBindTexture(GL_TEXTURE_2D, mTexture);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER,
-        mTexturePBOs[(mCurrentPBO + mTexturePBOs.size() - 1) % mTexturePBOs.size()]);
-    glTexSubImage2D(
-        GL_TEXTURE_2D, 0, 0, 0, mTextureSizeX, mTextureSizeY, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+
+    offset = 0;
+    for (auto const& rect : rects) {
+      // NOLINTNEXTLINE: The offset into the PBO has to be passed as a pointer.
+      glTexSubImage2D(GL_TEXTURE_2D, 0, rect.mX, rect.mY, rect.mWidth, rect.mHeight, GL_BGRA,
+          GL_UNSIGNED_BYTE, reinterpret_cast<void*>(offset));
+      offset += 4 * static_cast<std::size_t>(rect.mWidth) * rect.mHeight;
+    }
+
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     glBindTexture(GL_TEXTURE_2D, 0);
 
+    // The next upload uses the other PBO, so that it does not have to wait for this one.
     mCurrentPBO = (mCurrentPBO + 1) % mTexturePBOs.size();
-    mPBOsNeedUpload -= 1;
+
+    utils::FrameStats::get().addValue("Uploaded GUI Bytes", static_cast<int64_t>(bytes));
   }
 
   return mTexture;
@@ -8,9 +8,11 @@
 #ifndef CS_GUI_VISTA_GUIITEM_HPP
 #define CS_GUI_VISTA_GUIITEM_HPP
 
+#include "DirtyRects.hpp"
 #include "WebView.hpp"
 
 #include <array>
+#include <vector>
 
 class VistaTexture;
 
@@ -18,6 +20,8 @@ namespace cs::gui {
 
 /// GuiItem is an implementation of WebView specifically designed to be rendered in an OpenGL
 /// context. It renders the HTML contents into an OpenGL texture for use in the rendering pipeline.
+/// Only the regions which have been redrawn by the browser are uploaded to the texture; the number
+/// of uploaded bytes is reported as "Uploaded GUI Bytes" to the cs::utils::FrameStats.
 class CS_GUI_EXPORT GuiItem : public WebView {
 
  public:
@@ -84,7 +88,8 @@ class CS_GUI_EXPORT GuiItem : public WebView {
   /// Gets called, when the parent GuiArea changes size.
   void onAreaResize(int width, int height);
 
-  /// @return The current HTML output as an OpenGL texture.
+  /// @return The current HTML output as an OpenGL texture. All regions which have been redrawn
+  ///         since the last call are uploaded before.
   uint32_t getTexture() const;
 
  private:
@@ -94,8 +99,11 @@ class CS_GUI_EXPORT GuiItem : public WebView {
   std::vector<uint8_t>    mPixels;
   uint32_t                mTexture = 0;
   std::array<uint32_t, 2> mTexturePBOs;
-  mutable uint8_t         mCurrentPBO     = 0;
-  mutable uint8_t         mPBOsNeedUpload = 0;
+  mutable uint8_t         mCurrentPBO = 0;
+
+  // The regions of mPixels which have been redrawn since the last upload. After a resize, the
+  // entire texture is uploaded instead.
+  mutable DirtyRects mDirtyRects;
 
   // in pixels
   int mTextureSizeX = 0;
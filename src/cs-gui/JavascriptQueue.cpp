@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "JavascriptQueue.hpp"
+
+namespace cs::gui {
+
+namespace {
+
+// Returns the given code as a JavaScript string literal.
+std::string toStringLiteral(std::string const& code) {
+  std::string literal;
+  literal.reserve(code.size() + 2);
+  literal += '"';
+
+  for (char c : code) {
+    switch (c) {
+    case '\\':
+      literal += "\\\\";
+      break;
+    case '"':
+      literal += "\\\"";
+      break;
+    case '\n':
+      literal += "\\n";
+      break;
+    case '\r':
+      literal += "\\r";
+      break;
+    default:
+      literal += c;
+    }
+  }
+
+  literal += '"';
+  return literal;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JavascriptQueue::push(std::string const& key, std::string command) {
+  if (!key.empty()) {
+    auto previous = mCoalesced.find(key);
+
+    if (previous != mCoalesced.end()) {
+      mCommands[previous->second].clear();
+      previous->second = mCommands.size();
+    } else {
+      mCoalesced.emplace(key, mCommands.size());
+    }
+  }
+
+  mCommands.push_back(std::move(command));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string JavascriptQueue::makeEval(std::string const& code) {
+  return "(0, eval)(" + toStringLiteral(code) + ")";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool JavascriptQueue::empty() const {
+  return mCommands.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string JavascriptQueue::flush() {
+  std::string script;
+
+  for (auto const& command : mCommands) {
+    if (!command.empty()) {
+      script += "try {\n" + command + ";\n} catch (e) {\n  console.error(e);\n}\n";
+    }
+  }
+
+  mCommands.clear();
+  mCoalesced.clear();
+
+  return script;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::gui
@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_GUI_JAVASCRIPT_QUEUE_HPP
+#define CS_GUI_JAVASCRIPT_QUEUE_HPP
+
+#include "cs_gui_export.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cs::gui {
+
+/// Collects the JavaScript commands which a WebView sends to its page during one frame, so that
+/// they can be executed with a single message. This does not depend on CEF, so the generated
+/// script can be tested without a browser.
+class CS_GUI_EXPORT JavascriptQueue {
+ public:
+  /// Appends a command, for instance a function call. If key is not empty, an earlier command
+  /// with the same key is removed from the queue.
+  void push(std::string const& key, std::string command);
+
+  /// Returns a command which evaluates the given code with an indirect eval. The code is executed
+  /// in the global scope, so var and function declarations are visible to later commands. Top-level
+  /// let, const and class declarations are only visible within the given code. A syntax error in
+  /// the code only affects this command.
+  static std::string makeEval(std::string const& code);
+
+  /// Returns true if no command has been pushed since the last call to flush().
+  bool empty() const;
+
+  /// Returns all queued commands as one script and clears the queue. The commands are executed in
+  /// the order in which they were pushed. Each one is wrapped in a try-catch block, so that an
+  /// exception thrown by one of them does not affect the others.
+  std::string flush();
+
+ private:
+  // Coalesced commands are removed by clearing their string; mCoalesced stores their index.
+  std::vector<std::string>                     mCommands;
+  std::unordered_map<std::string, std::size_t> mCoalesced;
+};
+
+} // namespace cs::gui
+
+#endif // CS_GUI_JAVASCRIPT_QUEUE_HPP
@@ -7,13 +7,25 @@
 
 #include "WebView.hpp"
 
+#include "../cs-utils/FrameStats.hpp"
 #include "internal/WebViewClient.hpp"
 
+#include <algorithm>
 #include <include/cef_app.h>
 #include <thread>
 
 namespace cs::gui {
 
+namespace {
+
+// All WebViews which have queued JavaScript commands since the last call to flushAllJavascript().
+std::vector<WebView const*>& getViewsWithQueuedJavascript() {
+  static std::vector<WebView const*> views;
+  return views;
+}
+
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class DevToolsClient : public CefClient {
@@ -50,6 +62,9 @@ WebView::WebView(const std::string& url, int width, int height, bool allowLocalF
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 WebView::~WebView() {
+  auto& views = getViewsWithQueuedJavascript();
+  views.erase(std::remove(views.begin(), views.end(), this), views.end());
+
   auto host = mBrowser->GetHost();
   while (!host->TryCloseBrowser()) {
     CefDoMessageLoopWork();
@@ -346,23 +361,47 @@ void WebView::injectKeyEvent(KeyEvent const& event) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void WebView::callJavascriptImpl(
-    std::string const& function, std::vector<std::string> const& args) const {
-  std::string call(function + "( ");
-  for (auto&& s : args) {
-    call += s + ",";
+void WebView::executeJavascript(std::string const& code) const {
+  // The code is passed to an indirect eval, so that syntax errors do not prevent the other
+  // commands of the frame from being executed.
+  queueJavascript("", JavascriptQueue::makeEval(code));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WebView::flushJavascript() const {
+  if (mQueuedJavascript.empty()) {
+    return;
   }
-  call.back() = ')';
+
+  std::string script = mQueuedJavascript.flush();
 
   CefRefPtr<CefFrame> frame = mBrowser->GetMainFrame();
-  frame->ExecuteJavaScript(call, frame->GetURL(), 0);
+  frame->ExecuteJavaScript(script, frame->GetURL(), 0);
+
+  utils::FrameStats::get().addValue("JavaScript IPC Messages", 1);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void WebView::executeJavascript(std::string const& code) const {
-  CefRefPtr<CefFrame> frame = mBrowser->GetMainFrame();
-  frame->ExecuteJavaScript(code, frame->GetURL(), 0);
+void WebView::flushAllJavascript() {
+  // Swap the list first, as it is modified if a view is destroyed or queues new commands.
+  std::vector<WebView const*> views;
+  std::swap(views, getViewsWithQueuedJavascript());
+
+  for (auto const* view : views) {
+    view->flushJavascript();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WebView::queueJavascript(std::string const& key, std::string&& code) const {
+  if (mQueuedJavascript.empty()) {
+    getViewsWithQueuedJavascript().push_back(this);
+  }
+
+  mQueuedJavascript.push(key, std::move(code));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
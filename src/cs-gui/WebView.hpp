@@ -9,6 +9,7 @@
 #define CS_GUI_WEBVIEW_HPP
 
 #include "../cs-utils/utils.hpp"
+#include "JavascriptQueue.hpp"
 #include "KeyEvent.hpp"
 #include "MouseEvent.hpp"
 #include "logger.hpp"
@@ -18,6 +19,7 @@
 #include <iostream>
 #include <optional>
 #include <typeindex>
+#include <vector>
 
 namespace cs::gui {
 
@@ -52,6 +54,10 @@ class CS_GUI_EXPORT WebView {
 
   /// Calls an existing Javascript function. You can pass as many arguments as you like. They will
   /// be converted to std::strings, so on the JavaScript side you will have to convert them back.
+  /// The call is not executed immediately: All calls and all code passed to executeJavascript()
+  /// during a frame are sent to the page as one script by flushJavascript(), which gui::update()
+  /// calls once a frame. They are executed in the order in which they were issued; an exception
+  /// thrown by one of them does not affect the others.
   ///
   /// @param function The name of the function.
   /// @param a        The arguments of the function. Each arguments type must be convertible to a
@@ -59,14 +65,35 @@ class CS_GUI_EXPORT WebView {
   ///                 implementing the operator<<() for that type.
   template <typename... Args>
   void callJavascript(std::string const& function, Args&&... a) const {
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
-    std::vector<std::string> args = {(utils::toString(a))...};
-    callJavascriptImpl(function, args);
+    queueJavascript("", makeJavascriptCall(function, std::forward<Args>(a)...));
+  }
+
+  /// Like callJavascript(), but if the same function has already been called with
+  /// callJavascriptCoalesced() during the current frame, the earlier call is dropped. Use this for
+  /// functions which only set some state, like a progress bar or the compass, and which may be
+  /// called more often than once a frame.
+  template <typename... Args>
+  void callJavascriptCoalesced(std::string const& function, Args&&... a) const {
+    queueJavascript(function, makeJavascriptCall(function, std::forward<Args>(a)...));
   }
 
-  /// Execute Javascript code.
+  /// Execute Javascript code. Like callJavascript(), the code is not executed immediately but
+  /// queued until the next call to gui::update() (or flushJavascript()). Hence, it cannot influence
+  /// anything which happens in the page before then. The code is evaluated in the global scope with
+  /// an indirect eval: var and function declarations are visible to later calls, but top-level
+  /// let, const and class declarations are only visible within the given code. They do not persist
+  /// across calls anymore; code which needs to share state has to use var or properties of window.
+  /// This also applies to code sent to the /run-js endpoint of csp-web-api.
   void executeJavascript(std::string const& code) const;
 
+  /// Sends all queued calls to the page with a single message. The number of messages is reported
+  /// as "JavaScript IPC Messages" to the cs::utils::FrameStats. There is usually no need to call
+  /// this, as gui::update() flushes all WebViews once a frame.
+  void flushJavascript() const;
+
+  /// Calls flushJavascript() on all WebViews which have queued calls.
+  static void flushAllJavascript();
+
   /// Register a callback which can be called from Javascript with the
   /// "window.callNative('callback_name', ... args ...)" function. Callbacks are also registered as
   /// CosmoScout.callbacks.callback_name(... args ...). For the latter to work, the WebView has to
@@ -250,7 +277,25 @@ class CS_GUI_EXPORT WebView {
         });
   }
 
-  void callJavascriptImpl(std::string const& function, std::vector<std::string> const& args) const;
+  /// Creates a string like "function(arg0,arg1,...)". The arguments are appended directly, without
+  /// collecting them in a temporary container first.
+  template <typename... Args>
+  static std::string makeJavascriptCall(std::string const& function, Args&&... a) {
+    std::string call(function);
+    call += '(';
+
+    [[maybe_unused]] char const* separator = "";
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
+    ((call += separator, call += utils::toString(a), separator = ","), ...);
+
+    call += ')';
+    return call;
+  }
+
+  /// Appends the given code to mQueuedJavascript and registers this WebView for the next call to
+  /// flushAllJavascript(). If key is not empty, an earlier command with the same key is removed.
+  void queueJavascript(std::string const& key, std::string&& code) const;
+
   void registerJSCallbackImpl(std::string const& name, std::string const& comment,
       std::vector<std::type_index>&&                                   types,
       std::function<void(std::vector<std::optional<JSType>>&&)> const& callback);
@@ -258,6 +303,9 @@ class CS_GUI_EXPORT WebView {
   detail::WebViewClient* mClient;
   CefRefPtr<CefBrowser>  mBrowser;
 
+  // Commands which are sent to the page with the next call to flushJavascript().
+  mutable JavascriptQueue mQueuedJavascript;
+
   bool mInteractive = true;
   bool mCanScroll   = true;
 
@@ -7,6 +7,7 @@
 
 #include "gui.hpp"
 
+#include "WebView.hpp"
 #include "internal/WebApp.hpp"
 #include "logger.hpp"
 
@@ -66,6 +67,7 @@ void cleanUp() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void update() {
+  WebView::flushAllJavascript();
   CefDoMessageLoopWork();
 }
 
@@ -25,7 +25,8 @@ CS_GUI_EXPORT void init();
 /// Shuts down CEF.
 CS_GUI_EXPORT void cleanUp();
 
-/// Triggers the CEF update function. This should be called once a frame.
+/// Sends the JavaScript calls queued during this frame to all WebViews and triggers the CEF update
+/// function. This should be called once a frame.
 CS_GUI_EXPORT void update();
 
 } // namespace cs::gui
@@ -80,65 +80,82 @@ void RenderHandler::GetViewRect(CefRefPtr<CefBrowser> /*browser*/, CefRect& rect
 
 void RenderHandler::OnPaint(CefRefPtr<CefBrowser> /*browser*/, PaintElementType /*type*/,
     RectList const& dirtyRects, const void* b, int width, int height) {
-  DrawEvent event{};
-  event.mResized  = width != mLastDrawWidth || height != mLastDrawHeight;
+  bool resized    = width != mLastDrawWidth || height != mLastDrawHeight;
   mLastDrawWidth  = width;
   mLastDrawHeight = height;
 
-  if (event.mResized) {
-    event.mX      = 0;
-    event.mY      = 0;
-    event.mWidth  = width;
-    event.mHeight = height;
-  }
+  if (resized) {
+    DrawEvent event{};
+    event.mX       = 0;
+    event.mY       = 0;
+    event.mWidth   = width;
+    event.mHeight  = height;
+    event.mResized = true;
+
+    mPixelData = mDrawCallback(event);
+    if (!mPixelData) {
+      std::cerr << "[" << __FILE__ << ":" << __LINE__
+                << "] Error when initializing GUI Texture Buffer!" << std::endl;
+      return;
+    }
+
+    size_t bufferSize = width * height * 4;
+    std::memcpy(mPixelData, b, bufferSize * sizeof(uint8_t));
 
-  mPixelData = mDrawCallback(event);
-  if (!mPixelData) {
-    std::cerr << "[" << __FILE__ << ":" << __LINE__
-              << "] Error when initializing GUI Texture Buffer!" << std::endl;
     return;
   }
 
-  if (event.mResized) {
-    size_t bufferSize = width * height * 4;
-    std::memcpy(mPixelData, b, bufferSize * sizeof(uint8_t));
-  } else {
-    for (auto const& rect : dirtyRects) {
-      if (rect.width > 0.5 * width) {
-        // When the rect is almost the whole screen width we just copy the rest of the width
-        // too. This is faster since we only need one efficient std::memcpy call.
+  for (auto const& rect : dirtyRects) {
+    // The draw callback is called once for each dirty rectangle, so that the receiver can upload
+    // only the changed regions.
+    DrawEvent event{};
+    event.mX       = rect.x;
+    event.mY       = rect.y;
+    event.mWidth   = rect.width;
+    event.mHeight  = rect.height;
+    event.mResized = false;
+
+    mPixelData = mDrawCallback(event);
+    if (!mPixelData) {
+      std::cerr << "[" << __FILE__ << ":" << __LINE__
+                << "] Error when initializing GUI Texture Buffer!" << std::endl;
+      return;
+    }
 
-        size_t startOffset = rect.y * width * 4 * sizeof(uint8_t);
-        size_t extend      = rect.height * width * 4 * sizeof(uint8_t);
+    if (rect.width > 0.5 * width) {
+      // When the rect is almost the whole screen width we just copy the rest of the width
+      // too. This is faster since we only need one efficient std::memcpy call.
+
+      size_t startOffset = rect.y * width * 4 * sizeof(uint8_t);
+      size_t extend      = rect.height * width * 4 * sizeof(uint8_t);
+
+      // NOLINTNEXTLINE: This is performance critical.
+      std::memcpy(mPixelData + startOffset, (uint8_t*)b + startOffset, extend);
+    } else {
+      // We copy each row of the changed region over individually, since they are not
+      // guaranteed to have continuous memory.
+      //
+      // ################################################################################
+      // ##############################+--------------------------------------+##########
+      // ####################### i = 0 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
+      // ####################### i = 1 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
+      // ####################### i = 2 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
+      // ####################### i = 3 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
+      // ####################### i = 4 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
+      // ####################### i = 5 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
+      // ##############################+--------------------------------------+##########
+      // ################################################################################
+      // ################################################################################
+      for (int i = 0; i < rect.height; ++i) {
+        size_t startOffset = ((rect.y + i) * width + rect.x) * 4 * sizeof(uint8_t);
+        size_t extend      = rect.width * 4 * sizeof(uint8_t);
 
         // NOLINTNEXTLINE: This is performance critical.
         std::memcpy(mPixelData + startOffset, (uint8_t*)b + startOffset, extend);
-      } else {
-        // We copy each row of the changed region over individually, since they are not
-        // guaranteed to have continuous memory.
-        //
-        // ################################################################################
-        // ##############################+--------------------------------------+##########
-        // ####################### i = 0 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
-        // ####################### i = 1 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
-        // ####################### i = 2 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
-        // ####################### i = 3 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
-        // ####################### i = 4 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
-        // ####################### i = 5 |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|##########
-        // ##############################+--------------------------------------+##########
-        // ################################################################################
-        // ################################################################################
-        for (int i = 0; i < rect.height; ++i) {
-          size_t startOffset = ((rect.y + i) * width + rect.x) * 4 * sizeof(uint8_t);
-          size_t extend      = rect.width * 4 * sizeof(uint8_t);
-
-          // NOLINTNEXTLINE: This is performance critical.
-          std::memcpy(mPixelData + startOffset, (uint8_t*)b + startOffset, extend);
-        }
       }
     }
   }
-} // namespace cs::gui::detail
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
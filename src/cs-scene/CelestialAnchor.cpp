@@ -7,10 +7,10 @@
 
 #include "CelestialAnchor.hpp"
 
+#include "EphemerisCache.hpp"
+
 #include <VistaKernel/GraphicsManager/VistaNodeBridge.h>
 
-#include <array>
-#include <cspice/SpiceUsr.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/component_wise.hpp>
@@ -92,22 +92,14 @@ void CelestialAnchor::setScale(double dScale) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 glm::dvec3 CelestialAnchor::getRelativePosition(double tTime, CelestialAnchor const& other) const {
-  glm::dvec3 vOtherPos = other.getPosition() / 1000.0;
-
-  std::array<double, 6> relPos{};
-  double                timeOfLight{};
-  std::array            otherPos{vOtherPos[2], vOtherPos[0], vOtherPos[1]};
-  spkcpt_c(otherPos.data(), other.getCenterName().c_str(), other.getFrameName().c_str(), tTime,
-      mFrameName.c_str(), "OBSERVER", "NONE", mCenterName.c_str(), relPos.data(), &timeOfLight);
-
-  if (failed_c()) {
-    std::array<SpiceChar, 320> msg{};
-    getmsg_c("LONG", 320, msg.data());
-    reset_c();
-    throw std::runtime_error(msg.data());
-  }
+  auto& cache = EphemerisCache::get();
 
-  auto vRelPos = glm::dvec3(relPos[1], relPos[2], relPos[0]) * 1000.0;
+  auto vRelPos = cache.getPosition(tTime, other.getCenterName(), mCenterName, mFrameName);
+
+  // The position of "other" is given in its own frame.
+  if (other.getPosition() != glm::dvec3(0.0)) {
+    vRelPos += cache.getRotation(tTime, other.getFrameName(), mFrameName) * other.getPosition();
+  }
 
   return glm::inverse(mRotation) * ((vRelPos - mPosition) / mScale);
 }
@@ -115,27 +107,8 @@ glm::dvec3 CelestialAnchor::getRelativePosition(double tTime, CelestialAnchor co
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 glm::dquat CelestialAnchor::getRelativeRotation(double tTime, CelestialAnchor const& other) const {
-
-  // get rotation from self to other
-  std::array<double[3], 3> rotMat{}; // NOLINT(modernize-avoid-c-arrays)
-  pxform_c(other.getFrameName().c_str(), mFrameName.c_str(), tTime, rotMat.data());
-
-  if (failed_c()) {
-    std::array<SpiceChar, 320> msg{};
-    getmsg_c("LONG", 320, msg.data());
-    reset_c();
-    throw std::runtime_error(msg.data());
-  }
-
-  // convert to quaternion
-  std::array<double, 3> axis{};
-  double                angle{};
-
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay, modernize-avoid-c-arrays)
-  raxisa_c(rotMat.data(), axis.data(), &angle);
-
-  return glm::inverse(mRotation) * glm::angleAxis(angle, glm::dvec3(axis[1], axis[2], axis[0])) *
-         other.mRotation;
+  auto rot = EphemerisCache::get().getRotation(tTime, other.getFrameName(), mFrameName);
+  return glm::inverse(mRotation) * rot * other.mRotation;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
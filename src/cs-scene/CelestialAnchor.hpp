@@ -86,6 +86,9 @@ class CS_SCENE_EXPORT CelestialAnchor {
 
   /// Returns the entire transformation of "other" in the coordinate system defined by this
   /// CelestialAnchor. This may throw a std::runtime_error if no sufficient SPICE data is available.
+  ///
+  /// The SPICE data used by these methods is taken from the EphemerisCache. Hence, as long as the
+  /// anchors are not modified concurrently, they can be called from multiple threads.
   virtual glm::dmat4 getRelativeTransform(double tTime, CelestialAnchor const& other) const;
 
   /// Returns the how much "other" is larger than this, i.e. other.GetAnchorScale() /
@@ -8,6 +8,7 @@
 #include "CelestialObject.hpp"
 
 #include "../cs-utils/convert.hpp"
+#include "../cs-utils/spice.hpp"
 #include "CelestialObserver.hpp"
 #include "logger.hpp"
 
@@ -61,6 +62,8 @@ glm::dvec3 const& CelestialObject::getRadii() const {
 
   // If no radii were given to the object, we try once to get them from SPICE.
   if (mRadii == glm::dvec3(0.0) && mRadiiFromSPICE == glm::dvec3(-1.0)) {
+    std::unique_lock<std::mutex> lock(utils::spice::getMutex());
+
     // get target id code
     SpiceInt     id{};
     SpiceBoolean found{};
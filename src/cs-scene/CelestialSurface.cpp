@@ -7,10 +7,33 @@
 
 #include "CelestialSurface.hpp"
 
+#include <glm/glm.hpp>
+
 namespace cs::scene {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void CelestialSurface::getHeights(
+    glm::dvec2 const* lngLats, double* heights, std::size_t count) const {
+  for (std::size_t i = 0; i < count; ++i) {
+    heights[i] = getHeight(lngLats[i]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<double> CelestialSurface::getHeights(std::vector<glm::dvec2> const& lngLats) const {
+  std::vector<double> heights(lngLats.size());
+  getHeights(lngLats.data(), heights.data(), lngLats.size());
+  return heights;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CelestialSurface::HeightQuery CelestialSurface::queryHeights(std::vector<glm::dvec2> lngLats) {
+  return {getHeights(lngLats), {}};
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 } // namespace cs::scene
@@ -10,8 +10,11 @@
 
 #include "cs_scene_export.hpp"
 
+#include <cstddef>
+#include <future>
 #include <glm/fwd.hpp>
 #include <memory>
+#include <vector>
 
 namespace cs::scene {
 
@@ -28,6 +31,38 @@ class CS_SCENE_EXPORT CelestialSurface {
   ///
   /// @param lngLat The coordinates on the surface in the Geographic Coordinate System format.
   virtual double getHeight(glm::dvec2 lngLat) const = 0;
+
+  /// Returns the elevations in meters at many points on the surface at once. The default
+  /// implementation calls getHeight() for each point. Implementations should override this if
+  /// sampling many points together is cheaper, for instance by looking up the terrain data of
+  /// neighboring points only once. Tools which sample the surface in loops should prefer this.
+  ///
+  /// @param lngLats The coordinates of count points on the surface in the Geographic Coordinate
+  ///                System format.
+  /// @param heights This receives the count elevations.
+  virtual void getHeights(glm::dvec2 const* lngLats, double* heights, std::size_t count) const;
+
+  /// Convenience overload of the method above.
+  std::vector<double> getHeights(std::vector<glm::dvec2> const& lngLats) const;
+
+  /// The result of queryHeights(). mEstimate contains the elevations which are available right
+  /// now. If the surface can provide more accurate elevations later on, mRefined is a valid future
+  /// which will receive them. Else it is invalid. The surface keeps refining the elevations only
+  /// as long as mToken or a copy of it exists, so resetting it cancels the refinement. Hence, a
+  /// HeightQuery which is replaced by a newer one does not cause any work anymore.
+  struct HeightQuery {
+    std::vector<double>              mEstimate;
+    std::future<std::vector<double>> mRefined;
+    std::shared_ptr<void>            mToken;
+  };
+
+  /// Returns the elevations in meters at the given points without blocking. If the terrain data
+  /// required for these points is not fully loaded yet, the implementation may load it in the
+  /// background and provide the refined elevations later on. The default implementation returns
+  /// the result of getHeights() and an invalid future.
+  ///
+  /// @param lngLats The coordinates on the surface in the Geographic Coordinate System format.
+  virtual HeightQuery queryHeights(std::vector<glm::dvec2> lngLats);
 };
 
 } // namespace cs::scene
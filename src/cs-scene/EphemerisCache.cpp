@@ -0,0 +1,439 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "EphemerisCache.hpp"
+
+#include "../cs-utils/spice.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cspice/SpiceUsr.h>
+#include <glm/gtc/constants.hpp>
+#include <stdexcept>
+#include <vector>
+
+namespace cs::scene {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Segments are fitted with this length first. It is halved for each segment which is not accurate
+// enough, down to the minimum length. All lengths are in seconds.
+const double INITIAL_SEGMENT_LENGTH = 86400.0;
+const double MIN_SEGMENT_LENGTH     = 60.0;
+
+// If a series grows larger than this, for instance because the simulation time runs very fast, it
+// is cleared to limit the memory usage.
+const std::size_t MAX_SEGMENTS = 4096;
+
+// Relative to the distance, the position tolerance is never smaller than this. In rotating frames,
+// SPICE itself is only precise to about 1e-11 times the distance, as the rotation angles are
+// computed from large numbers. Else distant bodies could never be fitted in these frames.
+const double RELATIVE_PRECISION = 1e-10;
+
+void throwOnSpiceError() {
+  if (failed_c()) {
+    std::array<SpiceChar, 320> msg{};
+    getmsg_c("LONG", 320, msg.data());
+    reset_c();
+    throw std::runtime_error(msg.data());
+  }
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EphemerisCache& EphemerisCache::get() {
+  static EphemerisCache cache;
+  return cache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::mutex& EphemerisCache::getSpiceMutex() {
+  return utils::spice::getMutex();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisCache::setEnabled(bool enabled) {
+  mEnabled = enabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool EphemerisCache::getEnabled() const {
+  return mEnabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisCache::setPositionTolerance(double meters) {
+  if (mPositionTolerance != meters) {
+    mPositionTolerance = meters;
+    clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double EphemerisCache::getPositionTolerance() const {
+  return mPositionTolerance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisCache::setRotationTolerance(double radians) {
+  if (mRotationTolerance != radians) {
+    mRotationTolerance = radians;
+    clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double EphemerisCache::getRotationTolerance() const {
+  return mRotationTolerance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisCache::clear() {
+  // Wait for segments which are currently being fitted.
+  std::unique_lock<std::mutex>        spiceLock(getSpiceMutex());
+  std::unique_lock<std::shared_mutex> lock(mSeriesMutex);
+
+  mPositions.clear();
+  mRotations.clear();
+
+  mCachedQueries  = 0;
+  mSpiceQueries   = 0;
+  mFittedSegments = 0;
+  mFailedSegments = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dvec3 EphemerisCache::getPosition(double tTime, std::string const& target,
+    std::string const& observer, std::string const& frame) {
+
+  if (target == observer) {
+    return glm::dvec3(0.0);
+  }
+
+  auto sampler = [&](double t) {
+    std::array<double, 3> pos{};
+    double                timeOfLight{};
+    spkpos_c(target.c_str(), t, frame.c_str(), "NONE", observer.c_str(), pos.data(), &timeOfLight);
+    throwOnSpiceError();
+
+    return Sample{pos[1] * 1000.0, pos[2] * 1000.0, pos[0] * 1000.0, 0.0};
+  };
+
+  Sample result{};
+
+  if (mEnabled) {
+    double tolerance = mPositionTolerance;
+
+    auto metric = [tolerance](Sample const& fitted, Sample const& exact) {
+      glm::dvec3 a(fitted[0], fitted[1], fitted[2]);
+      glm::dvec3 b(exact[0], exact[1], exact[2]);
+      return glm::length(a - b) <= std::max(tolerance, RELATIVE_PRECISION * glm::length(b));
+    };
+
+    result = query(mPositions, target + "/" + observer + "/" + frame, tTime, 3, sampler, metric);
+  } else {
+    std::unique_lock<std::mutex> lock(getSpiceMutex());
+    ++mSpiceQueries;
+    result = sampler(tTime);
+  }
+
+  return glm::dvec3(result[0], result[1], result[2]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dquat EphemerisCache::getRotation(
+    double tTime, std::string const& fromFrame, std::string const& toFrame) {
+
+  if (fromFrame == toFrame) {
+    return glm::dquat(1.0, 0.0, 0.0, 0.0);
+  }
+
+  auto sampler = [&](double t) {
+    std::array<double[3], 3> rotMat{}; // NOLINT(modernize-avoid-c-arrays)
+    pxform_c(fromFrame.c_str(), toFrame.c_str(), t, rotMat.data());
+    throwOnSpiceError();
+
+    // convert to quaternion
+    std::array<double, 3> axis{};
+    double                angle{};
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay, modernize-avoid-c-arrays)
+    raxisa_c(rotMat.data(), axis.data(), &angle);
+
+    auto rot = glm::angleAxis(angle, glm::dvec3(axis[1], axis[2], axis[0]));
+    return Sample{rot.w, rot.x, rot.y, rot.z};
+  };
+
+  Sample result{};
+
+  if (mEnabled) {
+    double tolerance = mRotationTolerance;
+
+    // q and -q describe the same rotation. The angle between two rotations a and b is
+    // 4 * asin(|a - b| / 2) if both are normalized and in the same hemisphere.
+    auto metric = [tolerance](Sample const& fitted, Sample const& exact) {
+      glm::dvec4 a = glm::normalize(glm::dvec4(fitted[0], fitted[1], fitted[2], fitted[3]));
+      glm::dvec4 b(exact[0], exact[1], exact[2], exact[3]);
+      double     d = std::min(glm::length(a - b), glm::length(a + b));
+      return 4.0 * std::asin(std::min(1.0, d * 0.5)) <= tolerance;
+    };
+
+    result = query(mRotations, fromFrame + "/" + toFrame, tTime, 4, sampler, metric);
+  } else {
+    std::unique_lock<std::mutex> lock(getSpiceMutex());
+    ++mSpiceQueries;
+    result = sampler(tTime);
+  }
+
+  return glm::normalize(glm::dquat(result[0], result[1], result[2], result[3]));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EphemerisCache::Statistics EphemerisCache::getStatistics() const {
+  Statistics statistics;
+  statistics.mCachedQueries  = mCachedQueries.load();
+  statistics.mSpiceQueries   = mSpiceQueries.load();
+  statistics.mFittedSegments = mFittedSegments.load();
+  statistics.mFailedSegments = mFailedSegments.load();
+  return statistics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EphemerisCache::Sample EphemerisCache::query(std::unordered_map<std::string, Series>& series,
+    std::string const& key, double tTime, std::size_t dimensions, Sampler const& sampler,
+    Metric const& metric) {
+
+  enum class Lookup { eHit, eMiss, eUncovered };
+
+  Sample result{};
+  double length = INITIAL_SEGMENT_LENGTH;
+
+  // Most queries end here. Many threads may evaluate the polynomials concurrently.
+  auto lookup = [&]() {
+    std::shared_lock<std::shared_mutex> lock(mSeriesMutex);
+
+    auto iter = series.find(key);
+    if (iter == series.end()) {
+      return Lookup::eMiss;
+    }
+
+    length       = iter->second.mSegmentLength;
+    auto segment = findSegment(iter->second, tTime);
+
+    if (!segment) {
+      return Lookup::eMiss;
+    }
+
+    if (!segment->mIsValid) {
+      return Lookup::eUncovered;
+    }
+
+    result = evaluate(*segment, tTime, dimensions);
+    return Lookup::eHit;
+  };
+
+  auto state = lookup();
+
+  if (state == Lookup::eHit) {
+    ++mCachedQueries;
+    return result;
+  }
+
+  std::unique_lock<std::mutex> spiceLock(getSpiceMutex());
+
+  // Another thread may have fitted the segment while we were waiting for SPICE.
+  if (state == Lookup::eMiss) {
+    state = lookup();
+
+    if (state == Lookup::eHit) {
+      ++mCachedQueries;
+      return result;
+    }
+  }
+
+  if (state == Lookup::eMiss) {
+    Segment segment;
+
+    // The segments are aligned to multiples of their length. As the length is only ever halved,
+    // a new segment can never overlap an existing one.
+    while (true) {
+      segment.mStart = std::floor(tTime / length) * length;
+      segment.mEnd   = segment.mStart + length;
+
+      try {
+        segment.mIsValid = fitSegment(segment, dimensions, sampler, metric);
+      } catch (std::exception const&) {
+        // SPICE has no data for a part of this segment.
+        segment.mIsValid = false;
+        break;
+      }
+
+      if (segment.mIsValid || length * 0.5 < MIN_SEGMENT_LENGTH) {
+        break;
+      }
+
+      length *= 0.5;
+    }
+
+    if (segment.mIsValid) {
+      ++mFittedSegments;
+    } else {
+      ++mFailedSegments;
+    }
+
+    {
+      std::unique_lock<std::shared_mutex> lock(mSeriesMutex);
+      auto&                               s = series[key];
+
+      if (s.mSegments.size() >= MAX_SEGMENTS) {
+        s.mSegments.clear();
+      }
+
+      s.mSegmentLength            = length;
+      s.mSegments[segment.mStart] = segment;
+    }
+
+    if (segment.mIsValid) {
+      ++mCachedQueries;
+      return evaluate(segment, tTime, dimensions);
+    }
+  }
+
+  // The segment is not covered, SPICE will most likely throw an exception here.
+  ++mSpiceQueries;
+  return sampler(tTime);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool EphemerisCache::fitSegment(
+    Segment& segment, std::size_t dimensions, Sampler const& sampler, Metric const& metric) {
+
+  const std::size_t nodes = DEGREE + 1;
+  const double      pi    = glm::pi<double>();
+
+  auto toTime = [&](double x) {
+    return segment.mStart + (x + 1.0) * 0.5 * (segment.mEnd - segment.mStart);
+  };
+
+  // Sample the data at the Chebyshev nodes in ascending order. The node k is at cos(theta_k).
+  std::array<Sample, nodes> samples{};
+  std::array<double, nodes> thetas{};
+
+  for (std::size_t k = 0; k < nodes; ++k) {
+    thetas.at(k)  = pi * (static_cast<double>(nodes - k) - 0.5) / static_cast<double>(nodes);
+    samples.at(k) = sampler(toTime(std::cos(thetas.at(k))));
+
+    // Rotations are fitted as quaternions. As q and -q describe the same rotation, SPICE may
+    // return either of them. Make sure that the samples are continuous.
+    if (dimensions == 4 && k > 0) {
+      double dot = 0.0;
+      for (std::size_t d = 0; d < 4; ++d) {
+        dot += samples.at(k)[d] * samples.at(k - 1)[d];
+      }
+
+      if (dot < 0.0) {
+        for (std::size_t d = 0; d < 4; ++d) {
+          samples.at(k)[d] = -samples.at(k)[d];
+        }
+      }
+    }
+  }
+
+  for (std::size_t d = 0; d < dimensions; ++d) {
+    for (std::size_t j = 0; j < nodes; ++j) {
+      double sum = 0.0;
+      for (std::size_t k = 0; k < nodes; ++k) {
+        sum += samples.at(k)[d] * std::cos(static_cast<double>(j) * thetas.at(k));
+      }
+
+      // The first coefficient is halved, so that evaluate() does not have to do this.
+      double scale = (j == 0 ? 1.0 : 2.0) / static_cast<double>(nodes);
+      segment.mCoefficients.at(d * nodes + j) = sum * scale;
+    }
+  }
+
+  // Check the polynomials at both ends of the segment and half-way between the nodes. These are
+  // the places where the error is largest.
+  std::vector<double> checks{-1.0, 1.0};
+  for (std::size_t k = 1; k < nodes; ++k) {
+    checks.push_back(-std::cos(pi * static_cast<double>(k) / static_cast<double>(nodes)));
+  }
+
+  return std::all_of(checks.begin(), checks.end(), [&](double x) {
+    double t = toTime(x);
+    return metric(evaluate(segment, t, dimensions), sampler(t));
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EphemerisCache::Segment const* EphemerisCache::findSegment(Series const& series, double tTime) {
+  auto iter = series.mSegments.upper_bound(tTime);
+
+  if (iter == series.mSegments.begin()) {
+    return nullptr;
+  }
+
+  --iter;
+
+  if (tTime >= iter->second.mEnd) {
+    return nullptr;
+  }
+
+  return &iter->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EphemerisCache::Sample EphemerisCache::evaluate(
+    Segment const& segment, double tTime, std::size_t dimensions) {
+
+  const std::size_t nodes = DEGREE + 1;
+
+  double x = 2.0 * (tTime - segment.mStart) / (segment.mEnd - segment.mStart) - 1.0;
+
+  // Clenshaw's recurrence.
+  Sample result{};
+  for (std::size_t d = 0; d < dimensions; ++d) {
+    auto const* c  = &segment.mCoefficients[d * nodes];
+    double      b1 = 0.0;
+    double      b2 = 0.0;
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    for (std::size_t j = DEGREE; j > 0; --j) {
+      double b0 = c[j] + 2.0 * x * b1 - b2;
+      b2        = b1;
+      b1        = b0;
+    }
+
+    result[d] = c[0] + x * b1 - b2;
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::scene
@@ -0,0 +1,164 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_SCENE_EPHEMERIS_CACHE_HPP
+#define CS_SCENE_EPHEMERIS_CACHE_HPP
+
+#include "cs_scene_export.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace cs::scene {
+
+/// Querying SPICE for the position of a body or for the orientation of a reference frame is
+/// comparatively expensive and, as CSPICE is not thread-safe, it cannot be done in parallel. The
+/// EphemerisCache approximates these queries with piecewise Chebyshev polynomials. For each
+/// combination of target, observer and frame, segments of these polynomials are fitted to the
+/// SPICE data on demand when a query hits a time which is not covered yet. Each segment is checked
+/// against SPICE before it is used; if it exceeds the configured tolerance, the segment length is
+/// halved until it is accurate enough. Later queries are evaluated from the polynomials without
+/// touching SPICE at all, so they are cheap and can be made from multiple threads concurrently.
+///
+/// If SPICE has no data for a part of a segment, queries in this segment fall back to SPICE.
+/// These will throw a std::runtime_error just like direct SPICE queries if the time is not covered
+/// by the loaded kernels.
+///
+/// All positions are in meters and all vectors and rotations use the axis convention of
+/// CosmoScout VR, which is the SPICE convention with the axes permuted from (x, y, z) to (y, z, x).
+///
+/// Most components should not create their own cache but use the process-wide instance returned
+/// by EphemerisCache::get().
+class CS_SCENE_EXPORT EphemerisCache {
+ public:
+  /// Some statistics which may be useful for debugging and benchmarking. All counters are
+  /// accumulated since the last call to clear().
+  struct Statistics {
+    /// The number of queries which have been answered from the polynomials.
+    uint64_t mCachedQueries = 0;
+
+    /// The number of queries which have been passed on to SPICE, either because the cache is
+    /// disabled or because no accurate segment could be fitted.
+    uint64_t mSpiceQueries = 0;
+
+    /// The number of segments which have been fitted successfully.
+    uint64_t mFittedSegments = 0;
+
+    /// The number of segments for which no accurate polynomial could be found.
+    uint64_t mFailedSegments = 0;
+  };
+
+  EphemerisCache() = default;
+
+  EphemerisCache(EphemerisCache const& other) = delete;
+  EphemerisCache(EphemerisCache&& other)      = delete;
+
+  EphemerisCache& operator=(EphemerisCache const& other) = delete;
+  EphemerisCache& operator=(EphemerisCache&& other)      = delete;
+
+  ~EphemerisCache() = default;
+
+  /// Returns the process-wide shared instance. This is used by the CelestialAnchor.
+  static EphemerisCache& get();
+
+  /// CSPICE uses global state, so only one thread may call it at any time. Each call has to be made
+  /// while holding this mutex. This is the same as cs::utils::spice::getMutex().
+  static std::mutex& getSpiceMutex();
+
+  /// If disabled, all queries are passed on to SPICE directly. Already fitted segments are kept.
+  void setEnabled(bool enabled);
+  bool getEnabled() const;
+
+  /// The maximum allowed position error in meters. At large distances, this is relaxed to 1e-10
+  /// times the distance, as SPICE itself is not much more precise in rotating frames. Changing this
+  /// clears the cache.
+  void   setPositionTolerance(double meters);
+  double getPositionTolerance() const;
+
+  /// The maximum allowed rotation error in radians. Changing this clears the cache.
+  void   setRotationTolerance(double radians);
+  double getRotationTolerance() const;
+
+  /// Removes all fitted segments and resets the statistics. This has to be called whenever
+  /// different SPICE kernels are loaded.
+  void clear();
+
+  /// Returns the position of the center of "target" relative to the center of "observer" in the
+  /// given frame. This is the equivalent of SPICE's spkpos_c() without aberration correction.
+  glm::dvec3 getPosition(double tTime, std::string const& target, std::string const& observer,
+      std::string const& frame);
+
+  /// Returns the rotation which transforms vectors from "fromFrame" to "toFrame". This is the
+  /// equivalent of SPICE's pxform_c().
+  glm::dquat getRotation(double tTime, std::string const& fromFrame, std::string const& toFrame);
+
+  Statistics getStatistics() const;
+
+ private:
+  static constexpr std::size_t DEGREE     = 12;
+  static constexpr std::size_t DIMENSIONS = 4;
+
+  using Sample  = std::array<double, DIMENSIONS>;
+  using Sampler = std::function<Sample(double)>;
+  using Metric  = std::function<bool(Sample const& fitted, Sample const& exact)>;
+
+  struct Segment {
+    double mStart{};
+    double mEnd{};
+
+    /// If this is false, SPICE has no data for a part of the segment or the polynomial was not
+    /// accurate enough even for the shortest segment length. Queries are passed to SPICE then.
+    bool mIsValid{};
+
+    /// DEGREE + 1 coefficients for each dimension.
+    std::array<double, DIMENSIONS * (DEGREE + 1)> mCoefficients{};
+  };
+
+  struct Series {
+    /// The segments are sorted by their start time. They do not overlap.
+    std::map<double, Segment> mSegments;
+
+    /// The length of the next segment to be fitted. This shrinks for quickly changing data.
+    double mSegmentLength{};
+  };
+
+  Sample query(std::unordered_map<std::string, Series>& series, std::string const& key,
+      double tTime, std::size_t dimensions, Sampler const& sampler, Metric const& metric);
+
+  static bool fitSegment(
+      Segment& segment, std::size_t dimensions, Sampler const& sampler, Metric const& metric);
+
+  static Segment const* findSegment(Series const& series, double tTime);
+  static Sample evaluate(Segment const& segment, double tTime, std::size_t dimensions);
+
+  std::atomic<bool>   mEnabled{true};
+  std::atomic<double> mPositionTolerance{0.001};
+  std::atomic<double> mRotationTolerance{1e-9};
+
+  mutable std::shared_mutex               mSeriesMutex;
+  std::unordered_map<std::string, Series> mPositions;
+  std::unordered_map<std::string, Series> mRotations;
+
+  std::atomic<uint64_t> mCachedQueries{0};
+  std::atomic<uint64_t> mSpiceQueries{0};
+  std::atomic<uint64_t> mFittedSegments{0};
+  std::atomic<uint64_t> mFailedSegments{0};
+};
+
+} // namespace cs::scene
+
+#endif // CS_SCENE_EPHEMERIS_CACHE_HPP
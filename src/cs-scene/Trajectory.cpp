@@ -7,37 +7,72 @@
 
 #include "Trajectory.hpp"
 
+#include "../cs-utils/FrameStats.hpp"
 #include "../cs-utils/utils.hpp"
 
 #include <VistaKernel/DisplayManager/VistaProjection.h>
 #include <VistaOGLExt/VistaBufferObject.h>
 #include <VistaOGLExt/VistaGLSLShader.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
+#include <algorithm>
 #include <array>
+#include <glm/gtc/type_ptr.hpp>
 
 namespace cs::scene {
 
+namespace {
+
+// Each point is stored as two vec4 on the GPU. The first one contains the point and its time
+// converted to float, the second one contains the remainders.
+struct Vertex {
+  glm::vec4 mHigh;
+  glm::vec4 mLow;
+};
+
+Vertex splitPoint(glm::dvec4 const& point) {
+  glm::vec4 high(point);
+  return {high, glm::vec4(point - glm::dvec4(high))};
+}
+
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 static const char* SHADER_VERT = R"(
 #version 330
 
 // inputs
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in float inAge;
+layout(location = 0) in vec4 inHigh;
+layout(location = 1) in vec4 inLow;
 
 // uniforms
-uniform mat4 uMatModelView;
-uniform mat4 uMatProjection;
+uniform mat4  uMatModelView;
+uniform mat4  uMatProjection;
+uniform mat3  uMatRelative;
+uniform vec3  uObserverHigh;
+uniform vec3  uObserverLow;
+uniform float uTimeHigh;
+uniform float uTimeLow;
+uniform float uMaxAge;
+uniform vec3  uTip;
 
 // outputs
 out float fAge;
 
 void main()
 {
-    fAge = inAge;
-    vec4 pos = uMatModelView * vec4(inPosition.xyz, 1);
-    gl_Position = uMatProjection * pos;
+    // The high parts are subtracted first. This is exact for nearby values, so the position
+    // relative to the observer and the age of the point keep the precision of the double input.
+    float age = (uTimeHigh - inHigh.w) + (uTimeLow - inLow.w);
+    vec3  pos = uTip;
+    fAge      = 0.0;
+
+    if (age > 0.0) {
+      pos  = uMatRelative * ((inHigh.xyz - uObserverHigh) + (inLow.xyz - uObserverLow));
+      fAge = age / uMaxAge;
+    }
+
+    gl_Position = uMatProjection * uMatModelView * vec4(pos, 1);
 })";
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -70,58 +105,96 @@ Trajectory::Trajectory()
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Trajectory::upload(glm::dmat4 const& relativeTransform, double dTime,
-    std::vector<glm::dvec4> const& vPoints, glm::dvec3 const& vTip, int startIndex) {
-  if (!vPoints.empty()) {
-    // transform all points to observer centric coordinates
-    std::vector<glm::vec4> points(vPoints.size());
+void Trajectory::uploadPoints(
+    std::vector<glm::dvec4> const& vPoints, std::size_t first, std::size_t count) {
+  if (vPoints.empty()) {
+    mPointCount = 0;
+    return;
+  }
 
-    for (size_t i(0); i < vPoints.size(); ++i) {
-      int ringbufferIndex = (static_cast<int>(i) + startIndex) % static_cast<int>(vPoints.size());
+  auto pointCount = static_cast<uint32_t>(vPoints.size());
 
-      glm::dvec4 const& curr = vPoints[ringbufferIndex];
+  // The buffer contains one additional vertex at its end which repeats the first point. This way,
+  // the ring buffer can be drawn as two line strips without a gap in between.
+  if (mPointCount != pointCount || !mVBO) {
+    mVBO = std::make_unique<VistaBufferObject>();
+    mVAO = std::make_unique<VistaVertexArrayObject>();
 
-      glm::dvec4 pos(curr.x, curr.y, curr.z, 1.0);
-      auto       age = static_cast<float>((dTime - curr.w) / mMaxAge);
+    mVAO->Bind();
 
-      if (curr.w >= dTime) {
-        pos = glm::dvec4(vTip, 1.0);
-        age = 0.F;
-      }
+    mVBO->Bind(GL_ARRAY_BUFFER);
+    mVBO->BufferData((pointCount + 1) * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
 
-      pos = relativeTransform * pos;
+    // high parts
+    mVAO->EnableAttributeArray(0);
+    mVAO->SpecifyAttributeArrayFloat(
+        0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, mHigh), mVBO.get());
 
-      points[i] = glm::vec4(pos.x, pos.y, pos.z, age);
-    }
+    // low parts
+    mVAO->EnableAttributeArray(1);
+    mVAO->SpecifyAttributeArrayFloat(
+        1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, mLow), mVBO.get());
 
-    if (mPointCount != vPoints.size()) {
-      mVBO = std::make_unique<VistaBufferObject>();
-      mVAO = std::make_unique<VistaVertexArrayObject>();
+    mVAO->Release();
+    mVBO->Release();
 
-      mVAO->Bind();
+    mPointCount = pointCount;
+    first       = 0;
+    count       = pointCount;
+  }
 
-      mVBO->Bind(GL_ARRAY_BUFFER);
-      mVBO->BufferData(points.size() * sizeof(glm::vec4), points.data(), GL_DYNAMIC_DRAW);
+  count = std::min<std::size_t>(count, pointCount);
+  first = first % pointCount;
 
-      // positions
-      mVAO->EnableAttributeArray(0);
-      mVAO->SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), 0, mVBO.get());
+  if (count == 0) {
+    return;
+  }
 
-      // ages
-      mVAO->EnableAttributeArray(1);
-      mVAO->SpecifyAttributeArrayFloat(
-          1, 1, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), sizeof(glm::vec3), mVBO.get());
+  std::vector<Vertex> vertices(count);
 
-      mVAO->Release();
-      mVBO->Release();
-    } else {
-      mVBO->Bind(GL_ARRAY_BUFFER);
-      mVBO->BufferSubData(0, points.size() * sizeof(glm::vec4), points.data());
-      mVBO->Release();
-    }
+  for (std::size_t i(0); i < count; ++i) {
+    vertices[i] = splitPoint(vPoints[(first + i) % pointCount]);
+  }
+
+  mVBO->Bind(GL_ARRAY_BUFFER);
 
-    mPointCount = static_cast<int>(vPoints.size());
+  // The range may wrap around at the end of the ring buffer.
+  std::size_t tail = std::min<std::size_t>(count, pointCount - first);
+  mVBO->BufferSubData(first * sizeof(Vertex), tail * sizeof(Vertex), vertices.data());
+
+  if (tail < count) {
+    mVBO->BufferSubData(0, (count - tail) * sizeof(Vertex), vertices.data() + tail);
   }
+
+  // Update the copy of the first point if it has changed.
+  if (first == 0 || tail < count) {
+    std::size_t index = first == 0 ? 0 : tail;
+    mVBO->BufferSubData(pointCount * sizeof(Vertex), sizeof(Vertex), &vertices[index]);
+  }
+
+  mVBO->Release();
+
+  utils::FrameStats::get().addValue(
+      "Uploaded Trajectory Bytes", static_cast<int64_t>(count * sizeof(Vertex)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Trajectory::update(
+    glm::dmat4 const& relativeTransform, double dTime, glm::dvec3 const& vTip, int startIndex) {
+
+  // Instead of transforming all points to observer centric coordinates, the observer is
+  // transformed to the coordinate system of the points. The shader then only has to rotate and
+  // scale the difference.
+  glm::dvec3 observer(glm::inverse(relativeTransform) * glm::dvec4(0.0, 0.0, 0.0, 1.0));
+
+  mRelativeMatrix = glm::mat3(relativeTransform);
+  mObserverHigh   = glm::vec3(observer);
+  mObserverLow    = glm::vec3(observer - glm::dvec3(mObserverHigh));
+  mTimeHigh       = static_cast<float>(dTime);
+  mTimeLow        = static_cast<float>(dTime - static_cast<double>(mTimeHigh));
+  mTip            = glm::vec3(relativeTransform * glm::dvec4(vTip, 1.0));
+  mStartIndex     = mPointCount > 0 ? static_cast<uint32_t>(startIndex) % mPointCount : 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -156,7 +229,22 @@ bool Trajectory::Do() {
     glUniformMatrix4fv(mUniforms.modelViewMatrix, 1, GL_FALSE, glMatMV.data());
     glUniformMatrix4fv(mUniforms.projectionMatrix, 1, GL_FALSE, glMatP.data());
 
-    glDrawArrays(GL_LINE_STRIP, 0, mPointCount);
+    glUniformMatrix3fv(mUniforms.relativeMatrix, 1, GL_FALSE, glm::value_ptr(mRelativeMatrix));
+    glUniform3fv(mUniforms.observerHigh, 1, glm::value_ptr(mObserverHigh));
+    glUniform3fv(mUniforms.observerLow, 1, glm::value_ptr(mObserverLow));
+    glUniform3fv(mUniforms.tip, 1, glm::value_ptr(mTip));
+    mShader->SetUniform(mUniforms.timeHigh, mTimeHigh);
+    mShader->SetUniform(mUniforms.timeLow, mTimeLow);
+    mShader->SetUniform(mUniforms.maxAge, static_cast<float>(mMaxAge));
+
+    // The oldest point is at mStartIndex. The first strip runs to the end of the buffer, including
+    // the copy of the first point, the second one from the first point to the newest point.
+    std::array<GLint, 2>   firsts{static_cast<GLint>(mStartIndex), 0};
+    std::array<GLsizei, 2> counts{
+        static_cast<GLsizei>(mStartIndex == 0 ? mPointCount : mPointCount + 1 - mStartIndex),
+        static_cast<GLsizei>(mStartIndex)};
+
+    glMultiDrawArrays(GL_LINE_STRIP, firsts.data(), counts.data(), 2);
 
     mShader->Release();
     mVAO->Release();
@@ -189,6 +277,13 @@ void Trajectory::createShader() {
   mUniforms.endColor         = mShader->GetUniformLocation("cEndColor");
   mUniforms.modelViewMatrix  = mShader->GetUniformLocation("uMatModelView");
   mUniforms.projectionMatrix = mShader->GetUniformLocation("uMatProjection");
+  mUniforms.relativeMatrix   = mShader->GetUniformLocation("uMatRelative");
+  mUniforms.observerHigh     = mShader->GetUniformLocation("uObserverHigh");
+  mUniforms.observerLow      = mShader->GetUniformLocation("uObserverLow");
+  mUniforms.timeHigh         = mShader->GetUniformLocation("uTimeHigh");
+  mUniforms.timeLow          = mShader->GetUniformLocation("uTimeLow");
+  mUniforms.maxAge           = mShader->GetUniformLocation("uMaxAge");
+  mUniforms.tip              = mShader->GetUniformLocation("uTip");
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -17,6 +17,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -25,8 +26,14 @@ namespace cs::scene {
 /// This class is responsible for drawing trajectories. Trajectories are line segments which
 /// typically follow an object in space. It is most often used to draw orbit paths.
 /// A trajectories trail consists of a list of points in 3D space, where every 3D point is
-/// extended by a fourth value, which indicates its age. This is used to fade older
-/// points out. The lifetime of every point depends on the maxAge member.
+/// extended by a fourth value, which is the time at which the point was sampled. This is used to
+/// fade older points out. The lifetime of every point depends on the maxAge member.
+///
+/// The points are stored in a ring buffer on the GPU. They are given in the coordinate system of
+/// the object the trajectory is drawn relative to and are split into a high and a low float part
+/// each, so that they retain double precision. Only new points have to be uploaded; the
+/// transformation to observer centric coordinates and the computation of the age of each point is
+/// done in the vertex shader.
 /// The color of every point is also dependent on the lifetime. It is controlled with the members
 /// startColor and endColor. A young point will have a color closer to the startColor and an old
 /// point, which is close to the maxAge will have a color closer to the endColor.
@@ -42,11 +49,20 @@ class CS_SCENE_EXPORT Trajectory : public IVistaOpenGLDraw {
 
   ~Trajectory() override = default;
 
-  /// Transforms all points by relativeTransform and uploads them to the GPU. Call this every frame
-  /// in order to show the trajectory with observer centric coordinates. dTime determines the
-  /// current age of all points.
-  void upload(glm::dmat4 const& relativeTransform, double dTime,
-      std::vector<glm::dvec4> const& vPoints, glm::dvec3 const& vTip, int startIndex);
+  /// Uploads count points of the given ring buffer to the GPU, beginning at index first and
+  /// wrapping around at the end of vPoints. The fourth component of each point is the time at which
+  /// it was sampled. If the size of vPoints changed since the last call, the buffer on the GPU is
+  /// reallocated and all points are uploaded. If vPoints is empty, nothing is drawn until points
+  /// are uploaded again.
+  void uploadPoints(
+      std::vector<glm::dvec4> const& vPoints, std::size_t first, std::size_t count);
+
+  /// Call this every frame in order to show the trajectory with observer centric coordinates.
+  /// relativeTransform transforms the points to observer centric coordinates, dTime determines the
+  /// current age of all points and startIndex is the index of the oldest point in the ring buffer.
+  /// Points which are newer than dTime are drawn at vTip instead.
+  void update(
+      glm::dmat4 const& relativeTransform, double dTime, glm::dvec3 const& vTip, int startIndex);
 
   /// The method Do() gets the callback from scene graph during the rendering process.
   /// Renders the trajectory in its current state.
@@ -86,12 +102,29 @@ class CS_SCENE_EXPORT Trajectory : public IVistaOpenGLDraw {
   bool mShaderDirty = true;
 
   uint32_t mPointCount{0};
+  uint32_t mStartIndex{0};
+
+  // The values of the last call to update(). The observer position is given in the coordinate
+  // system of the points and, like the time, split into a high and a low part.
+  glm::mat3 mRelativeMatrix{1.F};
+  glm::vec3 mObserverHigh{0.F};
+  glm::vec3 mObserverLow{0.F};
+  float     mTimeHigh{0.F};
+  float     mTimeLow{0.F};
+  glm::vec3 mTip{0.F};
 
   struct {
     uint32_t startColor       = 0;
     uint32_t endColor         = 0;
     uint32_t modelViewMatrix  = 0;
     uint32_t projectionMatrix = 0;
+    uint32_t relativeMatrix   = 0;
+    uint32_t observerHigh     = 0;
+    uint32_t observerLow      = 0;
+    uint32_t timeHigh         = 0;
+    uint32_t timeLow          = 0;
+    uint32_t maxAge           = 0;
+    uint32_t tip              = 0;
   } mUniforms;
 };
 } // namespace cs::scene
@@ -0,0 +1,405 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "TrajectorySampler.hpp"
+
+#include "../cs-utils/filesystem.hpp"
+#include "EphemerisCache.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cspice/SpiceUsr.h>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+namespace cs::scene {
+
+namespace {
+
+// A block file starts with this magic, followed by VERSION, the length of the key, the key itself
+// and BLOCK_SIZE samples with four doubles each.
+const std::array<char, 8> MAGIC   = {'C', 'S', 'V', 'R', 'T', 'R', 'A', 'J'};
+const uint32_t            VERSION = 1;
+
+// Rounds towards negative infinity, so that negative sample indices are mapped to the correct
+// block.
+int64_t floorDiv(int64_t a, int64_t b) {
+  return a / b - ((a % b != 0) && ((a < 0) != (b < 0)) ? 1 : 0);
+}
+
+std::string toHex(std::size_t value) {
+  std::ostringstream stream;
+  stream << std::hex << std::setw(16) << std::setfill('0') << value;
+  return stream.str();
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TrajectorySampler::Job::isReady() const {
+  return mDone.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrajectorySampler::Job::wait() const {
+  mDone.wait();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrajectorySampler::Job::cancel() {
+  mCancelled = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<glm::dvec4> const& TrajectorySampler::Job::getPoints() const {
+  return mPoints;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TrajectorySampler& TrajectorySampler::get() {
+  static TrajectorySampler sampler;
+  return sampler;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrajectorySampler::setCacheDirectory(std::string const& directory) {
+  if (!directory.empty()) {
+    try {
+      utils::filesystem::createDirectoryRecursively(directory);
+    } catch (std::exception const& e) {
+      logger().warn("Failed to create trajectory cache directory '{}': {}", directory, e.what());
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mCacheDirectory = directory;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string TrajectorySampler::getCacheDirectory() const {
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mCacheDirectory;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrajectorySampler::clear() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mKernelKey.clear();
+  mSampledBlocks = 0;
+  mLoadedBlocks  = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<TrajectorySampler::Job> TrajectorySampler::sample(Request const& request) {
+  auto job   = std::make_shared<Job>();
+  job->mDone = job->mPromise.get_future().share();
+  job->mPoints.resize(request.mCount, glm::dvec4(std::numeric_limits<double>::quiet_NaN()));
+
+  if (request.mCount == 0) {
+    job->mPromise.set_value();
+    return job;
+  }
+
+  auto blockSize  = static_cast<int64_t>(BLOCK_SIZE);
+  auto firstBlock = floorDiv(request.mFirst, blockSize);
+  auto lastBlock  = floorDiv(request.mFirst + static_cast<int64_t>(request.mCount) - 1, blockSize);
+
+  job->mPendingBlocks = static_cast<std::size_t>(lastBlock - firstBlock + 1);
+
+  auto directory = request.mUseCache ? getCacheDirectory() : std::string();
+  auto kernelKey = directory.empty() ? std::string() : getKernelKey();
+  auto shared    = std::make_shared<Request const>(request);
+
+  for (int64_t block = firstBlock; block <= lastBlock; ++block) {
+    mTasks.post([this, job, shared, directory, kernelKey, block]() {
+      if (!job->mCancelled) {
+        copyBlock(*shared, block, getBlock(*shared, block, directory, kernelKey), job->mPoints);
+      }
+
+      if (--job->mPendingBlocks == 0) {
+        job->mPromise.set_value();
+      }
+    });
+  }
+
+  return job;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<glm::dvec4> TrajectorySampler::sampleNow(Request const& request) {
+  std::vector<glm::dvec4> points(
+      request.mCount, glm::dvec4(std::numeric_limits<double>::quiet_NaN()));
+
+  if (request.mCount == 0) {
+    return points;
+  }
+
+  auto blockSize  = static_cast<int64_t>(BLOCK_SIZE);
+  auto firstBlock = floorDiv(request.mFirst, blockSize);
+  auto lastBlock  = floorDiv(request.mFirst + static_cast<int64_t>(request.mCount) - 1, blockSize);
+
+  auto directory = request.mUseCache ? getCacheDirectory() : std::string();
+  auto kernelKey = directory.empty() ? std::string() : getKernelKey();
+
+  // The blocks are computed on this thread, so this does not have to wait for the jobs which are
+  // currently queued on the ThreadPool.
+  for (int64_t block = firstBlock; block <= lastBlock; ++block) {
+    copyBlock(request, block, getBlock(request, block, directory, kernelKey), points);
+  }
+
+  return points;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TrajectorySampler::Statistics TrajectorySampler::getStatistics() const {
+  Statistics statistics;
+  statistics.mSampledBlocks = mSampledBlocks.load();
+  statistics.mLoadedBlocks  = mLoadedBlocks.load();
+  return statistics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string TrajectorySampler::getKernelKey() {
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  if (!mKernelKey.empty()) {
+    return mKernelKey;
+  }
+
+  std::ostringstream kernels;
+
+  {
+    std::unique_lock<std::mutex> spiceLock(EphemerisCache::getSpiceMutex());
+
+    SpiceInt count = 0;
+    ktotal_c("ALL", &count);
+
+    for (SpiceInt i = 0; i < count; ++i) {
+      std::array<SpiceChar, 1024> file{};
+      std::array<SpiceChar, 32>   type{};
+      std::array<SpiceChar, 1024> source{};
+      SpiceInt                    handle = 0;
+      SpiceBoolean                found  = SPICEFALSE;
+
+      kdata_c(i, "ALL", static_cast<SpiceInt>(file.size()), static_cast<SpiceInt>(type.size()),
+          static_cast<SpiceInt>(source.size()), file.data(), type.data(), source.data(), &handle,
+          &found);
+
+      if (!found) {
+        continue;
+      }
+
+      // Kernels may be replaced by newer versions with the same name, so their size and
+      // modification time are part of the key as well.
+      boost::system::error_code error;
+      auto size = boost::filesystem::file_size(file.data(), error);
+      auto time = boost::filesystem::last_write_time(file.data(), error);
+
+      kernels << file.data() << ';' << size << ';' << time << ';';
+    }
+
+    if (failed_c()) {
+      reset_c();
+    }
+  }
+
+  mKernelKey = toHex(std::hash<std::string>{}(kernels.str()));
+  return mKernelKey;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string TrajectorySampler::getBlockKey(
+    std::string const& kernelKey, Request const& request, int64_t block) {
+
+  // All floating point values are written in hexadecimal notation, so that they are exact.
+  std::ostringstream key;
+  key << std::hexfloat << kernelKey << ';';
+
+  // The samples are only accurate up to the tolerances of the EphemerisCache.
+  auto const& ephemerisCache = EphemerisCache::get();
+  key << ephemerisCache.getEnabled() << ';' << ephemerisCache.getPositionTolerance() << ';'
+      << ephemerisCache.getRotationTolerance() << ';';
+
+  for (auto const* anchor : {&request.mCenter, &request.mTarget}) {
+    auto const& position = anchor->getPosition();
+    auto const& rotation = anchor->getRotation();
+
+    key << anchor->getCenterName() << ';' << anchor->getFrameName() << ';' << position.x << ';'
+        << position.y << ';' << position.z << ';' << rotation.w << ';' << rotation.x << ';'
+        << rotation.y << ';' << rotation.z << ';' << anchor->getScale() << ';';
+  }
+
+  key << request.mExistence.x << ';' << request.mExistence.y << ';' << request.mOffset << ';'
+      << request.mStep << ';' << block;
+
+  return key.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TrajectorySampler::loadBlock(
+    std::string const& file, std::string const& key, std::vector<glm::dvec4>& points) {
+
+  std::ifstream stream(file, std::ios::in | std::ios::binary);
+
+  if (!stream) {
+    return false;
+  }
+
+  std::array<char, 8> magic{};
+  uint32_t            version   = 0;
+  uint32_t            keyLength = 0;
+
+  stream.read(magic.data(), magic.size());
+  stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+  stream.read(reinterpret_cast<char*>(&keyLength), sizeof(keyLength));
+
+  if (!stream || magic != MAGIC || version != VERSION || keyLength != key.size()) {
+    return false;
+  }
+
+  // Different blocks may end up with the same file name, so the key is compared as well.
+  std::string storedKey(keyLength, '\0');
+  stream.read(storedKey.data(), keyLength);
+
+  if (!stream || storedKey != key) {
+    return false;
+  }
+
+  points.resize(BLOCK_SIZE);
+  stream.read(reinterpret_cast<char*>(points.data()),
+      static_cast<std::streamsize>(BLOCK_SIZE * sizeof(glm::dvec4)));
+
+  return static_cast<bool>(stream);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrajectorySampler::saveBlock(
+    std::string const& file, std::string const& key, std::vector<glm::dvec4> const& points) {
+
+  // Another thread or another instance of CosmoScout VR may write the same block at the same time.
+  // Therefore, the block is written to a unique temporary file which is moved into place
+  // afterwards.
+  auto tmpFile =
+      boost::filesystem::path(file).parent_path() / boost::filesystem::unique_path("%%%%%%%%.tmp");
+
+  {
+    std::ofstream stream(tmpFile.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+    auto keyLength = static_cast<uint32_t>(key.size());
+
+    stream.write(MAGIC.data(), MAGIC.size());
+    stream.write(reinterpret_cast<char const*>(&VERSION), sizeof(VERSION));
+    stream.write(reinterpret_cast<char const*>(&keyLength), sizeof(keyLength));
+    stream.write(key.data(), keyLength);
+    stream.write(reinterpret_cast<char const*>(points.data()),
+        static_cast<std::streamsize>(points.size() * sizeof(glm::dvec4)));
+
+    if (!stream) {
+      logger().warn("Failed to write trajectory cache file '{}'.", tmpFile.string());
+      return;
+    }
+  }
+
+  boost::system::error_code error;
+  boost::filesystem::rename(tmpFile, file, error);
+
+  if (error) {
+    boost::filesystem::remove(tmpFile, error);
+    logger().warn("Failed to write trajectory cache file '{}'.", file);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<glm::dvec4> TrajectorySampler::getBlock(Request const& request, int64_t block,
+    std::string const& directory, std::string const& kernelKey) {
+
+  std::vector<glm::dvec4> points;
+  std::string             file;
+  std::string             key;
+
+  if (!directory.empty()) {
+    key  = getBlockKey(kernelKey, request, block);
+    file = directory + "/" + toHex(std::hash<std::string>{}(key)) + ".bin";
+  }
+
+  if (!file.empty() && loadBlock(file, key, points)) {
+    ++mLoadedBlocks;
+    return points;
+  }
+
+  points = sampleBlock(request, block);
+  ++mSampledBlocks;
+
+  if (!file.empty()) {
+    saveBlock(file, key, points);
+  }
+
+  return points;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrajectorySampler::copyBlock(Request const& request, int64_t block,
+    std::vector<glm::dvec4> const& blockPoints, std::vector<glm::dvec4>& points) {
+
+  // Copy the part of the block which has been requested.
+  auto blockSize = static_cast<int64_t>(BLOCK_SIZE);
+  auto begin     = std::max(block * blockSize, request.mFirst);
+  auto end =
+      std::min((block + 1) * blockSize, request.mFirst + static_cast<int64_t>(request.mCount));
+
+  for (auto i = begin; i < end; ++i) {
+    points[i - request.mFirst] = blockPoints[i - block * blockSize];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<glm::dvec4> TrajectorySampler::sampleBlock(Request const& request, int64_t block) {
+  std::vector<glm::dvec4> points(BLOCK_SIZE);
+
+  for (std::size_t i(0); i < BLOCK_SIZE; ++i) {
+    auto   index = block * static_cast<int64_t>(BLOCK_SIZE) + static_cast<int64_t>(i);
+    double tTime = glm::clamp(request.mOffset + static_cast<double>(index) * request.mStep,
+        request.mExistence.x, request.mExistence.y);
+
+    try {
+      glm::dvec3 pos = request.mCenter.getRelativePosition(tTime, request.mTarget);
+      points[i]      = glm::dvec4(pos, tTime);
+    } catch (...) {
+      // Getting the relative transformation may fail due to insufficient SPICE data.
+      points[i] = glm::dvec4(std::numeric_limits<double>::quiet_NaN());
+    }
+  }
+
+  return points;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::scene
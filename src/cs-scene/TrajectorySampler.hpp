@@ -0,0 +1,176 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_SCENE_TRAJECTORY_SAMPLER_HPP
+#define CS_SCENE_TRAJECTORY_SAMPLER_HPP
+
+#include "cs_scene_export.hpp"
+
+#include "../cs-utils/ThreadPool.hpp"
+#include "CelestialAnchor.hpp"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cs::scene {
+
+/// Sampling a trajectory requires one SPICE query per sample. When a trajectory has to be computed
+/// from scratch, for instance after a jump in time, this may take long enough to stall a frame. The
+/// TrajectorySampler computes trajectories on the cs::utils::ThreadPool instead. This works
+/// because all queries go through the EphemerisCache, which serializes the remaining SPICE calls.
+///
+/// The samples of a trajectory lie on a grid with a fixed step. This grid is divided into blocks of
+/// BLOCK_SIZE samples which are computed in parallel. If a cache directory is set, each block is
+/// stored in a file there. The files are keyed by the loaded SPICE kernels, the settings of the
+/// EphemerisCache, the center and the target anchor and the time span of the block, so restarts
+/// and jumps back in time can load the samples from disk instead of querying SPICE again. The
+/// cache directory is not limited in size.
+///
+/// Most components should not create their own sampler but use the process-wide instance returned
+/// by TrajectorySampler::get().
+class CS_SCENE_EXPORT TrajectorySampler {
+ public:
+  /// The number of samples which are computed and cached together.
+  static constexpr std::size_t BLOCK_SIZE = 256;
+
+  /// Describes the samples to compute. Sample i is taken at mOffset + i * mStep, clamped to the
+  /// existence interval. The positions are the positions of mTarget relative to mCenter, as
+  /// returned by CelestialAnchor::getRelativePosition().
+  struct Request {
+    CelestialAnchor mCenter;
+    CelestialAnchor mTarget;
+
+    double      mOffset{};
+    double      mStep{1.0};
+    int64_t     mFirst{};
+    std::size_t mCount{};
+    glm::dvec2  mExistence{
+        std::numeric_limits<double>::lowest(), std::numeric_limits<double>::max()};
+
+    /// If false, the blocks are neither loaded from nor stored in the cache directory. This should
+    /// be used for one-off requests whose grid is unlikely to be requested again.
+    bool mUseCache{true};
+  };
+
+  /// Some statistics which may be useful for debugging and benchmarking. All counters are
+  /// accumulated since the last call to clear().
+  struct Statistics {
+    /// The number of blocks which have been computed using SPICE.
+    uint64_t mSampledBlocks = 0;
+
+    /// The number of blocks which have been loaded from the cache directory.
+    uint64_t mLoadedBlocks = 0;
+  };
+
+  /// A Job is returned by sample(). Its points become available all at once when all blocks have
+  /// been computed, so the old points can be used until then.
+  class CS_SCENE_EXPORT Job {
+   public:
+    /// Returns true if the points are available.
+    bool isReady() const;
+
+    /// Blocks until the points are available.
+    void wait() const;
+
+    /// Prevents blocks which have not been started yet from being computed. This is useful if the
+    /// points are not needed anymore. The samples of skipped blocks are NaN.
+    void cancel();
+
+    /// Returns the computed points. The fourth component of each point contains the time of the
+    /// sample. If a sample could not be computed, for instance due to insufficient SPICE data, its
+    /// components are NaN. This must only be called once the job is ready.
+    std::vector<glm::dvec4> const& getPoints() const;
+
+   private:
+    friend class TrajectorySampler;
+
+    std::vector<glm::dvec4>  mPoints;
+    std::atomic<std::size_t> mPendingBlocks{0};
+    std::atomic<bool>        mCancelled{false};
+    std::promise<void>       mPromise;
+    std::shared_future<void> mDone;
+  };
+
+  TrajectorySampler() = default;
+
+  TrajectorySampler(TrajectorySampler const& other) = delete;
+  TrajectorySampler(TrajectorySampler&& other)      = delete;
+
+  TrajectorySampler& operator=(TrajectorySampler const& other) = delete;
+  TrajectorySampler& operator=(TrajectorySampler&& other)      = delete;
+
+  ~TrajectorySampler() = default;
+
+  /// Returns the process-wide shared instance.
+  static TrajectorySampler& get();
+
+  /// Blocks are stored in this directory. It is created if it does not exist. If it is empty, no
+  /// blocks are cached on disk.
+  void        setCacheDirectory(std::string const& directory);
+  std::string getCacheDirectory() const;
+
+  /// This has to be called whenever different SPICE kernels are loaded. The key of the loaded
+  /// kernels is recomputed then and the statistics are reset.
+  void clear();
+
+  /// Starts computing the requested samples on the ThreadPool.
+  std::shared_ptr<Job> sample(Request const& request);
+
+  /// Computes the requested samples on the calling thread. In contrast to sample(), this does not
+  /// have to wait for other jobs on the ThreadPool, and it uses the cache directory as well.
+  std::vector<glm::dvec4> sampleNow(Request const& request);
+
+  Statistics getStatistics() const;
+
+ private:
+  /// Returns a string which identifies the currently loaded SPICE kernels, including their sizes
+  /// and modification times.
+  std::string getKernelKey();
+
+  /// Returns a string which identifies the given block of the given request.
+  static std::string getBlockKey(
+      std::string const& kernelKey, Request const& request, int64_t block);
+
+  static bool loadBlock(
+      std::string const& file, std::string const& key, std::vector<glm::dvec4>& points);
+  static void saveBlock(
+      std::string const& file, std::string const& key, std::vector<glm::dvec4> const& points);
+
+  /// Loads the given block from the cache directory or samples it if it is not cached yet. If
+  /// directory is empty, the block is always sampled.
+  std::vector<glm::dvec4> getBlock(Request const& request, int64_t block,
+      std::string const& directory, std::string const& kernelKey);
+
+  /// Copies the samples of the given block which are part of the request to points.
+  static void copyBlock(Request const& request, int64_t block,
+      std::vector<glm::dvec4> const& blockPoints, std::vector<glm::dvec4>& points);
+
+  static std::vector<glm::dvec4> sampleBlock(Request const& request, int64_t block);
+
+  mutable std::mutex mMutex;
+  std::string        mCacheDirectory;
+  std::string        mKernelKey;
+
+  std::atomic<uint64_t> mSampledBlocks{0};
+  std::atomic<uint64_t> mLoadedBlocks{0};
+
+  // This has to be the last member, so that all tasks have finished before the other members are
+  // destroyed.
+  utils::TaskGroup mTasks;
+};
+
+} // namespace cs::scene
+
+#endif // CS_SCENE_TRAJECTORY_SAMPLER_HPP
@@ -10,19 +10,121 @@
 #include "logger.hpp"
 
 #include <GL/glew.h>
+#include <algorithm>
 #include <thread>
 #include <utility>
 
 namespace cs::utils {
 
+namespace {
+
+// This is set by FrameStats::startFrame(). All other threads record their ranges in a ring buffer.
+thread_local bool tIsMainThread = false;
+
+int64_t getCPUTime() {
+  return std::chrono::high_resolution_clock::now().time_since_epoch().count();
+}
+
+// A single-producer, single-consumer ring buffer. push() is only called by the owning thread,
+// collect() only by the main thread. If the buffer is full, pushed items are dropped.
+template <typename T>
+class RingBuffer {
+ public:
+  void push(T const& item) {
+    auto written = mWritten.load(std::memory_order_relaxed);
+    if (written - mRead.load(std::memory_order_acquire) < FrameStats::THREAD_TIMER_CAPACITY) {
+      mItems[written % FrameStats::THREAD_TIMER_CAPACITY] = item;
+      mWritten.store(written + 1, std::memory_order_release);
+    }
+  }
+
+  template <typename Callback>
+  void collect(Callback const& callback) {
+    auto read    = mRead.load(std::memory_order_relaxed);
+    auto written = mWritten.load(std::memory_order_acquire);
+
+    for (auto i = read; i < written; ++i) {
+      callback(mItems[i % FrameStats::THREAD_TIMER_CAPACITY]);
+    }
+
+    mRead.store(written, std::memory_order_release);
+  }
+
+ private:
+  std::array<T, FrameStats::THREAD_TIMER_CAPACITY> mItems{};
+
+  // The items in [mRead, mWritten) have been pushed but not collected yet.
+  std::atomic<uint64_t> mWritten{0};
+  std::atomic<uint64_t> mRead{0};
+};
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct FrameStats::ThreadTimers {
+  struct Range {
+    NameID   mName;
+    uint32_t mNestingLevel;
+    int64_t  mCPUStart;
+    int64_t  mCPUEnd;
+  };
+
+  RingBuffer<Range>     mRanges;
+  RingBuffer<FlowEvent> mFlowEvents;
+
+  // These are only accessed by the owning thread.
+  uint32_t mThread{};
+  uint32_t mNestingLevel{};
+
+  // This is set when the owning thread exits. The ring buffers are then removed once they have been
+  // collected completely.
+  std::atomic<bool> mFinished{false};
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-FrameStats::ScopedTimer::ScopedTimer(std::string name, TimerMode mode)
-    : mID(FrameStats::get().startTimerQuery(std::move(name), mode)) {
+FrameStats::ScopedTimer::ScopedTimer(std::string const& name, TimerMode mode) {
+
+  // Registering the name requires a lock, so this is skipped if nothing is measured.
+  auto& frameStats = FrameStats::get();
+  if (frameStats.getMeasurementsEnabled()) {
+    mName = frameStats.registerName(name);
+
+    if (tIsMainThread) {
+      mID = frameStats.startTimerQuery(mName, mode);
+    } else {
+      ++frameStats.getThreadTimers().mNestingLevel;
+      mID       = THREAD_RANGE_ID;
+      mCPUStart = getCPUTime();
+    }
+  }
+}
+
+FrameStats::ScopedTimer::ScopedTimer(NameID name, TimerMode mode)
+    : mName(name) {
+
+  auto& frameStats = FrameStats::get();
+  if (frameStats.getMeasurementsEnabled()) {
+    if (tIsMainThread) {
+      mID = frameStats.startTimerQuery(mName, mode);
+    } else {
+      ++frameStats.getThreadTimers().mNestingLevel;
+      mID       = THREAD_RANGE_ID;
+      mCPUStart = getCPUTime();
+    }
+  }
 }
 
 FrameStats::ScopedTimer::~ScopedTimer() {
-  FrameStats::get().endTimerQuery(mID);
+  if (mID == THREAD_RANGE_ID) {
+    auto  cpuEnd = getCPUTime();
+    auto& timers = FrameStats::get().getThreadTimers();
+    --timers.mNestingLevel;
+    timers.mRanges.push({mName, timers.mNestingLevel, mCPUStart, cpuEnd});
+  } else if (mID >= 0) {
+    FrameStats::get().endTimerQuery(mID);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -55,9 +157,46 @@ FrameStats& FrameStats::get() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 FrameStats::FrameStats() {
-  pEnableMeasurements.connectAndTouch([this](bool enable) {
+  mFullFrameTimingName = registerName("Process Frame");
+
+  pEnableMeasurements.connectAndTouch([this](bool enable) { mEnabled = enable; });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrameStats::NameID FrameStats::registerName(std::string const& name) {
+  std::unique_lock<std::mutex> lock(mNamesMutex);
+
+  auto id = mNameIDs.find(name);
+  if (id != mNameIDs.end()) {
+    return id->second;
+  }
+
+  auto newID = static_cast<NameID>(mNames.size());
+  mNames.push_back(name);
+  mNameIDs.emplace(mNames.back(), newID);
+
+  return newID;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool FrameStats::getMeasurementsEnabled() const {
+  return mEnabled.load(std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameStats::startFrame() {
+  tIsMainThread = true;
+
+  // The pools are recreated if pEnableMeasurements has been toggled. This is done here and not in
+  // the property's callback, so that all ranges of a frame end up in the same pool.
+  if (!mQueryPools[0] || mQueryPoolsEnabled != getMeasurementsEnabled()) {
+    mQueryPoolsEnabled = getMeasurementsEnabled();
+
     for (auto& pool : mQueryPools) {
-      if (enable) {
+      if (mQueryPoolsEnabled) {
         pool = std::make_unique<QueryPool>(512);
       } else {
         // If measurements are disabled, we need at most two query objects, one for the start of the
@@ -65,12 +204,7 @@ FrameStats::FrameStats() {
         pool = std::make_unique<QueryPool>(2);
       }
     }
-  });
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void FrameStats::startFrame() {
+  }
 
   // Advance the timer pool triple-buffer by one.
   mCurrentQueryPool = (mCurrentQueryPool + 1) % mQueryPools.size();
@@ -80,6 +214,19 @@ void FrameStats::startFrame() {
   auto oldestPool = (mCurrentQueryPool + 1) % mQueryPools.size();
   mQueryPools.at(oldestPool)->fetchQueries();
 
+  // The ranges only store the IDs of their names. The names are looked up once per frame, so that
+  // the mutex does not have to be locked for each range.
+  {
+    std::unique_lock<std::mutex> lock(mNamesMutex);
+    for (auto& result : mQueryPools.at(oldestPool)->getTimerQueryResults()) {
+      result.mName = mNames[result.mNameID];
+    }
+
+    for (auto& event : mQueryPools.at(oldestPool)->getFlowEvents()) {
+      event.mName = mNames[event.mNameID];
+    }
+  }
+
   // Retrieve the pFrameTime from the oldest pool as well.
   double const toMilliSeconds = 0.000001;
   auto const&  timerResults   = mQueryPools.at(oldestPool)->getTimerQueryResults();
@@ -96,7 +243,7 @@ void FrameStats::startFrame() {
 
   // Start the "root" full frame timing. This is always done, even if pEnableMeasurements is set to
   // false. This is required to get data for the pFrameTime property.
-  mFullFrameTimingID = pool->startTimerQuery("Process Frame", FrameStats::TimerMode::eBoth);
+  mFullFrameTimingID = pool->startTimerQuery(mFullFrameTimingName, FrameStats::TimerMode::eBoth);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -106,15 +253,46 @@ void FrameStats::endFrame() {
   // End the "root" full frame timing. This is always done, even if pEnableMeasurements is set to
   // false. This is required to get data for the pFrameTime property.
   mQueryPools.at(mCurrentQueryPool)->endTimerQuery(mFullFrameTimingID);
+
+  // Append the ranges which have been recorded by other threads during this frame. They are
+  // discarded if measurements are disabled for this frame.
+  collectThreadTimers(mThreadRanges, mThreadFlowEvents);
+
+  if (mQueryPoolsEnabled) {
+    auto const& pool = mQueryPools.at(mCurrentQueryPool);
+
+    for (auto const& range : mThreadRanges) {
+      pool->addThreadTimerResult(range);
+    }
+
+    for (auto const& event : mThreadFlowEvents) {
+      pool->addFlowEvent(event);
+    }
+  }
+
+  mThreadRanges.clear();
+  mThreadFlowEvents.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int32_t FrameStats::startTimerQuery(std::string const& name, FrameStats::TimerMode mode) {
+
+  // Only attempt to start the timing if measurements are enabled for the current frame.
+  if (mQueryPoolsEnabled) {
+    return startTimerQuery(registerName(name), mode);
+  }
+
+  return -1;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int32_t FrameStats::startTimerQuery(std::string name, FrameStats::TimerMode mode) {
+int32_t FrameStats::startTimerQuery(NameID name, FrameStats::TimerMode mode) {
 
-  // Only attempt to start the timing if pEnableMeasurements is set to true.
-  if (pEnableMeasurements.get()) {
-    return mQueryPools.at(mCurrentQueryPool)->startTimerQuery(std::move(name), mode);
+  // Only attempt to start the timing if measurements are enabled for the current frame.
+  if (mQueryPoolsEnabled) {
+    return mQueryPools.at(mCurrentQueryPool)->startTimerQuery(name, mode);
   }
 
   return -1;
@@ -124,8 +302,8 @@ int32_t FrameStats::startTimerQuery(std::string name, FrameStats::TimerMode mode
 
 int32_t FrameStats::startSamplesQuery(std::string name) {
 
-  // Only attempt to start the counting if pEnableMeasurements is set to true.
-  if (pEnableMeasurements.get()) {
+  // Only attempt to start the counting if measurements are enabled for the current frame.
+  if (mQueryPoolsEnabled) {
     return mQueryPools.at(mCurrentQueryPool)->startSamplesQuery(std::move(name));
   }
 
@@ -136,8 +314,8 @@ int32_t FrameStats::startSamplesQuery(std::string name) {
 
 int32_t FrameStats::startPrimitivesQuery(std::string name) {
 
-  // Only attempt to start the counting if pEnableMeasurements is set to true.
-  if (pEnableMeasurements.get()) {
+  // Only attempt to start the counting if measurements are enabled for the current frame.
+  if (mQueryPoolsEnabled) {
     return mQueryPools.at(mCurrentQueryPool)->startPrimitivesQuery(std::move(name));
   }
 
@@ -148,8 +326,8 @@ int32_t FrameStats::startPrimitivesQuery(std::string name) {
 
 void FrameStats::endTimerQuery(int32_t id) {
 
-  // Only attempt to end the timing if pEnableMeasurements is set to true.
-  if (pEnableMeasurements.get()) {
+  // Only attempt to end the timing if measurements are enabled for the current frame.
+  if (mQueryPoolsEnabled) {
     mQueryPools.at(mCurrentQueryPool)->endTimerQuery(id);
   }
 }
@@ -158,8 +336,8 @@ void FrameStats::endTimerQuery(int32_t id) {
 
 void FrameStats::endSamplesQuery(int32_t id) {
 
-  // Only attempt to end the counting if pEnableMeasurements is set to true.
-  if (pEnableMeasurements.get()) {
+  // Only attempt to end the counting if measurements are enabled for the current frame.
+  if (mQueryPoolsEnabled) {
     mQueryPools.at(mCurrentQueryPool)->endSamplesQuery(id);
   }
 }
@@ -168,18 +346,152 @@ void FrameStats::endSamplesQuery(int32_t id) {
 
 void FrameStats::endPrimitivesQuery(int32_t id) {
 
-  // Only attempt to end the counting if pEnableMeasurements is set to true.
-  if (pEnableMeasurements.get()) {
+  // Only attempt to end the counting if measurements are enabled for the current frame.
+  if (mQueryPoolsEnabled) {
     mQueryPools.at(mCurrentQueryPool)->endPrimitivesQuery(id);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void FrameStats::addValue(std::string const& name, int64_t value) {
+
+  // Only attempt to count if measurements are enabled for the current frame.
+  if (mQueryPoolsEnabled) {
+    mQueryPools.at(mCurrentQueryPool)->addValue(name, value);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrameStats::ThreadTimers& FrameStats::getThreadTimers() {
+
+  // The ring buffer is shared with mThreadTimers, so that the ranges recorded shortly before the
+  // thread exits can still be collected.
+  struct Handle {
+    std::shared_ptr<ThreadTimers> mTimers;
+
+    Handle()                    = default;
+    Handle(Handle const& other) = delete;
+    Handle(Handle&& other)      = delete;
+
+    Handle& operator=(Handle const& other) = delete;
+    Handle& operator=(Handle&& other)      = delete;
+
+    ~Handle() {
+      if (mTimers) {
+        mTimers->mFinished = true;
+      }
+    }
+  };
+
+  thread_local Handle handle;
+
+  if (!handle.mTimers) {
+    handle.mTimers = std::make_shared<ThreadTimers>();
+
+    std::unique_lock<std::mutex> lock(mThreadTimersMutex);
+    handle.mTimers->mThread = mNextThreadIndex++;
+    mThreadTimers.push_back(handle.mTimers);
+  }
+
+  return *handle.mTimers;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameStats::collectThreadTimers(
+    std::vector<TimerQueryResult>& ranges, std::vector<FlowEvent>& events) {
+  auto firstRange = ranges.size();
+  auto firstEvent = events.size();
+
+  std::unique_lock<std::mutex> lock(mThreadTimersMutex);
+
+  for (auto& timers : mThreadTimers) {
+
+    // This has to be loaded before the ring buffers are collected. Else the thread could record
+    // another range and exit in between, and the range would be lost.
+    bool finished = timers->mFinished.load(std::memory_order_acquire);
+
+    timers->mRanges.collect([&](ThreadTimers::Range const& range) {
+      TimerQueryResult result;
+      result.mMode         = TimerMode::eCPU;
+      result.mNameID       = range.mName;
+      result.mThread       = timers->mThread;
+      result.mNestingLevel = range.mNestingLevel;
+      result.mCPUStart     = range.mCPUStart;
+      result.mCPUEnd       = range.mCPUEnd;
+      ranges.push_back(result);
+    });
+
+    timers->mFlowEvents.collect([&](FlowEvent const& event) { events.push_back(event); });
+
+    // Mark the ring buffers of exited threads for removal.
+    if (finished) {
+      timers.reset();
+    }
+  }
+
+  mThreadTimers.erase(std::remove(mThreadTimers.begin(), mThreadTimers.end(), nullptr),
+      mThreadTimers.end());
+
+  lock.unlock();
+
+  // The ring buffers only store the IDs of the names.
+  std::unique_lock<std::mutex> namesLock(mNamesMutex);
+
+  for (auto i = firstRange; i < ranges.size(); ++i) {
+    ranges[i].mName = mNames[ranges[i].mNameID];
+  }
+
+  for (auto i = firstEvent; i < events.size(); ++i) {
+    events[i].mName = mNames[events[i].mNameID];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t FrameStats::createFlowID() {
+  return ++mLastFlowID;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameStats::addFlowEvent(NameID name, uint64_t id, FlowPhase phase) {
+  if (!getMeasurementsEnabled()) {
+    return;
+  }
+
+  FlowEvent event;
+  event.mNameID = name;
+  event.mID     = id;
+  event.mPhase  = phase;
+  event.mTime   = getCPUTime();
+
+  if (tIsMainThread) {
+    if (mQueryPoolsEnabled) {
+      mQueryPools.at(mCurrentQueryPool)->addFlowEvent(event);
+    }
+  } else {
+    auto& timers  = getThreadTimers();
+    event.mThread = timers.mThread;
+    timers.mFlowEvents.push(event);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::vector<FrameStats::TimerQueryResult> const& FrameStats::getTimerQueryResults() {
 
   // We return the ranges from the last-but-one frame.
   auto oldestPool = (mCurrentQueryPool + 1) % mQueryPools.size();
+
+  // The pools are only created with the first frame.
+  if (!mQueryPools.at(oldestPool)) {
+    static const std::vector<FrameStats::TimerQueryResult> empty;
+    return empty;
+  }
+
   return mQueryPools.at(oldestPool)->getTimerQueryResults();
 }
 
@@ -189,6 +501,13 @@ std::vector<FrameStats::CounterQueryResult> const& FrameStats::getSamplesQueryRe
 
   // We return the ranges from the last-but-one frame.
   auto oldestPool = (mCurrentQueryPool + 1) % mQueryPools.size();
+
+  // The pools are only created with the first frame.
+  if (!mQueryPools.at(oldestPool)) {
+    static const std::vector<FrameStats::CounterQueryResult> empty;
+    return empty;
+  }
+
   return mQueryPools.at(oldestPool)->getSamplesQueryResults();
 }
 
@@ -198,15 +517,55 @@ std::vector<FrameStats::CounterQueryResult> const& FrameStats::getPrimitivesQuer
 
   // We return the ranges from the last-but-one frame.
   auto oldestPool = (mCurrentQueryPool + 1) % mQueryPools.size();
+
+  // The pools are only created with the first frame.
+  if (!mQueryPools.at(oldestPool)) {
+    static const std::vector<FrameStats::CounterQueryResult> empty;
+    return empty;
+  }
+
   return mQueryPools.at(oldestPool)->getPrimitivesQueryResults();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::vector<FrameStats::CounterQueryResult> const& FrameStats::getValueCounterResults() {
+
+  // We return the values from the last-but-one frame.
+  auto oldestPool = (mCurrentQueryPool + 1) % mQueryPools.size();
+
+  // The pools are only created with the first frame.
+  if (!mQueryPools.at(oldestPool)) {
+    static const std::vector<FrameStats::CounterQueryResult> empty;
+    return empty;
+  }
+
+  return mQueryPools.at(oldestPool)->getValueCounterResults();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<FrameStats::FlowEvent> const& FrameStats::getFlowEvents() {
+
+  // We return the events from the last-but-one frame.
+  auto oldestPool = (mCurrentQueryPool + 1) % mQueryPools.size();
+
+  // The pools are only created with the first frame.
+  if (!mQueryPools.at(oldestPool)) {
+    static const std::vector<FrameStats::FlowEvent> empty;
+    return empty;
+  }
+
+  return mQueryPools.at(oldestPool)->getFlowEvents();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 QueryPool::QueryPool(std::size_t queryAllocationBucketSize)
     : mQueryAllocationBucketSize(queryAllocationBucketSize) {
 
   mTimerQueries.mQueries.resize(mQueryAllocationBucketSize);
+  mTimerQueryResults.reserve(mQueryAllocationBucketSize);
   mSamplesQueries.mQueries.resize(mQueryAllocationBucketSize);
   mPrimitivesQueries.mQueries.resize(mQueryAllocationBucketSize);
 
@@ -232,6 +591,8 @@ void QueryPool::reset() {
   mTimerQueryResults.clear();
   mSamplesQueryResults.clear();
   mPrimitivesQueryResults.clear();
+  mValueCounterResults.clear();
+  mFlowEvents.clear();
 
   mTimerQueries.mNextID      = 0;
   mSamplesQueries.mNextID    = 0;
@@ -242,11 +603,11 @@ void QueryPool::reset() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-int32_t QueryPool::startTimerQuery(std::string name, FrameStats::TimerMode mode) {
+int32_t QueryPool::startTimerQuery(FrameStats::NameID name, FrameStats::TimerMode mode) {
 
   FrameStats::TimerQueryResult result;
   result.mMode         = mode;
-  result.mName         = std::move(name);
+  result.mNameID       = name;
   result.mNestingLevel = mCurrentNestingLevel++;
 
   // Start the GPU result if necessary.
@@ -256,10 +617,10 @@ int32_t QueryPool::startTimerQuery(std::string name, FrameStats::TimerMode mode)
 
   // Start the CPU result if necessary.
   if (mode == FrameStats::TimerMode::eCPU || mode == FrameStats::TimerMode::eBoth) {
-    result.mCPUStart = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    result.mCPUStart = getCPUTime();
   }
 
-  mTimerQueryResults.push_back(std::move(result));
+  mTimerQueryResults.push_back(result);
 
   // Return the index at which this result was inserted.
   return static_cast<int32_t>(mTimerQueryResults.size() - 1);
@@ -309,8 +670,7 @@ void QueryPool::endTimerQuery(int32_t id) {
   // End the CPU range if necessary.
   if (mTimerQueryResults[id].mMode == FrameStats::TimerMode::eCPU ||
       mTimerQueryResults[id].mMode == FrameStats::TimerMode::eBoth) {
-    mTimerQueryResults[id].mCPUEnd =
-        std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    mTimerQueryResults[id].mCPUEnd = getCPUTime();
   }
 
   --mCurrentNestingLevel;
@@ -342,6 +702,36 @@ void QueryPool::endPrimitivesQuery(int32_t id) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void QueryPool::addValue(std::string const& name, int64_t value) {
+
+  // There are usually only a few value counters, so a linear search is fine here.
+  auto counter = std::find_if(mValueCounterResults.begin(), mValueCounterResults.end(),
+      [&name](auto const& result) { return result.mName == name; });
+
+  if (counter != mValueCounterResults.end()) {
+    counter->mCount += value;
+  } else {
+    FrameStats::CounterQueryResult result;
+    result.mName  = name;
+    result.mCount = value;
+    mValueCounterResults.push_back(std::move(result));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void QueryPool::addThreadTimerResult(FrameStats::TimerQueryResult const& result) {
+  mTimerQueryResults.push_back(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void QueryPool::addFlowEvent(FrameStats::FlowEvent const& event) {
+  mFlowEvents.push_back(event);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void QueryPool::fetchQueries() {
 
   // Wait for the last query to finish.
@@ -380,6 +770,12 @@ std::vector<FrameStats::TimerQueryResult> const& QueryPool::getTimerQueryResults
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::vector<FrameStats::TimerQueryResult>& QueryPool::getTimerQueryResults() {
+  return mTimerQueryResults;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::vector<FrameStats::CounterQueryResult> const& QueryPool::getSamplesQueryResults() const {
   return mSamplesQueryResults;
 }
@@ -392,6 +788,24 @@ std::vector<FrameStats::CounterQueryResult> const& QueryPool::getPrimitivesQuery
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::vector<FrameStats::CounterQueryResult> const& QueryPool::getValueCounterResults() const {
+  return mValueCounterResults;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<FrameStats::FlowEvent> const& QueryPool::getFlowEvents() const {
+  return mFlowEvents;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<FrameStats::FlowEvent>& QueryPool::getFlowEvents() {
+  return mFlowEvents;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::size_t QueryPool::startTimerQuery() {
   if (mTimerQueries.mNextID >= mTimerQueries.mQueries.size()) {
     auto currentSize = mTimerQueries.mQueries.size();
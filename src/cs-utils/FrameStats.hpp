@@ -12,9 +12,14 @@
 #include "cs_utils_export.hpp"
 
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -30,8 +35,28 @@ class QueryPool;
 /// measuring range in its constructor and and end the range in its destructor.
 /// The ScopedSamplesCounter and the ScopedPrimitivesCounter do not support nesting, so you have to
 /// ensure that you do not start two of them at the same time.
+///
+/// Timer names are interned: registerName() returns an ID which can be passed to the ScopedTimer
+/// instead of a string. Code which is executed every frame should register its names once and
+/// reuse the IDs, so that no strings have to be built just for the sake of measuring.
+///
+/// ScopedTimers may also be used on other threads than the main thread. There, only the CPU time
+/// is measured. The ranges are stored in a fixed-size, lock-free ring buffer per thread and
+/// collected by the main thread at the end of each frame. If a thread records more than
+/// THREAD_TIMER_CAPACITY ranges during one frame, the surplus ranges are dropped.
+///
+/// Flow events can be used to link ranges which belong to the same piece of work, even if they are
+/// recorded on different threads or in different frames. For instance, a tile may be requested on
+/// the main thread, loaded on a worker thread and uploaded to the GPU on the main thread a few
+/// frames later.
 class CS_UTILS_EXPORT FrameStats {
  public:
+  /// The ID of an interned timer name. See registerName().
+  using NameID = uint32_t;
+
+  /// The maximum number of ranges a thread other than the main thread can record per frame.
+  static constexpr std::size_t THREAD_TIMER_CAPACITY = 1024;
+
   /// Defines which timings should be measured.
   enum class TimerMode {
     eCPU, ///< Only the CPU time will be measured.
@@ -44,10 +69,19 @@ class CS_UTILS_EXPORT FrameStats {
   struct TimerQueryResult {
 
     /// The name of the range as it was passed to the constructor of the ScopedTimer or the
-    /// FrameStats::startRange() method.
-    std::string mName;
+    /// FrameStats::startTimerQuery() method. The referenced string is owned by the FrameStats
+    /// singleton and stays valid until the application exits.
+    std::string_view mName;
+
+    /// The interned ID of mName.
+    NameID mNameID{};
 
-    /// This contains the number of timing ranges which were active when this range was started.
+    /// The thread on which this range was recorded. The main thread has index zero, all other
+    /// threads are numbered in the order in which they recorded their first range.
+    uint32_t mThread{};
+
+    /// This contains the number of timing ranges which were active on the same thread when this
+    /// range was started.
     uint32_t mNestingLevel{};
 
     /// Timestamps in nanoseconds when the range started / ended on the CPU / GPU. They will be
@@ -66,6 +100,32 @@ class CS_UTILS_EXPORT FrameStats {
     std::size_t mEndQueryIndex{};
   };
 
+  /// Defines the position of a FlowEvent in its flow.
+  enum class FlowPhase {
+    eBegin, ///< The first event of a flow.
+    eStep,  ///< An intermediate event of a flow.
+    eEnd    ///< The last event of a flow.
+  };
+
+  /// A FlowEvent is recorded with addFlowEvent() and is returned by getFlowEvents().
+  struct FlowEvent {
+
+    /// The name of the event. The referenced string is owned by the FrameStats singleton and stays
+    /// valid until the application exits.
+    std::string_view mName;
+    NameID           mNameID{};
+
+    /// All events with the same ID belong to the same flow.
+    uint64_t  mID{};
+    FlowPhase mPhase{};
+
+    /// The thread on which this event was recorded. See TimerQueryResult::mThread.
+    uint32_t mThread{};
+
+    /// The CPU timestamp in nanoseconds.
+    int64_t mTime{};
+  };
+
   /// This struct contains information on one specific counting range. It is used internally by the
   /// FrameStats singleton and is returned by the getSamplesQueryResults and
   /// mgetPrimitivesQueryResults methods.
@@ -80,8 +140,14 @@ class CS_UTILS_EXPORT FrameStats {
   class CS_UTILS_EXPORT ScopedTimer {
    public:
     /// @param name The name of the counter.
-    /// @param mode The mode of querying. See CounterMode for more info.
-    explicit ScopedTimer(std::string name, TimerMode mode = TimerMode::eBoth);
+    /// @param mode The mode of querying. See CounterMode for more info. On other threads than the
+    ///             main thread, this is ignored and only the CPU time is measured.
+    explicit ScopedTimer(std::string const& name, TimerMode mode = TimerMode::eBoth);
+
+    /// This does the same as the constructor above, but uses a name which has been registered with
+    /// FrameStats::registerName() before. This does not allocate any memory and should be preferred
+    /// for code which is executed every frame.
+    explicit ScopedTimer(NameID name, TimerMode mode = TimerMode::eBoth);
 
     ScopedTimer(ScopedTimer const& other) = delete;
     ScopedTimer(ScopedTimer&& other)      = delete;
@@ -92,7 +158,13 @@ class CS_UTILS_EXPORT FrameStats {
     ~ScopedTimer();
 
    private:
-    int32_t mID;
+    // This is >= 0 for ranges recorded on the main thread, THREAD_RANGE_ID for ranges recorded on
+    // other threads and -1 if nothing is measured.
+    static constexpr int32_t THREAD_RANGE_ID = -2;
+
+    int32_t mID       = -1;
+    NameID  mName     = 0;
+    int64_t mCPUStart = 0;
   };
 
   /// A ScopedSamplesCounter is responsible for counting generated fragments during its entire
@@ -152,19 +224,31 @@ class CS_UTILS_EXPORT FrameStats {
 
   ~FrameStats() = default;
 
+  /// Returns the ID of the given timer name. If the name has not been registered before, a new ID
+  /// is created. This is thread-safe; the same name always yields the same ID.
+  NameID registerName(std::string const& name);
+
+  /// Returns true if pEnableMeasurements is set to true. Other than pEnableMeasurements.get(), this
+  /// can be called from any thread.
+  bool getMeasurementsEnabled() const;
+
   /// Starts the time measurement for the current frame. No need to call this manually; the
-  /// application is responsible for this.
+  /// application is responsible for this. The thread which calls this is considered to be the main
+  /// thread.
   void startFrame();
 
-  /// Ends the time measurement for the current frame. No need to call this manually; the
-  /// application is responsible for this.
+  /// Ends the time measurement for the current frame. This also collects the ranges recorded on all
+  /// other threads since the last frame. No need to call this manually; the application is
+  /// responsible for this.
   void endFrame();
 
   /// Starts a timer / counter with the given name and mode. You can use this interface, however the
   /// ScopedTimer, ScopedSamplesCounter, and ScopedPrimitivesCounter are often more easy to use. The
   /// returned ID will be >= 0 if the timing range was actually started and -1 if
-  /// pEnableMeasurements is set to false.
-  int32_t startTimerQuery(std::string name, TimerMode mode = TimerMode::eBoth);
+  /// pEnableMeasurements is set to false. These must only be called on the main thread; use a
+  /// ScopedTimer for measuring on other threads.
+  int32_t startTimerQuery(std::string const& name, TimerMode mode = TimerMode::eBoth);
+  int32_t startTimerQuery(NameID name, TimerMode mode = TimerMode::eBoth);
   int32_t startSamplesQuery(std::string name);
   int32_t startPrimitivesQuery(std::string name);
 
@@ -174,27 +258,81 @@ class CS_UTILS_EXPORT FrameStats {
   void endSamplesQuery(int32_t id);
   void endPrimitivesQuery(int32_t id);
 
+  /// Adds the given value to the value counter with the given name. Other than the samples and
+  /// primitives counters, value counters do not query the GPU. Instead, all values added with the
+  /// same name during one frame are summed up. This can be used to track quantities like the number
+  /// of bytes uploaded to the GPU. This does nothing if pEnableMeasurements is set to false.
+  void addValue(std::string const& name, int64_t value);
+
+  /// Returns a new ID for a flow of events. This can be called from any thread.
+  uint64_t createFlowID();
+
+  /// Records an event of the flow with the given ID. Events should be recorded within a timing
+  /// range, as trace viewers usually attach them to the enclosing range. This can be called from
+  /// any thread and does nothing if pEnableMeasurements is set to false.
+  void addFlowEvent(NameID name, uint64_t id, FlowPhase phase);
+
   /// This will retrieve the recorded results from the last-but-one frame. This is to prevent any
   /// synchronization between CPU and GPU: In one frame timings are recorded and queries are
   /// dispatched, then we wait one full frame until we attempt to read the query results. Then, in
   /// the third frame the results are available via this method.
   /// This will always contain at least one range for the entire frame. If pEnableMeasurements is
-  /// set to true, it will contain all timing results created by all ScopedTimers. It may contain
-  /// incomplete data for the frames in which pEnableMeasurements was toggled.
+  /// set to true, it will contain all timing results created by all ScopedTimers. The ranges of
+  /// the main thread come first, followed by the ranges of all other threads which ended during
+  /// the frame. It may contain incomplete data for the frames in which pEnableMeasurements was
+  /// toggled.
   std::vector<TimerQueryResult> const&   getTimerQueryResults();
   std::vector<CounterQueryResult> const& getSamplesQueryResults();
   std::vector<CounterQueryResult> const& getPrimitivesQueryResults();
+  std::vector<CounterQueryResult> const& getValueCounterResults();
+  std::vector<FlowEvent> const&          getFlowEvents();
+
+  /// Moves all ranges and flow events which have been recorded by other threads than the main
+  /// thread since the last call to the given vectors. This is called by endFrame(), so usually
+  /// there is no need to call this manually. The ranges and events are appended in the order in
+  /// which they have been recorded on each thread.
+  void collectThreadTimers(std::vector<TimerQueryResult>& ranges, std::vector<FlowEvent>& events);
 
  private:
+  /// The ranges recorded by one thread other than the main thread. It is defined in the source
+  /// file.
+  struct ThreadTimers;
+
   /// You should not need to instantiate this class. One singleton instance can be created with the
   /// static get() method above.
   FrameStats();
 
-  /// We have a triple-buffer of QueryPools.
+  /// Returns the ring buffer of the calling thread. It is created on first use.
+  ThreadTimers& getThreadTimers();
+
+  /// We have a triple-buffer of QueryPools. They are created lazily in startFrame(), as they
+  /// require an OpenGL context.
   std::array<std::unique_ptr<QueryPool>, 3> mQueryPools;
   int32_t                                   mCurrentQueryPool{};
+  bool                                      mQueryPoolsEnabled{};
 
   int32_t mFullFrameTimingID{};
+  NameID  mFullFrameTimingName{};
+
+  // pEnableMeasurements is not thread-safe, so its value is mirrored here.
+  std::atomic<bool> mEnabled{false};
+
+  std::atomic<uint64_t> mLastFlowID{0};
+
+  // The interned timer names. The strings in mNames never move, so that mNameIDs and the results
+  // can refer to them.
+  std::mutex                                   mNamesMutex;
+  std::deque<std::string>                      mNames;
+  std::unordered_map<std::string_view, NameID> mNameIDs;
+
+  // The ring buffers of all threads which recorded ranges so far.
+  std::mutex                                 mThreadTimersMutex;
+  std::vector<std::shared_ptr<ThreadTimers>> mThreadTimers;
+  uint32_t                                   mNextThreadIndex{1};
+
+  // The ranges and events collected by endFrame(). They are kept to avoid reallocations.
+  std::vector<TimerQueryResult> mThreadRanges;
+  std::vector<FlowEvent>        mThreadFlowEvents;
 };
 
 /// The QueryPool is used in a triple-buffer fashion internally by the FrameStats class. You
@@ -219,7 +357,7 @@ class CS_UTILS_EXPORT QueryPool {
 
   /// Starts a new query. The returned integer will always be >= 0 and can be used to end the
   /// range with the method below.
-  int32_t startTimerQuery(std::string name, FrameStats::TimerMode mode);
+  int32_t startTimerQuery(FrameStats::NameID name, FrameStats::TimerMode mode);
   int32_t startSamplesQuery(std::string name);
   int32_t startPrimitivesQuery(std::string name);
 
@@ -228,6 +366,15 @@ class CS_UTILS_EXPORT QueryPool {
   void endSamplesQuery(int32_t id);
   void endPrimitivesQuery(int32_t id);
 
+  /// Adds the given value to the value counter with the given name.
+  void addValue(std::string const& name, int64_t value);
+
+  /// Appends a CPU range which has been recorded on another thread.
+  void addThreadTimerResult(FrameStats::TimerQueryResult const& result);
+
+  /// Appends the given flow event.
+  void addFlowEvent(FrameStats::FlowEvent const& event);
+
   /// Fetches timestamps from GPU. This needs to be called before get*Results() and blocks until all
   /// queries are done.
   void fetchQueries();
@@ -235,8 +382,12 @@ class CS_UTILS_EXPORT QueryPool {
   /// Returns the currently recorded queries since the last call to reset(). You should call
   /// fetchQueries() before trying to access these.
   std::vector<FrameStats::TimerQueryResult> const&   getTimerQueryResults() const;
+  std::vector<FrameStats::TimerQueryResult>&         getTimerQueryResults();
   std::vector<FrameStats::CounterQueryResult> const& getSamplesQueryResults() const;
   std::vector<FrameStats::CounterQueryResult> const& getPrimitivesQueryResults() const;
+  std::vector<FrameStats::CounterQueryResult> const& getValueCounterResults() const;
+  std::vector<FrameStats::FlowEvent> const&          getFlowEvents() const;
+  std::vector<FrameStats::FlowEvent>&                getFlowEvents();
 
  private:
   struct Queries {
@@ -260,6 +411,8 @@ class CS_UTILS_EXPORT QueryPool {
   std::vector<FrameStats::TimerQueryResult>   mTimerQueryResults;
   std::vector<FrameStats::CounterQueryResult> mSamplesQueryResults;
   std::vector<FrameStats::CounterQueryResult> mPrimitivesQueryResults;
+  std::vector<FrameStats::CounterQueryResult> mValueCounterResults;
+  std::vector<FrameStats::FlowEvent>          mFlowEvents;
 
   uint32_t mCurrentNestingLevel{};
 };
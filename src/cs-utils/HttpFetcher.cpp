@@ -0,0 +1,356 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "HttpFetcher.hpp"
+
+#include "logger.hpp"
+
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <array>
+
+namespace cs::utils {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The fetcher's thread wakes up at least this often, even if there is nothing to do.
+const std::chrono::milliseconds MAX_POLL_TIMEOUT(1000);
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct HttpFetcher::Transfer {
+  HttpRequest  mRequest;
+  Callback     mCallback;
+  HttpResponse mResponse;
+
+  // This is set once data has been passed to HttpRequest::mOnData.
+  bool mDataConsumed = false;
+
+  std::array<char, CURL_ERROR_SIZE> mErrorBuffer{};
+
+  static std::size_t onWrite(char* data, std::size_t size, std::size_t count, void* userData) {
+    auto* transfer = static_cast<Transfer*>(userData);
+    auto  bytes    = size * count;
+
+    if (transfer->mRequest.mOnData) {
+      transfer->mDataConsumed = true;
+      return transfer->mRequest.mOnData(data, bytes) ? bytes : 0;
+    }
+
+    transfer->mResponse.mBody.append(data, bytes);
+    return bytes;
+  }
+
+  static int onProgress(void* userData, curl_off_t downloadTotal, curl_off_t downloaded,
+      curl_off_t /*uploadTotal*/, curl_off_t /*uploaded*/) {
+    auto* transfer = static_cast<Transfer*>(userData);
+    transfer->mRequest.mOnProgress(
+        static_cast<double>(downloaded), static_cast<double>(downloadTotal));
+    return 0;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool HttpResponse::isSuccess() const {
+  // File URLs do not have a status code.
+  return mError.empty() && mStatus < 400;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HttpFetcher::HttpFetcher()
+    : HttpFetcher(Settings()) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HttpFetcher::HttpFetcher(Settings const& settings)
+    : mSettings(settings) {
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+
+  mMulti = curl_multi_init();
+
+  curl_multi_setopt(mMulti, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+  curl_multi_setopt(
+      mMulti, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(mSettings.mMaxConnectionsPerHost));
+  curl_multi_setopt(
+      mMulti, CURLMOPT_MAX_TOTAL_CONNECTIONS, static_cast<long>(mSettings.mMaxConnections));
+  curl_multi_setopt(mMulti, CURLMOPT_MAX_CONCURRENT_STREAMS,
+      static_cast<long>(mSettings.mMaxStreamsPerConnection));
+
+  // Idle connections are kept open for later requests.
+  curl_multi_setopt(mMulti, CURLMOPT_MAXCONNECTS, static_cast<long>(mSettings.mMaxConnections));
+
+  mThread = std::thread([this]() { run(); });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HttpFetcher::~HttpFetcher() {
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mStop = true;
+  }
+
+  curl_multi_wakeup(mMulti);
+  mThread.join();
+
+  curl_multi_cleanup(mMulti);
+  curl_global_cleanup();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HttpFetcher& HttpFetcher::get() {
+  static HttpFetcher fetcher;
+  return fetcher;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HttpFetcher::fetch(HttpRequest request, Callback callback) {
+  auto transfer       = std::make_unique<Transfer>();
+  transfer->mRequest  = std::move(request);
+  transfer->mCallback = std::move(callback);
+
+  ++mRequests;
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIncoming.push_back(std::move(transfer));
+  }
+
+  curl_multi_wakeup(mMulti);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::future<HttpResponse> HttpFetcher::fetch(HttpRequest request) {
+  auto promise = std::make_shared<std::promise<HttpResponse>>();
+  auto future  = promise->get_future();
+
+  fetch(std::move(request),
+      [promise](HttpResponse response) { promise->set_value(std::move(response)); });
+
+  return future;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HttpFetcher::Statistics HttpFetcher::getStatistics() const {
+  Statistics statistics;
+  statistics.mRequests    = mRequests.load();
+  statistics.mCompleted   = mCompleted.load();
+  statistics.mFailed      = mFailed.load();
+  statistics.mRetries     = mRetries.load();
+  statistics.mConnections = mConnections.load();
+  return statistics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HttpFetcher::run() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+
+      if (mStop) {
+        break;
+      }
+
+      auto now = std::chrono::steady_clock::now();
+      for (auto& transfer : mIncoming) {
+        auto delay = transfer->mRequest.mDelay;
+        mDelayed.emplace(now + delay, std::move(transfer));
+      }
+
+      mIncoming.clear();
+    }
+
+    startDueTransfers();
+
+    int running = 0;
+    curl_multi_perform(mMulti, &running);
+
+    int      remaining = 0;
+    CURLMsg* message   = nullptr;
+    while ((message = curl_multi_info_read(mMulti, &remaining))) {
+      if (message->msg == CURLMSG_DONE) {
+        finishTransfer(message->easy_handle, message->data.result);
+      }
+    }
+
+    // Sleep until there is network activity, libcurl has to handle a timeout, a delayed request is
+    // due or new requests have been passed to fetch().
+    auto timeout = MAX_POLL_TIMEOUT;
+
+    if (!mDelayed.empty()) {
+      auto untilDue = std::chrono::ceil<std::chrono::milliseconds>(
+          mDelayed.begin()->first - std::chrono::steady_clock::now());
+      timeout = std::clamp(untilDue, std::chrono::milliseconds(0), timeout);
+    }
+
+    long curlTimeout = -1;
+    curl_multi_timeout(mMulti, &curlTimeout);
+    if (curlTimeout >= 0) {
+      timeout = std::min(timeout, std::chrono::milliseconds(curlTimeout));
+    }
+
+    curl_multi_poll(mMulti, nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+  }
+
+  // Abort all remaining transfers. The callbacks are destroyed without being invoked.
+  for (auto& [handle, transfer] : mActive) {
+    curl_multi_remove_handle(mMulti, handle);
+    curl_easy_cleanup(handle);
+  }
+
+  for (auto* handle : mIdleHandles) {
+    curl_easy_cleanup(handle);
+  }
+
+  mActive.clear();
+  mDelayed.clear();
+  mIdleHandles.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HttpFetcher::startDueTransfers() {
+  auto now = std::chrono::steady_clock::now();
+
+  while (!mDelayed.empty() && mDelayed.begin()->first <= now) {
+    auto transfer = std::move(mDelayed.begin()->second);
+    mDelayed.erase(mDelayed.begin());
+
+    // Easy handles are reused, this saves some allocations. The connections themselves are kept in
+    // the connection cache of the multi handle.
+    CURL* handle = nullptr;
+    if (mIdleHandles.empty()) {
+      handle = curl_easy_init();
+    } else {
+      handle = mIdleHandles.back();
+      mIdleHandles.pop_back();
+      curl_easy_reset(handle);
+    }
+
+    auto const& request = transfer->mRequest;
+
+    curl_easy_setopt(handle, CURLOPT_URL, request.mUrl.c_str());
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, request.mFollowLocation ? 1L : 0L);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, request.mVerifyPeer ? 1L : 0L);
+    curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, transfer->mErrorBuffer.data());
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &Transfer::onWrite);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, transfer.get());
+
+    // Use HTTP/2 for HTTPS URLs if the server supports it. Instead of opening a new connection,
+    // wait for a pending one to find out whether requests can be multiplexed.
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+
+    if (request.mConnectTimeout.count() > 0) {
+      curl_easy_setopt(
+          handle, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(request.mConnectTimeout.count()));
+    }
+
+    if (request.mTimeout.count() > 0) {
+      curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, static_cast<long>(request.mTimeout.count()));
+    }
+
+    // A transfer is considered to be stalled if less than one byte per second is received.
+    if (request.mStallTimeout.count() > 0) {
+      curl_easy_setopt(handle, CURLOPT_LOW_SPEED_LIMIT, 1L);
+      curl_easy_setopt(
+          handle, CURLOPT_LOW_SPEED_TIME, static_cast<long>(request.mStallTimeout.count()));
+    }
+
+    if (request.mOnProgress) {
+      curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 0L);
+      curl_easy_setopt(handle, CURLOPT_XFERINFOFUNCTION, &Transfer::onProgress);
+      curl_easy_setopt(handle, CURLOPT_XFERINFODATA, transfer.get());
+    }
+
+    transfer->mErrorBuffer[0] = '\0';
+    ++transfer->mResponse.mAttempts;
+
+    curl_multi_add_handle(mMulti, handle);
+    mActive.emplace(handle, std::move(transfer));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HttpFetcher::finishTransfer(void* handle, int result) {
+  auto iter     = mActive.find(handle);
+  auto transfer = std::move(iter->second);
+  mActive.erase(iter);
+
+  auto& response = transfer->mResponse;
+
+  if (result != CURLE_OK) {
+    response.mError = transfer->mErrorBuffer[0] != '\0'
+                          ? transfer->mErrorBuffer.data()
+                          : curl_easy_strerror(static_cast<CURLcode>(result));
+  }
+
+  curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response.mStatus);
+
+  char* contentType = nullptr;
+  curl_easy_getinfo(handle, CURLINFO_CONTENT_TYPE, &contentType);
+  response.mContentType = contentType ? contentType : "";
+
+  long connections = 0;
+  curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &connections);
+  mConnections += static_cast<uint64_t>(connections);
+
+  curl_multi_remove_handle(mMulti, handle);
+  mIdleHandles.push_back(handle);
+
+  auto const& request = transfer->mRequest;
+
+  bool retry = !response.mError.empty() || response.mStatus == 429 || response.mStatus >= 500 ||
+               (request.mRetryIf && request.mRetryIf(response));
+
+  if (retry && !transfer->mDataConsumed && response.mAttempts <= request.mMaxRetries) {
+    // The delay is doubled with each attempt. The request is simply re-scheduled, so no thread is
+    // blocked in the meantime.
+    auto delay = request.mRetryDelay * (1 << std::min(response.mAttempts - 1, 16));
+
+    response.mStatus = 0;
+    response.mContentType.clear();
+    response.mBody.clear();
+    response.mError.clear();
+
+    ++mRetries;
+    mDelayed.emplace(std::chrono::steady_clock::now() + delay, std::move(transfer));
+    return;
+  }
+
+  if (!response.isSuccess()) {
+    ++mFailed;
+  }
+
+  ++mCompleted;
+
+  // There is no one we could report an error of the callback to, so we just log it.
+  try {
+    transfer->mCallback(std::move(response));
+  } catch (std::exception const& e) {
+    logger().warn("Uncaught exception in HttpFetcher callback: {}", e.what());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils
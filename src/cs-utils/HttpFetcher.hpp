@@ -0,0 +1,199 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_HTTP_FETCHER_HPP
+#define CS_UTILS_HTTP_FETCHER_HPP
+
+#include "cs_utils_export.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace cs::utils {
+
+/// The result of a request made through the HttpFetcher.
+struct CS_UTILS_EXPORT HttpResponse {
+  /// The HTTP status code of the response. This is zero if no response has been received.
+  long mStatus = 0;
+
+  /// The value of the Content-Type header. This is empty if the server did not send one.
+  std::string mContentType;
+
+  /// The received data. This stays empty if the request has an HttpRequest::mOnData callback.
+  std::string mBody;
+
+  /// A description of what went wrong if the transfer failed, for instance because the host could
+  /// not be reached. This is empty if a response has been received, regardless of its status code.
+  std::string mError;
+
+  /// The number of attempts which have been made for this request.
+  int mAttempts = 0;
+
+  /// Returns true if the transfer succeeded and the status code does not indicate an error.
+  bool isSuccess() const;
+};
+
+/// The parameters of a request made through the HttpFetcher.
+struct CS_UTILS_EXPORT HttpRequest {
+  std::string mUrl;
+
+  /// The request is not started before this delay has elapsed. This can be used to implement a
+  /// cooldown for resources which failed recently without blocking any thread.
+  std::chrono::milliseconds mDelay{0};
+
+  /// The transfer is aborted if no connection could be established within this time.
+  std::chrono::milliseconds mConnectTimeout{10000};
+
+  /// If non-zero, the transfer is aborted if it takes longer than this in total. Requests for large
+  /// files should set this to zero and rely on mStallTimeout instead.
+  std::chrono::milliseconds mTimeout{60000};
+
+  /// If non-zero, the transfer is aborted if no data has been received for this long. Together with
+  /// mConnectTimeout this ensures that requests to unresponsive servers fail eventually.
+  std::chrono::seconds mStallTimeout{30};
+
+  /// Failed requests are repeated up to this many times. A request is considered to be failed if
+  /// no response has been received, if the server responded with a status code of 429 or 5xx or if
+  /// mRetryIf returns true. The delay between the attempts is doubled after each retry.
+  int                       mMaxRetries = 0;
+  std::chrono::milliseconds mRetryDelay{500};
+
+  /// This can be used to retry requests for which the server returned a response which is not
+  /// usable, for instance because it has an unexpected content type.
+  std::function<bool(HttpResponse const&)> mRetryIf;
+
+  /// If set, received data is passed to this function instead of being collected in
+  /// HttpResponse::mBody. The transfer is aborted if it returns false. Requests are not retried
+  /// once data has been passed to this function.
+  std::function<bool(char const* data, std::size_t size)> mOnData;
+
+  /// If set, this is called regularly with the amount of downloaded bytes and the total amount of
+  /// bytes to be downloaded. The latter is zero as long as it is not known.
+  std::function<void(double downloaded, double total)> mOnProgress;
+
+  bool mFollowLocation = true;
+  bool mVerifyPeer     = true;
+};
+
+/// The HttpFetcher performs HTTP requests using libcurl's multi interface on a single background
+/// thread. All requests share a connection cache, so subsequent requests to the same host do not
+/// require a new TCP and TLS handshake. If libcurl and the server support HTTP/2, several requests
+/// are multiplexed over one connection. The number of parallel connections is limited per host and
+/// in total; requests exceeding these limits are queued by libcurl.
+///
+/// Instead of blocking the calling thread, the results are passed to a callback. This callback is
+/// executed on the fetcher's thread, so it should return quickly. Any expensive processing of the
+/// response, such as image decoding, should be moved to the ThreadPool. Retries and delayed
+/// requests are scheduled on the fetcher's thread as well, so they do not block any thread either.
+///
+/// Most components should not create their own fetcher but use the process-wide instance returned
+/// by HttpFetcher::get().
+class CS_UTILS_EXPORT HttpFetcher {
+ public:
+  using Callback = std::function<void(HttpResponse)>;
+
+  struct Settings {
+    /// The maximum number of connections which are opened to a single host.
+    uint32_t mMaxConnectionsPerHost = 6;
+
+    /// The maximum number of connections which are opened to all hosts together.
+    uint32_t mMaxConnections = 32;
+
+    /// The maximum number of requests which are multiplexed over one HTTP/2 connection.
+    uint32_t mMaxStreamsPerConnection = 100;
+  };
+
+  /// Some statistics which may be useful for debugging and testing. All counters are accumulated
+  /// over the lifetime of the fetcher.
+  struct Statistics {
+    /// The number of requests passed to fetch().
+    uint64_t mRequests = 0;
+
+    /// The number of requests whose callback has been invoked.
+    uint64_t mCompleted = 0;
+
+    /// The number of completed requests which have not been successful.
+    uint64_t mFailed = 0;
+
+    /// The number of retries which have been made.
+    uint64_t mRetries = 0;
+
+    /// The number of connections which have been opened. If this is much smaller than the number
+    /// of attempts, connections have been reused.
+    uint64_t mConnections = 0;
+  };
+
+  /// Starts the fetcher's thread.
+  HttpFetcher();
+  explicit HttpFetcher(Settings const& settings);
+
+  HttpFetcher(HttpFetcher const& other) = delete;
+  HttpFetcher(HttpFetcher&& other)      = delete;
+
+  HttpFetcher& operator=(HttpFetcher const& other) = delete;
+  HttpFetcher& operator=(HttpFetcher&& other)      = delete;
+
+  /// Aborts all pending requests and joins the fetcher's thread. The callbacks of the aborted
+  /// requests are destroyed without being invoked.
+  ~HttpFetcher();
+
+  /// Returns the process-wide shared instance.
+  static HttpFetcher& get();
+
+  /// Queues the given request. This returns immediately, the callback is invoked on the fetcher's
+  /// thread once the request has been completed, has failed or has run out of retries. Components
+  /// which need to wait for their callbacks, for instance in their destructor, can wrap them with
+  /// TaskGroup::track().
+  void fetch(HttpRequest request, Callback callback);
+
+  /// Queues the given request. The returned future can be used to retrieve the response. This is
+  /// meant for code which has to block anyways; it should not be used on ThreadPool threads.
+  std::future<HttpResponse> fetch(HttpRequest request);
+
+  Statistics getStatistics() const;
+
+ private:
+  struct Transfer;
+
+  void run();
+  void startDueTransfers();
+  void finishTransfer(void* handle, int result);
+
+  Settings mSettings;
+  void*    mMulti = nullptr;
+
+  std::mutex                             mMutex;
+  std::vector<std::unique_ptr<Transfer>> mIncoming;
+  bool                                   mStop = false;
+
+  // These are only accessed by the fetcher's thread.
+  std::multimap<std::chrono::steady_clock::time_point, std::unique_ptr<Transfer>> mDelayed;
+  std::unordered_map<void*, std::unique_ptr<Transfer>>                            mActive;
+  std::vector<void*>                                                              mIdleHandles;
+
+  std::atomic<uint64_t> mRequests{0};
+  std::atomic<uint64_t> mCompleted{0};
+  std::atomic<uint64_t> mFailed{0};
+  std::atomic<uint64_t> mRetries{0};
+  std::atomic<uint64_t> mConnections{0};
+
+  std::thread mThread;
+};
+
+} // namespace cs::utils
+
+#endif // CS_UTILS_HTTP_FETCHER_HPP
@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "MappedFile.hpp"
+
+#include <boost/filesystem.hpp>
+#include <stdexcept>
+
+#ifdef _WIN32
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace cs::utils {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+std::size_t getFileSize(std::string const& path) {
+  boost::system::error_code error;
+  auto                      size = boost::filesystem::file_size(path, error);
+
+  if (error) {
+    throw std::runtime_error("Failed to open '" + path + "' for reading!");
+  }
+
+  return static_cast<std::size_t>(size);
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MappedFile::MappedFile(std::string const& path)
+    : MappedFile(path, getFileSize(path)) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MappedFile::MappedFile(std::string const& path, std::size_t size)
+    : mSize(size) {
+
+  // Empty files cannot be mapped.
+  if (mSize == 0) {
+    return;
+  }
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL, nullptr);
+
+  if (file == INVALID_HANDLE_VALUE) {
+    throw std::runtime_error("Failed to open '" + path + "' for reading!");
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+
+  if (mapping == nullptr) {
+    throw std::runtime_error("Failed to map '" + path + "' into memory!");
+  }
+
+  mData = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, mSize);
+  CloseHandle(mapping);
+
+  if (mData == nullptr) {
+    throw std::runtime_error("Failed to map '" + path + "' into memory!");
+  }
+#else
+  int file = open(path.c_str(), O_RDONLY); // NOLINT(cppcoreguidelines-pro-type-vararg)
+
+  if (file < 0) {
+    throw std::runtime_error("Failed to open '" + path + "' for reading!");
+  }
+
+  mData = mmap(nullptr, mSize, PROT_READ, MAP_SHARED, file, 0);
+  close(file);
+
+  if (mData == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    mData = nullptr;
+    throw std::runtime_error("Failed to map '" + path + "' into memory!");
+  }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MappedFile::~MappedFile() {
+  if (mData == nullptr) {
+    return;
+  }
+
+#ifdef _WIN32
+  UnmapViewOfFile(mData);
+#else
+  munmap(mData, mSize);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+char const* MappedFile::data() const {
+  return static_cast<char const*>(mData);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t MappedFile::size() const {
+  return mSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils
@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_MAPPED_FILE_HPP
+#define CS_UTILS_MAPPED_FILE_HPP
+
+#include "cs_utils_export.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace cs::utils {
+
+/// Maps a file read-only into memory. The operating system loads the pages of the file on demand
+/// and can share them with other processes, so this is usually the fastest way to read large files
+/// which are accessed only once or randomly.
+class CS_UTILS_EXPORT MappedFile {
+ public:
+  /// Maps the entire file. This throws a std::runtime_error if the file cannot be mapped.
+  explicit MappedFile(std::string const& path);
+
+  /// Maps the first bytes of the file. The file may grow while it is mapped. This throws a
+  /// std::runtime_error if the file cannot be mapped.
+  MappedFile(std::string const& path, std::size_t size);
+
+  MappedFile(MappedFile const& other) = delete;
+  MappedFile(MappedFile&& other)      = delete;
+
+  MappedFile& operator=(MappedFile const& other) = delete;
+  MappedFile& operator=(MappedFile&& other)      = delete;
+
+  ~MappedFile();
+
+  /// Returns a pointer to the mapped data. This is nullptr for empty files.
+  char const* data() const;
+
+  /// Returns the number of mapped bytes.
+  std::size_t size() const;
+
+ private:
+  void*       mData = nullptr;
+  std::size_t mSize;
+};
+
+} // namespace cs::utils
+
+#endif // CS_UTILS_MAPPED_FILE_HPP
@@ -7,38 +7,74 @@
 
 #include "ThreadPool.hpp"
 
-#include <iostream>
+#include "logger.hpp"
+
+#include <algorithm>
+#include <chrono>
 
 namespace cs::utils {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-ThreadPool::ThreadPool(size_t threads)
-    : mStop(false) {
-  for (size_t i = 0; i < threads; ++i) {
-    mWorkers.emplace_back([this] {
-      while (true) {
-        std::function<void()> task;
-        {
-          std::unique_lock<std::mutex> lock(mMutex);
+namespace {
 
-          mCondition.wait(lock, [this] { return mStop || !mTasks.empty(); });
+// These are used to detect whether a task is enqueued from within one of the pool's own workers.
+// In this case, the task is pushed to the worker's own queue.
+thread_local ThreadPool const* tCurrentPool  = nullptr;
+thread_local size_t            tCurrentIndex = 0;
 
-          if (mStop && mTasks.empty()) {
-            return;
-          }
+// When TaskGroup::wait() is called from a worker and there is no task it could run itself, it
+// checks for new tasks in these intervals.
+const std::chrono::milliseconds HELPING_WAIT_INTERVAL(1);
 
-          task = std::move(mTasks.top());
-          mTasks.pop();
-          ++mRunningTasks;
-        }
+} // namespace
 
-        task();
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-        std::unique_lock<std::mutex> lock(mMutex);
-        --mRunningTasks;
-      }
-    });
+TaskHandle::TaskHandle(std::shared_ptr<std::atomic<State>> state)
+    : mState(std::move(state)) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TaskHandle::cancel() {
+  if (!mState) {
+    return false;
+  }
+
+  auto expected = State::ePending;
+  return mState->compare_exchange_strong(expected, State::eCancelled);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TaskHandle::isCancelled() const {
+  return mState && mState->load() == State::eCancelled;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TaskHandle::isFinished() const {
+  return mState && mState->load() == State::eFinished;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TaskHandle::isValid() const {
+  return mState != nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool::ThreadPool(size_t threads) {
+  threads = std::max<size_t>(threads, 1);
+
+  for (size_t i = 0; i < threads; ++i) {
+    mWorkers.emplace_back(std::make_unique<Worker>());
+  }
+
+  for (size_t i = 0; i < threads; ++i) {
+    mThreads.emplace_back([this, i] { run(i); });
   }
 }
 
@@ -46,15 +82,248 @@ ThreadPool::ThreadPool(size_t threads)
 
 ThreadPool::~ThreadPool() {
   {
-    std::unique_lock<std::mutex> lock(mMutex);
+    std::unique_lock<std::mutex> lock(mSleepMutex);
     mStop = true;
   }
 
-  mCondition.notify_all();
+  mSleepCondition.notify_all();
+
+  for (std::thread& thread : mThreads) {
+    thread.join();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool& ThreadPool::get() {
+  static ThreadPool instance(std::max(32U, 2U * std::thread::hardware_concurrency()));
+  return instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::push(Task&& task, TaskPriority priority) {
+  if (mStop) {
+    throw std::runtime_error("enqueue on stopped ThreadPool");
+  }
+
+  size_t index = tCurrentPool == this ? tCurrentIndex : mNextWorker++ % mWorkers.size();
+
+  // The counter is incremented before the task becomes visible so that it can never underflow when
+  // a worker picks up the task immediately.
+  ++mPendingTasks;
+
+  {
+    auto&                        worker = *mWorkers[index];
+    std::unique_lock<std::mutex> lock(worker.mMutex);
+    worker.mQueues.at(static_cast<size_t>(priority)).push_back(std::move(task));
+    ++worker.mSizes.at(static_cast<size_t>(priority));
+  }
+
+  // Only wake up a worker if there is one sleeping. A worker increments mSleepingWorkers before it
+  // checks mPendingTasks while holding mSleepMutex, so either it sees the new task or we see the
+  // sleeping worker. Locking the mutex here ensures that it is actually waiting when we notify it.
+  if (mSleepingWorkers > 0) {
+    { std::unique_lock<std::mutex> lock(mSleepMutex); }
+    mSleepCondition.notify_one();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ThreadPool::pop(size_t workerIndex, Task& task) {
+  for (size_t p = PRIORITY_COUNT; p-- > 0;) {
+
+    // First, we try to take the most recently added task from our own queue. If that is empty, we
+    // steal the oldest task of this priority from another worker. Other workers' queues are only
+    // locked if this is possible without waiting. Only if that fails for a queue which contains
+    // tasks, a second pass blocks on these queues. This way, a task of lower priority is never
+    // taken while one of this priority sits in a queue which happens to be locked.
+    for (int pass = 0; pass < 2; ++pass) {
+      bool contended = false;
+
+      for (size_t i = 0; i < mWorkers.size(); ++i) {
+        auto& worker = *mWorkers[(workerIndex + i) % mWorkers.size()];
+
+        if (worker.mSizes.at(p) == 0) {
+          continue;
+        }
+
+        std::unique_lock<std::mutex> lock(worker.mMutex, std::defer_lock);
+
+        if (i == 0 || pass == 1) {
+          lock.lock();
+        } else if (!lock.try_lock()) {
+          contended = true;
+          continue;
+        }
+
+        auto& queue = worker.mQueues.at(p);
+
+        if (queue.empty()) {
+          continue;
+        }
+
+        if (i == 0) {
+          task = std::move(queue.back());
+          queue.pop_back();
+        } else {
+          task = std::move(queue.front());
+          queue.pop_front();
+        }
+
+        --worker.mSizes.at(p);
+        return true;
+      }
+
+      if (!contended) {
+        break;
+      }
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ThreadPool::runPendingTask() {
+
+  // Before searching the queues, a thread claims one of the pending tasks by decrementing the
+  // counter. This way, there are never more threads searching for tasks than there are tasks, so
+  // idle workers do not spin on the queue locks. The running counter is incremented first so
+  // that hasFinished() never sees both counters at zero while a task changes hands.
+  ++mRunningTasks;
+
+  uint32_t pending = mPendingTasks.load();
+  while (pending > 0 && !mPendingTasks.compare_exchange_weak(pending, pending - 1)) {
+  }
+
+  if (pending == 0) {
+    --mRunningTasks;
+    return false;
+  }
+
+  // As we have claimed a task, there is one in one of the queues - or it will be there soon, as
+  // the counter is incremented before the task is actually pushed.
+  Task task;
+  while (!pop(tCurrentIndex, task)) {
+    std::this_thread::yield();
+  }
+
+  // Tasks created with enqueue() store exceptions in their future. For all others, there is no
+  // one we could report the error to, so we just log it.
+  try {
+    task();
+  } catch (std::exception const& e) {
+    logger().warn("Uncaught exception in ThreadPool task: {}", e.what());
+  }
+
+  // Destroy the task before it is reported as done. This releases everything the task captured,
+  // which is what TaskGroup relies on.
+  task = Task();
+  --mRunningTasks;
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::run(size_t workerIndex) {
+  tCurrentPool  = this;
+  tCurrentIndex = workerIndex;
+
+  while (true) {
+    if (runPendingTask()) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mSleepMutex);
+    ++mSleepingWorkers;
+    mSleepCondition.wait(lock, [this] { return mStop || mPendingTasks > 0; });
+    --mSleepingWorkers;
+
+    if (mStop && mPendingTasks == 0) {
+      return;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TaskGroup::Token::Token(TaskGroup* group)
+    : mGroup(group) {
+  std::unique_lock<std::mutex> lock(mGroup->mMutex);
+  ++mGroup->mPendingTasks;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TaskGroup::Token::Token(Token&& other) noexcept
+    : mGroup(other.mGroup) {
+  other.mGroup = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TaskGroup::Token::~Token() {
+  if (mGroup) {
+    std::unique_lock<std::mutex> lock(mGroup->mMutex);
+    if (--mGroup->mPendingTasks == 0) {
+      mGroup->mCondition.notify_all();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TaskGroup::TaskGroup(ThreadPool& pool)
+    : mPool(pool) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  for (std::thread& worker : mWorkers) {
-    worker.join();
+TaskGroup::~TaskGroup() {
+  wait();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TaskGroup::getPendingTaskCount() const {
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mPendingTasks;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TaskGroup::hasFinished() const {
+  return getPendingTaskCount() == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TaskGroup::wait() const {
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  // If this is called from within a task of the same pool, blocking the worker could deadlock
+  // the pool if the tasks we are waiting for are queued behind us. Hence, the worker executes
+  // pending tasks until the group has finished. If there are none, our tasks are being executed by
+  // other workers and we wait a moment for them.
+  if (tCurrentPool == &mPool) {
+    while (mPendingTasks > 0) {
+      lock.unlock();
+      bool ranTask = mPool.runPendingTask();
+      lock.lock();
+
+      if (!ranTask) {
+        mCondition.wait_for(lock, HELPING_WAIT_INTERVAL, [this] { return mPendingTasks == 0; });
+      }
+    }
+
+    return;
   }
+
+  mCondition.wait(lock, [this] { return mPendingTasks == 0; });
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
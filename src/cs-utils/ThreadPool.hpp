@@ -10,19 +10,170 @@
 
 #include "cs_utils_export.hpp"
 
+#include <array>
+#include <atomic>
 #include <condition_variable>
-#include <functional>
+#include <cstddef>
+#include <deque>
 #include <future>
 #include <memory>
 #include <mutex>
-#include <stack>
+#include <new>
 #include <stdexcept>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace cs::utils {
 
-/// This is based on https://github.com/progschj/ThreadPool
+/// Tasks with a higher priority are always started before tasks with a lower priority, regardless
+/// of the order in which they were enqueued. Tasks of equal priority are executed in LIFO order
+/// by the worker which owns them and in FIFO order by workers stealing them.
+enum class TaskPriority { eLow, eNormal, eHigh };
+
+/// A type-erased, move-only callable with small-buffer storage. Callables which are not larger than
+/// INLINE_SIZE bytes are stored in-place, so creating a Task for them does not allocate any heap
+/// memory. Larger callables are moved to the heap. In contrast to std::function, this also accepts
+/// move-only callables such as std::packaged_task.
+class Task {
+ public:
+  static constexpr std::size_t INLINE_SIZE = 64;
+
+  Task() = default;
+
+  template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+  explicit Task(F&& f) {
+    using Func = std::decay_t<F>;
+
+    if constexpr (fitsInline<Func>()) {
+      new (&mStorage) Func(std::forward<F>(f));
+      mOps = inlineOps<Func>();
+    } else {
+      new (&mStorage) Func*(new Func(std::forward<F>(f)));
+      mOps = heapOps<Func>();
+    }
+  }
+
+  Task(Task const& other) = delete;
+  Task& operator=(Task const& other) = delete;
+
+  Task(Task&& other) noexcept
+      : mOps(other.mOps) {
+    if (mOps) {
+      mOps->mMove(&mStorage, &other.mStorage);
+      other.mOps = nullptr;
+    }
+  }
+
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      reset();
+      mOps = other.mOps;
+      if (mOps) {
+        mOps->mMove(&mStorage, &other.mStorage);
+        other.mOps = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  ~Task() {
+    reset();
+  }
+
+  /// Executes the stored callable. The Task must not be empty.
+  void operator()() {
+    mOps->mInvoke(&mStorage);
+  }
+
+  /// Returns false if this Task has been default-constructed or moved from.
+  explicit operator bool() const {
+    return mOps != nullptr;
+  }
+
+ private:
+  struct Ops {
+    void (*mInvoke)(void* storage);
+    void (*mMove)(void* dst, void* src);
+    void (*mDestroy)(void* storage);
+  };
+
+  template <typename F>
+  static constexpr bool fitsInline() {
+    return sizeof(F) <= INLINE_SIZE && alignof(F) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible_v<F>;
+  }
+
+  template <typename F>
+  static Ops const* inlineOps() {
+    static const Ops ops = {
+        [](void* storage) { (*std::launder(static_cast<F*>(storage)))(); },
+        [](void* dst, void* src) {
+          F* f = std::launder(static_cast<F*>(src));
+          new (dst) F(std::move(*f));
+          f->~F();
+        },
+        [](void* storage) { std::launder(static_cast<F*>(storage))->~F(); }};
+    return &ops;
+  }
+
+  template <typename F>
+  static Ops const* heapOps() {
+    static const Ops ops = {
+        [](void* storage) { (**std::launder(static_cast<F**>(storage)))(); },
+        [](void* dst, void* src) { new (dst) F*(*std::launder(static_cast<F**>(src))); },
+        [](void* storage) { delete *std::launder(static_cast<F**>(storage)); }};
+    return &ops;
+  }
+
+  void reset() {
+    if (mOps) {
+      mOps->mDestroy(&mStorage);
+      mOps = nullptr;
+    }
+  }
+
+  alignas(std::max_align_t) std::array<std::byte, INLINE_SIZE> mStorage{};
+  Ops const* mOps = nullptr;
+};
+
+/// A TaskHandle is returned by ThreadPool::submit() and can be used to cancel a task which has not
+/// been started yet. Cancelled tasks stay in the queue until a worker picks them up; they are then
+/// destroyed without being executed. A default-constructed TaskHandle refers to no task.
+class CS_UTILS_EXPORT TaskHandle {
+ public:
+  TaskHandle() = default;
+
+  /// Prevents the task from being executed. Returns true if the task was cancelled, false if it
+  /// has already been started, has finished or has been cancelled before.
+  bool cancel();
+
+  /// Returns true if cancel() has been called successfully on this or on a copy of this handle.
+  bool isCancelled() const;
+
+  /// Returns true if the task has been executed completely.
+  bool isFinished() const;
+
+  /// Returns true if this handle refers to a task.
+  bool isValid() const;
+
+ private:
+  friend class ThreadPool;
+
+  enum class State { ePending, eRunning, eFinished, eCancelled };
+
+  explicit TaskHandle(std::shared_ptr<std::atomic<State>> state);
+
+  std::shared_ptr<std::atomic<State>> mState;
+};
+
+/// A work-stealing thread pool. Each worker owns a deque of tasks per priority level. Tasks which
+/// are enqueued from within a worker thread are pushed to the worker's own deques, all other tasks
+/// are distributed round-robin. Idle workers steal tasks from the other workers. Hence, there is no
+/// single lock which all producers and consumers have to contend for.
+///
+/// Most components should not create their own pool but use the process-wide instance returned by
+/// ThreadPool::get(), usually through a TaskGroup.
 class CS_UTILS_EXPORT ThreadPool {
  public:
   /// Creates a new ThreadPool with the specified amount of threads.
@@ -34,40 +185,60 @@ class CS_UTILS_EXPORT ThreadPool {
   ThreadPool& operator=(ThreadPool const& other) = delete;
   ThreadPool& operator=(ThreadPool&& other)      = delete;
 
+  /// Executes all remaining tasks and joins the worker threads.
   virtual ~ThreadPool();
 
-  /// Adds a new work item to the pool.
+  /// Returns the process-wide shared instance. As many of the tasks in CosmoScout VR wait for
+  /// network or disk I/O, it uses more threads than there are hardware threads.
+  static ThreadPool& get();
+
+  /// Adds a new work item to the pool. The returned future can be used to retrieve the result.
   template <class F>
-  auto enqueue(F&& f) -> std::future<typename std::invoke_result<F>::type> {
+  auto enqueue(F&& f, TaskPriority priority = TaskPriority::eNormal)
+      -> std::future<typename std::invoke_result<F>::type> {
     using return_type = typename std::invoke_result<F>::type;
 
-    auto task = std::make_shared<std::packaged_task<return_type()>>(
-        [Func = std::forward<F>(f)] { return Func(); });
+    std::packaged_task<return_type()> task(std::forward<F>(f));
+    std::future<return_type>          res = task.get_future();
+    push(Task(std::move(task)), priority);
+    return res;
+  }
+
+  /// Adds a new work item to the pool. Unlike enqueue(), this does not create a future and
+  /// therefore does not allocate any memory for the task if the callable fits into a Task's inline
+  /// storage.
+  template <class F>
+  void post(F&& f, TaskPriority priority = TaskPriority::eNormal) {
+    push(Task(std::forward<F>(f)), priority);
+  }
 
-    std::future<return_type> res = task->get_future();
-    {
-      std::unique_lock<std::mutex> lock(mMutex);
+  /// Adds a new work item to the pool. The returned handle can be used to cancel the task as long
+  /// as it has not been started.
+  template <class F>
+  TaskHandle submit(F&& f, TaskPriority priority = TaskPriority::eNormal) {
+    auto state = std::make_shared<std::atomic<TaskHandle::State>>(TaskHandle::State::ePending);
 
-      if (mStop) {
-        throw std::runtime_error("enqueue on stopped ThreadPool");
+    push(Task([state, func = std::forward<F>(f)]() mutable {
+      auto expected = TaskHandle::State::ePending;
+      if (state->compare_exchange_strong(expected, TaskHandle::State::eRunning)) {
+        func();
+        state->store(TaskHandle::State::eFinished);
       }
+    }),
+        priority);
 
-      mTasks.emplace([task]() { (*task)(); });
-    }
-    mCondition.notify_one();
-    return res;
+    return TaskHandle(std::move(state));
   }
 
-  /// Returns the amount of tasks that await execution.
+  /// Returns the amount of tasks that await execution. This includes cancelled tasks which have not
+  /// been removed from the queues yet.
   uint32_t getPendingTaskCount() const {
-    std::unique_lock<std::mutex> lock(mMutex);
-    return static_cast<uint32_t>(mTasks.size());
+    return mPendingTasks.load();
   }
 
   /// Returns the number of tasks that currently are being executed.
   uint32_t getRunningTaskCount() const {
-    std::unique_lock<std::mutex> lock(mMutex);
-    return mRunningTasks;
+    return mRunningTasks.load();
   }
 
   /// Retruns true when there are no more tasks running or pending.
@@ -75,13 +246,126 @@ class CS_UTILS_EXPORT ThreadPool {
     return getPendingTaskCount() + getRunningTaskCount() == 0;
   }
 
+  /// Returns the number of worker threads.
+  size_t getThreadCount() const {
+    return mWorkers.size();
+  }
+
  private:
-  std::vector<std::thread>          mWorkers;
-  std::stack<std::function<void()>> mTasks;
-  mutable std::mutex                mMutex;
-  std::condition_variable           mCondition;
-  bool                              mStop;
-  uint32_t                          mRunningTasks = 0;
+  static constexpr size_t PRIORITY_COUNT = 3;
+
+  /// The sizes of the queues are mirrored in atomic counters so that other workers can skip empty
+  /// queues without locking them.
+  struct Worker {
+    std::mutex                                        mMutex;
+    std::array<std::deque<Task>, PRIORITY_COUNT>      mQueues;
+    std::array<std::atomic<uint32_t>, PRIORITY_COUNT> mSizes{};
+  };
+
+  friend class TaskGroup;
+
+  void push(Task&& task, TaskPriority priority);
+  bool pop(size_t workerIndex, Task& task);
+  void run(size_t workerIndex);
+
+  /// Claims one pending task and executes it on the calling thread. This is used by the workers
+  /// and by TaskGroup::wait() when it is called from within a worker. Returns false if there was
+  /// no pending task.
+  bool runPendingTask();
+
+  std::vector<std::unique_ptr<Worker>> mWorkers;
+  std::vector<std::thread>             mThreads;
+
+  std::mutex              mSleepMutex;
+  std::condition_variable mSleepCondition;
+
+  std::atomic<uint32_t> mPendingTasks{0};
+  std::atomic<uint32_t> mRunningTasks{0};
+  std::atomic<uint32_t> mSleepingWorkers{0};
+  std::atomic<size_t>   mNextWorker{0};
+  std::atomic<bool>     mStop{false};
+};
+
+/// Components which submit work to a shared ThreadPool usually need to know how many of their own
+/// tasks are still outstanding and have to make sure that none of them is running when they are
+/// destroyed. A TaskGroup keeps track of all tasks submitted through it; its destructor blocks until
+/// all of them have been executed or discarded. Therefore, it should be declared as the last member
+/// of a class, so that it is destroyed before any data the tasks may access.
+class CS_UTILS_EXPORT TaskGroup {
+ public:
+  explicit TaskGroup(ThreadPool& pool = ThreadPool::get());
+
+  TaskGroup(TaskGroup const& other) = delete;
+  TaskGroup(TaskGroup&& other)      = delete;
+
+  TaskGroup& operator=(TaskGroup const& other) = delete;
+  TaskGroup& operator=(TaskGroup&& other)      = delete;
+
+  ~TaskGroup();
+
+  /// See ThreadPool::enqueue().
+  template <class F>
+  auto enqueue(F&& f, TaskPriority priority = TaskPriority::eNormal)
+      -> std::future<typename std::invoke_result<F>::type> {
+    return mPool.enqueue(
+        [token = Token(this), func = std::forward<F>(f)]() mutable { return func(); }, priority);
+  }
+
+  /// See ThreadPool::post().
+  template <class F>
+  void post(F&& f, TaskPriority priority = TaskPriority::eNormal) {
+    mPool.post([token = Token(this), func = std::forward<F>(f)]() mutable { func(); }, priority);
+  }
+
+  /// See ThreadPool::submit().
+  template <class F>
+  TaskHandle submit(F&& f, TaskPriority priority = TaskPriority::eNormal) {
+    return mPool.submit(
+        [token = Token(this), func = std::forward<F>(f)]() mutable { func(); }, priority);
+  }
+
+  /// Wraps the given callable so that it counts as a pending task of this group for as long as the
+  /// returned callable or one of its copies exists. This is meant for callbacks which are invoked
+  /// by other components, for instance by the HttpFetcher, so that the group waits for them as
+  /// well.
+  template <class F>
+  auto track(F&& f) {
+    return [token = std::make_shared<Token>(this), func = std::forward<F>(f)](
+               auto&&... args) mutable { return func(std::forward<decltype(args)>(args)...); };
+  }
+
+  /// Returns the number of tasks of this group which have been neither executed nor discarded.
+  uint32_t getPendingTaskCount() const;
+
+  /// Returns true when no task of this group is pending or running.
+  bool hasFinished() const;
+
+  /// Blocks until all tasks of this group have been executed or discarded. If this is called from
+  /// a worker of the group's pool, the worker executes other pending tasks in the meantime, so
+  /// that waiting for a group from within a task cannot deadlock the pool.
+  void wait() const;
+
+ private:
+  /// A Token is captured by each task of the group. It is released when the task is destroyed,
+  /// which happens both after regular execution and when a cancelled task is discarded.
+  class CS_UTILS_EXPORT Token {
+   public:
+    explicit Token(TaskGroup* group);
+    Token(Token&& other) noexcept;
+    ~Token();
+
+    Token(Token const& other) = delete;
+    Token& operator=(Token const& other) = delete;
+    Token& operator=(Token&& other) = delete;
+
+   private:
+    TaskGroup* mGroup;
+  };
+
+  ThreadPool&                     mPool;
+  mutable std::mutex              mMutex;
+  mutable std::condition_variable mCondition;
+  uint32_t                        mPendingTasks = 0;
 };
 
 } // namespace cs::utils
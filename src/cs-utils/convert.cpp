@@ -8,6 +8,7 @@
 #include "convert.hpp"
 
 #include "logger.hpp"
+#include "spice.hpp"
 
 #include <cmath>
 #include <cspice/SpiceUsr.h>
@@ -125,7 +126,11 @@ double toSpice(boost::posix_time::ptime const& tIn) {
 
   // Incorporate delta between ET and UTC.
   double ETUTCDelta = 0.0;
-  deltet_c(dTime, "UTC", &ETUTCDelta);
+
+  {
+    std::unique_lock<std::mutex> lock(spice::getMutex());
+    deltet_c(dTime, "UTC", &ETUTCDelta);
+  }
 
   return dTime + ETUTCDelta;
 }
@@ -179,7 +184,11 @@ boost::posix_time::ptime toPosix(double tIn) {
 
   // Incorporate delta between ET and UTC.
   double ETUTCDelta = 0.0;
-  deltet_c(tIn, "ET", &ETUTCDelta);
+
+  {
+    std::unique_lock<std::mutex> lock(spice::getMutex());
+    deltet_c(tIn, "ET", &ETUTCDelta);
+  }
 
   return boost::posix_time::ptime(boost::gregorian::date(startYear, 1, 1),
       boost::posix_time::hours(noon) + boost::posix_time::milliseconds(static_cast<int64_t>(
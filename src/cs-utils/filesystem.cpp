@@ -7,16 +7,16 @@
 
 #include "filesystem.hpp"
 
+#include "HttpFetcher.hpp"
 #include "utils.hpp"
 
-#include <curlpp/Easy.hpp>
-#include <curlpp/Info.hpp>
-#include <curlpp/Infos.hpp>
-#include <curlpp/Options.hpp>
-
 #include <cmath>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace cs::utils::filesystem {
 
@@ -98,20 +98,101 @@ void downloadFile(std::string const& url, std::string const& destination,
     throw std::runtime_error("Failed to open " + destination + " for downloading " + url + "!");
   }
 
-  curlpp::Easy request;
-  request.setOpt(curlpp::options::Url(url));
-  request.setOpt(curlpp::options::WriteStream(&stream));
-  request.setOpt(curlpp::options::NoSignal(true));
-  request.setOpt(curlpp::options::NoProgress(false));
-  request.setOpt(curlpp::options::SslVerifyPeer(false));
-  request.setOpt(curlpp::options::FollowLocation(true));
-  request.setOpt(curlpp::options::ProgressFunction(
-      [&](double a, double b, double /*unused*/, double /*unused*/) {
-        progressCallback(b, a);
-        return 0;
-      }));
-
-  request.perform();
+  // The HttpFetcher's thread is shared by all downloads, so it only collects the received data and
+  // progress. Writing to the file and reporting the progress happens on the calling thread. The
+  // state is shared, as the request's callbacks may be destroyed after this function returned.
+  struct State {
+    std::mutex               mMutex;
+    std::condition_variable  mCondition;
+    std::vector<std::string> mChunks;
+    double                   mDownloaded      = 0.0;
+    double                   mTotal           = 0.0;
+    bool                     mProgressChanged = false;
+    bool                     mWriteFailed     = false;
+    bool                     mFinished        = false;
+    HttpResponse             mResponse;
+  };
+
+  auto state = std::make_shared<State>();
+
+  HttpRequest request;
+  request.mUrl            = url;
+  request.mVerifyPeer     = false;
+  request.mFollowLocation = true;
+
+  // Large files may take arbitrarily long, so only stalled downloads are aborted.
+  request.mTimeout = std::chrono::milliseconds(0);
+
+  request.mOnData = [state](char const* data, std::size_t size) {
+    std::unique_lock<std::mutex> lock(state->mMutex);
+    state->mChunks.emplace_back(data, size);
+    state->mCondition.notify_one();
+    return !state->mWriteFailed;
+  };
+
+  if (progressCallback) {
+    request.mOnProgress = [state](double downloaded, double total) {
+      std::unique_lock<std::mutex> lock(state->mMutex);
+      state->mDownloaded      = downloaded;
+      state->mTotal           = total;
+      state->mProgressChanged = true;
+      state->mCondition.notify_one();
+    };
+  }
+
+  HttpFetcher::get().fetch(std::move(request), [state](HttpResponse response) {
+    std::unique_lock<std::mutex> lock(state->mMutex);
+    state->mResponse = std::move(response);
+    state->mFinished = true;
+    state->mCondition.notify_one();
+  });
+
+  // This is called from threads which are dedicated to downloading, so it is fine to block here.
+  std::vector<std::string> chunks;
+  bool                     finished = false;
+
+  while (!finished) {
+    double downloaded      = 0.0;
+    double total           = 0.0;
+    bool   progressChanged = false;
+
+    {
+      std::unique_lock<std::mutex> lock(state->mMutex);
+      state->mCondition.wait(lock, [&state]() {
+        return state->mFinished || state->mProgressChanged || !state->mChunks.empty();
+      });
+
+      chunks.swap(state->mChunks);
+      downloaded              = state->mDownloaded;
+      total                   = state->mTotal;
+      progressChanged         = state->mProgressChanged;
+      finished                = state->mFinished;
+      state->mProgressChanged = false;
+    }
+
+    for (auto const& chunk : chunks) {
+      stream.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    }
+
+    chunks.clear();
+
+    if (!stream) {
+      std::unique_lock<std::mutex> lock(state->mMutex);
+      state->mWriteFailed = true;
+    }
+
+    if (progressChanged) {
+      progressCallback(downloaded, total);
+    }
+  }
+
+  if (!stream) {
+    throw std::runtime_error("Failed to write " + destination + " while downloading " + url + "!");
+  }
+
+  if (!state->mResponse.mError.empty()) {
+    throw std::runtime_error("Failed to download " + url + ": " + state->mResponse.mError);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
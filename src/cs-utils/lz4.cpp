@@ -0,0 +1,247 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "lz4.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace cs::utils::lz4 {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// These limits are defined by the LZ4 block format.
+const std::size_t MAX_INPUT_SIZE = 0x7E000000;
+const std::size_t MIN_MATCH      = 4;
+const std::size_t MAX_OFFSET     = 65535;
+
+// The last match has to start at least 12 bytes before the end of the block and the last five
+// bytes are always literals.
+const std::size_t MF_LIMIT      = 12;
+const std::size_t LAST_LITERALS = 5;
+
+const int HASH_BITS = 16;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t read32(char const* p) {
+  uint32_t value{};
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint32_t hash(uint32_t sequence) {
+  return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+// Writes the remainder of a literal or match length which does not fit into the token.
+char* writeLength(char* op, std::size_t length) {
+  while (length >= 255) {
+    *op++ = static_cast<char>(255);
+    length -= 255;
+  }
+  *op++ = static_cast<char>(length);
+  return op;
+}
+
+// Reads the remainder of a literal or match length. Returns false if the input ends prematurely.
+bool readLength(unsigned char const*& ip, unsigned char const* end, std::size_t& length) {
+  unsigned char byte{};
+  do {
+    if (ip == end) {
+      return false;
+    }
+    byte = *ip++;
+    length += byte;
+  } while (byte == 255);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t compressBound(std::size_t size) {
+  return size + size / 255 + 16;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+std::size_t compress(char const* src, std::size_t srcSize, char* dst, std::size_t dstCapacity) {
+  if (srcSize > MAX_INPUT_SIZE || dstCapacity < compressBound(srcSize)) {
+    return 0;
+  }
+
+  char*       op     = dst;
+  std::size_t anchor = 0;
+
+  // Emits a sequence of the literals between the anchor and pos followed by the given match. A
+  // matchLength of zero marks the last sequence which consists of literals only.
+  auto emitSequence = [&](std::size_t pos, std::size_t offset, std::size_t matchLength) {
+    std::size_t literals = pos - anchor;
+    char*       token    = op++;
+
+    *token = static_cast<char>(std::min<std::size_t>(literals, 15) << 4);
+    if (literals >= 15) {
+      op = writeLength(op, literals - 15);
+    }
+
+    std::memcpy(op, src + anchor, literals);
+    op += literals;
+
+    if (matchLength > 0) {
+      *op++ = static_cast<char>(offset & 0xFF);
+      *op++ = static_cast<char>(offset >> 8);
+
+      std::size_t length = matchLength - MIN_MATCH;
+      *token             = static_cast<char>(*token | std::min<std::size_t>(length, 15));
+      if (length >= 15) {
+        op = writeLength(op, length - 15);
+      }
+    }
+  };
+
+  if (srcSize > MF_LIMIT) {
+    // The hash table stores the last position + 1 of each four-byte sequence, zero means empty.
+    std::vector<uint32_t> table(1U << HASH_BITS, 0);
+
+    std::size_t matchLimit = srcSize - LAST_LITERALS;
+    std::size_t pos        = 0;
+
+    while (pos + MF_LIMIT < srcSize) {
+      uint32_t    sequence  = read32(src + pos);
+      uint32_t&   entry     = table[hash(sequence)];
+      std::size_t candidate = entry;
+
+      entry = static_cast<uint32_t>(pos + 1);
+
+      if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET ||
+          read32(src + candidate - 1) != sequence) {
+        // Incompressible data is skipped faster the longer no match has been found.
+        pos += 1 + ((pos - anchor) >> 6);
+        continue;
+      }
+
+      std::size_t match  = candidate - 1;
+      std::size_t length = MIN_MATCH;
+
+      // Extend the match backwards over literals which have not been emitted yet.
+      while (pos > anchor && match > 0 && src[pos - 1] == src[match - 1]) {
+        --pos;
+        --match;
+        ++length;
+      }
+
+      while (pos + length < matchLimit && src[pos + length] == src[match + length]) {
+        ++length;
+      }
+
+      emitSequence(pos, pos - match, length);
+
+      pos += length;
+      anchor = pos;
+
+      // Make the position just before the next one findable, this improves the ratio of runs.
+      if (pos - 2 + MF_LIMIT < srcSize) {
+        table[hash(read32(src + pos - 2))] = static_cast<uint32_t>(pos - 1);
+      }
+    }
+  }
+
+  emitSequence(srcSize, 0, 0);
+
+  return static_cast<std::size_t>(op - dst);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool decompress(char const* src, std::size_t srcSize, char* dst, std::size_t dstSize) {
+  auto const* ip    = reinterpret_cast<unsigned char const*>(src);
+  auto const* ipEnd = ip + srcSize;
+  std::size_t op    = 0;
+
+  if (srcSize == 0) {
+    return false;
+  }
+
+  while (true) {
+    if (ip == ipEnd) {
+      return false;
+    }
+
+    unsigned char token    = *ip++;
+    std::size_t   literals = token >> 4;
+
+    if (literals == 15 && !readLength(ip, ipEnd, literals)) {
+      return false;
+    }
+
+    if (literals > static_cast<std::size_t>(ipEnd - ip) || literals > dstSize - op) {
+      return false;
+    }
+
+    std::memcpy(dst + op, ip, literals);
+    ip += literals;
+    op += literals;
+
+    // The last sequence consists of literals only.
+    if (ip == ipEnd) {
+      break;
+    }
+
+    if (ipEnd - ip < 2) {
+      return false;
+    }
+
+    std::size_t offset = ip[0] | (static_cast<std::size_t>(ip[1]) << 8);
+    ip += 2;
+
+    if (offset == 0 || offset > op) {
+      return false;
+    }
+
+    std::size_t length = token & 15;
+    if (length == 15 && !readLength(ip, ipEnd, length)) {
+      return false;
+    }
+    length += MIN_MATCH;
+
+    if (length > dstSize - op) {
+      return false;
+    }
+
+    // Overlapping matches repeat the last offset bytes. The repeated region doubles in size with
+    // each copy, so this requires only a few non-overlapping memcpy calls.
+    char const* from = dst + op - offset;
+    char*       to   = dst + op;
+    std::size_t left = length;
+
+    while (left > 0) {
+      std::size_t count = std::min(left, static_cast<std::size_t>(to - from));
+      std::memcpy(to, from, count);
+      to += count;
+      left -= count;
+    }
+
+    op += length;
+  }
+
+  return op == dstSize;
+}
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils::lz4
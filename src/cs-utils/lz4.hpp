@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_LZ4_HPP
+#define CS_UTILS_LZ4_HPP
+
+#include "cs_utils_export.hpp"
+
+#include <cstddef>
+
+/// A minimal implementation of the LZ4 block format (https://github.com/lz4/lz4). The compressor
+/// is a simple greedy one which trades compression ratio for speed; the output can be decompressed
+/// by any LZ4 implementation and vice versa. There is no frame format, so the size of the
+/// uncompressed data has to be stored by the caller.
+namespace cs::utils::lz4 {
+
+/// Returns the maximum size of the compressed data for an input of the given size.
+CS_UTILS_EXPORT std::size_t compressBound(std::size_t size);
+
+/// Compresses the given data into dst. Returns the number of bytes written to dst or zero if
+/// dstCapacity is smaller than compressBound(srcSize) or if the input is too large.
+CS_UTILS_EXPORT std::size_t compress(
+    char const* src, std::size_t srcSize, char* dst, std::size_t dstCapacity);
+
+/// Decompresses the given data into dst. This returns false if the data is malformed or if it does
+/// not decompress to exactly dstSize bytes. It never reads or writes outside of the given buffers.
+CS_UTILS_EXPORT bool decompress(
+    char const* src, std::size_t srcSize, char* dst, std::size_t dstSize);
+
+} // namespace cs::utils::lz4
+
+#endif // CS_UTILS_LZ4_HPP
@@ -0,0 +1,21 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "spice.hpp"
+
+namespace cs::utils::spice {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::mutex& getMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils::spice
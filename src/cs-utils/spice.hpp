@@ -0,0 +1,26 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#ifndef CS_UTILS_SPICE_HPP
+#define CS_UTILS_SPICE_HPP
+
+#include "cs_utils_export.hpp"
+
+#include <mutex>
+
+/// Utility functions for using CSPICE from multiple threads.
+namespace cs::utils::spice {
+
+/// CSPICE uses global state, so only one thread may call it at any time. As SPICE is used by the
+/// main thread and by the ThreadPool, each call to a CSPICE function has to be made while holding
+/// this mutex. The mutex is not recursive, so it must not be locked when calling functions which
+/// lock it themselves, like cs::utils::convert::time::toSpice().
+CS_UTILS_EXPORT std::mutex& getMutex();
+
+} // namespace cs::utils::spice
+
+#endif // CS_UTILS_SPICE_HPP
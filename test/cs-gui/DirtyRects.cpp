@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-gui/DirtyRects.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+namespace cs::gui {
+
+namespace {
+
+bool isEqual(DirtyRects::Rect const& a, DirtyRects::Rect const& b) {
+  return a.mX == b.mX && a.mY == b.mY && a.mWidth == b.mWidth && a.mHeight == b.mHeight;
+}
+
+} // namespace
+
+TEST_CASE("cs::gui::DirtyRects::merge") {
+  SUBCASE("Overlapping regions are merged") {
+    auto rects = DirtyRects::merge({{0, 0, 10, 10}, {5, 5, 10, 10}}, 100, 100);
+    REQUIRE_EQ(rects.size(), 1U);
+    CHECK_UNARY(isEqual(rects[0], {0, 0, 15, 15}));
+  }
+
+  SUBCASE("Adjacent regions are merged") {
+    auto rects = DirtyRects::merge({{0, 0, 10, 10}, {10, 0, 10, 10}, {0, 10, 20, 5}}, 100, 100);
+    REQUIRE_EQ(rects.size(), 1U);
+    CHECK_UNARY(isEqual(rects[0], {0, 0, 20, 15}));
+  }
+
+  SUBCASE("Distant regions are kept apart") {
+    auto rects = DirtyRects::merge({{0, 0, 10, 10}, {50, 50, 10, 10}}, 100, 100);
+    REQUIRE_EQ(rects.size(), 2U);
+    CHECK_UNARY(isEqual(rects[0], {0, 0, 10, 10}));
+    CHECK_UNARY(isEqual(rects[1], {50, 50, 10, 10}));
+  }
+
+  SUBCASE("Regions are clamped to the texture") {
+    auto rects = DirtyRects::merge({{-5, 90, 10, 20}, {200, 0, 10, 10}}, 100, 100);
+    REQUIRE_EQ(rects.size(), 1U);
+    CHECK_UNARY(isEqual(rects[0], {0, 90, 5, 10}));
+  }
+
+  SUBCASE("Too many regions are replaced by their bounding box") {
+    std::vector<DirtyRects::Rect> input;
+    for (std::size_t i = 0; i <= DirtyRects::MAX_RECTS; ++i) {
+      input.push_back({static_cast<int>(i) * 3, static_cast<int>(i) * 3, 1, 1});
+    }
+
+    auto rects = DirtyRects::merge(input, 1000, 1000);
+    int  size  = static_cast<int>(DirtyRects::MAX_RECTS) * 3 + 1;
+    REQUIRE_EQ(rects.size(), 1U);
+    CHECK_UNARY(isEqual(rects[0], {0, 0, size, size}));
+  }
+}
+
+TEST_CASE("cs::gui::DirtyRects") {
+  DirtyRects dirtyRects;
+  CHECK_UNARY(dirtyRects.empty());
+
+  SUBCASE("Regions are taken only once") {
+    dirtyRects.add({0, 0, 10, 10});
+    dirtyRects.add({40, 40, 10, 10});
+    CHECK_UNARY_FALSE(dirtyRects.empty());
+
+    CHECK_EQ(dirtyRects.take(100, 100).size(), 2U);
+    CHECK_UNARY(dirtyRects.empty());
+    CHECK_UNARY(dirtyRects.take(100, 100).empty());
+  }
+
+  SUBCASE("The entire texture is dirty after invalidate()") {
+    dirtyRects.add({0, 0, 10, 10});
+    dirtyRects.invalidate();
+
+    // Further regions are contained in the entire texture anyways.
+    dirtyRects.add({40, 40, 10, 10});
+
+    auto rects = dirtyRects.take(100, 50);
+    REQUIRE_EQ(rects.size(), 1U);
+    CHECK_UNARY(isEqual(rects[0], {0, 0, 100, 50}));
+    CHECK_UNARY(dirtyRects.empty());
+  }
+
+  SUBCASE("Too many pending regions mark the entire texture as dirty") {
+    for (std::size_t i = 0; i < DirtyRects::MAX_PENDING_RECTS; ++i) {
+      dirtyRects.add({0, 0, 1, 1});
+    }
+
+    // Up to this point, the regions are kept.
+    auto rects = dirtyRects.take(100, 50);
+    REQUIRE_EQ(rects.size(), 1U);
+    CHECK_UNARY(isEqual(rects[0], {0, 0, 1, 1}));
+
+    for (std::size_t i = 0; i <= DirtyRects::MAX_PENDING_RECTS; ++i) {
+      dirtyRects.add({0, 0, 1, 1});
+    }
+
+    rects = dirtyRects.take(100, 50);
+    REQUIRE_EQ(rects.size(), 1U);
+    CHECK_UNARY(isEqual(rects[0], {0, 0, 100, 50}));
+  }
+}
+
+} // namespace cs::gui
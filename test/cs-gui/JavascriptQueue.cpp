@@ -0,0 +1,60 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-gui/JavascriptQueue.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+namespace cs::gui {
+
+namespace {
+
+// Returns the given command as it is contained in the flushed script.
+std::string wrap(std::string const& command) {
+  return "try {\n" + command + ";\n} catch (e) {\n  console.error(e);\n}\n";
+}
+
+} // namespace
+
+TEST_CASE("cs::gui::JavascriptQueue") {
+  JavascriptQueue queue;
+  CHECK_UNARY(queue.empty());
+
+  SUBCASE("Commands are executed in the order in which they were queued") {
+    // Like before batching, the function declared by the second command can be used by the third.
+    queue.push("", "CosmoScout.state.a = 1");
+    queue.push("", JavascriptQueue::makeEval("function f() { return 2; }"));
+    queue.push("", "CosmoScout.state.b = f()");
+
+    CHECK_UNARY_FALSE(queue.empty());
+    CHECK_EQ(queue.flush(), wrap("CosmoScout.state.a = 1") +
+                                wrap("(0, eval)(\"function f() { return 2; }\")") +
+                                wrap("CosmoScout.state.b = f()"));
+
+    CHECK_UNARY(queue.empty());
+    CHECK_EQ(queue.flush(), "");
+  }
+
+  SUBCASE("Coalesced commands replace earlier ones") {
+    queue.push("setProgress", "setProgress(1)");
+    queue.push("", "other()");
+    queue.push("setProgress", "setProgress(2)");
+    queue.push("setCompass", "setCompass(3)");
+
+    CHECK_EQ(queue.flush(), wrap("other()") + wrap("setProgress(2)") + wrap("setCompass(3)"));
+
+    // The keys are forgotten once the queue has been flushed.
+    queue.push("setProgress", "setProgress(4)");
+    CHECK_EQ(queue.flush(), wrap("setProgress(4)"));
+  }
+
+  SUBCASE("Code is passed to eval as a string literal") {
+    CHECK_EQ(JavascriptQueue::makeEval("let s = \"a\\b\";\r\nf(s)"),
+        "(0, eval)(\"let s = \\\"a\\\\b\\\";\\r\\nf(s)\")");
+  }
+}
+
+} // namespace cs::gui
@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-scene/EphemerisCache.hpp"
+#include "../../src/cs-scene/CelestialAnchor.hpp"
+#include "../../src/cs-utils/convert.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cspice/SpiceUsr.h>
+#include <stdexcept>
+#include <vector>
+
+namespace cs::scene {
+
+namespace {
+
+// The kernels are downloaded when CosmoScout VR is started for the first time. The tests are
+// skipped if they are not available.
+bool loadKernels() {
+  std::string action = "RETURN";
+  erract_c("SET", 0, action.data());
+
+  std::string device = "NULL";
+  errdev_c("SET", 0, device.data());
+
+  furnsh_c("../share/config/spice/simple.txt");
+
+  if (failed_c()) {
+    reset_c();
+    MESSAGE("Skipping test as the SPICE kernels are not available.");
+    return false;
+  }
+
+  return true;
+}
+
+// Returns the angle of the rotation between a and b.
+double getAngle(glm::dquat const& a, glm::dquat const& b) {
+  auto diff = glm::normalize(glm::inverse(a) * b);
+  return glm::angle(diff.w < 0.0 ? -diff : diff);
+}
+
+} // namespace
+
+TEST_CASE("cs::scene::EphemerisCache") {
+  if (!loadKernels()) {
+    return;
+  }
+
+  EphemerisCache cache;
+
+  // This passes all queries to SPICE.
+  EphemerisCache spice;
+  spice.setEnabled(false);
+
+  double start = utils::convert::time::toSpice("2021-03-01 00:00:00.000");
+
+  SUBCASE("Positions and rotations match SPICE") {
+    double maxPositionError = 0.0;
+    double maxRotationError = 0.0;
+
+    // Query a month in steps of a bit more than an hour.
+    for (int i = 0; i < 600; ++i) {
+      double t = start + i * 4321.0;
+
+      auto position = cache.getPosition(t, "Moon", "Earth", "J2000");
+      auto rotation = cache.getRotation(t, "IAU_Moon", "IAU_Earth");
+
+      auto expectedPosition = spice.getPosition(t, "Moon", "Earth", "J2000");
+      auto expectedRotation = spice.getRotation(t, "IAU_Moon", "IAU_Earth");
+
+      maxPositionError = std::max(maxPositionError, glm::length(position - expectedPosition));
+      maxRotationError = std::max(maxRotationError, getAngle(rotation, expectedRotation));
+    }
+
+    // The tolerances are only checked where the error of the polynomials is largest, so they may
+    // be exceeded slightly in between.
+    CHECK_LE(maxPositionError, 2.0 * cache.getPositionTolerance());
+    CHECK_LE(maxRotationError, 2.0 * cache.getRotationTolerance());
+
+    auto statistics = cache.getStatistics();
+    CHECK_GT(statistics.mFittedSegments, 0U);
+    CHECK_EQ(statistics.mFailedSegments, 0U);
+    CHECK_EQ(statistics.mSpiceQueries, 0U);
+    CHECK_EQ(statistics.mCachedQueries, 1200U);
+  }
+
+  SUBCASE("Queries without SPICE data throw") {
+    double t = utils::convert::time::toSpice("2080-01-01 00:00:00.000");
+
+    CHECK_THROWS_AS(cache.getPosition(t, "Moon", "Earth", "J2000"), std::runtime_error);
+    CHECK_THROWS_AS(cache.getPosition(t, "Moon", "Earth", "J2000"), std::runtime_error);
+    CHECK_EQ(cache.getStatistics().mFailedSegments, 1U);
+
+    CHECK_THROWS_AS(cache.getPosition(start, "Nonexistent", "Earth", "J2000"), std::runtime_error);
+  }
+
+  SUBCASE("Identical centers and frames do not require SPICE") {
+    CHECK_EQ(cache.getPosition(start, "Earth", "Earth", "J2000"), glm::dvec3(0.0));
+    CHECK_EQ(cache.getRotation(start, "J2000", "J2000"), glm::dquat(1.0, 0.0, 0.0, 0.0));
+    CHECK_EQ(cache.getStatistics().mSpiceQueries, 0U);
+  }
+
+  kclear_c();
+}
+
+TEST_CASE("cs::scene::EphemerisCache accuracy and speed [benchmark]") {
+  if (!loadKernels()) {
+    return;
+  }
+
+  // A typical scene: The observer is close to Earth and all other objects are queried relative to
+  // it. Each frame, the simulation time advances by five minutes, so a year is simulated.
+  CelestialAnchor observer("Earth", "IAU_Earth");
+  observer.setPosition(glm::dvec3(0.0, 0.0, 7e6));
+
+  std::vector<CelestialAnchor> objects{{"Sun", "IAU_Sun"}, {"Moon", "IAU_Moon"},
+      {"Earth", "IAU_Earth"}, {"Mars Barycenter", "J2000"}, {"Jupiter Barycenter", "J2000"},
+      {"Saturn Barycenter", "ECLIPJ2000"}};
+
+  objects[2].setPosition(glm::dvec3(1e6, 2e6, 3e6));
+
+  const double start = utils::convert::time::toSpice("2021-01-01 00:00:00.000");
+  const double step  = 300.0;
+  const int    steps = static_cast<int>(365.0 * 86400.0 / step);
+
+  struct Result {
+    std::vector<glm::dvec3> mPositions;
+    std::vector<glm::dquat> mRotations;
+    double                  mMicroseconds = 0.0;
+  };
+
+  auto run = [&]() {
+    Result result;
+    result.mPositions.reserve(objects.size() * steps);
+    result.mRotations.reserve(objects.size() * steps);
+
+    auto begin = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < steps; ++i) {
+      double t = start + i * step;
+
+      for (auto const& object : objects) {
+        result.mPositions.push_back(observer.getRelativePosition(t, object));
+        result.mRotations.push_back(observer.getRelativeRotation(t, object));
+      }
+    }
+
+    std::chrono::duration<double, std::micro> duration =
+        std::chrono::high_resolution_clock::now() - begin;
+    result.mMicroseconds = duration.count() / static_cast<double>(objects.size() * steps);
+
+    return result;
+  };
+
+  auto& cache = EphemerisCache::get();
+  cache.clear();
+
+  cache.setEnabled(false);
+  auto spice = run();
+
+  cache.setEnabled(true);
+  auto cold = run();
+  auto warm = run();
+
+  double maxPositionError = 0.0;
+  double maxRelativeError = 0.0;
+  double maxRotationError = 0.0;
+
+  for (std::size_t i = 0; i < spice.mPositions.size(); ++i) {
+    double error     = glm::length(cold.mPositions[i] - spice.mPositions[i]);
+    maxPositionError = std::max(maxPositionError, error);
+    maxRelativeError = std::max(maxRelativeError, error / glm::length(spice.mPositions[i]));
+    maxRotationError =
+        std::max(maxRotationError, getAngle(cold.mRotations[i], spice.mRotations[i]));
+  }
+
+  auto statistics = cache.getStatistics();
+  cache.clear();
+
+  // In the rotating frame of the observer, SPICE itself is only precise to about 1e-11 times the
+  // distance. So the positions of the Sun and the outer planets can be off by several meters.
+  CHECK_LT(maxRelativeError, 2e-10);
+  CHECK_LT(maxRotationError, 1e-8);
+  CHECK_EQ(statistics.mFailedSegments, 0U);
+
+  MESSAGE("SPICE: ", spice.mMicroseconds, " us, cache (fitting): ", cold.mMicroseconds,
+      " us, cache (fitted): ", warm.mMicroseconds, " us per object and frame, ",
+      statistics.mFittedSegments, " segments, max. error: ", maxPositionError, " m (",
+      maxRelativeError, " relative), ", maxRotationError, " rad");
+
+  kclear_c();
+}
+
+} // namespace cs::scene
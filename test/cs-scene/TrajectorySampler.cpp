@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-scene/TrajectorySampler.hpp"
+#include "../../src/cs-scene/EphemerisCache.hpp"
+#include "../../src/cs-utils/convert.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <boost/filesystem.hpp>
+#include <cmath>
+#include <cspice/SpiceUsr.h>
+#include <future>
+
+namespace cs::scene {
+
+namespace {
+
+// The kernels are downloaded when CosmoScout VR is started for the first time. The tests are
+// skipped if they are not available.
+bool loadKernels() {
+  std::string action = "RETURN";
+  erract_c("SET", 0, action.data());
+
+  std::string device = "NULL";
+  errdev_c("SET", 0, device.data());
+
+  furnsh_c("../share/config/spice/simple.txt");
+
+  if (failed_c()) {
+    reset_c();
+    MESSAGE("Skipping test as the SPICE kernels are not available.");
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace
+
+TEST_CASE("cs::scene::TrajectorySampler") {
+  if (!loadKernels()) {
+    return;
+  }
+
+  TrajectorySampler sampler;
+
+  // The requested samples start in the middle of a block and span several blocks.
+  TrajectorySampler::Request request{
+      CelestialAnchor("Earth", "J2000"), CelestialAnchor("Moon", "J2000")};
+  request.mOffset = utils::convert::time::toSpice("2021-03-01 00:00:00.000");
+  request.mStep   = 3600.0;
+  request.mFirst  = -100;
+  request.mCount  = 3 * TrajectorySampler::BLOCK_SIZE;
+
+  SUBCASE("Samples match CelestialAnchor") {
+    auto points = sampler.sampleNow(request);
+    REQUIRE_EQ(points.size(), request.mCount);
+
+    double maxError = 0.0;
+
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      auto   index    = request.mFirst + static_cast<int64_t>(i);
+      double tTime    = request.mOffset + static_cast<double>(index) * request.mStep;
+      auto   expected = request.mCenter.getRelativePosition(tTime, request.mTarget);
+
+      CHECK_EQ(points[i].w, tTime);
+      maxError = std::max(maxError, glm::length(glm::dvec3(points[i]) - expected));
+    }
+
+    CHECK_EQ(maxError, 0.0);
+    CHECK_EQ(sampler.getStatistics().mSampledBlocks, 4U);
+    CHECK_EQ(sampler.getStatistics().mLoadedBlocks, 0U);
+  }
+
+  SUBCASE("sampleNow does not wait for the ThreadPool") {
+    auto& pool = utils::ThreadPool::get();
+
+    // Occupy all workers until the samples have been computed.
+    std::promise<void>       release;
+    std::shared_future<void> released = release.get_future().share();
+
+    for (std::size_t i = 0; i < pool.getThreadCount(); ++i) {
+      pool.post([released]() { released.wait(); });
+    }
+
+    auto points = sampler.sampleNow(request);
+    release.set_value();
+
+    REQUIRE_EQ(points.size(), request.mCount);
+    CHECK_FALSE(std::isnan(points.front().w));
+    CHECK_FALSE(std::isnan(points.back().w));
+  }
+
+  SUBCASE("Times can be converted while sampling in the background") {
+    auto expected = sampler.sampleNow(request);
+    auto job      = sampler.sample(request);
+
+    // Converting times uses SPICE as well. This must not interfere with the sampling.
+    double tTime = request.mOffset;
+
+    do {
+      double converted = utils::convert::time::toSpice(utils::convert::time::toPosix(tTime));
+      CHECK_LT(std::abs(converted - tTime), 0.001);
+    } while (!job->isReady());
+
+    CHECK(job->getPoints() == expected);
+  }
+
+  SUBCASE("Samples are clamped to the existence") {
+    request.mExistence = glm::dvec2(request.mOffset, request.mOffset + 10.0 * request.mStep);
+
+    auto points = sampler.sampleNow(request);
+
+    CHECK_EQ(points.front().w, request.mExistence.x);
+    CHECK_EQ(points.back().w, request.mExistence.y);
+  }
+
+  SUBCASE("Samples without SPICE data are NaN") {
+    request.mOffset = utils::convert::time::toSpice("2080-01-01 00:00:00.000");
+
+    auto points = sampler.sampleNow(request);
+
+    CHECK(std::isnan(points.front().w));
+    CHECK(std::isnan(points.back().w));
+  }
+
+  SUBCASE("Blocks are cached on disk") {
+    auto directory =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%");
+    sampler.setCacheDirectory(directory.string());
+
+    auto sampled = sampler.sampleNow(request);
+    CHECK_EQ(sampler.getStatistics().mSampledBlocks, 4U);
+
+    // A second request which overlaps the first one only has to sample one block.
+    request.mFirst += static_cast<int64_t>(TrajectorySampler::BLOCK_SIZE);
+    auto loaded = sampler.sampleNow(request);
+    CHECK_EQ(sampler.getStatistics().mSampledBlocks, 5U);
+    CHECK_EQ(sampler.getStatistics().mLoadedBlocks, 3U);
+
+    for (std::size_t i = 0; i + TrajectorySampler::BLOCK_SIZE < sampled.size(); ++i) {
+      CHECK_EQ(loaded[i], sampled[i + TrajectorySampler::BLOCK_SIZE]);
+    }
+
+    // A different target must not reuse the cached blocks.
+    request.mTarget = CelestialAnchor("Sun", "J2000");
+    sampler.sampleNow(request);
+    CHECK_EQ(sampler.getStatistics().mSampledBlocks, 9U);
+
+    // Blocks which have been computed with other tolerances must not be reused either.
+    auto& ephemerisCache = EphemerisCache::get();
+    auto  tolerance      = ephemerisCache.getPositionTolerance();
+    ephemerisCache.setPositionTolerance(tolerance * 2.0);
+    sampler.sampleNow(request);
+    ephemerisCache.setPositionTolerance(tolerance);
+    CHECK_EQ(sampler.getStatistics().mSampledBlocks, 13U);
+
+    // Requests which do not use the cache neither load nor store any blocks.
+    request.mUseCache = false;
+    sampler.sampleNow(request);
+    CHECK_EQ(sampler.getStatistics().mSampledBlocks, 17U);
+    CHECK_EQ(sampler.getStatistics().mLoadedBlocks, 3U);
+
+    boost::filesystem::remove_all(directory);
+  }
+
+  kclear_c();
+}
+
+} // namespace cs::scene
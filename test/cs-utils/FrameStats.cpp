@@ -0,0 +1,232 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/FrameStats.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+
+namespace cs::utils {
+
+namespace {
+
+// The number of threads measureScopeTime() uses.
+const std::size_t BATCH_COUNT = 200;
+
+// Measures the average time in nanoseconds it takes to create and destroy one ScopedTimer. The
+// timers are created on a separate thread, as no OpenGL context is available for the main thread
+// ranges. For the same reason, FrameStats::startFrame() is never called and the ranges recorded by
+// the thread are only collected by the test. Therefore, each batch of THREAD_TIMER_CAPACITY timers
+// is recorded on a new thread, so that its ring buffer does not overflow.
+template <typename Scope>
+double measureScopeTime(Scope const& scope) {
+  const int batchSize = static_cast<int>(FrameStats::THREAD_TIMER_CAPACITY);
+
+  std::chrono::duration<double, std::nano> duration{};
+
+  for (std::size_t batch = 0; batch < BATCH_COUNT; ++batch) {
+    std::thread thread([&] {
+      auto start = std::chrono::high_resolution_clock::now();
+
+      for (int i = 0; i < batchSize; ++i) {
+        scope(i);
+      }
+
+      duration += std::chrono::high_resolution_clock::now() - start;
+    });
+
+    thread.join();
+  }
+
+  return duration.count() / static_cast<double>(BATCH_COUNT * batchSize);
+}
+
+// Returns the number of the given ranges with the given name.
+std::size_t countRanges(
+    std::vector<FrameStats::TimerQueryResult> const& ranges, FrameStats::NameID name) {
+  return static_cast<std::size_t>(std::count_if(ranges.begin(), ranges.end(),
+      [name](auto const& range) { return range.mNameID == name; }));
+}
+
+} // namespace
+
+TEST_CASE("cs::utils::FrameStats::registerName") {
+  auto& frameStats = FrameStats::get();
+
+  auto a = frameStats.registerName("FrameStats Test A");
+  auto b = frameStats.registerName("FrameStats Test B");
+
+  CHECK_NE(a, b);
+  CHECK_EQ(frameStats.registerName("FrameStats Test A"), a);
+  CHECK_EQ(frameStats.registerName(std::string("FrameStats Test ") + "B"), b);
+
+  // Names registered on other threads share the same IDs.
+  FrameStats::NameID c = 0;
+  std::thread        thread([&] { c = frameStats.registerName("FrameStats Test A"); });
+  thread.join();
+
+  CHECK_EQ(c, a);
+}
+
+TEST_CASE("cs::utils::FrameStats::createFlowID") {
+  auto& frameStats = FrameStats::get();
+
+  // Flow IDs are unique across all threads and zero is never returned.
+  uint64_t a = frameStats.createFlowID();
+  uint64_t b = 0;
+
+  std::thread thread([&] { b = frameStats.createFlowID(); });
+  thread.join();
+
+  CHECK_NE(a, 0U);
+  CHECK_NE(b, 0U);
+  CHECK_NE(a, b);
+}
+
+TEST_CASE("cs::utils::FrameStats::collectThreadTimers") {
+  auto& frameStats = FrameStats::get();
+
+  const std::size_t threadCount = 4;
+  const std::size_t rangeCount  = 100;
+
+  auto outerName = frameStats.registerName("FrameStats Test Outer");
+  auto innerName = frameStats.registerName("FrameStats Test Inner");
+  auto flowName  = frameStats.registerName("FrameStats Test Flow");
+  auto flowID    = frameStats.createFlowID();
+
+  // Drop everything which has been recorded by previous tests.
+  std::vector<FrameStats::TimerQueryResult> ranges;
+  std::vector<FrameStats::FlowEvent>        events;
+  frameStats.collectThreadTimers(ranges, events);
+  ranges.clear();
+  events.clear();
+
+  frameStats.pEnableMeasurements = true;
+
+  // The threads record their ranges concurrently. The first thread keeps running until the ranges
+  // have been collected, the others exit before.
+  std::atomic<std::size_t> finishedThreads{0};
+  std::atomic<bool>        collected{false};
+  std::vector<std::thread> threads;
+
+  for (std::size_t t = 0; t < threadCount; ++t) {
+    threads.emplace_back([&, t] {
+      for (std::size_t i = 0; i < rangeCount; ++i) {
+        FrameStats::ScopedTimer outer(outerName, FrameStats::TimerMode::eCPU);
+        FrameStats::ScopedTimer inner(innerName, FrameStats::TimerMode::eCPU);
+      }
+
+      frameStats.addFlowEvent(flowName, flowID, FrameStats::FlowPhase::eStep);
+      ++finishedThreads;
+
+      while (t == 0 && !collected) {
+        std::this_thread::yield();
+      }
+    });
+  }
+
+  while (finishedThreads < threadCount) {
+    std::this_thread::yield();
+  }
+
+  frameStats.collectThreadTimers(ranges, events);
+  collected = true;
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  frameStats.pEnableMeasurements = false;
+
+  CHECK_EQ(countRanges(ranges, outerName), threadCount * rangeCount);
+  CHECK_EQ(countRanges(ranges, innerName), threadCount * rangeCount);
+
+  std::set<uint32_t> threadIndices;
+
+  for (auto const& range : ranges) {
+    if (range.mNameID == outerName || range.mNameID == innerName) {
+      threadIndices.insert(range.mThread);
+
+      CHECK_EQ(range.mNestingLevel, range.mNameID == outerName ? 0U : 1U);
+      CHECK_EQ(range.mName, range.mNameID == outerName ? "FrameStats Test Outer"
+                                                       : "FrameStats Test Inner");
+      CHECK_UNARY(range.mMode == FrameStats::TimerMode::eCPU);
+      CHECK_LE(range.mCPUStart, range.mCPUEnd);
+    }
+  }
+
+  // The main thread has index zero, so none of the ranges may use it.
+  CHECK_EQ(threadIndices.size(), threadCount);
+  CHECK_EQ(threadIndices.count(0), 0U);
+
+  auto flowEvents = std::count_if(
+      events.begin(), events.end(), [&](auto const& event) { return event.mID == flowID; });
+  CHECK_EQ(static_cast<std::size_t>(flowEvents), threadCount);
+
+  for (auto const& event : events) {
+    if (event.mID == flowID) {
+      CHECK_EQ(event.mName, "FrameStats Test Flow");
+      CHECK_UNARY(threadIndices.count(event.mThread) == 1);
+    }
+  }
+
+  // Everything has been moved out of the ring buffers.
+  ranges.clear();
+  events.clear();
+  frameStats.collectThreadTimers(ranges, events);
+  CHECK_EQ(countRanges(ranges, outerName), 0U);
+  CHECK_UNARY(events.empty());
+}
+
+TEST_CASE("cs::utils::FrameStats::ScopedTimer overhead [benchmark]") {
+  auto& frameStats = FrameStats::get();
+
+  // This resembles the names which were built each frame for each celestial object.
+  std::string center = "Earth";
+  std::string frame  = "IAU_Earth";
+  auto        name   = frameStats.registerName("Update " + center + " / " + frame);
+
+  auto stringScope = [&](int /*i*/) {
+    FrameStats::ScopedTimer timer("Update " + center + " / " + frame, FrameStats::TimerMode::eCPU);
+  };
+
+  auto internedScope = [&](int /*i*/) {
+    FrameStats::ScopedTimer timer(name, FrameStats::TimerMode::eCPU);
+  };
+
+  frameStats.pEnableMeasurements = false;
+  double stringDisabled          = measureScopeTime(stringScope);
+  double internedDisabled        = measureScopeTime(internedScope);
+
+  frameStats.pEnableMeasurements = true;
+  double stringEnabled           = measureScopeTime(stringScope);
+  double internedEnabled         = measureScopeTime(internedScope);
+
+  frameStats.pEnableMeasurements = false;
+
+  MESSAGE("disabled: string name ", stringDisabled, " ns, interned name ", internedDisabled, " ns");
+  MESSAGE("enabled: string name ", stringEnabled, " ns, interned name ", internedEnabled, " ns");
+
+  // Building the name each time requires a heap allocation, so the interned names have to be
+  // faster, regardless of whether anything is measured.
+  CHECK_LT(internedDisabled, stringDisabled);
+  CHECK_LT(internedEnabled, stringEnabled);
+
+  // All ranges of the exited threads have to be collectable. Both variants use the same name, and
+  // nothing is recorded while measurements are disabled.
+  std::vector<FrameStats::TimerQueryResult> ranges;
+  std::vector<FrameStats::FlowEvent>        events;
+  frameStats.collectThreadTimers(ranges, events);
+
+  CHECK_EQ(countRanges(ranges, name), 2 * BATCH_COUNT * FrameStats::THREAD_TIMER_CAPACITY);
+}
+
+} // namespace cs::utils
@@ -0,0 +1,281 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/HttpFetcher.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <istream>
+
+namespace cs::utils {
+
+namespace {
+
+using boost::asio::ip::tcp;
+
+const std::string PNG_SIGNATURE("\x89PNG\r\n\x1a\n", 8);
+
+// A minimal HTTP/1.1 server on localhost which behaves like a web map service. GetMap requests are
+// answered with a small PNG image after a short delay. Requests for the layer "unknown" are
+// answered with a WMS exception report and requests for the layer "flaky" fail with a 503 status
+// code for the first two times. Connections are kept alive until the client closes them.
+class TestMapServer {
+ public:
+  TestMapServer()
+      : mAcceptor(mContext, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)) {
+    mAcceptThread = std::thread([this]() {
+      while (true) {
+        tcp::socket socket(mContext);
+        mAcceptor.accept(socket);
+
+        if (mStop) {
+          return;
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        ++mConnections;
+        mConnectionThreads.emplace_back([this, s = std::move(socket)]() mutable { serve(s); });
+      }
+    });
+  }
+
+  TestMapServer(TestMapServer const& other) = delete;
+  TestMapServer(TestMapServer&& other)      = delete;
+
+  TestMapServer& operator=(TestMapServer const& other) = delete;
+  TestMapServer& operator=(TestMapServer&& other)      = delete;
+
+  // All clients have to be destroyed before the server, else this will wait for their connections
+  // to be closed.
+  ~TestMapServer() {
+    mStop = true;
+
+    // Wake up the accepting thread.
+    tcp::socket socket(mContext);
+    socket.connect(mAcceptor.local_endpoint());
+    mAcceptThread.join();
+
+    for (auto& thread : mConnectionThreads) {
+      thread.join();
+    }
+  }
+
+  std::string getUrl(std::string const& layer) const {
+    return "http://127.0.0.1:" + std::to_string(mAcceptor.local_endpoint().port()) +
+           "/wms?version=1.1.0&request=GetMap&layers=" + layer + "&width=16&height=16";
+  }
+
+  int getConnectionCount() const {
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mConnections;
+  }
+
+  int getMaxParallelRequests() const {
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mMaxParallelRequests;
+  }
+
+ private:
+  void serve(tcp::socket& socket) {
+    boost::asio::streambuf    buffer;
+    boost::system::error_code error;
+
+    while (true) {
+      boost::asio::read_until(socket, buffer, "\r\n\r\n", error);
+
+      if (error) {
+        return;
+      }
+
+      // Only the request target is of interest, the headers are skipped.
+      std::istream stream(&buffer);
+      std::string  method;
+      std::string  target;
+      std::string  line;
+      stream >> method >> target;
+
+      while (std::getline(stream, line) && line != "\r") {
+      }
+
+      std::string response = respond(target);
+      boost::asio::write(socket, boost::asio::buffer(response), error);
+
+      if (error) {
+        return;
+      }
+    }
+  }
+
+  std::string respond(std::string const& target) {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      ++mParallelRequests;
+      mMaxParallelRequests = std::max(mMaxParallelRequests, mParallelRequests);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    --mParallelRequests;
+
+    if (target.find("layers=flaky") != std::string::npos && mFlakyFailures++ < 2) {
+      return createResponse("503 Service Unavailable", "text/plain", "Try again later.");
+    }
+
+    if (target.find("layers=unknown") != std::string::npos) {
+      return createResponse("200 OK", "text/xml",
+          "<ServiceExceptionReport version=\"1.1.1\"><ServiceException code=\"LayerNotDefined\">"
+          "Unknown layer.</ServiceException></ServiceExceptionReport>");
+    }
+
+    return createResponse("200 OK", "image/png", PNG_SIGNATURE + target);
+  }
+
+  static std::string createResponse(
+      std::string const& status, std::string const& contentType, std::string const& body) {
+    return "HTTP/1.1 " + status + "\r\nContent-Type: " + contentType +
+           "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+  }
+
+  boost::asio::io_context  mContext;
+  tcp::acceptor            mAcceptor;
+  std::thread              mAcceptThread;
+  std::vector<std::thread> mConnectionThreads;
+  std::atomic<bool>        mStop{false};
+
+  mutable std::mutex mMutex;
+  int                mConnections         = 0;
+  int                mParallelRequests    = 0;
+  int                mMaxParallelRequests = 0;
+  int                mFlakyFailures       = 0;
+};
+
+} // namespace
+
+TEST_CASE("cs::utils::HttpFetcher") {
+  TestMapServer server;
+
+  HttpFetcher::Settings settings;
+  settings.mMaxConnectionsPerHost = 2;
+
+  HttpFetcher fetcher(settings);
+
+  HttpRequest request;
+  request.mUrl        = server.getUrl("earth");
+  request.mRetryDelay = std::chrono::milliseconds(10);
+
+  SUBCASE("The response is passed to the caller") {
+    auto response = fetcher.fetch(request).get();
+
+    CHECK_UNARY(response.isSuccess());
+    CHECK_EQ(response.mStatus, 200);
+    CHECK_EQ(response.mContentType, "image/png");
+    CHECK_EQ(response.mBody.substr(0, PNG_SIGNATURE.size()), PNG_SIGNATURE);
+    CHECK_EQ(response.mAttempts, 1);
+  }
+
+  SUBCASE("Connections are reused and limited per host") {
+    const int               requestCount = 20;
+    const auto              testThread   = std::this_thread::get_id();
+    std::mutex              mutex;
+    std::condition_variable condition;
+    int                     completed     = 0;
+    int                     succeeded     = 0;
+    bool                    onOtherThread = true;
+
+    for (int i = 0; i < requestCount; ++i) {
+      fetcher.fetch(request, [&](HttpResponse response) {
+        std::unique_lock<std::mutex> lock(mutex);
+        onOtherThread = onOtherThread && std::this_thread::get_id() != testThread;
+        succeeded += response.isSuccess() ? 1 : 0;
+        ++completed;
+        condition.notify_all();
+      });
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&]() { return completed == requestCount; });
+
+    CHECK_EQ(succeeded, requestCount);
+    CHECK_UNARY(onOtherThread);
+    CHECK_LE(server.getMaxParallelRequests(), 2);
+    CHECK_LE(server.getConnectionCount(), 2);
+    CHECK_LE(fetcher.getStatistics().mConnections, 2U);
+  }
+
+  SUBCASE("Failed requests are retried") {
+    request.mUrl        = server.getUrl("flaky");
+    request.mMaxRetries = 3;
+
+    auto response = fetcher.fetch(request).get();
+
+    CHECK_UNARY(response.isSuccess());
+    CHECK_EQ(response.mAttempts, 3);
+    CHECK_EQ(fetcher.getStatistics().mRetries, 2U);
+  }
+
+  SUBCASE("Requests fail once all retries are used up") {
+    request.mUrl        = server.getUrl("flaky");
+    request.mMaxRetries = 1;
+
+    auto response = fetcher.fetch(request).get();
+
+    CHECK_UNARY_FALSE(response.isSuccess());
+    CHECK_EQ(response.mStatus, 503);
+    CHECK_EQ(response.mAttempts, 2);
+    CHECK_EQ(fetcher.getStatistics().mFailed, 1U);
+  }
+
+  SUBCASE("Unusable responses can be retried") {
+    request.mUrl        = server.getUrl("unknown");
+    request.mMaxRetries = 2;
+    request.mRetryIf    = [](HttpResponse const& r) { return r.mContentType != "image/png"; };
+
+    auto response = fetcher.fetch(request).get();
+
+    CHECK_EQ(response.mStatus, 200);
+    CHECK_EQ(response.mContentType, "text/xml");
+    CHECK_NE(response.mBody.find("ServiceException"), std::string::npos);
+    CHECK_EQ(response.mAttempts, 3);
+  }
+
+  SUBCASE("Delayed requests do not hold back other requests") {
+    auto delayedRequest   = request;
+    delayedRequest.mDelay = std::chrono::milliseconds(500);
+
+    auto start   = std::chrono::steady_clock::now();
+    auto delayed = fetcher.fetch(delayedRequest);
+    auto regular = fetcher.fetch(request);
+
+    CHECK_UNARY(regular.get().isSuccess());
+    CHECK_LT(std::chrono::steady_clock::now() - start, delayedRequest.mDelay);
+    CHECK_UNARY(delayed.get().isSuccess());
+    CHECK_GE(std::chrono::steady_clock::now() - start, delayedRequest.mDelay);
+  }
+
+  SUBCASE("Transfer errors are reported") {
+    // Nothing listens on this port anymore.
+    unsigned short port{};
+    {
+      boost::asio::io_context context;
+      tcp::acceptor acceptor(context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+      port = acceptor.local_endpoint().port();
+    }
+
+    request.mUrl  = "http://127.0.0.1:" + std::to_string(port) + "/wms";
+    auto response = fetcher.fetch(request).get();
+
+    CHECK_UNARY_FALSE(response.isSuccess());
+    CHECK_EQ(response.mStatus, 0);
+    CHECK_UNARY_FALSE(response.mError.empty());
+  }
+}
+
+} // namespace cs::utils
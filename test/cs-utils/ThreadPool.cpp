@@ -0,0 +1,271 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/ThreadPool.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <chrono>
+#include <functional>
+#include <stack>
+
+namespace cs::utils {
+
+namespace {
+
+// This is the single-lock, LIFO pool which was used before the work-stealing ThreadPool has been
+// introduced. It is only kept here as a baseline for the benchmark below.
+class LegacyThreadPool {
+ public:
+  explicit LegacyThreadPool(size_t threads) {
+    for (size_t i = 0; i < threads; ++i) {
+      mWorkers.emplace_back([this] {
+        while (true) {
+          std::function<void()> task;
+          {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mStop || !mTasks.empty(); });
+            if (mStop && mTasks.empty()) {
+              return;
+            }
+            task = std::move(mTasks.top());
+            mTasks.pop();
+          }
+          task();
+        }
+      });
+    }
+  }
+
+  ~LegacyThreadPool() {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mStop = true;
+    }
+    mCondition.notify_all();
+    for (std::thread& worker : mWorkers) {
+      worker.join();
+    }
+  }
+
+  template <class F>
+  auto enqueue(F&& f) -> std::future<typename std::invoke_result<F>::type> {
+    using return_type = typename std::invoke_result<F>::type;
+    auto task         = std::make_shared<std::packaged_task<return_type()>>(
+        [Func = std::forward<F>(f)] { return Func(); });
+    std::future<return_type> res = task->get_future();
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mTasks.emplace([task]() { (*task)(); });
+    }
+    mCondition.notify_one();
+    return res;
+  }
+
+ private:
+  std::vector<std::thread>          mWorkers;
+  std::stack<std::function<void()>> mTasks;
+  std::mutex                        mMutex;
+  std::condition_variable           mCondition;
+  bool                              mStop = false;
+};
+
+// Enqueues taskCount tiny tasks from producerCount threads at the same time and returns the number
+// of tasks per second which have been enqueued and executed.
+template <typename Pool, typename Enqueue>
+double measureThroughput(Pool& pool, int producerCount, int taskCount, Enqueue const& enqueue) {
+  std::atomic<int> counter{0};
+
+  auto start = std::chrono::high_resolution_clock::now();
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < producerCount; ++p) {
+    producers.emplace_back([&] {
+      for (int i = 0; i < taskCount / producerCount; ++i) {
+        enqueue(pool, [&counter] { ++counter; });
+      }
+    });
+  }
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  while (counter < taskCount / producerCount * producerCount) {
+    std::this_thread::yield();
+  }
+
+  std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+  return counter / duration.count();
+}
+
+} // namespace
+
+TEST_CASE("cs::utils::ThreadPool::enqueue") {
+  ThreadPool pool(4);
+
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 100; ++i) {
+    results.push_back(pool.enqueue([i] { return i * i; }));
+  }
+
+  for (int i = 0; i < 100; ++i) {
+    CHECK_EQ(results[i].get(), i * i);
+  }
+}
+
+TEST_CASE("cs::utils::ThreadPool::enqueue forwards exceptions") {
+  ThreadPool pool(1);
+  auto       result = pool.enqueue([]() -> int { throw std::runtime_error("foo"); });
+  CHECK_THROWS_AS(result.get(), std::runtime_error);
+}
+
+TEST_CASE("cs::utils::ThreadPool priorities") {
+  ThreadPool pool(1);
+
+  // Block the only worker so that all following tasks are queued.
+  std::promise<void> blocker;
+  auto               blocked = blocker.get_future().share();
+  pool.post([blocked] { blocked.wait(); });
+
+  std::mutex       mutex;
+  std::vector<int> order;
+  auto             record = [&](int i) {
+    std::unique_lock<std::mutex> lock(mutex);
+    order.push_back(i);
+  };
+
+  pool.post([&] { record(0); }, TaskPriority::eLow);
+  pool.post([&] { record(1); }, TaskPriority::eHigh);
+  pool.post([&] { record(2); }, TaskPriority::eNormal);
+
+  blocker.set_value();
+
+  while (!pool.hasFinished()) {
+    std::this_thread::yield();
+  }
+
+  std::vector<int> expected{1, 2, 0};
+  CHECK_EQ(order, expected);
+}
+
+TEST_CASE("cs::utils::ThreadPool::submit cancellation") {
+  ThreadPool pool(1);
+
+  std::promise<void> blocker;
+  auto               blocked = blocker.get_future().share();
+  pool.post([blocked] { blocked.wait(); });
+
+  std::atomic<bool> executed{false};
+  auto              handle = pool.submit([&] { executed = true; });
+
+  CHECK_UNARY(handle.isValid());
+  CHECK_UNARY(handle.cancel());
+  CHECK_UNARY(handle.isCancelled());
+  CHECK_UNARY_FALSE(handle.cancel());
+
+  blocker.set_value();
+
+  while (!pool.hasFinished()) {
+    std::this_thread::yield();
+  }
+
+  CHECK_UNARY_FALSE(executed);
+  CHECK_UNARY_FALSE(handle.isFinished());
+  CHECK_UNARY_FALSE(TaskHandle().isValid());
+}
+
+TEST_CASE("cs::utils::TaskGroup") {
+  ThreadPool pool(4);
+
+  std::atomic<int> counter{0};
+  {
+    TaskGroup group(pool);
+    for (int i = 0; i < 1000; ++i) {
+      group.post([&counter] { ++counter; });
+    }
+
+    // A cancelled task has to be released from the group as well.
+    group.submit([] {}).cancel();
+
+    group.wait();
+    CHECK_UNARY(group.hasFinished());
+    CHECK_EQ(group.getPendingTaskCount(), 0);
+  }
+
+  CHECK_EQ(counter, 1000);
+}
+
+TEST_CASE("cs::utils::TaskGroup::wait from within a task") {
+  ThreadPool pool(1);
+
+  // With only one worker, the inner tasks can only be executed if the waiting worker executes them
+  // itself.
+  std::atomic<int> counter{0};
+  auto             outer = pool.enqueue([&] {
+    TaskGroup group(pool);
+    for (int i = 0; i < 10; ++i) {
+      group.post([&counter] { ++counter; });
+    }
+    group.wait();
+    return counter.load();
+  });
+
+  REQUIRE_EQ(outer.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+  CHECK_EQ(outer.get(), 10);
+}
+
+TEST_CASE("cs::utils::Task inline storage") {
+  int  value = 0;
+  Task small([&value] { value = 1; });
+  Task moved(std::move(small));
+
+  CHECK_UNARY_FALSE(small);
+  CHECK_UNARY(moved);
+
+  moved();
+  CHECK_EQ(value, 1);
+
+  // This is larger than the inline storage and therefore stored on the heap.
+  std::array<char, Task::INLINE_SIZE * 2> payload{};
+  payload.back() = 42;
+  Task large([&value, payload] { value = payload.back(); });
+  large();
+  CHECK_EQ(value, 42);
+}
+
+TEST_CASE("cs::utils::ThreadPool throughput [benchmark]") {
+  const int threadCount = 32;
+  const int taskCount   = 1000000;
+
+  for (int producerCount : {1, 4, 16}) {
+    double legacy = 0.0;
+    {
+      LegacyThreadPool pool(threadCount);
+      legacy = measureThroughput(pool, producerCount, taskCount,
+          [](LegacyThreadPool& p, auto&& f) { p.enqueue(std::forward<decltype(f)>(f)); });
+    }
+
+    double enqueue = 0.0;
+    {
+      ThreadPool pool(threadCount);
+      enqueue = measureThroughput(pool, producerCount, taskCount,
+          [](ThreadPool& p, auto&& f) { p.enqueue(std::forward<decltype(f)>(f)); });
+    }
+
+    double post = 0.0;
+    {
+      ThreadPool pool(threadCount);
+      post = measureThroughput(pool, producerCount, taskCount,
+          [](ThreadPool& p, auto&& f) { p.post(std::forward<decltype(f)>(f)); });
+    }
+
+    MESSAGE(producerCount, " producers: legacy ", static_cast<int>(legacy), " tasks/s, enqueue() ",
+        static_cast<int>(enqueue), " tasks/s, post() ", static_cast<int>(post), " tasks/s");
+  }
+}
+
+} // namespace cs::utils
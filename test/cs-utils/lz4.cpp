@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SPDX-FileCopyrightText: German Aerospace Center (DLR) <cosmoscout@dlr.de>
+// SPDX-License-Identifier: MIT
+
+#include "../../src/cs-utils/lz4.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <array>
+#include <random>
+#include <string>
+
+namespace cs::utils {
+
+namespace {
+
+// Compresses and decompresses the given data and returns the compressed size.
+std::size_t roundTrip(std::string const& input) {
+  std::string compressed(lz4::compressBound(input.size()), '\0');
+  std::size_t size =
+      lz4::compress(input.data(), input.size(), compressed.data(), compressed.size());
+  REQUIRE_GT(size, 0);
+
+  std::string output(input.size(), '\0');
+  CHECK_UNARY(lz4::decompress(compressed.data(), size, output.data(), output.size()));
+  CHECK_EQ(output, input);
+
+  return size;
+}
+
+} // namespace
+
+TEST_CASE("cs::utils::lz4::compress") {
+  std::mt19937 random(42);
+
+  std::string noise(100000, '\0');
+  for (auto& c : noise) {
+    c = static_cast<char>(random());
+  }
+
+  std::string runs;
+  for (int i = 0; i < 1000; ++i) {
+    runs += std::string(static_cast<std::size_t>(random() % 300), static_cast<char>(i % 7));
+  }
+
+  std::string text;
+  while (text.size() < 100000) {
+    text += "The quick brown fox jumps over the lazy dog " + std::to_string(random() % 100) + ". ";
+  }
+
+  CHECK_EQ(roundTrip(""), 1);
+  CHECK_EQ(roundTrip("short"), 6);
+  CHECK_LT(roundTrip(runs), runs.size() / 10);
+  CHECK_LT(roundTrip(text), text.size() / 2);
+  CHECK_LE(roundTrip(noise), lz4::compressBound(noise.size()));
+
+  // The destination buffer has to be large enough for the worst case.
+  std::string small(10, '\0');
+  CHECK_EQ(lz4::compress(text.data(), text.size(), small.data(), small.size()), 0);
+}
+
+TEST_CASE("cs::utils::lz4::decompress") {
+  std::string input(1000, 'a');
+  std::string compressed(lz4::compressBound(input.size()), '\0');
+  compressed.resize(
+      lz4::compress(input.data(), input.size(), compressed.data(), compressed.size()));
+
+  // The data has to decompress to exactly the given size.
+  std::string output(input.size() + 1, '\0');
+  CHECK_UNARY_FALSE(lz4::decompress(compressed.data(), compressed.size(), output.data(), 999));
+  CHECK_UNARY_FALSE(lz4::decompress(compressed.data(), compressed.size(), output.data(), 1001));
+  CHECK_UNARY(lz4::decompress(compressed.data(), compressed.size(), output.data(), 1000));
+
+  // Truncated data must not be accepted.
+  CHECK_UNARY_FALSE(
+      lz4::decompress(compressed.data(), compressed.size() - 1, output.data(), 1000));
+  CHECK_UNARY_FALSE(lz4::decompress(compressed.data(), 0, output.data(), 1000));
+
+  // A match must not reference data before the start of the output.
+  std::array<char, 3> invalid = {4, 5, 0};
+  CHECK_UNARY_FALSE(lz4::decompress(invalid.data(), invalid.size(), output.data(), 8));
+}
+
+} // namespace cs::utils